@@ -4,8 +4,12 @@ neura9_trainer.py - Treinador offline da NEURA9 (IA defensiva do WavePwn)
 
 Objetivo:
     - Treinar um classificador leve (72 features -> 10 classes)
-    - Exportar modelo .tflite (float32) para uso com TensorFlow Lite Micro
+    - Exportar modelo .tflite para uso com TensorFlow Lite Micro: int8 com
+      entrada/saída int8 (padrão; quantizado com amostras do próprio
+      dataset) ou float32
     - Opcionalmente gerar um array C para embutir no firmware
+    - Opcionalmente (--mlp-header) exportar os pesos em ponto fixo para o
+      MLP do firmware sem TFLM (src/neura9/mlp.h, -DNEURA9_BACKEND_MLP=1)
 
 Formato de dataset esperado (CSV):
     - Arquivo: ai/dataset/neura9_dataset.csv
@@ -16,14 +20,26 @@ Formato de dataset esperado (CSV):
 
 Uso:
     $ python3 ai/neura9_trainer.py --dataset ai/dataset/neura9_dataset.csv
+    $ python3 ai/neura9_trainer.py --quantize float   # modelo float32
+    $ python3 ai/neura9_trainer.py --mlp-header src/neura9/mlp_model.h
+
+As funções do MLP de ponto fixo (quantize_mlp, mlp_fixed_predict,
+export_mlp_header) só usam numpy: tools/neura9/mlp_check.py as importa
+sem TensorFlow.
 """
 
+from __future__ import annotations
+
 import argparse
 import pathlib
 
 import numpy as np
-import tensorflow as tf
-from tensorflow import keras
+
+try:
+    import tensorflow as tf
+    from tensorflow import keras
+except ImportError:  # só o MLP de ponto fixo (numpy)
+    tf = keras = None
 
 
 LABELS = [
@@ -62,12 +78,81 @@ def build_model(input_dim: int = 72, num_classes: int = 10) -> keras.Model:
     return model
 
 
-def export_tflite(model: keras.Model, out_path: pathlib.Path):
+def representative_dataset(x: np.ndarray, samples: int = 500):
+    """Amostras para o conversor medir as faixas de cada tensor."""
+    rng = np.random.default_rng(0)
+    idx = rng.choice(len(x), size=min(samples, len(x)), replace=False)
+
+    def gen():
+        for i in idx:
+            yield [x[i:i + 1]]
+
+    return gen
+
+
+def convert_tflite(model: keras.Model, quantize: str = "int8", x_calib=None) -> bytes:
+    """
+    int8: quantização inteira completa (pesos e ativações int8, bias int32,
+    entrada/saída int8), o único tipo com kernels otimizados (ESP-NN) no S3.
+    float: float32 puro, sem otimizações.
+    """
     converter = tf.lite.TFLiteConverter.from_keras_model(model)
-    converter.optimizations = [tf.lite.Optimize.DEFAULT]
-    tflite_model = converter.convert()
+    if quantize == "int8":
+        if x_calib is None or len(x_calib) == 0:
+            raise SystemExit("Quantização int8 precisa de amostras do dataset (--dataset)")
+        converter.optimizations = [tf.lite.Optimize.DEFAULT]
+        converter.representative_dataset = representative_dataset(x_calib)
+        converter.target_spec.supported_ops = [tf.lite.OpsSet.TFLITE_BUILTINS_INT8]
+        converter.inference_input_type = tf.int8
+        converter.inference_output_type = tf.int8
+    return converter.convert()
+
+
+def tflite_predict(tflite_bytes: bytes, x: np.ndarray) -> np.ndarray:
+    """Probabilidades (float) do modelo .tflite, quantizando a entrada como o firmware."""
+    interp = tf.lite.Interpreter(model_content=tflite_bytes)
+    interp.allocate_tensors()
+    inp = interp.get_input_details()[0]
+    out = interp.get_output_details()[0]
+    in_scale, in_zp = inp["quantization"]
+    out_scale, out_zp = out["quantization"]
+
+    probs = np.zeros((len(x), out["shape"][-1]), dtype="float32")
+    for i, row in enumerate(x):
+        if inp["dtype"] == np.int8:
+            q = np.clip(np.round(row / in_scale) + in_zp, -128, 127)
+            interp.set_tensor(inp["index"], q.astype(np.int8)[None, :])
+        else:
+            interp.set_tensor(inp["index"], row.astype("float32")[None, :])
+        interp.invoke()
+        y = interp.get_tensor(out["index"])[0]
+        if out["dtype"] == np.int8:
+            y = (y.astype("float32") - out_zp) * out_scale
+        probs[i] = y
+    return probs
+
+
+def compare_models(float_bytes: bytes, quant_bytes: bytes, x: np.ndarray, y: np.ndarray):
+    """Acurácia do float32 x int8 e quantas predições mudam."""
+    pf = tflite_predict(float_bytes, x).argmax(axis=1)
+    pq = tflite_predict(quant_bytes, x).argmax(axis=1)
+    acc_f = float((pf == y).mean())
+    acc_q = float((pq == y).mean())
+    agree = float((pf == pq).mean())
+    print(
+        f"[NEURA9] float32: {len(float_bytes)} bytes, acurácia {acc_f * 100:.2f}% | "
+        f"int8: {len(quant_bytes)} bytes, acurácia {acc_q * 100:.2f}% "
+        f"(delta {(acc_q - acc_f) * 100:+.2f} pp, mesma classe em {agree * 100:.2f}%)"
+    )
+    return acc_f, acc_q, agree
+
+
+def export_tflite(model: keras.Model, out_path: pathlib.Path, quantize: str = "int8",
+                  x_calib=None) -> bytes:
+    tflite_model = convert_tflite(model, quantize, x_calib)
     out_path.write_bytes(tflite_model)
-    print(f"[NEURA9] Modelo TFLite salvo em: {out_path}")
+    print(f"[NEURA9] Modelo TFLite ({quantize}) salvo em: {out_path}")
+    return tflite_model
 
 
 def export_c_array(tflite_bytes: bytes, out_path: pathlib.Path, symbol: str):
@@ -89,6 +174,202 @@ def export_c_array(tflite_bytes: bytes, out_path: pathlib.Path, symbol: str):
     print(f"[NEURA9] Array C salvo em: {out_path}")
 
 
+# -----------------------------------------------------------------------------
+# MLP de ponto fixo (src/neura9/mlp.h)
+# -----------------------------------------------------------------------------
+
+# Folga sobre o máximo visto na calibração antes de saturar o int16
+MLP_HEADROOM = 2.0
+MLP_BIAS_LIMIT = 1 << 30
+
+
+def dense_layers(model: keras.Model):
+    """[(kernel [entrada, saída], bias)] das camadas Dense, em ordem."""
+    return [
+        tuple(np.asarray(w, dtype="float64") for w in layer.get_weights())
+        for layer in model.layers
+        if isinstance(layer, keras.layers.Dense)
+    ]
+
+
+def mlp_float_forward(layers, x: np.ndarray) -> list[np.ndarray]:
+    """Saídas de cada camada em float64: ReLU nas ocultas, logits na última."""
+    outs = []
+    a = np.asarray(x, dtype="float64")
+    for i, (w, b) in enumerate(layers):
+        a = a @ w + b
+        if i < len(layers) - 1:
+            a = np.maximum(a, 0.0)
+        outs.append(a)
+    return outs
+
+
+def _q31(m: np.ndarray):
+    """Multiplicadores reais > 0 como (mult Q31, shift): m ~= mult * 2^-shift."""
+    frac, exp = np.frexp(m)
+    mult = np.round(frac * (1 << 31)).astype("int64")
+    carry = mult == (1 << 31)
+    mult[carry] //= 2
+    exp[carry] += 1
+    shift = 31 - exp
+    if (shift < 1).any():
+        raise SystemExit("[NEURA9] Escala de camada grande demais para o MLP de ponto fixo")
+    # Abaixo de 2^-62 a saída é sempre zero
+    tiny = shift > 62
+    mult[tiny] = 0
+    shift[tiny] = 1
+    return mult.astype("int32"), shift.astype("uint8")
+
+
+def quantize_mlp(layers, x_calib: np.ndarray) -> dict:
+    """
+    Pesos int8 por neurônio, bias int32 e requantização Q31 para o int16 de
+    cada camada. Escalas de ativação pelo máximo da calibração vezes
+    MLP_HEADROOM. Cada uma das 72 entradas tem centro (meio da faixa vista)
+    e escala próprios: features com valor alto e pouca variação (heap,
+    uptime) não viram termos enormes que se cancelam no bias e somem no
+    arredondamento dos pesos int8. O centro entra no bias da 1ª camada.
+    Feature constante na calibração fica com faixa ±max(|centro|, 1): com
+    escala 1 os pesos dela (que nunca contribuem) ditariam a escala int8
+    do neurônio inteiro.
+    """
+    x_calib = np.asarray(x_calib, dtype="float64")
+    acts = mlp_float_forward(layers, x_calib)
+
+    lo, hi = x_calib.min(axis=0), x_calib.max(axis=0)
+    input_center = ((lo + hi) / 2).astype("float32")
+    half = (hi - lo) / 2
+    half = np.where(half > 0, half, np.maximum(np.abs(input_center), 1.0))
+    in_scale = half * MLP_HEADROOM / 32767.0
+    input_inv_scale = (1.0 / in_scale).astype("float32")
+    # Centro e escala efetivos são os float32 gravados no header
+    prev_scale = 1.0 / input_inv_scale.astype("float64")
+    center = input_center.astype("float64")
+
+    qlayers = []
+    for (w, b), a in zip(layers, acts):
+        b = b + center @ w
+        center = np.zeros(w.shape[1])
+        amax = float(np.abs(a).max())
+        out_scale = (amax if amax > 0 else 1.0) * MLP_HEADROOM / 32767.0
+
+        # Escala da entrada embutida nos pesos; uma escala por neurônio
+        wt = (w * prev_scale[:, None]).T
+        wmax = np.abs(wt).max(axis=1)
+        w_scale = np.where(wmax > 0, wmax / 127.0, out_scale / 32768.0)
+        wq = np.clip(np.rint(wt / w_scale[:, None]), -127, 127).astype("int8")
+        bq = np.clip(np.rint(b / w_scale), -MLP_BIAS_LIMIT, MLP_BIAS_LIMIT).astype("int32")
+        mult, shift = _q31(w_scale / out_scale)
+
+        qlayers.append({"weights": wq, "bias": bq, "mult": mult, "shift": shift})
+        prev_scale = np.full(wt.shape[0], out_scale)
+
+    return {
+        "sizes": [layers[0][0].shape[0]] + [w.shape[1] for w, _ in layers],
+        "input_center": input_center,
+        "input_inv_scale": input_inv_scale,
+        "output_scale": np.float32(prev_scale[0]),
+        "layers": qlayers,
+    }
+
+
+def mlp_fixed_predict(q: dict, x: np.ndarray):
+    """
+    Mesma conta inteira do FixedMlp::run() (src/neura9/mlp.h): devolve
+    (classe, logits int16). A entrada passa por float32 como no firmware.
+    """
+    v = (np.asarray(x, dtype="float32") - q["input_center"]) * q["input_inv_scale"]
+    a = np.rint(np.clip(v, np.float32(-32768.0), np.float32(32767.0))).astype("int64")
+    last = len(q["layers"]) - 1
+    for i, layer in enumerate(q["layers"]):
+        acc = a @ layer["weights"].astype("int64").T + layer["bias"].astype("int64")
+        shift = layer["shift"].astype("int64")
+        a = (acc * layer["mult"].astype("int64") + (np.int64(1) << (shift - 1))) >> shift
+        a = np.clip(a, 0 if i < last else -32768, 32767)
+    return a.argmax(axis=1), a.astype("int16")
+
+
+def _c_float(v) -> str:
+    """Literal float que volta exatamente ao mesmo float32."""
+    text = f"{float(v):.9g}"
+    if "." not in text and "e" not in text:
+        text += ".0"
+    return text + "f"
+
+
+def _c_array(f, ctype: str, name: str, values, per_line: int, align: bool = False):
+    values = np.asarray(values).ravel()
+    f.write("{}constexpr {} {}[{}] = {{\n".format("alignas(16) " if align else "", ctype,
+                                                  name, len(values)))
+    for i in range(0, len(values), per_line):
+        chunk = values[i:i + per_line]
+        if ctype == "float":
+            items = ", ".join(_c_float(v) for v in chunk)
+        else:
+            items = ", ".join(str(int(v)) for v in chunk)
+        f.write(f"    {items},\n")
+    f.write("};\n")
+
+
+def export_mlp_header(q: dict, out_path: pathlib.Path):
+    """Grava neura9/mlp_model.h (arrays constexpr + typedef do FixedMlp)."""
+    sizes = q["sizes"]
+    with out_path.open("w") as f:
+        f.write("#pragma once\n\n")
+        f.write("// Pesos do MLP de ponto fixo da NEURA9 (src/neura9/mlp.h).\n")
+        f.write("// Gerado por ai/neura9_trainer.py --mlp-header; não editar à mão.\n\n")
+        f.write('#include "neura9/mlp.h"\n\n')
+        f.write("#define NEURA9_MLP_PLACEHOLDER 0\n\n")
+        f.write("namespace neura9_mlp {\n\n")
+        f.write("typedef FixedMlp<{}> Model;\n\n".format(", ".join(str(s) for s in sizes)))
+        _c_array(f, "float", "INPUT_CENTER", q["input_center"], 6)
+        _c_array(f, "float", "INPUT_INV_SCALE", q["input_inv_scale"], 6)
+        f.write(f"constexpr float OUTPUT_SCALE = {_c_float(q['output_scale'])};\n\n")
+        for i, layer in enumerate(q["layers"]):
+            _c_array(f, "int8_t", f"W{i}", layer["weights"], 24, align=True)
+            _c_array(f, "int32_t", f"B{i}", layer["bias"], 8)
+            _c_array(f, "int32_t", f"M{i}", layer["mult"], 6)
+            _c_array(f, "uint8_t", f"S{i}", layer["shift"], 24)
+            f.write("\n")
+        f.write("constexpr MlpLayer LAYERS[Model::kLayers] = {\n")
+        for i in range(len(q["layers"])):
+            f.write(f"    {{W{i}, B{i}, M{i}, S{i}}},\n")
+        f.write("};\n\n")
+        f.write("}  // namespace neura9_mlp\n")
+    n_bytes = sum(s_in * s_out + s_out * 9 for s_in, s_out in zip(sizes, sizes[1:]))
+    print(f"[NEURA9] MLP de ponto fixo {'x'.join(str(s) for s in sizes)} salvo em: "
+          f"{out_path} ({n_bytes} bytes de parâmetros)")
+
+
+def save_mlp_npz(layers, q: dict, out_path: pathlib.Path):
+    """Pesos float e quantizados, para o tools/neura9/mlp_check.py."""
+    arrays = {"sizes": np.array(q["sizes"]), "input_center": q["input_center"],
+              "input_inv_scale": q["input_inv_scale"],
+              "output_scale": np.array(q["output_scale"])}
+    for i, ((w, b), layer) in enumerate(zip(layers, q["layers"])):
+        arrays[f"w{i}"] = w
+        arrays[f"b{i}"] = b
+        for key in ("weights", "bias", "mult", "shift"):
+            arrays[f"{key}{i}"] = layer[key]
+    np.savez(out_path, **arrays)
+
+
+def load_mlp_npz(path: pathlib.Path):
+    """(camadas float, q) gravados por save_mlp_npz."""
+    d = np.load(path)
+    n = len(d["sizes"]) - 1
+    layers = [(d[f"w{i}"], d[f"b{i}"]) for i in range(n)]
+    q = {
+        "sizes": [int(s) for s in d["sizes"]],
+        "input_center": d["input_center"],
+        "input_inv_scale": d["input_inv_scale"],
+        "output_scale": np.float32(d["output_scale"]),
+        "layers": [{key: d[f"{key}{i}"] for key in ("weights", "bias", "mult", "shift")}
+                   for i in range(n)],
+    }
+    return layers, q
+
+
 def main():
     parser = argparse.ArgumentParser()
     parser.add_argument(
@@ -109,8 +390,23 @@ def main():
         default=256,
         help="Tamanho do batch",
     )
+    parser.add_argument(
+        "--quantize",
+        choices=["int8", "float"],
+        default="int8",
+        help="Tipo do modelo exportado (padrão: int8 com entrada/saída int8)",
+    )
+    parser.add_argument(
+        "--mlp-header",
+        type=pathlib.Path,
+        help="Gera também o MLP de ponto fixo (ex. src/neura9/mlp_model.h) e "
+             "ai/neura9_mlp.npz para o tools/neura9/mlp_check.py",
+    )
     args = parser.parse_args()
 
+    if tf is None:
+        raise SystemExit("TensorFlow não encontrado (pip install tensorflow)")
+
     if not args.dataset.exists():
         raise SystemExit(
             f"Dataset não encontrado em {args.dataset}. "
@@ -128,6 +424,12 @@ def main():
     model = build_model(input_dim=x.shape[1], num_classes=10)
     model.summary()
 
+    # Embaralha antes: o validation_split do Keras pega as últimas linhas,
+    # que também são as usadas para comparar float x int8 abaixo
+    order = np.random.default_rng(0).permutation(len(x))
+    x, y = x[order], y[order]
+    n_train = int(len(x) * 0.8)
+
     model.fit(
         x,
         y,
@@ -141,7 +443,10 @@ def main():
     out_dir.mkdir(parents=True, exist_ok=True)
 
     tflite_path = out_dir / "neura9_defense_model.tflite"
-    export_tflite(model, tflite_path)
+    export_tflite(model, tflite_path, args.quantize, x[:n_train])
+    if args.quantize == "int8":
+        compare_models(convert_tflite(model, "float"), tflite_path.read_bytes(),
+                       x[n_train:], y[n_train:])
 
     c_array_path = out_dir / "neura9_defense_model_data.cpp"
     export_c_array(
@@ -150,6 +455,18 @@ def main():
         symbol="neura9_defense_model_tflite",
     )
 
+    if args.mlp_header:
+        layers = dense_layers(model)
+        q = quantize_mlp(layers, x[:n_train])
+        export_mlp_header(q, args.mlp_header)
+        save_mlp_npz(layers, q, out_dir / "neura9_mlp.npz")
+        pm, _ = mlp_fixed_predict(q, x[n_train:])
+        pf = tflite_predict(convert_tflite(model, "float"), x[n_train:]).argmax(axis=1)
+        print(
+            f"[NEURA9] MLP de ponto fixo: acurácia {(pm == y[n_train:]).mean() * 100:.2f}%, "
+            f"mesma classe do TFLite float32 em {(pm == pf).mean() * 100:.2f}%"
+        )
+
 
 if __name__ == "__main__":
     main()
\ No newline at end of file
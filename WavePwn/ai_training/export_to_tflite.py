@@ -2,23 +2,38 @@
 """
 export_to_tflite.py - Converte um modelo Keras (.h5) para TensorFlow Lite (.tflite)
 
+Por padrão o modelo sai com quantização inteira completa (int8, entrada e
+saída int8), calibrada com amostras do dataset; o firmware quantiza as 72
+features com a escala/zero-point do tensor de entrada. --quantize float
+gera o float32 de antes.
+
 Uso:
 
-    python export_to_tflite.py --model best_model.h5 --output neura9_defense_model.tflite
+    python export_to_tflite.py --model best_model.h5 --output neura9_defense_model.tflite \\
+        --dataset neura9_dataset.csv
 
 Por convenção, execute a partir da pasta WavePwn/:
 
     cd WavePwn
-    python ai_training/export_to_tflite.py \
-        --model ai_training/best_model.h5 \
-        --output ai/neura9_defense_model.tflite
+    python ai_training/export_to_tflite.py \\
+        --model ai_training/best_model.h5 \\
+        --dataset ai/dataset/neura9_dataset.csv \\
+        --output ai/neura9_defense_model.tflite \\
+        --c-array ai/neura9_defense_model_data.cpp
+
+Com --dataset, imprime também a acurácia do float32 e do int8 no dataset
+(interpretador TFLite do host, mesmos kernels de referência da TFLM).
 """
 
 import argparse
 import pathlib
+import sys
 
 import tensorflow as tf
 
+sys.path.insert(0, str(pathlib.Path(__file__).resolve().parent.parent / "ai"))
+from neura9_trainer import compare_models, convert_tflite, export_c_array, load_dataset  # noqa: E402
+
 
 def main() -> None:
     parser = argparse.ArgumentParser()
@@ -34,24 +49,49 @@ def main() -> None:
         required=True,
         help="Caminho de saída para o .tflite",
     )
+    parser.add_argument(
+        "--quantize",
+        choices=["int8", "float"],
+        default="int8",
+        help="int8 (padrão, precisa de --dataset) ou float32",
+    )
+    parser.add_argument(
+        "--dataset",
+        type=pathlib.Path,
+        help="CSV f0..f71,label: calibração do int8 e comparação de acurácia",
+    )
+    parser.add_argument(
+        "--c-array",
+        type=pathlib.Path,
+        help="Gera também o array C (ex. ai/neura9_defense_model_data.cpp)",
+    )
     args = parser.parse_args()
 
     if not args.model.exists():
         raise SystemExit(f"Modelo não encontrado em {args.model}")
+    if args.quantize == "int8" and not args.dataset:
+        raise SystemExit("--quantize int8 precisa de --dataset para calibrar")
 
     print(f"[NEURA9] Carregando modelo Keras de {args.model}")
     model = tf.keras.models.load_model(args.model)
 
-    print("[NEURA9] Convertendo para TensorFlow Lite (float32)")
-    converter = tf.lite.TFLiteConverter.from_keras_model(model)
-    converter.optimizations = [tf.lite.Optimize.DEFAULT]
-    tflite_model = converter.convert()
+    x = y = None
+    if args.dataset:
+        x, y = load_dataset(args.dataset)
+
+    print(f"[NEURA9] Convertendo para TensorFlow Lite ({args.quantize})")
+    tflite_model = convert_tflite(model, args.quantize, x)
 
     args.output.parent.mkdir(parents=True, exist_ok=True)
     args.output.write_bytes(tflite_model)
+    print(f"[NEURA9] Modelo TFLite salvo em: {args.output} ({len(tflite_model)} bytes)")
+
+    if args.quantize == "int8":
+        compare_models(convert_tflite(model, "float"), tflite_model, x, y)
 
-    print(f"[NEURA9] Modelo TFLite salvo em: {args.output}")
+    if args.c_array:
+        export_c_array(tflite_model, args.c_array, symbol="neura9_defense_model_tflite")
 
 
 if __name__ == "__main__":
-    main()
\ No newline at end of file
+    main()
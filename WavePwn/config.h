@@ -8,7 +8,10 @@
 // Canais Wi-Fi para varredura (1-13, use 1,6,11 para menos hop)
 const uint8_t WIFI_CHANNELS[] = {1, 6, 11, 2, 7, 3, 8, 4, 9, 5, 10, 12, 13};
 #define CHANNEL_COUNT               13
-#define CHANNEL_HOP_DELAY           10000  // ms
+#define CHANNEL_HOP_DELAY           10000  // ms (dwell médio por canal)
+#define CHANNEL_HOP_ADAPTIVE        true   // false = round-robin fixo
+#define CHANNEL_HOP_MIN_DWELL       1000   // ms, canal sem atividade
+#define CHANNEL_HOP_MAX_DWELL       30000  // ms, canal mais movimentado
 
 // Deauth settings
 #define DEAUTH_PACKETS_PER_TARGET   15
@@ -1,10 +1,10 @@
 #include <Arduino.h>
-#include <SD.h>
 #include <lvgl.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #include "pwnagotchi.h"
+#include "storage.h"
 #include "ui.h"
 
 // Indica se o modo laboratorio esta ativo.
@@ -35,14 +35,13 @@ void konami_godmode() {
         return;
     }
 
-    // Verifica arquivo secreto no microSD (sem re-inicializar SD)
-    if (!SD.begin()) {
-        Serial.println("[EASTER] SD nao inicializado - GODMODE abortado");
-        ui_reset_eye_left_longpress_flag();
-        return;
-    }
-
-    if (!SD.exists("/sd/.wavepwn_master")) {
+    // Verifica arquivo secreto no microSD (pela task sd, sem re-inicializar
+    // o cartão: sem SD montado o arquivo simplesmente não existe)
+    bool master = false;
+    storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_REPORT, [](void* arg) {
+        *(bool*)arg = SDCARD.exists("/sd/.wavepwn_master");
+    }, &master);
+    if (!master) {
         Serial.println("[EASTER] Arquivo secreto /sd/.wavepwn_master ausente");
         ui_reset_eye_left_longpress_flag();
         return;
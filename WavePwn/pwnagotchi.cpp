@@ -1,6 +1,5 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include <SD.h>
 #include <esp_wifi.h>
 #include <esp_sleep.h>
 #include <ArduinoJson.h>
@@ -15,6 +14,7 @@
 #include "sensors.h"
 #include "audio.h"
 #include "capture.h"
+#include "capture/ap_table.h"
 #include "ai/neura9_inference.h"
 #include "src/webserver.h"
 #include "src/home_assistant.h"
@@ -22,6 +22,8 @@
 #include "anti_tamper/secure_boot.h"
 #include "reports/tiny_pdf.h"
 #include "assistants/assistant_manager.h"
+#include "utils/config_store.h"
+#include "utils/event_log.h"
 
 uint32_t threat_count = 0;
 
@@ -52,8 +54,22 @@ void load_language(const char* lang) {
     path += lang;
     path += ".json";
 
-    File f = SD.open(path.c_str());
-    if (!f) {
+    // Lido inteiro pela task sd; o parse fica aqui
+    struct LangFile {
+        const char* path;
+        bool opened;
+        String text;
+    } file = {path.c_str(), false, String()};
+    storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_CONFIG, [](void* arg) {
+        LangFile* lf = (LangFile*)arg;
+        File f = SDCARD.open(lf->path);
+        if (!f) return;
+        lf->opened = true;
+        lf->text = f.readString();
+        f.close();
+        storage_account(lf->text.length(), 0);
+    }, &file);
+    if (!file.opened) {
         Serial.printf("[LANG] Falha ao abrir %s\n", path.c_str());
         if (strcmp(lang, "en-US") != 0) {
             load_language("en-US");
@@ -62,8 +78,7 @@ void load_language(const char* lang) {
     }
 
     StaticJsonDocument<1024> doc;
-    DeserializationError err = deserializeJson(doc, f);
-    f.close();
+    DeserializationError err = deserializeJson(doc, file.text);
 
     if (err) {
         Serial.printf("[LANG] Erro ao parsear %s: %s\n",
@@ -145,6 +160,8 @@ void Pwnagotchi::begin() {
     showBootAnimation();
 
     initSD();
+    // /config lido uma vez; daqui em diante tudo vem da RAM
+    config_store.begin();
     capture_init();
 
     initSensors();
@@ -172,6 +189,7 @@ void Pwnagotchi::begin() {
     if (!neura9.begin()) {
         Serial.println("[NEURA9] Falha ao inicializar IA defensiva (modo stub)");
     }
+    neura9.start_service();
 
     // BLE PwnGrid cooperativo
     pwnGrid.begin();
@@ -192,6 +210,9 @@ void Pwnagotchi::update() {
     // Atualiza timers relacionados ao Home Assistant (NTP etc.).
     ha_loop();
 
+    // Linhas de log paradas na fila há mais de EVENT_LOG_FLUSH_MS
+    event_log_poll(millis());
+
     // Placeholders de ambiente (até integrar sensores reais reais).
     // Estes valores podem ser sobrescritos por sensores.cpp quando existirem.
     if (battery_percent <= 0.0f || battery_percent > 100.0f) {
@@ -204,6 +225,11 @@ void Pwnagotchi::update() {
         return;
     }
 
+    // Contagens vêm da tabela de APs (atualizada pela task de captura). Só o
+    // total: get_summary() varre a tabela inteira, caro demais a cada 5 ms
+    aps_seen = ap_table.aps_total();
+    current_channel = wifi_sniffer_channel();
+
     ui_update_stats(
         aps_seen,
         handshakes,
@@ -214,31 +240,27 @@ void Pwnagotchi::update() {
         is_moving
     );
 
-    // NEURA9 avalia o ambiente periodicamente (HUD + PwnGrid + Home Assistant)
-    static uint32_t last_ai = 0;
+    // A task neura9 avalia o ambiente; aqui só reage a um resultado novo
+    // (HUD + PwnGrid + Home Assistant)
     uint32_t now = millis();
-    if (now - last_ai > 800) {
-        uint8_t cls = neura9.predict();
-        float conf  = neura9.get_confidence();
-        threat_level = cls;
-        threat_confidence = conf;
-
-        if (cls > 0) {
+    static uint32_t last_ai_seq = 0;
+    Neura9Result ai;
+    if (neura9.get_result(&ai) && ai.seq != last_ai_seq) {
+        last_ai_seq = ai.seq;
+        threat_level = ai.cls;
+        threat_confidence = ai.confidence;
+
+        if (ai.cls > 0) {
             threat_count++;
         }
 
-        Serial.printf("[NEURA9] classe=%u (%s) conf=%.2f\n",
-                      cls,
-                      NEURA9_THREAT_LABELS[cls],
-                      conf);
-
-        last_ai = now;
+        neura9_apply_mood(ai.cls);
 
         // Compartilha nível de ameaça com a PwnGrid cooperativa
-        pwnGrid.share_threat_level(cls);
+        pwnGrid.share_threat_level(ai.cls);
 
         // Publica o nível de ameaça atual no Home Assistant / Google Home.
-        ha_send_threat(NEURA9_THREAT_LABELS[cls]);
+        ha_send_threat(NEURA9_THREAT_LABELS[ai.cls]);
     }
 
     // Tema dark/light automatico simples baseado em tempo de execução
@@ -260,6 +282,9 @@ void Pwnagotchi::update() {
         last_voice_status = now;
     }
 
+    // Moods/celebrações sinalizados pela task de captura
+    capture_dispatch_ui_events();
+
     // Deixa o LVGL rodar a UI
     lv_timer_handler();
     vTaskDelay(pdMS_TO_TICKS(5));
@@ -276,22 +301,29 @@ void Pwnagotchi::initDisplay() {
 void Pwnagotchi::initSD() {
     Serial.println("[WavePwn] initSD() - inicializando microSD...");
 
-    if (!SD.begin()) {
+    // SDMMC em alta velocidade (storage_card.cpp)
+    if (!storage_mount()) {
         Serial.println("[WavePwn] Falha ao inicializar o microSD");
         return;
     }
 
     // Estrutura definitiva de pastas
-    SD.mkdir("/sd");
-    SD.mkdir("/sd/wavepwn");
-    SD.mkdir("/sd/wavepwn/handshakes");
-    SD.mkdir("/sd/wavepwn/pmkid");
-    SD.mkdir("/sd/wavepwn/sae");
-    SD.mkdir("/sd/wavepwn/logs");
-    SD.mkdir("/sd/wavepwn/session");
-    SD.mkdir("/sd/lang");
-    SD.mkdir("/sd/reports");
-    SD.mkdir("/sd/lab_logs");
+    SDCARD.mkdir("/sd");
+    SDCARD.mkdir("/sd/wavepwn");
+    SDCARD.mkdir("/sd/wavepwn/handshakes");
+    SDCARD.mkdir("/sd/wavepwn/pmkid");
+    SDCARD.mkdir("/sd/wavepwn/sae");
+    SDCARD.mkdir("/sd/wavepwn/logs");
+    SDCARD.mkdir("/sd/wavepwn/session");
+    SDCARD.mkdir("/sd/lang");
+    SDCARD.mkdir("/sd/reports");
+    SDCARD.mkdir("/sd/lab_logs");
+
+    // Daqui em diante o cartão é da task sd (storage.h)
+    storage_start();
+
+    // Anel de eventos do lab/web em /sd/lab_logs (utils/event_log.h)
+    event_log_begin();
 
     Serial.println("[WavePwn] microSD pronto para captura de handshakes");
 }
@@ -327,11 +359,17 @@ void Pwnagotchi::initWiFiMonitor() {
     filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_DATA;
     esp_wifi_set_promiscuous_filter(&filter);
 
-    // Canal inicial (primeiro da lista configurada)
-    esp_wifi_set_channel(WIFI_CHANNELS[0], WIFI_SECOND_CHAN_NONE);
-
     // Ativa modo promíscuo
     esp_wifi_set_promiscuous(true);
+
+    // Channel hopping: começa no primeiro canal da lista e distribui o tempo
+    // conforme a atividade de cada canal (ou round-robin fixo)
+    wifi_sniffer_begin(WIFI_CHANNELS,
+                       CHANNEL_COUNT,
+                       CHANNEL_HOP_DELAY,
+                       CHANNEL_HOP_MIN_DWELL,
+                       CHANNEL_HOP_MAX_DWELL,
+                       CHANNEL_HOP_ADAPTIVE);
 }
 
 void Pwnagotchi::initSensors() {
@@ -377,16 +415,21 @@ void Pwnagotchi::enterZombieMode() {
     esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
     esp_sleep_enable_timer_wakeup(30000000ULL); // 30 segundos em micros
 
+    uint32_t last_seq = 0;
     while (true) {
-        // Ainda protege mesmo dormindo: a IA defensiva roda e atualiza o nível.
-        uint8_t cls = neura9.predict();
-        threat_level = cls;
-        threat_confidence = neura9.get_confidence();
-
-        Serial.printf("[ZUMBI] Tick - classe=%u (%s) conf=%.2f\n",
-                      cls,
-                      NEURA9_THREAT_LABELS[cls],
-                      threat_confidence);
+        // Ainda protege mesmo dormindo: pede uma inferência ao serviço da
+        // NEURA9 (que dorme junto) e atualiza o nível.
+        Neura9Result ai;
+        if (neura9.infer_now(last_seq, &ai, 1000)) {
+            last_seq = ai.seq;
+            threat_level = ai.cls;
+            threat_confidence = ai.confidence;
+
+            Serial.printf("[ZUMBI] Tick - classe=%u (%s) conf=%.2f\n",
+                          ai.cls,
+                          NEURA9_THREAT_LABELS[ai.cls],
+                          ai.confidence);
+        }
 
         // Dorme profundamente até o próximo tick; o resto do sistema fica em paz.
         esp_light_sleep_start();
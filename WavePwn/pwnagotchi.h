@@ -38,6 +38,10 @@ public:
     uint32_t pmkids = 0;
     uint32_t deauths = 0;
 
+    // Pipeline de captura (atualizado pela task de captura)
+    uint32_t frames_captured = 0;
+    uint32_t frames_dropped  = 0;
+
     // Estado de ambiente para NEURA9
     float    battery_percent   = 100.0f;
     bool     is_charging       = false;
@@ -1,9 +1,9 @@
 #pragma once
 
 #include <Arduino.h>
-#include <SD.h>
 
 #include "pwnagotchi.h"
+#include "storage.h"
 
 // Contador global de ameacas detectadas pela NEURA9.
 // Definido em pwnagotchi.cpp.
@@ -36,24 +36,46 @@ public:
         buffer += "\n";
     }
 
+    // Gravado em segundo plano pela task sd (fila BULK). false se a fila
+    // estiver cheia.
     bool save(const String& fullPath) {
-        File f = SD.open(fullPath.c_str(), FILE_WRITE);
-        if (!f) {
-            Serial.printf("[PDF] Falha ao abrir %s\n", fullPath.c_str());
+        SaveJob* job = new SaveJob{fullPath, buffer};
+        if (!storage_submit(STORAGE_PRIO_BULK, STORAGE_CLIENT_REPORT, write_job, job, free_job)) {
+            Serial.printf("[PDF] Fila do SD cheia, %s nao salvo\n", fullPath.c_str());
+            delete job;
             return false;
         }
+        return true;
+    }
+
+private:
+    struct SaveJob {
+        String path;
+        String text;
+    };
+
+    String buffer;
+
+    static void write_job(void* arg) {
+        SaveJob* job = (SaveJob*)arg;
+        File f = SDCARD.open(job->path.c_str(), FILE_WRITE);
+        if (!f) {
+            Serial.printf("[PDF] Falha ao abrir %s\n", job->path.c_str());
+            return;
+        }
 
-        f.println("WAVE PWN v2 - Relatorio de Seguranca");
-        f.print(buffer);
+        size_t n = f.println("WAVE PWN v2 - Relatorio de Seguranca");
+        n += f.print(job->text);
         f.close();
+        storage_account(0, n);
 
         Serial.printf("[PDF] Relatorio salvo em %s (formato simplificado)\n",
-                      fullPath.c_str());
-        return true;
+                      job->path.c_str());
     }
 
-private:
-    String buffer;
+    static void free_job(void* arg) {
+        delete (SaveJob*)arg;
+    }
 };
 
 // Gera um relatorio simples com estatisticas atuais do dispositivo.
@@ -1,8 +1,5 @@
 #include "assistants/assistant_manager.h"
 
-#include <SD.h>
-#include <ArduinoJson.h>
-
 #include "assistants/alexa.h"
 #include "assistants/google_home.h"
 #include "ai/neura9_inference.h"
@@ -13,39 +10,14 @@ extern Neura9     neura9;
 
 AssistantManager assistantManager;
 
-void AssistantManager::load_from_sd() {
-    File f = SD.open("/config/device_config.json");
-    if (!f) {
-        Serial.println("[Assistant] device_config.json não encontrado em /config — usando defaults");
-        return;
-    }
-
-    DynamicJsonDocument doc(1024);
-    DeserializationError err = deserializeJson(doc, f);
-    f.close();
-
-    if (err) {
-        Serial.printf("[Assistant] Erro ao parsear device_config.json: %s\n", err.c_str());
-        return;
-    }
-
-    device_name        = doc["device_name"]       | device_name;
-    assistant_type     = doc["assistant"]         | assistant_type;
-    language           = doc["language"]          | language;
-    theme              = doc["theme"]             | theme;
-    owner              = doc["owner"]             | owner;
-    enable_voice_alerts = doc["enable_voice_alerts"] | enable_voice_alerts;
-    neura9_sensitivity = doc["neura9_sensitivity"] | neura9_sensitivity;
-
-    device_name.trim();
-    assistant_type.trim();
-    language.trim();
-    theme.trim();
-    owner.trim();
-
-    if (assistant_type.length() == 0) {
-        assistant_type = "none";
-    }
+void AssistantManager::apply_config(const DeviceConfig &cfg) {
+    device_name         = cfg.device_name;
+    assistant_type      = cfg.assistant;
+    language            = cfg.language;
+    theme               = cfg.theme;
+    owner               = cfg.owner;
+    enable_voice_alerts = cfg.enable_voice_alerts;
+    neura9_sensitivity  = cfg.neura9_sensitivity;
 
     Serial.printf("[Assistant] device_name='%s', assistant='%s', lang='%s', theme='%s'\n",
                   device_name.c_str(),
@@ -54,8 +26,23 @@ void AssistantManager::load_from_sd() {
                   theme.c_str());
 }
 
+// Roda na task de quem alterou a config: só marca, quem aplica é o dono
+// dos campos (loop da UI)
+void AssistantManager::on_config_change(ConfigSection section, void *ctx) {
+    if (section == CONFIG_DEVICE) {
+        static_cast<AssistantManager *>(ctx)->config_changed.store(true);
+    }
+}
+
+void AssistantManager::refresh() {
+    if (config_changed.exchange(false)) {
+        apply_config(config_store.device());
+    }
+}
+
 void AssistantManager::begin() {
-    load_from_sd();
+    apply_config(config_store.device());
+    config_store.subscribe(on_config_change, this);
 
     if (assistant_type == "alexa" || assistant_type == "both") {
         alexa_init(device_name);
@@ -66,6 +53,7 @@ void AssistantManager::begin() {
 }
 
 void AssistantManager::speak(const char *text) {
+    refresh();
     if (!text || !enable_voice_alerts) {
         return;
     }
@@ -83,6 +71,8 @@ void AssistantManager::speak(const char *text) {
 }
 
 void AssistantManager::send_status() {
+    refresh();
+
     String status;
     status.reserve(128);
 
@@ -1,10 +1,18 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
+
+#include "utils/config_store.h"
 
 // Gerencia o nome do dispositivo e a escolha dinâmica de assistentes
 // de voz (Alexa / Google Home / ambos / nenhum), com base em
-// src/config/device_config.json.
+// /config/device_config.json (ConfigStore; modelo em
+// src/config/device_config.json).
+//
+// Alterações feitas pelo dashboard chegam por assinatura do ConfigStore e
+// valem a partir do próximo speak()/send_status(); trocar o assistente
+// só tem efeito no próximo boot.
 //
 // Formato esperado:
 //
@@ -38,7 +46,11 @@ private:
     bool   enable_voice_alerts = true;
     float  neura9_sensitivity = 0.78f;
 
-    void load_from_sd();
+    std::atomic<bool> config_changed{false};
+
+    void apply_config(const DeviceConfig &cfg);
+    void refresh();
+    static void on_config_change(ConfigSection section, void *ctx);
 };
 
 extern AssistantManager assistantManager;
\ No newline at end of file
@@ -1,12 +1,25 @@
 #include "capture.h"
+#include "capture/ap_table.h"
+#include "capture/dot11.h"
+#include "capture/frame_ring.h"
+#include "capture/handshake_tracker.h"
+#include "capture/mac_table.h"
+#include "capture/pcap_writer.h"
+#include "capture/session_log.h"
+#include "neura9/features.h"
 #include "pwnagotchi.h"
+#include "storage.h"
+#include "wifi_sniffer.h"
 #include "ui.h"
 
 #include <Arduino.h>
 #include <esp_wifi_types.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
 #include <time.h>
-#include <set>
-#include <map>
 
 extern Pwnagotchi pwn;
 
@@ -14,125 +27,222 @@ extern Pwnagotchi pwn;
 // Estado global da captura
 // -----------------------------------------------------------------------------
 
-File pcap_file;
+static PcapWriter pcap_writer;
+static CaptureFormat capture_format = CAPTURE_DEFAULT_FORMAT;
 String current_pcap_path = "";
-uint64_t pcap_size = 0;
 const uint64_t MAX_PCAP_SIZE = 150ULL * 1024 * 1024; // 150 MB por arquivo
 
-// Deduplicação em RAM (AP+STA)
-static std::set<String> seen_handshakes;
-
-// Mapa BSSID -> SSID (para enriquecer logs / futuros exports 22000)
-static std::map<String, String> bssid_to_ssid;
+// Deduplicação em RAM (AP+STA): chave = 12 bytes crus, capacidade fixa em PSRAM
+static const uint32_t SEEN_HANDSHAKES_CAPACITY = 4096;
+static MacTable<12, uint8_t> seen_handshakes;
+
+// PMKIDs já registrados: chave = BSSID + PMKID (22 bytes). O AP repete o
+// mesmo PMKID em todo beacon; só o primeiro vira registro, contagem e UI
+static const uint32_t SEEN_PMKIDS_CAPACITY = 1024;
+static const size_t PMKID_KEY_LEN = 6 + 16;
+static MacTable<PMKID_KEY_LEN, uint8_t> seen_pmkids;
+
+// Log binário da sessão (PMKID/handshake/AP), aberto durante todo o boot
+static SessionLog session_log;
+
+// Handshakes em andamento (M1..M4 por AP/STA)
+static const uint32_t HANDSHAKE_SESSIONS_CAPACITY = 128;  // ~80 KB em PSRAM
+static HandshakeTracker handshake_tracker;
+
+// Mapa BSSID -> SSID (ESSID das linhas 22000, aprendido de beacons)
+struct SsidEntry {
+    uint8_t ssid_len;         // 0 = ainda desconhecido; NULs no meio valem
+    char ssid[33];
+};
+static const uint32_t BSSID_SSID_CAPACITY = 2048;
+static MacTable<6, SsidEntry> bssid_to_ssid;
+
+// Ring SPSC callback -> task de captura (slots em PSRAM)
+static const uint32_t CAPTURE_RING_SLOTS = 256;          // ~600 KB em PSRAM
+static const uint32_t CAPTURE_RING_SLOTS_FALLBACK = 16;  // sem PSRAM
+static const BaseType_t CAPTURE_TASK_CORE = 0;
+static const UBaseType_t CAPTURE_TASK_PRIO = 3;
+static const uint32_t CAPTURE_TASK_STACK = 8192;
+
+static FrameRing capture_ring;
+static TaskHandle_t capture_task_handle = nullptr;
+static uint32_t frames_processed = 0;
+
+// Eventos para a UI: a task de captura só marca, o loop do LVGL aplica.
+static std::atomic<uint32_t> pending_ui_handshakes{0};
+static std::atomic<uint32_t> pending_ui_pmkids{0};
 
 // -----------------------------------------------------------------------------
 // Helpers internos
 // -----------------------------------------------------------------------------
 
-static void capture_write_global_header();
-static bool locate_eapol(const uint8_t* frame,
-                         uint16_t len,
-                         uint16_t& eapol_offset,
-                         uint16_t& eapol_len);
-static bool is_eapol_frame(const uint8_t* frame, uint16_t len);
+static void parse_pmkid(const dot11::Dot11View& view);
+static void parse_handshake(const dot11::Dot11View& view, uint8_t channel, uint32_t rx_ms);
+static void learn_ssid(const dot11::Dot11View& view, uint8_t channel);
+static bool ssid_is_hidden(const uint8_t* ssid, size_t len);
+static void ssid_entry_set(SsidEntry* entry, const void* ssid, size_t len);
+static void capture_resume_sessions();
 
-static void parse_pmkid(const uint8_t* frame, uint16_t len, uint8_t channel);
-static void parse_handshake(const uint8_t* frame, uint16_t len, uint8_t channel);
+static void* capture_alloc(size_t bytes);
+static void capture_process_frame(const CaptureSlot* slot);
+static void capture_task(void* arg);
 
-static String mac_to_string(const uint8_t* mac);
 static String mac_to_string_nosep(const uint8_t* mac);
-static String bytes_to_hex(const uint8_t* data, size_t len);
 
 // -----------------------------------------------------------------------------
 // PCAP
 // -----------------------------------------------------------------------------
 
-static void capture_write_global_header() {
-    // Cabeçalho PCAP clássico little-endian, linktype = IEEE802_11 (105)
-    uint8_t header[24] = {
-        0xd4, 0xc3, 0xb2, 0xa1, // magic number (little endian)
-        0x02, 0x00,             // version major
-        0x04, 0x00,             // version minor
-        0x00, 0x00, 0x00, 0x00, // thiszone
-        0x00, 0x00, 0x00, 0x00, // sigfigs
-        0xff, 0xff, 0x00, 0x00, // snaplen
-        0x69, 0x00, 0x00, 0x00  // network = 105 (LINKTYPE_IEEE802_11)
-    };
-
-    pcap_file.write(header, sizeof(header));
-    pcap_size = sizeof(header);
-}
-
 void capture_rotate_files() {
-    if (pcap_file) {
-        pcap_file.flush();
-        pcap_file.close();
-    }
+    // Fecha o PCAP anterior drenando os buffers pendentes
+    pcap_writer.close();
 
     time_t t = time(nullptr);
     struct tm* tm_info = localtime(&t);
 
+    bool ng = (capture_format == CAPTURE_FORMAT_PCAPNG);
+    const char* ext = ng ? "pcapng" : "pcap";
+
     char path[96];
     if (tm_info) {
         snprintf(path,
                  sizeof(path),
-                 "/sd/wavepwn/handshakes/%04d%02d%02d_%02d%02d%02d.pcap",
+                 "/sd/wavepwn/handshakes/%04d%02d%02d_%02d%02d%02d.%s",
                  tm_info->tm_year + 1900,
                  tm_info->tm_mon + 1,
                  tm_info->tm_mday,
                  tm_info->tm_hour,
                  tm_info->tm_min,
-                 tm_info->tm_sec);
+                 tm_info->tm_sec,
+                 ext);
     } else {
         // Fallback se RTC não estiver configurado
         unsigned long ms = millis();
         snprintf(path,
                  sizeof(path),
-                 "/sd/wavepwn/handshakes/%010lu.pcap",
-                 ms / 1000UL);
+                 "/sd/wavepwn/handshakes/%010lu.%s",
+                 ms / 1000UL,
+                 ext);
     }
 
     current_pcap_path = path;
 
-    pcap_file = SD.open(path, FILE_WRITE);
-    if (!pcap_file) {
+    if (!pcap_writer.open(path, ng ? PCAP_FORMAT_PCAPNG : PCAP_FORMAT_LEGACY)) {
         Serial.printf("[CAPTURE] ERRO ao abrir PCAP '%s' para escrita\n", path);
         return;
     }
 
-    capture_write_global_header();
     Serial.printf("[CAPTURE] Novo PCAP: %s\n", path);
 }
 
 void capture_init() {
     // Assume que o SD já foi inicializado em Pwnagotchi::initSD()
+    pcap_writer.begin();
     capture_rotate_files();
+
+    seen_handshakes.begin(
+        capture_alloc(seen_handshakes.storage_bytes(SEEN_HANDSHAKES_CAPACITY)),
+        SEEN_HANDSHAKES_CAPACITY);
+    seen_pmkids.begin(
+        capture_alloc(seen_pmkids.storage_bytes(SEEN_PMKIDS_CAPACITY)),
+        SEEN_PMKIDS_CAPACITY);
+    bssid_to_ssid.begin(
+        capture_alloc(bssid_to_ssid.storage_bytes(BSSID_SSID_CAPACITY)),
+        BSSID_SSID_CAPACITY);
+    handshake_tracker.begin(
+        capture_alloc(HandshakeTracker::storage_bytes(HANDSHAKE_SESSIONS_CAPACITY)),
+        HANDSHAKE_SESSIONS_CAPACITY);
+
+    ap_table.begin();
+    neura9_features.begin();
+
+    // Retoma a deduplicação das sessões anteriores e abre o log desta
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE,
+                 [](void*) { capture_resume_sessions(); }, nullptr);
+    session_log.begin();
+
+    uint32_t slots = CAPTURE_RING_SLOTS;
+    CaptureSlot* storage = (CaptureSlot*)heap_caps_malloc(
+        slots * sizeof(CaptureSlot), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!storage) {
+        slots = CAPTURE_RING_SLOTS_FALLBACK;
+        storage = (CaptureSlot*)heap_caps_malloc(
+            slots * sizeof(CaptureSlot), MALLOC_CAP_8BIT);
+    }
+    if (!storage || !capture_ring.begin(storage, slots)) {
+        Serial.println("[CAPTURE] ERRO ao alocar ring de frames, captura desativada");
+        return;
+    }
+
+    xTaskCreatePinnedToCore(capture_task,
+                            "capture",
+                            CAPTURE_TASK_STACK,
+                            nullptr,
+                            CAPTURE_TASK_PRIO,
+                            &capture_task_handle,
+                            CAPTURE_TASK_CORE);
+
+    Serial.printf("[CAPTURE] Ring de %lu slots (%u KB) + task no core %d\n",
+                  (unsigned long)slots,
+                  (unsigned)(slots * sizeof(CaptureSlot) / 1024),
+                  (int)CAPTURE_TASK_CORE);
+}
+
+void capture_get_stats(CaptureStats* out) {
+    if (!out) return;
+    out->frames_received = capture_ring.total_pushed();
+    out->frames_processed = frames_processed;
+    out->frames_dropped = capture_ring.total_dropped();
+    out->ring_depth = capture_ring.depth();
+    out->ring_max_depth = capture_ring.max_depth();
+    out->ring_capacity = capture_ring.capacity();
+
+    PcapWriterStats ws;
+    pcap_writer.get_stats(&ws);
+    out->pcap_bytes = ws.bytes_written;
+    out->pcap_sd_writes = ws.sd_writes;
+    out->pcap_stalls = ws.stalls;
+    out->eapol_oversize = handshake_tracker.oversize_frames();
+}
+
+void capture_dispatch_ui_events() {
+    if (pending_ui_handshakes.exchange(0, std::memory_order_relaxed) > 0) {
+        ui_set_mood(MOOD_HANDSHAKE);
+        ui_celebrate_handshake();
+    }
+    if (pending_ui_pmkids.exchange(0, std::memory_order_relaxed) > 0) {
+        ui_set_mood(MOOD_PMKID);
+        ui_celebrate_pmkid();
+    }
 }
 
 String capture_get_current_pcap() {
     return current_pcap_path;
 }
 
-void capture_write_pcap(const uint8_t* data, uint32_t len, uint32_t channel) {
-    if (!pcap_file) return;
+void capture_set_format(CaptureFormat format) {
+    capture_format = format;
+}
+
+CaptureFormat capture_get_format() {
+    return capture_format;
+}
 
-    // Timestamp em microssegundos baseado no millis()
-    uint32_t ms = millis();
-    uint32_t ts_sec = ms / 1000;
-    uint32_t ts_usec = (ms % 1000) * 1000;
+// Grava o frame do slot: preserva timestamp µs e rx_ctrl.
+static void capture_write_slot(const CaptureSlot* slot) {
+    if (!pcap_writer.is_open()) return;
 
-    // Cabeçalho por pacote
-    uint8_t header[16];
-    memcpy(header + 0, &ts_sec, 4);
-    memcpy(header + 4, &ts_usec, 4);
-    memcpy(header + 8, &len, 4);
-    memcpy(header + 12, &len, 4);
+    PcapPacketInfo info;
+    info.timestamp_us = slot->timestamp_us;
+    info.orig_len = slot->orig_len;
+    info.channel = slot->channel;
+    info.rssi = slot->rssi;
+    info.noise_floor = slot->noise_floor;
+    info.rate = slot->rate;
 
-    pcap_file.write(header, sizeof(header));
-    pcap_file.write(data, len);
-    pcap_size += sizeof(header) + len;
+    pcap_writer.write_packet(info, slot->data, slot->len);
 
-    if (pcap_size > MAX_PCAP_SIZE) {
+    if (pcap_writer.size() > MAX_PCAP_SIZE) {
         capture_rotate_files();
     }
 }
@@ -141,14 +251,21 @@ void capture_write_pcap(const uint8_t* data, uint32_t len, uint32_t channel) {
 // Deduplicação
 // -----------------------------------------------------------------------------
 
-static String make_handshake_key(const uint8_t* ap, const uint8_t* sta) {
-    return mac_to_string_nosep(ap) + String("_") + mac_to_string_nosep(sta);
+static void make_handshake_key(const uint8_t* ap, const uint8_t* sta, uint8_t key[12]) {
+    memcpy(key, ap, 6);
+    memcpy(key + 6, sta, 6);
+}
+
+static void make_pmkid_key(const uint8_t* ap, const uint8_t* pmkid, uint8_t key[PMKID_KEY_LEN]) {
+    memcpy(key, ap, 6);
+    memcpy(key + 6, pmkid, 16);
 }
 
 bool capture_is_duplicate(const uint8_t* ap, const uint8_t* sta) {
     if (!ap || !sta) return false;
-    String key = make_handshake_key(ap, sta);
-    return seen_handshakes.find(key) != seen_handshakes.end();
+    uint8_t key[12];
+    make_handshake_key(ap, sta, key);
+    return seen_handshakes.contains(key);
 }
 
 // -----------------------------------------------------------------------------
@@ -157,439 +274,347 @@ bool capture_is_duplicate(const uint8_t* ap, const uint8_t* sta) {
 
 bool capture_save_pmkid(const PMKID* pmkid) {
     if (!pmkid) return false;
-    if (!pcap_file) {
-        // Não exige PCAP aberto, mas assume SD OK
+
+    // Atualiza mapa BSSID -> SSID (rede oculta não serve como ESSID)
+    SsidEntry* entry = !pmkid->hidden ? bssid_to_ssid.insert(pmkid->ap) : nullptr;
+    if (entry) {
+        ssid_entry_set(entry, pmkid->ssid, pmkid->ssid_len);
     }
 
-    String ap_hex = mac_to_string_nosep(pmkid->ap);
-    String sta_hex = mac_to_string_nosep(pmkid->sta);
-    String pmkid_hex = bytes_to_hex(pmkid->pmkid, sizeof(pmkid->pmkid));
-    String ssid_str = String(pmkid->ssid);
-
-    // Formato hashcat -m 16800: WPA*01*PMKID*MAC_AP*MAC_STA*SSID_HEX
-    String ssid_hex = bytes_to_hex((const uint8_t*)pmkid->ssid, strlen(pmkid->ssid));
-    String hash_line = "WPA*01*";
-    hash_line += pmkid_hex;
-    hash_line += "*";
-    hash_line += ap_hex;
-    hash_line += "*";
-    hash_line += sta_hex;
-    hash_line += "*";
-    hash_line += ssid_hex;
-
-    String file_path = "/sd/wavepwn/pmkid/";
-    file_path += pmkid_hex;
-    file_path += "_";
-    file_path += ap_hex;
-    file_path += "_";
-    file_path += sta_hex;
-    file_path += ".16800";
-
-    File f = SD.open(file_path, FILE_WRITE);
-    if (!f) {
-        Serial.printf("[CAPTURE] Falha ao abrir arquivo PMKID: %s\n", file_path.c_str());
+    // Linha 16800 e JSONL são gerados depois pelo export do log de sessão
+    if (!session_log.append_pmkid(*pmkid)) {
+        Serial.println("[CAPTURE] Falha ao registrar PMKID no log de sessao");
         return false;
     }
-    f.println(hash_line);
-    f.close();
-
-    // Atualiza mapa BSSID -> SSID
-    bssid_to_ssid[ap_hex] = ssid_str;
-
-    // Log JSON simples
-    File log = SD.open("/sd/wavepwn/logs/pmkid.jsonl", FILE_APPEND);
-    if (log) {
-        log.printf(
-            "{\"type\":\"pmkid\",\"ap\":\"%s\",\"sta\":\"%s\",\"ssid\":\"%s\","
-            "\"file\":\"%s\",\"timestamp\":%llu}\n",
-            ap_hex.c_str(),
-            sta_hex.c_str(),
-            ssid_str.c_str(),
-            file_path.c_str(),
-            (unsigned long long)pmkid->timestamp);
-        log.close();
-    }
 
     Serial.printf("[CAPTURE] PMKID salvo (%s -> %s) SSID=\"%s\"\n",
-                  ap_hex.c_str(),
-                  sta_hex.c_str(),
-                  ssid_str.c_str());
+                  mac_to_string_nosep(pmkid->ap).c_str(),
+                  mac_to_string_nosep(pmkid->sta).c_str(),
+                  pmkid->ssid_len ? pmkid->ssid : "<hidden>");
     return true;
 }
 
-bool capture_save_handshake(const Handshake* hs) {
-    if (!hs) return false;
-
-    String ap_hex = mac_to_string_nosep(hs->ap);
-    String sta_hex = mac_to_string_nosep(hs->sta);
+bool capture_save_handshake(const Handshake* hs, const char* ssid, size_t ssid_len) {
+    if (!hs || !ssid || ssid_len == 0) return false;
 
-    char ts_buf[32];
-    snprintf(ts_buf, sizeof(ts_buf), "%llu",
-             (unsigned long long)hs->timestamp);
-
-    // Salvamos a estrutura binária para futura conversão (22000/2500) em PC.
-    String file_path = "/sd/wavepwn/session/hs_";
-    file_path += ap_hex;
-    file_path += "_";
-    file_path += sta_hex;
-    file_path += "_";
-    file_path += ts_buf;
-    file_path += ".bin";
-
-    File f = SD.open(file_path, FILE_WRITE);
-    if (!f) {
-        Serial.printf("[CAPTURE] Falha ao abrir arquivo Handshake: %s\n", file_path.c_str());
+    // Linha 22000 (WPA*02*) e JSONL são gerados depois pelo export
+    if (!session_log.append_handshake(*hs, ssid, ssid_len)) {
+        Serial.println("[CAPTURE] Falha ao registrar handshake no log de sessao");
         return false;
     }
-    f.write((const uint8_t*)hs, sizeof(Handshake));
-    f.close();
-
-    // Log JSONL com metadados
-    File log = SD.open("/sd/wavepwn/logs/handshakes.jsonl", FILE_APPEND);
-    if (log) {
-        String ssid = "";
-        auto it = bssid_to_ssid.find(ap_hex);
-        if (it != bssid_to_ssid.end()) {
-            ssid = it->second;
-        }
-        log.printf(
-            "{\"type\":\"handshake\",\"ap\":\"%s\",\"sta\":\"%s\",\"ssid\":\"%s\","
-            "\"file\":\"%s\",\"keyver\":%u,\"msg\":%u,\"timestamp\":%llu}\n",
-            ap_hex.c_str(),
-            sta_hex.c_str(),
-            ssid.c_str(),
-            file_path.c_str(),
-            hs->key_version,
-            hs->message_num,
-            (unsigned long long)hs->timestamp);
-        log.close();
-    }
 
-    Serial.printf("[CAPTURE] Handshake salvo (%s <-> %s)\n",
-                  ap_hex.c_str(),
-                  sta_hex.c_str());
+    Serial.printf("[CAPTURE] Handshake salvo (%s <-> %s) par=0x%02x%s\n",
+                  mac_to_string_nosep(hs->ap).c_str(),
+                  mac_to_string_nosep(hs->sta).c_str(),
+                  hs->message_pair,
+                  hs->authorized ? " autorizado" : "");
     return true;
 }
 
-// -----------------------------------------------------------------------------
-// Parsing de frames
-// -----------------------------------------------------------------------------
-
-static bool locate_eapol(const uint8_t* frame,
-                         uint16_t len,
-                         uint16_t& eapol_offset,
-                         uint16_t& eapol_len) {
-    if (len < 40) return false;
-
-    uint8_t fc = frame[0];
-    uint8_t type = (fc >> 2) & 0x3; // bits Type
-    if (type != 2) {
-        // Apenas Data frames carregam EAPOL
-        return false;
-    }
-
-    uint16_t hdr_len = 24; // 3 endereços
-    uint8_t flags = frame[1];
-    bool to_ds = flags & 0x01;
-    bool from_ds = flags & 0x02;
-
-    if (to_ds && from_ds) {
-        // 4-addr frame
-        hdr_len += 6;
-    }
-
-    // QOS? (subtype bit 7 ligado em QoS Data)
-    bool qos = (fc & 0x80) != 0;
-    if (qos) {
-        hdr_len += 2;
+// Reconstrói seen_handshakes, seen_pmkids e o mapa BSSID -> SSID a partir dos logs de
+// sessões anteriores: uma leitura sequencial por arquivo, sem parsing de texto.
+static void capture_resume_sessions() {
+    File root = SDCARD.open(SESSION_LOG_DIR);
+    if (!root || !root.isDirectory()) return;
+
+    static uint8_t payload[SESSION_LOG_MAX_PAYLOAD];
+    uint32_t files = 0, records = 0, torn = 0;
+    unsigned long t0 = millis();
+
+    File f = root.openNextFile();
+    while (f) {
+        char path[64];
+        uint32_t fid = SessionLog::parse_file_id(f.name());
+        f.close();
+
+        if (fid != 0) {
+            snprintf(path, sizeof(path), "%s/session_%05lu.bin",
+                     SESSION_LOG_DIR, (unsigned long)fid);
+            SessionLogReader reader;
+            if (reader.open(path)) {
+                files++;
+                SessionRecordHeader hdr;
+                while (reader.next(&hdr, payload)) {
+                    records++;
+                    if (hdr.type == SESSION_REC_HANDSHAKE &&
+                        hdr.len >= sizeof(SessionHandshakeRecord)) {
+                        const SessionHandshakeRecord* r = (const SessionHandshakeRecord*)payload;
+                        if (r->authorized) {
+                            uint8_t key[12];
+                            make_handshake_key(r->ap, r->sta, key);
+                            seen_handshakes.insert(key);
+                        }
+                    } else if (hdr.type == SESSION_REC_PMKID &&
+                               hdr.len >= sizeof(SessionPmkidRecord)) {
+                        const SessionPmkidRecord* r = (const SessionPmkidRecord*)payload;
+                        uint8_t key[PMKID_KEY_LEN];
+                        make_pmkid_key(r->ap, r->pmkid, key);
+                        seen_pmkids.insert(key);
+                    } else if (hdr.type == SESSION_REC_AP &&
+                               hdr.len >= sizeof(SessionApRecord)) {
+                        const SessionApRecord* r = (const SessionApRecord*)payload;
+                        SsidEntry* entry = bssid_to_ssid.insert(r->bssid);
+                        if (entry) {
+                            ssid_entry_set(entry, r->ssid, r->ssid_len);
+                        }
+                    }
+                }
+                if (reader.truncated()) torn++;
+                reader.close();
+            }
+        }
+        f = root.openNextFile();
     }
-
-    if (len < hdr_len + 8) return false;
-
-    const uint8_t* llc = frame + hdr_len;
-    // LLC: AA AA 03 00 00 00 88 8E
-    if (llc[0] != 0xAA || llc[1] != 0xAA) return false;
-    if (llc[6] != 0x88 || llc[7] != 0x8E) return false;
-
-    eapol_offset = hdr_len + 8;
-    if (len <= eapol_offset) return false;
-    eapol_len = len - eapol_offset;
-    return true;
+    root.close();
+
+    Serial.printf("[CAPTURE] Sessoes retomadas: %lu arquivos, %lu registros, "
+                  "%lu handshakes completos, %lu PMKIDs (%lu ms)%s\n",
+                  (unsigned long)files,
+                  (unsigned long)records,
+                  (unsigned long)seen_handshakes.size(),
+                  (unsigned long)seen_pmkids.size(),
+                  (unsigned long)(millis() - t0),
+                  torn ? ", cauda truncada ignorada" : "");
 }
 
-static bool is_eapol_frame(const uint8_t* frame, uint16_t len) {
-    uint16_t off = 0, l = 0;
-    return locate_eapol(frame, len, off, l);
-}
-
-// Parser de PMKID a partir de IEs RSN (Beacon / Probe Response)
-static void parse_pmkid(const uint8_t* frame, uint16_t len, uint8_t channel) {
-    (void)channel;
+// Grava o par se o SSID do AP já for conhecido; senão ele fica pendente no
+// tracker até o próximo beacon/probe response desse BSSID.
+static void capture_store_handshake(const Handshake& hs) {
+    const SsidEntry* entry = bssid_to_ssid.find(hs.ap);
+    if (!entry || entry->ssid_len == 0) return;
 
-    if (len < 36) return;
+    if (!capture_save_handshake(&hs, entry->ssid, entry->ssid_len)) return;
 
-    uint8_t fc = frame[0];
-    uint8_t type = (fc >> 2) & 0x3;
-    uint8_t subtype = (fc >> 4) & 0xF;
-
-    if (type != 0) return; // só management
-    if (!(subtype == 8 || subtype == 5)) {
-        // Beacon (1000) ou Probe Response (0101)
-        return;
+    uint8_t result = handshake_tracker.mark_written(hs);
+    if (result & HS_WRITTEN_COMPLETE) {
+        uint8_t key[12];
+        make_handshake_key(hs.ap, hs.sta, key);
+        seen_handshakes.insert(key);
     }
 
-    const uint8_t* addr1 = frame + 4;
-    const uint8_t* addr2 = frame + 10;
-    const uint8_t* addr3 = frame + 16;
-
-    const uint8_t* body = frame + 24;
-    uint16_t body_len = len - 24;
-
-    if (body_len < 12) return;
-    const uint8_t* ie = body + 12;
-    uint16_t ie_len = body_len - 12;
-
-    const uint8_t* rsn = nullptr;
-    uint8_t rsn_len = 0;
-    const uint8_t* ssid = nullptr;
-    uint8_t ssid_len = 0;
-
-    // Navega pelos IEs
-    while (ie_len >= 2) {
-        uint8_t id = ie[0];
-        uint8_t elen = ie[1];
-        if (elen + 2 > ie_len) break;
-
-        if (id == 0) { // SSID
-            ssid = ie + 2;
-            ssid_len = elen > 32 ? 32 : elen;
-        } else if (id == 48) { // RSN
-            rsn = ie + 2;
-            rsn_len = elen;
-        }
+    ap_table.mark_capture(hs.ap, hs.authorized ? AP_CAPTURE_HANDSHAKE
+                                               : AP_CAPTURE_HANDSHAKE_PARTIAL);
 
-        ie += 2 + elen;
-        ie_len -= 2 + elen;
+    // Conta cada AP/STA uma vez: no primeiro par gravado.
+    if (result & HS_WRITTEN_FIRST) {
+        pwn.handshakes++;
+        pending_ui_handshakes.fetch_add(1, std::memory_order_relaxed);
     }
+}
 
-    if (!rsn || rsn_len < 20) return;
-
-    const uint8_t* ptr = rsn;
-    uint16_t rem = rsn_len;
-
-    if (rem < 2) return;
-    uint16_t version = ptr[0] | (ptr[1] << 8);
-    (void)version;
-    ptr += 2;
-    rem -= 2;
-
-    if (rem < 4) return; // group cipher
-    ptr += 4;
-    rem -= 4;
-
-    if (rem < 2) return;
-    uint16_t pairwise_count = ptr[0] | (ptr[1] << 8);
-    ptr += 2;
-    rem -= 2;
-
-    if (rem < 4 * pairwise_count) return;
-    ptr += 4 * pairwise_count;
-    rem -= 4 * pairwise_count;
-
-    if (rem < 2) return;
-    uint16_t akm_count = ptr[0] | (ptr[1] << 8);
-    ptr += 2;
-    rem -= 2;
-
-    if (rem < 4 * akm_count) return;
-    ptr += 4 * akm_count;
-    rem -= 4 * akm_count;
+// -----------------------------------------------------------------------------
+// Parsing de frames
+// -----------------------------------------------------------------------------
 
-    // RSN Capabilities (opcional, mas geralmente presente)
-    if (rem < 2) return;
-    ptr += 2;
-    rem -= 2;
+// PMKID anunciado no RSN IE de beacons / probe responses
+static void parse_pmkid(const dot11::Dot11View& view) {
+    if (view.rsn.empty() || !view.bssid) return;
 
-    if (rem < 2) return;
-    uint16_t pmkid_count = ptr[0] | (ptr[1] << 8);
-    ptr += 2;
-    rem -= 2;
+    const uint8_t* pmkid = dot11::rsn_pmkid(view.rsn);
+    if (!pmkid) return;
 
-    if (pmkid_count == 0 || rem < 16) return;
+    // Mesmo BSSID + PMKID já registrado: nada a fazer (antes de montar o
+    // registro, que é o caminho de todo beacon desse AP)
+    uint8_t key[PMKID_KEY_LEN];
+    make_pmkid_key(view.bssid, pmkid, key);
+    if (seen_pmkids.contains(key)) return;
 
     PMKID pm = {};
-    memcpy(pm.pmkid, ptr, 16);
+    memcpy(pm.pmkid, pmkid, 16);
     pm.timestamp = millis();
-
-    // BSSID é addr3
-    memcpy(pm.ap, addr3, 6);
+    memcpy(pm.ap, view.bssid, 6);
     // Para Beacons/Probe Resp não há STA específica, usamos broadcast
     memset(pm.sta, 0xFF, 6);
 
-    if (ssid && ssid_len > 0) {
-        memcpy(pm.ssid, ssid, ssid_len);
-        pm.ssid[ssid_len] = '\0';
+    // Rede oculta: ESSID do mapa se um probe response já o revelou, senão
+    // fica vazio (o 16800 sai sem ESSID em vez de "<hidden>")
+    pm.hidden = ssid_is_hidden(view.ssid.data, view.ssid.len);
+    if (!pm.hidden) {
+        pm.ssid_len = (uint8_t)view.ssid.len;
+        memcpy(pm.ssid, view.ssid.data, pm.ssid_len);
     } else {
-        strncpy(pm.ssid, "<hidden>", sizeof(pm.ssid));
-        pm.ssid[sizeof(pm.ssid) - 1] = '\0';
+        const SsidEntry* known = bssid_to_ssid.find(view.bssid);
+        if (known) {
+            pm.ssid_len = known->ssid_len;
+            memcpy(pm.ssid, known->ssid, known->ssid_len);
+        }
     }
+    pm.ssid[pm.ssid_len] = '\0';
 
     if (capture_save_pmkid(&pm)) {
+        seen_pmkids.insert(key);
+        ap_table.mark_capture(pm.ap, AP_CAPTURE_PMKID);
         pwn.pmkids++;
-        ui_set_mood(MOOD_PMKID);
-        ui_celebrate_pmkid();
+        pending_ui_pmkids.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
-// Parser simplificado do 4-way handshake WPA2
-static void parse_handshake(const uint8_t* frame, uint16_t len, uint8_t channel) {
-    (void)channel;
-
-    uint16_t eapol_offset = 0;
-    uint16_t eapol_len = 0;
+// Decodifica uma mensagem EAPOL-Key (M1..M4) e entrega ao HandshakeTracker.
+// `rx_ms` é o instante do RX (não o do processamento): com o ring cheio, as
+// mensagens de um handshake podem ser drenadas juntas bem depois.
+static void parse_handshake(const dot11::Dot11View& view, uint8_t channel, uint32_t rx_ms) {
+    dot11::EapolKey key;
+    if (!dot11::parse_eapol_key(view.eapol, &key) || key.message == 0) return;
+    if (!view.addr1 || !view.addr2 || !view.bssid) return;
+
+    wifi_sniffer_count(channel, SNIFF_EAPOL);
+
+    // AP = BSSID; STA = o outro endereço do par
+    const uint8_t* ap_mac = view.bssid;
+    const uint8_t* sta_mac = view.addr2;
+    if (memcmp(view.addr1, view.bssid, 6) == 0) {
+        sta_mac = view.addr2;
+    } else if (memcmp(view.addr2, view.bssid, 6) == 0) {
+        sta_mac = view.addr1;
+    }
 
-    if (!locate_eapol(frame, len, eapol_offset, eapol_len)) {
+    // Deduplicação: um handshake por par AP/STA
+    if (capture_is_duplicate(ap_mac, sta_mac)) {
         return;
     }
 
-    if (eapol_len < 4 + 95) {
-        // Cabeçalho EAPOL (4) + estrutura mínima de EAPOL-Key
-        return;
+    // M1 de um par ainda sem handshake: segura o canal para M2..M4
+    if (key.message == 1) {
+        wifi_sniffer_count(channel, SNIFF_EAPOL_M1);
+    }
+
+    EapolKeyMessage msg = {};
+    msg.ap = ap_mac;
+    msg.sta = sta_mac;
+    msg.message = key.message;
+    msg.key_version = key.key_info & 0x7;
+    msg.replay_counter = key.replay_counter;
+    msg.nonce = key.nonce;
+    msg.mic = key.mic;
+    msg.eapol = key.frame.data;
+    msg.eapol_len = key.frame.len;
+    msg.mic_offset = key.mic_offset;
+    msg.timestamp_ms = rx_ms;
+
+    Handshake hs;
+    if (handshake_tracker.on_message(msg, &hs)) {
+        capture_store_handshake(hs);
+    }
+}
+
+// SSID oculto: vazio ou só zeros
+static bool ssid_is_hidden(const uint8_t* ssid, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (ssid[i]) return false;
     }
+    return true;
+}
 
-    const uint8_t* eapol = frame + eapol_offset;
+// Tamanho explícito: um SSID com NUL no meio não vira outro a cada beacon
+static void ssid_entry_set(SsidEntry* entry, const void* ssid, size_t len) {
+    if (len > sizeof(entry->ssid) - 1) len = sizeof(entry->ssid) - 1;
+    memcpy(entry->ssid, ssid, len);
+    entry->ssid[len] = '\0';
+    entry->ssid_len = (uint8_t)len;
+}
+
+// Aprende BSSID -> SSID de beacons / probe responses. Quando o SSID de um AP
+// aparece pela primeira vez, grava os pares que estavam esperando por ele.
+static void learn_ssid(const dot11::Dot11View& view, uint8_t channel) {
+    if (!view.has_ssid || !view.bssid) return;
 
-    uint8_t eapol_version = eapol[0];
-    uint8_t eapol_type = eapol[1];
-    uint16_t eapol_body_len = (eapol[2] << 8) | eapol[3];
+    const uint8_t* ssid = view.ssid.data;
+    uint8_t ssid_len = (uint8_t)view.ssid.len;
+    if (ssid_is_hidden(ssid, ssid_len)) return;
 
-    (void)eapol_version;
-    if (eapol_type != 3) {
-        // Só EAPOL-Key nos interessa
+    SsidEntry* entry = bssid_to_ssid.insert(view.bssid);
+    if (!entry) return;
+    if (entry->ssid_len == ssid_len && memcmp(entry->ssid, ssid, ssid_len) == 0) {
         return;
     }
+    ssid_entry_set(entry, ssid, ssid_len);
+    session_log.append_ap(view.bssid, entry->ssid, entry->ssid_len,
+                          view.channel ? view.channel : channel);
 
-    if (eapol_body_len + 4 > eapol_len) {
-        eapol_body_len = eapol_len - 4;
-    }
+    handshake_tracker.for_each_pending(view.bssid, [](const Handshake& hs) {
+        capture_store_handshake(hs);
+    });
+}
 
-    const uint8_t* key_frame = eapol + 4;
-    if (eapol_body_len < 95) return;
-
-    uint8_t descriptor_type = key_frame[0];
-    (void)descriptor_type;
-
-    uint16_t key_info = (key_frame[1] << 8) | key_frame[2];
-    uint16_t key_len = (key_frame[3] << 8) | key_frame[4];
-    (void)key_len;
-
-    const uint8_t* replay_counter = key_frame + 5;
-    const uint8_t* key_nonce = key_frame + 13;
-    const uint8_t* key_mic = key_frame + 77;
-    uint16_t key_data_len = (key_frame[93] << 8) | key_frame[94];
-    (void)replay_counter;
-    (void)key_data_len;
-
-    // Bits de controle
-    const uint16_t WPA_KEY_INFO_INSTALL = 0x0040;
-    const uint16_t WPA_KEY_INFO_ACK     = 0x0080;
-    const uint16_t WPA_KEY_INFO_MIC     = 0x0100;
-    const uint16_t WPA_KEY_INFO_SECURE  = 0x0200;
-    const uint16_t WPA_KEY_INFO_REQUEST = 0x0800;
-
-    bool mic_set   = (key_info & WPA_KEY_INFO_MIC) != 0;
-    bool ack_set   = (key_info & WPA_KEY_INFO_ACK) != 0;
-    bool install   = (key_info & WPA_KEY_INFO_INSTALL) != 0;
-    bool secure    = (key_info & WPA_KEY_INFO_SECURE) != 0;
-    bool request   = (key_info & WPA_KEY_INFO_REQUEST) != 0;
-
-    uint8_t message_num = 0;
-    if (!mic_set && ack_set && !install && !secure) {
-        message_num = 1;
-    } else if (mic_set && !ack_set && !install && !secure && !request) {
-        message_num = 2;
-    } else if (mic_set && ack_set && install && secure) {
-        message_num = 3;
-    } else if (mic_set && !ack_set && !install && secure) {
-        message_num = 4;
-    }
+// -----------------------------------------------------------------------------
+// Task de captura (consumidor do ring)
+// -----------------------------------------------------------------------------
 
-    // Extrair MACs do header 802.11
-    const uint8_t* addr1 = frame + 4;
-    const uint8_t* addr2 = frame + 10;
-    const uint8_t* addr3 = frame + 16;
-
-    uint8_t flags = frame[1];
-    bool to_ds = flags & 0x01;
-    bool from_ds = flags & 0x02;
-
-    const uint8_t* bssid = nullptr;
-    if (!to_ds && !from_ds) {
-        bssid = addr3;
-    } else if (!to_ds && from_ds) {
-        bssid = addr2;
-    } else if (to_ds && !from_ds) {
-        bssid = addr1;
-    } else {
-        // WDS, escolhemos addr1 por convenção
-        bssid = addr1;
+// Estruturas grandes e de vida longa vão para a PSRAM quando disponível.
+static void* capture_alloc(size_t bytes) {
+    void* p = heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) {
+        p = heap_caps_calloc(1, bytes, MALLOC_CAP_8BIT);
     }
+    if (!p) {
+        Serial.printf("[CAPTURE] ERRO ao alocar %u bytes\n", (unsigned)bytes);
+    }
+    return p;
+}
 
-    const uint8_t* ap_mac = nullptr;
-    const uint8_t* sta_mac = nullptr;
+static void capture_process_frame(const CaptureSlot* slot) {
+    // Escreve TODOS os pacotes no PCAP/pcapng (com metadados de rádio)
+    capture_write_slot(slot);
 
-    if (memcmp(addr1, bssid, 6) == 0) {
-        ap_mac = addr1;
-        sta_mac = addr2;
-    } else if (memcmp(addr2, bssid, 6) == 0) {
-        ap_mac = addr2;
-        sta_mac = addr1;
-    } else {
-        ap_mac = bssid;
-        sta_mac = addr2;
-    }
+    // Uma única passada pelo frame; o FCS só existe se o frame não foi cortado
+    dot11::Dot11View view;
+    uint16_t fcs = (slot->len == slot->orig_len) ? CAPTURE_FCS_LEN : 0;
+    if (!view.parse(slot->data, slot->len, fcs)) return;
+    uint32_t now = millis();
 
-    if (!ap_mac || !sta_mac) return;
+    // Janelas de 1/10/60 s da NEURA9
+    neura9_features.on_frame(view, slot->rssi, slot->channel, now);
 
-    // Deduplicação: um handshake por par AP/STA
-    if (capture_is_duplicate(ap_mac, sta_mac)) {
-        return;
+    // Handshake WPA/WPA2 (EAPOL dentro de Data frame)
+    if (view.is_data()) {
+        wifi_sniffer_count(slot->channel, SNIFF_DATA);
+        ap_table.on_data(view, slot->rssi, slot->channel, now);
+        if (view.has_eapol()) {
+            parse_handshake(view, slot->channel, (uint32_t)(slot->timestamp_us / 1000ULL));
+        }
     }
 
-    Handshake hs = {};
-    memcpy(hs.ap, ap_mac, 6);
-    memcpy(hs.sta, sta_mac, 6);
+    // SSID e PMKID a partir de beacons / probe responses
+    if (view.is_beacon() || view.is_probe_resp()) {
+        if (view.is_beacon()) {
+            wifi_sniffer_count(slot->channel, SNIFF_BEACON);
+        }
+        if (ap_table.on_beacon(view, slot->rssi, slot->channel, now)) {
+            wifi_sniffer_count(slot->channel, SNIFF_NEW_BSSID);
+        }
+        learn_ssid(view, slot->channel);
+        parse_pmkid(view);
+    }
+}
 
-    bool from_ap = (memcmp(addr2, ap_mac, 6) == 0);
-    if (from_ap) {
-        memcpy(hs.anonce, key_nonce, 32);
-    } else {
-        memcpy(hs.snonce, key_nonce, 32);
+void capture_poll() {
+    const CaptureSlot* slot;
+    while ((slot = capture_ring.peek()) != nullptr) {
+        capture_process_frame(slot);
+        capture_ring.release();
+        frames_processed++;
     }
 
-    memcpy(hs.mic, key_mic, 16);
+    // fsync por tempo: limita o que se perde numa queda de energia
+    pcap_writer.poll();
+    session_log.poll();
 
-    uint16_t copy_len = eapol_len;
-    if (copy_len > sizeof(hs.eapol)) copy_len = sizeof(hs.eapol);
-    memcpy(hs.eapol, eapol, copy_len);
-    hs.eapol_size = copy_len;
+    pwn.frames_captured = capture_ring.total_pushed();
+    pwn.frames_dropped = capture_ring.total_dropped();
+}
 
-    // Zera o MIC no buffer EAPOL para facilitar conversões futuras (-m 22000)
-    size_t mic_offset = (size_t)(key_mic - eapol);
-    if (mic_offset + 16 <= hs.eapol_size) {
-        memset(hs.eapol + mic_offset, 0, 16);
-    }
+void capture_flush() {
+    pcap_writer.sync();
+    session_log.sync();
+}
 
-    hs.key_version = key_info & 0x7;
-    hs.message_num = message_num;
-    hs.timestamp = millis();
+static void capture_task(void* arg) {
+    (void)arg;
 
-    String key = make_handshake_key(hs.ap, hs.sta);
-    if (capture_save_handshake(&hs)) {
-        seen_handshakes.insert(key);
-        pwn.handshakes++;
-        ui_set_mood(MOOD_HANDSHAKE);
-        ui_celebrate_handshake();
+    for (;;) {
+        // Acorda a cada frame publicado ou, no máximo, a cada 100 ms.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        capture_poll();
     }
 }
 
@@ -599,28 +624,28 @@ static void parse_handshake(const uint8_t* frame, uint16_t len, uint8_t channel)
 
 void IRAM_ATTR capture_packet_handler(uint8_t* buf, uint16_t len, uint8_t channel) {
     (void)len;
+    (void)channel; // usamos o do rx_ctrl para garantir consistência
 
     wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
-    const uint8_t* frame = pkt->payload;
     uint16_t frame_len = pkt->rx_ctrl.sig_len;
-    uint8_t ch = pkt->rx_ctrl.channel;
-    (void)channel; // usamos o do rx_ctrl para garantir consistência
 
-    // Escreve TODOS os pacotes no PCAP
-    capture_write_pcap(frame, frame_len, ch);
+    // Só copia para o slot; nada de SD, String ou LVGL no contexto do driver.
+    CaptureSlot* slot = capture_ring.acquire();
+    if (!slot) return;
 
-    uint8_t fc = frame[0];
+    slot->timestamp_us = (uint64_t)esp_timer_get_time();
+    slot->orig_len = frame_len;
+    slot->len = frame_len > CAPTURE_MAX_FRAME_LEN ? CAPTURE_MAX_FRAME_LEN : frame_len;
+    slot->channel = pkt->rx_ctrl.channel;
+    slot->rssi = pkt->rx_ctrl.rssi;
+    slot->noise_floor = pkt->rx_ctrl.noise_floor;
+    slot->rate = pkt->rx_ctrl.rate;
+    memcpy(slot->data, pkt->payload, slot->len);
 
-    // Handshake WPA/WPA2 (EAPOL dentro de Data frame)
-    if (is_eapol_frame(frame, frame_len)) {
-        parse_handshake(frame, frame_len, ch);
-    }
+    capture_ring.publish();
 
-    // PMKID a partir de beacons / probe responses
-    uint8_t type = (fc >> 2) & 0x3;
-    uint8_t subtype = (fc >> 4) & 0xF;
-    if (type == 0 && (subtype == 8 || subtype == 5)) {
-        parse_pmkid(frame, frame_len, ch);
+    if (capture_task_handle) {
+        xTaskNotifyGive(capture_task_handle);
     }
 }
 
@@ -628,15 +653,6 @@ void IRAM_ATTR capture_packet_handler(uint8_t* buf, uint16_t len, uint8_t channe
 // Helpers de formatação
 // -----------------------------------------------------------------------------
 
-static String mac_to_string(const uint8_t* mac) {
-    char buf[18];
-    snprintf(buf,
-             sizeof(buf),
-             "%02X:%02X:%02X:%02X:%02X:%02X",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    return String(buf);
-}
-
 static String mac_to_string_nosep(const uint8_t* mac) {
     char buf[13];
     snprintf(buf,
@@ -644,16 +660,4 @@ static String mac_to_string_nosep(const uint8_t* mac) {
              "%02X%02X%02X%02X%02X%02X",
              mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
     return String(buf);
-}
-
-static String bytes_to_hex(const uint8_t* data, size_t len) {
-    static const char* hex = "0123456789abcdef";
-    String out;
-    out.reserve(len * 2);
-    for (size_t i = 0; i < len; ++i) {
-        uint8_t b = data[i];
-        out += hex[b >> 4];
-        out += hex[b & 0x0F];
-    }
-    return out;
 }
\ No newline at end of file
@@ -2,47 +2,97 @@
 
 #include <Arduino.h>
 #include <cstdint>
-#include <SD.h>
+#include <FS.h>
 
+// Par de mensagens EAPOL já correlacionado e pronto para hashcat -m 22000
+// (WPA*02*MIC*MAC_AP*MAC_STA*ESSID*ANONCE*EAPOL*MESSAGEPAIR).
 struct Handshake {
     uint8_t ap[6];
     uint8_t sta[6];
-    uint8_t snonce[32];
-    uint8_t anonce[32];
-    uint8_t mic[16];
-    uint8_t eapol[256];
+    uint8_t anonce[32];      // de M1 ou M3
+    uint8_t mic[16];         // MIC da mensagem cujo EAPOL vai na linha
+    uint8_t eapol[256];      // EAPOL (M2 ou M4) com o MIC zerado
     uint16_t eapol_size;
     uint8_t key_version;
-    uint8_t message_num;
-    uint64_t timestamp; // milliseconds since boot
+    uint8_t message_pair;    // código hcxtools (0 = M1+M2, 2 = M2+M3, ...)
+    bool authorized;         // par prova que o cliente conhecia a PSK
+    uint64_t timestamp;      // milliseconds since boot
 };
 
 struct PMKID {
     uint8_t pmkid[16];
     uint8_t ap[6];
     uint8_t sta[6];
-    char ssid[33];
+    char ssid[33];      // terminado em NUL só para log; vale ssid_len
+    uint8_t ssid_len;   // pode conter NULs no meio
+    bool hidden;        // beacon com SSID vazio/zerado (ssid = o aprendido, se houver)
     uint64_t timestamp; // milliseconds since boot
 };
 
-// Inicialização do subsistema de captura (abre primeiro PCAP, zera deduplicação)
+// Formato dos arquivos de captura gerados por capture_rotate_files().
+enum CaptureFormat : uint8_t {
+    CAPTURE_FORMAT_PCAP   = 0,  // legado: .pcap, LINKTYPE 105, timestamp em µs (esp_timer)
+    CAPTURE_FORMAT_PCAPNG = 1,  // .pcapng, radiotap (canal/RSSI/ruído/taxa), µs, IDB por canal
+};
+
+#ifndef CAPTURE_DEFAULT_FORMAT
+#define CAPTURE_DEFAULT_FORMAT CAPTURE_FORMAT_PCAP
+#endif
+
+// Contadores do pipeline callback -> ring -> task de captura.
+struct CaptureStats {
+    uint32_t frames_received;   // frames copiados para o ring pelo callback
+    uint32_t frames_processed;  // frames drenados pela task de captura
+    uint32_t frames_dropped;    // frames perdidos por ring cheio
+    uint32_t ring_depth;        // slots ocupados agora
+    uint32_t ring_max_depth;    // maior ocupação observada
+    uint32_t ring_capacity;     // total de slots
+    uint64_t pcap_bytes;        // bytes do PCAP já gravados no SD
+    uint32_t pcap_sd_writes;    // writes em bloco feitos no SD
+    uint32_t pcap_stalls;       // esperas por buffer livre do escritor PCAP
+    uint32_t eapol_oversize;    // M2/M4 descartadas por EAPOL maior que o buffer
+};
+
+// Inicialização do subsistema de captura (abre primeiro PCAP, zera deduplicação,
+// aloca o ring de frames e cria a task de captura)
 void capture_init();
 
-// Handler chamado pelo callback promíscuo do Wi-Fi
+// Handler chamado pelo callback promíscuo do Wi-Fi. Apenas copia o frame para
+// o ring; todo o processamento acontece na task de captura.
 void capture_packet_handler(uint8_t* buf, uint16_t len, uint8_t channel);
 
-// Escrita raw de um frame 802.11 em PCAP (com cabeçalho por pacote)
-void capture_write_pcap(const uint8_t* data, uint32_t len, uint32_t channel);
+// Drena o ring (parsing, PCAP, log de sessão) e aplica o fsync por tempo.
+// Chamada em loop pela task de captura; o replay no host (tools/replay)
+// chama direto, sem RTOS.
+void capture_poll();
+
+// Grava no SD tudo o que o PCAP e o log de sessão ainda têm em RAM. Chamar
+// do mesmo contexto que capture_poll() (ou com a task de captura ociosa).
+void capture_flush();
+
+// Snapshot dos contadores do pipeline de captura.
+void capture_get_stats(CaptureStats* out);
 
-// Persistência de estruturas já parseadas
-bool capture_save_handshake(const Handshake* hs);
+// Aplica na UI (mood/celebração) os eventos gerados pela task de captura.
+// Deve ser chamada a partir do loop do LVGL.
+void capture_dispatch_ui_events();
+
+// Persistência de estruturas já parseadas: viram registros no log binário da
+// sessão (/sd/wavepwn/session). As linhas 16800/22000 são geradas sob demanda
+// por tools/session_export.py.
+bool capture_save_handshake(const Handshake* hs, const char* ssid, size_t ssid_len);
 bool capture_save_pmkid(const PMKID* pmkid);
 
-// Deduplicação em RAM (AP+STA)
+// Deduplicação em RAM (AP+STA): verdadeiro só depois que um par autorizado
+// (M2+M3, M3+M4 ou M1+M4) do handshake foi gravado.
 bool capture_is_duplicate(const uint8_t* ap, const uint8_t* sta);
 
 // Rotação de arquivos PCAP quando ultrapassar o limite
 void capture_rotate_files();
 
+// Seleciona o formato usado a partir da próxima rotação.
+void capture_set_format(CaptureFormat format);
+CaptureFormat capture_get_format();
+
 // Caminho do PCAP atual em uso
 String capture_get_current_pcap();
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "capture/ap_table.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+ApTable ap_table;
+
+static const uint16_t CAP_PRIVACY = 0x0010;   // capability: WEP/WPA ativo
+static const uint8_t RSN_AKM_SAE = 8;
+static const uint8_t RSN_AKM_SAE_EXT = 24;
+
+static bool is_group_addr(const uint8_t* mac) {
+    return (mac[0] & 0x01) != 0;
+}
+
+uint8_t ap_classify_encryption(const dot11::Dot11View& view) {
+    if (!view.rsn.empty()) {
+        // versão(2) + group(4) + pairwise list + AKM list
+        dot11::Span rsn = view.rsn;
+        uint32_t off = 6;
+        if (!rsn.has(off, 2)) return AP_ENC_WPA2;
+        off += 2 + 4u * rsn.le16(off);
+        if (off > rsn.len || !rsn.has(off, 2)) return AP_ENC_WPA2;
+        uint16_t akm_count = rsn.le16(off);
+        off += 2;
+        for (uint16_t i = 0; i < akm_count && rsn.has(off + 4 * i, 4); ++i) {
+            uint8_t type = rsn.data[off + 4 * i + 3];
+            if (type == RSN_AKM_SAE || type == RSN_AKM_SAE_EXT) return AP_ENC_WPA3;
+        }
+        return AP_ENC_WPA2;
+    }
+    if (!view.wpa.empty()) return AP_ENC_WPA;
+    if (view.body.le16(10) & CAP_PRIVACY) return AP_ENC_WEP;
+    return AP_ENC_OPEN;
+}
+
+bool ApTable::begin(uint32_t ap_capacity, uint32_t sta_capacity) {
+    size_t ap_bytes = ApMap::storage_bytes(ap_capacity);
+    size_t sta_bytes = StaMap::storage_bytes(sta_capacity);
+
+    // Uma arena só para as duas tabelas
+    uint8_t* arena = (uint8_t*)heap_caps_calloc(1, ap_bytes + sta_bytes,
+                                                MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!arena) {
+        arena = (uint8_t*)heap_caps_calloc(1, ap_bytes + sta_bytes, MALLOC_CAP_8BIT);
+    }
+    if (!arena) {
+        Serial.println("[APTABLE] ERRO ao alocar arena");
+        return false;
+    }
+
+    mutex = xSemaphoreCreateMutex();
+    if (!aps.begin(arena, ap_capacity) || !stations.begin(arena + ap_bytes, sta_capacity)) {
+        Serial.println("[APTABLE] Capacidade invalida (precisa ser potencia de 2)");
+        return false;
+    }
+
+    Serial.printf("[APTABLE] %lu APs + %lu estacoes (%u KB)\n",
+                  (unsigned long)ap_capacity,
+                  (unsigned long)sta_capacity,
+                  (unsigned)((ap_bytes + sta_bytes) / 1024));
+    return true;
+}
+
+void ApTable::lock() {
+    if (mutex) xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void ApTable::unlock() {
+    if (mutex) xSemaphoreGive(mutex);
+}
+
+// Remove dos agregados a contribuição de uma entrada despejada.
+void ApTable::forget(const ApInfo& ap) {
+    by_encryption[ap.encryption]--;
+    if (ap.hidden) hidden--;
+    if (ap.capture_flags & AP_CAPTURE_HANDSHAKE) with_handshake--;
+    if (ap.capture_flags & AP_CAPTURE_PMKID) with_pmkid--;
+    clients -= ap.clients;
+}
+
+ApInfo* ApTable::touch(const uint8_t* bssid, int8_t rssi, uint32_t now_ms, bool* created) {
+    ApInfo* ap = aps.insert(bssid, created, [this](const uint8_t*, const ApInfo& old) {
+        forget(old);
+    });
+    if (!ap) return nullptr;
+
+    if (*created) {
+        memcpy(ap->bssid, bssid, 6);
+        ap->first_seen_ms = now_ms;
+        total_seen.fetch_add(1, std::memory_order_relaxed);
+        by_encryption[AP_ENC_UNKNOWN]++;
+    }
+    // rssi == 0: sem amostra (dado to-DS vem da estação, não do AP). A média
+    // começa na primeira amostra real, não em 0 dBm.
+    if (rssi != 0) {
+        if (!ap->has_rssi()) {
+            ap->rssi_ewma_x16 = (int16_t)(rssi * 16);
+        } else {
+            // EWMA com alfa = 1/8
+            ap->rssi_ewma_x16 += (int16_t)((rssi * 16 - ap->rssi_ewma_x16) / 8);
+        }
+        ap->rssi_last = rssi;
+    }
+    ap->last_seen_ms = now_ms;
+    return ap;
+}
+
+void ApTable::set_encryption(ApInfo& ap, uint8_t enc) {
+    if (ap.encryption == enc) return;
+    by_encryption[ap.encryption]--;
+    by_encryption[enc]++;
+    ap.encryption = enc;
+}
+
+void ApTable::set_ssid(ApInfo& ap, dot11::Span ssid) {
+    bool is_hidden = true;
+    for (uint16_t i = 0; i < ssid.len; ++i) {
+        if (ssid.data[i]) {
+            is_hidden = false;
+            break;
+        }
+    }
+
+    if (is_hidden != (ap.hidden != 0)) {
+        if (is_hidden) hidden++;
+        else hidden--;
+        ap.hidden = is_hidden ? 1 : 0;
+    }
+    // Probe response de rede oculta revela o SSID; beacon vazio não apaga.
+    if (!is_hidden) {
+        memcpy(ap.ssid, ssid.data, ssid.len);
+        ap.ssid[ssid.len] = '\0';
+    }
+}
+
+bool ApTable::on_beacon(const dot11::Dot11View& view, int8_t rssi, uint8_t rx_channel,
+                        uint32_t now_ms) {
+    if (!view.bssid || is_group_addr(view.bssid)) return false;
+
+    lock();
+    bool created = false;
+    ApInfo* ap = touch(view.bssid, rssi, now_ms, &created);
+    if (ap) {
+        ap->beacons++;
+        ap->channel = view.channel ? view.channel : rx_channel;
+        set_encryption(*ap, ap_classify_encryption(view));
+        if (view.has_ssid) set_ssid(*ap, view.ssid);
+    }
+    unlock();
+    return created;
+}
+
+void ApTable::add_client(const uint8_t* sta, const uint8_t* bssid, uint32_t now_ms) {
+    bool created = false;
+    StaInfo* s = stations.insert(sta, &created, [this](const uint8_t*, const StaInfo& old) {
+        ApInfo* prev = aps.find(old.bssid);
+        if (prev && prev->clients) {
+            prev->clients--;
+            clients--;
+        }
+    });
+    if (!s) return;
+
+    if (!created && memcmp(s->bssid, bssid, 6) == 0) {
+        s->last_seen_ms = now_ms;
+        return;
+    }
+
+    // Estação nova ou que trocou de AP (roaming)
+    if (!created) {
+        ApInfo* prev = aps.find(s->bssid);
+        if (prev && prev->clients) {
+            prev->clients--;
+            clients--;
+        }
+    }
+    memcpy(s->bssid, bssid, 6);
+    s->last_seen_ms = now_ms;
+
+    ApInfo* ap = aps.find(bssid);
+    if (ap) {
+        ap->clients++;
+        clients++;
+    }
+}
+
+void ApTable::on_data(const dot11::Dot11View& view, int8_t rssi, uint8_t rx_channel,
+                      uint32_t now_ms) {
+    bool to_ds = view.flags & dot11::FC_TO_DS;
+    bool from_ds = view.flags & dot11::FC_FROM_DS;
+    if (to_ds == from_ds || !view.addr1 || !view.addr2) return;   // só infraestrutura
+
+    const uint8_t* bssid = from_ds ? view.addr2 : view.addr1;
+    const uint8_t* sta = from_ds ? view.addr1 : view.addr2;
+    if (is_group_addr(bssid)) return;
+
+    lock();
+    bool created = false;
+    // O RSSI do frame é do transmissor: só vale para o AP quando from_ds
+    ApInfo* ap = touch(bssid, from_ds ? rssi : 0, now_ms, &created);
+    if (ap) {
+        ap->data_frames++;
+        if (created) ap->channel = rx_channel;
+        if (!is_group_addr(sta)) {
+            add_client(sta, bssid, now_ms);
+        }
+    }
+    unlock();
+}
+
+void ApTable::mark_capture(const uint8_t* bssid, uint8_t flags) {
+    lock();
+    ApInfo* ap = aps.find(bssid);
+    if (ap) {
+        uint8_t added = flags & ~ap->capture_flags;
+        if (added & AP_CAPTURE_HANDSHAKE) with_handshake++;
+        if (added & AP_CAPTURE_PMKID) with_pmkid++;
+        ap->capture_flags |= flags;
+    }
+    unlock();
+}
+
+void ApTable::get_summary(ApTableSummary* out, uint32_t now_ms) {
+    memset(out, 0, sizeof(*out));
+    out->strongest_rssi = -127;
+
+    lock();
+    out->aps_total = total_seen.load(std::memory_order_relaxed);
+    out->aps_tracked = aps.size();
+    memcpy(out->by_encryption, by_encryption, sizeof(by_encryption));
+    out->hidden = hidden;
+    out->with_handshake = with_handshake;
+    out->with_pmkid = with_pmkid;
+    out->clients = clients;
+
+    // Só a janela ativa exige varrer a tabela
+    uint32_t since = now_ms - AP_TABLE_ACTIVE_WINDOW_MS;
+    int32_t rssi_sum = 0;
+    int32_t rssi_count = 0;
+    aps.for_each([&](const uint8_t*, ApInfo& ap) {
+        if ((int32_t)(ap.last_seen_ms - since) < 0) return;
+        out->aps_active++;
+        if (!ap.has_rssi()) return;
+        int8_t r = ap.rssi();
+        rssi_sum += r;
+        rssi_count++;
+        if (r > out->strongest_rssi) out->strongest_rssi = r;
+    });
+    unlock();
+
+    out->mean_rssi = rssi_count ? (int8_t)(rssi_sum / rssi_count) : -127;
+}
+
+bool ApTable::get(const uint8_t* bssid, ApInfo* out) {
+    lock();
+    ApInfo* ap = aps.find(bssid);
+    if (ap) *out = *ap;
+    unlock();
+    return ap != nullptr;
+}
+
+size_t ApTable::top_by_rssi(ApInfo* out, size_t n, uint32_t since_ms) {
+    if (!out || n == 0) return 0;
+
+    // Inserção ordenada num vetor de N: O(tabela * N), N pequeno
+    size_t found = 0;
+    for_each_since(since_ms, [&](const ApInfo& ap) {
+        if (!ap.has_rssi()) return;
+        int8_t r = ap.rssi();
+        size_t pos = found;
+        while (pos > 0 && out[pos - 1].rssi() < r) {
+            if (pos < n) out[pos] = out[pos - 1];
+            pos--;
+        }
+        if (pos < n) {
+            out[pos] = ap;
+            if (found < n) found++;
+        }
+    });
+    return found;
+}
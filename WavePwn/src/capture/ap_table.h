@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "capture/dot11.h"
+#include "capture/mac_table.h"
+
+// Tabela de APs e estações vistos, mantida incrementalmente pela task de
+// captura. Fonte única para UI, dashboard e features da NEURA9: ninguém
+// precisa reler logs do SD para saber "quantos APs", "quais os mais fortes"
+// ou "quantos WPA3 por perto".
+//
+// - Uma arena em PSRAM com duas MacTable: APs (BSSID) e estações (MAC).
+// - Os agregados (por criptografia, capturas, clientes) são atualizados a
+//   cada mudança, inclusive quando uma entrada é despejada.
+// - Escrita só pela task de captura; leituras de outras tasks passam pelo
+//   mesmo mutex e copiam o que precisam.
+
+// Sondagem limitada do MacTable: folga de ~4x para não haver despejos em
+// ambientes densos (~150 KB + ~100 KB em PSRAM)
+#define AP_TABLE_CAPACITY        2048
+#define AP_TABLE_STA_CAPACITY    4096
+#define AP_TABLE_ACTIVE_WINDOW_MS 300000   // "ativo" = visto nos últimos 5 min
+
+enum ApEncryption : uint8_t {
+    AP_ENC_UNKNOWN = 0,   // só visto em data frames
+    AP_ENC_OPEN,
+    AP_ENC_WEP,
+    AP_ENC_WPA,
+    AP_ENC_WPA2,
+    AP_ENC_WPA3,          // SAE (inclui transição WPA2/WPA3)
+    AP_ENC_COUNT,
+};
+
+// ApInfo::capture_flags
+#define AP_CAPTURE_HANDSHAKE_PARTIAL  0x01   // par M1+M2 (não autorizado)
+#define AP_CAPTURE_HANDSHAKE          0x02   // par autorizado gravado
+#define AP_CAPTURE_PMKID              0x04
+
+struct ApInfo {
+    uint8_t  bssid[6];
+    char     ssid[33];        // vazio = oculto / ainda desconhecido
+    uint8_t  channel;
+    int8_t   rssi_last;       // 0 = nenhuma amostra ainda
+    int16_t  rssi_ewma_x16;   // média exponencial em 1/16 dBm
+    uint8_t  encryption;      // ApEncryption
+    uint8_t  capture_flags;   // AP_CAPTURE_*
+    uint8_t  hidden;          // beacon com SSID vazio/zerado
+    uint16_t clients;         // estações distintas associadas a este BSSID
+    uint32_t first_seen_ms;
+    uint32_t last_seen_ms;
+    uint32_t beacons;
+    uint32_t data_frames;
+
+    bool has_rssi() const { return rssi_last != 0; }
+    int8_t rssi() const { return (int8_t)(rssi_ewma_x16 / 16); }
+};
+
+struct ApTableSummary {
+    uint32_t aps_total;                   // APs desde o boot (despejado e
+                                          // visto de novo conta outra vez)
+    uint32_t aps_tracked;                 // entradas na tabela agora
+    uint32_t aps_active;                  // vistos na janela ativa
+    uint32_t by_encryption[AP_ENC_COUNT]; // entradas na tabela por tipo
+    uint32_t hidden;
+    uint32_t with_handshake;
+    uint32_t with_pmkid;
+    uint32_t clients;                     // estações associadas na tabela
+    int8_t   strongest_rssi;              // entre os ativos com amostra (-127 = nenhum)
+    int8_t   mean_rssi;                   // idem
+};
+
+class ApTable {
+public:
+    // Aloca a arena (PSRAM com fallback para RAM interna) e o mutex.
+    bool begin(uint32_t ap_capacity = AP_TABLE_CAPACITY,
+               uint32_t sta_capacity = AP_TABLE_STA_CAPACITY);
+
+    // --- Atualização (task de captura) ---------------------------------------
+
+    // Beacon / probe response: SSID, canal, criptografia, RSSI.
+    // Retorna true se o BSSID é novo.
+    bool on_beacon(const dot11::Dot11View& view, int8_t rssi, uint8_t rx_channel,
+                   uint32_t now_ms);
+
+    // Data frame entre AP e estação: atividade e contagem de clientes.
+    void on_data(const dot11::Dot11View& view, int8_t rssi, uint8_t rx_channel,
+                 uint32_t now_ms);
+
+    // Marca uma captura (AP_CAPTURE_*) no AP.
+    void mark_capture(const uint8_t* bssid, uint8_t flags);
+
+    // --- Consultas (qualquer task) -------------------------------------------
+
+    void get_summary(ApTableSummary* out, uint32_t now_ms);
+
+    // Igual a ApTableSummary::aps_total, em O(1) e sem o mutex (para a UI,
+    // que consulta a cada volta do loop).
+    uint32_t aps_total() const { return total_seen.load(std::memory_order_relaxed); }
+
+    bool get(const uint8_t* bssid, ApInfo* out);
+
+    // Até `n` APs vistos desde `since_ms`, do mais forte para o mais fraco.
+    size_t top_by_rssi(ApInfo* out, size_t n, uint32_t since_ms);
+
+    // Visita (com o mutex) os APs vistos desde `since_ms`. `fn(const ApInfo&)`
+    // não deve bloquear nem chamar a tabela.
+    template <typename Fn>
+    void for_each_since(uint32_t since_ms, Fn fn);
+
+private:
+    struct StaInfo {
+        uint8_t  bssid[6];        // AP ao qual está associada
+        uint32_t last_seen_ms;
+    };
+
+    typedef MacTable<6, ApInfo> ApMap;
+    typedef MacTable<6, StaInfo> StaMap;
+
+    ApMap aps;
+    StaMap stations;
+    SemaphoreHandle_t mutex = nullptr;
+
+    // Agregados incrementais
+    std::atomic<uint32_t> total_seen{0};
+    uint32_t by_encryption[AP_ENC_COUNT] = {};
+    uint32_t hidden = 0;
+    uint32_t with_handshake = 0;
+    uint32_t with_pmkid = 0;
+    uint32_t clients = 0;
+
+    void lock();
+    void unlock();
+    ApInfo* touch(const uint8_t* bssid, int8_t rssi, uint32_t now_ms, bool* created);
+    void set_encryption(ApInfo& ap, uint8_t enc);
+    void set_ssid(ApInfo& ap, dot11::Span ssid);
+    void forget(const ApInfo& ap);
+    void add_client(const uint8_t* sta, const uint8_t* bssid, uint32_t now_ms);
+};
+
+template <typename Fn>
+void ApTable::for_each_since(uint32_t since_ms, Fn fn) {
+    lock();
+    aps.for_each([&](const uint8_t*, ApInfo& ap) {
+        if ((int32_t)(ap.last_seen_ms - since_ms) >= 0) fn(ap);
+    });
+    unlock();
+}
+
+// ApEncryption de um beacon / probe response, pelo RSN/WPA IE e pelo bit
+// Privacy da capability.
+uint8_t ap_classify_encryption(const dot11::Dot11View& view);
+
+extern ApTable ap_table;
@@ -0,0 +1,167 @@
+#include "capture/channel_scheduler.h"
+
+#include <math.h>
+#include <string.h>
+
+bool ChannelScheduler::begin(const uint8_t* channels,
+                             uint8_t n,
+                             uint32_t base_dwell_ms,
+                             uint32_t min_dwell_ms,
+                             uint32_t max_dwell_ms,
+                             bool adaptive_mode,
+                             uint32_t seed) {
+    if (!channels || n == 0) return false;
+    if (n > SCHED_MAX_CHANNELS) n = SCHED_MAX_CHANNELS;
+
+    memset(stats, 0, sizeof(stats));
+    for (uint8_t i = 0; i < n; ++i) {
+        stats[i].channel = channels[i];
+    }
+    count = n;
+    current = 0;
+    rr_next = n > 1 ? 1 : 0;
+    adaptive = adaptive_mode;
+
+    base_dwell = base_dwell_ms;
+    min_dwell = min_dwell_ms < base_dwell_ms ? min_dwell_ms : base_dwell_ms;
+    max_dwell = max_dwell_ms > base_dwell_ms ? max_dwell_ms : base_dwell_ms;
+    dwell = base_dwell;
+
+    total_visits = 0;
+    total_hops = 0;
+    total_bumps = 0;
+    rng = seed ? seed : 1;
+    return true;
+}
+
+int ChannelScheduler::index_of(uint8_t ch) const {
+    for (uint8_t i = 0; i < count; ++i) {
+        if (stats[i].channel == ch) return i;
+    }
+    return -1;
+}
+
+float ChannelScheduler::rate(uint8_t index) const {
+    const ChannelStats& s = stats[index];
+    return (s.reward + SCHED_PRIOR_REWARD) / (s.time_s + SCHED_PRIOR_TIME_S);
+}
+
+uint32_t ChannelScheduler::random() {
+    // xorshift32: determinístico para a simulação ser reproduzível
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+void ChannelScheduler::credit(const ChannelActivity& a, uint32_t elapsed_ms) {
+    ChannelStats& s = stats[current];
+    s.beacons += a.beacons;
+    s.data_frames += a.data_frames;
+    s.eapol += a.eapol;
+    s.new_bssids += a.new_bssids;
+    s.visits++;
+    s.dwell_total_ms += elapsed_ms;
+    s.last_dwell_ms = elapsed_ms;
+
+    float r = SCHED_W_EAPOL * a.eapol +
+              SCHED_W_NEW_BSSID * a.new_bssids +
+              SCHED_W_DATA * a.data_frames +
+              SCHED_W_BEACON * a.beacons;
+    s.reward = s.reward * SCHED_DECAY + r;
+    s.time_s = s.time_s * SCHED_DECAY + elapsed_ms / 1000.0f;
+    total_visits++;
+}
+
+uint32_t ChannelScheduler::dwell_for(uint8_t index) const {
+    if (!adaptive) return base_dwell;
+
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < count; ++i) {
+        sum += rate(i);
+    }
+    float mean = sum / count;
+    float d = base_dwell * (mean > 0.0f ? rate(index) / mean : 1.0f);
+
+    if (d < min_dwell) return min_dwell;
+    if (d > max_dwell) return max_dwell;
+    return (uint32_t)d;
+}
+
+uint8_t ChannelScheduler::pick_next() {
+    if (!adaptive || count == 1) {
+        uint8_t next = rr_next;
+        rr_next = (uint8_t)((rr_next + 1) % count);
+        return next;
+    }
+
+    // Exploração: canal aleatório diferente do atual
+    if ((random() % 1000) < (uint32_t)(SCHED_EPSILON * 1000)) {
+        uint8_t next = (uint8_t)(random() % (count - 1));
+        return next >= current ? next + 1 : next;
+    }
+
+    // UCB1 visita cada canal uma vez antes de comparar: sem isso, um canal
+    // com EAPOL logo no início deixa os outros abaixo do bônus para sempre
+    for (uint8_t i = 0; i < count; ++i) {
+        if (stats[i].visits == 0 && i != current) return i;
+    }
+
+    float max_rate = 0.0f;
+    for (uint8_t i = 0; i < count; ++i) {
+        float r = rate(i);
+        if (r > max_rate) max_rate = r;
+    }
+
+    // UCB1 sobre a taxa normalizada
+    float log_n = logf((float)total_visits + 1.0f);
+    uint8_t best = current;
+    float best_score = -1.0f;
+    for (uint8_t i = 0; i < count; ++i) {
+        float bonus = SCHED_UCB_C * sqrtf(log_n / (stats[i].visits + 1.0f));
+        float score = rate(i) / max_rate + bonus;
+        if (score > best_score) {
+            best_score = score;
+            best = i;
+        }
+    }
+    return best;
+}
+
+uint8_t ChannelScheduler::advance(const ChannelActivity& activity, uint32_t elapsed_ms) {
+    if (!count) return 0;
+
+    credit(activity, elapsed_ms);
+    uint8_t next = pick_next();
+    if (next != current) total_hops++;
+    current = next;
+    dwell = dwell_for(current);
+    return stats[current].channel;
+}
+
+bool ChannelScheduler::bump(uint8_t ch, const ChannelActivity& activity, uint32_t elapsed_ms) {
+    if (!can_bump(ch)) return false;
+    int idx = index_of(ch);
+    if ((uint8_t)idx == current) {
+        hold(elapsed_ms);
+        return false;
+    }
+
+    credit(activity, elapsed_ms);
+    total_bumps++;
+    total_hops++;
+    current = (uint8_t)idx;
+    uint32_t d = dwell_for(current);
+    dwell = d > SCHED_EAPOL_HOLD_MS ? d : SCHED_EAPOL_HOLD_MS;
+    return true;
+}
+
+void ChannelScheduler::hold(uint32_t elapsed_ms) {
+    if (!adaptive) return;
+    // Só garante o hold a partir de agora, e só até max_dwell: com M1
+    // frequentes, estender sempre prenderia o rádio num canal só.
+    if (elapsed_ms >= max_dwell) return;
+    total_bumps++;
+    uint32_t until = elapsed_ms + SCHED_EAPOL_HOLD_MS;
+    if (until > dwell) dwell = until;
+}
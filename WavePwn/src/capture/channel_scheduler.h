@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Escalonador de channel hopping adaptativo (lógica pura, sem Wi-Fi/RTOS).
+//
+// Cada canal acumula uma recompensa por dwell (EAPOL, BSSIDs novos, data
+// frames, beacons) com decaimento exponencial, o que dá uma taxa de
+// "recompensa por segundo". A escolha do próximo canal é um bandit:
+//
+//   - com probabilidade SCHED_EPSILON, explora um canal aleatório;
+//   - senão, um canal ainda não visitado ou o maior UCB = taxa normalizada
+//     + bônus de pouca visita;
+//   - o dwell é proporcional à taxa do canal em relação à média.
+//
+// Um EAPOL M1 faz bump() (vai para o canal por SCHED_EAPOL_HOLD_MS) ou, se
+// já é o canal atual, hold() (estende o dwell em andamento) para pegar
+// M2..M4. Com adaptive = false vira o round-robin fixo antigo, útil
+// como referência na simulação (tempo sempre vem do chamador).
+
+#define SCHED_MAX_CHANNELS   16
+
+#define SCHED_W_EAPOL        20.0f   // por frame EAPOL
+#define SCHED_W_NEW_BSSID    5.0f    // por BSSID nunca visto
+#define SCHED_W_DATA         0.05f   // por data frame
+#define SCHED_W_BEACON       0.01f   // por beacon
+
+#define SCHED_DECAY          0.8f    // peso do histórico a cada visita
+#define SCHED_PRIOR_REWARD   1.0f    // taxa inicial = 1 recompensa/s
+#define SCHED_PRIOR_TIME_S   1.0f
+#define SCHED_EPSILON        0.10f
+#define SCHED_UCB_C          0.5f
+#define SCHED_EAPOL_HOLD_MS  1500
+
+// Atividade observada num canal durante um dwell.
+struct ChannelActivity {
+    uint32_t beacons;
+    uint32_t data_frames;
+    uint32_t eapol;
+    uint32_t new_bssids;
+};
+
+struct ChannelStats {
+    uint8_t  channel;
+    uint32_t beacons;         // totais desde o boot
+    uint32_t data_frames;
+    uint32_t eapol;
+    uint32_t new_bssids;
+    uint32_t visits;
+    uint32_t dwell_total_ms;
+    uint32_t last_dwell_ms;
+    float    reward;          // recompensa com decaimento
+    float    time_s;          // tempo com decaimento
+};
+
+class ChannelScheduler {
+public:
+    bool begin(const uint8_t* channels,
+               uint8_t count,
+               uint32_t base_dwell_ms,
+               uint32_t min_dwell_ms,
+               uint32_t max_dwell_ms,
+               bool adaptive = true,
+               uint32_t seed = 0x9E3779B9u);
+
+    uint8_t channel() const { return count ? stats[current].channel : 0; }
+    uint32_t dwell_ms() const { return dwell; }
+
+    // Fecha o dwell atual (`elapsed_ms` de fato no canal) creditando
+    // `activity` e escolhe o próximo canal. Retorna o novo canal.
+    uint8_t advance(const ChannelActivity& activity, uint32_t elapsed_ms);
+
+    // EAPOL M1 visto em outro canal `ch`: fecha o dwell atual creditando
+    // `activity` e segura `ch` por no mínimo SCHED_EAPOL_HOLD_MS. Retorna
+    // true se o canal mudou. Se `ch` já é o canal atual, equivale a
+    // hold(elapsed_ms) e `activity` é ignorada (retorna false). No modo
+    // round-robin não faz nada (retorna false).
+    bool bump(uint8_t ch, const ChannelActivity& activity, uint32_t elapsed_ms);
+
+    // EAPOL M1 no canal atual, `elapsed_ms` depois do início do dwell: o
+    // dwell passa a terminar no mínimo SCHED_EAPOL_HOLD_MS depois de agora
+    // (M1 depois de max_dwell não estende mais).
+    // Não credita nada: o chamador mantém o início do dwell e a atividade
+    // acumulada, que entram uma vez só no advance() quando ele terminar.
+    void hold(uint32_t elapsed_ms);
+
+    // true se bump(ch, ...) vai agir: modo adaptativo e `ch` na lista.
+    // Senão o dwell atual segue como está.
+    bool can_bump(uint8_t ch) const { return adaptive && index_of(ch) >= 0; }
+
+    // Taxa de recompensa estimada do canal (recompensa/s).
+    float rate(uint8_t index) const;
+
+    uint8_t channel_count() const { return count; }
+    int index_of(uint8_t ch) const;
+    const ChannelStats& channel_stats(uint8_t index) const { return stats[index]; }
+    uint32_t hops() const { return total_hops; }
+    uint32_t bumps() const { return total_bumps; }
+
+private:
+    ChannelStats stats[SCHED_MAX_CHANNELS] = {};
+    uint8_t count = 0;
+    uint8_t current = 0;
+    uint8_t rr_next = 0;
+    bool adaptive = true;
+
+    uint32_t base_dwell = 0;
+    uint32_t min_dwell = 0;
+    uint32_t max_dwell = 0;
+    uint32_t dwell = 0;
+
+    uint32_t total_visits = 0;
+    uint32_t total_hops = 0;
+    uint32_t total_bumps = 0;
+    uint32_t rng = 0;
+
+    void credit(const ChannelActivity& activity, uint32_t elapsed_ms);
+    uint8_t pick_next();
+    uint32_t dwell_for(uint8_t index) const;
+    uint32_t random();
+};
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Visão somente-leitura de um frame 802.11, sem alocação e sem String.
+//
+// Dot11View::parse() faz uma única passada sobre o frame: decodifica o
+// cabeçalho (tipo, flags, endereços, BSSID), percorre os IEs de management
+// uma vez (SSID, canal, RSN, WPA, vendor) e localiza o EAPOL de Data frames.
+// Todo acesso passa por Span, que checa limites: um frame truncado ou com IE
+// malformado nunca provoca leitura fora do buffer, só campos vazios.
+//
+// Os ponteiros apontam para o buffer original, que deve continuar válido
+// enquanto a view for usada (ex.: o slot do ring de captura).
+
+namespace dot11 {
+
+// -----------------------------------------------------------------------------
+// Constantes
+// -----------------------------------------------------------------------------
+
+enum FrameType : uint8_t {
+    TYPE_MGMT = 0,
+    TYPE_CTRL = 1,
+    TYPE_DATA = 2,
+    TYPE_EXT  = 3,
+};
+
+enum MgmtSubtype : uint8_t {
+    MGMT_ASSOC_REQ    = 0,
+    MGMT_ASSOC_RESP   = 1,
+    MGMT_REASSOC_REQ  = 2,
+    MGMT_REASSOC_RESP = 3,
+    MGMT_PROBE_REQ    = 4,
+    MGMT_PROBE_RESP   = 5,
+    MGMT_TIMING_ADV   = 6,
+    MGMT_BEACON       = 8,
+    MGMT_ATIM         = 9,
+    MGMT_DISASSOC     = 10,
+    MGMT_AUTH         = 11,
+    MGMT_DEAUTH       = 12,
+    MGMT_ACTION       = 13,
+    MGMT_ACTION_NOACK = 14,
+};
+
+enum IeId : uint8_t {
+    IE_SSID      = 0,
+    IE_DS_PARAMS = 3,
+    IE_RSN       = 48,
+    IE_HT_OPER   = 61,
+    IE_VENDOR    = 221,
+};
+
+static const uint8_t FC_TO_DS     = 0x01;
+static const uint8_t FC_FROM_DS   = 0x02;
+static const uint8_t FC_PROTECTED = 0x40;
+static const uint8_t FC_ORDER     = 0x80;
+
+static const uint16_t HDR_LEN_3ADDR = 24;
+static const uint8_t MAX_VENDOR_IES = 4;
+
+// Campos fixos antes dos IEs, por subtipo de management. NO_IES = subtipo
+// cujo corpo não tem IEs que nos interessem (ou não tem corpo).
+static const uint8_t NO_IES = 0xFF;
+static constexpr uint8_t MGMT_FIXED_LEN[16] = {
+    4,       // assoc request: capability + listen interval
+    6,       // assoc response: capability + status + AID
+    10,      // reassoc request: + AP atual
+    6,       // reassoc response
+    0,       // probe request: só IEs
+    12,      // probe response: timestamp + intervalo + capability
+    NO_IES,  // timing advertisement
+    NO_IES,  // reservado
+    12,      // beacon
+    NO_IES,  // ATIM
+    NO_IES,  // disassoc: reason
+    6,       // auth: algoritmo + seq + status
+    NO_IES,  // deauth: reason
+    NO_IES,  // action
+    NO_IES,  // action no ack
+    NO_IES,  // reservado
+};
+
+// Despacho de IEs: quais IDs a view registra durante a passada.
+enum IeKind : uint8_t {
+    IE_KIND_IGNORE = 0,
+    IE_KIND_SSID,
+    IE_KIND_CHANNEL,
+    IE_KIND_RSN,
+    IE_KIND_HT_OPER,
+    IE_KIND_VENDOR,
+};
+
+constexpr IeKind ie_kind(uint8_t id) {
+    return id == IE_SSID      ? IE_KIND_SSID
+         : id == IE_DS_PARAMS ? IE_KIND_CHANNEL
+         : id == IE_RSN       ? IE_KIND_RSN
+         : id == IE_HT_OPER   ? IE_KIND_HT_OPER
+         : id == IE_VENDOR    ? IE_KIND_VENDOR
+         :                      IE_KIND_IGNORE;
+}
+
+// -----------------------------------------------------------------------------
+// Span: ponteiro + tamanho com acesso checado
+// -----------------------------------------------------------------------------
+
+struct Span {
+    const uint8_t* data;
+    uint16_t len;
+
+    bool empty() const { return len == 0; }
+
+    // Verdadeiro se [off, off + n) cabe no span.
+    bool has(uint16_t off, uint16_t n) const {
+        return off <= len && n <= len - off;
+    }
+
+    // Sub-span começando em `off`, cortado ao fim do span.
+    Span sub(uint16_t off, uint16_t n = 0xFFFF) const {
+        Span s = {nullptr, 0};
+        if (off > len) return s;
+        s.data = data + off;
+        s.len = (n > len - off) ? (uint16_t)(len - off) : n;
+        return s;
+    }
+
+    uint8_t u8(uint16_t off) const { return off < len ? data[off] : 0; }
+    uint16_t le16(uint16_t off) const {
+        return has(off, 2) ? (uint16_t)(data[off] | (data[off + 1] << 8)) : 0;
+    }
+    uint16_t be16(uint16_t off) const {
+        return has(off, 2) ? (uint16_t)((data[off] << 8) | data[off + 1]) : 0;
+    }
+    uint64_t be64(uint16_t off) const {
+        if (!has(off, 8)) return 0;
+        uint64_t v = 0;
+        for (uint16_t i = 0; i < 8; ++i) v = (v << 8) | data[off + i];
+        return v;
+    }
+    const uint8_t* ptr(uint16_t off, uint16_t n) const {
+        return has(off, n) ? data + off : nullptr;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Iterador de IEs
+// -----------------------------------------------------------------------------
+
+struct Ie {
+    uint8_t id;
+    Span body;
+};
+
+class IeIterator {
+public:
+    explicit IeIterator(Span ies) : rest(ies), bad(false) {}
+
+    bool next(Ie* out) {
+        if (rest.len < 2) {
+            bad = bad || rest.len != 0;
+            return false;
+        }
+        uint8_t elen = rest.data[1];
+        if (elen > rest.len - 2) {
+            // IE declara mais bytes do que o frame tem
+            bad = true;
+            rest.len = 0;
+            return false;
+        }
+        out->id = rest.data[0];
+        out->body.data = rest.data + 2;
+        out->body.len = elen;
+        rest = rest.sub(2 + elen);
+        return true;
+    }
+
+    bool malformed() const { return bad; }
+
+private:
+    Span rest;
+    bool bad;
+};
+
+// Vendor IE da Microsoft com o WPA1 (00:50:F2, tipo 1).
+inline bool is_wpa_vendor_ie(Span body) {
+    return body.has(0, 4) && body.data[0] == 0x00 && body.data[1] == 0x50 &&
+           body.data[2] == 0xF2 && body.data[3] == 0x01;
+}
+
+// PMKID do RSN IE (ou nullptr). Percorre a estrutura variável do RSN:
+// versão, group cipher, pairwise, AKM, capabilities, PMKID list.
+inline const uint8_t* rsn_pmkid(Span rsn) {
+    uint32_t off = 2 + 4;                              // versão + group cipher
+    for (int list = 0; list < 2; ++list) {             // pairwise, AKM
+        if (!rsn.has(off, 2)) return nullptr;
+        off += 2 + 4u * rsn.le16(off);
+    }
+    off += 2;                                          // RSN capabilities
+    if (off > rsn.len || !rsn.has(off, 2) || rsn.le16(off) == 0) return nullptr;
+    return rsn.ptr(off + 2, 16);
+}
+
+// -----------------------------------------------------------------------------
+// EAPOL-Key
+// -----------------------------------------------------------------------------
+
+static const uint16_t KEY_INFO_INSTALL = 0x0040;
+static const uint16_t KEY_INFO_ACK     = 0x0080;
+static const uint16_t KEY_INFO_MIC     = 0x0100;
+static const uint16_t KEY_INFO_SECURE  = 0x0200;
+static const uint16_t KEY_INFO_REQUEST = 0x0800;
+
+struct EapolKey {
+    Span frame;               // EAPOL declarado (cabeçalho 4 + corpo)
+    uint16_t key_info;
+    uint64_t replay_counter;
+    const uint8_t* nonce;     // 32 bytes
+    const uint8_t* mic;       // 16 bytes
+    uint16_t mic_offset;      // dentro de `frame`
+    uint8_t message;          // 1..4, 0 = não identificada
+};
+
+// Decodifica um EAPOL-Key com MIC de 16 bytes (WPA/WPA2-PSK).
+inline bool parse_eapol_key(Span eapol, EapolKey* out) {
+    static const uint16_t KEY_OFF = 4;
+    static const uint16_t KEY_MIN_LEN = 95;
+
+    if (!eapol.has(0, KEY_OFF) || eapol.data[1] != 3) return false;  // só EAPOL-Key
+
+    // Corta no tamanho declarado (descarta padding do 802.11)
+    Span frame = eapol.sub(0, KEY_OFF + eapol.be16(2));
+    if (!frame.has(KEY_OFF, KEY_MIN_LEN)) return false;
+    Span key = frame.sub(KEY_OFF);
+
+    out->frame = frame;
+    out->key_info = key.be16(1);
+    out->replay_counter = key.be64(5);
+    out->nonce = key.ptr(13, 32);
+    out->mic = key.ptr(77, 16);
+    out->mic_offset = KEY_OFF + 77;
+
+    uint16_t ki = out->key_info;
+    bool mic = ki & KEY_INFO_MIC;
+    bool ack = ki & KEY_INFO_ACK;
+    bool install = ki & KEY_INFO_INSTALL;
+    bool secure = ki & KEY_INFO_SECURE;
+    bool request = ki & KEY_INFO_REQUEST;
+
+    out->message = 0;
+    if (!mic && ack && !install && !secure) {
+        out->message = 1;
+    } else if (mic && !ack && !install && !secure && !request) {
+        out->message = 2;
+    } else if (mic && ack && install && secure) {
+        out->message = 3;
+    } else if (mic && !ack && !install && secure) {
+        out->message = 4;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dot11View
+// -----------------------------------------------------------------------------
+
+struct Dot11View {
+    Span frame;                 // sem FCS
+    uint8_t type;
+    uint8_t subtype;
+    uint8_t flags;
+    uint16_t header_len;
+
+    const uint8_t* addr1;       // nullptr quando ausente
+    const uint8_t* addr2;
+    const uint8_t* addr3;
+    const uint8_t* bssid;
+
+    Span body;
+
+    // Management: resultado da passada pelos IEs
+    Span ies;
+    bool has_ssid;
+    Span ssid;                  // pode ser vazio (rede oculta)
+    uint8_t channel;            // DS Parameter Set / HT Operation, 0 = ausente
+    Span rsn;
+    Span wpa;                   // vendor IE WPA1 (sem OUI/tipo)
+    uint8_t vendor_count;
+    Span vendor[MAX_VENDOR_IES];
+    bool ies_malformed;
+
+    // Data: EAPOL depois do LLC/SNAP (vazio se não for EAPOL)
+    Span eapol;
+
+    bool is_mgmt() const { return type == TYPE_MGMT; }
+    bool is_data() const { return type == TYPE_DATA; }
+    bool is_beacon() const { return type == TYPE_MGMT && subtype == MGMT_BEACON; }
+    bool is_probe_resp() const { return type == TYPE_MGMT && subtype == MGMT_PROBE_RESP; }
+    bool is_protected() const { return (flags & FC_PROTECTED) != 0; }
+    bool has_eapol() const { return !eapol.empty(); }
+
+    // `fcs_len` = bytes de FCS no fim do buffer (4 no modo promíscuo do ESP32
+    // quando o frame não foi truncado). Retorna false se não há nem o
+    // Frame Control; cabeçalhos incompletos deixam os campos vazios.
+    bool parse(const uint8_t* data, uint16_t len, uint16_t fcs_len = 0) {
+        memset(this, 0, sizeof(*this));
+        if (!data || len < 2) return false;
+        if (fcs_len && len >= fcs_len + 2) len -= fcs_len;
+
+        frame.data = data;
+        frame.len = len;
+        type = (data[0] >> 2) & 0x3;
+        subtype = (data[0] >> 4) & 0xF;
+        flags = data[1];
+
+        switch (type) {
+            case TYPE_MGMT: parse_mgmt(); break;
+            case TYPE_DATA: parse_data(); break;
+            case TYPE_CTRL:
+                addr1 = frame.ptr(4, 6);
+                addr2 = frame.ptr(10, 6);   // ausente em ACK/CTS curtos
+                break;
+            default: break;
+        }
+        return true;
+    }
+
+private:
+    void parse_addrs() {
+        addr1 = frame.ptr(4, 6);
+        addr2 = frame.ptr(10, 6);
+        addr3 = frame.ptr(16, 6);
+    }
+
+    void parse_mgmt() {
+        header_len = HDR_LEN_3ADDR;
+        if ((flags & FC_ORDER) != 0) header_len += 4;   // HT Control
+        parse_addrs();
+        bssid = addr3;
+        if (!frame.has(0, header_len)) return;
+        body = frame.sub(header_len);
+
+        uint8_t fixed = MGMT_FIXED_LEN[subtype];
+        if (fixed == NO_IES || is_protected() || !body.has(0, fixed)) return;
+        ies = body.sub(fixed);
+
+        IeIterator it(ies);
+        Ie ie;
+        while (it.next(&ie)) {
+            switch (ie_kind(ie.id)) {
+                case IE_KIND_SSID:
+                    if (!has_ssid) {
+                        has_ssid = true;
+                        ssid = ie.body.sub(0, 32);
+                    }
+                    break;
+                case IE_KIND_CHANNEL:
+                    if (ie.body.len >= 1) channel = ie.body.data[0];
+                    break;
+                case IE_KIND_HT_OPER:
+                    if (!channel && ie.body.len >= 1) channel = ie.body.data[0];
+                    break;
+                case IE_KIND_RSN:
+                    if (rsn.empty()) rsn = ie.body;
+                    break;
+                case IE_KIND_VENDOR:
+                    if (wpa.empty() && is_wpa_vendor_ie(ie.body)) {
+                        wpa = ie.body.sub(4);
+                    }
+                    if (vendor_count < MAX_VENDOR_IES) {
+                        vendor[vendor_count++] = ie.body;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        ies_malformed = it.malformed();
+    }
+
+    void parse_data() {
+        bool to_ds = flags & FC_TO_DS;
+        bool from_ds = flags & FC_FROM_DS;
+        bool qos = (subtype & 0x8) != 0;
+
+        header_len = HDR_LEN_3ADDR;
+        if (to_ds && from_ds) header_len += 6;          // addr4 (WDS)
+        if (qos) header_len += 2;
+        if (qos && (flags & FC_ORDER) != 0) header_len += 4;
+
+        parse_addrs();
+        if (!to_ds && !from_ds) {
+            bssid = addr3;
+        } else if (from_ds && !to_ds) {
+            bssid = addr2;
+        } else if (to_ds && !from_ds) {
+            bssid = addr1;
+        } else {
+            bssid = addr1;   // WDS: sem BSSID; addr1 por convenção
+        }
+
+        if (!frame.has(0, header_len)) return;
+        body = frame.sub(header_len);
+
+        // Null data (subtipo bit 2) não tem corpo; protegido não tem LLC legível.
+        if ((subtype & 0x4) != 0 || is_protected()) return;
+
+        // LLC/SNAP: AA AA 03 00 00 00 88 8E
+        static const uint8_t LLC_EAPOL[8] = {0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8E};
+        if (body.has(0, sizeof(LLC_EAPOL) + 4) &&
+            memcmp(body.data, LLC_EAPOL, sizeof(LLC_EAPOL)) == 0) {
+            eapol = body.sub(sizeof(LLC_EAPOL));
+        }
+    }
+};
+
+}  // namespace dot11
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fila SPSC (single-producer / single-consumer) de frames 802.11.
+//
+// O produtor é o callback promíscuo do Wi-Fi, que apenas copia o frame para
+// um slot pré-alocado (PSRAM) e publica. O consumidor é a task de captura,
+// que drena os slots e faz todo o trabalho lento (PCAP, parsing, SD).
+// Nenhuma alocação e nenhum lock no caminho do driver.
+
+// Maior MPDU 802.11 que guardamos por slot (frames maiores são truncados).
+#define CAPTURE_MAX_FRAME_LEN 2346
+
+// sig_len do modo promíscuo inclui o FCS no fim do frame.
+#define CAPTURE_FCS_LEN 4
+
+// Frame copiado do callback junto com os metadados de rádio de rx_ctrl.
+struct CaptureSlot {
+    uint64_t timestamp_us;   // esp_timer_get_time() no momento do RX
+    uint16_t len;            // bytes válidos em data[]
+    uint16_t orig_len;       // tamanho original do frame no ar
+    uint8_t  channel;
+    int8_t   rssi;
+    int8_t   noise_floor;
+    uint8_t  rate;
+    uint8_t  data[CAPTURE_MAX_FRAME_LEN];
+};
+
+class FrameRing {
+public:
+    // `count` precisa ser potência de 2. A memória dos slots pertence ao
+    // chamador e deve viver enquanto o ring estiver em uso.
+    bool begin(CaptureSlot* storage, uint32_t count) {
+        if (!storage || count == 0 || (count & (count - 1)) != 0) {
+            return false;
+        }
+        slots = storage;
+        mask = count - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        pushed.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+        high_watermark.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // --- Produtor -----------------------------------------------------------
+
+    // Retorna o próximo slot livre ou nullptr (ring cheio: conta um drop).
+    inline CaptureSlot* acquire() {
+        if (!slots) return nullptr;
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        const uint32_t t = tail.load(std::memory_order_acquire);
+        const uint32_t used = h - t;
+        if (used > mask) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (used + 1 > high_watermark.load(std::memory_order_relaxed)) {
+            high_watermark.store(used + 1, std::memory_order_relaxed);
+        }
+        return &slots[h & mask];
+    }
+
+    // Torna visível ao consumidor o slot obtido em acquire().
+    inline void publish() {
+        head.store(head.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+        pushed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // --- Consumidor ---------------------------------------------------------
+
+    // Próximo slot pronto para leitura, ou nullptr se o ring estiver vazio.
+    inline const CaptureSlot* peek() const {
+        if (!slots) return nullptr;
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        const uint32_t h = head.load(std::memory_order_acquire);
+        if (t == h) return nullptr;
+        return &slots[t & mask];
+    }
+
+    // Devolve ao produtor o slot lido em peek().
+    inline void release() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    }
+
+    // --- Estatísticas (leitura de qualquer task) -----------------------------
+
+    uint32_t capacity() const { return slots ? mask + 1 : 0; }
+    uint32_t depth() const {
+        return head.load(std::memory_order_acquire) -
+               tail.load(std::memory_order_acquire);
+    }
+    uint32_t total_pushed() const { return pushed.load(std::memory_order_relaxed); }
+    uint32_t total_dropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t max_depth() const { return high_watermark.load(std::memory_order_relaxed); }
+
+private:
+    CaptureSlot* slots = nullptr;
+    uint32_t mask = 0;
+
+    std::atomic<uint32_t> head{0};   // escrito só pelo produtor
+    std::atomic<uint32_t> tail{0};   // escrito só pelo consumidor
+
+    std::atomic<uint32_t> pushed{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint32_t> high_watermark{0};
+};
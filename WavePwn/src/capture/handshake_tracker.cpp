@@ -0,0 +1,157 @@
+#include "capture/handshake_tracker.h"
+
+#include <string.h>
+
+static bool is_zero(const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (p[i]) return false;
+    }
+    return true;
+}
+
+static bool within_timeout(uint32_t a, uint32_t b) {
+    uint32_t dt = a > b ? a - b : b - a;
+    return dt <= HS_EAPOL_TIMEOUT_MS;
+}
+
+uint8_t HandshakeTracker::rank_of(uint8_t message_pair) {
+    switch (message_pair) {
+        case HS_PAIR_M32E2: return 4;
+        case HS_PAIR_M12E2: return 3;
+        case HS_PAIR_M34E4: return 2;
+        case HS_PAIR_M14E4: return 1;
+        default:            return 0;
+    }
+}
+
+bool HandshakeTracker::on_message(const EapolKeyMessage& msg, Handshake* out) {
+    if (!msg.ap || !msg.sta || !msg.nonce || msg.message < 1 || msg.message > 4) {
+        return false;
+    }
+
+    // O MIC cobre o frame EAPOL inteiro: truncado, o par vira uma linha 22000
+    // que nunca confere. Frame maior que o buffer é recusado e contado.
+    if ((msg.message == 2 || msg.message == 4) &&
+        msg.eapol_len > sizeof(StaMessage::eapol)) {
+        oversize++;
+        return false;
+    }
+
+    uint8_t key[12];
+    memcpy(key, msg.ap, 6);
+    memcpy(key + 6, msg.sta, 6);
+
+    Session* s = sessions.insert(key);
+    if (!s || s->complete) return false;
+
+    if (msg.message == 1 || msg.message == 3) {
+        ApMessage& m = (msg.message == 1) ? s->m1 : s->m3;
+        m.replay_counter = msg.replay_counter;
+        m.timestamp_ms = msg.timestamp_ms;
+        memcpy(m.anonce, msg.nonce, 32);
+        m.valid = 1;
+    } else {
+        // M4 com SNonce zerado (comum) não serve para derivar a PTK.
+        if (msg.message == 4 && is_zero(msg.nonce, 32)) return false;
+        if (!msg.eapol || !msg.mic || msg.eapol_len == 0) return false;
+
+        StaMessage& m = (msg.message == 2) ? s->m2 : s->m4;
+        uint16_t len = msg.eapol_len;
+
+        m.replay_counter = msg.replay_counter;
+        m.timestamp_ms = msg.timestamp_ms;
+        m.key_version = msg.key_version;
+        memcpy(m.mic, msg.mic, 16);
+        memcpy(m.eapol, msg.eapol, len);
+        if (msg.mic_offset + 16 <= len) {
+            memset(m.eapol + msg.mic_offset, 0, 16);
+        }
+        m.eapol_len = len;
+        m.valid = 1;
+    }
+
+    Handshake hs;
+    if (!best_pair(key, *s, &hs)) return false;
+    if (rank_of(hs.message_pair) <= s->written_rank) return false;
+
+    hs.timestamp = msg.timestamp_ms;
+    if (out) *out = hs;
+    return true;
+}
+
+uint8_t HandshakeTracker::mark_written(const Handshake& hs) {
+    uint8_t key[12];
+    memcpy(key, hs.ap, 6);
+    memcpy(key + 6, hs.sta, 6);
+
+    Session* s = sessions.find(key);
+    if (!s) return 0;
+
+    uint8_t result = 0;
+    if (s->written_rank == 0) {
+        result |= HS_WRITTEN_FIRST;
+    }
+
+    uint8_t rank = rank_of(hs.message_pair);
+    if (rank > s->written_rank) {
+        s->written_rank = rank;
+    }
+    if (hs.authorized && !s->complete) {
+        s->complete = 1;
+        result |= HS_WRITTEN_COMPLETE;
+    }
+    return result;
+}
+
+bool HandshakeTracker::best_pair(const uint8_t* key, const Session& s, Handshake* out) {
+    const ApMessage* anonce_src = nullptr;
+    const StaMessage* eapol_src = nullptr;
+    uint8_t pair = 0;
+
+    const ApMessage& m1 = s.m1;
+    const ApMessage& m3 = s.m3;
+    const StaMessage& m2 = s.m2;
+    const StaMessage& m4 = s.m4;
+
+    // Replay counters: M2 = M1, M3 = M2 + 1, M4 = M3 = M1 + 1.
+    if (m2.valid && m3.valid &&
+        m3.replay_counter == m2.replay_counter + 1 &&
+        within_timeout(m2.timestamp_ms, m3.timestamp_ms)) {
+        anonce_src = &m3;
+        eapol_src = &m2;
+        pair = HS_PAIR_M32E2;
+    } else if (m1.valid && m2.valid &&
+               m2.replay_counter == m1.replay_counter &&
+               within_timeout(m1.timestamp_ms, m2.timestamp_ms)) {
+        anonce_src = &m1;
+        eapol_src = &m2;
+        pair = HS_PAIR_M12E2;
+    } else if (m3.valid && m4.valid &&
+               m4.replay_counter == m3.replay_counter &&
+               within_timeout(m3.timestamp_ms, m4.timestamp_ms)) {
+        anonce_src = &m3;
+        eapol_src = &m4;
+        pair = HS_PAIR_M34E4;
+    } else if (m1.valid && m4.valid &&
+               m4.replay_counter == m1.replay_counter + 1 &&
+               within_timeout(m1.timestamp_ms, m4.timestamp_ms)) {
+        anonce_src = &m1;
+        eapol_src = &m4;
+        pair = HS_PAIR_M14E4;
+    } else {
+        return false;
+    }
+
+    memset(out, 0, sizeof(*out));
+    memcpy(out->ap, key, 6);
+    memcpy(out->sta, key + 6, 6);
+    memcpy(out->anonce, anonce_src->anonce, 32);
+    memcpy(out->mic, eapol_src->mic, 16);
+    memcpy(out->eapol, eapol_src->eapol, eapol_src->eapol_len);
+    out->eapol_size = eapol_src->eapol_len;
+    out->key_version = eapol_src->key_version;
+    out->message_pair = pair;
+    out->authorized = (pair != HS_PAIR_M12E2);
+    out->timestamp = eapol_src->timestamp_ms;
+    return true;
+}
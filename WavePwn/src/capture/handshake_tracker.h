@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "capture.h"
+#include "capture/mac_table.h"
+
+// Máquina de estados do 4-way handshake por par AP/STA.
+//
+// Guarda a última M1..M4 vista de cada par, correlaciona nonces e replay
+// counters e escolhe o melhor par crackeável, na ordem:
+//
+//   M2+M3 (EAPOL de M2, ANonce de M3)  - autorizado
+//   M1+M2 (EAPOL de M2, ANonce de M1)  - challenge (senha pode estar errada)
+//   M3+M4 (EAPOL de M4, ANonce de M3)  - autorizado, exige SNonce em M4
+//   M1+M4 (EAPOL de M4, ANonce de M1)  - autorizado, exige SNonce em M4
+//
+// O tracker não toca em SD: devolve um Handshake pronto e o chamador informa
+// com mark_written() o que conseguiu gravar. Um par só é dado como completo
+// (deduplicável) depois que um par autorizado foi gravado.
+
+// Janela máxima entre mensagens do mesmo handshake (igual ao hcxpcapngtool).
+#define HS_EAPOL_TIMEOUT_MS 5000
+
+// Códigos MESSAGEPAIR do formato 22000 (hcxtools).
+#define HS_PAIR_M12E2 0x00
+#define HS_PAIR_M14E4 0x01
+#define HS_PAIR_M32E2 0x02
+#define HS_PAIR_M34E4 0x05
+
+// Retorno de HandshakeTracker::mark_written()
+#define HS_WRITTEN_FIRST    0x01   // primeiro par gravado deste AP/STA
+#define HS_WRITTEN_COMPLETE 0x02   // par autorizado: handshake completo
+
+// Uma mensagem EAPOL-Key já decodificada a partir do frame 802.11.
+struct EapolKeyMessage {
+    const uint8_t* ap;
+    const uint8_t* sta;
+    uint8_t message;          // 1..4
+    uint8_t key_version;
+    uint64_t replay_counter;
+    const uint8_t* nonce;     // 32 bytes
+    const uint8_t* mic;       // 16 bytes
+    const uint8_t* eapol;     // frame EAPOL completo (cabeçalho + corpo)
+    uint16_t eapol_len;
+    uint16_t mic_offset;      // offset do MIC dentro de `eapol`
+    uint32_t timestamp_ms;
+};
+
+class HandshakeTracker {
+public:
+    struct ApMessage {            // M1 / M3: só interessa o ANonce
+        uint64_t replay_counter;
+        uint32_t timestamp_ms;
+        uint8_t valid;
+        uint8_t anonce[32];
+    };
+
+    struct StaMessage {           // M2 / M4: MIC + EAPOL completo
+        uint64_t replay_counter;
+        uint32_t timestamp_ms;
+        uint8_t valid;
+        uint8_t key_version;
+        uint16_t eapol_len;
+        uint8_t mic[16];
+        uint8_t eapol[256];       // MIC já zerado
+    };
+
+    struct Session {
+        uint8_t written_rank;     // melhor par já gravado (0 = nenhum)
+        uint8_t complete;         // par autorizado gravado
+        ApMessage m1;
+        ApMessage m3;
+        StaMessage m2;
+        StaMessage m4;
+    };
+
+    typedef MacTable<12, Session> SessionTable;
+
+    static size_t storage_bytes(uint32_t capacity) {
+        return SessionTable::storage_bytes(capacity);
+    }
+
+    bool begin(void* storage, uint32_t capacity) {
+        return sessions.begin(storage, capacity);
+    }
+
+    // Registra a mensagem. Retorna true se `out` recebeu um par melhor do
+    // que o já gravado para este AP/STA.
+    bool on_message(const EapolKeyMessage& msg, Handshake* out);
+
+    // Informa que o par `hs` foi persistido. Retorna HS_WRITTEN_* conforme
+    // esta gravação foi a primeira do par e/ou o completou.
+    uint8_t mark_written(const Handshake& hs);
+
+    // Pares ainda não gravados de um AP (ex.: aguardando o SSID). Chama
+    // `fn(const Handshake&)` para cada um.
+    template <typename Fn>
+    void for_each_pending(const uint8_t* ap, Fn fn);
+
+    uint32_t active_sessions() const { return sessions.size(); }
+
+    // M2/M4 recusadas por terem EAPOL maior que StaMessage::eapol
+    uint32_t oversize_frames() const { return oversize; }
+
+private:
+    SessionTable sessions;
+    uint32_t oversize = 0;
+
+    static bool best_pair(const uint8_t* key, const Session& s, Handshake* out);
+    static uint8_t rank_of(uint8_t message_pair);
+};
+
+template <typename Fn>
+void HandshakeTracker::for_each_pending(const uint8_t* ap, Fn fn) {
+    sessions.for_each([&](const uint8_t* key, Session& s) {
+        if (s.complete || memcmp(key, ap, 6) != 0) return;
+        Handshake hs;
+        if (best_pair(key, s, &hs) && rank_of(hs.message_pair) > s.written_rank) {
+            fn(hs);
+        }
+    });
+}
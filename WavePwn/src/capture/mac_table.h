@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Tabela hash de capacidade fixa, endereçamento aberto, chave = bytes crus
+// de MAC (6 bytes para BSSID, 12 para o par AP+STA).
+//
+// - Nenhuma alocação depois de begin(): a memória (PSRAM) vem do chamador.
+// - Sondagem linear limitada a `max_probe` slots: busca e inserção O(1).
+//   Com a janela padrão (32) praticamente não há despejos até ~70% de ocupação.
+// - Quando a janela de sondagem está cheia, a inserção reaproveita o slot
+//   usado há mais tempo dentro da janela (LRU aproximado). Como a entrada é
+//   substituída no lugar, nunca surgem buracos e não há tombstones.
+// - Sem locks: cada tabela deve ser usada por uma única task.
+
+template <size_t KeyLen, typename Value>
+class MacTable {
+public:
+    struct Entry {
+        uint32_t last_used;   // 0 = slot vazio
+        uint8_t  key[KeyLen];
+        Value    value;
+    };
+
+    // Bytes necessários para `capacity` entradas (potência de 2).
+    static size_t storage_bytes(uint32_t capacity) {
+        return (size_t)capacity * sizeof(Entry);
+    }
+
+    bool begin(void* storage, uint32_t capacity, uint32_t probe = 32) {
+        if (!storage || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            return false;
+        }
+        entries = static_cast<Entry*>(storage);
+        mask = capacity - 1;
+        max_probe = probe < capacity ? probe : capacity;
+        clear();
+        return true;
+    }
+
+    void clear() {
+        if (!entries) return;
+        memset(static_cast<void*>(entries), 0, storage_bytes(mask + 1));
+        clock = 0;
+        count = 0;
+        evictions = 0;
+    }
+
+    // Retorna o valor associado à chave (e marca como recém-usado) ou nullptr.
+    Value* find(const uint8_t* key) {
+        if (!entries) return nullptr;
+        uint32_t idx = hash(key) & mask;
+        for (uint32_t i = 0; i < max_probe; ++i) {
+            Entry& e = entries[(idx + i) & mask];
+            if (e.last_used == 0) return nullptr;
+            if (memcmp(e.key, key, KeyLen) == 0) {
+                e.last_used = tick();
+                return &e.value;
+            }
+        }
+        return nullptr;
+    }
+
+    bool contains(const uint8_t* key) { return find(key) != nullptr; }
+
+    // Retorna o valor da chave, criando (zerado) se ainda não existir.
+    // `created` indica se a entrada é nova. Só falha antes de begin().
+    Value* insert(const uint8_t* key, bool* created = nullptr) {
+        return insert(key, created, [](const uint8_t*, const Value&) {});
+    }
+
+    // Igual ao anterior; `on_evict(key, value)` é chamado com a entrada que
+    // vai ser despejada para abrir espaço (agregados incrementais).
+    template <typename EvictFn>
+    Value* insert(const uint8_t* key, bool* created, EvictFn on_evict) {
+        if (created) *created = false;
+        if (!entries) return nullptr;
+
+        uint32_t idx = hash(key) & mask;
+        Entry* victim = nullptr;
+        for (uint32_t i = 0; i < max_probe; ++i) {
+            Entry& e = entries[(idx + i) & mask];
+            if (e.last_used == 0) {
+                victim = &e;
+                count++;
+                break;
+            }
+            if (memcmp(e.key, key, KeyLen) == 0) {
+                e.last_used = tick();
+                return &e.value;
+            }
+            if (!victim || e.last_used < victim->last_used) {
+                victim = &e;
+            }
+        }
+
+        if (victim->last_used != 0) {
+            evictions++;
+            on_evict(victim->key, victim->value);
+        }
+        memcpy(victim->key, key, KeyLen);
+        memset(static_cast<void*>(&victim->value), 0, sizeof(Value));
+        victim->last_used = tick();
+        if (created) *created = true;
+        return &victim->value;
+    }
+
+    // Visita todas as entradas ocupadas (sem alterar a ordem LRU).
+    template <typename Fn>
+    void for_each(Fn fn) {
+        if (!entries) return;
+        for (uint32_t i = 0; i <= mask; ++i) {
+            if (entries[i].last_used != 0) {
+                fn(entries[i].key, entries[i].value);
+            }
+        }
+    }
+
+    uint32_t size() const { return count; }
+    uint32_t capacity() const { return entries ? mask + 1 : 0; }
+    uint32_t total_evictions() const { return evictions; }
+
+private:
+    Entry* entries = nullptr;
+    uint32_t mask = 0;
+    uint32_t max_probe = 0;
+    uint32_t clock = 0;
+    uint32_t count = 0;
+    uint32_t evictions = 0;
+
+    uint32_t tick() {
+        // Relógio lógico de acessos (0 é reservado para "vazio").
+        if (++clock == 0) {
+            age_all();
+        }
+        return clock;
+    }
+
+    void age_all() {
+        // Wrap do relógio (2^32 acessos): recomeça a contagem mantendo
+        // todas as entradas vivas com a mesma idade.
+        for (uint32_t i = 0; i <= mask; ++i) {
+            if (entries[i].last_used != 0) entries[i].last_used = 1;
+        }
+        clock = 2;
+    }
+
+    static uint32_t hash(const uint8_t* key) {
+        // FNV-1a + finalizador (murmur3 fmix32)
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < KeyLen; ++i) {
+            h ^= key[i];
+            h *= 16777619u;
+        }
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+};
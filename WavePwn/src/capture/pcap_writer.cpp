@@ -0,0 +1,443 @@
+#include "capture/pcap_writer.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#include "storage.h"
+
+// pcapng (https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-02.html)
+static const uint32_t PCAPNG_BLOCK_SHB = 0x0A0D0D0A;
+static const uint32_t PCAPNG_BLOCK_IDB = 0x00000001;
+static const uint32_t PCAPNG_BLOCK_EPB = 0x00000006;
+static const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+static const uint16_t LINKTYPE_IEEE802_11_RADIOTAP = 127;
+
+// Radiotap fixo de 16 bytes: Flags, Rate, Channel, dBm signal, dBm noise.
+static const uint16_t RADIOTAP_LEN = 16;
+static const uint32_t RADIOTAP_PRESENT = (1u << 1) | (1u << 2) | (1u << 3) |
+                                         (1u << 5) | (1u << 6);
+static const uint8_t  RADIOTAP_F_FCS = 0x10;        // frame termina com FCS
+static const uint16_t RADIOTAP_CHAN_2GHZ = 0x0080;
+
+// wifi_phy_rate_t (legacy) -> unidades de 500 kbps. 0 = desconhecido/HT.
+static const uint8_t PHY_RATE_500K[16] = {
+    2, 4, 11, 22,      // 0x0-0x3: 1, 2, 5.5, 11 Mbps (long preamble)
+    0, 4, 11, 22,      // 0x5-0x7: 2, 5.5, 11 Mbps (short preamble)
+    96, 48, 24, 12,    // 0x8-0xB: 48, 24, 12, 6 Mbps
+    108, 72, 36, 18    // 0xC-0xF: 54, 36, 18, 9 Mbps
+};
+
+static inline void put_u16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void put_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+
+static inline uint32_t pad4(uint32_t len) { return (len + 3) & ~3u; }
+
+bool PcapWriter::begin(size_t buf_size, uint32_t sync_ms, uint32_t sync_b) {
+    sync_interval_ms = sync_ms;
+    sync_bytes = sync_b;
+
+    // Buffers múltiplos do setor para que cada write completo seja alinhado.
+    buf_size -= buf_size % PCAP_WRITER_SECTOR_SIZE;
+    if (buf_size == 0) {
+        buf_size = PCAP_WRITER_SECTOR_SIZE;
+    }
+
+    // RAM interna com DMA: o SDMMC grava direto deles (da PSRAM, o driver
+    // copiaria setor a setor para um buffer próprio)
+    for (int i = 0; i < 2; ++i) {
+        buffers[i] = (uint8_t*)storage_dma_alloc(buf_size);
+    }
+    if (!buffers[0] || !buffers[1]) {
+        heap_caps_free(buffers[0]);
+        heap_caps_free(buffers[1]);
+        buffers[0] = buffers[1] = nullptr;
+        Serial.println("[PCAP] Sem memoria para buffers, usando escrita direta");
+        return false;
+    }
+    buffer_size = buf_size;
+
+    free_buffer = xSemaphoreCreateBinary();
+    if (!free_buffer) {
+        heap_caps_free(buffers[0]);
+        heap_caps_free(buffers[1]);
+        buffers[0] = buffers[1] = nullptr;
+        buffer_size = 0;
+        Serial.println("[PCAP] Falha ao criar semaforo, usando escrita direta");
+        return false;
+    }
+    // Começamos enchendo o buffer 0; o buffer 1 está livre.
+    xSemaphoreGive(free_buffer);
+
+    Serial.printf("[PCAP] Escritor em lote: 2 x %u KB, fsync a cada %lu ms\n",
+                  (unsigned)(buffer_size / 1024),
+                  (unsigned long)sync_interval_ms);
+    return true;
+}
+
+bool PcapWriter::open(const char* path, PcapFormat format) {
+    close();
+
+    struct OpenCtx {
+        PcapWriter* writer;
+        const char* path;
+    } ctx = {this, path};
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, [](void* arg) {
+        OpenCtx* c = (OpenCtx*)arg;
+        c->writer->file = SDCARD.open(c->path, FILE_WRITE);
+        // Buffer do stdio de um setor: o que sobra de um write fecha o setor
+        // seguinte, e o resto dos nossos buffers vai direto para o FATFS
+        if (c->writer->file) c->writer->file.setBufferSize(PCAP_WRITER_SECTOR_SIZE);
+    }, &ctx);
+    if (!file) {
+        return false;
+    }
+    file_open = true;
+    file_size = 0;
+    submitted = 0;
+    fill = 0;
+    dirty = false;
+    bytes_since_sync = 0;
+    update_fill_limit();
+
+    file_format = format;
+    memset(channel_interface, NO_INTERFACE, sizeof(channel_interface));
+    next_interface = 0;
+
+    if (file_format == PCAP_FORMAT_PCAPNG) {
+        write_pcapng_shb();
+    } else {
+        write_legacy_header();
+    }
+    return true;
+}
+
+void PcapWriter::close() {
+    if (!file_open) return;
+
+    if (buffered()) {
+        submit_active(true);
+        drain();
+    } else {
+        file_sync();
+    }
+
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, [](void* arg) {
+        static_cast<PcapWriter*>(arg)->file.close();
+    }, this);
+    file_open = false;
+    dirty = false;
+}
+
+void PcapWriter::sync() {
+    if (!file_open || !dirty) return;
+
+    if (buffered()) {
+        submit_active(true);
+        drain();
+    } else {
+        file_sync();
+        bytes_since_sync = 0;
+        dirty = false;
+    }
+}
+
+bool PcapWriter::write_packet(const PcapPacketInfo& info,
+                              const uint8_t* data,
+                              uint32_t caplen) {
+    if (!file_open) return false;
+
+    if (file_format == PCAP_FORMAT_LEGACY) {
+        uint32_t ts_sec = (uint32_t)(info.timestamp_us / 1000000ULL);
+        uint32_t ts_usec = (uint32_t)(info.timestamp_us % 1000000ULL);
+
+        // Cabeçalho por pacote
+        uint8_t header[16];
+        put_u32(header + 0, ts_sec);
+        put_u32(header + 4, ts_usec);
+        put_u32(header + 8, caplen);
+        put_u32(header + 12, info.orig_len);
+
+        write_bytes(header, sizeof(header));
+        write_bytes(data, caplen);
+        stats.records++;
+        return true;
+    }
+
+    // Enhanced Packet Block: cabeçalho (28) + radiotap + frame + pad + trailer (4)
+    uint32_t iface = pcapng_interface_for(info.channel);
+    uint32_t cap = RADIOTAP_LEN + caplen;
+    uint32_t total = 28 + pad4(cap) + 4;
+
+    uint8_t hdr[28 + RADIOTAP_LEN];
+    put_u32(hdr + 0, PCAPNG_BLOCK_EPB);
+    put_u32(hdr + 4, total);
+    put_u32(hdr + 8, iface);
+    put_u32(hdr + 12, (uint32_t)(info.timestamp_us >> 32));
+    put_u32(hdr + 16, (uint32_t)(info.timestamp_us & 0xFFFFFFFFu));
+    put_u32(hdr + 20, cap);
+    put_u32(hdr + 24, RADIOTAP_LEN + info.orig_len);
+
+    uint8_t* rt = hdr + 28;
+    rt[0] = 0;                                   // it_version
+    rt[1] = 0;                                   // it_pad
+    put_u16(rt + 2, RADIOTAP_LEN);
+    put_u32(rt + 4, RADIOTAP_PRESENT);
+    // Flags: sig_len inclui o FCS, mas num frame cortado (caplen < orig_len)
+    // os 4 bytes finais não são o FCS
+    rt[8] = caplen < info.orig_len ? 0 : RADIOTAP_F_FCS;
+    rt[9] = PHY_RATE_500K[info.rate & 0x0F];     // Rate
+    uint16_t freq = 0;
+    if (info.channel == 14) {
+        freq = 2484;
+    } else if (info.channel >= 1 && info.channel <= 13) {
+        freq = 2407 + 5 * info.channel;
+    }
+    put_u16(rt + 10, freq);                      // Channel: frequência
+    put_u16(rt + 12, RADIOTAP_CHAN_2GHZ);        // Channel: flags
+    rt[14] = (uint8_t)info.rssi;                 // dBm antenna signal
+    rt[15] = (uint8_t)info.noise_floor;          // dBm antenna noise
+
+    static const uint8_t zeros[4] = {0, 0, 0, 0};
+    uint8_t trailer[4];
+    put_u32(trailer, total);
+
+    write_bytes(hdr, sizeof(hdr));
+    write_bytes(data, caplen);
+    write_bytes(zeros, pad4(cap) - cap);
+    write_bytes(trailer, sizeof(trailer));
+    stats.records++;
+    return true;
+}
+
+void PcapWriter::poll() {
+    if (!file_open || !dirty) return;
+    if (millis() - dirty_since_ms < sync_interval_ms) return;
+
+    if (buffered()) {
+        submit_active(true);
+    } else {
+        file_sync();
+        bytes_since_sync = 0;
+        dirty = false;
+    }
+}
+
+void PcapWriter::get_stats(PcapWriterStats* out) const {
+    if (!out) return;
+    *out = stats;
+}
+
+// -----------------------------------------------------------------------------
+// Internos
+// -----------------------------------------------------------------------------
+
+void PcapWriter::write_legacy_header() {
+    // Cabeçalho PCAP clássico little-endian, linktype = IEEE802_11 (105)
+    static const uint8_t header[24] = {
+        0xd4, 0xc3, 0xb2, 0xa1, // magic number (little endian)
+        0x02, 0x00,             // version major
+        0x04, 0x00,             // version minor
+        0x00, 0x00, 0x00, 0x00, // thiszone
+        0x00, 0x00, 0x00, 0x00, // sigfigs
+        0xff, 0xff, 0x00, 0x00, // snaplen
+        0x69, 0x00, 0x00, 0x00  // network = 105 (LINKTYPE_IEEE802_11)
+    };
+    write_bytes(header, sizeof(header));
+}
+
+void PcapWriter::write_pcapng_shb() {
+    // Section Header Block com shb_hardware e shb_userappl
+    static const char hw[] = "ESP32-S3";        // 8 bytes, sem padding
+    static const char app[] = "WavePwn";        // 7 bytes + 1 de padding
+    const uint32_t total = 28 + (4 + 8) + (4 + 8) + 4 + 4;
+
+    uint8_t b[total];
+    memset(b, 0, sizeof(b));
+    put_u32(b + 0, PCAPNG_BLOCK_SHB);
+    put_u32(b + 4, total);
+    put_u32(b + 8, PCAPNG_BYTE_ORDER_MAGIC);
+    put_u16(b + 12, 1);                          // major
+    put_u16(b + 14, 0);                          // minor
+    memset(b + 16, 0xFF, 8);                     // section length: desconhecido
+
+    uint8_t* opt = b + 24;
+    put_u16(opt + 0, 2);                         // shb_hardware
+    put_u16(opt + 2, sizeof(hw) - 1);
+    memcpy(opt + 4, hw, sizeof(hw) - 1);
+    opt += 12;
+    put_u16(opt + 0, 4);                         // shb_userappl
+    put_u16(opt + 2, sizeof(app) - 1);
+    memcpy(opt + 4, app, sizeof(app) - 1);
+    opt += 12;
+    put_u32(opt, 0);                             // opt_endofopt
+    put_u32(b + total - 4, total);
+
+    write_bytes(b, sizeof(b));
+}
+
+uint8_t PcapWriter::pcapng_interface_for(uint8_t channel) {
+    if (channel > 14) channel = 0;
+    if (channel_interface[channel] != NO_INTERFACE) {
+        return channel_interface[channel];
+    }
+
+    // Interface Description Block com if_name "chN" e if_tsresol = 6 (µs)
+    char name[8];
+    int name_len = snprintf(name, sizeof(name), "ch%u", channel);
+    const uint32_t total = 16 + (4 + 8) + (4 + 4) + 4 + 4;
+
+    uint8_t b[total];
+    memset(b, 0, sizeof(b));
+    put_u32(b + 0, PCAPNG_BLOCK_IDB);
+    put_u32(b + 4, total);
+    put_u16(b + 8, LINKTYPE_IEEE802_11_RADIOTAP);
+    put_u16(b + 10, 0);                          // reserved
+    put_u32(b + 12, 0);                          // snaplen: sem limite
+
+    uint8_t* opt = b + 16;
+    put_u16(opt + 0, 2);                         // if_name
+    put_u16(opt + 2, (uint16_t)name_len);
+    memcpy(opt + 4, name, name_len);
+    opt += 12;
+    put_u16(opt + 0, 9);                         // if_tsresol
+    put_u16(opt + 2, 1);
+    opt[4] = 6;
+    opt += 8;
+    put_u32(opt, 0);                             // opt_endofopt
+    put_u32(b + total - 4, total);
+
+    write_bytes(b, sizeof(b));
+
+    channel_interface[channel] = next_interface++;
+    return channel_interface[channel];
+}
+
+void PcapWriter::write_bytes(const uint8_t* data, size_t len) {
+    if (len == 0) return;
+
+    if (!dirty) {
+        dirty = true;
+        dirty_since_ms = millis();
+    }
+    file_size += len;
+
+    if (!buffered()) {
+        file_write(data, len);
+        bytes_since_sync += len;
+        if (bytes_since_sync >= sync_bytes) {
+            file_sync();
+            bytes_since_sync = 0;
+            dirty = false;
+        }
+        return;
+    }
+
+    // Registros podem atravessar a fronteira entre buffers: o arquivo é só
+    // um fluxo de bytes, então dividimos sem problema.
+    while (len > 0) {
+        size_t room = fill_limit - fill;
+        size_t n = len < room ? len : room;
+        memcpy(buffers[active] + lead + fill, data, n);
+        fill += n;
+        data += n;
+        len -= n;
+
+        if (fill == fill_limit) {
+            submit_active(false);
+        }
+    }
+}
+
+void PcapWriter::submit_active(bool force_sync) {
+    bytes_since_sync += fill;
+    bool sync = force_sync || bytes_since_sync >= sync_bytes;
+
+    if (fill > 0) {
+        // Precisamos do outro buffer livre antes de trocar.
+        if (xSemaphoreTake(free_buffer, 0) != pdTRUE) {
+            uint32_t start = micros();
+            xSemaphoreTake(free_buffer, portMAX_DELAY);
+            uint32_t waited = micros() - start;
+            stats.stalls++;
+            if (waited > stats.max_stall_us) {
+                stats.max_stall_us = waited;
+            }
+        }
+
+        // Fila de captura cheia (improvável: dois buffers de 16 KB): grava
+        // esperando, que é o mesmo que um stall
+        WriteJob& job = write_jobs[active];
+        job.writer = this;
+        job.data = buffers[active] + lead;
+        job.len = (uint32_t)fill;
+        if (!storage_submit(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE,
+                            write_job, &job, release_job)) {
+            storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, write_job, &job);
+            release_job(&job);
+            stats.stalls++;
+        }
+
+        submitted += fill;
+        active ^= 1;
+        fill = 0;
+        update_fill_limit();
+    }
+
+    if (sync) {
+        if (!storage_submit(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, sync_job, this)) {
+            file_sync();
+        }
+        bytes_since_sync = 0;
+        dirty = false;
+    }
+}
+
+// A fila de captura é FIFO: quando este job roda, os anteriores já rodaram
+void PcapWriter::drain() {
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, [](void*) {}, nullptr);
+}
+
+void PcapWriter::update_fill_limit() {
+    // Depois de um flush parcial (por tempo), o próximo buffer é encurtado
+    // para que o write seguinte termine de novo numa fronteira de setor. Os
+    // dados começam em `lead`, não no início: a próxima fronteira de setor
+    // do arquivo cai em buffers[active] + 512, alinhada para o DMA.
+    lead = (size_t)(submitted % PCAP_WRITER_SECTOR_SIZE);
+    fill_limit = buffer_size - lead;
+}
+
+// Modo direto: cada write é um job (espera terminar)
+void PcapWriter::file_write(const uint8_t* data, size_t len) {
+    WriteJob job = {this, data, (uint32_t)len};
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, write_job, &job);
+}
+
+void PcapWriter::file_sync() {
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, sync_job, this);
+}
+
+// Jobs da task sd
+
+void PcapWriter::write_job(void* arg) {
+    WriteJob* job = static_cast<WriteJob*>(arg);
+    PcapWriter* w = job->writer;
+    size_t n = w->file.write(job->data, job->len);
+    storage_account(0, n);
+    w->stats.sd_writes++;
+    w->stats.bytes_written += n;
+    if (n != job->len) {
+        Serial.printf("[PCAP] Escrita curta no SD (%u de %lu bytes)\n",
+                      (unsigned)n,
+                      (unsigned long)job->len);
+    }
+}
+
+void PcapWriter::release_job(void* arg) {
+    xSemaphoreGive(static_cast<WriteJob*>(arg)->writer->free_buffer);
+}
+
+void PcapWriter::sync_job(void* arg) {
+    PcapWriter* w = static_cast<PcapWriter*>(arg);
+    w->file.flush();
+    w->stats.syncs++;
+}
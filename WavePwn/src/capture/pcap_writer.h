@@ -0,0 +1,149 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Escritor PCAP em lote para o microSD.
+//
+// Os registros são acumulados em dois buffers (RAM interna com DMA,
+// storage_dma_alloc): enquanto um enche, o outro é gravado pela task "sd"
+// (storage.h, fila de captura, a mais prioritária). Cada escrita no SD é
+// de um buffer inteiro, terminando numa fronteira de setor e com os setores
+// inteiros alinhados na memória, em vez de dois writes minúsculos por frame.
+// O fsync segue uma política de tempo/tamanho: nenhum dado fica mais de
+// `sync_interval_ms` só em RAM.
+//
+// Dois formatos de saída:
+//   - PCAP clássico (LINKTYPE 105), compatível com o legado;
+//   - pcapng com radiotap (LINKTYPE 127): timestamp em µs, canal, RSSI,
+//     ruído e taxa por pacote, e uma interface (IDB) por canal.
+
+// 2 x 16 KB de RAM interna. Na PSRAM o driver do SDMMC grava setor a setor
+// (um comando por 512 bytes) e, no modelo do native_storage (700 KB/s de
+// captura, 250 us por comando), a fila sd satura: logs esperam ~370 ms e
+// downloads caem para 18 KB/s. Com 16 KB em vez de 32 KB a captura espera
+// mais vezes (95 esperas em 10 s contra 18, a maior de ~40 ms, que o
+// FrameRing absorve), mas sobram 32 KB de RAM interna.
+#define PCAP_WRITER_BUFFER_SIZE      (16 * 1024)
+#define PCAP_WRITER_SECTOR_SIZE      512
+#define PCAP_WRITER_SYNC_INTERVAL_MS 1000
+#define PCAP_WRITER_SYNC_BYTES       (256 * 1024)
+
+enum PcapFormat : uint8_t {
+    PCAP_FORMAT_LEGACY = 0,   // .pcap, 802.11 puro
+    PCAP_FORMAT_PCAPNG = 1,   // .pcapng, radiotap + IDB por canal
+};
+
+// Metadados de rádio de um frame (vindos de wifi_promiscuous_pkt_t::rx_ctrl).
+struct PcapPacketInfo {
+    uint64_t timestamp_us;   // esp_timer_get_time() no RX
+    uint32_t orig_len;       // tamanho original no ar
+    uint8_t  channel;        // 0 = desconhecido
+    int8_t   rssi;           // dBm
+    int8_t   noise_floor;    // dBm
+    uint8_t  rate;           // índice wifi_phy_rate_t (legacy)
+};
+
+struct PcapWriterStats {
+    uint64_t bytes_written;   // bytes entregues ao SD
+    uint32_t records;         // pacotes gravados
+    uint32_t sd_writes;       // chamadas File::write
+    uint32_t syncs;           // chamadas File::flush (fsync)
+    uint32_t stalls;          // vezes que o produtor esperou um buffer livre
+    uint32_t max_stall_us;    // maior espera do produtor
+};
+
+class PcapWriter {
+public:
+    // Aloca os buffers. Se não houver memória, o escritor continua
+    // funcionando em modo direto (um job de write por registro).
+    bool begin(size_t buffer_size = PCAP_WRITER_BUFFER_SIZE,
+               uint32_t sync_interval_ms = PCAP_WRITER_SYNC_INTERVAL_MS,
+               uint32_t sync_bytes = PCAP_WRITER_SYNC_BYTES);
+
+    // Fecha o arquivo atual (drenando os buffers) e abre `path`, já com o
+    // cabeçalho global (PCAP) ou Section Header Block (pcapng) escrito.
+    bool open(const char* path, PcapFormat format = PCAP_FORMAT_LEGACY);
+
+    // Grava tudo o que estiver pendente, faz fsync e fecha o arquivo.
+    void close();
+
+    // Como close(), mas mantém o arquivo aberto.
+    void sync();
+
+    bool is_open() const { return file_open; }
+    PcapFormat format() const { return file_format; }
+
+    // Um pacote: registro PCAP (16 bytes + frame) ou Enhanced Packet Block
+    // (radiotap + frame), conforme o formato do arquivo aberto.
+    bool write_packet(const PcapPacketInfo& info,
+                      const uint8_t* data,
+                      uint32_t caplen);
+
+    // Aplica a política de fsync por tempo. Chamar periodicamente a partir
+    // da mesma task que escreve os registros.
+    void poll();
+
+    // Tamanho lógico do arquivo atual (inclui o que ainda está em RAM).
+    uint64_t size() const { return file_size; }
+
+    void get_stats(PcapWriterStats* out) const;
+
+private:
+    // Job de gravação de um buffer (no máximo um pendente por buffer)
+    struct WriteJob {
+        PcapWriter* writer;
+        const uint8_t* data;
+        uint32_t len;
+    };
+
+    File file;
+    bool file_open = false;
+    PcapFormat file_format = PCAP_FORMAT_LEGACY;
+
+    // pcapng: interface (IDB) já emitida para cada canal 0..14
+    static const uint8_t NO_INTERFACE = 0xFF;
+    uint8_t channel_interface[15];
+    uint8_t next_interface = 0;
+
+    uint8_t* buffers[2] = {nullptr, nullptr};
+    size_t buffer_size = 0;
+    uint8_t active = 0;
+    size_t lead = 0;              // bytes sem dados no início do buffer ativo
+    size_t fill = 0;
+    size_t fill_limit = 0;
+
+    uint32_t sync_interval_ms = PCAP_WRITER_SYNC_INTERVAL_MS;
+    uint32_t sync_bytes = PCAP_WRITER_SYNC_BYTES;
+    bool dirty = false;               // há bytes ainda sem fsync
+    uint32_t dirty_since_ms = 0;      // millis() do primeiro deles
+    uint32_t bytes_since_sync = 0;
+
+    uint64_t file_size = 0;       // bytes lógicos (RAM + SD)
+    uint64_t submitted = 0;       // bytes já entregues à task sd
+
+    SemaphoreHandle_t free_buffer = nullptr;  // o buffer inativo está livre
+    WriteJob write_jobs[2];
+
+    PcapWriterStats stats = {};
+
+    bool buffered() const { return free_buffer != nullptr; }
+    void write_bytes(const uint8_t* data, size_t len);
+    void write_legacy_header();
+    void write_pcapng_shb();
+    uint8_t pcapng_interface_for(uint8_t channel);
+    void submit_active(bool sync);
+    void drain();
+    void update_fill_limit();
+    void file_write(const uint8_t* data, size_t len);
+    void file_sync();
+
+    static void write_job(void* arg);
+    static void release_job(void* arg);
+    static void sync_job(void* arg);
+};
@@ -0,0 +1,354 @@
+#include "capture/session_log.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "storage.h"
+#include "utils/crc32.h"
+
+static const char SESSION_MAGIC[4] = {'W', 'P', 'S', 'L'};
+
+static uint8_t copy_ssid(char* dst, const char* ssid, size_t n) {
+    if (!ssid) n = 0;
+    if (n > 32) n = 32;
+    memset(dst, 0, 32);
+    memcpy(dst, ssid, n);
+    return (uint8_t)n;
+}
+
+// -----------------------------------------------------------------------------
+// Escritor
+// -----------------------------------------------------------------------------
+
+uint32_t SessionLog::parse_file_id(const char* name) {
+    if (!name) return 0;
+    const char* base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+
+    if (strncmp(base, "session_", 8) != 0) return 0;
+    char* end = nullptr;
+    unsigned long v = strtoul(base + 8, &end, 10);
+    if (!end || strcmp(end, ".bin") != 0) return 0;
+    return (uint32_t)v;
+}
+
+bool SessionLog::begin(const char* dir) {
+    close();
+
+    if (!buffered()) {
+        for (int i = 0; i < 2; ++i) {
+            buffers[i] = (uint8_t*)storage_dma_alloc(SESSION_LOG_BUFFER_SIZE);
+        }
+        if (buffers[0] && buffers[1]) {
+            free_buffer = xSemaphoreCreateBinary();
+        }
+        if (free_buffer) {
+            // Começamos enchendo o buffer 0; o buffer 1 está livre.
+            xSemaphoreGive(free_buffer);
+        } else {
+            heap_caps_free(buffers[0]);
+            heap_caps_free(buffers[1]);
+            buffers[0] = buffers[1] = nullptr;
+            Serial.println("[SESSION] Sem memoria para buffers, usando escrita direta");
+        }
+    }
+
+    struct OpenCtx {
+        SessionLog* log;
+        const char* dir;
+        bool ok;
+    } ctx = {this, dir, false};
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, [](void* arg) {
+        OpenCtx* c = (OpenCtx*)arg;
+        c->ok = c->log->open_file(c->dir);
+    }, &ctx);
+    return ctx.ok;
+}
+
+// Na task sd
+bool SessionLog::open_file(const char* dir) {
+    // Próximo id = maior id existente + 1 (uma listagem do diretório por boot)
+    uint32_t last_id = 0;
+    File root = SDCARD.open(dir);
+    if (root && root.isDirectory()) {
+        File f = root.openNextFile();
+        while (f) {
+            uint32_t fid = parse_file_id(f.name());
+            if (fid > last_id) last_id = fid;
+            f.close();
+            f = root.openNextFile();
+        }
+    }
+    if (root) root.close();
+    id = last_id + 1;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/session_%05lu.bin", dir, (unsigned long)id);
+    file = SDCARD.open(path, FILE_WRITE);
+    if (!file) {
+        Serial.printf("[SESSION] ERRO ao criar %s\n", path);
+        return false;
+    }
+    // Como no PcapWriter: o stdio só completa setores, o resto vai direto
+    file.setBufferSize(STORAGE_SECTOR_SIZE);
+
+    SessionFileHeader hdr = {};
+    memcpy(hdr.magic, SESSION_MAGIC, 4);
+    hdr.version = SESSION_LOG_VERSION;
+    hdr.header_len = sizeof(SessionFileHeader);
+    hdr.session_id = id;
+    time_t now = time(nullptr);
+    hdr.start_epoch = now > 1600000000 ? (uint32_t)now : 0;  // RTC não ajustado
+
+    if (file.write((const uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+        Serial.printf("[SESSION] ERRO ao gravar cabecalho em %s\n", path);
+        file.close();
+        return false;
+    }
+    file.flush();
+    storage_account(0, sizeof(hdr));
+    file_open = true;
+    active = 0;
+    fill = 0;
+
+    Serial.printf("[SESSION] Log de sessao: %s\n", path);
+    return true;
+}
+
+void SessionLog::close() {
+    if (!file_open) return;
+    sync();
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, [](void* arg) {
+        static_cast<SessionLog*>(arg)->file.close();
+    }, this);
+    file_open = false;
+}
+
+bool SessionLog::append(SessionRecordType type, const void* payload, uint16_t len,
+                        const void* tail, uint16_t tail_len) {
+    uint32_t payload_len = (uint32_t)len + tail_len;
+    if (!file_open || payload_len > SESSION_LOG_MAX_PAYLOAD) {
+        stats.dropped++;
+        return false;
+    }
+
+    uint8_t rec[sizeof(SessionRecordHeader) + SESSION_LOG_MAX_PAYLOAD + 4];
+    SessionRecordHeader* hdr = (SessionRecordHeader*)rec;
+    hdr->len = (uint16_t)payload_len;
+    hdr->type = type;
+    hdr->flags = 0;
+
+    size_t n = sizeof(SessionRecordHeader);
+    memcpy(rec + n, payload, len);
+    n += len;
+    if (tail_len) {
+        memcpy(rec + n, tail, tail_len);
+        n += tail_len;
+    }
+    uint32_t crc = crc32_update(0, rec, n);
+    memcpy(rec + n, &crc, 4);
+    n += 4;
+
+    if (!buffered()) {
+        // Sem buffers: um write por registro (ainda sem open/close por evento)
+        if (!file_write(rec, n, false)) {
+            stats.dropped++;
+            return false;
+        }
+    } else {
+        // Buffer cheio e o outro ainda sendo gravado: perde o registro em
+        // vez de travar a task de captura (que consome o FrameRing)
+        if (fill + n > SESSION_LOG_BUFFER_SIZE && !submit_active(false)) {
+            stats.dropped++;
+            return false;
+        }
+        if (fill == 0) {
+            pending_since_ms = millis();
+        }
+        memcpy(buffers[active] + fill, rec, n);
+        fill += n;
+    }
+
+    stats.records++;
+    stats.bytes += n;
+    return true;
+}
+
+// Entrega o buffer ativo à task sd e passa a encher o outro. Não espera:
+// se o outro buffer ainda não voltou (ou a fila de captura está cheia),
+// retorna false e o buffer ativo fica como está.
+bool SessionLog::submit_active(bool flush) {
+    if (fill == 0) return true;
+    if (xSemaphoreTake(free_buffer, 0) != pdTRUE) return false;
+
+    WriteJob& job = write_jobs[active];
+    job.log = this;
+    job.data = buffers[active];
+    job.len = fill;
+    job.flush = flush;
+    job.written = 0;
+    if (!storage_submit(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE,
+                        write_job, &job, release_job)) {
+        xSemaphoreGive(free_buffer);
+        return false;
+    }
+    active ^= 1;
+    fill = 0;
+    return true;
+}
+
+// A fila de captura é FIFO: quando este job roda, os anteriores já rodaram
+void SessionLog::drain() {
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, [](void*) {}, nullptr);
+}
+
+// Modo direto: um job na fila de captura, esperando terminar
+bool SessionLog::file_write(const uint8_t* data, size_t len, bool flush) {
+    WriteJob job = {this, data, len, flush, 0};
+    storage_call(STORAGE_PRIO_CAPTURE, STORAGE_CLIENT_CAPTURE, write_job, &job);
+    return job.written == len;
+}
+
+void SessionLog::sync() {
+    if (!file_open) return;
+
+    // Só aqui (e no close) a task de captura espera a task sd: o drain
+    // devolve o outro buffer, então o submit abaixo não falha por ele
+    if (buffered() && fill > 0) {
+        drain();
+        if (submit_active(true)) {
+            drain();
+            return;
+        }
+    }
+    if (buffered()) {
+        file_write(buffers[active], fill, true);
+        fill = 0;
+    } else {
+        file_write(nullptr, 0, true);
+    }
+}
+
+void SessionLog::poll() {
+    if (!file_open || !buffered() || fill == 0) return;
+    if (millis() - pending_since_ms >= SESSION_LOG_SYNC_INTERVAL_MS) {
+        // Outro buffer ainda em voo: tenta de novo no próximo poll
+        submit_active(true);
+    }
+}
+
+// Jobs da task sd
+
+void SessionLog::write_job(void* arg) {
+    WriteJob* job = static_cast<WriteJob*>(arg);
+    SessionLog* log = job->log;
+    if (job->len > 0) {
+        job->written = log->file.write(job->data, job->len);
+        storage_account(0, job->written);
+        log->stats.sd_writes++;
+    }
+    if (job->flush) {
+        log->file.flush();
+        log->stats.syncs++;
+    }
+    if (job->written != job->len) {
+        Serial.printf("[SESSION] ERRO de escrita (%u/%u bytes)\n",
+                      (unsigned)job->written, (unsigned)job->len);
+    }
+}
+
+void SessionLog::release_job(void* arg) {
+    xSemaphoreGive(static_cast<WriteJob*>(arg)->log->free_buffer);
+}
+
+bool SessionLog::append_ap(const uint8_t* bssid, const char* ssid, size_t ssid_len,
+                           uint8_t channel) {
+    SessionApRecord r = {};
+    memcpy(r.bssid, bssid, 6);
+    r.channel = channel;
+    r.ssid_len = copy_ssid(r.ssid, ssid, ssid_len);
+    r.timestamp_ms = millis();
+    return append(SESSION_REC_AP, &r, sizeof(r));
+}
+
+bool SessionLog::append_pmkid(const PMKID& pmkid) {
+    SessionPmkidRecord r = {};
+    memcpy(r.pmkid, pmkid.pmkid, 16);
+    memcpy(r.ap, pmkid.ap, 6);
+    memcpy(r.sta, pmkid.sta, 6);
+    r.ssid_len = copy_ssid(r.ssid, pmkid.ssid, pmkid.ssid_len);
+    r.timestamp_ms = pmkid.timestamp;
+    return append(SESSION_REC_PMKID, &r, sizeof(r));
+}
+
+bool SessionLog::append_handshake(const Handshake& hs, const char* ssid, size_t ssid_len) {
+    SessionHandshakeRecord r = {};
+    memcpy(r.ap, hs.ap, 6);
+    memcpy(r.sta, hs.sta, 6);
+    memcpy(r.anonce, hs.anonce, 32);
+    memcpy(r.mic, hs.mic, 16);
+    r.key_version = hs.key_version;
+    r.message_pair = hs.message_pair;
+    r.authorized = hs.authorized ? 1 : 0;
+    r.ssid_len = copy_ssid(r.ssid, ssid, ssid_len);
+    r.timestamp_ms = hs.timestamp;
+    r.eapol_len = hs.eapol_size > sizeof(hs.eapol) ? sizeof(hs.eapol) : hs.eapol_size;
+    return append(SESSION_REC_HANDSHAKE, &r, sizeof(r), hs.eapol, r.eapol_len);
+}
+
+// -----------------------------------------------------------------------------
+// Leitor
+// -----------------------------------------------------------------------------
+
+bool SessionLogReader::open(const char* path) {
+    close();
+    bad_tail = false;
+
+    file = SDCARD.open(path, FILE_READ);
+    if (!file) return false;
+
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, SESSION_MAGIC, 4) != 0 ||
+        header.version != SESSION_LOG_VERSION ||
+        header.header_len < sizeof(header)) {
+        file.close();
+        return false;
+    }
+    if (header.header_len > sizeof(header)) {
+        file.seek(header.header_len);
+    }
+    return true;
+}
+
+void SessionLogReader::close() {
+    if (file) file.close();
+}
+
+bool SessionLogReader::next(SessionRecordHeader* hdr, uint8_t* payload) {
+    if (!file || bad_tail) return false;
+
+    int n = file.read((uint8_t*)hdr, sizeof(*hdr));
+    if (n == 0) return false;  // fim limpo
+    if (n != (int)sizeof(*hdr) || hdr->len > SESSION_LOG_MAX_PAYLOAD) {
+        bad_tail = true;
+        return false;
+    }
+
+    uint32_t stored_crc = 0;
+    if (file.read(payload, hdr->len) != hdr->len ||
+        file.read((uint8_t*)&stored_crc, 4) != 4) {
+        bad_tail = true;
+        return false;
+    }
+    storage_account(sizeof(*hdr) + hdr->len + 4, 0);
+
+    uint32_t crc = crc32_update(0, hdr, sizeof(*hdr));
+    crc = crc32_update(crc, payload, hdr->len);
+    if (crc != stored_crc) {
+        bad_tail = true;
+        return false;
+    }
+    return true;
+}
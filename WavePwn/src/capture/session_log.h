@@ -0,0 +1,186 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "capture.h"
+
+// Log de sessão binário, append-only, um arquivo por boot.
+//
+// Substitui o SD.open/close por evento (arquivo .16800 por PMKID, JSONL por
+// captura): o arquivo fica aberto durante a sessão e os registros são
+// acumulados em RAM e gravados em bloco com fsync por tempo. Como no
+// PcapWriter, são dois buffers: enquanto um enche, o outro é gravado pela
+// task "sd", sem que a task de captura espere. As
+// linhas 16800/22000 e os JSONL são gerados sob demanda a partir destes
+// arquivos (tools/session_export.py).
+//
+// Layout (little-endian):
+//
+//   SessionFileHeader
+//   { SessionRecordHeader | payload[len] | crc32 } ...
+//
+// O CRC-32 cobre o cabeçalho do registro e o payload. Um registro truncado
+// ou corrompido (queda de energia) encerra a leitura do arquivo: tudo antes
+// dele continua válido.
+
+#define SESSION_LOG_DIR              "/sd/wavepwn/session"
+#define SESSION_LOG_VERSION          1
+#define SESSION_LOG_BUFFER_SIZE      4096
+#define SESSION_LOG_SYNC_INTERVAL_MS 1000
+#define SESSION_LOG_MAX_PAYLOAD      512
+
+enum SessionRecordType : uint8_t {
+    SESSION_REC_AP        = 1,   // BSSID -> SSID aprendido
+    SESSION_REC_PMKID     = 2,
+    SESSION_REC_HANDSHAKE = 3,
+};
+
+#pragma pack(push, 1)
+
+struct SessionFileHeader {
+    char     magic[4];        // "WPSL"
+    uint16_t version;
+    uint16_t header_len;      // sizeof(SessionFileHeader)
+    uint32_t session_id;      // sequencial, igual ao nome do arquivo
+    uint32_t start_epoch;     // time(nullptr) na abertura (0 sem RTC)
+};
+
+struct SessionRecordHeader {
+    uint16_t len;             // bytes de payload
+    uint8_t  type;            // SessionRecordType
+    uint8_t  flags;           // reservado (0)
+};
+
+struct SessionApRecord {
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint8_t  ssid_len;
+    char     ssid[32];
+    uint64_t timestamp_ms;
+};
+
+struct SessionPmkidRecord {
+    uint8_t  pmkid[16];
+    uint8_t  ap[6];
+    uint8_t  sta[6];
+    uint8_t  ssid_len;
+    char     ssid[32];
+    uint64_t timestamp_ms;
+};
+
+// Seguido de `eapol_len` bytes de EAPOL (MIC zerado).
+struct SessionHandshakeRecord {
+    uint8_t  ap[6];
+    uint8_t  sta[6];
+    uint8_t  anonce[32];
+    uint8_t  mic[16];
+    uint8_t  key_version;
+    uint8_t  message_pair;
+    uint8_t  authorized;
+    uint8_t  ssid_len;
+    char     ssid[32];
+    uint64_t timestamp_ms;
+    uint16_t eapol_len;
+};
+
+#pragma pack(pop)
+
+struct SessionLogStats {
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t sd_writes;
+    uint32_t syncs;
+    uint32_t dropped;         // registros perdidos (arquivo fechado / erro /
+                              // os dois buffers ocupados)
+};
+
+// Escritor. Não é thread-safe: usar só a partir da task de captura. O SD
+// em si só é tocado pela task "sd" (storage.h), na fila de captura.
+class SessionLog {
+public:
+    // Cria SESSION_LOG_DIR/session_NNNNN.bin com o próximo id livre.
+    bool begin(const char* dir = SESSION_LOG_DIR);
+    void close();
+
+    bool is_open() const { return file_open; }
+    uint32_t session_id() const { return id; }
+
+    // SSIDs com tamanho explícito: bytes NUL no meio são preservados.
+    bool append_ap(const uint8_t* bssid, const char* ssid, size_t ssid_len,
+                   uint8_t channel);
+    bool append_pmkid(const PMKID& pmkid);
+    bool append_handshake(const Handshake& hs, const char* ssid, size_t ssid_len);
+
+    // Entrega o buffer à task sd (write + fsync) se o registro mais antigo
+    // pendente já passou de SESSION_LOG_SYNC_INTERVAL_MS. Não espera.
+    void poll();
+
+    // Grava o buffer, faz fsync e espera terminar (fim de sessão / flush).
+    void sync();
+
+    void get_stats(SessionLogStats* out) const { *out = stats; }
+
+    // Extrai o id de "session_NNNNN.bin" (0 se o nome não bate).
+    static uint32_t parse_file_id(const char* name);
+
+private:
+    // Job de gravação de um buffer (no máximo um pendente por buffer)
+    struct WriteJob {
+        SessionLog* log;
+        const uint8_t* data;
+        size_t len;
+        bool flush;
+        size_t written;
+    };
+
+    File file;
+    bool file_open = false;
+    uint32_t id = 0;
+
+    uint8_t* buffers[2] = {nullptr, nullptr};
+    uint8_t active = 0;
+    size_t fill = 0;
+    uint32_t pending_since_ms = 0;
+
+    SemaphoreHandle_t free_buffer = nullptr;  // o buffer inativo está livre
+    WriteJob write_jobs[2];
+
+    SessionLogStats stats = {};
+
+    bool buffered() const { return free_buffer != nullptr; }
+    bool append(SessionRecordType type, const void* payload, uint16_t len,
+                const void* tail = nullptr, uint16_t tail_len = 0);
+    bool open_file(const char* dir);
+    bool submit_active(bool flush);
+    void drain();
+    bool file_write(const uint8_t* data, size_t len, bool flush);
+
+    static void write_job(void* arg);
+    static void release_job(void* arg);
+};
+
+// Leitor sequencial (retomada no boot e exportação). Usar dentro de um job
+// da task "sd" (storage.h).
+class SessionLogReader {
+public:
+    bool open(const char* path);
+    void close();
+
+    // Próximo registro válido. `payload` deve ter SESSION_LOG_MAX_PAYLOAD
+    // bytes. Retorna false no fim do arquivo ou no primeiro registro
+    // truncado/corrompido (ver truncated()).
+    bool next(SessionRecordHeader* hdr, uint8_t* payload);
+
+    uint32_t session_id() const { return header.session_id; }
+    bool truncated() const { return bad_tail; }
+
+private:
+    File file;
+    SessionFileHeader header = {};
+    bool bad_tail = false;
+};
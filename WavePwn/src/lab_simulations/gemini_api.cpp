@@ -2,30 +2,17 @@
 
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
-#include <SD.h>
 #include <ArduinoJson.h>
 
-// Caminho do arquivo que armazena a chave de API do Gemini.
-static const char* GEMINI_KEY_PATH = "/config/gemini_key.txt";
+#include "utils/config_store.h"
 
 bool GeminiAPI::has_key() {
-  return SD.exists(GEMINI_KEY_PATH);
+  return read_key().length() > 0;
 }
 
+// /config/gemini_key.txt, lido uma vez no boot pelo ConfigStore
 String GeminiAPI::read_key() {
-  if (!SD.exists(GEMINI_KEY_PATH)) {
-    return String();
-  }
-
-  File f = SD.open(GEMINI_KEY_PATH);
-  if (!f) {
-    return String();
-  }
-
-  String key = f.readStringUntil('\n');
-  f.close();
-  key.trim();
-  return key;
+  return config_store.gemini_key();
 }
 
 String GeminiAPI::extract_text(const String& response) {
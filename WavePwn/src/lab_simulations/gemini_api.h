@@ -8,7 +8,8 @@
   Não deve ser usada para enviar dados pessoais sensíveis ou payloads
   completos de tráfego. Priorize resumos e estatísticas agregadas.
 
-  A chave de API é lida de /config/gemini_key.txt no microSD.
+  A chave de API vem de /config/gemini_key.txt no microSD (em RAM via
+  ConfigStore).
 */
 
 #pragma once
@@ -13,35 +13,25 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "simulation_manager.h"
+#include "storage.h"
+#include "utils/event_log.h"
 #include "ui.h"
 
 // Estado de desbloqueio da sessão atual (PIN válido já fornecido).
 static bool s_lab_unlocked = false;
 
-static void lab_ensure_log_dir() {
-  if (!SD.exists("/sd/lab_logs")) {
-    SD.mkdir("/sd/lab_logs");
-  }
-}
-
+// Vai para o anel de eventos (utils/event_log.h): só copia para a fila em
+// RAM, a task sd grava em lote
 static void lab_log_event(const char* tag, const char* details) {
-  lab_ensure_log_dir();
-
-  char path[64];
-  snprintf(path, sizeof(path), "/sd/lab_logs/%s.log", tag ? tag : "lab_sim");
-
-  File f = SD.open(path, FILE_APPEND);
-  if (!f) {
-    Serial.printf("[LAB][SIM] Falha ao abrir log %s\n", path);
-    return;
+  char line[EVENT_LOG_TEXT_MAX + 1];
+  snprintf(line, sizeof(line), "%s;%s", tag ? tag : "event", details ? details : "");
+  if (!event_log_append(EVENT_SRC_LAB, line)) {
+    Serial.printf("[LAB][SIM] Fila do log cheia, evento %s descartado\n", tag ? tag : "event");
   }
+}
 
-  unsigned long t = millis() / 1000;
-  f.printf("%lu;%s;%s\n",
-           (unsigned long)t,
-           tag ? tag : "event",
-           details ? details : "");
-  f.close();
+static void lab_guard_check(void* arg) {
+  *(bool*)arg = SDCARD.exists("/sd/.enable_lab_attacks");
 }
 
 static lv_obj_t* s_sim_banner = nullptr;
@@ -81,7 +71,9 @@ static void lab_warn_mode_off(const char* feature) {
 // ---------------------------------------------------------------------------
 
 bool SimulationManager::is_lab_mode_enabled() {
-  if (!SD.exists("/sd/.enable_lab_attacks")) {
+  bool guard = false;
+  storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_LOG, lab_guard_check, &guard);
+  if (!guard) {
     return false;
   }
   return s_lab_unlocked;
@@ -12,7 +12,7 @@
 #pragma once
 
 #include <stdint.h>
-#include <SD.h>
+#include <FS.h>
 
 class SimulationManager {
 public:
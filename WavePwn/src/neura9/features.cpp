@@ -1,9 +1,347 @@
-#include "inference.h"
-
-// Este arquivo existe para permitir futura extração de features mais rica
-// (por exemplo, estatísticas detalhadas do sniffer, IMU, RTC, etc.).
-// No momento, a lógica principal de extração está em Neura9::extract_features()
-// dentro de neura9_inference.cpp para manter o código compacto.
-//
-// Quando o pipeline de dados crescer, as funções auxiliares podem migrar
-// para cá, mantendo a classe Neura9 enxuta.
\ No newline at end of file
+#include "neura9/features.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <math.h>
+#include <string.h>
+
+#include "capture/ap_table.h"
+#include "pwnagotchi.h"
+
+extern Pwnagotchi pwn;
+
+FeatureEngine neura9_features;
+
+static const float LOG2_CHANNELS = 3.807355f;   // log2(FEATURE_CHANNELS)
+
+static bool is_broadcast(const uint8_t* mac) {
+    static const uint8_t BCAST[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    return mac && memcmp(mac, BCAST, 6) == 0;
+}
+
+// SSID oculto: vazio ou só zeros
+static bool is_hidden_ssid(dot11::Span ssid) {
+    for (uint16_t i = 0; i < ssid.len; ++i) {
+        if (ssid.data[i] != 0) return false;
+    }
+    return true;
+}
+
+// FNV-1a: chave de 4 bytes da tabela de SSIDs
+static uint32_t ssid_hash(dot11::Span ssid) {
+    uint32_t h = 2166136261u;
+    for (uint16_t i = 0; i < ssid.len; ++i) {
+        h ^= ssid.data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool FeatureEngine::begin(uint32_t bssid_capacity, uint32_t ssid_capacity) {
+    size_t bucket_bytes = FEATURE_BUCKETS * sizeof(Bucket);
+    size_t bssid_bytes = BssidMap::storage_bytes(bssid_capacity);
+    size_t ssid_bytes = SsidMap::storage_bytes(ssid_capacity);
+    size_t total = bucket_bytes + bssid_bytes + ssid_bytes;
+
+    uint8_t* arena = (uint8_t*)heap_caps_calloc(1, total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!arena) {
+        arena = (uint8_t*)heap_caps_calloc(1, total, MALLOC_CAP_8BIT);
+    }
+    if (!arena) {
+        Serial.println("[FEATURES] ERRO ao alocar arena");
+        return false;
+    }
+
+    mutex = xSemaphoreCreateMutex();
+    buckets = (Bucket*)arena;
+    if (!bssids.begin(arena + bucket_bytes, bssid_capacity) ||
+        !ssids.begin(arena + bucket_bytes + bssid_bytes, ssid_capacity)) {
+        Serial.println("[FEATURES] Capacidade invalida (precisa ser potencia de 2)");
+        return false;
+    }
+
+    Serial.printf("[FEATURES] %lu BSSIDs + %lu SSIDs, janelas 1/10/60 s (%u KB)\n",
+                  (unsigned long)bssid_capacity,
+                  (unsigned long)ssid_capacity,
+                  (unsigned)(total / 1024));
+    return true;
+}
+
+void FeatureEngine::lock() {
+    if (mutex) xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void FeatureEngine::unlock() {
+    if (mutex) xSemaphoreGive(mutex);
+}
+
+// Fecha os segundos até `now_sec`: o balde completo entra nas somas e o que
+// saiu de cada janela é subtraído. Depois de mais de FEATURE_BUCKETS
+// segundos sem frames nem snapshot, tudo já expirou: zera de uma vez.
+void FeatureEngine::advance(uint32_t now_sec) {
+    if (!started) {
+        started = true;
+        start_sec = cur_sec = now_sec;
+        return;
+    }
+    if ((int32_t)(now_sec - cur_sec) <= 0) return;
+
+    if (now_sec - cur_sec >= FEATURE_BUCKETS) {
+        memset(buckets, 0, FEATURE_BUCKETS * sizeof(Bucket));
+        memset(sum10, 0, sizeof(sum10));
+        memset(sum60, 0, sizeof(sum60));
+        cur_sec = now_sec;
+        return;
+    }
+
+    while (cur_sec != now_sec) {
+        const Bucket& done = buckets[cur_sec & (FEATURE_BUCKETS - 1)];
+        const Bucket& out10 = buckets[(cur_sec - 10) & (FEATURE_BUCKETS - 1)];
+        const Bucket& out60 = buckets[(cur_sec - 60) & (FEATURE_BUCKETS - 1)];
+        bool expire10 = cur_sec - start_sec >= 10;
+        bool expire60 = cur_sec - start_sec >= 60;
+        for (int k = 0; k < C_COUNT; ++k) {
+            sum10[k] += done.c[k];
+            sum60[k] += done.c[k];
+            if (expire10) sum10[k] -= out10.c[k];
+            if (expire60) sum60[k] -= out60.c[k];
+        }
+        cur_sec++;
+        memset(&buckets[cur_sec & (FEATURE_BUCKETS - 1)], 0, sizeof(Bucket));
+    }
+}
+
+void FeatureEngine::on_frame(const dot11::Dot11View& view, int8_t rssi, uint8_t rx_channel,
+                             uint32_t now_ms) {
+    if (!buckets) return;
+    lock();
+    advance(now_ms / 1000);
+    Bucket& cur = buckets[cur_sec & (FEATURE_BUCKETS - 1)];
+
+    cur.c[C_FRAMES]++;
+    if (rssi != 0) {
+        uint32_t v = (uint32_t)(-(int32_t)rssi);
+        cur.c[C_RSSI_N]++;
+        cur.c[C_RSSI_SUM] += v;
+        cur.c[C_RSSI_SQ] += v * v;
+    }
+    if (rx_channel >= 1 && rx_channel <= FEATURE_CHANNELS) {
+        cur.c[C_CHANNEL + rx_channel - 1]++;
+    }
+
+    if (view.is_data()) {
+        cur.c[C_DATA]++;
+        if (view.has_eapol()) cur.c[C_EAPOL]++;
+    } else if (view.is_mgmt()) {
+        cur.c[C_MGMT]++;
+        switch (view.subtype) {
+            case dot11::MGMT_DEAUTH:
+            case dot11::MGMT_DISASSOC:
+                cur.c[C_DEAUTH]++;
+                if (is_broadcast(view.addr1)) cur.c[C_DEAUTH_BCAST]++;
+                last_deauth_sec = cur_sec + 1;
+                break;
+            case dot11::MGMT_PROBE_REQ:
+                cur.c[C_PROBE_REQ]++;
+                break;
+            case dot11::MGMT_BEACON:
+            case dot11::MGMT_PROBE_RESP: {
+                if (!view.bssid) break;
+                bool created;
+                BssidState* b = bssids.insert(view.bssid, &created);
+                if (created) cur.c[C_NEW_BSSID]++;
+                if (view.subtype == dot11::MGMT_BEACON) {
+                    cur.c[C_BEACON]++;
+                    if (b->beacon_sec != cur_sec + 1) {
+                        b->beacon_sec = cur_sec + 1;
+                        b->beacons = 0;
+                        cur.c[C_BEACONING]++;
+                    }
+                    if (b->beacons < 0xFFFF) b->beacons++;
+                    if (b->beacons > cur.max_bssid_beacons) cur.max_bssid_beacons = b->beacons;
+                }
+                if (view.has_ssid && !is_hidden_ssid(view.ssid)) {
+                    on_ssid(view, *b, created, cur);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    unlock();
+}
+
+// SSID anunciado por um BSSID. A tabela de SSIDs só é consultada quando o
+// BSSID passa a anunciar outro SSID ou muda de criptografia; no beacon
+// repetido basta comparar o hash.
+void FeatureEngine::on_ssid(const dot11::Dot11View& view, BssidState& b, bool created,
+                            Bucket& cur) {
+    uint32_t h = ssid_hash(view.ssid);
+    uint8_t enc = ap_classify_encryption(view);
+    bool new_ssid = created || !b.has_ssid || b.ssid_hash != h;
+    if (!new_ssid && b.encryption == enc) return;
+
+    // Um BSSID respondendo por vários SSIDs é o padrão de karma/MANA
+    if (!created && b.has_ssid && b.ssid_hash != h) cur.c[C_SSID_CHANGE]++;
+    b.ssid_hash = h;
+    b.has_ssid = 1;
+    b.encryption = enc;
+
+    uint8_t key[4];
+    memcpy(key, &h, sizeof(key));
+    bool s_created;
+    SsidState* s = ssids.insert(key, &s_created);
+    if (s_created) {
+        memcpy(s->owner, view.bssid, 6);
+        s->bssids = 1;
+    } else if (new_ssid && memcmp(s->owner, view.bssid, 6) != 0) {
+        // Outro BSSID com o mesmo SSID: mesh/roaming legítimo ou clone
+        if (s->bssids < 0xFFFF) s->bssids++;
+        cur.c[C_SSID_DUP]++;
+    }
+
+    // Mesmo SSID com outra criptografia (ex. cópia aberta de uma rede WPA2)
+    uint8_t bit = (uint8_t)(1u << enc);
+    if (s->encryptions && !(s->encryptions & bit)) {
+        cur.c[C_EVIL_TWIN]++;
+        last_twin_sec = cur_sec + 1;
+    }
+    s->encryptions |= bit;
+}
+
+// Uma janela: `sum` = contadores somados, `seconds` = divisor das taxas,
+// `span` = baldes completos a percorrer para o máximo por BSSID.
+void FeatureEngine::fill_window(float* out, const uint64_t* sum, uint32_t seconds,
+                                uint32_t span) {
+    float inv = seconds ? 1.0f / (float)seconds : 0.0f;
+    out[FEATURE_M_FRAMES] = sum[C_FRAMES] * inv;
+    out[FEATURE_M_MGMT] = sum[C_MGMT] * inv;
+    out[FEATURE_M_DATA] = sum[C_DATA] * inv;
+    out[FEATURE_M_BEACONS] = sum[C_BEACON] * inv;
+    out[FEATURE_M_DEAUTH] = sum[C_DEAUTH] * inv;
+    out[FEATURE_M_DEAUTH_BCAST] = sum[C_DEAUTH_BCAST] * inv;
+    out[FEATURE_M_PROBE_REQ] = sum[C_PROBE_REQ] * inv;
+    out[FEATURE_M_EAPOL] = sum[C_EAPOL] * inv;
+    out[FEATURE_M_NEW_BSSID] = sum[C_NEW_BSSID] * inv;
+    out[FEATURE_M_BEACONING_BSSIDS] = sum[C_BEACONING] * inv;
+    out[FEATURE_M_SSID_DUP] = sum[C_SSID_DUP] * inv;
+    out[FEATURE_M_EVIL_TWIN] = sum[C_EVIL_TWIN] * inv;
+
+    uint16_t max_beacons = 0;
+    for (uint32_t i = 1; i <= span; ++i) {
+        const Bucket& b = buckets[(cur_sec - i) & (FEATURE_BUCKETS - 1)];
+        if (b.max_bssid_beacons > max_beacons) max_beacons = b.max_bssid_beacons;
+    }
+    out[FEATURE_M_MAX_BSSID_BEACONS] = max_beacons;
+
+    float stddev = 0.0f;
+    if (sum[C_RSSI_N] > 1) {
+        double n = (double)sum[C_RSSI_N];
+        double mean = sum[C_RSSI_SUM] / n;
+        double var = sum[C_RSSI_SQ] / n - mean * mean;
+        stddev = var > 0 ? (float)sqrt(var) : 0.0f;
+    }
+    out[FEATURE_M_RSSI_STDDEV] = stddev;
+
+    // Entropia de Shannon normalizada: 0 = um canal só, 1 = uniforme
+    uint64_t total = 0;
+    for (int ch = 0; ch < FEATURE_CHANNELS; ++ch) total += sum[C_CHANNEL + ch];
+    float entropy = 0.0f;
+    if (total) {
+        for (int ch = 0; ch < FEATURE_CHANNELS; ++ch) {
+            if (!sum[C_CHANNEL + ch]) continue;
+            float p = (float)sum[C_CHANNEL + ch] / (float)total;
+            entropy -= p * log2f(p);
+        }
+    }
+    out[FEATURE_M_CHANNEL_ENTROPY] = entropy / LOG2_CHANNELS;
+}
+
+static uint32_t seconds_since(uint32_t mark, uint32_t now_sec) {
+    if (!mark) return FEATURE_SINCE_CAP_S;
+    uint32_t s = now_sec - (mark - 1);
+    return s < FEATURE_SINCE_CAP_S ? s : FEATURE_SINCE_CAP_S;
+}
+
+void FeatureEngine::snapshot(float* out, uint32_t now_ms) {
+    int i = 0;
+
+    // Visão geral de redes e capturas
+    out[i++] = static_cast<float>(pwn.aps_seen);
+    out[i++] = static_cast<float>(pwn.handshakes);
+    out[i++] = static_cast<float>(pwn.pmkids);
+    out[i++] = static_cast<float>(pwn.deauths);
+
+    // Estado de bateria / energia
+    out[i++] = pwn.battery_percent / 100.0f;
+    out[i++] = pwn.is_charging ? 1.0f : 0.0f;
+
+    // Movimento / contexto físico
+    out[i++] = pwn.is_moving ? 1.0f : 0.0f;
+
+    // Tempo de uso (horas aproximadas desde boot)
+    out[i++] = static_cast<float>(pwn.uptime) / 3600.0f;
+
+    // Canal atual
+    out[i++] = static_cast<float>(pwn.current_channel);
+
+    // Ambiente de RF a partir da tabela de APs (janela ativa de 5 min)
+    ApTableSummary aps;
+    ap_table.get_summary(&aps, now_ms);
+    out[i++] = static_cast<float>(aps.aps_active);
+    out[i++] = static_cast<float>(aps.clients);
+    out[i++] = static_cast<float>(aps.by_encryption[AP_ENC_OPEN]);
+    out[i++] = static_cast<float>(aps.by_encryption[AP_ENC_WEP]);
+    out[i++] = static_cast<float>(aps.by_encryption[AP_ENC_WPA]);
+    out[i++] = static_cast<float>(aps.by_encryption[AP_ENC_WPA2]);
+    out[i++] = static_cast<float>(aps.by_encryption[AP_ENC_WPA3]);
+    out[i++] = static_cast<float>(aps.hidden);
+    out[i++] = static_cast<float>(aps.with_handshake);
+    out[i++] = static_cast<float>(aps.with_pmkid);
+    // RSSI em [0, 1]: -100 dBm -> 0, -20 dBm -> 1
+    bool rssi_known = aps.strongest_rssi > -127;
+    out[i++] = rssi_known ? (aps.strongest_rssi + 100) / 80.0f : 0.0f;
+    out[i++] = rssi_known ? (aps.mean_rssi + 100) / 80.0f : 0.0f;
+
+    if (!buckets) {
+        for (; i < NEURA9_FEATURE_COUNT; ++i) out[i] = 0.0f;
+        return;
+    }
+
+    lock();
+    uint32_t now_sec = now_ms / 1000;
+    advance(now_sec);
+    uint32_t elapsed = started ? cur_sec - start_sec : 0;   // segundos completos
+
+    // 1 s: o último balde completo
+    uint64_t last[C_COUNT] = {};
+    if (elapsed >= 1) {
+        const Bucket& b = buckets[(cur_sec - 1) & (FEATURE_BUCKETS - 1)];
+        for (int k = 0; k < C_COUNT; ++k) last[k] = b.c[k];
+    }
+    uint32_t s1 = elapsed < 1 ? elapsed : 1;
+    uint32_t s10 = elapsed < 10 ? elapsed : 10;
+    uint32_t s60 = elapsed < 60 ? elapsed : 60;
+    float* win = out + FEATURE_WINDOW_OFFSET;
+    fill_window(win + FEATURE_WIN_1S * FEATURE_M_COUNT, last, s1, s1);
+    fill_window(win + FEATURE_WIN_10S * FEATURE_M_COUNT, sum10, s10, s10);
+    fill_window(win + FEATURE_WIN_60S * FEATURE_M_COUNT, sum60, s60, s60);
+
+    uint32_t probe_burst = 0;
+    uint32_t deauth_burst = 0;
+    for (uint32_t k = 1; k <= s60; ++k) {
+        const Bucket& b = buckets[(cur_sec - k) & (FEATURE_BUCKETS - 1)];
+        if (b.c[C_PROBE_REQ] > probe_burst) probe_burst = b.c[C_PROBE_REQ];
+        if (b.c[C_DEAUTH] > deauth_burst) deauth_burst = b.c[C_DEAUTH];
+    }
+
+    float* g = out + FEATURE_GLOBAL_OFFSET;
+    g[FEATURE_G_PROBE_BURST] = static_cast<float>(probe_burst);
+    g[FEATURE_G_DEAUTH_BURST] = static_cast<float>(deauth_burst);
+    g[FEATURE_G_SINCE_DEAUTH] = static_cast<float>(seconds_since(last_deauth_sec, now_sec));
+    g[FEATURE_G_SINCE_EVIL_TWIN] = static_cast<float>(seconds_since(last_twin_sec, now_sec));
+    g[FEATURE_G_SSID_CHANGES] = static_cast<float>(sum60[C_SSID_CHANGE]);
+    g[FEATURE_G_SSIDS_TRACKED] = static_cast<float>(ssids.size());
+    unlock();
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "capture/dot11.h"
+#include "capture/mac_table.h"
+
+// Motor de features da NEURA9: agregados em janelas deslizantes de 1 s,
+// 10 s e 60 s alimentados frame a frame pela task de captura.
+//
+// - Cada frame só incrementa contadores do balde do segundo atual: O(1),
+//   sem reler histórico. Beacons e probe responses consultam ainda duas
+//   MacTable (por BSSID e por hash de SSID), também O(1).
+// - Ao virar o segundo, o balde completo entra na soma das janelas de 10 s
+//   e 60 s e o que saiu da janela é subtraído (somas correntes).
+// - snapshot() monta o vetor de NEURA9_FEATURE_COUNT floats; só os máximos
+//   e a entropia de canais percorrem os baldes da janela (no máximo 60).
+// - Escrita pela task de captura; snapshot() de qualquer task, com o mesmo
+//   mutex (como a ApTable).
+//
+// Vetor (a ordem é a do CSV do dataset: f0..f71):
+//
+//   0..20   ambiente: contadores do pwn (0-8) e resumo da ApTable (9-20)
+//   21..35  janela de 1 s  (último segundo completo)
+//   36..50  janela de 10 s
+//   51..65  janela de 60 s
+//   66..71  globais (ver FEATURE_G_*)
+//
+// Em cada janela, na ordem de FeatureWindowMetric: taxas por segundo de
+// frames, management, data, beacons, deauth+disassoc, deauth broadcast,
+// probe requests, EAPOL, BSSIDs novos, BSSIDs emitindo beacons, máximo de
+// beacons/s de um único BSSID, SSIDs duplicados (outro BSSID anunciando um
+// SSID já visto), sinais de evil twin (mesmo SSID com outra criptografia),
+// desvio padrão do RSSI (dB) e entropia da distribuição por canal (0..1).
+// Nos primeiros segundos após o boot a taxa usa o tempo decorrido, não a
+// janela inteira.
+
+#define NEURA9_FEATURE_COUNT        72
+#define FEATURE_BASE_COUNT          21
+#define FEATURE_WINDOW_OFFSET       FEATURE_BASE_COUNT
+#define FEATURE_GLOBAL_OFFSET       66
+
+#define FEATURE_BSSID_CAPACITY      1024   // potência de 2
+#define FEATURE_SSID_CAPACITY       1024   // potência de 2
+#define FEATURE_BUCKETS             64     // > 60 s, potência de 2
+#define FEATURE_CHANNELS            14
+#define FEATURE_SINCE_CAP_S         3600   // "segundos desde" satura em 1 h
+
+enum FeatureWindow : uint8_t {
+    FEATURE_WIN_1S = 0,
+    FEATURE_WIN_10S,
+    FEATURE_WIN_60S,
+    FEATURE_WIN_COUNT,
+};
+
+enum FeatureWindowMetric : uint8_t {
+    FEATURE_M_FRAMES = 0,
+    FEATURE_M_MGMT,
+    FEATURE_M_DATA,
+    FEATURE_M_BEACONS,
+    FEATURE_M_DEAUTH,
+    FEATURE_M_DEAUTH_BCAST,
+    FEATURE_M_PROBE_REQ,
+    FEATURE_M_EAPOL,
+    FEATURE_M_NEW_BSSID,
+    FEATURE_M_BEACONING_BSSIDS,
+    FEATURE_M_MAX_BSSID_BEACONS,
+    FEATURE_M_SSID_DUP,
+    FEATURE_M_EVIL_TWIN,
+    FEATURE_M_RSSI_STDDEV,
+    FEATURE_M_CHANNEL_ENTROPY,
+    FEATURE_M_COUNT,
+};
+
+// Globais, a partir de FEATURE_GLOBAL_OFFSET
+enum FeatureGlobal : uint8_t {
+    FEATURE_G_PROBE_BURST = 0,   // maior nº de probe requests em 1 s (60 s)
+    FEATURE_G_DEAUTH_BURST,      // maior nº de deauth+disassoc em 1 s (60 s)
+    FEATURE_G_SINCE_DEAUTH,      // segundos desde o último deauth/disassoc
+    FEATURE_G_SINCE_EVIL_TWIN,   // segundos desde o último sinal de evil twin
+    FEATURE_G_SSID_CHANGES,      // BSSIDs trocando de SSID em 60 s (karma)
+    FEATURE_G_SSIDS_TRACKED,     // SSIDs distintos na tabela
+    FEATURE_G_COUNT,
+};
+
+static_assert(FEATURE_WINDOW_OFFSET + FEATURE_WIN_COUNT * FEATURE_M_COUNT ==
+                  FEATURE_GLOBAL_OFFSET,
+              "layout das janelas");
+static_assert(FEATURE_GLOBAL_OFFSET + FEATURE_G_COUNT == NEURA9_FEATURE_COUNT,
+              "layout das features");
+
+class FeatureEngine {
+public:
+    // Aloca a arena (baldes + tabelas; PSRAM com fallback) e o mutex.
+    bool begin(uint32_t bssid_capacity = FEATURE_BSSID_CAPACITY,
+               uint32_t ssid_capacity = FEATURE_SSID_CAPACITY);
+
+    // Task de captura: todo frame que o Dot11View aceitou.
+    void on_frame(const dot11::Dot11View& view, int8_t rssi, uint8_t rx_channel,
+                  uint32_t now_ms);
+
+    // Qualquer task: preenche `out` com NEURA9_FEATURE_COUNT floats.
+    void snapshot(float* out, uint32_t now_ms);
+
+private:
+    // Contadores somáveis de um segundo
+    enum Counter : uint8_t {
+        C_FRAMES = 0,
+        C_MGMT,
+        C_DATA,
+        C_BEACON,
+        C_DEAUTH,
+        C_DEAUTH_BCAST,
+        C_PROBE_REQ,
+        C_EAPOL,
+        C_NEW_BSSID,
+        C_BEACONING,      // BSSIDs com ao menos um beacon no segundo
+        C_SSID_DUP,
+        C_EVIL_TWIN,
+        C_SSID_CHANGE,
+        C_RSSI_N,
+        C_RSSI_SUM,       // de -rssi (0..128)
+        C_RSSI_SQ,
+        C_CHANNEL,        // FEATURE_CHANNELS contadores a partir daqui
+        C_COUNT = C_CHANNEL + FEATURE_CHANNELS,
+    };
+
+    struct Bucket {
+        uint32_t c[C_COUNT];
+        uint16_t max_bssid_beacons;   // não somável: máximo na leitura
+    };
+
+    struct BssidState {
+        uint32_t ssid_hash;
+        uint32_t beacon_sec;          // segundo + 1 do último beacon (0 = nunca)
+        uint16_t beacons;             // beacons em beacon_sec
+        uint8_t  has_ssid;
+        uint8_t  encryption;          // ApEncryption
+    };
+
+    struct SsidState {
+        uint8_t  owner[6];            // primeiro BSSID que anunciou o SSID
+        uint8_t  encryptions;         // máscara 1 << ApEncryption
+        uint16_t bssids;
+    };
+
+    typedef MacTable<6, BssidState> BssidMap;
+    typedef MacTable<4, SsidState> SsidMap;
+
+    BssidMap bssids;
+    SsidMap ssids;
+    Bucket* buckets = nullptr;        // FEATURE_BUCKETS, anel por segundo
+    SemaphoreHandle_t mutex = nullptr;
+
+    bool started = false;
+    uint32_t start_sec = 0;
+    uint32_t cur_sec = 0;             // segundo do balde em preenchimento
+    uint64_t sum10[C_COUNT] = {};     // segundos [cur_sec - 10, cur_sec)
+    uint64_t sum60[C_COUNT] = {};     // segundos [cur_sec - 60, cur_sec)
+    uint32_t last_deauth_sec = 0;     // segundo + 1 (0 = nunca)
+    uint32_t last_twin_sec = 0;
+
+    void lock();
+    void unlock();
+    void advance(uint32_t now_sec);
+    void on_ssid(const dot11::Dot11View& view, BssidState& b, bool created, Bucket& cur);
+    void fill_window(float* out, const uint64_t* sum, uint32_t seconds, uint32_t span);
+};
+
+// Instância usada pela captura e pela NEURA9
+extern FeatureEngine neura9_features;
@@ -1,11 +1,22 @@
 #include "inference.h"
 
-#include <cstring>
+#include <math.h>
+#include <string.h>
+#include <new>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 #include "pwnagotchi.h"
 #include "ui.h"
 #include "sensors.h"
+#include "neura9/features.h"
+#if NEURA9_BACKEND_MLP
+#include "neura9/mlp_model.h"
+#else
 #include "neura9/model.h"
+#include "utils/crc32.h"
+#include "neura9/model_arena.h"
+#endif
 
 extern Pwnagotchi pwn;
 
@@ -25,6 +36,142 @@ const char* NEURA9_THREAT_LABELS[10] = {
     "LEARNING_MODE"
 };
 
+// Inferências medidas no begin() para a latência de referência
+static const int NEURA9_BENCH_INVOKES = 10;
+
+// Task "neura9": no core da UI, na prioridade do loop; a captura (core 0)
+// nunca espera a inferência
+static const BaseType_t NEURA9_TASK_CORE = 1;
+static const UBaseType_t NEURA9_TASK_PRIO = 1;
+static const uint32_t NEURA9_TASK_STACK = 8192;
+
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+const uint32_t NEURA9_LATENCY_EDGES[NEURA9_LATENCY_BUCKETS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, UINT32_MAX,
+};
+
+#if NEURA9_BACKEND_MLP
+
+// Pesos em flash (constexpr); só os dois buffers int16 da camada vão na
+// pilha da task neura9
+static const neura9_mlp::Model mlp_model(neura9_mlp::INPUT_CENTER, neura9_mlp::INPUT_INV_SCALE,
+                                         neura9_mlp::LAYERS, neura9_mlp::OUTPUT_SCALE);
+
+static_assert(neura9_mlp::Model::kInputs == NEURA9_FEATURE_COUNT,
+              "mlp_model.h gerado para outro vetor de features");
+static_assert(neura9_mlp::Model::kOutputs == 10, "mlp_model.h com outro número de classes");
+
+bool Neura9::begin() {
+    if (NEURA9_MLP_PLACEHOLDER) {
+        Serial.println("[NEURA9] MLP de ponto fixo: neura9/mlp_model.h ainda e o placeholder "
+                       "(ai/neura9_trainer.py --mlp-header)");
+        return false;
+    }
+    model_ready = true;
+    last_invoke_us = bench_invoke();
+    Serial.printf("[NEURA9] IA defensiva NEURA9 carregada — MLP de ponto fixo, %d camadas, "
+                  "%u bytes em flash, sem TFLM, run() %lu us — 100%% offline\n",
+                  neura9_mlp::Model::kLayers, (unsigned)neura9_mlp::Model::kModelBytes,
+                  (unsigned long)last_invoke_us);
+    return true;
+}
+
+uint32_t Neura9::bench_invoke() {
+    float conf = 0.0f;
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < NEURA9_BENCH_INVOKES; ++i) {
+        mlp_model.run(features, &conf);
+    }
+    return static_cast<uint32_t>((esp_timer_get_time() - t0) / NEURA9_BENCH_INVOKES);
+}
+
+#else
+
+// Arena para medir um modelo que ainda não está em neura9/model_arena.h
+// (o tamanho fixo de antes)
+#ifndef NEURA9_ARENA_PROBE_BYTES
+#define NEURA9_ARENA_PROBE_BYTES (160 * 1024)
+#endif
+
+// Acima disso por Invoke() em PSRAM, a arena vai para a RAM interna (se
+// couber sem apertar o heap). -DNEURA9_ARENA_INTERNAL=1 força a interna.
+#ifndef NEURA9_ARENA_PSRAM_MAX_US
+#define NEURA9_ARENA_PSRAM_MAX_US 2000
+#endif
+#ifndef NEURA9_ARENA_INTERNAL
+#define NEURA9_ARENA_INTERNAL 0
+#endif
+
+// RAM interna que precisa sobrar depois da arena (Wi-Fi, AsyncTCP, LVGL)
+static const size_t NEURA9_INTERNAL_RESERVE = 64 * 1024;
+
+// A TFLM alinha os tensores em 16 bytes a partir do início da arena
+static const size_t NEURA9_ARENA_ALIGN = 16;
+static const size_t NEURA9_ARENA_SLACK = 64;
+
+// O interpretador é recriado quando a arena muda de tamanho ou de lugar
+alignas(tflite::MicroInterpreter) static uint8_t interpreter_storage[sizeof(tflite::MicroInterpreter)];
+
+static const char* tensor_type_name(TfLiteType type) {
+    switch (type) {
+        case kTfLiteFloat32: return "float32";
+        case kTfLiteInt8: return "int8";
+        default: return "?";
+    }
+}
+
+// Copia as features para a entrada. float32 direto; int8 com a escala e o
+// zero-point do tensor (q = round(x / scale) + zp, saturado em [-128, 127]).
+// Posições além de `count` ficam em zero.
+static bool load_input(TfLiteTensor* t, const float* src, int count) {
+    if (t->type == kTfLiteFloat32) {
+        const int len = t->bytes / static_cast<int>(sizeof(float));
+        for (int i = 0; i < len; ++i) {
+            t->data.f[i] = i < count ? src[i] : 0.0f;
+        }
+        return true;
+    }
+    if (t->type == kTfLiteInt8) {
+        const float inv_scale = 1.0f / t->params.scale;
+        const int32_t zp = t->params.zero_point;
+        const int len = static_cast<int>(t->bytes);
+        for (int i = 0; i < len; ++i) {
+            int32_t q = zp + (i < count ? static_cast<int32_t>(lroundf(src[i] * inv_scale)) : 0);
+            t->data.int8[i] = static_cast<int8_t>(q < -128 ? -128 : (q > 127 ? 127 : q));
+        }
+        return true;
+    }
+    return false;
+}
+
+// Classe de maior score e a probabilidade dela. No int8 o argmax é feito nos
+// valores quantizados (escala positiva: mesma ordem) e só o vencedor é
+// convertido. -1 com tipo de saída não suportado.
+static int read_output(const TfLiteTensor* t, int max_classes, float* conf) {
+    if (t->type == kTfLiteFloat32) {
+        int n = t->bytes / static_cast<int>(sizeof(float));
+        if (n > max_classes) n = max_classes;
+        int best = 0;
+        for (int i = 1; i < n; ++i) {
+            if (t->data.f[i] > t->data.f[best]) best = i;
+        }
+        *conf = t->data.f[best];
+        return best;
+    }
+    if (t->type == kTfLiteInt8) {
+        int n = static_cast<int>(t->bytes);
+        if (n > max_classes) n = max_classes;
+        int best = 0;
+        for (int i = 1; i < n; ++i) {
+            if (t->data.int8[i] > t->data.int8[best]) best = i;
+        }
+        *conf = (t->data.int8[best] - t->params.zero_point) * t->params.scale;
+        return best;
+    }
+    return -1;
+}
+
 bool Neura9::begin() {
     const tflite::Model* model = tflite::GetModel(neura9_defense_model_tflite);
     if (model->version() != TFLITE_SCHEMA_VERSION) {
@@ -36,129 +183,362 @@ bool Neura9::begin() {
         return false;
     }
 
-    // Resolver mínimo para o modelo denso (Dense + ReLU + Softmax).
-    static tflite::MicroMutableOpResolver<4> resolver;
+    // Resolver mínimo para o modelo denso (Dense + ReLU + Softmax), float32
+    // ou int8. Quantize/Dequantize só aparecem em modelos int8 exportados com
+    // entrada/saída float. Com a TFLM da Espressif (esp-tflite-micro), os
+    // kernels int8 de FullyConnected/Softmax são os do ESP-NN (SIMD do S3);
+    // no float32 ficam os de referência.
+    static tflite::MicroMutableOpResolver<6> resolver;
     resolver.AddFullyConnected();
     resolver.AddReshape();
     resolver.AddSoftmax();
     resolver.AddRelu();
+    resolver.AddQuantize();
+    resolver.AddDequantize();
+
+    // Tamanho: o medido para este modelo (neura9/model_arena.h) ou, se o
+    // modelo mudou, uma arena de sonda que é medida e depois encolhida
+    const uint32_t model_crc = crc32_update(0, neura9_defense_model_tflite,
+                                            neura9_defense_model_tflite_len);
+    const bool recorded = NEURA9_ARENA_BYTES > 0 && NEURA9_ARENA_MODEL_CRC == model_crc;
+    const bool internal = NEURA9_ARENA_INTERNAL != 0;
+    size_t size = recorded ? NEURA9_ARENA_BYTES + NEURA9_ARENA_SLACK : NEURA9_ARENA_PROBE_BYTES;
+
+    bool probed = !recorded;
+    if (!setup_arena(model, &resolver, size, internal)) {
+        // Tamanho gravado que não serve mais (outra versão da TFLM): mede
+        if (!recorded || !setup_arena(model, &resolver, NEURA9_ARENA_PROBE_BYTES, internal)) {
+            return false;
+        }
+        probed = true;
+    }
+    if (probed) {
+        const size_t used = interpreter->arena_used_bytes();
+        Serial.printf("[NEURA9] arena medida: used=%u crc=%08lx len=%u "
+                      "(tools/neura9/record_arena.py grava em neura9/model_arena.h)\n",
+                      (unsigned)used, (unsigned long)model_crc, neura9_defense_model_tflite_len);
+        if (!setup_arena(model, &resolver, used + NEURA9_ARENA_SLACK, internal)) {
+            return false;
+        }
+    }
 
-    static tflite::MicroInterpreter static_interpreter(
-        model,
-        resolver,
-        tensor_arena,
-        sizeof(tensor_arena));
+    float conf = 0.0f;
+    if (!load_input(input, features, 0) || read_output(output, 10, &conf) < 0) {
+        Serial.printf("[NEURA9] Tipos de tensor nao suportados (entrada=%s, saida=%s)\n",
+                      tensor_type_name(input->type), tensor_type_name(output->type));
+        release_arena();
+        return false;
+    }
 
-    interpreter = &static_interpreter;
+    // Latência de referência com entrada neutra; lenta demais em PSRAM, a
+    // arena passa para a RAM interna se couber
+    last_invoke_us = bench_invoke();
+    const uint32_t psram_us = arena_internal ? 0 : last_invoke_us;
+    if (!arena_internal && psram_us > NEURA9_ARENA_PSRAM_MAX_US &&
+        heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) >
+            arena_size + NEURA9_INTERNAL_RESERVE) {
+        // Se a interna falhar, a arena volta para a PSRAM, que já funcionava
+        const size_t size = arena_size;
+        if (setup_arena(model, &resolver, size, true)) {
+            last_invoke_us = bench_invoke();
+        } else if (setup_arena(model, &resolver, size, false)) {
+            Serial.println("[NEURA9] Arena na RAM interna falhou, mantida na PSRAM");
+        } else {
+            return false;
+        }
+    }
 
-    if (interpreter->AllocateTensors() != kTfLiteOk) {
-        Serial.println("[NEURA9] AllocateTensors() falhou");
-        interpreter = nullptr;
-        input = nullptr;
-        output = nullptr;
+    Serial.printf("[NEURA9] IA defensiva NEURA9 carregada — modelo %s (%u bytes), arena %u bytes "
+                  "em %s, Invoke() %lu us",
+                  tensor_type_name(input->type), neura9_defense_model_tflite_len,
+                  (unsigned)arena_size, arena_internal ? "RAM interna" : "PSRAM",
+                  (unsigned long)last_invoke_us);
+    if (psram_us && arena_internal) {
+        Serial.printf(" (PSRAM: %lu us)", (unsigned long)psram_us);
+    }
+    Serial.println(" — 100% offline");
+    return true;
+}
+
+// (Re)cria o interpretador sobre uma arena nova de `size` bytes. Na PSRAM
+// por padrão (volta para a interna sem PSRAM); `internal` pede a interna.
+bool Neura9::setup_arena(const tflite::Model* model, tflite::MicroOpResolver* resolver,
+                         size_t size, bool internal) {
+    release_arena();
+
+    size = (size + NEURA9_ARENA_ALIGN - 1) & ~(NEURA9_ARENA_ALIGN - 1);
+    if (!internal) {
+        tensor_arena = static_cast<uint8_t*>(heap_caps_aligned_alloc(
+            NEURA9_ARENA_ALIGN, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    }
+    arena_internal = tensor_arena == nullptr;
+    if (!tensor_arena) {
+        tensor_arena = static_cast<uint8_t*>(heap_caps_aligned_alloc(
+            NEURA9_ARENA_ALIGN, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    if (!tensor_arena) {
+        Serial.printf("[NEURA9] Sem memoria para a arena (%u bytes)\n", (unsigned)size);
         return false;
     }
+    arena_size = size;
 
+    interpreter = new (interpreter_storage) tflite::MicroInterpreter(
+        model, *resolver, tensor_arena, arena_size);
+    if (interpreter->AllocateTensors() != kTfLiteOk) {
+        Serial.printf("[NEURA9] AllocateTensors() falhou com arena de %u bytes\n",
+                      (unsigned)arena_size);
+        release_arena();
+        return false;
+    }
     input = interpreter->input(0);
     output = interpreter->output(0);
-
-    Serial.println("[NEURA9] IA defensiva NEURA9 carregada — modelo TFLite em RAM — 100% offline");
     return true;
 }
 
-void Neura9::extract_features() {
-    // Preenche features com dados básicos do ambiente; o restante fica para
-    // integrações futuras (sniffer detalhado, IMU, RTC, etc.).
-    int i = 0;
-
-    // Visão geral de redes e capturas
-    features[i++] = static_cast<float>(pwn.aps_seen);
-    features[i++] = static_cast<float>(pwn.handshakes);
-    features[i++] = static_cast<float>(pwn.pmkids);
-    features[i++] = static_cast<float>(pwn.deauths);
+void Neura9::release_arena() {
+    if (interpreter) {
+        interpreter->~MicroInterpreter();
+        interpreter = nullptr;
+    }
+    input = nullptr;
+    output = nullptr;
+    if (tensor_arena) {
+        heap_caps_free(tensor_arena);
+        tensor_arena = nullptr;
+    }
+    arena_size = 0;
+}
 
-    // Estado de bateria / energia
-    features[i++] = pwn.battery_percent / 100.0f;
-    features[i++] = pwn.is_charging ? 1.0f : 0.0f;
+uint32_t Neura9::bench_invoke() {
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < NEURA9_BENCH_INVOKES; ++i) {
+        interpreter->Invoke();
+    }
+    return static_cast<uint32_t>((esp_timer_get_time() - t0) / NEURA9_BENCH_INVOKES);
+}
 
-    // Movimento / contexto físico
-    features[i++] = pwn.is_moving ? 1.0f : 0.0f;
+#endif  // NEURA9_BACKEND_MLP
 
-    // Tempo de uso (horas aproximadas desde boot)
-    features[i++] = static_cast<float>(pwn.uptime) / 3600.0f;
+void Neura9::extract_features() {
+    // Ambiente (pwn + ApTable) e janelas de 1/10/60 s do sniffer, mantidas
+    // frame a frame pela task de captura (neura9/features.h)
+    neura9_features.snapshot(features, millis());
 
-    // Canal atual (placeholder)
-    features[i++] = static_cast<float>(pwn.current_channel);
+    gesture_detection();
+    battery_prediction();
+}
 
-    // Demais features ficam zeradas até termos fontes reais
-    for (; i < static_cast<int>(sizeof(features) / sizeof(features[0])); ++i) {
-        features[i] = 0.0f;
+// Heurística de quando não há modelo ou o Invoke() falha
+static uint8_t fallback_class(float* confidence) {
+    if (pwn.deauths > 50) {
+        *confidence = 1.0f;
+        return 4; // DEAUTH_DETECTED
     }
+    *confidence = 0.0f;
+    return 0; // SAFE
+}
 
-    gesture_detection();
-    battery_prediction();
-    threat_detection();
+static void hist_add(uint32_t* hist, uint32_t us) {
+    int b = 0;
+    while (b < NEURA9_LATENCY_BUCKETS - 1 && us >= NEURA9_LATENCY_EDGES[b]) b++;
+    hist[b]++;
 }
 
-uint8_t Neura9::predict() {
-    extract_features();
+uint8_t Neura9::infer(float* confidence, bool* fallback) {
+    *fallback = true;
+#if NEURA9_BACKEND_MLP
+    if (!model_ready) {
+        return fallback_class(confidence);
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    int cls = mlp_model.run(features, confidence);
+    last_invoke_us = static_cast<uint32_t>(esp_timer_get_time() - t0);
 
+    *fallback = false;
+    return static_cast<uint8_t>(cls);
+#else
     if (!interpreter || !input || !output) {
-        // Fallback leve baseado em regras simples se TFLM não estiver ativo.
-        if (pwn.deauths > 50) {
-            ui_set_mood(MOOD_ANGRY);
-            last_confidence = 1.0f;
-            return 4; // DEAUTH_DETECTED
-        }
-        last_confidence = 0.0f;
-        return 0; // SAFE
+        return fallback_class(confidence);
     }
 
-    if (input->type != kTfLiteFloat32) {
-        Serial.println("[NEURA9] Tipo de tensor de entrada inesperado (esperado float32)");
-        last_confidence = 0.0f;
-        return 0;
+    load_input(input, features, NEURA9_FEATURE_COUNT);
+
+    int64_t t0 = esp_timer_get_time();
+    TfLiteStatus status = interpreter->Invoke();
+    last_invoke_us = static_cast<uint32_t>(esp_timer_get_time() - t0);
+
+    if (status != kTfLiteOk) {
+        portENTER_CRITICAL(&stats_mux);
+        stats.failures++;
+        portEXIT_CRITICAL(&stats_mux);
+        return fallback_class(confidence);
     }
 
-    const int input_len = input->bytes / static_cast<int>(sizeof(float));
-    const int copy_len = input_len < 72 ? input_len : 72;
-    std::memcpy(input->data.f, features, copy_len * sizeof(float));
+    *fallback = false;
+    return static_cast<uint8_t>(read_output(output, 10, confidence));
+#endif
+}
 
-    if (interpreter->Invoke() != kTfLiteOk) {
-        Serial.println("[NEURA9] Invoke() falhou, usando fallback heuristico");
-        if (pwn.deauths > 50) {
-            ui_set_mood(MOOD_ANGRY);
-            last_confidence = 1.0f;
-            return 4;
-        }
-        last_confidence = 0.0f;
-        return 0;
+// Fora da detecção de mudança: relógios que andam sozinhos (uptime,
+// segundos desde deauth / evil twin) e a janela de 1 s, ruidosa demais,
+// menos deauth e evil twin: uma rajada nova precisa disparar na hora, e na
+// janela de 10 s ela pode se somar à anterior sem mudar 10%
+static bool change_tracked(int i) {
+    if (i == 7) return false;
+    if (i >= FEATURE_WINDOW_OFFSET && i < FEATURE_WINDOW_OFFSET + FEATURE_M_COUNT) {
+        int m = i - FEATURE_WINDOW_OFFSET;
+        return m == FEATURE_M_DEAUTH || m == FEATURE_M_DEAUTH_BCAST || m == FEATURE_M_EVIL_TWIN;
     }
+    return i != FEATURE_GLOBAL_OFFSET + FEATURE_G_SINCE_DEAUTH &&
+           i != FEATURE_GLOBAL_OFFSET + FEATURE_G_SINCE_EVIL_TWIN;
+}
 
-    if (output->type != kTfLiteFloat32) {
-        Serial.println("[NEURA9] Tipo de tensor de saída inesperado (esperado float32)");
-        last_confidence = 0.0f;
-        return 0;
+// Alguma feature andou mais que NEURA9_SERVICE_DELTA desde a última
+// inferência (relativo ao valor anterior; abaixo de 1.0, absoluto)
+bool Neura9::features_changed() const {
+    for (int i = 0; i < NEURA9_FEATURE_COUNT; ++i) {
+        if (!change_tracked(i)) continue;
+        float ref = fabsf(last_features[i]);
+        if (fabsf(features[i] - last_features[i]) > NEURA9_SERVICE_DELTA * (ref > 1.0f ? ref : 1.0f)) {
+            return true;
+        }
     }
+    return false;
+}
 
-    int num_classes = output->bytes / static_cast<int>(sizeof(float));
-    if (num_classes > 10) {
-        num_classes = 10;
+void Neura9::publish(const Neura9Result& r) {
+    uint32_t s = result_seq.load(std::memory_order_relaxed);
+    result_seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    result = r;
+    result_seq.store(s + 2, std::memory_order_release);
+}
+
+bool Neura9::get_result(Neura9Result* out) const {
+    for (;;) {
+        uint32_t s = result_seq.load(std::memory_order_acquire);
+        if (s & 1) {
+            // Publicação em andamento (cópia de ~20 bytes)
+            taskYIELD();
+            continue;
+        }
+        *out = result;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (result_seq.load(std::memory_order_relaxed) == s) return out->seq != 0;
     }
+}
+
+void Neura9::service_entry(void* arg) {
+    static_cast<Neura9*>(arg)->service_loop();
+}
+
+void Neura9::service_loop() {
+    Neura9Result r = {};
+    bool have_last = false;
+
+    for (;;) {
+        bool requested = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NEURA9_SERVICE_TICK_MS)) > 0;
+
+        int64_t t0 = esp_timer_get_time();
+        extract_features();
+        uint32_t features_us = static_cast<uint32_t>(esp_timer_get_time() - t0);
+        uint32_t now = millis();
+
+        uint8_t trigger = NEURA9_TRIGGER_COUNT;
+        if (requested) {
+            trigger = NEURA9_TRIGGER_REQUEST;
+        } else if (!have_last || now - r.timestamp_ms >= NEURA9_SERVICE_PERIOD_MS) {
+            trigger = NEURA9_TRIGGER_PERIOD;
+        } else if (features_changed()) {
+            trigger = NEURA9_TRIGGER_CHANGE;
+        }
 
-    uint8_t best = 0;
-    float max_conf = output->data.f[0];
-    for (int i = 1; i < num_classes; ++i) {
-        if (output->data.f[i] > max_conf) {
-            max_conf = output->data.f[i];
-            best = static_cast<uint8_t>(i);
+        portENTER_CRITICAL(&stats_mux);
+        stats.checks++;
+        hist_add(stats.features_hist, features_us);
+        if (features_us > stats.features_us_max) stats.features_us_max = features_us;
+        if (trigger == NEURA9_TRIGGER_COUNT) stats.skipped++;
+        portEXIT_CRITICAL(&stats_mux);
+        if (trigger == NEURA9_TRIGGER_COUNT) continue;
+
+        memcpy(last_features, features, sizeof(last_features));
+        have_last = true;
+
+        float confidence = 0.0f;
+        bool fallback = true;
+        uint8_t cls = infer(&confidence, &fallback);
+        bool changed = r.seq == 0 || cls != r.cls;
+
+        r.seq++;
+        r.cls = cls;
+        r.trigger = trigger;
+        r.fallback = fallback;
+        r.confidence = confidence;
+        r.timestamp_ms = now;
+        r.invoke_us = fallback ? 0 : last_invoke_us;
+        publish(r);
+
+        portENTER_CRITICAL(&stats_mux);
+        stats.invocations++;
+        stats.by_trigger[trigger]++;
+        if (!fallback) {
+            hist_add(stats.invoke_hist, r.invoke_us);
+            if (r.invoke_us > stats.invoke_us_max) stats.invoke_us_max = r.invoke_us;
+        }
+        if (changed) stats.class_changes++;
+        portEXIT_CRITICAL(&stats_mux);
+
+        // Serial só quando a classe muda: o resto está em /api/neura9
+        if (changed) {
+            Serial.printf("[NEURA9] classe=%u (%s) conf=%.2f (%lu us)\n",
+                          cls, NEURA9_THREAT_LABELS[cls], confidence,
+                          (unsigned long)r.invoke_us);
         }
     }
+}
 
-    last_confidence = max_conf;
+bool Neura9::start_service() {
+    if (service_task) return true;
+    if (xTaskCreatePinnedToCore(service_entry,
+                                "neura9",
+                                NEURA9_TASK_STACK,
+                                this,
+                                NEURA9_TASK_PRIO,
+                                &service_task,
+                                NEURA9_TASK_CORE) != pdPASS) {
+        service_task = nullptr;
+        Serial.println("[NEURA9] Falha ao criar task neura9");
+        return false;
+    }
+    stats.running = true;
+    Serial.printf("[NEURA9] Servico: checagem a cada %u ms, inferencia a cada %u ms "
+                  "ou com mudanca > %.0f%%\n",
+                  (unsigned)NEURA9_SERVICE_TICK_MS, (unsigned)NEURA9_SERVICE_PERIOD_MS,
+                  NEURA9_SERVICE_DELTA * 100.0f);
+    return true;
+}
 
-    // Reação leve na UI conforme o perfil identificado.
-    switch (best) {
+bool Neura9::infer_now(uint32_t after_seq, Neura9Result* out, uint32_t timeout_ms) {
+    if (!service_task) return false;
+    xTaskNotifyGive(service_task);
+    uint32_t start = millis();
+    do {
+        if (get_result(out) && out->seq > after_seq) return true;
+        vTaskDelay(pdMS_TO_TICKS(5));
+    } while (millis() - start < timeout_ms);
+    return false;
+}
+
+void Neura9::get_stats(Neura9Stats* out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+// Reação leve na UI conforme o perfil identificado.
+void neura9_apply_mood(uint8_t cls) {
+    switch (cls) {
         case 0: // SAFE
             ui_set_mood(MOOD_HAPPY);
             break;
@@ -192,13 +572,62 @@ uint8_t Neura9::predict() {
         default:
             break;
     }
+}
 
-    Serial.printf("[NEURA9] classe=%u (%s) conf=%.2f\n",
-                  best,
-                  NEURA9_THREAT_LABELS[best],
-                  max_conf);
-
-    return best;
+String neura9_stats_json() {
+    Neura9Stats s;
+    neura9.get_stats(&s);
+    Neura9Result r;
+    bool have = neura9.get_result(&r);
+
+    static const char* TRIGGER_NAMES[NEURA9_TRIGGER_COUNT] = {"period", "change", "request"};
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             "{\"running\":%s,\"checks\":%lu,\"skipped\":%lu,\"invocations\":%lu,"
+             "\"failures\":%lu,\"class_changes\":%lu,\"by_trigger\":{",
+             s.running ? "true" : "false", (unsigned long)s.checks,
+             (unsigned long)s.skipped, (unsigned long)s.invocations,
+             (unsigned long)s.failures, (unsigned long)s.class_changes);
+    String out = buf;
+    for (int t = 0; t < NEURA9_TRIGGER_COUNT; ++t) {
+        snprintf(buf, sizeof(buf), "%s\"%s\":%lu", t ? "," : "", TRIGGER_NAMES[t],
+                 (unsigned long)s.by_trigger[t]);
+        out += buf;
+    }
+    // Histogramas: contagem por faixa, limites superiores em "edges_us"
+    // (o último balde é "acima do penúltimo")
+    out += "},\"edges_us\":[";
+    for (int b = 0; b < NEURA9_LATENCY_BUCKETS; ++b) {
+        snprintf(buf, sizeof(buf), "%s%lu", b ? "," : "", (unsigned long)NEURA9_LATENCY_EDGES[b]);
+        out += buf;
+    }
+    const uint32_t* hists[2] = {s.features_hist, s.invoke_hist};
+    const char* names[2] = {"features_hist", "invoke_hist"};
+    for (int h = 0; h < 2; ++h) {
+        out += "],\"";
+        out += names[h];
+        out += "\":[";
+        for (int b = 0; b < NEURA9_LATENCY_BUCKETS; ++b) {
+            snprintf(buf, sizeof(buf), "%s%lu", b ? "," : "", (unsigned long)hists[h][b]);
+            out += buf;
+        }
+    }
+    snprintf(buf, sizeof(buf), "],\"features_us_max\":%lu,\"invoke_us_max\":%lu,\"last\":",
+             (unsigned long)s.features_us_max, (unsigned long)s.invoke_us_max);
+    out += buf;
+    if (have) {
+        snprintf(buf, sizeof(buf),
+                 "{\"seq\":%lu,\"class\":%u,\"label\":\"%s\",\"confidence\":%.3f,"
+                 "\"t_ms\":%lu,\"invoke_us\":%lu,\"fallback\":%s}",
+                 (unsigned long)r.seq, r.cls, NEURA9_THREAT_LABELS[r.cls], r.confidence,
+                 (unsigned long)r.timestamp_ms, (unsigned long)r.invoke_us,
+                 r.fallback ? "true" : "false");
+        out += buf;
+    } else {
+        out += "null";
+    }
+    out += "}";
+    return out;
 }
 
 void Neura9::update_from_environment() {
@@ -207,7 +636,12 @@ void Neura9::update_from_environment() {
 }
 
 float Neura9::get_confidence() const {
-    return last_confidence;
+    Neura9Result r;
+    return get_result(&r) ? r.confidence : 0.0f;
+}
+
+uint32_t Neura9::get_invoke_us() const {
+    return last_invoke_us;
 }
 
 void Neura9::gesture_detection() {
@@ -219,8 +653,3 @@ void Neura9::battery_prediction() {
     // Futuro: usar histórico de consumo para prever drenagem e sugerir modos
     // de economia antes de atingir BATTERY_CRITICAL.
 }
-
-void Neura9::threat_detection() {
-    // Futuro: agregar estatísticas do sniffer para detectar padrões suspeitos
-    // (deauth em massa, APs mal configurados, etc.) e alimentar features.
-}
\ No newline at end of file
@@ -3,7 +3,18 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
+// Backend do modelo: TFLM com o .tflite embutido (padrão) ou, com
+// -DNEURA9_BACKEND_MLP=1, o MLP de ponto fixo gerado pelo trainer
+// (neura9/mlp.h + neura9/mlp_model.h), sem interpretador nem arena.
+#ifndef NEURA9_BACKEND_MLP
+#define NEURA9_BACKEND_MLP 0
+#endif
+
+#if !NEURA9_BACKEND_MLP
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -13,44 +24,148 @@
 #ifndef TFLITE_SCHEMA_VERSION
 #define TFLITE_SCHEMA_VERSION 3
 #endif
+#endif
+
+#include "neura9/features.h"
+
+// Serviço de inferência (task "neura9"): a cada NEURA9_SERVICE_TICK_MS lê
+// o vetor de features e só roda o modelo se alguma feature mudou mais que
+// NEURA9_SERVICE_DELTA (relativo, mínimo absoluto 1.0; fora relógios e a
+// janela de 1 s, menos deauth e evil twin) desde a última inferência, se
+// passou NEURA9_SERVICE_PERIOD_MS ou se alguém pediu (infer_now()).
+#ifndef NEURA9_SERVICE_PERIOD_MS
+#define NEURA9_SERVICE_PERIOD_MS 5000
+#endif
+#ifndef NEURA9_SERVICE_TICK_MS
+#define NEURA9_SERVICE_TICK_MS 250
+#endif
+#ifndef NEURA9_SERVICE_DELTA
+#define NEURA9_SERVICE_DELTA 0.10f
+#endif
+
+// Histogramas de latência: limites superiores (us) em NEURA9_LATENCY_EDGES
+#define NEURA9_LATENCY_BUCKETS 8
+
+enum Neura9Trigger : uint8_t {
+    NEURA9_TRIGGER_PERIOD = 0,
+    NEURA9_TRIGGER_CHANGE,
+    NEURA9_TRIGGER_REQUEST,
+    NEURA9_TRIGGER_COUNT,
+};
+
+// Resultado publicado: cópia imutável de uma inferência
+struct Neura9Result {
+    uint32_t seq;             // 1, 2, ...; 0 = nenhuma inferência ainda
+    uint8_t  cls;             // 0-9 (NEURA9_THREAT_LABELS)
+    uint8_t  trigger;         // Neura9Trigger
+    bool     fallback;        // heurística (sem modelo ou Invoke() falhou)
+    float    confidence;      // 0.0–1.0
+    uint32_t timestamp_ms;    // millis() da inferência
+    uint32_t invoke_us;
+};
+
+struct Neura9Stats {
+    bool     running;
+    uint32_t checks;                            // vetores lidos
+    uint32_t skipped;                           // sem mudança nem período
+    uint32_t invocations;
+    uint32_t by_trigger[NEURA9_TRIGGER_COUNT];
+    uint32_t failures;                          // Invoke() != kTfLiteOk
+    uint32_t class_changes;
+    uint32_t features_us_max;
+    uint32_t invoke_us_max;
+    uint32_t features_hist[NEURA9_LATENCY_BUCKETS];
+    uint32_t invoke_hist[NEURA9_LATENCY_BUCKETS];
+};
+
+extern const uint32_t NEURA9_LATENCY_EDGES[NEURA9_LATENCY_BUCKETS];
 
 // Encapsula a IA defensiva local NEURA9.
 class Neura9 {
 public:
-    // Inicializa TensorFlow Lite Micro e o modelo em RAM/PSRAM.
+    // Inicializa TensorFlow Lite Micro e o modelo em RAM/PSRAM (no backend
+    // MLP, só confere o modelo e mede a latência).
     bool begin();
 
-    // Executa inferência com base nas features atuais e retorna a classe 0-9.
-    uint8_t predict();
+    // Cria a task "neura9". Sem begin() bem-sucedido roda a heurística.
+    bool start_service();
+
+    // Último resultado publicado, sem lock (qualquer task). false se ainda
+    // não houve inferência.
+    bool get_result(Neura9Result* out) const;
+
+    // Acorda o serviço para uma inferência já (ex. modo ZUMBI) e espera um
+    // resultado com seq > after_seq por até timeout_ms.
+    bool infer_now(uint32_t after_seq, Neura9Result* out, uint32_t timeout_ms);
+
+    void get_stats(Neura9Stats* out);
 
     // Hook para ajustes leves a partir do ambiente (pode registrar eventos,
     // salvar estatísticas, etc. – implementação futura).
     void update_from_environment();
 
-    // Confiança (0.0–1.0) da última predição.
+    // Confiança (0.0–1.0) do último resultado publicado.
     float get_confidence() const;
 
+    // Duração do último Invoke() / run() do MLP (no begin(): média de
+    // referência).
+    uint32_t get_invoke_us() const;
+
 private:
+#if NEURA9_BACKEND_MLP
+    bool model_ready = false;
+#else
     tflite::MicroInterpreter* interpreter = nullptr;
     TfLiteTensor* input = nullptr;
     TfLiteTensor* output = nullptr;
 
-    // Arena dedicada à TFLM (alocada em PSRAM quando disponível).
-    uint8_t tensor_arena[160 * 1024];
+    // Arena da TFLM, do tamanho medido para o modelo (arena_used_bytes()),
+    // na PSRAM; na RAM interna sem PSRAM ou se o Invoke() ficar lento.
+    uint8_t* tensor_arena = nullptr;
+    size_t arena_size = 0;
+    bool arena_internal = false;
+#endif
+
+    // Vetor de entrada (layout em neura9/features.h).
+    float features[NEURA9_FEATURE_COUNT];
+
+    float last_features[NEURA9_FEATURE_COUNT];   // da última inferência
+    uint32_t last_invoke_us = 0;
 
-    // Vetor de entrada com até 72 features normalizadas.
-    float features[72];
+    // Publicação por seqlock: ímpar enquanto o serviço copia `result`;
+    // leitores repetem a cópia se o contador mudou no meio
+    std::atomic<uint32_t> result_seq{0};
+    Neura9Result result = {};
 
-    float last_confidence = 0.0f;
+    TaskHandle_t service_task = nullptr;
+    Neura9Stats stats = {};   // sob o stats_mux de inference.cpp
+
+#if !NEURA9_BACKEND_MLP
+    bool setup_arena(const tflite::Model* model, tflite::MicroOpResolver* resolver,
+                     size_t size, bool internal);
+    void release_arena();
+#endif
+    uint32_t bench_invoke();
+
+    static void service_entry(void* arg);
+    void service_loop();
+    bool features_changed() const;
+    uint8_t infer(float* confidence, bool* fallback);
+    void publish(const Neura9Result& r);
 
     void extract_features();
     void gesture_detection();
     void battery_prediction();
-    void threat_detection();
 };
 
 // Labels textuais das classes de risco/perfil de ambiente.
 extern const char* NEURA9_THREAT_LABELS[10];
 
+// Humor da UI para a classe. LVGL: só da task da UI (Pwnagotchi::update).
+void neura9_apply_mood(uint8_t cls);
+
+// Contadores e histogramas do serviço (GET /api/neura9).
+String neura9_stats_json();
+
 // Instância global utilizada pelo restante do firmware.
 extern Neura9 neura9;
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// MLP de ponto fixo da NEURA9 (backend sem TFLM, -DNEURA9_BACKEND_MLP=1).
+//
+// Os pesos vêm de ai/neura9_trainer.py --mlp-header (neura9/mlp_model.h):
+//
+// - Entrada: cada feature vira int16 com centro e escala próprios
+//   (q = lrintf((x - INPUT_CENTER[i]) * INPUT_INV_SCALE[i]), saturado);
+//   o centro já está descontado no bias da 1ª camada.
+// - Camadas densas: pesos int8 por linha [saída][entrada] com escala por
+//   neurônio, bias int32 na unidade do acumulador. acc = bias + Σ w·x em
+//   int32; a saída volta para int16 com multiplicador Q31 + shift
+//   (y = (acc·mult + 2^(shift-1)) >> shift), ReLU nas ocultas.
+// - Última camada: logits int16 com uma escala comum (OUTPUT_SCALE);
+//   argmax nos inteiros e softmax só para a confiança.
+//
+// O numpy do trainer (mlp_fixed_predict) faz exatamente a mesma conta:
+// tools/neura9/mlp_check.py confere bit a bit contra este código.
+//
+// Tamanhos das camadas como parâmetros do template: os laços internos têm
+// contagem fixa e pesos contíguos (o compilador desenrola/vetoriza; no S3
+// o ESP-NN não é usado). Sem `if constexpr`: o firmware compila em gnu++11.
+
+struct MlpLayer {
+    const int8_t*  weights;   // [saída][entrada]
+    const int32_t* bias;
+    const int32_t* mult;      // Q31
+    const uint8_t* shift;     // 1..62
+};
+
+namespace mlp_detail {
+
+template <int... S> struct First;
+template <int A, int... R> struct First<A, R...> { static const int value = A; };
+
+template <int... S> struct Last;
+template <int A> struct Last<A> { static const int value = A; };
+template <int A, int B, int... R> struct Last<A, B, R...> {
+    static const int value = Last<B, R...>::value;
+};
+
+template <int... S> struct Max;
+template <int A> struct Max<A> { static const int value = A; };
+template <int A, int B, int... R> struct Max<A, B, R...> {
+    static const int value = Max<(A > B ? A : B), R...>::value;
+};
+
+// Bytes de parâmetros: pesos int8 + (bias, mult, shift) por neurônio
+template <int... S> struct Params;
+template <int A> struct Params<A> { static const size_t value = 0; };
+template <int A, int B, int... R> struct Params<A, B, R...> {
+    static const size_t value = static_cast<size_t>(A) * B +
+                                static_cast<size_t>(B) * (2 * sizeof(int32_t) + 1) +
+                                Params<B, R...>::value;
+};
+
+template <bool Relu>
+inline int16_t requantize(int32_t acc, int32_t mult, uint8_t shift) {
+    int64_t v = (static_cast<int64_t>(acc) * mult + (static_cast<int64_t>(1) << (shift - 1))) >> shift;
+    const int64_t lo = Relu ? 0 : -32768;
+    return static_cast<int16_t>(v < lo ? lo : (v > 32767 ? 32767 : v));
+}
+
+template <int In, int Out, bool Relu>
+inline void dense(const int16_t* __restrict x, const MlpLayer& l, int16_t* __restrict y) {
+    const int8_t* __restrict w = l.weights;
+    for (int o = 0; o < Out; ++o, w += In) {
+        int32_t acc = 0;
+        for (int i = 0; i < In; ++i) {
+            acc += static_cast<int32_t>(w[i]) * x[i];
+        }
+        y[o] = requantize<Relu>(acc + l.bias[o], l.mult[o], l.shift[o]);
+    }
+}
+
+// Camada L de In para Out; x e y se alternam entre as camadas. Devolve o
+// buffer com a saída da última.
+template <int L, int... S> struct Forward;
+template <int L, int In, int Out> struct Forward<L, In, Out> {
+    static int16_t* run(const MlpLayer* layers, int16_t* x, int16_t* y) {
+        dense<In, Out, false>(x, layers[L], y);
+        return y;
+    }
+};
+template <int L, int In, int Out, int Next, int... R> struct Forward<L, In, Out, Next, R...> {
+    static int16_t* run(const MlpLayer* layers, int16_t* x, int16_t* y) {
+        dense<In, Out, true>(x, layers[L], y);
+        return Forward<L + 1, Out, Next, R...>::run(layers, y, x);
+    }
+};
+
+}  // namespace mlp_detail
+
+template <int... Sizes>
+class FixedMlp {
+public:
+    static const int kInputs = mlp_detail::First<Sizes...>::value;
+    static const int kOutputs = mlp_detail::Last<Sizes...>::value;
+    static const int kLayers = sizeof...(Sizes) - 1;
+    static const int kWidth = mlp_detail::Max<Sizes...>::value;
+
+    // Flash ocupada pelo modelo: parâmetros + centro/escala das entradas,
+    // escala da saída e a tabela de camadas
+    static const size_t kModelBytes = mlp_detail::Params<Sizes...>::value +
+                                      (2 * kInputs + 1) * sizeof(float) +
+                                      kLayers * sizeof(MlpLayer);
+
+    constexpr FixedMlp(const float* input_center, const float* input_inv_scale,
+                       const MlpLayer* layers, float output_scale)
+        : input_center(input_center), input_inv_scale(input_inv_scale), layers(layers),
+          output_scale(output_scale) {}
+
+    // Classe de maior logit (a primeira em empate) e a probabilidade dela.
+    // `logits` (kOutputs), se não nulo, recebe a saída inteira.
+    int run(const float* features, float* confidence, int16_t* logits = nullptr) const {
+        alignas(16) int16_t a[kWidth];
+        alignas(16) int16_t b[kWidth];
+        for (int i = 0; i < kInputs; ++i) {
+            float v = (features[i] - input_center[i]) * input_inv_scale[i];
+            v = v < -32768.0f ? -32768.0f : (v > 32767.0f ? 32767.0f : v);
+            a[i] = static_cast<int16_t>(lrintf(v));
+        }
+        const int16_t* out = mlp_detail::Forward<0, Sizes...>::run(layers, a, b);
+
+        int best = 0;
+        for (int k = 1; k < kOutputs; ++k) {
+            if (out[k] > out[best]) best = k;
+        }
+        float sum = 0.0f;
+        for (int k = 0; k < kOutputs; ++k) {
+            sum += expf((out[k] - out[best]) * output_scale);
+            if (logits) logits[k] = out[k];
+        }
+        *confidence = 1.0f / sum;
+        return best;
+    }
+
+private:
+    const float* input_center;
+    const float* input_inv_scale;
+    const MlpLayer* layers;
+    float output_scale;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+// Pesos do MLP de ponto fixo da NEURA9 (src/neura9/mlp.h).
+// Gerado por ai/neura9_trainer.py --mlp-header; não editar à mão.
+//
+// Placeholder (72 -> 10, tudo zero) enquanto não há modelo treinado, como
+// o ai/neura9_defense_model_data.cpp de exemplo: com ele o begin() do
+// backend MLP recusa o modelo e a NEURA9 fica na heurística.
+
+#include "neura9/mlp.h"
+
+#define NEURA9_MLP_PLACEHOLDER 1
+
+namespace neura9_mlp {
+
+typedef FixedMlp<72, 10> Model;
+
+constexpr float INPUT_CENTER[72] = {};
+constexpr float INPUT_INV_SCALE[72] = {};
+constexpr float OUTPUT_SCALE = 1.0f;
+
+alignas(16) constexpr int8_t W0[72 * 10] = {};
+constexpr int32_t B0[10] = {};
+constexpr int32_t M0[10] = {};
+constexpr uint8_t S0[10] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+constexpr MlpLayer LAYERS[Model::kLayers] = {
+    {W0, B0, M0, S0},
+};
+
+}  // namespace neura9_mlp
@@ -0,0 +1,11 @@
+#pragma once
+
+// Arena medida para o modelo em ai/neura9_defense_model_data.cpp.
+// Gerado por tools/neura9/record_arena.py a partir da linha
+// "[NEURA9] arena medida: ..." do boot; não editar à mão.
+//
+// Com CRC diferente do modelo embutido (modelo novo), o begin() mede de
+// novo com uma arena de sonda e loga o valor a gravar aqui.
+#define NEURA9_ARENA_MODEL_CRC 0x00000000u
+#define NEURA9_ARENA_MODEL_LEN 0
+#define NEURA9_ARENA_BYTES     0
@@ -0,0 +1,369 @@
+#include "utils/config_store.h"
+
+#include <ArduinoJson.h>
+
+#include "storage.h"
+
+// Core 0, prioridade mínima: só espera a coalescência; os arquivos em si
+// são lidos e gravados pela task sd (fila de logs)
+static const BaseType_t CONFIG_TASK_CORE = 0;
+static const UBaseType_t CONFIG_TASK_PRIO = 1;
+static const uint32_t CONFIG_TASK_STACK = 4096;
+
+// Um tamanho só para todos os JSON do /config
+static const size_t CONFIG_JSON_CAPACITY = 1024;
+
+static const char* const SECTION_PATHS[CONFIG_SECTION_COUNT] = {
+    CONFIG_DEVICE_PATH,
+    CONFIG_LAB_PATH,
+    CONFIG_GEMINI_PATH,
+};
+
+ConfigStore config_store;
+
+struct SemLock {
+    explicit SemLock(SemaphoreHandle_t sem) : sem(sem) {
+        if (sem) xSemaphoreTake(sem, portMAX_DELAY);
+    }
+    ~SemLock() {
+        if (sem) xSemaphoreGive(sem);
+    }
+    SemaphoreHandle_t sem;
+};
+
+// -----------------------------------------------------------------------------
+// Arquivos (task sd)
+// -----------------------------------------------------------------------------
+
+static String tmp_path(const char* path) {
+    return String(path) + ".tmp";
+}
+
+// Sobra de uma gravação interrompida: com o original presente, o .tmp pode
+// estar pela metade e é descartado; sem o original, o .tmp está completo (o
+// original só é removido depois do .tmp fechado) e assume o lugar dele.
+static void recover_file(const char* path) {
+    String tmp = tmp_path(path);
+    if (!SDCARD.exists(tmp)) return;
+
+    if (SDCARD.exists(path)) {
+        SDCARD.remove(tmp);
+    } else if (SDCARD.rename(tmp, path)) {
+        Serial.printf("[CONFIG] %s recuperado do .tmp\n", path);
+    }
+}
+
+static String read_file(const char* path) {
+    File f = SDCARD.open(path, FILE_READ);
+    if (!f) return String();
+    String content = f.readString();
+    f.close();
+    storage_account(content.length(), 0);
+    return content;
+}
+
+static bool write_file(const char* path, const String& content) {
+    if (!SDCARD.exists("/config") && !SDCARD.mkdir("/config")) {
+        Serial.println("[CONFIG] Falha ao criar /config");
+        return false;
+    }
+
+    String tmp = tmp_path(path);
+    File f = SDCARD.open(tmp, FILE_WRITE);
+    if (!f) {
+        Serial.printf("[CONFIG] Falha ao abrir %s\n", tmp.c_str());
+        return false;
+    }
+    size_t written = f.print(content);
+    f.flush();
+    f.close();
+    storage_account(0, written);
+    if (written != content.length()) {
+        Serial.printf("[CONFIG] Gravação incompleta de %s\n", tmp.c_str());
+        SDCARD.remove(tmp);
+        return false;
+    }
+
+    if (SDCARD.exists(path)) SDCARD.remove(path);
+    if (!SDCARD.rename(tmp, path)) {
+        Serial.printf("[CONFIG] Falha ao renomear %s\n", tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// begin(): recupera e lê os três arquivos num job só
+static void load_job(void* arg) {
+    String* contents = (String*)arg;
+    for (size_t i = 0; i < CONFIG_SECTION_COUNT; ++i) {
+        recover_file(SECTION_PATHS[i]);
+        contents[i] = read_file(SECTION_PATHS[i]);
+    }
+}
+
+struct SaveJob {
+    uint8_t pending;          // bit por ConfigSection
+    const String* contents;
+    uint8_t failed;
+};
+
+static void save_job(void* arg) {
+    SaveJob* job = (SaveJob*)arg;
+    for (size_t i = 0; i < CONFIG_SECTION_COUNT; ++i) {
+        if (!(job->pending & (1u << i))) continue;
+        if (!write_file(SECTION_PATHS[i], job->contents[i])) {
+            job->failed |= (uint8_t)(1u << i);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// ConfigStore
+// -----------------------------------------------------------------------------
+
+bool ConfigStore::valid_pin(const String& pin) {
+    if (pin.length() != 6) {
+        return false;
+    }
+    for (size_t i = 0; i < pin.length(); ++i) {
+        if (pin[i] < '0' || pin[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConfigStore::parse_device(const String& json, DeviceConfig* cfg, String* normalized) const {
+    DynamicJsonDocument doc(CONFIG_JSON_CAPACITY);
+    if (json.length() > 0) {
+        DeserializationError err = deserializeJson(doc, json);
+        if (err || !doc.is<JsonObject>()) {
+            return false;
+        }
+    } else {
+        doc.to<JsonObject>();
+    }
+
+    DeviceConfig c;
+    c.device_name         = doc["device_name"]         | c.device_name;
+    c.assistant           = doc["assistant"]           | c.assistant;
+    c.language            = doc["language"]            | c.language;
+    c.theme               = doc["theme"]               | c.theme;
+    c.owner               = doc["owner"]               | c.owner;
+    c.enable_voice_alerts = doc["enable_voice_alerts"] | c.enable_voice_alerts;
+    c.neura9_sensitivity  = doc["neura9_sensitivity"]  | c.neura9_sensitivity;
+
+    c.device_name.trim();
+    c.assistant.trim();
+    c.language.trim();
+    c.theme.trim();
+    c.owner.trim();
+    if (c.assistant.length() == 0) {
+        c.assistant = "none";
+    }
+
+    // Campos que o firmware não conhece continuam no arquivo
+    doc["device_name"]         = c.device_name;
+    doc["assistant"]           = c.assistant;
+    doc["language"]            = c.language;
+    doc["theme"]               = c.theme;
+    doc["owner"]               = c.owner;
+    doc["enable_voice_alerts"] = c.enable_voice_alerts;
+    doc["neura9_sensitivity"]  = c.neura9_sensitivity;
+
+    normalized->clear();
+    serializeJson(doc, *normalized);
+    *cfg = c;
+    return true;
+}
+
+bool ConfigStore::begin() {
+    if (!mutex) mutex = xSemaphoreCreateMutex();
+    if (!io_mutex) io_mutex = xSemaphoreCreateMutex();
+    if (!wake) wake = xSemaphoreCreateBinary();
+
+    String files[CONFIG_SECTION_COUNT];
+    storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_CONFIG, load_job, files);
+
+    DeviceConfig cfg;
+    String raw;
+    const String& stored = files[CONFIG_DEVICE];
+    if (stored.length() == 0) {
+        Serial.println("[CONFIG] device_config.json não encontrado em /config — usando defaults");
+        parse_device(String(), &cfg, &raw);
+    } else if (!parse_device(stored, &cfg, &raw)) {
+        Serial.println("[CONFIG] device_config.json inválido — usando defaults");
+        parse_device(String(), &cfg, &raw);
+    }
+
+    String lab_pin_value;
+    const String& lab = files[CONFIG_LAB];
+    if (lab.length() > 0) {
+        DynamicJsonDocument doc(CONFIG_JSON_CAPACITY);
+        if (!deserializeJson(doc, lab)) {
+            const char* p = doc["lab_pin"];
+            if (p && valid_pin(String(p))) {
+                lab_pin_value = p;
+            }
+        }
+    }
+
+    String key_value = files[CONFIG_GEMINI];
+    int nl = key_value.indexOf('\n');
+    if (nl >= 0) key_value = key_value.substring(0, nl);
+    key_value.trim();
+
+    {
+        SemLock lock(mutex);
+        device_cfg = cfg;
+        device_raw = raw;
+        pin = lab_pin_value;
+        key = key_value;
+        dirty = 0;
+    }
+
+    Serial.printf("[CONFIG] device_name='%s', assistant='%s', lab_pin=%s, gemini_key=%s\n",
+                  cfg.device_name.c_str(),
+                  cfg.assistant.c_str(),
+                  lab_pin_value.length() ? "sim" : "não",
+                  key_value.length() ? "sim" : "não");
+
+    if (!task_handle &&
+        xTaskCreatePinnedToCore(task_main,
+                                "cfg_store",
+                                CONFIG_TASK_STACK,
+                                this,
+                                CONFIG_TASK_PRIO,
+                                &task_handle,
+                                CONFIG_TASK_CORE) != pdPASS) {
+        task_handle = nullptr;
+        Serial.println("[CONFIG] Falha ao criar task cfg_store (gravação só com flush())");
+        return false;
+    }
+    return true;
+}
+
+DeviceConfig ConfigStore::device() const {
+    SemLock lock(mutex);
+    return device_cfg;
+}
+
+String ConfigStore::device_json() const {
+    SemLock lock(mutex);
+    return device_raw;
+}
+
+String ConfigStore::lab_pin() const {
+    SemLock lock(mutex);
+    return pin;
+}
+
+String ConfigStore::gemini_key() const {
+    SemLock lock(mutex);
+    return key;
+}
+
+bool ConfigStore::set_device_json(const String& json) {
+    DeviceConfig cfg;
+    String raw;
+    if (json.length() == 0 || !parse_device(json, &cfg, &raw)) {
+        return false;
+    }
+    {
+        SemLock lock(mutex);
+        device_cfg = cfg;
+        device_raw = raw;
+    }
+    changed(CONFIG_DEVICE);
+    return true;
+}
+
+bool ConfigStore::set_lab_pin(const String& value) {
+    if (!valid_pin(value)) {
+        return false;
+    }
+    {
+        SemLock lock(mutex);
+        pin = value;
+    }
+    changed(CONFIG_LAB);
+    return true;
+}
+
+bool ConfigStore::set_gemini_key(const String& value) {
+    String k = value;
+    k.trim();
+    if (k.length() == 0 || k.indexOf('\n') >= 0) {
+        return false;
+    }
+    {
+        SemLock lock(mutex);
+        key = k;
+    }
+    changed(CONFIG_GEMINI);
+    return true;
+}
+
+bool ConfigStore::subscribe(ConfigListener fn, void* ctx) {
+    SemLock lock(mutex);
+    if (!fn || listener_count >= CONFIG_STORE_LISTENERS) {
+        return false;
+    }
+    listeners[listener_count++] = Listener{fn, ctx};
+    return true;
+}
+
+void ConfigStore::changed(ConfigSection section) {
+    Listener copy[CONFIG_STORE_LISTENERS];
+    size_t n;
+    {
+        SemLock lock(mutex);
+        dirty |= (uint8_t)(1u << section);
+        n = listener_count;
+        for (size_t i = 0; i < n; ++i) copy[i] = listeners[i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        copy[i].fn(section, copy[i].ctx);
+    }
+    if (wake) xSemaphoreGive(wake);
+}
+
+void ConfigStore::flush() {
+    SemLock io(io_mutex);
+
+    // Cópia do que está sujo; setters continuam livres durante a gravação
+    uint8_t pending;
+    String contents[CONFIG_SECTION_COUNT];
+    {
+        SemLock lock(mutex);
+        pending = dirty;
+        dirty = 0;
+        if (pending & (1u << CONFIG_DEVICE)) contents[CONFIG_DEVICE] = device_raw;
+        if (pending & (1u << CONFIG_LAB)) contents[CONFIG_LAB] = "{\"lab_pin\":\"" + pin + "\"}";
+        if (pending & (1u << CONFIG_GEMINI)) contents[CONFIG_GEMINI] = key + "\n";
+    }
+
+    if (!pending) return;
+    SaveJob job = {pending, contents, 0};
+    storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_CONFIG, save_job, &job);
+
+    // O que falhou volta a ficar sujo e sai na próxima alteração / flush()
+    if (job.failed) {
+        SemLock lock(mutex);
+        dirty |= job.failed;
+    }
+}
+
+void ConfigStore::task_main(void* arg) {
+    ConfigStore* self = static_cast<ConfigStore*>(arg);
+    for (;;) {
+        xSemaphoreTake(self->wake, portMAX_DELAY);
+
+        // Espera as alterações pararem (cada setter acorda a task de novo)
+        uint32_t first = millis();
+        while (millis() - first < CONFIG_STORE_MAX_DELAY_MS &&
+               xSemaphoreTake(self->wake, pdMS_TO_TICKS(CONFIG_STORE_COALESCE_MS)) == pdTRUE) {
+        }
+        self->flush();
+    }
+}
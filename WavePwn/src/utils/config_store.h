@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Configuração do /config em RAM.
+//
+// Os arquivos são lidos uma vez no boot (begin(), logo após o initSD); daí
+// em diante os getters só copiam da RAM, sob um mutex, de qualquer task.
+// Os setters atualizam a RAM na hora, avisam os assinantes e marcam a seção
+// como suja; a task "cfg_store" grava quando as mudanças param de chegar
+// por CONFIG_STORE_COALESCE_MS (várias alterações seguidas = uma gravação).
+//
+// Cada gravação vai para "<arquivo>.tmp" e só então substitui o original
+// (remove + rename, já que o rename da FAT não sobrescreve). Queda de
+// energia no meio deixa o arquivo antigo ou o .tmp completo, que o begin()
+// seguinte recupera; nunca um JSON pela metade.
+
+#define CONFIG_DEVICE_PATH   "/config/device_config.json"
+#define CONFIG_LAB_PATH      "/config/lab_config.json"
+#define CONFIG_GEMINI_PATH   "/config/gemini_key.txt"
+
+#define CONFIG_STORE_COALESCE_MS  500
+#define CONFIG_STORE_MAX_DELAY_MS 3000   // teto com alterações contínuas
+#define CONFIG_STORE_LISTENERS    4
+
+enum ConfigSection : uint8_t {
+    CONFIG_DEVICE = 0,   // device_config.json
+    CONFIG_LAB,          // lab_config.json (PIN)
+    CONFIG_GEMINI,       // gemini_key.txt
+    CONFIG_SECTION_COUNT,
+};
+
+// device_config.json com os padrões já aplicados
+struct DeviceConfig {
+    String device_name = "CyberGuard Pro";
+    String assistant = "none";          // "alexa" | "google" | "both" | "none"
+    String language = "pt-BR";
+    String theme = "dark";
+    String owner = "";
+    bool enable_voice_alerts = true;
+    float neura9_sensitivity = 0.78f;
+};
+
+// Chamado na task de quem fez a alteração, fora do mutex. Deve ser rápido
+// (marcar uma flag, copiar um valor).
+typedef void (*ConfigListener)(ConfigSection section, void* ctx);
+
+class ConfigStore {
+public:
+    // Lê os arquivos e sobe a task de gravação. Sem SD, fica com os padrões.
+    bool begin();
+
+    DeviceConfig device() const;
+    // JSON completo (campos desconhecidos preservados + padrões), pronto
+    // para o GET /api/config/device
+    String device_json() const;
+    String lab_pin() const;             // "" = não configurado
+    String gemini_key() const;          // "" = não configurada
+
+    // false: JSON inválido / PIN fora do formato (nada muda)
+    bool set_device_json(const String& json);
+    bool set_lab_pin(const String& pin);
+    bool set_gemini_key(const String& key);
+
+    bool subscribe(ConfigListener fn, void* ctx);
+
+    // Grava agora o que estiver pendente (ex. antes de reiniciar). Bloqueia
+    // no SD: não chamar do AsyncTCP nem do loop da UI.
+    void flush();
+
+    static bool valid_pin(const String& pin);
+
+private:
+    struct Listener {
+        ConfigListener fn;
+        void* ctx;
+    };
+
+    mutable SemaphoreHandle_t mutex = nullptr;   // estado em RAM
+    SemaphoreHandle_t io_mutex = nullptr;        // uma gravação por vez
+    SemaphoreHandle_t wake = nullptr;            // setter -> task
+    TaskHandle_t task_handle = nullptr;
+
+    DeviceConfig device_cfg;
+    String device_raw;                  // JSON como será gravado
+    String pin;
+    String key;
+    uint8_t dirty = 0;                  // bit por ConfigSection
+
+    Listener listeners[CONFIG_STORE_LISTENERS] = {};
+    size_t listener_count = 0;
+
+    bool parse_device(const String& json, DeviceConfig* cfg, String* normalized) const;
+    void changed(ConfigSection section);
+    static void task_main(void* arg);
+};
+
+extern ConfigStore config_store;
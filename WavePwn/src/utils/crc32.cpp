@@ -0,0 +1,30 @@
+#include "utils/crc32.h"
+
+// Tabela de 256 entradas gerada em tempo de compilação: fica em .rodata
+// (flash), sem estado mutável nem inicialização preguiçosa, então pode ser
+// usada de qualquer task ao mesmo tempo. O firmware compila como gnu++11,
+// daí a recursão em vez de laços no constexpr.
+static constexpr uint32_t crc32_bits(uint32_t c, int k) {
+    return k == 0 ? c
+                  : crc32_bits((c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1), k - 1);
+}
+
+#define CRC32_T1(i)   crc32_bits((i), 8)
+#define CRC32_T4(i)   CRC32_T1(i), CRC32_T1((i) + 1), CRC32_T1((i) + 2), CRC32_T1((i) + 3)
+#define CRC32_T16(i)  CRC32_T4(i), CRC32_T4((i) + 4), CRC32_T4((i) + 8), CRC32_T4((i) + 12)
+#define CRC32_T64(i)  CRC32_T16(i), CRC32_T16((i) + 16), CRC32_T16((i) + 32), CRC32_T16((i) + 48)
+#define CRC32_T256(i) CRC32_T64(i), CRC32_T64((i) + 64), CRC32_T64((i) + 128), CRC32_T64((i) + 192)
+
+static constexpr uint32_t crc_table[256] = {CRC32_T256(0u)};
+
+static_assert(crc_table[1] == 0x77073096u && crc_table[255] == 0x2D02EF8Du,
+              "tabela CRC-32 incorreta");
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    while (len--) {
+        crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
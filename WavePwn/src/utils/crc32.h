@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 IEEE 802.3 (mesmo do zlib/PNG: polinômio 0xEDB88320, refletido).
+// `crc` permite calcular em pedaços: crc32_update(crc32_update(0, a), b).
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
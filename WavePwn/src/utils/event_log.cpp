@@ -0,0 +1,471 @@
+#include "utils/event_log.h"
+
+#include <atomic>
+#include <string.h>
+#include <time.h>
+
+#include "storage.h"
+#include "utils/crc32.h"
+
+static const uint8_t SEG_MAGIC[4] = {'W', 'P', 'E', 'L'};
+static const uint32_t SEG_HEADER_SIZE = 16;
+static const uint32_t REC_HEADER_SIZE = 12;
+static const uint32_t FILE_SIZE = (uint32_t)EVENT_LOG_SEGMENTS * EVENT_LOG_SEGMENT_SIZE;
+
+// Lote de escrita e janela de leitura (um registro cabe inteiro nos dois)
+static const uint32_t STAGE_SIZE = 4096;
+static const uint32_t WINDOW_SIZE = 2048;
+
+static inline uint32_t pad4(uint32_t len) { return (len + 3) & ~3u; }
+static inline void put_u16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void put_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline uint16_t get_u16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+static inline uint32_t get_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+// -----------------------------------------------------------------------------
+// Fila em RAM: anel de slots com reserva por CAS (vários produtores) e um
+// consumidor só, o job da task sd. `turn` diz de quem é o slot na volta
+// pos / EVENT_LOG_QUEUE_LEN: 2*volta = livre para o produtor, 2*volta+1 =
+// linha pronta para o consumidor. Zero = livre na primeira volta, então a
+// fila não precisa de inicialização.
+// -----------------------------------------------------------------------------
+
+struct QueueSlot {
+    std::atomic<uint32_t> turn;
+    uint32_t time;
+    uint8_t source;
+    uint8_t flags;
+    uint16_t len;
+    char text[EVENT_LOG_TEXT_MAX];
+};
+
+static QueueSlot queue[EVENT_LOG_QUEUE_LEN];
+static std::atomic<uint32_t> enqueue_pos{0};
+static std::atomic<uint32_t> dequeue_pos{0};   // só a task sd avança
+static std::atomic<bool> flush_queued{false};
+static std::atomic<uint32_t> appended{0};
+static std::atomic<uint32_t> dropped{0};
+static std::atomic<uint32_t> last_flush_ms{0};
+
+static inline uint32_t lap_turn(uint32_t pos) {
+    return (pos / EVENT_LOG_QUEUE_LEN) * 2;
+}
+
+// -----------------------------------------------------------------------------
+// Arquivo (só na task sd)
+// -----------------------------------------------------------------------------
+
+static File file;
+static bool ready = false;
+static uint32_t seg_first[EVENT_LOG_SEGMENTS];   // 0 = sem cabeçalho válido
+static uint32_t cur_seg = 0;
+static uint32_t cur_off = 0;                     // fim dos dados no segmento
+static uint32_t next_seq = 1;
+
+static uint8_t* stage = nullptr;
+static uint32_t stage_pos = 0;   // offset no arquivo do stage[0]
+static uint32_t stage_len = 0;
+
+static uint8_t* window = nullptr;
+static uint32_t window_pos = 0;
+static uint32_t window_len = 0;
+
+// Publicados para event_log_get_stats()
+static std::atomic<uint32_t> stat_first{0};
+static std::atomic<uint32_t> stat_next{1};
+static std::atomic<uint32_t> stat_batches{0};
+static std::atomic<bool> stat_ready{false};
+
+static bool read_at(uint32_t pos, void* dst, uint32_t len) {
+    if (pos < window_pos || pos + len > window_pos + window_len) {
+        window_len = 0;
+        if (!file.seek(pos)) return false;
+        window_len = (uint32_t)file.read(window, WINDOW_SIZE);
+        window_pos = pos;
+        storage_account(window_len, 0);
+        if (len > window_len) return false;
+    }
+    memcpy(dst, window + (pos - window_pos), len);
+    return true;
+}
+
+static bool stage_write() {
+    if (stage_len == 0) return true;
+    uint32_t len = stage_len;
+    size_t n = file.seek(stage_pos) ? file.write(stage, len) : 0;
+    storage_account(0, n);
+    stat_batches.fetch_add(1, std::memory_order_relaxed);
+    stage_pos += len;
+    stage_len = 0;
+    window_len = 0;   // a janela pode ter o conteúdo antigo
+    if (n != len) {
+        Serial.println("[LOG] Falha ao gravar o anel de eventos no SD");
+        return false;
+    }
+    return true;
+}
+
+static void stage_append(const uint8_t* data, uint32_t len) {
+    if (stage_len + len > STAGE_SIZE) {
+        stage_write();
+    }
+    memcpy(stage + stage_len, data, len);
+    stage_len += len;
+}
+
+static uint32_t oldest_seq() {
+    for (uint32_t i = 1; i <= EVENT_LOG_SEGMENTS; ++i) {
+        uint32_t s = (cur_seg + i) % EVENT_LOG_SEGMENTS;
+        if (seg_first[s]) return seg_first[s];
+    }
+    return next_seq;
+}
+
+static void publish_state() {
+    stat_first.store(oldest_seq(), std::memory_order_relaxed);
+    stat_next.store(next_seq, std::memory_order_relaxed);
+}
+
+// Começa `seg` com o próximo seq; o cabeçalho vai no mesmo lote
+static void start_segment(uint32_t seg) {
+    stage_write();
+    cur_seg = seg;
+    cur_off = SEG_HEADER_SIZE;
+    seg_first[seg] = next_seq;
+    stage_pos = seg * EVENT_LOG_SEGMENT_SIZE;
+
+    uint8_t hdr[SEG_HEADER_SIZE];
+    memcpy(hdr, SEG_MAGIC, 4);
+    put_u16(hdr + 4, EVENT_LOG_VERSION);
+    put_u16(hdr + 6, SEG_HEADER_SIZE);
+    put_u32(hdr + 8, next_seq);
+    put_u32(hdr + 12, crc32_update(0, hdr, 12));
+    stage_append(hdr, sizeof(hdr));
+}
+
+static uint32_t read_segment_header(uint32_t seg) {
+    uint8_t hdr[SEG_HEADER_SIZE];
+    if (!read_at(seg * EVENT_LOG_SEGMENT_SIZE, hdr, sizeof(hdr))) return 0;
+    if (memcmp(hdr, SEG_MAGIC, 4) != 0 || get_u16(hdr + 4) != EVENT_LOG_VERSION ||
+        get_u32(hdr + 12) != crc32_update(0, hdr, 12)) {
+        return 0;
+    }
+    return get_u32(hdr + 8);
+}
+
+// Registro em seg/off com o seq esperado; *size = bytes ocupados
+static bool read_record(uint32_t seg, uint32_t off, uint32_t seq, EventRecord* rec, uint32_t* size) {
+    if (off + REC_HEADER_SIZE + 4 > EVENT_LOG_SEGMENT_SIZE) return false;
+    uint32_t base = seg * EVENT_LOG_SEGMENT_SIZE + off;
+    uint8_t hdr[REC_HEADER_SIZE];
+    if (!read_at(base, hdr, sizeof(hdr))) return false;
+    uint16_t len = get_u16(hdr + 10);
+    if (get_u32(hdr) != seq || len > EVENT_LOG_TEXT_MAX) return false;
+    uint32_t total = REC_HEADER_SIZE + pad4(len) + 4;
+    if (off + total > EVENT_LOG_SEGMENT_SIZE) return false;
+
+    uint8_t crc_bytes[4];
+    if (!read_at(base + REC_HEADER_SIZE, rec->text, len) ||
+        !read_at(base + REC_HEADER_SIZE + pad4(len), crc_bytes, 4)) {
+        return false;
+    }
+    uint32_t crc = crc32_update(crc32_update(0, hdr, sizeof(hdr)), rec->text, len);
+    if (crc != get_u32(crc_bytes)) return false;
+
+    rec->seq = seq;
+    rec->time = get_u32(hdr + 4);
+    rec->source = hdr[8];
+    rec->flags = hdr[9];
+    rec->len = len;
+    rec->text[len] = 0;
+    *size = total;
+    return true;
+}
+
+// Fila -> lote(s) no arquivo, um fsync no fim
+static void drain() {
+    if (!ready) return;
+
+    bool wrote = false;
+    uint32_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        QueueSlot& slot = queue[pos % EVENT_LOG_QUEUE_LEN];
+        uint32_t full = lap_turn(pos) + 1;
+        if (slot.turn.load(std::memory_order_acquire) != full) break;
+
+        uint32_t total = REC_HEADER_SIZE + pad4(slot.len) + 4;
+        if (cur_off + total > EVENT_LOG_SEGMENT_SIZE) {
+            start_segment((cur_seg + 1) % EVENT_LOG_SEGMENTS);
+        }
+        uint8_t rec[REC_HEADER_SIZE + EVENT_LOG_TEXT_MAX + 3 + 4];
+        put_u32(rec, next_seq);
+        put_u32(rec + 4, slot.time);
+        rec[8] = slot.source;
+        rec[9] = slot.flags;
+        put_u16(rec + 10, slot.len);
+        memcpy(rec + REC_HEADER_SIZE, slot.text, slot.len);
+        memset(rec + REC_HEADER_SIZE + slot.len, 0, pad4(slot.len) - slot.len);
+        put_u32(rec + total - 4, crc32_update(0, rec, REC_HEADER_SIZE + slot.len));
+
+        // O slot volta para os produtores assim que a linha foi copiada
+        slot.turn.store(full + 1, std::memory_order_release);
+        dequeue_pos.store(++pos, std::memory_order_relaxed);
+
+        if (stage_len == 0) {
+            stage_pos = cur_seg * EVENT_LOG_SEGMENT_SIZE + cur_off;
+        }
+        stage_append(rec, total);
+        cur_off += total;
+        next_seq++;
+        wrote = true;
+    }
+    if (!wrote) return;
+
+    stage_write();
+    file.flush();
+    publish_state();
+}
+
+static void drain_job(void*) {
+    flush_queued.store(false);
+    last_flush_ms.store(millis(), std::memory_order_relaxed);
+    drain();
+}
+
+static void request_flush() {
+    if (flush_queued.exchange(true)) return;
+    if (!storage_submit(STORAGE_PRIO_LOG, STORAGE_CLIENT_LOG, drain_job, nullptr)) {
+        flush_queued.store(false);   // tenta de novo no próximo append/poll
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Abertura e recuperação
+// -----------------------------------------------------------------------------
+
+// Cria o arquivo com o tamanho final (zeros: nenhum segmento válido)
+static bool create_file() {
+    if (!SDCARD.exists("/sd/lab_logs")) {
+        SDCARD.mkdir("/sd/lab_logs");
+    }
+    File f = SDCARD.open(EVENT_LOG_PATH, FILE_WRITE);
+    if (!f) return false;
+    memset(stage, 0, STAGE_SIZE);
+    uint32_t written = 0;
+    while (written < FILE_SIZE) {
+        size_t n = f.write(stage, STAGE_SIZE);
+        storage_account(0, n);
+        if (n != STAGE_SIZE) break;
+        written += n;
+    }
+    f.close();
+    return written == FILE_SIZE;
+}
+
+static void begin_job(void* arg) {
+    bool* ok = (bool*)arg;
+    *ok = false;
+
+    if (file) file.close();
+    ready = false;
+    stage_len = 0;
+    window_len = 0;
+
+    if (!stage) stage = (uint8_t*)storage_dma_alloc(STAGE_SIZE);
+    if (!window) window = (uint8_t*)storage_dma_alloc(WINDOW_SIZE);
+    if (!stage || !window) {
+        Serial.println("[LOG] Sem memoria para o anel de eventos");
+        return;
+    }
+
+    file = SDCARD.open(EVENT_LOG_PATH, "r+");
+    if (!file || file.size() != FILE_SIZE) {
+        if (file) file.close();
+        Serial.printf("[LOG] Criando %s (%u KB)\n", EVENT_LOG_PATH, (unsigned)(FILE_SIZE / 1024));
+        if (!create_file()) {
+            Serial.printf("[LOG] Falha ao criar %s\n", EVENT_LOG_PATH);
+            return;
+        }
+        file = SDCARD.open(EVENT_LOG_PATH, "r+");
+        if (!file) return;
+    }
+
+    // Segmento atual = maior primeiro seq; o fim dele = último registro
+    // encadeado
+    uint32_t best = 0;
+    for (uint32_t s = 0; s < EVENT_LOG_SEGMENTS; ++s) {
+        seg_first[s] = read_segment_header(s);
+        if (seg_first[s] > seg_first[best]) best = s;
+    }
+    ready = true;
+    if (seg_first[best] == 0) {
+        next_seq = 1;
+        start_segment(0);
+    } else {
+        cur_seg = best;
+        cur_off = SEG_HEADER_SIZE;
+        next_seq = seg_first[best];
+        EventRecord rec;
+        uint32_t size;
+        while (read_record(cur_seg, cur_off, next_seq, &rec, &size)) {
+            cur_off += size;
+            next_seq++;
+        }
+    }
+    publish_state();
+    stat_ready.store(true);
+    Serial.printf("[LOG] Anel de eventos: seq %lu..%lu, segmento %lu\n",
+                  (unsigned long)oldest_seq(), (unsigned long)(next_seq - 1),
+                  (unsigned long)cur_seg);
+    *ok = true;
+}
+
+bool event_log_begin() {
+    bool ok = false;
+    storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_LOG, begin_job, &ok);
+    if (ok) {
+        event_log_append(EVENT_SRC_SYSTEM, "boot");
+        request_flush();
+    }
+    return ok;
+}
+
+bool event_log_append(EventSource source, const char* text) {
+    uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    QueueSlot* slot;
+    for (;;) {
+        slot = &queue[pos % EVENT_LOG_QUEUE_LEN];
+        uint32_t turn = slot->turn.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(turn - lap_turn(pos));
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Slot ainda com a linha de uma volta atrás: fila cheia
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            request_flush();
+            return false;
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    time_t now = time(nullptr);
+    if (now > 1600000000) {   // RTC/NTP ajustado
+        slot->time = (uint32_t)now;
+        slot->flags = EVENT_FLAG_EPOCH;
+    } else {
+        slot->time = millis() / 1000;
+        slot->flags = 0;
+    }
+    slot->source = source;
+    size_t len = text ? strnlen(text, EVENT_LOG_TEXT_MAX) : 0;
+    memcpy(slot->text, text, len);
+    slot->len = (uint16_t)len;
+    slot->turn.store(lap_turn(pos) + 1, std::memory_order_release);
+    appended.fetch_add(1, std::memory_order_relaxed);
+
+    if (pos + 1 - dequeue_pos.load(std::memory_order_relaxed) >= EVENT_LOG_FLUSH_LINES) {
+        request_flush();
+    }
+    return true;
+}
+
+void event_log_poll(uint32_t now_ms) {
+    if (enqueue_pos.load(std::memory_order_relaxed) == dequeue_pos.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (now_ms - last_flush_ms.load(std::memory_order_relaxed) >= EVENT_LOG_FLUSH_MS) {
+        request_flush();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Leitura
+// -----------------------------------------------------------------------------
+
+struct ReadJob {
+    uint32_t from;
+    EventRecord* out;
+    size_t max;
+    size_t count;
+    uint32_t next;
+};
+
+static void read_job(void* arg) {
+    ReadJob* job = (ReadJob*)arg;
+    job->count = 0;
+    job->next = job->from;
+    if (!ready) return;
+
+    drain();
+    uint32_t first = oldest_seq();
+    uint32_t from = job->from < first ? first : job->from;
+    if (from >= next_seq) {
+        job->next = from > next_seq ? next_seq : from;
+        return;
+    }
+
+    // Segmento de partida: o último, em ordem de idade, que começa em ou
+    // antes de `from`
+    uint32_t seg = cur_seg;
+    uint32_t age = 0;   // segmentos depois do mais antigo
+    for (uint32_t i = 1; i <= EVENT_LOG_SEGMENTS; ++i) {
+        uint32_t s = (cur_seg + i) % EVENT_LOG_SEGMENTS;
+        if (seg_first[s] && seg_first[s] <= from) {
+            seg = s;
+            age = i;
+        }
+    }
+
+    uint32_t off = SEG_HEADER_SIZE;
+    uint32_t seq = seg_first[seg];
+    EventRecord rec;
+    uint32_t size;
+    while (job->count < job->max && seq < next_seq) {
+        if (!read_record(seg, off, seq, &rec, &size)) {
+            // Fim do segmento: o próximo tem que continuar a sequência
+            if (age >= EVENT_LOG_SEGMENTS) break;
+            seg = (seg + 1) % EVENT_LOG_SEGMENTS;
+            age++;
+            if (seg_first[seg] != seq) break;
+            off = SEG_HEADER_SIZE;
+            continue;
+        }
+        if (seq >= from) {
+            job->out[job->count++] = rec;
+        }
+        off += size;
+        seq++;
+    }
+    job->next = seq;
+}
+
+size_t event_log_read(uint32_t from_seq, EventRecord* out, size_t max, uint32_t* next_seq_out) {
+    ReadJob job = {from_seq, out, max, 0, from_seq};
+    if (out && max > 0) {
+        storage_call(STORAGE_PRIO_LOG, STORAGE_CLIENT_LOG, read_job, &job);
+    }
+    if (next_seq_out) *next_seq_out = job.next;
+    return job.count;
+}
+
+void event_log_get_stats(EventLogStats* out) {
+    if (!out) return;
+    out->ready = stat_ready.load();
+    out->first_seq = stat_first.load(std::memory_order_relaxed);
+    out->next_seq = stat_next.load(std::memory_order_relaxed);
+    out->pending = enqueue_pos.load(std::memory_order_relaxed) -
+                   dequeue_pos.load(std::memory_order_relaxed);
+    out->appended = appended.load(std::memory_order_relaxed);
+    out->dropped = dropped.load(std::memory_order_relaxed);
+    out->batches = stat_batches.load(std::memory_order_relaxed);
+}
+
+const char* event_source_name(uint8_t source) {
+    switch (source) {
+        case EVENT_SRC_SYSTEM: return "system";
+        case EVENT_SRC_LAB: return "lab";
+        case EVENT_SRC_WEB: return "web";
+        default: return "?";
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Log de eventos (lab, servidor web) num arquivo em anel no SD.
+//
+// event_log_append() só copia a linha para uma fila em RAM sem locks (um
+// slot reservado por compare-and-swap): pode ser chamado de qualquer task
+// e nunca espera o cartão. Um job da task sd (fila LOG) esvazia a fila em
+// lote quando ela junta EVENT_LOG_FLUSH_LINES linhas ou a cada
+// EVENT_LOG_FLUSH_MS (event_log_poll, loop da UI).
+//
+// O arquivo é criado uma vez com o tamanho final (EVENT_LOG_SEGMENTS
+// segmentos de EVENT_LOG_SEGMENT_SIZE) e nunca cresce nem é reaberto: um
+// lote é um write no meio do arquivo e um fsync, sem alocar clusters nem
+// mexer na FAT. Quando o segmento atual enche, o seguinte (em anel) é
+// reescrito por cima; o histórico é o dos últimos segmentos.
+//
+// Formato (little-endian; ver tools/event_log_dump.py):
+//
+//   segmento   [magic "WPEL"][versão u16][tam. cabeçalho u16]
+//              [primeiro seq u32][crc32 dos 12 bytes anteriores]
+//              registros...
+//   registro   [seq u32][tempo u32][origem u8][flags u8][len u16]
+//              [texto len bytes][zeros até múltiplo de 4]
+//              [crc32 do cabeçalho + texto]
+//
+// Os seq são consecutivos, também entre reboots (o begin() acha o último).
+// Um registro só vale com CRC certo e seq = anterior + 1: o resto de uma
+// volta anterior do anel (seq menores) ou um write cortado por queda de
+// energia encerram a leitura do segmento.
+
+#define EVENT_LOG_PATH          "/sd/lab_logs/events.ring"
+#define EVENT_LOG_SEGMENT_SIZE  (64 * 1024)
+#define EVENT_LOG_SEGMENTS      16            // 1 MB no cartão
+#define EVENT_LOG_QUEUE_LEN     32            // linhas em RAM (potência de 2)
+#define EVENT_LOG_TEXT_MAX      160
+#define EVENT_LOG_FLUSH_LINES   8
+#define EVENT_LOG_FLUSH_MS      1000
+#define EVENT_LOG_VERSION       1
+
+enum EventSource : uint8_t {
+    EVENT_SRC_SYSTEM = 0,
+    EVENT_SRC_LAB,
+    EVENT_SRC_WEB,
+    EVENT_SRC_COUNT,
+};
+
+#define EVENT_FLAG_EPOCH 0x01   // tempo em epoch; sem: segundos desde o boot
+
+struct EventRecord {
+    uint32_t seq;
+    uint32_t time;
+    uint8_t source;
+    uint8_t flags;
+    uint16_t len;
+    char text[EVENT_LOG_TEXT_MAX + 1];   // terminado em zero
+};
+
+struct EventLogStats {
+    bool ready;
+    uint32_t first_seq;   // mais antigo ainda no anel
+    uint32_t next_seq;    // o próximo a ser gravado
+    uint32_t pending;     // linhas na fila em RAM
+    uint32_t appended;
+    uint32_t dropped;     // fila cheia
+    uint32_t batches;     // writes (um por lote e segmento)
+};
+
+// Abre (ou cria) o anel e acha o fim. Chamado pelo initSD, depois do
+// storage_start(). Linhas aceitas antes ficam na fila até aqui.
+bool event_log_begin();
+
+// Qualquer task; não toca o SD. false com a fila cheia (linha descartada).
+// Textos maiores que EVENT_LOG_TEXT_MAX são cortados.
+bool event_log_append(EventSource source, const char* text);
+
+// Pede a gravação do que estiver na fila há EVENT_LOG_FLUSH_MS
+void event_log_poll(uint32_t now_ms);
+
+// Até `max` registros a partir de `from_seq` (ou do mais antigo ainda no
+// anel, se from_seq já foi sobrescrito). A fila é gravada antes, então
+// tudo o que foi aceito até a chamada aparece. *next_seq = o from_seq da
+// próxima chamada. Espera a task sd: não chamar da UI nem do AsyncTCP.
+size_t event_log_read(uint32_t from_seq, EventRecord* out, size_t max, uint32_t* next_seq);
+
+void event_log_get_stats(EventLogStats* out);
+
+const char* event_source_name(uint8_t source);
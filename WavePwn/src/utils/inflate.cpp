@@ -0,0 +1,276 @@
+#include "utils/inflate.h"
+
+#include <string.h>
+
+// Decodificação canônica bit a bit (como o puff.c do zlib): lenta perto do
+// zlib, mas o OTA delta é limitado pela flash, não por isto.
+
+enum InflateMode : uint8_t {
+    MODE_HEADER = 0,
+    MODE_STORED,
+    MODE_CODES,
+    MODE_DONE,
+};
+
+static const uint16_t LEN_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LEN_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t bits(Inflate* z, int need) {
+    while (z->bitcnt < need) {
+        if (z->in_pos == z->in_len) {
+            z->short_read = true;
+            return 0;
+        }
+        z->bitbuf |= (uint32_t)z->in[z->in_pos++] << z->bitcnt;
+        z->bitcnt += 8;
+    }
+    uint32_t v = z->bitbuf & ((1u << need) - 1);
+    z->bitbuf >>= need;
+    z->bitcnt -= need;
+    return v;
+}
+
+// < 0: conjunto de comprimentos inválido; > 0: incompleto
+static int construct(InflateHuffman* h, const uint8_t* length, int n) {
+    memset(h->count, 0, sizeof(h->count));
+    for (int s = 0; s < n; ++s) {
+        h->count[length[s]]++;
+    }
+    if (h->count[0] == n) {
+        return 0;
+    }
+
+    int left = 1;
+    for (int len = 1; len < 16; ++len) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) return left;
+    }
+
+    uint16_t offs[16];
+    offs[1] = 0;
+    for (int len = 1; len < 15; ++len) {
+        offs[len + 1] = offs[len] + h->count[len];
+    }
+    for (int s = 0; s < n; ++s) {
+        if (length[s] != 0) h->symbol[offs[length[s]]++] = (uint16_t)s;
+    }
+    return left;
+}
+
+static int decode(Inflate* z, const InflateHuffman* h) {
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len < 16; ++len) {
+        code |= (int)bits(z, 1);
+        int count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static bool flush(Inflate* z, InflateSink sink, void* ctx) {
+    if (z->pos == z->flushed) return true;
+    bool ok = sink(ctx, z->window + z->flushed, z->pos - z->flushed);
+    z->flushed = z->pos;
+    return ok;
+}
+
+static bool put(Inflate* z, uint8_t b, InflateSink sink, void* ctx) {
+    z->window[z->pos++] = b;
+    if (z->history < INFLATE_WINDOW) z->history++;
+    if (z->pos == INFLATE_WINDOW) {
+        if (!flush(z, sink, ctx)) return false;
+        z->pos = 0;
+        z->flushed = 0;
+    }
+    return true;
+}
+
+static void fixed_tables(Inflate* z) {
+    uint8_t lengths[288];
+    int s = 0;
+    for (; s < 144; ++s) lengths[s] = 8;
+    for (; s < 256; ++s) lengths[s] = 9;
+    for (; s < 280; ++s) lengths[s] = 7;
+    for (; s < 288; ++s) lengths[s] = 8;
+    construct(&z->lencode, lengths, 288);
+    for (s = 0; s < 30; ++s) lengths[s] = 5;
+    construct(&z->distcode, lengths, 30);
+}
+
+static bool dynamic_tables(Inflate* z) {
+    static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint8_t lengths[320];
+
+    int nlen = (int)bits(z, 5) + 257;
+    int ndist = (int)bits(z, 5) + 1;
+    int ncode = (int)bits(z, 4) + 4;
+    if (nlen > 286 || ndist > 30) return false;
+
+    memset(lengths, 0, 19);
+    for (int i = 0; i < ncode; ++i) {
+        lengths[ORDER[i]] = (uint8_t)bits(z, 3);
+    }
+    if (construct(&z->lencode, lengths, 19) != 0) return false;
+
+    int index = 0;
+    while (index < nlen + ndist) {
+        int symbol = decode(z, &z->lencode);
+        if (symbol < 0 || z->short_read) return false;
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+        uint8_t len = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) return false;
+            len = lengths[index - 1];
+            repeat = 3 + (int)bits(z, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + (int)bits(z, 3);
+        } else {
+            repeat = 11 + (int)bits(z, 7);
+        }
+        if (index + repeat > nlen + ndist) return false;
+        while (repeat--) lengths[index++] = len;
+    }
+    if (lengths[256] == 0) return false;
+
+    int err = construct(&z->lencode, lengths, nlen);
+    if (err < 0 || (err > 0 && nlen - z->lencode.count[0] != 1)) return false;
+    err = construct(&z->distcode, lengths + nlen, ndist);
+    if (err < 0 || (err > 0 && ndist - z->distcode.count[0] != 1)) return false;
+    return true;
+}
+
+// Um passo. false: fluxo inválido (ou o sink recusou, ver *sink_failed)
+static bool step(Inflate* z, InflateSink sink, void* ctx, bool* sink_failed) {
+    switch (z->mode) {
+        case MODE_HEADER: {
+            z->last = bits(z, 1) != 0;
+            uint32_t type = bits(z, 2);
+            if (type == 0) {
+                // Bloco sem compressão: alinha no byte, LEN e ~LEN
+                z->bitbuf >>= z->bitcnt & 7;
+                z->bitcnt -= z->bitcnt & 7;
+                uint32_t len = bits(z, 16);
+                uint32_t nlen = bits(z, 16);
+                if (len != (~nlen & 0xFFFF)) return false;
+                z->stored_left = (uint16_t)len;
+                z->mode = len ? MODE_STORED : (z->last ? MODE_DONE : MODE_HEADER);
+            } else if (type == 1) {
+                fixed_tables(z);
+                z->mode = MODE_CODES;
+            } else if (type == 2) {
+                if (!dynamic_tables(z)) return false;
+                z->mode = MODE_CODES;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        case MODE_STORED: {
+            int n = z->stored_left < 256 ? z->stored_left : 256;
+            for (int i = 0; i < n; ++i) {
+                uint8_t b = (uint8_t)bits(z, 8);
+                if (z->short_read) return false;
+                if (!put(z, b, sink, ctx)) {
+                    *sink_failed = true;
+                    return false;
+                }
+            }
+            z->stored_left -= (uint16_t)n;
+            if (z->stored_left == 0) z->mode = z->last ? MODE_DONE : MODE_HEADER;
+            return true;
+        }
+
+        case MODE_CODES: {
+            int symbol = decode(z, &z->lencode);
+            if (symbol < 0) return false;
+            if (symbol < 256) {
+                if (!put(z, (uint8_t)symbol, sink, ctx)) {
+                    *sink_failed = true;
+                    return false;
+                }
+                return true;
+            }
+            if (symbol == 256) {
+                z->mode = z->last ? MODE_DONE : MODE_HEADER;
+                return true;
+            }
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            uint32_t len = LEN_BASE[symbol] + bits(z, LEN_EXTRA[symbol]);
+            int dsym = decode(z, &z->distcode);
+            if (dsym < 0 || dsym >= 30) return false;
+            uint32_t dist = DIST_BASE[dsym] + bits(z, DIST_EXTRA[dsym]);
+            if (dist > z->history) return false;
+
+            while (len--) {
+                uint8_t b = z->window[(z->pos + INFLATE_WINDOW - dist) % INFLATE_WINDOW];
+                if (!put(z, b, sink, ctx)) {
+                    *sink_failed = true;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+void inflate_init(Inflate* z, uint8_t* window) {
+    memset(z, 0, sizeof(*z));
+    z->window = window;
+    z->mode = MODE_HEADER;
+}
+
+InflateResult inflate_feed(Inflate* z, const uint8_t* data, size_t len, bool final,
+                           InflateSink sink, void* ctx) {
+    size_t used = 0;
+    for (;;) {
+        // Acumula a entrada; o que já foi lido sai da frente
+        if (z->in_pos > 0) {
+            memmove(z->in, z->in + z->in_pos, z->in_len - z->in_pos);
+            z->in_len -= z->in_pos;
+            z->in_pos = 0;
+        }
+        size_t n = INFLATE_IN_MAX - z->in_len;
+        if (n > len - used) n = len - used;
+        memcpy(z->in + z->in_len, data + used, n);
+        z->in_len += (uint16_t)n;
+        used += n;
+        bool end = final && used == len;
+
+        while (z->mode != MODE_DONE && (end || z->in_len - z->in_pos >= INFLATE_STEP_MIN)) {
+            bool sink_failed = false;
+            bool ok = step(z, sink, ctx, &sink_failed);
+            if (sink_failed) return INFLATE_ERR_SINK;
+            if (!ok || z->short_read) return INFLATE_ERR_DATA;
+        }
+        if (z->mode == MODE_DONE || used == len) break;
+    }
+
+    if (!flush(z, sink, ctx)) return INFLATE_ERR_SINK;
+    if (z->mode == MODE_DONE) return INFLATE_DONE;
+    return final ? INFLATE_ERR_DATA : INFLATE_MORE;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Inflate (deflate cru, RFC 1951) em fluxo, sem alocação. Usado pelo OTA
+// delta para descomprimir o patch enquanto ele chega do HTTP.
+//
+// A entrada vem em pedaços de qualquer tamanho (inflate_feed); a saída sai
+// pelo `sink` em pedaços do histórico. O histórico (INFLATE_WINDOW bytes)
+// é do chamador, para poder ficar em PSRAM. Cada passo do decodificador
+// (cabeçalho de bloco ou um símbolo) só roda com INFLATE_STEP_MIN bytes de
+// entrada acumulados, ou no fim do fluxo, então não há estado no meio de
+// um símbolo para guardar entre chamadas.
+#define INFLATE_WINDOW    32768
+#define INFLATE_IN_MAX    2048
+#define INFLATE_STEP_MIN  1024     // > maior cabeçalho dinâmico (~600 bytes)
+
+enum InflateResult : uint8_t {
+    INFLATE_MORE = 0,      // tudo consumido, esperando mais entrada
+    INFLATE_DONE,          // último bloco terminado
+    INFLATE_ERR_DATA,      // fluxo inválido ou truncado
+    INFLATE_ERR_SINK,      // o sink recusou a saída
+};
+
+// false interrompe o inflate (INFLATE_ERR_SINK)
+typedef bool (*InflateSink)(void* ctx, const uint8_t* data, size_t len);
+
+struct InflateHuffman {
+    uint16_t count[16];      // códigos por comprimento
+    uint16_t symbol[288];    // símbolos em ordem canônica
+};
+
+struct Inflate {
+    uint8_t* window;
+    uint32_t pos;            // próximo byte em window
+    uint32_t flushed;        // window[flushed, pos) ainda não entregue
+    uint32_t history;        // bytes válidos no histórico (até INFLATE_WINDOW)
+
+    uint8_t in[INFLATE_IN_MAX];
+    uint16_t in_pos;
+    uint16_t in_len;
+    uint32_t bitbuf;
+    uint8_t bitcnt;
+    bool short_read;         // passo leu além da entrada (só no fim do fluxo)
+
+    uint8_t mode;
+    bool last;               // bloco atual é o último
+    uint16_t stored_left;
+    InflateHuffman lencode;
+    InflateHuffman distcode;
+};
+
+void inflate_init(Inflate* z, uint8_t* window);
+
+// `final`: `data` termina o fluxo comprimido.
+InflateResult inflate_feed(Inflate* z, const uint8_t* data, size_t len, bool final,
+                           InflateSink sink, void* ctx);
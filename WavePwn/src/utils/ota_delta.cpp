@@ -0,0 +1,192 @@
+#include "utils/ota_delta.h"
+
+#include <string.h>
+
+enum OtaDeltaPhase : uint8_t {
+    PHASE_HEADER = 0,
+    PHASE_RECORD,
+    PHASE_DIFF,
+    PHASE_EXTRA,
+    PHASE_DONE,
+};
+
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static bool set_error(OtaDelta* d, const char* reason) {
+    if (!d->error) d->error = reason;
+    return false;
+}
+
+static bool flush_out(OtaDelta* d) {
+    if (d->out_len == 0) return true;
+    bool ok = d->io.write_image(d->io.ctx, d->out, d->out_len);
+    d->out_len = 0;
+    return ok ? true : set_error(d, "write");
+}
+
+// A base do patch tem que ser exatamente a imagem em execução
+static bool check_base(OtaDelta* d, const uint8_t* expected) {
+    if (d->base_size > d->base_limit) return set_error(d, "base");
+
+    Sha256 hash;
+    sha256_init(&hash);
+    for (uint32_t off = 0; off < d->base_size; off += OTA_DELTA_BASE_READ) {
+        uint32_t n = d->base_size - off;
+        if (n > OTA_DELTA_BASE_READ) n = OTA_DELTA_BASE_READ;
+        if (!d->io.read_base(d->io.ctx, off, d->base, n)) return set_error(d, "base");
+        sha256_update(&hash, d->base, n);
+    }
+    d->base_len = 0;
+
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256_final(&hash, digest);
+    return memcmp(digest, expected, SHA256_DIGEST_LEN) == 0 ? true : set_error(d, "base");
+}
+
+static bool parse_header(OtaDelta* d) {
+    if (memcmp(d->head, OTA_DELTA_MAGIC, 4) != 0) return set_error(d, "patch");
+    d->base_size = le32(d->head + 4);
+    if (le32(d->head + 40) != d->image_size) return set_error(d, "patch");
+    return check_base(d, d->head + 8);
+}
+
+static bool parse_record(OtaDelta* d) {
+    d->diff_left = le32(d->head);
+    d->extra_left = le32(d->head + 4);
+    d->seek = (int32_t)le32(d->head + 8);
+
+    uint64_t end = (uint64_t)d->produced + d->diff_left + d->extra_left;
+    int64_t next = (int64_t)d->base_pos + d->diff_left + d->seek;
+    if (end > d->image_size || (uint64_t)d->base_pos + d->diff_left > d->base_size ||
+        next < 0 || next > (int64_t)d->base_size) {
+        return set_error(d, "patch");
+    }
+    return true;
+}
+
+// Fim de registro (ou de um dos trechos dele): próxima fase
+static bool advance(OtaDelta* d) {
+    if (d->phase == PHASE_DIFF && d->diff_left == 0) d->phase = PHASE_EXTRA;
+    if (d->phase == PHASE_EXTRA && d->extra_left == 0) {
+        d->base_pos = (uint32_t)((int64_t)d->base_pos + d->seek);
+        d->phase = PHASE_RECORD;
+        d->head_len = 0;
+    }
+    if (d->phase == PHASE_RECORD && d->produced == d->image_size) {
+        d->phase = PHASE_DONE;
+        return flush_out(d);
+    }
+    return true;
+}
+
+static bool emit(OtaDelta* d, const uint8_t* data, size_t n) {
+    memcpy(d->out + d->out_len, data, n);
+    d->out_len += (uint16_t)n;
+    d->produced += (uint32_t)n;
+    return d->out_len < OTA_DELTA_OUT || flush_out(d);
+}
+
+// Sink do inflate: bytes descomprimidos do patch
+static bool on_patch(void* ctx, const uint8_t* data, size_t len) {
+    OtaDelta* d = (OtaDelta*)ctx;
+    while (len > 0) {
+        switch (d->phase) {
+            case PHASE_HEADER:
+            case PHASE_RECORD: {
+                size_t want = d->phase == PHASE_HEADER ? OTA_DELTA_HEADER : OTA_DELTA_RECORD;
+                size_t n = want - d->head_len;
+                if (n > len) n = len;
+                memcpy(d->head + d->head_len, data, n);
+                d->head_len += (uint8_t)n;
+                data += n;
+                len -= n;
+                if (d->head_len < want) break;
+
+                if (d->phase == PHASE_HEADER) {
+                    if (!parse_header(d)) return false;
+                    d->phase = PHASE_RECORD;
+                    d->head_len = 0;
+                } else {
+                    if (!parse_record(d)) return false;
+                    d->phase = PHASE_DIFF;
+                }
+                if (!advance(d)) return false;
+                break;
+            }
+
+            case PHASE_DIFF: {
+                if (d->base_pos < d->base_at || d->base_pos >= d->base_at + d->base_len) {
+                    uint32_t n = d->base_size - d->base_pos;
+                    if (n > OTA_DELTA_BASE_READ) n = OTA_DELTA_BASE_READ;
+                    if (!d->io.read_base(d->io.ctx, d->base_pos, d->base, n)) {
+                        return set_error(d, "base");
+                    }
+                    d->base_at = d->base_pos;
+                    d->base_len = (uint16_t)n;
+                }
+                size_t n = d->diff_left;
+                if (n > len) n = len;
+                if (n > d->base_at + d->base_len - d->base_pos) n = d->base_at + d->base_len - d->base_pos;
+                if (n > (size_t)(OTA_DELTA_OUT - d->out_len)) n = OTA_DELTA_OUT - d->out_len;
+
+                const uint8_t* base = d->base + (d->base_pos - d->base_at);
+                uint8_t* out = d->out + d->out_len;
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = (uint8_t)(base[i] + data[i]);
+                }
+                d->out_len += (uint16_t)n;
+                d->produced += (uint32_t)n;
+                d->base_pos += (uint32_t)n;
+                d->diff_left -= (uint32_t)n;
+                data += n;
+                len -= n;
+                if (d->out_len == OTA_DELTA_OUT && !flush_out(d)) return false;
+                if (!advance(d)) return false;
+                break;
+            }
+
+            case PHASE_EXTRA: {
+                size_t n = d->extra_left;
+                if (n > len) n = len;
+                if (n > (size_t)(OTA_DELTA_OUT - d->out_len)) n = OTA_DELTA_OUT - d->out_len;
+                if (!emit(d, data, n)) return false;
+                d->extra_left -= (uint32_t)n;
+                data += n;
+                len -= n;
+                if (!advance(d)) return false;
+                break;
+            }
+
+            default:
+                // Bytes depois da imagem completa
+                return set_error(d, "patch");
+        }
+    }
+    return true;
+}
+
+void ota_delta_begin(OtaDelta* d, uint8_t* window, uint32_t image_size, uint32_t base_limit,
+                     const OtaDeltaIo& io) {
+    memset(d, 0, sizeof(*d));
+    inflate_init(&d->inflate, window);
+    d->io = io;
+    d->image_size = image_size;
+    d->base_limit = base_limit;
+    d->phase = PHASE_HEADER;
+}
+
+bool ota_delta_feed(OtaDelta* d, const uint8_t* data, size_t len, bool final) {
+    if (d->error) return false;
+
+    InflateResult r = inflate_feed(&d->inflate, data, len, final, on_patch, d);
+    if (r == INFLATE_ERR_SINK) return false;
+    if (r == INFLATE_ERR_DATA) return set_error(d, "patch");
+    if (final && (r != INFLATE_DONE || d->phase != PHASE_DONE)) return set_error(d, "patch");
+    return true;
+}
+
+bool ota_delta_done(const OtaDelta* d) {
+    return d->phase == PHASE_DONE;
+}
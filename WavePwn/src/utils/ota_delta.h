@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils/inflate.h"
+#include "utils/sha256.h"
+
+// Patch do OTA delta (gerado por tools/ota/ota_delta.py): a imagem nova
+// reconstruída a partir da imagem em execução, no estilo do bsdiff.
+//
+// O patch é um único fluxo deflate cru. Descomprimido:
+//
+//   "WPD1" | tamanho da base (u32) | SHA-256 da base (32) | tamanho da imagem (u32)
+//   registros até completar a imagem:
+//     diff_len (u32) | extra_len (u32) | seek (i32)
+//     diff_len bytes: imagem[i] = base[pos + i] + diff[i]  (mod 256); pos += diff_len
+//     extra_len bytes copiados como estão
+//     pos += seek
+//
+// Inteiros em little endian. Trechos de código que só mudaram endereços
+// viram diff quase todo zero, que o deflate comprime bem.
+//
+// Tudo em fluxo com memória fixa (sizeof(OtaDelta) + INFLATE_WINDOW): a
+// base é lida aos poucos e a imagem sai em blocos de OTA_DELTA_OUT bytes.
+
+#define OTA_DELTA_MAGIC     "WPD1"
+#define OTA_DELTA_HEADER    44
+#define OTA_DELTA_RECORD    12
+#define OTA_DELTA_OUT       4096
+#define OTA_DELTA_BASE_READ 1024
+
+struct OtaDeltaIo {
+    // Lê `len` bytes da imagem em execução a partir de `offset`
+    bool (*read_base)(void* ctx, uint32_t offset, uint8_t* out, size_t len);
+    // Próximo pedaço da imagem nova, em ordem
+    bool (*write_image)(void* ctx, const uint8_t* data, size_t len);
+    void* ctx;
+};
+
+struct OtaDelta {
+    Inflate inflate;
+    OtaDeltaIo io;
+    uint32_t image_size;      // esperado pelo manifesto
+    uint32_t base_limit;      // tamanho da partição em execução
+
+    uint8_t head[OTA_DELTA_HEADER];
+    uint8_t head_len;
+    uint8_t phase;
+    uint32_t base_size;
+    uint32_t diff_left;
+    uint32_t extra_left;
+    int32_t seek;
+    uint32_t base_pos;
+    uint32_t produced;        // bytes da imagem já gerados
+
+    uint8_t out[OTA_DELTA_OUT];
+    uint16_t out_len;
+    uint8_t base[OTA_DELTA_BASE_READ];
+    uint16_t base_len;        // base[] vale para [base_at, base_at + base_len)
+    uint32_t base_at;
+
+    const char* error;        // motivo (estático) quando feed devolve false
+};
+
+// `window`: INFLATE_WINDOW bytes do chamador. `base_limit`: quanto da
+// partição em execução pode ser lido.
+void ota_delta_begin(OtaDelta* d, uint8_t* window, uint32_t image_size, uint32_t base_limit,
+                     const OtaDeltaIo& io);
+
+// Bytes do patch, em ordem. `final`: último pedaço. false com d->error
+// ("patch", "base", "write"); true com a imagem completa quando
+// ota_delta_done().
+bool ota_delta_feed(OtaDelta* d, const uint8_t* data, size_t len, bool final);
+
+bool ota_delta_done(const OtaDelta* d);
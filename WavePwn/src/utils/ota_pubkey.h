@@ -0,0 +1,9 @@
+#pragma once
+
+// Chave pública ECDSA P-256 (PEM) que assina os manifestos de OTA.
+// `python3 tools/ota/ota_sign.py keygen` gera o par e reescreve este
+// arquivo; a chave privada fica fora do repositório.
+//
+// Vazia: toda OTA é recusada (403), a não ser num build com
+// -DOTA_ALLOW_UNSIGNED, que aceita manifestos sem assinatura.
+static const char OTA_PUBKEY_PEM[] = "";
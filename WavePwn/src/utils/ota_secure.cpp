@@ -1,33 +1,564 @@
 #include "utils/ota_secure.h"
 
 #include <Arduino.h>
-#include <Update.h>
+#include <string.h>
 
-// Pequena camada em torno da API Update, para permitir futuros checks
-// de integridade (hash, assinatura, etc.). Nesta etapa, o foco é manter
-// o código organizado e pronto para endurecimento adicional.
+#include "esp_heap_caps.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mbedtls/pk.h"
+#include "utils/ota_delta.h"
 
-bool ota_begin_secure(size_t size) {
-    // No futuro, poderíamos validar tamanho máximo, versão, etc.
-    if (!Update.begin(size)) {
-        Update.printError(Serial);
+#ifdef OTA_PUBKEY_HEADER
+#include OTA_PUBKEY_HEADER
+#else
+#include "utils/ota_pubkey.h"
+#endif
+
+// Core 0, abaixo da captura: a flash é o gargalo, não a CPU
+static const BaseType_t OTA_TASK_CORE = 0;
+static const UBaseType_t OTA_TASK_PRIO = 2;
+static const uint32_t OTA_TASK_STACK = 6144;   // delta: inflate -> gravação aninhados
+
+// slot == OTA_NO_SLOT: só acorda a task (sessão nova, apagar adiantado)
+static const uint16_t OTA_NO_SLOT = 0xFFFF;
+
+struct OtaBlock {
+    uint16_t slot;
+    uint16_t len;
+    uint32_t session;
+};
+
+// Estado compartilhado entre o HTTP (produtor) e a task ota_flash. Os campos
+// da sessão só mudam sob `lock`; fill_* são só do produtor.
+static struct {
+    SemaphoreHandle_t lock = nullptr;
+    QueueHandle_t free_q = nullptr;     // índices de slots livres
+    QueueHandle_t full_q = nullptr;     // OtaBlock para gravar, em ordem
+    TaskHandle_t task = nullptr;
+    uint8_t* ring = nullptr;            // OTA_RING_BLOCKS * OTA_BLOCK_SIZE
+    OtaDelta* delta = nullptr;          // só no primeiro OTA delta
+    uint8_t* delta_window = nullptr;    // INFLATE_WINDOW
+
+    const esp_partition_t* part = nullptr;
+    const esp_partition_t* running = nullptr;
+    OtaManifest manifest;
+    OtaState state = OTA_IDLE;
+    uint32_t session = 0;
+    uint32_t received = 0;
+    uint32_t consumed = 0;
+    uint32_t written = 0;
+    uint32_t erased = 0;
+    const char* error = nullptr;
+
+    int fill_slot = -1;
+    uint16_t fill_len = 0;
+} ota;
+
+struct OtaLock {
+    OtaLock() { xSemaphoreTake(ota.lock, portMAX_DELAY); }
+    ~OtaLock() { xSemaphoreGive(ota.lock); }
+};
+
+static uint32_t erase_end(uint32_t size) {
+    return (size + OTA_BLOCK_SIZE - 1) / OTA_BLOCK_SIZE * OTA_BLOCK_SIZE;
+}
+
+// Bytes que o cliente manda: a imagem ou o patch
+static uint32_t transfer_size(const OtaManifest& m) {
+    return m.patch_size ? m.patch_size : m.size;
+}
+
+static void* alloc_psram(size_t bytes) {
+    void* p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+}
+
+static void hex_encode(const uint8_t* data, size_t len, char* out) {
+    static const char* H = "0123456789abcdef";
+    for (size_t i = 0; i < len; ++i) {
+        out[i * 2] = H[data[i] >> 4];
+        out[i * 2 + 1] = H[data[i] & 0x0F];
+    }
+    out[len * 2] = '\0';
+}
+
+size_t ota_manifest_message(const OtaManifest& m, char* out, size_t cap) {
+    char hex[SHA256_DIGEST_LEN * 2 + 1];
+    hex_encode(m.sha256, SHA256_DIGEST_LEN, hex);
+    int n = snprintf(out, cap, "wavepwn-ota-v1 %u %s %s", (unsigned)m.size, hex, m.version);
+    return n < 0 ? 0 : ((size_t)n < cap ? (size_t)n : cap - 1);
+}
+
+// Sem chave compilada a OTA fica fechada: só -DOTA_ALLOW_UNSIGNED aceita
+// manifestos sem assinatura (bancada), conferindo apenas o SHA-256
+static bool verify_signature(const OtaManifest& m) {
+    if (OTA_PUBKEY_PEM[0] == '\0') {
+#ifdef OTA_ALLOW_UNSIGNED
+        Serial.println("[OTA] OTA_ALLOW_UNSIGNED: manifesto aceito sem assinatura");
+        return true;
+#else
+        Serial.println("[OTA] Sem chave pública em utils/ota_pubkey.h: OTA recusada "
+                       "(tools/ota/ota_sign.py keygen)");
+        return false;
+#endif
+    }
+    if (m.sig_len == 0) {
+        return false;
+    }
+
+    char msg[160];
+    size_t n = ota_manifest_message(m, msg, sizeof(msg));
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256(msg, n, digest);
+
+    // mbedtls_pk_parse_public_key quer o PEM com o '\0' no tamanho
+    mbedtls_pk_context pk;
+    mbedtls_pk_init(&pk);
+    int rc = mbedtls_pk_parse_public_key(&pk, (const unsigned char*)OTA_PUBKEY_PEM, sizeof(OTA_PUBKEY_PEM));
+    if (rc == 0) {
+        rc = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, sizeof(digest), m.sig, m.sig_len);
+    }
+    mbedtls_pk_free(&pk);
+    return rc == 0;
+}
+
+// Uma sessão READY já trocou o boot; descartá-la volta para a imagem atual
+static void revert_boot() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (running && esp_ota_set_boot_partition(running) == ESP_OK) {
+        Serial.printf("[OTA] Boot de volta para %s\n", running->label);
+    }
+}
+
+static void fail(uint32_t session, const char* reason) {
+    bool was_ready;
+    {
+        OtaLock l;
+        if (session != ota.session || ota.state == OTA_FAILED) return;
+        // Delta: a imagem pode ter fechado antes de um erro no resto do patch
+        was_ready = ota.state == OTA_READY;
+        ota.state = OTA_FAILED;
+        ota.error = reason;
+    }
+    if (was_ready) revert_boot();
+    Serial.printf("[OTA] Falha: %s\n", reason);
+}
+
+// -----------------------------------------------------------------------------
+// Task ota_flash
+// -----------------------------------------------------------------------------
+
+// Um passo de apagamento a partir de `from` (alinhado a OTA_ERASE_STEP
+// sempre que possível: bloco de 64 KB apaga ~6x mais rápido por byte que
+// setores de 4 KB). false se a sessão mudou ou a flash falhou.
+static bool erase_step(uint32_t session, const esp_partition_t* part, uint32_t from, uint32_t end) {
+    uint32_t len = OTA_ERASE_STEP - (from % OTA_ERASE_STEP);
+    if (len > end - from) len = end - from;
+
+    if (esp_partition_erase_range(part, from, len) != ESP_OK) {
+        fail(session, "erase");
         return false;
     }
+    OtaLock l;
+    if (session != ota.session) return false;
+    if (ota.erased < from + len) ota.erased = from + len;
     return true;
 }
 
-bool ota_write_chunk(const uint8_t *data, size_t len) {
-    if (Update.write(const_cast<uint8_t *>(data), len) != len) {
-        Update.printError(Serial);
+static void finish(uint32_t session, Sha256* hash) {
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256_final(hash, digest);
+
+    const esp_partition_t* part;
+    uint8_t expected[SHA256_DIGEST_LEN];
+    char version[OTA_VERSION_MAX];
+    {
+        OtaLock l;
+        if (session != ota.session) return;
+        ota.state = OTA_VERIFYING;
+        part = ota.part;
+        memcpy(expected, ota.manifest.sha256, sizeof(expected));
+        memcpy(version, ota.manifest.version, sizeof(version));
+    }
+
+    if (memcmp(digest, expected, sizeof(digest)) != 0) {
+        fail(session, "sha256");
+        return;
+    }
+    // Valida cabeçalho/segmentos/checksum da imagem antes de trocar o boot
+    if (esp_ota_set_boot_partition(part) != ESP_OK) {
+        fail(session, "image");
+        return;
+    }
+    {
+        OtaLock l;
+        if (session != ota.session) return;
+        ota.state = OTA_READY;
+    }
+    Serial.printf("[OTA] Imagem %s conferida (SHA-256 ok), boot em %s\n", version, part->label);
+}
+
+// Sessão e hash da imagem que a task está gravando (ctx do OtaDeltaIo)
+struct OtaWriter {
+    uint32_t session;
+    Sha256 hash;
+};
+
+// Próximo pedaço da imagem em ota.written: apaga o que falta, grava e
+// alimenta o hash; no último byte, confere e troca o boot
+static bool write_image(OtaWriter* w, const uint8_t* data, size_t len) {
+    uint32_t off, size;
+    const esp_partition_t* part;
+    {
+        OtaLock l;
+        if (w->session != ota.session || ota.state != OTA_RECEIVING) return false;
+        off = ota.written;
+        size = ota.manifest.size;
+        part = ota.part;
+    }
+    if (len > size - off) {
+        fail(w->session, "size");
+        return false;
+    }
+
+    // Normalmente já apagado; se o HTTP foi mais rápido que o apagamento
+    // adiantado, apaga aqui o que falta
+    uint32_t need = erase_end(off + len);
+    for (;;) {
+        uint32_t erased;
+        {
+            OtaLock l;
+            if (w->session != ota.session) return false;
+            erased = ota.erased;
+        }
+        if (erased >= need) break;
+        if (!erase_step(w->session, part, erased, erase_end(size))) return false;
+    }
+
+    if (esp_partition_write(part, off, data, len) != ESP_OK) {
+        fail(w->session, "write");
+        return false;
+    }
+    sha256_update(&w->hash, data, len);
+
+    bool done;
+    {
+        OtaLock l;
+        if (w->session != ota.session) return false;
+        ota.written = off + (uint32_t)len;
+        done = ota.written == size;
+    }
+    if (done) finish(w->session, &w->hash);
+    return true;
+}
+
+static bool delta_read_base(void*, uint32_t offset, uint8_t* out, size_t len) {
+    return esp_partition_read(ota.running, offset, out, len) == ESP_OK;
+}
+
+static bool delta_write_image(void* ctx, const uint8_t* data, size_t len) {
+    return write_image((OtaWriter*)ctx, data, len);
+}
+
+static void process_block(const OtaBlock& b, OtaWriter* w) {
+    uint32_t off, patch_size, size;
+    {
+        OtaLock l;
+        if (b.session != ota.session || ota.state != OTA_RECEIVING) return;
+        off = ota.consumed;
+        patch_size = ota.manifest.patch_size;
+        size = ota.manifest.size;
+    }
+
+    if (w->session != b.session || off == 0) {
+        w->session = b.session;
+        sha256_init(&w->hash);
+        if (patch_size) {
+            OtaDeltaIo io = {delta_read_base, delta_write_image, w};
+            ota_delta_begin(ota.delta, ota.delta_window, size, ota.running->size, io);
+        }
+    }
+
+    const uint8_t* data = ota.ring + (size_t)b.slot * OTA_BLOCK_SIZE;
+    if (patch_size == 0) {
+        if (!write_image(w, data, b.len)) return;
+    } else if (!ota_delta_feed(ota.delta, data, b.len, off + b.len == patch_size)) {
+        fail(b.session, ota.delta->error);
+        return;
+    }
+
+    OtaLock l;
+    if (b.session == ota.session) ota.consumed = off + b.len;
+}
+
+static void ota_task(void*) {
+    static OtaWriter writer;
+
+    for (;;) {
+        // Com a fila vazia, o tempo ocioso vai para apagar adiantado
+        uint32_t session, from = 0, end = 0;
+        const esp_partition_t* part;
+        {
+            OtaLock l;
+            session = ota.session;
+            part = ota.part;
+            if (ota.state == OTA_RECEIVING) {
+                from = ota.erased;
+                end = erase_end(ota.manifest.size);
+            }
+        }
+        bool erase_pending = from < end;
+
+        OtaBlock b;
+        if (xQueueReceive(ota.full_q, &b, erase_pending ? 0 : portMAX_DELAY) == pdTRUE) {
+            if (b.slot == OTA_NO_SLOT) continue;
+            process_block(b, &writer);
+            xQueueSend(ota.free_q, &b.slot, 0);
+        } else if (erase_pending) {
+            erase_step(session, part, from, end);
+        }
+    }
+}
+
+static bool ota_init() {
+    if (ota.task) return true;
+
+    if (!ota.lock) ota.lock = xSemaphoreCreateMutex();
+    if (!ota.ring) ota.ring = (uint8_t*)alloc_psram((size_t)OTA_RING_BLOCKS * OTA_BLOCK_SIZE);
+    if (!ota.free_q) ota.free_q = xQueueCreate(OTA_RING_BLOCKS, sizeof(uint16_t));
+    if (!ota.full_q) ota.full_q = xQueueCreate(OTA_RING_BLOCKS + 4, sizeof(OtaBlock));
+    if (!ota.lock || !ota.ring || !ota.free_q || !ota.full_q) {
+        Serial.println("[OTA] Sem memória para o anel de upload");
+        return false;
+    }
+    for (uint16_t i = 0; i < OTA_RING_BLOCKS; ++i) {
+        xQueueSend(ota.free_q, &i, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(ota_task,
+                                "ota_flash",
+                                OTA_TASK_STACK,
+                                nullptr,
+                                OTA_TASK_PRIO,
+                                &ota.task,
+                                OTA_TASK_CORE) != pdPASS) {
+        ota.task = nullptr;
+        Serial.println("[OTA] Falha ao criar task ota_flash");
         return false;
     }
     return true;
 }
 
-bool ota_finalize(bool reboot) {
-    if (!Update.end(reboot)) {
-        Update.printError(Serial);
+// ~41 KB que o OTA inteiro não precisa: só no primeiro delta
+static bool ota_delta_init() {
+    if (!ota.delta) ota.delta = (OtaDelta*)alloc_psram(sizeof(OtaDelta));
+    if (!ota.delta_window) ota.delta_window = (uint8_t*)alloc_psram(INFLATE_WINDOW);
+    if (!ota.delta || !ota.delta_window) {
+        Serial.println("[OTA] Sem memória para o delta");
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+// Devolve o slot que o produtor estava enchendo (sessão descartada)
+static void drop_fill_slot() {
+    if (ota.fill_slot >= 0) {
+        uint16_t slot = (uint16_t)ota.fill_slot;
+        xQueueSend(ota.free_q, &slot, 0);
+        ota.fill_slot = -1;
+        ota.fill_len = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// API
+// -----------------------------------------------------------------------------
+
+OtaResult ota_begin_secure(const OtaManifest& m, uint32_t* resume_offset) {
+    *resume_offset = 0;
+    if (m.size == 0) {
+        return OTA_ERR_MANIFEST;
+    }
+    if (!verify_signature(m)) {
+        Serial.println("[OTA] Assinatura do manifesto inválida");
+        return OTA_ERR_SIGNATURE;
+    }
+
+    const esp_partition_t* part = esp_ota_get_next_update_partition(nullptr);
+    if (!part) {
+        Serial.println("[OTA] Sem partição OTA livre (tabela com ota_0/ota_1?)");
+        return OTA_ERR_NO_PARTITION;
+    }
+    if (m.size > part->size) {
+        return OTA_ERR_SIZE;
+    }
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (m.patch_size && !running) {
+        return OTA_ERR_NO_PARTITION;
+    }
+    if (!ota_init() || (m.patch_size && !ota_delta_init())) {
+        return OTA_ERR_NO_MEMORY;
+    }
+
+    uint32_t session;
+    bool was_ready;
+    {
+        OtaLock l;
+        bool same = ota.state != OTA_IDLE && ota.state != OTA_FAILED &&
+                    ota.manifest.size == m.size && ota.manifest.patch_size == m.patch_size &&
+                    memcmp(ota.manifest.sha256, m.sha256, SHA256_DIGEST_LEN) == 0;
+        if (same) {
+            *resume_offset = ota.received;
+            Serial.printf("[OTA] Retomando %s em %u/%u bytes\n",
+                          ota.manifest.version, (unsigned)ota.received, (unsigned)transfer_size(m));
+            return OTA_OK;
+        }
+
+        was_ready = ota.state == OTA_READY;
+        session = ++ota.session;
+        ota.part = part;
+        ota.running = running;
+        ota.manifest = m;
+        ota.manifest.version[OTA_VERSION_MAX - 1] = '\0';
+        ota.state = OTA_RECEIVING;
+        ota.received = 0;
+        ota.consumed = 0;
+        ota.written = 0;
+        ota.erased = 0;
+        ota.error = nullptr;
+    }
+    drop_fill_slot();
+    if (was_ready) revert_boot();
+
+    OtaBlock wake = {OTA_NO_SLOT, 0, session};
+    xQueueSend(ota.full_q, &wake, 0);
+
+    if (m.patch_size) {
+        Serial.printf("[OTA] Recebendo %s (delta de %u bytes, imagem de %u) para %s\n",
+                      m.version, (unsigned)m.patch_size, (unsigned)m.size, part->label);
+    } else {
+        Serial.printf("[OTA] Recebendo %s (%u bytes) para %s\n",
+                      m.version, (unsigned)m.size, part->label);
+    }
+    return OTA_OK;
+}
+
+OtaResult ota_write_chunk(uint32_t offset, const uint8_t* data, size_t len, size_t* accepted) {
+    *accepted = 0;
+    if (!ota.lock) {
+        return OTA_ERR_STATE;
+    }
+
+    uint32_t session, size;
+    {
+        OtaLock l;
+        if (ota.state != OTA_RECEIVING) return OTA_ERR_STATE;
+        if (offset != ota.received) return OTA_ERR_OFFSET;
+        session = ota.session;
+        size = transfer_size(ota.manifest);
+    }
+
+    OtaResult result = OTA_OK;
+    if (len > size - offset) {
+        len = size - offset;
+        result = OTA_ERR_SIZE;
+    }
+
+    size_t done = 0;
+    while (done < len) {
+        if (ota.fill_slot < 0) {
+            uint16_t slot;
+            if (xQueueReceive(ota.free_q, &slot, pdMS_TO_TICKS(OTA_RING_WAIT_MS)) != pdTRUE) {
+                result = OTA_ERR_BUSY;
+                break;
+            }
+            ota.fill_slot = slot;
+            ota.fill_len = 0;
+        }
+
+        size_t n = len - done;
+        if (n > (size_t)(OTA_BLOCK_SIZE - ota.fill_len)) n = OTA_BLOCK_SIZE - ota.fill_len;
+        memcpy(ota.ring + (size_t)ota.fill_slot * OTA_BLOCK_SIZE + ota.fill_len, data + done, n);
+        ota.fill_len += (uint16_t)n;
+        done += n;
+
+        bool last;
+        {
+            OtaLock l;
+            if (session != ota.session) break;
+            ota.received += (uint32_t)n;
+            last = ota.received == size;
+        }
+        if (ota.fill_len == OTA_BLOCK_SIZE || last) {
+            OtaBlock b = {(uint16_t)ota.fill_slot, ota.fill_len, session};
+            xQueueSend(ota.full_q, &b, portMAX_DELAY);
+            ota.fill_slot = -1;
+            ota.fill_len = 0;
+        }
+    }
+
+    *accepted = done;
+    return result;
+}
+
+void ota_get_status(OtaStatus* out) {
+    memset(out, 0, sizeof(*out));
+    if (!ota.lock) {
+        out->state = OTA_IDLE;
+        return;
+    }
+    OtaLock l;
+    out->state = ota.state;
+    out->size = ota.manifest.size;
+    out->patch_size = ota.manifest.patch_size;
+    out->received = ota.received;
+    out->consumed = ota.consumed;
+    out->written = ota.written;
+    out->erased = ota.erased;
+    out->error = ota.error;
+    memcpy(out->version, ota.manifest.version, sizeof(out->version));
+}
+
+void ota_abort() {
+    if (!ota.lock) return;
+    bool was_ready;
+    {
+        OtaLock l;
+        if (ota.state == OTA_IDLE) return;
+        was_ready = ota.state == OTA_READY;
+        ota.session++;
+        ota.state = OTA_IDLE;
+    }
+    drop_fill_slot();
+    if (was_ready) revert_boot();
+    Serial.println("[OTA] Sessão descartada");
+}
+
+const char* ota_state_name(OtaState state) {
+    switch (state) {
+        case OTA_RECEIVING: return "receiving";
+        case OTA_VERIFYING: return "verifying";
+        case OTA_READY:     return "ready";
+        case OTA_FAILED:    return "failed";
+        default:            return "idle";
+    }
+}
+
+const char* ota_result_name(OtaResult result) {
+    switch (result) {
+        case OTA_OK:               return "ok";
+        case OTA_ERR_MANIFEST:     return "manifest";
+        case OTA_ERR_SIGNATURE:    return "signature";
+        case OTA_ERR_SIZE:         return "size";
+        case OTA_ERR_NO_PARTITION: return "no partition";
+        case OTA_ERR_NO_MEMORY:    return "no memory";
+        case OTA_ERR_STATE:        return "state";
+        case OTA_ERR_OFFSET:       return "offset";
+        default:                   return "busy";
+    }
+}
@@ -3,12 +3,98 @@
 #include <stddef.h>
 #include <stdint.h>
 
-// Inicia uma atualização OTA \"segura\". Retorna true se o buffer interno
-// foi preparado com sucesso.
-bool ota_begin_secure(size_t size);
+#include "utils/sha256.h"
 
-// Escreve um bloco de firmware recebido via HTTP.
-bool ota_write_chunk(const uint8_t *data, size_t len);
+// OTA em fluxo, retomável e verificado.
+//
+// Antes do primeiro byte, o manifesto (tamanho, SHA-256 da imagem, versão e
+// assinatura ECDSA P-256 gerada por tools/ota/ota_sign.py) é conferido
+// contra a chave pública de utils/ota_pubkey.h. Os bytes recebidos pelo
+// HTTP só são copiados para um anel em PSRAM; a task "ota_flash" (core 0)
+// apaga a partição inativa adiantado, em blocos de 64 KB, enquanto espera
+// dados, grava cada bloco de 4 KB e calcula o SHA-256 na ordem. Com o último
+// byte gravado, o hash é comparado com o do manifesto e só então a partição
+// vira a de boot (esp_ota_set_boot_partition também valida o formato da
+// imagem). Nada muda no boot se o upload parar no meio.
+//
+// Retomada: enquanto o dispositivo não reinicia, um ota_begin_secure() com
+// o mesmo manifesto continua a sessão e devolve o offset a partir do qual
+// o cliente deve reenviar.
+//
+// Delta (manifest.patch_size > 0): o que chega é um patch comprimido
+// (utils/ota_delta.h, gerado por tools/ota/ota_delta.py) contra a imagem
+// em execução. A task descomprime e reconstrói a imagem nova lendo a
+// partição atual, e grava/confere igual ao caminho inteiro; offsets,
+// retomada e o anel contam bytes do patch. A assinatura e o SHA-256 do
+// manifesto continuam sendo os da imagem final.
 
-// Finaliza a atualização e opcionalmente reinicia o dispositivo.
-bool ota_finalize(bool reboot);
\ No newline at end of file
+#define OTA_BLOCK_SIZE     4096              // um setor de flash
+#define OTA_RING_BLOCKS    16                // 64 KB entre o HTTP e a task
+#define OTA_ERASE_STEP     (64 * 1024)       // apagamento adiantado
+#define OTA_RING_WAIT_MS   50                // espera máxima do HTTP por espaço
+#define OTA_VERSION_MAX    32
+#define OTA_SIG_MAX        80                // ECDSA P-256 em DER: até 72
+
+enum OtaState : uint8_t {
+    OTA_IDLE = 0,
+    OTA_RECEIVING,     // aceitando bytes (e apagando/gravando em paralelo)
+    OTA_VERIFYING,     // tudo gravado, conferindo hash e imagem
+    OTA_READY,         // partição nova marcada para o próximo boot
+    OTA_FAILED,
+};
+
+enum OtaResult : uint8_t {
+    OTA_OK = 0,
+    OTA_ERR_MANIFEST,    // tamanho zero, campos faltando
+    OTA_ERR_SIGNATURE,   // assinatura não confere com a chave compilada
+    OTA_ERR_SIZE,        // maior que a partição inativa
+    OTA_ERR_NO_PARTITION,
+    OTA_ERR_NO_MEMORY,
+    OTA_ERR_STATE,       // sem sessão recebendo
+    OTA_ERR_OFFSET,      // offset diferente do esperado (ver status)
+    OTA_ERR_BUSY,        // anel cheio: parte dos bytes não foi aceita
+};
+
+struct OtaManifest {
+    uint32_t size;                  // da imagem
+    uint32_t patch_size;            // 0: imagem inteira; senão, bytes do patch
+    uint8_t sha256[SHA256_DIGEST_LEN];
+    char version[OTA_VERSION_MAX];
+    uint8_t sig[OTA_SIG_MAX];
+    size_t sig_len;
+};
+
+struct OtaStatus {
+    OtaState state;
+    uint32_t size;
+    uint32_t patch_size;
+    uint32_t received;     // próximo offset esperado (do patch, no delta)
+    uint32_t consumed;     // já processado pela task (received - consumed no anel)
+    uint32_t written;      // da imagem, já na flash (e no hash)
+    uint32_t erased;
+    char version[OTA_VERSION_MAX];
+    const char* error;     // motivo da falha (estático), nullptr se nenhuma
+};
+
+// Texto assinado pelo ota_sign.py: "wavepwn-ota-v1 <size> <sha256 hex> <versão>"
+// (o mesmo no delta: a assinatura é da imagem, não do patch)
+size_t ota_manifest_message(const OtaManifest& m, char* out, size_t cap);
+
+// Abre (ou retoma) uma sessão. `resume_offset` recebe o primeiro byte que
+// falta. Um manifesto diferente descarta a sessão anterior.
+OtaResult ota_begin_secure(const OtaManifest& m, uint32_t* resume_offset);
+
+// Bytes da imagem (ou do patch) a partir de `offset`, que precisa ser o received atual.
+// Copia para o anel e retorna sem tocar na flash; com o anel cheio espera
+// no máximo OTA_RING_WAIT_MS. `accepted` recebe quantos bytes entraram
+// (pode ser menos que `len` com OTA_ERR_BUSY).
+OtaResult ota_write_chunk(uint32_t offset, const uint8_t* data, size_t len, size_t* accepted);
+
+void ota_get_status(OtaStatus* out);
+
+// Descarta a sessão. Se ela já estava READY, o boot volta para a imagem em
+// execução; a partição inativa fica como estiver.
+void ota_abort();
+
+const char* ota_state_name(OtaState state);
+const char* ota_result_name(OtaResult result);
@@ -0,0 +1,131 @@
+#include "utils/sd_bench.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "storage.h"
+
+// Offsets aleatórios reprodutíveis (mesma sequência em toda execução)
+static uint32_t xorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void finish(SdBenchResult* r, int64_t start) {
+    r->us = (uint32_t)(esp_timer_get_time() - start);
+    double s = r->us > 0 ? r->us / 1e6 : 1e-6;
+    r->mb_s = r->bytes / (1024.0 * 1024.0) / s;
+    r->iops = r->ops / s;
+}
+
+// Escreve/lê `ops` blocos em sequência ou em offsets aleatórios (múltiplos
+// do bloco); nas escritas o fsync entra na conta
+static bool run_pass(const char* path, bool write, uint8_t* buf, uint32_t block,
+                     uint32_t ops, uint32_t blocks_in_file, bool random,
+                     SdBenchResult* r) {
+    memset(r, 0, sizeof(*r));
+    int flags = write ? (random ? O_RDWR : O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY;
+    int64_t start = esp_timer_get_time();
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        Serial.printf("[SD] bench: falha ao abrir %s\n", path);
+        return false;
+    }
+
+    uint32_t rng = 0x2545F491;
+    bool ok = true;
+    for (uint32_t i = 0; i < ops; ++i) {
+        if (random) {
+            off_t at = (off_t)(xorshift32(&rng) % blocks_in_file) * block;
+            if (lseek(fd, at, SEEK_SET) != at) {
+                ok = false;
+                break;
+            }
+        }
+        ssize_t n = write ? ::write(fd, buf, block) : ::read(fd, buf, block);
+        if (n != (ssize_t)block) {
+            ok = false;
+            break;
+        }
+        r->ops++;
+        r->bytes += block;
+    }
+    if (write && fsync(fd) != 0) {
+        ok = false;
+    }
+    close(fd);
+    finish(r, start);
+    if (!ok) {
+        Serial.printf("[SD] bench: %s %s parou em %lu de %lu blocos\n",
+                      random ? "aleatoria" : "sequencial", write ? "escrita" : "leitura",
+                      (unsigned long)r->ops, (unsigned long)ops);
+    }
+    return ok;
+}
+
+bool sd_bench_run(const char* dir, const SdBenchConfig& config, SdBenchReport* out) {
+    *out = SdBenchReport();
+    out->config = config;
+
+    uint32_t file_bytes = config.file_kb * 1024;
+    if (config.seq_block == 0 || config.rand_block == 0 ||
+        file_bytes < config.seq_block || file_bytes < config.rand_block) {
+        return false;
+    }
+    size_t buf_size = config.seq_block > config.rand_block ? config.seq_block : config.rand_block;
+    uint8_t* buf = (uint8_t*)storage_dma_alloc(buf_size);
+    if (!buf) {
+        Serial.println("[SD] bench: sem memoria para o buffer");
+        return false;
+    }
+    for (size_t i = 0; i < buf_size; ++i) {
+        buf[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    char path[96];
+    snprintf(path, sizeof(path), "%s/.sd_bench.tmp", dir);
+
+    uint32_t seq_ops = file_bytes / config.seq_block;
+    uint32_t rand_blocks = file_bytes / config.rand_block;
+    out->ok = run_pass(path, true, buf, config.seq_block, seq_ops, 0, false, &out->seq_write) &&
+              run_pass(path, false, buf, config.seq_block, seq_ops, 0, false, &out->seq_read) &&
+              run_pass(path, false, buf, config.rand_block, config.rand_ops, rand_blocks, true,
+                       &out->rand_read) &&
+              run_pass(path, true, buf, config.rand_block, config.rand_ops, rand_blocks, true,
+                       &out->rand_write);
+
+    unlink(path);
+    heap_caps_free(buf);
+    return out->ok;
+}
+
+static void append_result(String& out, const char* name, const SdBenchResult& r) {
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             ",\"%s\":{\"ops\":%lu,\"bytes\":%llu,\"us\":%lu,\"mb_s\":%.2f,\"iops\":%.0f}",
+             name, (unsigned long)r.ops, (unsigned long long)r.bytes,
+             (unsigned long)r.us, r.mb_s, r.iops);
+    out += buf;
+}
+
+String sd_bench_json(const SdBenchReport& report) {
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "{\"ok\":%s,\"file_kb\":%lu,\"seq_block\":%lu,\"rand_block\":%lu",
+             report.ok ? "true" : "false", (unsigned long)report.config.file_kb,
+             (unsigned long)report.config.seq_block, (unsigned long)report.config.rand_block);
+    String out = buf;
+    append_result(out, "seq_write", report.seq_write);
+    append_result(out, "seq_read", report.seq_read);
+    append_result(out, "rand_write", report.rand_write);
+    append_result(out, "rand_read", report.rand_read);
+    out += "}";
+    return out;
+}
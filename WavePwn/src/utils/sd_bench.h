@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Benchmark do cartão (adaptado do sd_card_example_main.c do ESP-IDF):
+// escrita e leitura sequenciais em blocos grandes e escrita/leitura
+// aleatórias em blocos de 4 KB, num arquivo temporário em `dir` (caminho
+// POSIX: STORAGE_MOUNT_POINT "/sd/wavepwn" no firmware). Usa open/read/
+// write sem o buffer do stdio e um buffer de storage_dma_alloc(), o mesmo
+// caminho da captura. O arquivo é apagado no fim.
+//
+// Roda na task que chamar. No firmware é um job da task sd
+// (POST /api/storage/bench), que fica com o cartão só para si enquanto
+// mede: a captura espera.
+
+#define SD_BENCH_FILE_KB    4096
+#define SD_BENCH_SEQ_BLOCK  (32 * 1024)
+#define SD_BENCH_RAND_BLOCK 4096
+#define SD_BENCH_RAND_OPS   256
+
+struct SdBenchConfig {
+    uint32_t file_kb = SD_BENCH_FILE_KB;
+    uint32_t seq_block = SD_BENCH_SEQ_BLOCK;
+    uint32_t rand_block = SD_BENCH_RAND_BLOCK;
+    uint32_t rand_ops = SD_BENCH_RAND_OPS;
+};
+
+struct SdBenchResult {
+    uint32_t ops;
+    uint64_t bytes;
+    uint32_t us;      // inclui o fsync das escritas
+    double mb_s;
+    double iops;
+};
+
+struct SdBenchReport {
+    bool ok;
+    SdBenchConfig config;
+    SdBenchResult seq_write;
+    SdBenchResult seq_read;
+    SdBenchResult rand_write;
+    SdBenchResult rand_read;
+};
+
+// false se o arquivo não pôde ser criado/lido (o que já foi medido fica
+// em `out`)
+bool sd_bench_run(const char* dir, const SdBenchConfig& config, SdBenchReport* out);
+
+String sd_bench_json(const SdBenchReport& report);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SHA-256 (FIPS 180-4) incremental, sem alocação. Usado pelo OTA para
+// conferir a imagem enquanto ela chega.
+#define SHA256_DIGEST_LEN 32
+
+struct Sha256 {
+    uint32_t state[8];
+    uint64_t bytes;
+    uint8_t block[64];
+};
+
+void sha256_init(Sha256* ctx);
+void sha256_update(Sha256* ctx, const void* data, size_t len);
+void sha256_final(Sha256* ctx, uint8_t out[SHA256_DIGEST_LEN]);
+
+// Atalho para um buffer inteiro
+void sha256(const void* data, size_t len, uint8_t out[SHA256_DIGEST_LEN]);
@@ -0,0 +1,577 @@
+#include "web/captures.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "capture/session_log.h"
+#include "storage.h"
+#include "utils/crc32.h"
+#include "web/web_io.h"
+
+struct CaptureDir {
+    const char* name;
+    const char* path;
+};
+
+static const CaptureDir CAPTURE_DIRS[] = {
+    {"handshakes", "/sd/wavepwn/handshakes"},
+    {"session", SESSION_LOG_DIR},
+    {"lab_logs", "/sd/lab_logs"},
+};
+
+const char* captures_dir_path(const char* dir) {
+    if (!dir) return nullptr;
+    for (size_t i = 0; i < sizeof(CAPTURE_DIRS) / sizeof(CAPTURE_DIRS[0]); ++i) {
+        if (strcmp(CAPTURE_DIRS[i].name, dir) == 0) {
+            return CAPTURE_DIRS[i].path;
+        }
+    }
+    return nullptr;
+}
+
+bool captures_valid_name(const char* name) {
+    if (!name || !name[0] || name[0] == '.') return false;
+    size_t len = 0;
+    for (const char* p = name; *p; ++p, ++len) {
+        char c = *p;
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-';
+        if (!ok || len >= CAPTURES_NAME_MAX) return false;
+    }
+    return true;
+}
+
+// Inteiro decimal sem sinal; false se vazio ou estourar size_t
+static bool parse_size(const char*& p, size_t* out) {
+    if (*p < '0' || *p > '9') return false;
+    size_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        size_t d = (size_t)(*p - '0');
+        if (v > ((size_t)-1 - d) / 10) return false;
+        v = v * 10 + d;
+        ++p;
+    }
+    *out = v;
+    return true;
+}
+
+CapturesRange captures_parse_range(const char* header, size_t size, size_t* first, size_t* last) {
+    if (!header || strncmp(header, "bytes=", 6) != 0) return CAPTURES_RANGE_NONE;
+    const char* p = header + 6;
+    while (*p == ' ') ++p;
+
+    // Vários intervalos são opcionais na RFC 7233: responde o arquivo todo
+    if (strchr(p, ',')) return CAPTURES_RANGE_NONE;
+
+    size_t a = 0, b = 0;
+    if (*p == '-') {
+        // Sufixo: os últimos n bytes
+        ++p;
+        if (!parse_size(p, &b) || *p) return CAPTURES_RANGE_NONE;
+        if (b == 0 || size == 0) return CAPTURES_RANGE_UNSATISFIABLE;
+        *first = b >= size ? 0 : size - b;
+        *last = size - 1;
+        return CAPTURES_RANGE_OK;
+    }
+
+    if (!parse_size(p, &a) || *p != '-') return CAPTURES_RANGE_NONE;
+    ++p;
+    bool open_end = (*p == '\0');
+    if (!open_end && (!parse_size(p, &b) || *p || b < a)) return CAPTURES_RANGE_NONE;
+
+    if (a >= size) return CAPTURES_RANGE_UNSATISFIABLE;
+    *first = a;
+    *last = (open_end || b >= size) ? size - 1 : b;
+    return CAPTURES_RANGE_OK;
+}
+
+static const char* content_type_for(const char* name) {
+    const char* ext = strrchr(name, '.');
+    if (ext && (strcmp(ext, ".pcap") == 0 || strcmp(ext, ".pcapng") == 0)) {
+        return "application/vnd.tcpdump.pcap";
+    }
+    if (ext && strcmp(ext, ".log") == 0) {
+        return "text/plain";
+    }
+    return "application/octet-stream";
+}
+
+static String param(AsyncWebServerRequest* request, const char* name) {
+    const AsyncWebParameter* p = request->getParam(name);
+    return p ? p->value() : String();
+}
+
+// -----------------------------------------------------------------------------
+// Cache de tamanhos (escrito na task sd, lido na do AsyncTCP)
+// -----------------------------------------------------------------------------
+
+// O download precisa do tamanho antes de responder (status, Content-Length,
+// Content-Range), e o handler roda na task do AsyncTCP, que não pode esperar
+// o SD. A listagem e as consultas avulsas deixam o tamanho aqui.
+struct SizeEntry {
+    uint8_t dir;                 // índice em CAPTURE_DIRS + 1 (0 = livre)
+    bool exists;
+    uint32_t size;
+    uint32_t stamp_ms;
+    char name[CAPTURES_NAME_MAX + 1];
+};
+
+static SizeEntry size_cache[CAPTURES_SIZE_CACHE];
+static portMUX_TYPE size_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t dir_index(const char* path) {
+    for (size_t i = 0; i < sizeof(CAPTURE_DIRS) / sizeof(CAPTURE_DIRS[0]); ++i) {
+        if (CAPTURE_DIRS[i].path == path) return (uint8_t)(i + 1);
+    }
+    return 0;
+}
+
+// Mesma entrada ou, se não houver, a mais antiga
+static void size_cache_put(uint8_t dir, const char* name, bool exists, uint32_t size) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&size_mux);
+    SizeEntry* slot = nullptr;
+    SizeEntry* oldest = &size_cache[0];
+    for (size_t i = 0; i < CAPTURES_SIZE_CACHE && !slot; ++i) {
+        SizeEntry& e = size_cache[i];
+        if (e.dir == 0 || (e.dir == dir && strcmp(e.name, name) == 0)) {
+            slot = &e;
+        } else if (now - e.stamp_ms > now - oldest->stamp_ms) {
+            oldest = &e;
+        }
+    }
+    if (!slot) slot = oldest;
+    slot->dir = dir;
+    slot->exists = exists;
+    slot->size = size;
+    slot->stamp_ms = now;
+    snprintf(slot->name, sizeof(slot->name), "%s", name);
+    portEXIT_CRITICAL(&size_mux);
+}
+
+// false = sem entrada válida (nunca vista ou vencida)
+static bool size_cache_get(uint8_t dir, const char* name, bool* exists, uint32_t* size) {
+    uint32_t now = millis();
+    bool found = false;
+    portENTER_CRITICAL(&size_mux);
+    for (size_t i = 0; i < CAPTURES_SIZE_CACHE; ++i) {
+        const SizeEntry& e = size_cache[i];
+        if (e.dir != dir || strcmp(e.name, name) != 0) continue;
+        uint32_t ttl = e.exists ? CAPTURES_SIZE_TTL_MS : CAPTURES_MISS_TTL_MS;
+        if (now - e.stamp_ms <= ttl) {
+            *exists = e.exists;
+            *size = e.size;
+            found = true;
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&size_mux);
+    return found;
+}
+
+struct SizeProbe {
+    uint8_t dir;
+    char name[CAPTURES_NAME_MAX + 1];
+};
+
+// Job da task sd: um arquivo fora do cache
+static void size_probe(void* arg) {
+    SizeProbe* probe = (SizeProbe*)arg;
+    char path[96];
+    snprintf(path, sizeof(path), "%s/%s", CAPTURE_DIRS[probe->dir - 1].path, probe->name);
+    File f = SDCARD.open(path, FILE_READ);
+    bool exists = f && !f.isDirectory();
+    size_cache_put(probe->dir, probe->name, exists, exists ? (uint32_t)f.size() : 0);
+    delete probe;
+}
+
+// -----------------------------------------------------------------------------
+// Listagem (task web_io, varredura na task sd)
+// -----------------------------------------------------------------------------
+
+struct CaptureEntry {
+    char name[CAPTURES_NAME_MAX + 1];
+    uint32_t size;
+};
+
+// Só a web_io lista: uma página + 1 (para saber se há próxima)
+static CaptureEntry page[CAPTURES_PAGE_MAX + 1];
+
+struct ListScan {
+    const char* path;
+    const char* cursor;
+    size_t limit;
+    size_t count;
+};
+
+// Uma passada pelo diretório guardando os `limit + 1` menores nomes depois
+// do cursor, em ordem: memória fixa, qualquer número de arquivos
+static void list_scan(void* arg) {
+    ListScan* scan = (ListScan*)arg;
+    size_t limit = scan->limit;
+    size_t count = 0;
+    File root = SDCARD.open(scan->path);
+    if (root && root.isDirectory()) {
+        for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+            if (f.isDirectory()) continue;
+            const char* name = f.name();
+            const char* slash = strrchr(name, '/');
+            if (slash) name = slash + 1;
+            if (!captures_valid_name(name) || strcmp(name, scan->cursor) <= 0) continue;
+
+            size_t pos = count;
+            while (pos > 0 && strcmp(page[pos - 1].name, name) > 0) --pos;
+            if (pos > limit) continue;
+            size_t end = count < limit + 1 ? count : limit;
+            memmove(&page[pos + 1], &page[pos], (end - pos) * sizeof(CaptureEntry));
+            strncpy(page[pos].name, name, CAPTURES_NAME_MAX);
+            page[pos].name[CAPTURES_NAME_MAX] = '\0';
+            page[pos].size = (uint32_t)f.size();
+            if (count < limit + 1) ++count;
+        }
+    }
+    scan->count = count;
+
+    // Os links da página baixam sem consultar o SD de novo
+    uint8_t dir = dir_index(scan->path);
+    for (size_t i = 0; i < count && i < limit; ++i) {
+        size_cache_put(dir, page[i].name, true, page[i].size);
+    }
+}
+
+// arg = "dir\nlimit\ncursor" (validados no handler)
+static String list_json(const String& arg) {
+    int nl1 = arg.indexOf('\n');
+    int nl2 = arg.indexOf('\n', nl1 + 1);
+    String dir = arg.substring(0, nl1);
+    size_t limit = (size_t)arg.substring(nl1 + 1, nl2).toInt();
+    String cursor = arg.substring(nl2 + 1);
+
+    ListScan scan = {captures_dir_path(dir.c_str()), cursor.c_str(), limit, 0};
+    storage_call(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, list_scan, &scan);
+    size_t count = scan.count;
+
+    // Nomes válidos não precisam de escape em JSON
+    bool more = count > limit;
+    if (more) count = limit;
+    String out = "{\"dir\":\"" + dir + "\",\"items\":[";
+    for (size_t i = 0; i < count; ++i) {
+        char item[CAPTURES_NAME_MAX + 48];
+        snprintf(item, sizeof(item), "%s{\"name\":\"%.*s\",\"size\":%lu}",
+                 i ? "," : "", CAPTURES_NAME_MAX, page[i].name, (unsigned long)page[i].size);
+        out += item;
+    }
+    out += "],\"next\":";
+    if (more) {
+        out += "\"";
+        out += page[count - 1].name;
+        out += "\"}";
+    } else {
+        out += "null}";
+    }
+    return out;
+}
+
+static void handle_list(AsyncWebServerRequest* request) {
+    String dir = param(request, "dir");
+    if (!captures_dir_path(dir.c_str())) {
+        request->send(400, "application/json", "{\"error\":\"invalid dir\"}");
+        return;
+    }
+    String cursor = param(request, "cursor");
+    if (cursor.length() > 0 && !captures_valid_name(cursor.c_str())) {
+        request->send(400, "application/json", "{\"error\":\"invalid cursor\"}");
+        return;
+    }
+    long limit = request->hasParam("limit") ? param(request, "limit").toInt() : CAPTURES_PAGE_DEFAULT;
+    if (limit < 1) limit = 1;
+    if (limit > CAPTURES_PAGE_MAX) limit = CAPTURES_PAGE_MAX;
+
+    // Varrer o diretório pode levar centenas de ms no SD: a web_io espera
+    // a task sd, não o AsyncTCP
+    String arg = dir + "\n" + String(limit) + "\n" + cursor;
+    if (!web_io_defer(request, "application/json", list_json, arg)) {
+        request->send(503, "application/json", "{\"error\":\"busy\"}");
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Download com Range
+// -----------------------------------------------------------------------------
+
+// Trecho [first, first + len) de um arquivo, aberto na primeira leitura
+class FileRangeSource : public WebIoSource {
+public:
+    FileRangeSource(const String& path, size_t first, size_t len)
+        : path(path), first(first), remaining(len) {}
+
+    size_t read(uint8_t* buf, size_t cap) override {
+        if (!opened) {
+            opened = true;
+            file = SDCARD.open(path.c_str(), FILE_READ);
+            if (!file || (first > 0 && !file.seek((uint32_t)first))) {
+                remaining = 0;
+            }
+        }
+        if (remaining == 0) return 0;
+        size_t n = file.read(buf, cap < remaining ? cap : remaining);
+        remaining = n > 0 ? remaining - n : 0;
+        storage_account(n, 0);
+        return n;
+    }
+
+private:
+    String path;
+    File file;
+    bool opened = false;
+    size_t first;
+    size_t remaining;
+};
+
+static void handle_file(AsyncWebServerRequest* request) {
+    String dir = param(request, "dir");
+    String name = param(request, "name");
+    const char* dir_path = captures_dir_path(dir.c_str());
+    if (!dir_path || !captures_valid_name(name.c_str())) {
+        request->send(400, "application/json", "{\"error\":\"invalid file\"}");
+        return;
+    }
+
+    // Nada de SD aqui: o tamanho vem do cache. Fora dele, a task sd consulta
+    // o arquivo e o cliente tenta de novo
+    uint8_t dir_id = dir_index(dir_path);
+    bool exists = false;
+    uint32_t cached_size = 0;
+    if (!size_cache_get(dir_id, name.c_str(), &exists, &cached_size)) {
+        SizeProbe* probe = new SizeProbe();
+        probe->dir = dir_id;
+        snprintf(probe->name, sizeof(probe->name), "%s", name.c_str());
+        if (!storage_submit(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, size_probe, probe)) {
+            delete probe;
+        }
+        AsyncWebServerResponse* response =
+            request->beginResponse(503, "application/json", "{\"error\":\"busy\"}");
+        response->addHeader("Retry-After", "1");
+        request->send(response);
+        return;
+    }
+    if (!exists) {
+        request->send(404, "application/json", "{\"error\":\"not found\"}");
+        return;
+    }
+    String path = String(dir_path) + "/" + name;
+    size_t size = cached_size;
+
+    size_t first = 0;
+    size_t last = size > 0 ? size - 1 : 0;
+    const AsyncWebHeader* range_hdr = request->getHeader("Range");
+    CapturesRange range = captures_parse_range(range_hdr ? range_hdr->value().c_str() : nullptr,
+                                               size, &first, &last);
+    char content_range[48];
+    if (range == CAPTURES_RANGE_UNSATISFIABLE) {
+        AsyncWebServerResponse* response = request->beginResponse(416);
+        snprintf(content_range, sizeof(content_range), "bytes */%lu", (unsigned long)size);
+        response->addHeader("Content-Range", content_range);
+        request->send(response);
+        return;
+    }
+
+    const char* type = content_type_for(name.c_str());
+    AsyncWebServerResponse* response;
+    if (size == 0) {
+        response = request->beginResponse(200, type);
+    } else {
+        response = web_io_stream(request, type, last - first + 1,
+                                 new FileRangeSource(path, first, last - first + 1));
+        if (!response) {
+            request->send(503, "application/json", "{\"error\":\"busy\"}");
+            return;
+        }
+        if (range == CAPTURES_RANGE_OK) {
+            response->setCode(206);
+            snprintf(content_range, sizeof(content_range), "bytes %lu-%lu/%lu",
+                     (unsigned long)first, (unsigned long)last, (unsigned long)size);
+            response->addHeader("Content-Range", content_range);
+        }
+    }
+    String disposition = "attachment; filename=\"" + name + "\"";
+    response->addHeader("Accept-Ranges", "bytes");
+    response->addHeader("Content-Disposition", disposition.c_str());
+    request->send(response);
+}
+
+// -----------------------------------------------------------------------------
+// Hashes 22000/16800 a partir dos logs de sessão
+// -----------------------------------------------------------------------------
+
+// Percorre session_*.bin em ordem de id, um registro por vez, e entrega as
+// linhas em pedaços do tamanho que a task sd pedir.
+class HashSource : public WebIoSource {
+public:
+    explicit HashSource(bool handshakes) : handshakes(handshakes) {}
+
+    size_t read(uint8_t* buf, size_t cap) override {
+        size_t out = 0;
+        while (out < cap) {
+            if (line_off == line_len && !next_line()) break;
+            size_t n = line_len - line_off;
+            if (n > cap - out) n = cap - out;
+            memcpy(buf + out, line + line_off, n);
+            line_off += n;
+            out += n;
+        }
+        return out;
+    }
+
+private:
+    bool handshakes;
+    SessionLogReader reader;
+    bool reader_open = false;
+    uint32_t file_id = 0;           // último arquivo aberto
+    uint8_t payload[SESSION_LOG_MAX_PAYLOAD];
+    char line[1024];
+    size_t line_len = 0;
+    size_t line_off = 0;
+    uint32_t seen[CAPTURES_HASH_DEDUP] = {};   // CRC das linhas já enviadas
+    size_t seen_count = 0;
+
+    // Menor id > file_id (os arquivos são poucos: um por boot)
+    bool open_next_file() {
+        uint32_t best = 0;
+        File root = SDCARD.open(SESSION_LOG_DIR);
+        if (root && root.isDirectory()) {
+            for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+                uint32_t id = SessionLog::parse_file_id(f.name());
+                if (id > file_id && (best == 0 || id < best)) best = id;
+            }
+        }
+        if (best == 0) return false;
+
+        file_id = best;
+        char path[64];
+        snprintf(path, sizeof(path), "%s/session_%05lu.bin", SESSION_LOG_DIR, (unsigned long)best);
+        reader_open = reader.open(path);
+        return true;
+    }
+
+    // false = linha repetida. Com a tabela cheia, tudo passa.
+    bool first_time(const char* text, size_t len) {
+        uint32_t h = crc32_update(0, text, len);
+        if (h == 0) h = 1;
+        size_t i = h % CAPTURES_HASH_DEDUP;
+        while (seen[i] != 0) {
+            if (seen[i] == h) return false;
+            i = (i + 1) % CAPTURES_HASH_DEDUP;
+        }
+        if (seen_count < CAPTURES_HASH_DEDUP * 3 / 4) {
+            seen[i] = h;
+            ++seen_count;
+        }
+        return true;
+    }
+
+    bool next_line() {
+        line_len = line_off = 0;
+        for (;;) {
+            if (!reader_open) {
+                if (!open_next_file()) return false;
+                continue;
+            }
+            SessionRecordHeader hdr;
+            if (!reader.next(&hdr, payload)) {
+                reader.close();
+                reader_open = false;
+                continue;
+            }
+            size_t n = handshakes ? format_handshake(hdr) : format_pmkid(hdr);
+            if (n > 0 && first_time(line, n)) {
+                line_len = n;
+                return true;
+            }
+        }
+    }
+
+    static char* hex(char* p, const uint8_t* data, size_t len) {
+        static const char* HEX_DIGITS = "0123456789abcdef";
+        for (size_t i = 0; i < len; ++i) {
+            *p++ = HEX_DIGITS[data[i] >> 4];
+            *p++ = HEX_DIGITS[data[i] & 0x0F];
+        }
+        return p;
+    }
+
+    // Mesmo formato de tools/session_export.py
+    size_t format_pmkid(const SessionRecordHeader& hdr) {
+        if (hdr.type != SESSION_REC_PMKID || hdr.len < sizeof(SessionPmkidRecord)) return 0;
+        SessionPmkidRecord rec;
+        memcpy(&rec, payload, sizeof(rec));
+        if (rec.ssid_len > sizeof(rec.ssid)) return 0;
+
+        char* p = line;
+        memcpy(p, "WPA*01*", 7);
+        p = hex(p + 7, rec.pmkid, 16);
+        *p++ = '*';
+        p = hex(p, rec.ap, 6);
+        *p++ = '*';
+        p = hex(p, rec.sta, 6);
+        *p++ = '*';
+        p = hex(p, (const uint8_t*)rec.ssid, rec.ssid_len);
+        *p++ = '\n';
+        return p - line;
+    }
+
+    size_t format_handshake(const SessionRecordHeader& hdr) {
+        if (hdr.type != SESSION_REC_HANDSHAKE || hdr.len < sizeof(SessionHandshakeRecord)) return 0;
+        SessionHandshakeRecord rec;
+        memcpy(&rec, payload, sizeof(rec));
+        if (rec.ssid_len > sizeof(rec.ssid) ||
+            rec.eapol_len > hdr.len - sizeof(SessionHandshakeRecord)) {
+            return 0;
+        }
+
+        char* p = line;
+        memcpy(p, "WPA*02*", 7);
+        p = hex(p + 7, rec.mic, 16);
+        *p++ = '*';
+        p = hex(p, rec.ap, 6);
+        *p++ = '*';
+        p = hex(p, rec.sta, 6);
+        *p++ = '*';
+        p = hex(p, (const uint8_t*)rec.ssid, rec.ssid_len);
+        *p++ = '*';
+        p = hex(p, rec.anonce, 32);
+        *p++ = '*';
+        p = hex(p, payload + sizeof(SessionHandshakeRecord), rec.eapol_len);
+        *p++ = '*';
+        p = hex(p, &rec.message_pair, 1);
+        *p++ = '\n';
+        return p - line;
+    }
+};
+
+static void handle_hashes(AsyncWebServerRequest* request) {
+    String type = param(request, "type");
+    if (type != "22000" && type != "16800") {
+        request->send(400, "application/json", "{\"error\":\"invalid type\"}");
+        return;
+    }
+
+    // Tamanho total desconhecido até o fim: chunked
+    AsyncWebServerResponse* response =
+        web_io_stream(request, "text/plain", 0, new HashSource(type == "22000"));
+    if (!response) {
+        request->send(503, "application/json", "{\"error\":\"busy\"}");
+        return;
+    }
+    String disposition = "attachment; filename=\"wavepwn." + type + "\"";
+    response->addHeader("Content-Disposition", disposition.c_str());
+    request->send(response);
+}
+
+void captures_register(AsyncWebServer& server) {
+    server.on("/api/captures", HTTP_GET, handle_list);
+    server.on("/api/captures/file", HTTP_GET, handle_file);
+    server.on("/api/captures/hashes", HTTP_GET, handle_hashes);
+}
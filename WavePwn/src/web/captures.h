@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class AsyncWebServer;
+
+// Capturas do SD pelo dashboard, sem carregar arquivos inteiros na RAM.
+//
+//   GET /api/captures?dir=D[&cursor=NOME][&limit=N]
+//       {"dir":"D","items":[{"name":"...","size":123},...],"next":"..."|null}
+//       Ordem lexicográfica dos nomes, paginação por chave: a próxima página
+//       é pedida com cursor=next. Arquivos criados entre páginas aparecem se
+//       o nome vier depois do cursor; nenhum se repete.
+//
+//   GET /api/captures/file?dir=D&name=NOME
+//       Download. Aceita "Range: bytes=a-b | a- | -n" (um intervalo; 206 com
+//       Content-Range, 416 se fora do arquivo). Vários intervalos: 200 com o
+//       arquivo inteiro. O tamanho vem do cache preenchido pela listagem:
+//       arquivo fora dele (link direto, entrada vencida) responde 503 com
+//       Retry-After enquanto a task sd consulta o cartão, e a repetição sai
+//       com 200/206/404.
+//
+//   GET /api/captures/hashes?type=22000|16800
+//       Linhas hashcat (WPA*02 / WPA*01) de todos os logs de sessão, na
+//       ordem em que foram gravadas, geradas enquanto a resposta sai. Linhas
+//       repetidas (PMKID visto em vários beacons) saem uma vez só enquanto
+//       couberem na tabela de CAPTURES_HASH_DEDUP entradas. Para escolher o
+//       melhor par por AP/STA, usar tools/session_export.py.
+//
+// D = handshakes (PCAPs), session (logs binários) ou lab_logs.
+
+#define CAPTURES_PAGE_DEFAULT  50
+#define CAPTURES_PAGE_MAX      100
+#define CAPTURES_NAME_MAX      64
+#define CAPTURES_HASH_DEDUP    1024
+#define CAPTURES_SIZE_CACHE    128      // entradas nome -> tamanho
+#define CAPTURES_SIZE_TTL_MS   60000    // validade de um tamanho lido do SD
+#define CAPTURES_MISS_TTL_MS   2000     // validade de um "não existe"
+
+void captures_register(AsyncWebServer& server);
+
+// Diretório do SD para o nome curto de `dir` (nullptr se desconhecido)
+const char* captures_dir_path(const char* dir);
+
+// Nome de arquivo aceito na API: [A-Za-z0-9._-], sem começar com '.'
+bool captures_valid_name(const char* name);
+
+enum CapturesRange : uint8_t {
+    CAPTURES_RANGE_NONE = 0,        // sem Range útil: 200 com tudo
+    CAPTURES_RANGE_OK,              // 206 com [first, last]
+    CAPTURES_RANGE_UNSATISFIABLE,   // 416
+};
+
+// Interpreta o cabeçalho Range para um arquivo de `size` bytes
+CapturesRange captures_parse_range(const char* header, size_t size, size_t* first, size_t* last);
@@ -0,0 +1,225 @@
+#include "web/ota_http.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "utils/ota_secure.h"
+
+static const char* ota_user = "";
+static const char* ota_pass = "";
+
+// Estado de um POST /ota/chunk entre os pedaços do corpo (_tempObject,
+// liberado com free() pelo próprio request)
+struct OtaChunkRequest {
+    uint32_t next;
+    OtaResult result;
+};
+
+static String param(AsyncWebServerRequest* request, const char* name) {
+    const AsyncWebParameter* p = request->getParam(name);
+    return p ? p->value() : String();
+}
+
+static bool authorized(AsyncWebServerRequest* request) {
+    if (!request->authenticate(ota_user, ota_pass)) {
+        request->requestAuthentication();
+        return false;
+    }
+    return true;
+}
+
+static void send_json(AsyncWebServerRequest* request, int code, const char* json) {
+    request->send(code, "application/json", json);
+}
+
+static void send_offset(AsyncWebServerRequest* request, int code, const char* error) {
+    OtaStatus st;
+    ota_get_status(&st);
+    char buf[128];
+    if (error) {
+        snprintf(buf, sizeof(buf), "{\"error\":\"%s\",\"offset\":%u,\"buffered\":%u}",
+                 error, (unsigned)st.received, (unsigned)(st.received - st.consumed));
+    } else {
+        snprintf(buf, sizeof(buf), "{\"offset\":%u,\"buffered\":%u}",
+                 (unsigned)st.received, (unsigned)(st.received - st.consumed));
+    }
+    send_json(request, code, buf);
+}
+
+bool ota_http_parse_hex(const char* hex, uint8_t* out, size_t cap, size_t* len) {
+    size_t n = strlen(hex);
+    if (n % 2 != 0 || n / 2 > cap) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        char c = hex[i];
+        uint8_t v;
+        if (c >= '0' && c <= '9') {
+            v = (uint8_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            v = (uint8_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            v = (uint8_t)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+        if (i % 2 == 0) {
+            out[i / 2] = (uint8_t)(v << 4);
+        } else {
+            out[i / 2] |= v;
+        }
+    }
+    *len = n / 2;
+    return true;
+}
+
+// Versão vai crua para o JSON do status e para a mensagem assinada
+static bool valid_version(const String& v) {
+    if (v.length() == 0 || v.length() >= OTA_VERSION_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < v.length(); ++i) {
+        char c = v[i];
+        bool ok = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  c == '.' || c == '-' || c == '_' || c == '+';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Handlers (task do AsyncTCP; nenhum toca na flash)
+// -----------------------------------------------------------------------------
+
+static void handle_begin(AsyncWebServerRequest* request) {
+    if (!authorized(request)) return;
+
+    OtaManifest m;
+    memset(&m, 0, sizeof(m));
+    String size = param(request, "size");
+    String hash = param(request, "sha256");
+    String version = param(request, "version");
+    String sig = param(request, "sig");
+    String patch = param(request, "patch");
+
+    size_t hash_len = 0;
+    long size_value = size.toInt();
+    long patch_value = patch.length() ? patch.toInt() : 0;
+    if (size_value <= 0 || patch_value < 0 || (patch.length() && patch_value == 0) ||
+        !valid_version(version) ||
+        !ota_http_parse_hex(hash.c_str(), m.sha256, sizeof(m.sha256), &hash_len) ||
+        hash_len != SHA256_DIGEST_LEN ||
+        !ota_http_parse_hex(sig.c_str(), m.sig, sizeof(m.sig), &m.sig_len)) {
+        send_json(request, 400, "{\"error\":\"manifest\"}");
+        return;
+    }
+    m.size = (uint32_t)size_value;
+    m.patch_size = (uint32_t)patch_value;
+    strncpy(m.version, version.c_str(), sizeof(m.version) - 1);
+
+    uint32_t offset = 0;
+    OtaResult r = ota_begin_secure(m, &offset);
+    if (r != OTA_OK) {
+        int code = r == OTA_ERR_SIGNATURE ? 403 : r == OTA_ERR_SIZE ? 413 : r == OTA_ERR_MANIFEST ? 400 : 500;
+        char buf[64];
+        snprintf(buf, sizeof(buf), "{\"error\":\"%s\"}", ota_result_name(r));
+        send_json(request, code, buf);
+        return;
+    }
+
+    OtaStatus st;
+    ota_get_status(&st);
+    char buf[128];
+    snprintf(buf, sizeof(buf), "{\"state\":\"%s\",\"offset\":%u,\"size\":%u,\"patch\":%u}",
+             ota_state_name(st.state), (unsigned)offset, (unsigned)m.size, (unsigned)m.patch_size);
+    send_json(request, 200, buf);
+}
+
+static void handle_chunk_body(AsyncWebServerRequest* request,
+                              uint8_t* data,
+                              size_t len,
+                              size_t index,
+                              size_t total) {
+    (void)total;
+    if (!request->authenticate(ota_user, ota_pass)) return;
+
+    OtaChunkRequest* ctx = (OtaChunkRequest*)request->_tempObject;
+    if (index == 0 && !ctx) {
+        ctx = (OtaChunkRequest*)calloc(1, sizeof(OtaChunkRequest));
+        if (!ctx) return;
+        request->_tempObject = ctx;
+        String offset = param(request, "offset");
+        ctx->next = (uint32_t)offset.toInt();
+        ctx->result = offset.length() ? OTA_OK : OTA_ERR_OFFSET;
+    }
+    // Depois de um erro, o resto do corpo é descartado; o cliente retoma
+    // pelo offset da resposta
+    if (!ctx || ctx->result != OTA_OK) return;
+
+    size_t accepted = 0;
+    ctx->result = ota_write_chunk(ctx->next, data, len, &accepted);
+    ctx->next += (uint32_t)accepted;
+}
+
+static void handle_chunk(AsyncWebServerRequest* request) {
+    if (!authorized(request)) return;
+
+    OtaChunkRequest* ctx = (OtaChunkRequest*)request->_tempObject;
+    if (!ctx) {
+        send_json(request, 400, "{\"error\":\"empty\"}");
+        return;
+    }
+    switch (ctx->result) {
+        case OTA_OK:
+            send_offset(request, 200, nullptr);
+            break;
+        case OTA_ERR_BUSY:
+            send_offset(request, 503, "busy");
+            break;
+        case OTA_ERR_SIZE:
+            send_offset(request, 413, "size");
+            break;
+        default:
+            send_offset(request, 409, ota_result_name(ctx->result));
+            break;
+    }
+}
+
+static void handle_status(AsyncWebServerRequest* request) {
+    if (!authorized(request)) return;
+
+    OtaStatus st;
+    ota_get_status(&st);
+    char error[40];
+    if (st.error) {
+        snprintf(error, sizeof(error), "\"%s\"", st.error);
+    } else {
+        strcpy(error, "null");
+    }
+    char buf[320];
+    snprintf(buf, sizeof(buf),
+             "{\"state\":\"%s\",\"size\":%u,\"patch\":%u,\"offset\":%u,\"written\":%u,\"buffered\":%u,"
+             "\"erased\":%u,\"version\":\"%s\",\"error\":%s}",
+             ota_state_name(st.state), (unsigned)st.size, (unsigned)st.patch_size, (unsigned)st.received,
+             (unsigned)st.written, (unsigned)(st.received - st.consumed), (unsigned)st.erased,
+             st.version, error);
+    send_json(request, 200, buf);
+}
+
+static void handle_abort(AsyncWebServerRequest* request) {
+    if (!authorized(request)) return;
+    ota_abort();
+    send_json(request, 200, "{\"state\":\"idle\"}");
+}
+
+void ota_http_register(AsyncWebServer& server, const char* user, const char* pass) {
+    ota_user = user;
+    ota_pass = pass;
+
+    server.on("/ota/begin", HTTP_POST, handle_begin);
+    server.on("/ota/chunk", HTTP_POST, handle_chunk, nullptr, handle_chunk_body);
+    server.on("/ota/status", HTTP_GET, handle_status);
+    server.on("/ota/abort", HTTP_POST, handle_abort);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils/ota_secure.h"
+
+class AsyncWebServer;
+
+// Rotas do OTA retomável (utils/ota_secure). Todas pedem HTTP Basic Auth.
+// O cliente (ota/update.html ou tools/ota/ota_upload.py) manda o manifesto,
+// depois a imagem em pedaços, e acompanha pelo status:
+//
+//   POST /ota/begin?size=N&sha256=HEX&version=V[&sig=HEX][&patch=P]
+//       200 {"state":"receiving","offset":O,"size":N,"patch":P}. O > 0:
+//       sessão com o mesmo manifesto retomada, reenviar a partir de O.
+//       patch=P: o corpo dos chunks é um patch delta de P bytes contra a
+//       imagem em execução (tools/ota/ota_delta.py); offsets contam o patch.
+//       400 manifest | 403 signature | 413 size | 500 no partition/memory
+//
+//   POST /ota/chunk?offset=O      corpo application/octet-stream
+//       200 {"offset":O',"buffered":B}  próximo offset
+//       409 {"error":"offset|state",...}   retomar de O'
+//       503 {"error":"busy",...}  anel cheio: esperar e retomar de O'
+//
+//   GET  /ota/status
+//       {"state":"idle|receiving|verifying|ready|failed","size":N,"patch":P,
+//        "offset":O,"written":W,"buffered":B,"version":"V","error":null|"..."}
+//       written conta bytes da imagem; error "base" no delta: o patch não é
+//       da imagem em execução.
+//       buffered = bytes no anel ainda não gravados; o cliente mantém
+//       buffered + próximo pedaço <= OTA_HTTP_WINDOW para não receber 503.
+//
+//   POST /ota/abort
+//
+// Conexão caída no meio de um /ota/chunk: o que chegou fica aceito; o
+// cliente consulta o status e continua do offset.
+
+#define OTA_HTTP_CHUNK   (16 * 1024)   // pedaço sugerido ao cliente
+#define OTA_HTTP_WINDOW  (OTA_RING_BLOCKS * OTA_BLOCK_SIZE)
+
+void ota_http_register(AsyncWebServer& server, const char* user, const char* pass);
+
+// Hex -> bytes. false se ímpar, com dígito inválido ou maior que `cap`.
+bool ota_http_parse_hex(const char* hex, uint8_t* out, size_t cap, size_t* len);
@@ -0,0 +1,461 @@
+#include "web/telemetry.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ESPAsyncWebServer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Período de cada canal. Os contadores do dashboard mudam em segundos; a
+// tabela de APs custa mais para montar e quase não muda de um tick a outro.
+static const uint32_t TELEM_PERIOD_MS[TELEM_CH_COUNT] = {
+    500,    // stats
+    2000,   // aps
+    250,    // log
+    500,    // threat
+};
+
+// Snapshot completo para todos de tempos em tempos: repõe frames que a fila
+// do AsyncWebSocket descartou. O log é fluxo de eventos e fica de fora.
+static const uint32_t TELEM_KEYFRAME_MS = 10000;
+
+// -----------------------------------------------------------------------------
+// Montagem dos frames
+// -----------------------------------------------------------------------------
+
+struct FrameWriter {
+    uint8_t* out;
+    size_t cap;
+    size_t len;
+    bool ok;
+
+    FrameWriter(uint8_t* o, size_t c) : out(o), cap(c), len(0), ok(true) {}
+
+    void u8(uint8_t v) {
+        if (len < cap) {
+            out[len++] = v;
+        } else {
+            ok = false;
+        }
+    }
+
+    void varint(uint32_t v) {
+        while (v >= 0x80) {
+            u8((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        u8((uint8_t)v);
+    }
+
+    void zigzag(int32_t v) {
+        varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+    }
+
+    void bytes(const void* p, size_t n) {
+        if (len + n > cap) {
+            ok = false;
+            return;
+        }
+        memcpy(out + len, p, n);
+        len += n;
+    }
+
+    size_t done() const { return ok ? len : 0; }
+};
+
+bool TelemetryEncoder::update_stats(const int32_t* values) {
+    stats_changed = 0;
+    for (uint8_t i = 0; i < TELEM_STAT_COUNT; ++i) {
+        if (!stats_valid || values[i] != stats[i]) {
+            stats[i] = values[i];
+            stats_changed |= 1u << i;
+        }
+    }
+    stats_valid = true;
+    if (stats_changed) seq[TELEM_CH_STATS]++;
+    return stats_changed != 0;
+}
+
+bool TelemetryEncoder::update_threat(uint8_t cls) {
+    threat_changed = !threat_valid || cls != threat;
+    threat = cls;
+    threat_valid = true;
+    if (threat_changed) seq[TELEM_CH_THREAT]++;
+    return threat_changed;
+}
+
+bool TelemetryEncoder::update_aps(const ApInfo* in, size_t n) {
+    if (n > TELEM_AP_MAX) n = TELEM_AP_MAX;
+
+    bool any = false;
+    for (size_t i = 0; i < n; ++i) {
+        const ApInfo& ap = in[i];
+        SentAp& e = scratch[i];
+
+        const SentAp* prev = nullptr;
+        for (size_t j = 0; j < ap_count; ++j) {
+            if (memcmp(aps[j].bssid, ap.bssid, 6) == 0) {
+                prev = &aps[j];
+                break;
+            }
+        }
+
+        if (prev) {
+            e = *prev;
+            e.changed = 0;
+        } else {
+            memset(&e, 0, sizeof(e));
+            memcpy(e.bssid, ap.bssid, 6);
+            e.changed = TELEM_AP_ALL;
+        }
+
+        if (strncmp(e.ssid, ap.ssid, sizeof(e.ssid)) != 0) {
+            strncpy(e.ssid, ap.ssid, sizeof(e.ssid) - 1);
+            e.ssid[sizeof(e.ssid) - 1] = '\0';
+            e.changed |= TELEM_AP_SSID;
+        }
+        if (e.channel != ap.channel) {
+            e.channel = ap.channel;
+            e.changed |= TELEM_AP_CHANNEL;
+        }
+        int8_t rssi = ap.rssi();
+        if (!prev || abs(rssi - e.rssi) >= TELEM_AP_RSSI_STEP) {
+            e.rssi = rssi;
+            e.changed |= TELEM_AP_RSSI;
+        }
+        if (e.encryption != ap.encryption) {
+            e.encryption = ap.encryption;
+            e.changed |= TELEM_AP_ENC;
+        }
+        if (e.clients != ap.clients) {
+            e.clients = ap.clients;
+            e.changed |= TELEM_AP_CLIENTS;
+        }
+        if (e.capture_flags != ap.capture_flags) {
+            e.capture_flags = ap.capture_flags;
+            e.changed |= TELEM_AP_FLAGS;
+        }
+        if (e.changed) any = true;
+    }
+
+    // Saiu do top-N (ou da janela ativa)
+    deleted_count = 0;
+    for (size_t j = 0; j < ap_count; ++j) {
+        bool kept = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (memcmp(scratch[i].bssid, aps[j].bssid, 6) == 0) {
+                kept = true;
+                break;
+            }
+        }
+        if (!kept) {
+            memcpy(deleted[deleted_count++], aps[j].bssid, 6);
+        }
+    }
+    if (deleted_count) any = true;
+
+    memcpy(aps, scratch, n * sizeof(SentAp));
+    ap_count = n;
+    if (any) seq[TELEM_CH_APS]++;
+    return any;
+}
+
+void TelemetryEncoder::push_log(const char* line) {
+    size_t slot;
+    if (pending_count < TELEM_LOG_MAX) {
+        slot = (pending_head + pending_count) % TELEM_LOG_MAX;
+        pending_count++;
+    } else {
+        // Fila cheia: perde a mais antiga
+        slot = pending_head;
+        pending_head = (pending_head + 1) % TELEM_LOG_MAX;
+    }
+    strncpy(pending[slot].text, line, TELEM_LOG_LINE_MAX - 1);
+    pending[slot].text[TELEM_LOG_LINE_MAX - 1] = '\0';
+}
+
+bool TelemetryEncoder::update_log() {
+    fresh_count = pending_count;
+    for (size_t k = 0; k < pending_count; ++k) {
+        const LogLine& line = pending[(pending_head + k) % TELEM_LOG_MAX];
+        if (history_count < TELEM_LOG_MAX) {
+            history[(history_head + history_count) % TELEM_LOG_MAX] = line;
+            history_count++;
+        } else {
+            history[history_head] = line;
+            history_head = (history_head + 1) % TELEM_LOG_MAX;
+        }
+    }
+    pending_head = 0;
+    pending_count = 0;
+    if (fresh_count) seq[TELEM_CH_LOG]++;
+    return fresh_count != 0;
+}
+
+size_t TelemetryEncoder::write(uint8_t channel, bool full, uint8_t* out, size_t cap) const {
+    switch (channel) {
+        case TELEM_CH_STATS:
+            return write_stats(full, out, cap);
+        case TELEM_CH_APS:
+            return write_aps(full, out, cap);
+        case TELEM_CH_LOG:
+            return write_log(full, out, cap);
+        case TELEM_CH_THREAT: {
+            if (!threat_valid || (!full && !threat_changed)) return 0;
+            FrameWriter w(out, cap);
+            w.u8(TELEM_CH_THREAT | (full ? TELEM_FLAG_FULL : 0));
+            w.u8(seq[TELEM_CH_THREAT]);
+            w.u8(threat);
+            return w.done();
+        }
+        default:
+            return 0;
+    }
+}
+
+size_t TelemetryEncoder::write_stats(bool full, uint8_t* out, size_t cap) const {
+    if (!stats_valid || (!full && !stats_changed)) return 0;
+
+    FrameWriter w(out, cap);
+    w.u8(TELEM_CH_STATS | (full ? TELEM_FLAG_FULL : 0));
+    w.u8(seq[TELEM_CH_STATS]);
+    for (uint8_t i = 0; i < TELEM_STAT_COUNT; ++i) {
+        if (full || (stats_changed & (1u << i))) {
+            w.u8(i);
+            w.zigzag(stats[i]);
+        }
+    }
+    return w.done();
+}
+
+size_t TelemetryEncoder::write_aps(bool full, uint8_t* out, size_t cap) const {
+    size_t updates = 0;
+    for (size_t i = 0; i < ap_count; ++i) {
+        if (full || aps[i].changed) updates++;
+    }
+    size_t deletions = full ? 0 : deleted_count;
+    if (!full && updates == 0 && deletions == 0) return 0;
+
+    FrameWriter w(out, cap);
+    w.u8(TELEM_CH_APS | (full ? TELEM_FLAG_FULL : 0));
+    w.u8(seq[TELEM_CH_APS]);
+
+    w.u8((uint8_t)updates);
+    for (size_t i = 0; i < ap_count; ++i) {
+        const SentAp& e = aps[i];
+        uint8_t mask = full ? TELEM_AP_ALL : e.changed;
+        if (!mask) continue;
+
+        w.bytes(e.bssid, 6);
+        w.u8(mask);
+        if (mask & TELEM_AP_SSID) {
+            size_t n = strnlen(e.ssid, sizeof(e.ssid) - 1);
+            w.u8((uint8_t)n);
+            w.bytes(e.ssid, n);
+        }
+        if (mask & TELEM_AP_CHANNEL) w.u8(e.channel);
+        if (mask & TELEM_AP_RSSI) w.u8((uint8_t)e.rssi);
+        if (mask & TELEM_AP_ENC) w.u8(e.encryption);
+        if (mask & TELEM_AP_CLIENTS) w.varint(e.clients);
+        if (mask & TELEM_AP_FLAGS) w.u8(e.capture_flags);
+    }
+
+    w.u8((uint8_t)deletions);
+    for (size_t i = 0; i < deletions; ++i) {
+        w.bytes(deleted[i], 6);
+    }
+    return w.done();
+}
+
+size_t TelemetryEncoder::write_log(bool full, uint8_t* out, size_t cap) const {
+    size_t count = full ? history_count : fresh_count;
+    if (count == 0) return 0;
+
+    FrameWriter w(out, cap);
+    w.u8(TELEM_CH_LOG | (full ? TELEM_FLAG_FULL : 0));
+    w.u8(seq[TELEM_CH_LOG]);
+
+    // As linhas novas são as últimas do histórico
+    for (size_t k = history_count - count; k < history_count; ++k) {
+        const LogLine& line = history[(history_head + k) % TELEM_LOG_MAX];
+        size_t n = strlen(line.text);
+        w.varint((uint32_t)n);
+        w.bytes(line.text, n);
+    }
+    return w.done();
+}
+
+// -----------------------------------------------------------------------------
+// Publisher
+// -----------------------------------------------------------------------------
+
+struct TelemetryClient {
+    uint32_t id;
+    uint8_t mask;        // canais assinados
+    uint8_t need_full;   // canais que ainda devem um snapshot
+    bool used;
+};
+
+static AsyncWebSocket* telem_ws = nullptr;
+static TelemetrySources telem_sources = {};
+static SemaphoreHandle_t telem_mutex = nullptr;
+
+// Clientes e fila do log são tocados por qualquer task (sob telem_mutex); o
+// resto do encoder e os buffers só pela task que chama telemetry_tick().
+static TelemetryEncoder encoder;
+static TelemetryClient telem_clients[TELEM_MAX_CLIENTS];
+static uint32_t last_tick_ms[TELEM_CH_COUNT];
+static uint32_t last_key_ms[TELEM_CH_COUNT];
+static ApInfo ap_scratch[TELEM_AP_MAX];
+static uint8_t delta_buf[TELEM_FRAME_MAX];
+static uint8_t full_buf[TELEM_FRAME_MAX];
+
+struct TelemetryLock {
+    TelemetryLock() { xSemaphoreTake(telem_mutex, portMAX_DELAY); }
+    ~TelemetryLock() { xSemaphoreGive(telem_mutex); }
+};
+
+void telemetry_begin(AsyncWebSocket* ws, const TelemetrySources& sources) {
+    if (!telem_mutex) {
+        telem_mutex = xSemaphoreCreateMutex();
+    }
+    telem_sources = sources;
+    telem_ws = ws;
+}
+
+void telemetry_client_connected(uint32_t client_id) {
+    if (!telem_mutex) return;
+    TelemetryLock lock;
+    for (size_t i = 0; i < TELEM_MAX_CLIENTS; ++i) {
+        TelemetryClient& c = telem_clients[i];
+        if (!c.used) {
+            c.id = client_id;
+            c.mask = TELEM_DEFAULT_MASK;
+            c.need_full = TELEM_DEFAULT_MASK;
+            c.used = true;
+            return;
+        }
+    }
+}
+
+void telemetry_client_disconnected(uint32_t client_id) {
+    if (!telem_mutex) return;
+    TelemetryLock lock;
+    for (size_t i = 0; i < TELEM_MAX_CLIENTS; ++i) {
+        if (telem_clients[i].used && telem_clients[i].id == client_id) {
+            telem_clients[i].used = false;
+        }
+    }
+}
+
+void telemetry_client_message(uint32_t client_id, const uint8_t* data, size_t len) {
+    if (!telem_mutex || len < 2 || data[0] != TELEM_OP_SUBSCRIBE) return;
+
+    uint8_t mask = data[1] & TELEM_MASK_ALL;
+    TelemetryLock lock;
+    for (size_t i = 0; i < TELEM_MAX_CLIENTS; ++i) {
+        TelemetryClient& c = telem_clients[i];
+        if (c.used && c.id == client_id) {
+            // Snapshot só dos canais que o cliente ainda não tinha
+            c.need_full |= mask & ~c.mask;
+            c.need_full &= mask;
+            c.mask = mask;
+        }
+    }
+}
+
+void telemetry_log(const char* line) {
+    if (!telem_mutex || !line) return;
+    TelemetryLock lock;
+    encoder.push_log(line);
+}
+
+void telemetry_tick(uint32_t now_ms) {
+    if (!telem_ws || !telem_mutex) return;
+
+    // Foto dos clientes sob o lock; montagem e envio ficam fora dele
+    TelemetryClient clients[TELEM_MAX_CLIENTS];
+    uint8_t due = 0;
+    bool log_fresh = false;
+    {
+        TelemetryLock lock;
+        uint8_t subscribed = 0;
+        uint8_t pending_full = 0;
+        for (size_t i = 0; i < TELEM_MAX_CLIENTS; ++i) {
+            if (!telem_clients[i].used) continue;
+            subscribed |= telem_clients[i].mask;
+            pending_full |= telem_clients[i].need_full;
+        }
+        for (uint8_t ch = 0; ch < TELEM_CH_COUNT; ++ch) {
+            uint8_t bit = TELEM_MASK(ch);
+            if (!(subscribed & bit)) continue;
+            if ((pending_full & bit) || now_ms - last_tick_ms[ch] >= TELEM_PERIOD_MS[ch]) {
+                due |= bit;
+            }
+        }
+        if (!due) return;
+
+        memcpy(clients, telem_clients, sizeof(clients));
+        for (size_t i = 0; i < TELEM_MAX_CLIENTS; ++i) {
+            telem_clients[i].need_full &= ~due;
+        }
+        if (due & TELEM_MASK(TELEM_CH_LOG)) {
+            log_fresh = encoder.update_log();
+        }
+    }
+
+    for (uint8_t ch = 0; ch < TELEM_CH_COUNT; ++ch) {
+        uint8_t bit = TELEM_MASK(ch);
+        if (!(due & bit)) continue;
+
+        bool changed = false;
+        switch (ch) {
+            case TELEM_CH_STATS: {
+                int32_t values[TELEM_STAT_COUNT];
+                telem_sources.stats(values, now_ms);
+                changed = encoder.update_stats(values);
+                break;
+            }
+            case TELEM_CH_APS: {
+                size_t n = telem_sources.aps(ap_scratch, TELEM_AP_MAX, now_ms);
+                changed = encoder.update_aps(ap_scratch, n);
+                break;
+            }
+            case TELEM_CH_LOG:
+                changed = log_fresh;
+                break;
+            case TELEM_CH_THREAT:
+                changed = encoder.update_threat(telem_sources.threat());
+                break;
+        }
+        last_tick_ms[ch] = now_ms;
+
+        bool keyframe = false;
+        if (ch != TELEM_CH_LOG && now_ms - last_key_ms[ch] >= TELEM_KEYFRAME_MS) {
+            keyframe = true;
+            last_key_ms[ch] = now_ms;
+        }
+
+        size_t delta_len = 0;
+        if (changed && !keyframe) {
+            delta_len = encoder.write(ch, false, delta_buf, sizeof(delta_buf));
+        }
+        size_t full_len = 0;
+        bool full_built = false;
+
+        for (size_t i = 0; i < TELEM_MAX_CLIENTS; ++i) {
+            const TelemetryClient& c = clients[i];
+            if (!c.used || !(c.mask & bit)) continue;
+
+            if (keyframe || (c.need_full & bit)) {
+                if (!full_built) {
+                    full_len = encoder.write(ch, true, full_buf, sizeof(full_buf));
+                    full_built = true;
+                }
+                if (full_len) telem_ws->binary(c.id, full_buf, full_len);
+            } else if (delta_len) {
+                telem_ws->binary(c.id, delta_buf, delta_len);
+            }
+        }
+    }
+}
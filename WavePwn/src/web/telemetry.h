@@ -0,0 +1,169 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "capture/ap_table.h"
+
+class AsyncWebSocket;
+
+// Telemetria binária do dashboard (WebSocket /ws).
+//
+// Cada canal tem período próprio e, a cada tick, só vai para o cliente o que
+// mudou desde o envio anterior. Os clientes escolhem os canais com uma
+// mensagem de assinatura; quem acabou de assinar recebe um snapshot completo.
+//
+// Frame servidor -> cliente (mensagem binária, inteiros little-endian):
+//
+//   [0]  canal (TELEM_CH_*) | TELEM_FLAG_FULL no snapshot completo
+//   [1]  seq (u8, por canal)
+//
+//   stats   n x ([id u8][valor varint zigzag]) só dos campos alterados
+//   threat  [classe u8]
+//   log     n x ([len varint][utf-8]), linhas novas (completo: as últimas)
+//   aps     [n_upd u8] + n_upd x ([bssid 6][máscara u8][campos TELEM_AP_*])
+//           [n_del u8] + n_del x [bssid 6]
+//           completo: o cliente descarta a tabela antes de aplicar
+//
+// Os valores vão absolutos (não a diferença numérica): um frame descartado
+// pela fila do AsyncWebSocket só atrasa a atualização até o próximo keyframe.
+//
+// Cliente -> servidor (mensagem binária): [TELEM_OP_SUBSCRIBE][máscara u8]
+
+enum TelemetryChannel : uint8_t {
+    TELEM_CH_STATS = 0,
+    TELEM_CH_APS,
+    TELEM_CH_LOG,
+    TELEM_CH_THREAT,
+    TELEM_CH_COUNT,
+};
+
+#define TELEM_MASK(ch)        (1u << (ch))
+#define TELEM_MASK_ALL        ((1u << TELEM_CH_COUNT) - 1)
+#define TELEM_FLAG_FULL       0x80
+#define TELEM_OP_SUBSCRIBE    0x53   // 'S'
+
+enum TelemetryStat : uint8_t {
+    TELEM_STAT_UPTIME = 0,
+    TELEM_STAT_BATTERY,
+    TELEM_STAT_APS,
+    TELEM_STAT_APS_ACTIVE,
+    TELEM_STAT_CLIENTS,
+    TELEM_STAT_OPEN,
+    TELEM_STAT_WPA3,
+    TELEM_STAT_APS_HS,
+    TELEM_STAT_RSSI_MAX,
+    TELEM_STAT_CHANNEL,
+    TELEM_STAT_HANDSHAKES,
+    TELEM_STAT_PMKIDS,
+    TELEM_STAT_FRAMES,
+    TELEM_STAT_DROPS,
+    TELEM_STAT_COUNT,
+};
+
+// Campos de uma entrada do canal aps (máscara, na ordem em que são escritos)
+#define TELEM_AP_SSID      0x01   // [len u8][bytes]
+#define TELEM_AP_CHANNEL   0x02   // u8
+#define TELEM_AP_RSSI      0x04   // i8
+#define TELEM_AP_ENC       0x08   // u8 (ApEncryption)
+#define TELEM_AP_CLIENTS   0x10   // varint
+#define TELEM_AP_FLAGS     0x20   // u8 (AP_CAPTURE_*)
+#define TELEM_AP_ALL       0x3F
+
+#define TELEM_AP_MAX        20    // top-N por RSSI
+#define TELEM_AP_RSSI_STEP  2     // dB: variação menor não é enviada
+#define TELEM_LOG_MAX       8     // linhas por frame / guardadas para o snapshot
+#define TELEM_LOG_LINE_MAX  160
+#define TELEM_FRAME_MAX     1536
+
+// Estado por canal e montagem dos frames. Sem I/O e sem locks: quem usa
+// serializa as chamadas (o publisher abaixo faz isso).
+class TelemetryEncoder {
+public:
+    // update_*: compara com o último envio, guarda o estado novo e devolve
+    // true se há delta a enviar.
+    bool update_stats(const int32_t* values);   // TELEM_STAT_COUNT valores
+    bool update_threat(uint8_t cls);
+    bool update_aps(const ApInfo* aps, size_t n);
+
+    // Linhas entram na fila e saem no próximo update_log()
+    void push_log(const char* line);
+    bool update_log();
+
+    // Frame do canal: delta do último update_* ou, com `full`, o estado
+    // inteiro. 0 = nada a enviar (ou não coube em `cap`).
+    size_t write(uint8_t channel, bool full, uint8_t* out, size_t cap) const;
+
+private:
+    struct SentAp {
+        uint8_t  bssid[6];
+        char     ssid[33];
+        uint8_t  channel;
+        int8_t   rssi;
+        uint8_t  encryption;
+        uint8_t  capture_flags;
+        uint16_t clients;
+        uint8_t  changed;   // TELEM_AP_* do último update
+    };
+
+    struct LogLine {
+        char text[TELEM_LOG_LINE_MAX];
+    };
+
+    uint8_t seq[TELEM_CH_COUNT] = {};
+
+    int32_t stats[TELEM_STAT_COUNT] = {};
+    uint32_t stats_changed = 0;   // bit por TelemetryStat
+    bool stats_valid = false;
+
+    uint8_t threat = 0;
+    bool threat_valid = false;
+    bool threat_changed = false;
+
+    SentAp aps[TELEM_AP_MAX];       // como o cliente vê a tabela
+    SentAp scratch[TELEM_AP_MAX];
+    size_t ap_count = 0;
+    uint8_t deleted[TELEM_AP_MAX][6];
+    size_t deleted_count = 0;
+
+    // Fila de linhas novas e histórico (últimas TELEM_LOG_MAX), circulares
+    LogLine pending[TELEM_LOG_MAX];
+    size_t pending_head = 0;
+    size_t pending_count = 0;
+    LogLine history[TELEM_LOG_MAX];
+    size_t history_head = 0;
+    size_t history_count = 0;
+    size_t fresh_count = 0;       // linhas novas do último update_log()
+
+    size_t write_stats(bool full, uint8_t* out, size_t cap) const;
+    size_t write_aps(bool full, uint8_t* out, size_t cap) const;
+    size_t write_log(bool full, uint8_t* out, size_t cap) const;
+};
+
+// --- Publisher (AsyncWebSocket) ---------------------------------------------
+
+// Fontes consultadas no tick, só para canais com assinantes
+struct TelemetrySources {
+    void (*stats)(int32_t* values, uint32_t now_ms);
+    uint8_t (*threat)();
+    size_t (*aps)(ApInfo* out, size_t n, uint32_t now_ms);   // mais forte primeiro
+};
+
+void telemetry_begin(AsyncWebSocket* ws, const TelemetrySources& sources);
+
+// Eventos do AsyncWebSocket, repassados pelo onEvent do servidor. Cliente
+// novo assina TELEM_DEFAULT_MASK até mandar a própria assinatura.
+#define TELEM_DEFAULT_MASK (TELEM_MASK(TELEM_CH_STATS) | TELEM_MASK(TELEM_CH_LOG) | \
+                            TELEM_MASK(TELEM_CH_THREAT))
+#define TELEM_MAX_CLIENTS  8   // DEFAULT_MAX_WS_CLIENTS do AsyncWebSocket
+
+void telemetry_client_connected(uint32_t client_id);
+void telemetry_client_disconnected(uint32_t client_id);
+// Mensagem binária completa (um frame só) recebida do cliente
+void telemetry_client_message(uint32_t client_id, const uint8_t* data, size_t len);
+
+// Qualquer task. A linha sai no próximo tick do canal log.
+void telemetry_log(const char* line);
+
+// Chamado a cada frame da UI; só trabalha quando algum canal vence.
+void telemetry_tick(uint32_t now_ms);
@@ -0,0 +1,72 @@
+#include "web/web_assets.h"
+
+#include <string.h>
+#include <ESPAsyncWebServer.h>
+
+static const char* HDR_IF_NONE_MATCH = "If-None-Match";
+
+const WebAsset* web_asset_find(const char* path) {
+    if (!path) return nullptr;
+    for (size_t i = 0; i < WEB_ASSETS_COUNT; ++i) {
+        if (strcmp(WEB_ASSETS[i].path, path) == 0) {
+            return &WEB_ASSETS[i];
+        }
+    }
+    return nullptr;
+}
+
+bool web_asset_etag_matches(const WebAsset& asset, const char* if_none_match) {
+    if (!if_none_match || !*if_none_match) return false;
+
+    const size_t etag_len = strlen(asset.etag);
+    const char* p = if_none_match;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') ++p;
+        if (!*p) break;
+
+        // If-None-Match usa comparação fraca: W/"x" casa com "x"
+        if (p[0] == 'W' && p[1] == '/') p += 2;
+
+        const char* end = p;
+        while (*end && *end != ',') ++end;
+        size_t len = end - p;
+        while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t')) --len;
+
+        if (len == 1 && p[0] == '*') return true;
+        if (len == etag_len && memcmp(p, asset.etag, len) == 0) return true;
+        p = end;
+    }
+    return false;
+}
+
+void web_assets_serve(AsyncWebServerRequest* request, const WebAsset& asset) {
+    AsyncWebServerResponse* response;
+
+    const AsyncWebHeader* inm = request->getHeader(HDR_IF_NONE_MATCH);
+    if (inm && web_asset_etag_matches(asset, inm->value().c_str())) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse_P(200, asset.mime, asset.data, asset.len);
+        // Todo navegador aceita gzip; não há cópia descomprimida na flash
+        if (asset.gzip) {
+            response->addHeader("Content-Encoding", "gzip");
+        }
+    }
+
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+void web_assets_register(AsyncWebServer& server, const char* skip_prefix) {
+    size_t skip_len = skip_prefix ? strlen(skip_prefix) : 0;
+    for (size_t i = 0; i < WEB_ASSETS_COUNT; ++i) {
+        const WebAsset* asset = &WEB_ASSETS[i];
+        if (skip_len && strncmp(asset->path, skip_prefix, skip_len) == 0) {
+            continue;
+        }
+        server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest* request) {
+            web_assets_serve(request, *asset);
+        });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+
+// Assets do dashboard embutidos já comprimidos com gzip.
+//
+// O manifesto WEB_ASSETS é gerado em build por tools/web/embed_assets.py
+// (extra_script do PlatformIO) em src/web/web_assets_data.cpp, a partir de
+// `custom_web_assets` no platformio.ini. Blobs e manifesto são constexpr e
+// ficam na flash: servir um asset não copia nada para a RAM.
+//
+// Cada resposta leva um ETag forte (hash do conteúdo original) e
+// "Cache-Control: no-cache": o navegador revalida com If-None-Match e
+// recebe 304 sem corpo enquanto o firmware não mudar o arquivo.
+
+struct WebAsset {
+    const char* path;      // caminho HTTP, ex. "/index.html"
+    const char* mime;
+    const uint8_t* data;   // corpo como vai para o cliente
+    uint32_t len;
+    uint32_t raw_len;      // tamanho descomprimido (só informativo)
+    const char* etag;      // com aspas, ex. "\"3f2a...\""
+    bool gzip;             // false quando o gzip não compensa (ex. favicon)
+};
+
+extern const WebAsset WEB_ASSETS[];
+extern const size_t WEB_ASSETS_COUNT;
+
+// nullptr se o caminho não estiver no manifesto
+const WebAsset* web_asset_find(const char* path);
+
+// If-None-Match: lista de ETags separados por vírgula, "*" ou W/"..."
+bool web_asset_etag_matches(const WebAsset& asset, const char* if_none_match);
+
+// Responde 304 se o ETag bate, senão 200 com o blob direto da flash
+void web_assets_serve(AsyncWebServerRequest* request, const WebAsset& asset);
+
+// Registra uma rota GET para cada asset do manifesto, exceto os que começam
+// com `skip_prefix` (ex. "/ota/", servidos com autenticação)
+void web_assets_register(AsyncWebServer& server, const char* skip_prefix);
@@ -0,0 +1,272 @@
+#include "web/web_io.h"
+
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "storage.h"
+
+// Core 0 com prioridade mínima: a captura (3) e o AsyncTCP passam na frente;
+// a UI (loop do Arduino) fica sozinha no core 1. Stack folgada para o TLS
+// do Gemini (WiFiClientSecure).
+static const BaseType_t WEB_IO_TASK_CORE = 0;
+static const UBaseType_t WEB_IO_TASK_PRIO = 1;
+static const uint32_t WEB_IO_TASK_STACK = 8192;
+static const UBaseType_t WEB_IO_QUEUE_LEN = 8;
+
+// Downloads: 4 blocos de 4 KB adiantados por resposta (16 KB, PSRAM se
+// houver). Um bloco é o que o AsyncTCP costuma pedir por ACK; com quatro, a
+// task sd lê o próximo enquanto os anteriores estão em trânsito. Com o anel
+// vazio o filler espera o próximo bloco por até WEB_IO_STREAM_WAIT_MS antes
+// de devolver RESPONSE_TRY_AGAIN: sem nada em trânsito, o AsyncTCP só tenta
+// de novo no próximo poll (~500 ms), o que derrubaria a vazão.
+static const size_t WEB_IO_STREAM_BLOCK = 4096;
+static const uint32_t WEB_IO_STREAM_BLOCKS = 4;
+static const uint32_t WEB_IO_STREAM_WAIT_MS = 20;
+static const int WEB_IO_MAX_STREAMS = 2;
+
+struct DeferredResult {
+    std::atomic<bool> done{false};
+    String body;
+};
+
+static std::atomic<int> active_streams{0};
+
+// Anel de blocos de um download: a task sd produz, a do AsyncTCP consome.
+// Os contadores só crescem; bloco i fica em ring[i % WEB_IO_STREAM_BLOCKS].
+struct WebIoStream {
+    WebIoSource* source = nullptr;
+    uint8_t* ring = nullptr;
+    size_t len[WEB_IO_STREAM_BLOCKS] = {};
+    std::atomic<uint32_t> produced{0};
+    std::atomic<uint32_t> consumed{0};
+    std::atomic<bool> eof{false};
+    std::atomic<bool> refill_queued{false};
+    SemaphoreHandle_t ready = nullptr;   // dado novo ou fim (sd -> AsyncTCP)
+    size_t offset = 0;   // dentro do bloco `consumed` (só AsyncTCP)
+
+    ~WebIoStream() {
+        // O arquivo é fechado pela task sd
+        if (storage_on_worker() ||
+            !storage_submit(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, delete_source, source)) {
+            delete source;
+        }
+        heap_caps_free(ring);
+        if (ready) vSemaphoreDelete(ready);
+        active_streams.fetch_sub(1);
+    }
+
+    static void delete_source(void* arg) {
+        delete static_cast<WebIoSource*>(arg);
+    }
+};
+
+// Item da fila (copiado byte a byte pelo FreeRTOS, por isso só ponteiros)
+struct WebIoItem {
+    WebIoJobFn job;
+    WebIoQueryFn query;
+    String* arg;
+    std::shared_ptr<DeferredResult>* result;
+};
+
+static QueueHandle_t io_queue = nullptr;
+static TaskHandle_t io_task_handle = nullptr;
+
+// Job da task sd: um bloco do download por vez. Com espaço no anel, o job
+// volta para o fim da fila BULK, então a captura passa entre dois blocos.
+static void stream_fill_job(void* arg) {
+    std::shared_ptr<WebIoStream>* ref = static_cast<std::shared_ptr<WebIoStream>*>(arg);
+    WebIoStream& s = **ref;
+
+    uint32_t produced = s.produced.load(std::memory_order_relaxed);
+    if (!s.eof.load(std::memory_order_relaxed) &&
+        produced - s.consumed.load(std::memory_order_acquire) < WEB_IO_STREAM_BLOCKS) {
+        uint32_t slot = produced % WEB_IO_STREAM_BLOCKS;
+        size_t n = s.source->read(s.ring + slot * WEB_IO_STREAM_BLOCK, WEB_IO_STREAM_BLOCK);
+        if (n == 0) {
+            s.eof.store(true, std::memory_order_release);
+        } else {
+            s.len[slot] = n;
+            s.produced.store(++produced, std::memory_order_release);
+        }
+        xSemaphoreGive(s.ready);
+    }
+
+    if (!s.eof.load(std::memory_order_relaxed) &&
+        produced - s.consumed.load(std::memory_order_acquire) < WEB_IO_STREAM_BLOCKS &&
+        storage_submit(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, stream_fill_job, ref)) {
+        return;
+    }
+    s.refill_queued.store(false, std::memory_order_release);
+    xSemaphoreGive(s.ready);
+    delete ref;
+}
+
+static void web_io_task(void*) {
+    WebIoItem item;
+    for (;;) {
+        if (xQueueReceive(io_queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (item.job) {
+            item.job(*item.arg);
+        } else if (item.query) {
+            (*item.result)->body = item.query(*item.arg);
+            (*item.result)->done.store(true, std::memory_order_release);
+        }
+        delete item.arg;
+        delete item.result;
+    }
+}
+
+bool web_io_start() {
+    if (io_task_handle) return true;
+
+    io_queue = xQueueCreate(WEB_IO_QUEUE_LEN, sizeof(WebIoItem));
+    if (!io_queue) {
+        Serial.println("[WEB] Falha ao criar fila da task web_io");
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(web_io_task,
+                                "web_io",
+                                WEB_IO_TASK_STACK,
+                                nullptr,
+                                WEB_IO_TASK_PRIO,
+                                &io_task_handle,
+                                WEB_IO_TASK_CORE) != pdPASS) {
+        io_task_handle = nullptr;
+        Serial.println("[WEB] Falha ao criar task web_io");
+        return false;
+    }
+    return true;
+}
+
+static bool enqueue(WebIoItem& item) {
+    if (io_queue && xQueueSend(io_queue, &item, 0) == pdTRUE) {
+        return true;
+    }
+    delete item.arg;
+    delete item.result;
+    return false;
+}
+
+bool web_io_post(WebIoJobFn fn, const String& payload) {
+    WebIoItem item = {fn, nullptr, new String(payload), nullptr};
+    return enqueue(item);
+}
+
+bool web_io_defer(AsyncWebServerRequest* request,
+                  const char* content_type,
+                  WebIoQueryFn fn,
+                  const String& arg) {
+    std::shared_ptr<DeferredResult> result = std::make_shared<DeferredResult>();
+
+    WebIoItem item = {nullptr, fn, new String(arg), new std::shared_ptr<DeferredResult>(result)};
+    if (!enqueue(item)) {
+        return false;
+    }
+
+    // `index` é quanto do corpo já foi enviado
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        content_type,
+        [result](uint8_t* buffer, size_t max_len, size_t index) -> size_t {
+            if (!result->done.load(std::memory_order_acquire)) {
+                return RESPONSE_TRY_AGAIN;
+            }
+            size_t len = result->body.length();
+            if (index >= len) {
+                return 0;
+            }
+            size_t n = len - index < max_len ? len - index : max_len;
+            memcpy(buffer, result->body.c_str() + index, n);
+            return n;
+        });
+    request->send(response);
+    return true;
+}
+
+// Pede à task sd que complete o anel, se há bloco livre e nenhum pedido na
+// fila. Fila cheia não é erro: o próximo filler tenta de novo.
+static bool stream_request_fill(const std::shared_ptr<WebIoStream>& s) {
+    if (s->eof.load(std::memory_order_acquire) ||
+        s->produced.load(std::memory_order_acquire) - s->consumed.load(std::memory_order_relaxed) >=
+            WEB_IO_STREAM_BLOCKS ||
+        s->refill_queued.exchange(true, std::memory_order_acq_rel)) {
+        return true;
+    }
+    std::shared_ptr<WebIoStream>* ref = new std::shared_ptr<WebIoStream>(s);
+    if (!storage_submit(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, stream_fill_job, ref)) {
+        delete ref;
+        s->refill_queued.store(false, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+AsyncWebServerResponse* web_io_stream(AsyncWebServerRequest* request,
+                                      const char* content_type,
+                                      size_t length,
+                                      WebIoSource* source) {
+    if (active_streams.fetch_add(1) >= WEB_IO_MAX_STREAMS) {
+        active_streams.fetch_sub(1);
+        delete source;
+        return nullptr;
+    }
+
+    std::shared_ptr<WebIoStream> s = std::make_shared<WebIoStream>();
+    s->source = source;
+    const size_t ring_bytes = WEB_IO_STREAM_BLOCK * WEB_IO_STREAM_BLOCKS;
+    s->ring = (uint8_t*)heap_caps_malloc(ring_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s->ring) {
+        s->ring = (uint8_t*)heap_caps_malloc(ring_bytes, MALLOC_CAP_8BIT);
+    }
+    s->ready = xSemaphoreCreateBinary();
+    if (!s->ring || !s->ready || !stream_request_fill(s)) {
+        return nullptr;
+    }
+
+    // Só cópia de memória na task do AsyncTCP (mais a espera curta acima)
+    AwsResponseFiller filler = [s](uint8_t* buffer, size_t max_len, size_t) -> size_t {
+        size_t out = 0;
+        bool waited = false;
+        while (out < max_len) {
+            uint32_t c = s->consumed.load(std::memory_order_relaxed);
+            if (c == s->produced.load(std::memory_order_acquire)) {
+                if (out > 0 || waited || s->eof.load(std::memory_order_acquire)) break;
+                stream_request_fill(s);
+                xSemaphoreTake(s->ready, pdMS_TO_TICKS(WEB_IO_STREAM_WAIT_MS));
+                waited = true;
+                continue;
+            }
+
+            uint32_t slot = c % WEB_IO_STREAM_BLOCKS;
+            size_t n = s->len[slot] - s->offset;
+            if (n > max_len - out) n = max_len - out;
+            memcpy(buffer + out, s->ring + slot * WEB_IO_STREAM_BLOCK + s->offset, n);
+            out += n;
+            s->offset += n;
+            if (s->offset == s->len[slot]) {
+                s->offset = 0;
+                s->consumed.store(c + 1, std::memory_order_release);
+            }
+        }
+        stream_request_fill(s);
+
+        if (out > 0) return out;
+        if (s->eof.load(std::memory_order_acquire) &&
+            s->consumed.load(std::memory_order_relaxed) == s->produced.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        return RESPONSE_TRY_AGAIN;
+    };
+
+    if (length > 0) {
+        return request->beginResponse(content_type, length, filler);
+    }
+    return request->beginChunkedResponse(content_type, filler);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+
+// Task "web_io": executa o que pode demorar (HTTPS, consultas que esperam
+// o SD) fora da task do AsyncTCP. Todos os handlers do AsyncWebServer rodam
+// nela e uma chamada bloqueante ali congela todas as conexões do dashboard;
+// na UI, congela o LVGL. A fila é FIFO. O SD em si é da task "sd"
+// (storage.h): jobs e consultas que tocam o cartão passam por ela.
+
+// Trabalho sem resposta (ex. gravar a config no SD). `payload` é uma cópia
+// feita no momento do post.
+typedef void (*WebIoJobFn)(const String& payload);
+
+// Consulta com resposta: o retorno vira o corpo da resposta HTTP 200.
+typedef String (*WebIoQueryFn)(const String& arg);
+
+bool web_io_start();
+
+// false se a fila estiver cheia (o handler deve responder 503)
+bool web_io_post(WebIoJobFn fn, const String& payload);
+
+// Responde `request` com 200 + fn(arg), calculado na task web_io. A resposta
+// é chunked e fica em RESPONSE_TRY_AGAIN até o resultado ficar pronto; se o
+// cliente desconectar antes, o resultado é descartado. false se a fila
+// estiver cheia (nada foi enviado).
+bool web_io_defer(AsyncWebServerRequest* request,
+                  const char* content_type,
+                  WebIoQueryFn fn,
+                  const String& arg);
+
+// Corpo de resposta lido do SD (downloads). read() roda na task "sd", um
+// bloco por job na fila BULK (atrás da captura e dos logs). O destrutor
+// também, salvo com a fila cheia: ele só deve fechar arquivos.
+class WebIoSource {
+public:
+    virtual ~WebIoSource() {}
+
+    // Até `cap` bytes em `buf`. 0 = fim (ou erro de leitura).
+    virtual size_t read(uint8_t* buf, size_t cap) = 0;
+};
+
+// Resposta com o corpo de `source`, lido adiantado pela task sd num anel de
+// blocos de tamanho fixo: a RAM por download não depende do tamanho do
+// arquivo e a task do AsyncTCP só copia memória. `length` > 0 vira o
+// Content-Length; 0 = chunked até read() devolver 0.
+//
+// O chamador ajusta código e cabeçalhos e chama request->send(). nullptr se
+// já há downloads demais em andamento ou a fila está cheia (responder 503);
+// `source` é destruído nesse caso.
+AsyncWebServerResponse* web_io_stream(AsyncWebServerRequest* request,
+                                      const char* content_type,
+                                      size_t length,
+                                      WebIoSource* source);
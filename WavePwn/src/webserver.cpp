@@ -2,63 +2,71 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
-#include <WebSocketsServer.h>
-#include <Update.h>
-#include <SD.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "freertos/semphr.h"
 
-#include "utils/ota_secure.h"
+#include "utils/config_store.h"
+#include "utils/event_log.h"
+#include "utils/sd_bench.h"
+#include "web/web_assets.h"
+#include "web/captures.h"
+#include "web/ota_http.h"
+#include "web/web_io.h"
+#include "web/telemetry.h"
 
 #include "pwnagotchi.h"
-#include "ai/neura9_inference.h"
+#include "storage.h"
+#include "capture/ap_table.h"
+#include "neura9/inference.h"
 #include "lab_simulations/simulation_manager.h"
 #include "lab_simulations/gemini_api.h"
 
 extern bool lab_mode;
 
-// Arquivos embutidos no firmware (PlatformIO board_build.embed_files)
-extern const uint8_t data_web_index_html_start[] asm("_binary_data_web_index_html_start");
-extern const uint8_t data_web_index_html_end[]   asm("_binary_data_web_index_html_end");
-
-extern const uint8_t data_web_style_css_start[]  asm("_binary_data_web_style_css_start");
-extern const uint8_t data_web_style_css_end[]    asm("_binary_data_web_style_css_end");
-
-extern const uint8_t data_web_chart_min_js_start[] asm("_binary_data_web_chart_min_js_start");
-extern const uint8_t data_web_chart_min_js_end[]   asm("_binary_data_web_chart_min_js_end");
-
-extern const uint8_t data_web_favicon_ico_start[] asm("_binary_data_web_favicon_ico_start");
-extern const uint8_t data_web_favicon_ico_end[]   asm("_binary_data_web_favicon_ico_end");
-
-extern const uint8_t data_web_config_html_start[] asm("_binary_data_web_config_html_start");
-extern const uint8_t data_web_config_html_end[]   asm("_binary_data_web_config_html_end");
-
-extern const uint8_t data_web_config_js_start[] asm("_binary_data_web_config_js_start");
-extern const uint8_t data_web_config_js_end[]   asm("_binary_data_web_config_js_end");
-
-extern const uint8_t ota_update_html_start[]  asm("_binary_ota_update_html_start");
-extern const uint8_t ota_update_html_end[]    asm("_binary_ota_update_html_end");
-
 extern Pwnagotchi pwn;
 
-// Servidor HTTP + WebSocket
-static WebServer http_server(80);
-static WebSocketsServer ws_server(81);
+// Servidor HTTP + WebSocket assíncronos: os handlers rodam na task do
+// AsyncTCP (core 0, ver CONFIG_ASYNC_TCP_RUNNING_CORE no platformio.ini),
+// nunca no loop da UI. O que toca o SD vai para a task sd (storage.h); o que
+// espera a rede, para a task web_io.
+static AsyncWebServer http_server(80);
+static AsyncWebSocket ws_server("/ws");
 
-// OTA básico com HTTP Basic Auth
+// OTA (web/ota_http) e a página dele com HTTP Basic Auth
 static const char* OTA_USER = "admin";
 static const char* OTA_PASS = "wavepwn";
 
-static String last_log_line;
+// Corpo máximo aceito nos POSTs JSON da API
+static const size_t WEB_MAX_BODY = 4096;
+
+// Limpeza dos clientes WebSocket desconectados (webserver_send_stats roda a
+// cada frame da UI)
+static const uint32_t WEB_WS_CLEANUP_MS = 1000;
+
+// /config vem do ConfigStore (RAM). Aqui só o arquivo-guarda do lab,
+// relido pela web_io; protegido por state_mutex (AsyncTCP, web_io e UI).
+static SemaphoreHandle_t state_mutex = nullptr;
+static bool lab_guard_file = false;
 
 // -----------------------------------------------------------------------------
 // Helpers
 // -----------------------------------------------------------------------------
 
+struct StateLock {
+    StateLock() {
+        if (state_mutex) xSemaphoreTake(state_mutex, portMAX_DELAY);
+    }
+    ~StateLock() {
+        if (state_mutex) xSemaphoreGive(state_mutex);
+    }
+};
+
 static void log_line(const String& line) {
-    last_log_line = line;
+    telemetry_log(line.c_str());
+    event_log_append(EVENT_SRC_WEB, line.c_str());
 
     if (lab_mode) {
         // Modo laboratorio: aplica uma ofuscacao simples nos logs enviados
@@ -73,11 +81,39 @@ static void log_line(const String& line) {
     }
 }
 
-static void serve_embedded(const uint8_t* start,
-                           const uint8_t* end,
-                           const char* contentType) {
-    size_t len = end - start;
-    http_server.send_P(200, contentType, (PGM_P)start, len);
+static void serve_asset(AsyncWebServerRequest* request, const char* path) {
+    const WebAsset* asset = web_asset_find(path);
+    if (!asset) {
+        request->send(404, "text/plain", "Not found");
+        return;
+    }
+    web_assets_serve(request, *asset);
+}
+
+// O corpo dos POSTs chega em pedaços no onBody; junta em _tempObject, que o
+// próprio AsyncWebServerRequest libera no fim.
+static void collect_body(AsyncWebServerRequest* request,
+                         uint8_t* data,
+                         size_t len,
+                         size_t index,
+                         size_t total) {
+    if (total > WEB_MAX_BODY) {
+        return;
+    }
+    if (index == 0 && !request->_tempObject) {
+        request->_tempObject = calloc(1, total + 1);
+    }
+    char* buf = (char*)request->_tempObject;
+    if (buf && index + len <= total) {
+        memcpy(buf + index, data, len);
+    }
+}
+
+static String request_body(AsyncWebServerRequest* request) {
+    if (!request->_tempObject) {
+        return String();
+    }
+    return String((const char*)request->_tempObject);
 }
 
 static String format_uptime(uint32_t seconds) {
@@ -92,102 +128,58 @@ static String format_uptime(uint32_t seconds) {
     return String(buf);
 }
 
-static bool ensure_config_dir() {
-    if (SD.exists("/config")) {
-        return true;
-    }
-    return SD.mkdir("/config");
-}
-
 // -----------------------------------------------------------------------------
-// HTTP handlers
+// Acesso ao SD (task sd) e à rede (task web_io)
 // -----------------------------------------------------------------------------
 
-static void handle_root() {
-    serve_embedded(data_web_index_html_start, data_web_index_html_end, "text/html");
-}
-
-static void handle_config_page() {
-    serve_embedded(data_web_config_html_start, data_web_config_html_end, "text/html");
-}
-
-static void handle_config_js() {
-    serve_embedded(data_web_config_js_start, data_web_config_js_end, "application/javascript");
+// O arquivo-guarda pode ser criado com o cartão no PC: o status relê em
+// segundo plano e a próxima consulta já vê o valor novo
+static void refresh_lab_guard(void*) {
+    bool guard = SDCARD.exists("/sd/.enable_lab_attacks");
+    StateLock lock;
+    lab_guard_file = guard;
 }
 
-static void handle_index() {
-    handle_root();
-}
+static String gemini_ask_json(const String& prompt) {
+    String answer = GeminiAPI::ask(prompt);
 
-static void handle_style() {
-    serve_embedded(data_web_style_css_start, data_web_style_css_end, "text/css");
+    DynamicJsonDocument doc(1024);
+    doc["response"] = answer;
+    String out;
+    serializeJson(doc, out);
+    return out;
 }
 
-static void handle_chart() {
-    serve_embedded(data_web_chart_min_js_start, data_web_chart_min_js_end, "application/javascript");
-}
+// -----------------------------------------------------------------------------
+// HTTP handlers
+// -----------------------------------------------------------------------------
 
-static void handle_favicon() {
-    serve_embedded(data_web_favicon_ico_start, data_web_favicon_ico_end, "image/x-icon");
+static void handle_root(AsyncWebServerRequest* request) {
+    serve_asset(request, "/index.html");
 }
 
 // --------------------------
 // Config REST helpers
 // --------------------------
 
-static void handle_api_config_device_get() {
-    DynamicJsonDocument doc(512);
-
-    File f = SD.open("/config/device_config.json");
-    if (f) {
-        DeserializationError err = deserializeJson(doc, f);
-        f.close();
-        if (err) {
-            doc.clear();
-        }
-    }
-
-    if (!doc.containsKey("device_name"))        doc["device_name"]        = "CyberGuard Pro";
-    if (!doc.containsKey("assistant"))          doc["assistant"]          = "none";
-    if (!doc.containsKey("language"))           doc["language"]           = "pt-BR";
-    if (!doc.containsKey("theme"))              doc["theme"]              = "dark";
-    if (!doc.containsKey("owner"))              doc["owner"]              = "";
-    if (!doc.containsKey("enable_voice_alerts")) doc["enable_voice_alerts"] = true;
-    if (!doc.containsKey("neura9_sensitivity")) doc["neura9_sensitivity"] = 0.78f;
-
-    String out;
-    serializeJson(doc, out);
-    http_server.send(200, "application/json", out);
+// JSON já normalizado (com os padrões) pelo ConfigStore: só uma cópia
+static void handle_api_config_device_get(AsyncWebServerRequest* request) {
+    request->send(200, "application/json", config_store.device_json());
 }
 
-static void handle_api_config_device_post() {
-    String body = http_server.arg("plain");
+static void handle_api_config_device_post(AsyncWebServerRequest* request) {
+    String body = request_body(request);
     if (body.isEmpty()) {
-        http_server.send(400, "application/json", "{\"error\":\"empty body\"}");
+        request->send(400, "application/json", "{\"error\":\"empty body\"}");
         return;
     }
 
-    DynamicJsonDocument doc(1024);
-    DeserializationError err = deserializeJson(doc, body);
-    if (err) {
-        http_server.send(400, "application/json", "{\"error\":\"invalid json\"}");
-        return;
-    }
-
-    if (!ensure_config_dir()) {
-        http_server.send(500, "application/json", "{\"error\":\"config dir\"}");
+    // Gravação no SD agrupada pela task do ConfigStore
+    if (!config_store.set_device_json(body)) {
+        request->send(400, "application/json", "{\"error\":\"invalid json\"}");
         return;
     }
-
-    File f = SD.open("/config/device_config.json", FILE_WRITE);
-    if (!f) {
-        http_server.send(500, "application/json", "{\"error\":\"open config\"}");
-        return;
-    }
-
-    serializeJson(doc, f);
-    f.close();
-    http_server.send(200, "application/json", "{\"ok\":true}");
+    request->send(200, "application/json", "{\"ok\":true}");
 }
 
 // --------------------------
@@ -195,39 +187,65 @@ static void handle_api_config_device_post() {
 // --------------------------
 
 static bool load_lab_pin(String &pin_out) {
-    File f = SD.open("/config/lab_config.json");
-    if (!f) {
-        return false;
-    }
+    pin_out = config_store.lab_pin();
+    return pin_out.length() > 0;
+}
 
-    DynamicJsonDocument doc(256);
-    DeserializationError err = deserializeJson(doc, f);
-    f.close();
-    if (err) {
-        return false;
+// Top-N APs ativos por RSSI (?n=, padrão 20, máx. 64)
+static void handle_api_aps(AsyncWebServerRequest* request) {
+    static ApInfo top[64];
+    int n = request->hasParam("n") ? request->getParam("n")->value().toInt() : 20;
+    if (n < 1) n = 1;
+    if (n > 64) n = 64;
+
+    uint32_t now = millis();
+    size_t count = ap_table.top_by_rssi(top, (size_t)n, now - AP_TABLE_ACTIVE_WINDOW_MS);
+
+    static const char* ENC_NAMES[AP_ENC_COUNT] = {"?", "OPEN", "WEP", "WPA", "WPA2", "WPA3"};
+
+    DynamicJsonDocument doc(512 + count * 256);
+    JsonArray arr = doc.createNestedArray("aps");
+    for (size_t i = 0; i < count; ++i) {
+        const ApInfo& ap = top[i];
+        char bssid[18];
+        snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 ap.bssid[0], ap.bssid[1], ap.bssid[2],
+                 ap.bssid[3], ap.bssid[4], ap.bssid[5]);
+
+        JsonObject o = arr.createNestedObject();
+        o["bssid"]   = bssid;
+        o["ssid"]    = ap.ssid;
+        o["ch"]      = ap.channel;
+        o["rssi"]    = ap.rssi();
+        o["enc"]     = ENC_NAMES[ap.encryption < AP_ENC_COUNT ? ap.encryption : 0];
+        o["clients"] = ap.clients;
+        o["hs"]      = (ap.capture_flags & AP_CAPTURE_HANDSHAKE) != 0;
+        o["pmkid"]   = (ap.capture_flags & AP_CAPTURE_PMKID) != 0;
+        o["age"]     = (now - ap.last_seen_ms) / 1000;
     }
 
-    const char* p = doc["lab_pin"];
-    if (!p) {
-        return false;
-    }
+    String out;
+    serializeJson(doc, out);
+    request->send(200, "application/json", out);
+}
 
-    pin_out = String(p);
-    if (pin_out.length() != 6) {
-        return false;
-    }
-    for (size_t i = 0; i < pin_out.length(); ++i) {
-        if (pin_out[i] < '0' || pin_out[i] > '9') {
-            return false;
-        }
-    }
-    return true;
+static void handle_api_storage(AsyncWebServerRequest* request) {
+    request->send(200, "application/json", storage_stats_json());
+}
+
+static void handle_api_neura9(AsyncWebServerRequest* request) {
+    request->send(200, "application/json", neura9_stats_json());
 }
 
-static void handle_api_lab_status() {
-    bool guard = SD.exists("/sd/.enable_lab_attacks");
+static void handle_api_lab_status(AsyncWebServerRequest* request) {
+    bool guard;
+    {
+        StateLock lock;
+        guard = lab_guard_file;
+    }
     String stored_pin;
     bool pin_set = load_lab_pin(stored_pin);
+    storage_submit(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, refresh_lab_guard, nullptr);
 
     DynamicJsonDocument doc(256);
     doc["lab_guard_file"] = guard;
@@ -236,324 +254,372 @@ static void handle_api_lab_status() {
 
     String out;
     serializeJson(doc, out);
-    http_server.send(200, "application/json", out);
+    request->send(200, "application/json", out);
 }
 
-static void handle_api_lab_set_pin() {
-    String body = http_server.arg("plain");
+static void handle_api_lab_set_pin(AsyncWebServerRequest* request) {
+    String body = request_body(request);
     DynamicJsonDocument doc(256);
     DeserializationError err = deserializeJson(doc, body);
     if (err) {
-        http_server.send(400, "application/json", "{\"error\":\"invalid json\"}");
+        request->send(400, "application/json", "{\"error\":\"invalid json\"}");
         return;
     }
 
     const char* pin = doc["pin"];
     if (!pin) {
-        http_server.send(400, "application/json", "{\"error\":\"pin missing\"}");
+        request->send(400, "application/json", "{\"error\":\"pin missing\"}");
         return;
     }
 
     String pin_s(pin);
     pin_s.trim();
     if (pin_s.length() != 6) {
-        http_server.send(400, "application/json", "{\"error\":\"pin length\"}");
+        request->send(400, "application/json", "{\"error\":\"pin length\"}");
         return;
     }
-    for (size_t i = 0; i < pin_s.length(); ++i) {
-        if (pin_s[i] < '0' || pin_s[i] > '9') {
-            http_server.send(400, "application/json", "{\"error\":\"pin digits\"}");
-            return;
-        }
-    }
-
-    if (!ensure_config_dir()) {
-        http_server.send(500, "application/json", "{\"error\":\"config dir\"}");
-        return;
-    }
-
-    DynamicJsonDocument outDoc(128);
-    outDoc["lab_pin"] = pin_s;
-
-    File f = SD.open("/config/lab_config.json", FILE_WRITE);
-    if (!f) {
-        http_server.send(500, "application/json", "{\"error\":\"open lab_config\"}");
+    if (!config_store.set_lab_pin(pin_s)) {
+        request->send(400, "application/json", "{\"error\":\"pin digits\"}");
         return;
     }
-    serializeJson(outDoc, f);
-    f.close();
 
     // Sempre que o PIN é alterado, o modo lab volta a ficar bloqueado.
     SimulationManager::set_lab_unlocked(false);
 
-    http_server.send(200, "application/json", "{\"ok\":true}");
+    request->send(200, "application/json", "{\"ok\":true}");
 }
 
-static void handle_api_lab_unlock() {
-    String body = http_server.arg("plain");
+static void handle_api_lab_unlock(AsyncWebServerRequest* request) {
+    String body = request_body(request);
     DynamicJsonDocument doc(256);
     DeserializationError err = deserializeJson(doc, body);
     if (err) {
-        http_server.send(400, "application/json", "{\"ok\":false,\"error\":\"invalid json\"}");
+        request->send(400, "application/json", "{\"ok\":false,\"error\":\"invalid json\"}");
         return;
     }
 
     const char* pin = doc["pin"];
     if (!pin) {
-        http_server.send(400, "application/json", "{\"ok\":false,\"error\":\"pin missing\"}");
+        request->send(400, "application/json", "{\"ok\":false,\"error\":\"pin missing\"}");
         return;
     }
 
     String stored;
     if (!load_lab_pin(stored)) {
-        http_server.send(400, "application/json", "{\"ok\":false,\"error\":\"pin not set\"}");
+        request->send(400, "application/json", "{\"ok\":false,\"error\":\"pin not set\"}");
         return;
     }
 
     if (stored != String(pin)) {
-        http_server.send(403, "application/json", "{\"ok\":false,\"error\":\"pin mismatch\"}");
+        request->send(403, "application/json", "{\"ok\":false,\"error\":\"pin mismatch\"}");
         return;
     }
 
     SimulationManager::set_lab_unlocked(true);
 
-    http_server.send(200, "application/json", "{\"ok\":true}");
+    request->send(200, "application/json", "{\"ok\":true}");
 }
 
 // --------------------------
 // Gemini REST helpers
 // --------------------------
 
-static void handle_api_gemini_key() {
-    String body = http_server.arg("plain");
+static void handle_api_gemini_key(AsyncWebServerRequest* request) {
+    String body = request_body(request);
     DynamicJsonDocument doc(256);
     DeserializationError err = deserializeJson(doc, body);
     if (err) {
-        http_server.send(400, "application/json", "{\"error\":\"invalid json\"}");
+        request->send(400, "application/json", "{\"error\":\"invalid json\"}");
         return;
     }
 
     const char* key = doc["key"];
     if (!key || !key[0]) {
-        http_server.send(400, "application/json", "{\"error\":\"key missing\"}");
-        return;
-    }
-
-    if (!ensure_config_dir()) {
-        http_server.send(500, "application/json", "{\"error\":\"config dir\"}");
+        request->send(400, "application/json", "{\"error\":\"key missing\"}");
         return;
     }
 
-    File f = SD.open("/config/gemini_key.txt", FILE_WRITE);
-    if (!f) {
-        http_server.send(500, "application/json", "{\"error\":\"open gemini_key\"}");
+    if (!config_store.set_gemini_key(String(key))) {
+        request->send(400, "application/json", "{\"error\":\"invalid key\"}");
         return;
     }
-    f.println(key);
-    f.close();
 
-    http_server.send(200, "application/json", "{\"ok\":true}");
+    request->send(200, "application/json", "{\"ok\":true}");
 }
 
-static void handle_api_gemini_ask() {
-    String body = http_server.arg("plain");
+static void handle_api_gemini_ask(AsyncWebServerRequest* request) {
+    String body = request_body(request);
     DynamicJsonDocument doc(512);
     DeserializationError err = deserializeJson(doc, body);
     if (err) {
-        http_server.send(400, "application/json", "{\"error\":\"invalid json\"}");
+        request->send(400, "application/json", "{\"error\":\"invalid json\"}");
         return;
     }
 
     const char* prompt = doc["prompt"];
     if (!prompt || !prompt[0]) {
-        http_server.send(400, "application/json", "{\"error\":\"prompt missing\"}");
+        request->send(400, "application/json", "{\"error\":\"prompt missing\"}");
         return;
     }
 
-    String answer = GeminiAPI::ask(String(prompt));
-
-    DynamicJsonDocument outDoc(1024);
-    outDoc["response"] = answer;
-    String out;
-    serializeJson(outDoc, out);
-    http_server.send(200, "application/json", out);
+    // HTTPS para o Gemini leva segundos: resposta adiada, calculada na web_io
+    if (!web_io_defer(request, "application/json", gemini_ask_json, String(prompt))) {
+        request->send(503, "application/json", "{\"error\":\"busy\"}");
+    }
 }
 
-static bool ensure_ota_auth() {
-    if (!http_server.authenticate(OTA_USER, OTA_PASS)) {
-        http_server.requestAuthentication();
+static bool ensure_ota_auth(AsyncWebServerRequest* request) {
+    if (!request->authenticate(OTA_USER, OTA_PASS)) {
+        request->requestAuthentication();
         return false;
     }
     return true;
 }
 
-static void handle_ota_page() {
-    if (!ensure_ota_auth()) return;
-    serve_embedded(ota_update_html_start, ota_update_html_end, "text/html");
+static void handle_ota_page(AsyncWebServerRequest* request) {
+    if (!ensure_ota_auth(request)) return;
+    serve_asset(request, "/ota/update.html");
 }
 
-static void handle_ota_upload() {
-    if (!ensure_ota_auth()) return;
+// Benchmark do cartão: um job da task sd que fica com o cartão por alguns
+// segundos (a captura espera). Uma execução por vez: a web_io é uma só.
+struct StorageBenchJob {
+    SdBenchReport report;
+    StorageCardInfo card;
+};
+
+static void run_storage_bench(void* arg) {
+    StorageBenchJob* job = (StorageBenchJob*)arg;
+    SdBenchConfig config;
+    sd_bench_run(STORAGE_MOUNT_POINT "/sd/wavepwn", config, &job->report);
+    storage_card_info(&job->card);
+}
 
-    HTTPUpload& upload = http_server.upload();
-    if (upload.status == UPLOAD_FILE_START) {
-        log_line("[OTA] Iniciando update: " + String(upload.filename.c_str()));
-        if (!ota_begin_secure(UPDATE_SIZE_UNKNOWN)) {
-            log_line("[OTA] Falha ao iniciar buffer OTA seguro");
-        }
-    } else if (upload.status == UPLOAD_FILE_WRITE) {
-        if (!ota_write_chunk(upload.buf, upload.currentSize)) {
-            log_line("[OTA] Erro ao escrever chunk OTA");
-        }
-    } else if (upload.status == UPLOAD_FILE_END) {
-        if (ota_finalize(true)) {
-            log_line("[OTA] Update concluído com sucesso, reiniciando...");
-        } else {
-            log_line("[OTA] Falha ao finalizar OTA");
-        }
+static String storage_bench_json(const String&) {
+    static StorageBenchJob job;
+    storage_call(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, run_storage_bench, &job);
+
+    String out = sd_bench_json(job.report);
+    char buf[192];
+    snprintf(buf, sizeof(buf),
+             ",\"card\":{\"mounted\":%s,\"name\":\"%s\",\"bus_width\":%u,\"freq_khz\":%lu,"
+             "\"cluster_bytes\":%lu,\"total_bytes\":%llu,\"free_bytes\":%llu}}",
+             job.card.mounted ? "true" : "false", job.card.name, job.card.bus_width,
+             (unsigned long)job.card.freq_khz, (unsigned long)job.card.cluster_bytes,
+             (unsigned long long)job.card.total_bytes, (unsigned long long)job.card.free_bytes);
+    out.remove(out.length() - 1);
+    out += buf;
+    return out;
+}
+
+static void handle_api_storage_bench(AsyncWebServerRequest* request) {
+    if (!ensure_ota_auth(request)) return;
+    if (!web_io_defer(request, "application/json", storage_bench_json, String())) {
+        request->send(503, "application/json", "{\"error\":\"busy\"}");
     }
 }
 
-static void handle_ota_result() {
-    if (!ensure_ota_auth()) return;
-    if (Update.hasError()) {
-        http_server.send(500, "text/plain", "OTA FAILED");
-    } else {
-        http_server.send(200, "text/plain", "OTA OK, rebooting...");
+// Página do anel de eventos. arg = "since,limit"; roda na task web_io
+// porque a leitura espera a task sd
+static String logs_json(const String& arg) {
+    static const size_t LOGS_PAGE_MAX = 32;
+    int comma = arg.indexOf(',');
+    uint32_t since = (uint32_t)strtoul(arg.c_str(), nullptr, 10);
+    size_t limit = (size_t)arg.substring(comma + 1).toInt();
+    if (limit < 1) limit = 1;
+    if (limit > LOGS_PAGE_MAX) limit = LOGS_PAGE_MAX;
+
+    EventRecord* recs = new EventRecord[limit];
+    uint32_t next = since;
+    size_t count = event_log_read(since, recs, limit, &next);
+    EventLogStats stats;
+    event_log_get_stats(&stats);
+
+    DynamicJsonDocument doc(256 + count * (EVENT_LOG_TEXT_MAX + 96));
+    doc["first"]   = stats.first_seq;
+    doc["next"]    = next;
+    doc["dropped"] = stats.dropped;
+    JsonArray lines = doc.createNestedArray("lines");
+    for (size_t i = 0; i < count; ++i) {
+        JsonObject o = lines.createNestedObject();
+        o["seq"]   = recs[i].seq;
+        o["t"]     = recs[i].time;
+        o["epoch"] = (recs[i].flags & EVENT_FLAG_EPOCH) != 0;
+        o["src"]   = event_source_name(recs[i].source);
+        o["text"]  = (const char*)recs[i].text;   // ponteiro: recs vive até o serialize
     }
-    vTaskDelay(pdMS_TO_TICKS(500));
-    ESP.restart();
+
+    String out;
+    serializeJson(doc, out);
+    delete[] recs;
+    return out;
 }
 
-static void handle_reboot() {
-    http_server.send(200, "text/plain", "Rebooting...");
-    vTaskDelay(pdMS_TO_TICKS(200));
-    ESP.restart();
+// Eventos do lab/web a partir de ?since= (padrão: o mais antigo), até
+// ?limit= (padrão e máx. 32). "next" é o since da próxima chamada.
+static void handle_api_logs(AsyncWebServerRequest* request) {
+    String since = request->hasParam("since") ? request->getParam("since")->value() : "0";
+    String limit = request->hasParam("limit") ? request->getParam("limit")->value() : "32";
+    if (!web_io_defer(request, "application/json", logs_json, since + "," + limit)) {
+        request->send(503, "application/json", "{\"error\":\"busy\"}");
+    }
 }
 
-static void handle_not_found() {
-    http_server.send(404, "text/plain", "Not found");
+static void handle_reboot(AsyncWebServerRequest* request) {
+    request->send(200, "text/plain", "Rebooting...");
+    request->onDisconnect([]() {
+        config_store.flush();
+        ESP.restart();
+    });
+}
+
+static void handle_not_found(AsyncWebServerRequest* request) {
+    request->send(404, "text/plain", "Not found");
 }
 
 // -----------------------------------------------------------------------------
 // WebSocket
 // -----------------------------------------------------------------------------
 
-static void on_ws_event(uint8_t num,
-                        WStype_t type,
-                        uint8_t* payload,
-                        size_t length) {
-    (void)payload;
-    (void)length;
+static void on_ws_event(AsyncWebSocket* server,
+                        AsyncWebSocketClient* client,
+                        AwsEventType type,
+                        void* arg,
+                        uint8_t* data,
+                        size_t len) {
+    (void)server;
 
     switch (type) {
-        case WStype_CONNECTED: {
-            IPAddress ip = ws_server.remoteIP(num);
-            String msg = "[WS] Cliente conectado: " + ip.toString();
+        case WS_EVT_CONNECT: {
+            String msg = "[WS] Cliente conectado: " + client->remoteIP().toString();
             log_line(msg);
+            telemetry_client_connected(client->id());
             break;
         }
-        case WStype_DISCONNECTED:
+        case WS_EVT_DISCONNECT:
+            telemetry_client_disconnected(client->id());
             log_line("[WS] Cliente desconectado");
             break;
+        case WS_EVT_DATA: {
+            // Assinatura de canais: mensagem binária curta, num frame só
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            if (info->final && info->index == 0 && info->len == len &&
+                info->opcode == WS_BINARY) {
+                telemetry_client_message(client->id(), data, len);
+            }
+            break;
+        }
         default:
             break;
     }
 }
 
+// Fontes da telemetria, consultadas no tick (loop da UI)
+
+static void telemetry_stats(int32_t* v, uint32_t now_ms) {
+    ApTableSummary aps;
+    ap_table.get_summary(&aps, now_ms);
+
+    v[TELEM_STAT_UPTIME]     = (int32_t)pwn.uptime;
+    v[TELEM_STAT_BATTERY]    = (int32_t)(pwn.battery_percent + 0.5f);
+    v[TELEM_STAT_APS]        = (int32_t)aps.aps_total;
+    v[TELEM_STAT_APS_ACTIVE] = (int32_t)aps.aps_active;
+    v[TELEM_STAT_CLIENTS]    = (int32_t)aps.clients;
+    v[TELEM_STAT_OPEN]       = (int32_t)aps.by_encryption[AP_ENC_OPEN];
+    v[TELEM_STAT_WPA3]       = (int32_t)aps.by_encryption[AP_ENC_WPA3];
+    v[TELEM_STAT_APS_HS]     = (int32_t)aps.with_handshake;
+    v[TELEM_STAT_RSSI_MAX]   = aps.strongest_rssi;
+    v[TELEM_STAT_CHANNEL]    = pwn.current_channel;
+    v[TELEM_STAT_HANDSHAKES] = (int32_t)pwn.handshakes;
+    v[TELEM_STAT_PMKIDS]     = (int32_t)pwn.pmkids;
+    v[TELEM_STAT_FRAMES]     = (int32_t)pwn.frames_captured;
+    v[TELEM_STAT_DROPS]      = (int32_t)pwn.frames_dropped;
+}
+
+// Classe do último resultado da NEURA9 (aplicado por Pwnagotchi::update())
+static uint8_t telemetry_threat() {
+    return pwn.threat_level;
+}
+
+static size_t telemetry_aps(ApInfo* out, size_t n, uint32_t now_ms) {
+    return ap_table.top_by_rssi(out, n, now_ms - AP_TABLE_ACTIVE_WINDOW_MS);
+}
+
 // -----------------------------------------------------------------------------
 // API pública
 // -----------------------------------------------------------------------------
 
 void webserver_start() {
-    // Rotas HTTP principais
+    state_mutex = xSemaphoreCreateMutex();
+
+    // O /config já está em RAM (config_store.begin() no boot); aqui só o
+    // arquivo-guarda do lab
+    storage_call(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, refresh_lab_guard, nullptr);
+    web_io_start();
+
+    // Rotas HTTP principais: "/" + um GET por asset embutido (gzip + ETag).
+    // /ota/update.html fica de fora e passa pela autenticação do OTA.
     http_server.on("/", HTTP_GET, handle_root);
-    http_server.on("/index.html", HTTP_GET, handle_index);
-    http_server.on("/style.css", HTTP_GET, handle_style);
-    http_server.on("/chart.min.js", HTTP_GET, handle_chart);
-    http_server.on("/favicon.ico", HTTP_GET, handle_favicon);
-    http_server.on("/config.html", HTTP_GET, handle_config_page);
-    http_server.on("/config.js", HTTP_GET, handle_config_js);
+    web_assets_register(http_server, "/ota/");
 
     // API de configuração do dispositivo
     http_server.on("/api/config/device", HTTP_GET, handle_api_config_device_get);
-    http_server.on("/api/config/device", HTTP_POST, handle_api_config_device_post);
+    http_server.on("/api/config/device", HTTP_POST, handle_api_config_device_post,
+                   nullptr, collect_body);
 
     // API de Lab Mode (simulações acadêmicas)
+    http_server.on("/api/aps", HTTP_GET, handle_api_aps);
     http_server.on("/api/lab/status", HTTP_GET, handle_api_lab_status);
-    http_server.on("/api/lab/set_pin", HTTP_POST, handle_api_lab_set_pin);
-    http_server.on("/api/lab/unlock", HTTP_POST, handle_api_lab_unlock);
+    http_server.on("/api/lab/set_pin", HTTP_POST, handle_api_lab_set_pin,
+                   nullptr, collect_body);
+    http_server.on("/api/lab/unlock", HTTP_POST, handle_api_lab_unlock,
+                   nullptr, collect_body);
 
     // API de integração com Gemini
-    http_server.on("/api/gemini/key", HTTP_POST, handle_api_gemini_key);
-    http_server.on("/api/gemini/ask", HTTP_POST, handle_api_gemini_ask);
+    http_server.on("/api/gemini/key", HTTP_POST, handle_api_gemini_key,
+                   nullptr, collect_body);
+    http_server.on("/api/gemini/ask", HTTP_POST, handle_api_gemini_ask,
+                   nullptr, collect_body);
+
+    // Capturas e logs do SD: listagem paginada, downloads com Range, hashes
+    captures_register(http_server);
+
+    // Filas da task sd: profundidade, espera e bytes por cliente
+    http_server.on("/api/storage", HTTP_GET, handle_api_storage);
+    // Seq/aleatório, MB/s e IOPS (grava 4 MB no cartão; pede login do OTA)
+    http_server.on("/api/storage/bench", HTTP_POST, handle_api_storage_bench);
+    // Anel de eventos do lab/web (utils/event_log.h)
+    http_server.on("/api/logs", HTTP_GET, handle_api_logs);
+    // Serviço de inferência: contagens, histogramas e último resultado
+    http_server.on("/api/neura9", HTTP_GET, handle_api_neura9);
 
     // OTA seguro
     http_server.on("/ota/update.html", HTTP_GET, handle_ota_page);
-    http_server.on(
-        "/ota/firmware",
-        HTTP_POST,
-        handle_ota_result,
-        handle_ota_upload
-    );
+    ota_http_register(http_server, OTA_USER, OTA_PASS);
 
     // Reboot simples via Web Config
     http_server.on("/reboot", HTTP_GET, handle_reboot);
 
     http_server.onNotFound(handle_not_found);
 
-    http_server.begin();
-    log_line("[WEB] HTTP server iniciado na porta 80");
-
-    ws_server.begin();
+    TelemetrySources sources = {telemetry_stats, telemetry_threat, telemetry_aps};
+    telemetry_begin(&ws_server, sources);
     ws_server.onEvent(on_ws_event);
-    log_line("[WEB] WebSocket server iniciado na porta 81");
+    http_server.addHandler(&ws_server);
+
+    http_server.begin();
+    log_line("[WEB] HTTP + WebSocket (/ws) assíncronos na porta 80");
 }
 
 void webserver_send_stats() {
-    http_server.handleClient();
-    ws_server.loop();
-
-    if (ws_server.connectedClients() == 0) {
-        return;
+    // Chamado a cada frame da UI: a telemetria só monta e enfileira o que
+    // venceu e mudou (o envio é da task do AsyncTCP)
+    static uint32_t last_cleanup = 0;
+    uint32_t now = millis();
+    if (now - last_cleanup >= WEB_WS_CLEANUP_MS) {
+        last_cleanup = now;
+        ws_server.cleanupClients();
     }
 
-    // NEURA9 - garante que a IA defensiva continue ativa mesmo sem UI física.
-    uint8_t cls = neura9.predict();
-    pwn.threat_level = cls;
-    pwn.threat_confidence = neura9.get_confidence();
-
-    String json;
-    json.reserve(256);
-
-    json += "{";
-    json += "\"uptime\":";
-    json += String(pwn.uptime);
-    json += ",\"battery\":";
-    json += String(pwn.battery_percent, 0);
-    json += ",\"aps\":";
-    json += String(pwn.aps_seen);
-    json += ",\"hs\":";
-    json += String(pwn.handshakes);
-    json += ",\"pmkid\":";
-    json += String(pwn.pmkids);
-    json += ",\"ai\":\"";
-    json += NEURA9_THREAT_LABELS[cls];
-    json += "\"";
-
-    if (last_log_line.length() > 0) {
-        json += ",\"log\":\"";
-        String safe = last_log_line;
-        safe.replace("\\", "\\\\");
-        safe.replace("\"", "\\\"");
-        safe.replace("\n", "\\n");
-        json += safe;
-        json += "\"";
-    } else {
-        json += ",\"log\":\"\"";
-    }
-
-    json += "}";
-
-    ws_server.broadcastTXT(json);
-}
\ No newline at end of file
+    telemetry_tick(now);
+}
@@ -4,4 +4,264 @@
 
 #include "storage.h"
 
-// Implementações futuras de armazenamento em cartão SD.
\ No newline at end of file
+#include <esp_heap_caps.h>
+
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Core 0, na prioridade do antigo pcap_flush: abaixo da task de captura (3),
+// que só enche buffers, e acima da web_io (1). Stack para o FATFS mais o
+// maior job (listagem de diretório, JSON do /config).
+static const BaseType_t STORAGE_TASK_CORE = 0;
+static const UBaseType_t STORAGE_TASK_PRIO = 2;
+static const uint32_t STORAGE_TASK_STACK = 6144;
+
+// CAPTURE: 2 buffers do PCAP + syncs + log de sessão. BULK: um bloco
+// adiantado por download, mais listagens.
+static const UBaseType_t STORAGE_QUEUE_LEN[STORAGE_PRIO_COUNT] = {8, 16, 16};
+
+// Semáforos para storage_call(), criados uma vez: no máximo tantas tasks
+// esperando ao mesmo tempo (as demais esperam um semáforo livre)
+static const UBaseType_t STORAGE_CALL_SLOTS = 4;
+
+static const char* const PRIO_NAMES[STORAGE_PRIO_COUNT] = {"capture", "log", "bulk"};
+static const char* const CLIENT_NAMES[STORAGE_CLIENT_COUNT] = {
+    "capture", "log", "config", "web", "report",
+};
+
+// Item da fila (copiado byte a byte pelo FreeRTOS)
+struct StorageJob {
+    StorageJobFn fn;
+    StorageJobFn done;
+    void* ctx;
+    uint32_t queued_us;
+    uint8_t client;
+};
+
+// storage_call(): o job de verdade e quem espera por ele
+struct StorageCall {
+    StorageJobFn fn;
+    void* ctx;
+    SemaphoreHandle_t finished;
+};
+
+static QueueHandle_t queues[STORAGE_PRIO_COUNT] = {};
+static SemaphoreHandle_t pending = nullptr;   // um give por job enfileirado
+static QueueHandle_t call_sems = nullptr;     // semáforos livres
+static TaskHandle_t worker = nullptr;
+
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static StorageStats stats = {};
+static uint8_t current_client = STORAGE_CLIENT_COUNT;   // do job em execução
+
+static void run_job(const StorageJob& job) {
+    uint32_t start = micros();
+    uint8_t outer = current_client;
+    current_client = job.client;
+    job.fn(job.ctx);
+    if (job.done) job.done(job.ctx);
+    current_client = outer;
+    uint32_t service = micros() - start;
+    uint32_t wait = start - job.queued_us;
+
+    portENTER_CRITICAL(&stats_mux);
+    StorageClientStats& c = stats.clients[job.client];
+    c.jobs++;
+    c.wait_us_total += wait;
+    if (wait > c.wait_us_max) c.wait_us_max = wait;
+    if (service > c.service_us_max) c.service_us_max = service;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+// Fila a atender: a mais prioritária com jobs, salvo quando uma mais baixa
+// já foi passada para trás STORAGE_STARVE_LIMIT vezes seguidas
+static int pick_queue() {
+    static uint32_t skipped[STORAGE_PRIO_COUNT] = {};
+
+    bool waiting[STORAGE_PRIO_COUNT];
+    int pick = -1;
+    for (int p = 0; p < STORAGE_PRIO_COUNT; ++p) {
+        waiting[p] = uxQueueMessagesWaiting(queues[p]) > 0;
+        if (!waiting[p]) skipped[p] = 0;
+        if (waiting[p] && pick < 0) pick = p;
+    }
+    if (pick < 0) return -1;
+    for (int p = STORAGE_PRIO_COUNT - 1; p > pick; --p) {
+        if (waiting[p] && skipped[p] >= STORAGE_STARVE_LIMIT) {
+            pick = p;
+            break;
+        }
+    }
+    for (int p = 0; p < STORAGE_PRIO_COUNT; ++p) {
+        if (waiting[p]) skipped[p] = p == pick ? 0 : skipped[p] + 1;
+    }
+    return pick;
+}
+
+static void storage_task(void*) {
+    for (;;) {
+        if (xSemaphoreTake(pending, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        int p = pick_queue();
+        StorageJob job;
+        if (p >= 0 && xQueueReceive(queues[p], &job, 0) == pdTRUE) {
+            run_job(job);
+        }
+    }
+}
+
+bool storage_start() {
+    if (worker) return true;
+
+    UBaseType_t total = 0;
+    for (int p = 0; p < STORAGE_PRIO_COUNT; ++p) {
+        queues[p] = xQueueCreate(STORAGE_QUEUE_LEN[p], sizeof(StorageJob));
+        total += STORAGE_QUEUE_LEN[p];
+        if (!queues[p]) {
+            Serial.println("[SD] Falha ao criar filas da task sd");
+            return false;
+        }
+    }
+    pending = xSemaphoreCreateCounting(total, 0);
+    call_sems = xQueueCreate(STORAGE_CALL_SLOTS, sizeof(SemaphoreHandle_t));
+    if (!pending || !call_sems) {
+        Serial.println("[SD] Falha ao criar semaforos da task sd");
+        return false;
+    }
+    for (UBaseType_t i = 0; i < STORAGE_CALL_SLOTS; ++i) {
+        SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+        if (!sem) {
+            Serial.println("[SD] Falha ao criar semaforos da task sd");
+            return false;
+        }
+        xQueueSend(call_sems, &sem, 0);
+    }
+    if (xTaskCreatePinnedToCore(storage_task,
+                                "sd",
+                                STORAGE_TASK_STACK,
+                                nullptr,
+                                STORAGE_TASK_PRIO,
+                                &worker,
+                                STORAGE_TASK_CORE) != pdPASS) {
+        worker = nullptr;
+        Serial.println("[SD] Falha ao criar task sd, acesso direto ao cartao");
+        return false;
+    }
+    stats.running = true;
+    return true;
+}
+
+static bool enqueue(StoragePrio prio, const StorageJob& job, TickType_t ticks) {
+    if (xQueueSend(queues[prio], &job, ticks) != pdTRUE) {
+        portENTER_CRITICAL(&stats_mux);
+        stats.queues[prio].rejected++;
+        portEXIT_CRITICAL(&stats_mux);
+        return false;
+    }
+    uint32_t depth = uxQueueMessagesWaiting(queues[prio]);
+    portENTER_CRITICAL(&stats_mux);
+    if (depth > stats.queues[prio].depth_max) stats.queues[prio].depth_max = depth;
+    portEXIT_CRITICAL(&stats_mux);
+    xSemaphoreGive(pending);
+    return true;
+}
+
+bool storage_submit(StoragePrio prio, StorageClient client,
+                    StorageJobFn fn, void* ctx, StorageJobFn done) {
+    StorageJob job = {fn, done, ctx, (uint32_t)micros(), client};
+    if (!worker) {
+        run_job(job);
+        return true;
+    }
+    return enqueue(prio, job, 0);
+}
+
+static void call_run(void* arg) {
+    StorageCall* call = (StorageCall*)arg;
+    call->fn(call->ctx);
+}
+
+static void call_done(void* arg) {
+    xSemaphoreGive(((StorageCall*)arg)->finished);
+}
+
+void storage_call(StoragePrio prio, StorageClient client, StorageJobFn fn, void* ctx) {
+    StorageCall call = {fn, ctx, nullptr};
+    if (worker && !storage_on_worker()) {
+        xQueueReceive(call_sems, &call.finished, portMAX_DELAY);
+    }
+    StorageJob job = {call_run, call.finished ? call_done : nullptr, &call,
+                      (uint32_t)micros(), client};
+    if (!call.finished) {
+        run_job(job);
+        return;
+    }
+    // Espera vaga na fila: quem chama precisa do resultado
+    enqueue(prio, job, portMAX_DELAY);
+    xSemaphoreTake(call.finished, portMAX_DELAY);
+    xQueueSend(call_sems, &call.finished, 0);
+}
+
+void* storage_dma_alloc(size_t size) {
+    size = (size + STORAGE_DMA_ALIGN - 1) & ~(size_t)(STORAGE_DMA_ALIGN - 1);
+    void* p = heap_caps_aligned_alloc(STORAGE_DMA_ALIGN, size,
+                                      MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!p) {
+        p = heap_caps_aligned_alloc(STORAGE_DMA_ALIGN, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    return p;
+}
+
+bool storage_on_worker() {
+    return worker && xTaskGetCurrentTaskHandle() == worker;
+}
+
+void storage_account(size_t read, size_t written) {
+    uint8_t client = current_client;
+    if (client >= STORAGE_CLIENT_COUNT) return;
+    portENTER_CRITICAL(&stats_mux);
+    stats.clients[client].bytes_read += read;
+    stats.clients[client].bytes_written += written;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void storage_get_stats(StorageStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+    for (int p = 0; p < STORAGE_PRIO_COUNT; ++p) {
+        out->queues[p].depth = queues[p] ? uxQueueMessagesWaiting(queues[p]) : 0;
+    }
+}
+
+String storage_stats_json() {
+    StorageStats s;
+    storage_get_stats(&s);
+
+    char buf[192];
+    String out = s.running ? "{\"running\":true,\"queues\":{" : "{\"running\":false,\"queues\":{";
+    for (int p = 0; p < STORAGE_PRIO_COUNT; ++p) {
+        const StorageQueueStats& q = s.queues[p];
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"depth\":%lu,\"depth_max\":%lu,\"rejected\":%lu}",
+                 p ? "," : "", PRIO_NAMES[p], (unsigned long)q.depth,
+                 (unsigned long)q.depth_max, (unsigned long)q.rejected);
+        out += buf;
+    }
+    out += "},\"clients\":{";
+    for (int i = 0; i < STORAGE_CLIENT_COUNT; ++i) {
+        const StorageClientStats& c = s.clients[i];
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"jobs\":%lu,\"read\":%llu,\"written\":%llu,"
+                 "\"wait_avg_us\":%lu,\"wait_max_us\":%lu,\"service_max_us\":%lu}",
+                 i ? "," : "", CLIENT_NAMES[i], (unsigned long)c.jobs,
+                 (unsigned long long)c.bytes_read, (unsigned long long)c.bytes_written,
+                 (unsigned long)(c.jobs ? c.wait_us_total / c.jobs : 0),
+                 (unsigned long)c.wait_us_max, (unsigned long)c.service_us_max);
+        out += buf;
+    }
+    out += "}}";
+    return out;
+}
@@ -1,7 +1,139 @@
 /*
   storage.h - Gerenciamento do microSD (PCAP, logs, config) para WavePwn
+
+  Uma task "sd" é a dona do cartão: todo acesso ao SD (abrir, ler, gravar,
+  listar, renomear) vira um job na fila dela em vez de rodar na task de
+  quem pediu. Assim a captura, os logs, o ConfigStore e os downloads do
+  dashboard não disputam o barramento entre si sem critério.
+
+  Três filas, por prioridade:
+    STORAGE_PRIO_CAPTURE  buffers do PCAP e log de sessão
+    STORAGE_PRIO_LOG      logs de eventos e /config
+    STORAGE_PRIO_BULK     downloads, listagens, relatórios
+
+  A task sempre atende a fila mais prioritária com jobs, exceto que a cada
+  STORAGE_STARVE_LIMIT jobs seguidos de uma fila mais alta ela atende um
+  da mais baixa que estiver esperando: um download nunca para por
+  completo, mas só anda nas brechas da captura. Dentro de uma fila a ordem
+  é FIFO, então gravações de um mesmo cliente saem na ordem do submit.
+
+  Jobs devem ser curtos (um bloco de 4-32 KB, uma entrada de diretório):
+  quem tem muito a fazer (download) submete um job por bloco. Para as
+  estatísticas por cliente, o job informa os bytes que moveu com
+  storage_account().
+
+  O cartão em si é montado por storage_mount() (storage_card.cpp): SDMMC
+  em alta velocidade, FATFS com unidade de alocação grande, exposto como
+  o mesmo fs::FS do Arduino em SDCARD. Buffers que vão inteiros para o
+  cartão (PCAP, log de sessão) vêm de storage_dma_alloc(): com eles
+  alinhados e gravados a partir de uma fronteira de setor, o FATFS passa
+  o buffer direto ao DMA do SDMMC, vários setores por comando.
 */
 
 #pragma once
 
-// Futuras declarações para gerenciamento de armazenamento em microSD.
\ No newline at end of file
+#include <Arduino.h>
+#include <FS.h>
+#include "freertos/FreeRTOS.h"
+
+#define STORAGE_STARVE_LIMIT 8
+
+// Ponto de montagem VFS (caminhos POSIX); pelo SDCARD os caminhos são
+// relativos a ele ("/sd/wavepwn/...").
+#define STORAGE_MOUNT_POINT "/sdcard"
+
+#define STORAGE_SECTOR_SIZE 512
+// Linha de cache (exigência do DMA do SDMMC com cache no S3/P4)
+#define STORAGE_DMA_ALIGN   64
+
+// Sistema de arquivos do cartão (no host, o SD do shim)
+extern fs::FS& SDCARD;
+
+enum StoragePrio : uint8_t {
+    STORAGE_PRIO_CAPTURE = 0,
+    STORAGE_PRIO_LOG,
+    STORAGE_PRIO_BULK,
+    STORAGE_PRIO_COUNT,
+};
+
+// Quem pediu (só para as estatísticas)
+enum StorageClient : uint8_t {
+    STORAGE_CLIENT_CAPTURE = 0,   // PcapWriter, SessionLog
+    STORAGE_CLIENT_LOG,           // lab_log_event
+    STORAGE_CLIENT_CONFIG,        // ConfigStore, idioma
+    STORAGE_CLIENT_WEB,           // downloads e listagens do dashboard
+    STORAGE_CLIENT_REPORT,        // PDFs, easter egg
+    STORAGE_CLIENT_COUNT,
+};
+
+// Roda na task "sd". `done` (opcional) roda logo depois, na mesma task:
+// é o aviso de conclusão para quem submeteu (liberar buffer, semáforo).
+typedef void (*StorageJobFn)(void* ctx);
+
+struct StorageQueueStats {
+    uint32_t depth;          // jobs esperando agora
+    uint32_t depth_max;
+    uint32_t rejected;       // submit com a fila cheia
+};
+
+struct StorageClientStats {
+    uint32_t jobs;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t wait_us_total;  // submit -> início do job
+    uint32_t wait_us_max;
+    uint32_t service_us_max; // duração do job mais longo
+};
+
+struct StorageStats {
+    bool running;
+    StorageQueueStats queues[STORAGE_PRIO_COUNT];
+    StorageClientStats clients[STORAGE_CLIENT_COUNT];
+};
+
+struct StorageCardInfo {
+    bool mounted;
+    uint8_t bus_width;        // 1 ou 4
+    uint32_t freq_khz;
+    uint32_t cluster_bytes;   // unidade de alocação do FATFS montado
+    uint64_t total_bytes;
+    uint64_t free_bytes;
+    char name[8];             // nome do cartão (CID)
+};
+
+// Monta o cartão (chamado pelo initSD). Sem cartão ou com falha: false, e
+// todo acesso pelo SDCARD falha como antes (arquivos não abrem).
+bool storage_mount();
+
+// Lê a FAT (espaço livre): chamar de dentro de um job
+void storage_card_info(StorageCardInfo* out);
+
+// Buffer para o DMA do SDMMC: RAM interna, alinhado a STORAGE_DMA_ALIGN.
+// Sem RAM interna cai para a PSRAM (funciona, mas o driver copia setor a
+// setor). Liberar com heap_caps_free().
+void* storage_dma_alloc(size_t size);
+
+// Sobe a task "sd" (chamado pelo initSD depois do storage_mount). Antes
+// disso, e se a task não subir, storage_call() roda o job na hora.
+bool storage_start();
+
+// Enfileira e volta. false com a fila cheia (o job não roda nem `done`).
+// Sem a task (antes do storage_start), roda na hora e devolve true.
+bool storage_submit(StoragePrio prio, StorageClient client,
+                    StorageJobFn fn, void* ctx,
+                    StorageJobFn done = nullptr);
+
+// Enfileira e espera terminar. Na própria task "sd" (um job chamando
+// outro) roda direto, sem fila.
+void storage_call(StoragePrio prio, StorageClient client, StorageJobFn fn, void* ctx);
+
+// true dentro de um job rodando na task "sd"
+bool storage_on_worker();
+
+// Bytes lidos/gravados pelo job atual, somados ao cliente dele
+void storage_account(size_t read, size_t written);
+
+void storage_get_stats(StorageStats* out);
+
+// GET /api/storage
+String storage_stats_json();
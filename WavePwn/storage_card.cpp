@@ -0,0 +1,146 @@
+/*
+  storage_card.cpp - Montagem do microSD via SDMMC (só no firmware)
+
+  A placa liga o slot ao periférico SDMMC do S3 (lib/Mylibrary/pin_config.h,
+  ESP-IDF-v5.3.2/04_SD_MMC). O SD.begin() do Arduino falava SPI: um bit por
+  clock e cada setor copiado pela CPU. Aqui o cartão é montado direto pelo
+  esp_vfs_fat_sdmmc_mount, em alta velocidade (40 MHz, com volta para 20 MHz
+  se o cartão não aguentar), e exposto como fs::FS em SDCARD, com a mesma
+  API de File que o resto do firmware já usa.
+
+  Fiação padrão: 1 bit (CLK 2, CMD 1, D0 3). Em placas com D1-D3 ligados,
+  -DSTORAGE_SDMMC_D1=.. -DSTORAGE_SDMMC_D2=.. -DSTORAGE_SDMMC_D3=.. liga o
+  modo 4 bits.
+*/
+
+#include "storage.h"
+
+#include <vfs_api.h>
+
+#include "diskio_sdmmc.h"
+#include "driver/sdmmc_host.h"
+#include "esp_vfs_fat.h"
+#include "sdmmc_cmd.h"
+
+#ifndef STORAGE_SDMMC_CLK
+#define STORAGE_SDMMC_CLK 2
+#endif
+#ifndef STORAGE_SDMMC_CMD
+#define STORAGE_SDMMC_CMD 1
+#endif
+#ifndef STORAGE_SDMMC_D0
+#define STORAGE_SDMMC_D0 3
+#endif
+#ifndef STORAGE_SDMMC_D1
+#define STORAGE_SDMMC_D1 -1
+#endif
+#ifndef STORAGE_SDMMC_D2
+#define STORAGE_SDMMC_D2 -1
+#endif
+#ifndef STORAGE_SDMMC_D3
+#define STORAGE_SDMMC_D3 -1
+#endif
+
+// Formatar apaga o cartão: só com -DSTORAGE_FORMAT_IF_MOUNT_FAILED=1
+#ifndef STORAGE_FORMAT_IF_MOUNT_FAILED
+#define STORAGE_FORMAT_IF_MOUNT_FAILED 0
+#endif
+
+// PCAP aberto, log de sessão, /config, downloads simultâneos, relatório
+static const int STORAGE_MAX_FILES = 10;
+
+// Cluster usado ao formatar. O PCAP cresce em blocos de 16 KB: clusters
+// grandes = menos entradas da FAT para atualizar por write. Cartões já
+// formatados mantêm o cluster deles (ver cluster_bytes no /api/storage/bench).
+static const size_t STORAGE_ALLOC_UNIT = 64 * 1024;
+
+static fs::FSImplPtr card_impl = std::make_shared<VFSImpl>();
+static fs::FS card_fs(card_impl);
+fs::FS& SDCARD = card_fs;
+
+static sdmmc_card_t* card = nullptr;
+static StorageCardInfo info = {};
+
+static esp_err_t mount_at(uint32_t freq_khz, int width) {
+    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+    host.max_freq_khz = freq_khz;
+
+    sdmmc_slot_config_t slot = SDMMC_SLOT_CONFIG_DEFAULT();
+    slot.width = width;
+    slot.clk = (gpio_num_t)STORAGE_SDMMC_CLK;
+    slot.cmd = (gpio_num_t)STORAGE_SDMMC_CMD;
+    slot.d0 = (gpio_num_t)STORAGE_SDMMC_D0;
+    if (width == 4) {
+        slot.d1 = (gpio_num_t)STORAGE_SDMMC_D1;
+        slot.d2 = (gpio_num_t)STORAGE_SDMMC_D2;
+        slot.d3 = (gpio_num_t)STORAGE_SDMMC_D3;
+    }
+    // Os pull-ups externos da placa são os que valem; os internos ajudam
+    // com cartões que sobem devagar
+    slot.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+
+    esp_vfs_fat_sdmmc_mount_config_t mount = {};
+    mount.format_if_mount_failed = STORAGE_FORMAT_IF_MOUNT_FAILED;
+    mount.max_files = STORAGE_MAX_FILES;
+    mount.allocation_unit_size = STORAGE_ALLOC_UNIT;
+
+    return esp_vfs_fat_sdmmc_mount(STORAGE_MOUNT_POINT, &host, &slot, &mount, &card);
+}
+
+// Tamanho, espaço livre e cluster, lidos da FAT
+static void refresh_fat_info() {
+    char drive[3] = {(char)('0' + ff_diskio_get_pdrv_card(card)), ':', 0};
+    FATFS* fs = nullptr;
+    DWORD free_clusters = 0;
+    if (f_getfree(drive, &free_clusters, &fs) != FR_OK || !fs) {
+        return;
+    }
+    uint64_t cluster = (uint64_t)fs->csize * card->csd.sector_size;
+    info.cluster_bytes = (uint32_t)cluster;
+    info.total_bytes = cluster * (fs->n_fatent - 2);
+    info.free_bytes = cluster * free_clusters;
+}
+
+bool storage_mount() {
+    if (info.mounted) return true;
+
+    bool four_bit = STORAGE_SDMMC_D1 >= 0 && STORAGE_SDMMC_D2 >= 0 && STORAGE_SDMMC_D3 >= 0;
+    int width = four_bit ? 4 : 1;
+
+    esp_err_t err = mount_at(SDMMC_FREQ_HIGHSPEED, width);
+    if (err != ESP_OK && err != ESP_FAIL) {
+        // ESP_FAIL é o FATFS (cartão sem sistema de arquivos); o resto é
+        // o barramento, que pode não aguentar 40 MHz
+        Serial.printf("[SD] SDMMC a %d MHz falhou (%s), tentando %d MHz\n",
+                      SDMMC_FREQ_HIGHSPEED / 1000, esp_err_to_name(err),
+                      SDMMC_FREQ_DEFAULT / 1000);
+        err = mount_at(SDMMC_FREQ_DEFAULT, width);
+    }
+    if (err != ESP_OK) {
+        Serial.printf("[SD] Falha ao montar o microSD (%s)\n", esp_err_to_name(err));
+        card = nullptr;
+        return false;
+    }
+    card_impl->mountpoint(STORAGE_MOUNT_POINT);
+
+    info.mounted = true;
+    info.bus_width = (uint8_t)(1 << card->log_bus_width);
+    info.freq_khz = card->max_freq_khz;
+    memcpy(info.name, card->cid.name, sizeof(info.name) - 1);
+    info.name[sizeof(info.name) - 1] = 0;
+    refresh_fat_info();
+
+    Serial.printf("[SD] %s: SDMMC %u bit(s) a %lu kHz, %llu MB, cluster de %lu KB\n",
+                  info.name, info.bus_width, (unsigned long)info.freq_khz,
+                  (unsigned long long)(info.total_bytes / (1024 * 1024)),
+                  (unsigned long)(info.cluster_bytes / 1024));
+    return true;
+}
+
+void storage_card_info(StorageCardInfo* out) {
+    if (!out) return;
+    if (info.mounted) {
+        refresh_fat_info();
+    }
+    *out = info;
+}
@@ -0,0 +1,324 @@
+/*
+  dot11_bench.cpp - Dot11View (src/capture/dot11.h) no host: fuzz e microbench
+
+  Sobre os frames de um pcap clássico (LINKTYPE 105, com FCS, como os
+  corpora de tools/replay/bench.sh):
+
+    padrão      microbench: Dot11View::parse() + o que a captura extrai
+                (SSID, RSN/PMKID, EAPOL-Key) em cada frame, melhor de
+                --passes passadas; frames/s, ns/frame e MB/s
+    --fuzz N    N entradas mutadas a partir dos frames do pcap (bits
+                trocados, bytes sobrescritos, tamanhos de IE forjados,
+                cortes, emendas entre frames). Cada entrada vai para um
+                buffer do tamanho exato; todo Span e ponteiro da view é
+                conferido contra esse buffer e lido byte a byte, então o
+                env native_dot11_fuzz (ASan + UBSan) pega qualquer leitura
+                fora dele. Sai com 1 na primeira violação, com o frame em hex.
+
+  Com -DDOT11_LIBFUZZER o arquivo vira um alvo do libFuzzer (clang
+  -fsanitize=fuzzer) com as mesmas verificações.
+
+  Uso:
+    pio run -e native_dot11 && .pio/build/native_dot11/program [--passes N] [--json] captura.pcap
+    pio run -e native_dot11_fuzz
+    .pio/build/native_dot11_fuzz/program --fuzz 2000000 [--seed S] captura.pcap
+*/
+
+#include "capture/dot11.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+// -----------------------------------------------------------------------------
+// Verificação de uma view contra o buffer de onde ela saiu
+// -----------------------------------------------------------------------------
+
+struct Checker {
+    const uint8_t* begin;
+    const uint8_t* end;
+    const char* failure = nullptr;
+    uint32_t sink = 0;     // soma dos bytes lidos (o compilador não descarta)
+
+    void span(const dot11::Span& s, const char* what) {
+        if (s.len == 0) return;
+        if (!s.data || s.data < begin || s.data + s.len > end) {
+            if (!failure) failure = what;
+            return;
+        }
+        for (uint16_t i = 0; i < s.len; ++i) sink += s.data[i];
+    }
+
+    void ptr(const uint8_t* p, size_t n, const char* what) {
+        if (!p) return;
+        dot11::Span s = {p, (uint16_t)n};
+        span(s, what);
+    }
+};
+
+// O que a captura faz com um frame: view, IEs de novo (iterador), PMKID do
+// RSN e EAPOL-Key. Retorna o nome do campo fora do buffer, ou nullptr.
+static const char* check_frame(const uint8_t* data, uint16_t len, uint16_t fcs_len,
+                               uint32_t* sink) {
+    Checker c = {data, data + len};
+    dot11::Dot11View v;
+    if (v.parse(data, len, fcs_len)) {
+        c.span(v.frame, "frame");
+        c.ptr(v.addr1, 6, "addr1");
+        c.ptr(v.addr2, 6, "addr2");
+        c.ptr(v.addr3, 6, "addr3");
+        c.ptr(v.bssid, 6, "bssid");
+        c.span(v.body, "body");
+        c.span(v.ies, "ies");
+        c.span(v.ssid, "ssid");
+        c.span(v.rsn, "rsn");
+        c.span(v.wpa, "wpa");
+        for (uint8_t i = 0; i < v.vendor_count; ++i) c.span(v.vendor[i], "vendor");
+        c.span(v.eapol, "eapol");
+        if (v.ssid.len > 32) c.failure = "ssid > 32";
+
+        dot11::IeIterator it(v.ies);
+        dot11::Ie ie;
+        while (it.next(&ie)) c.span(ie.body, "ie");
+
+        c.ptr(dot11::rsn_pmkid(v.rsn), 16, "pmkid");
+
+        dot11::EapolKey key;
+        if (dot11::parse_eapol_key(v.eapol, &key)) {
+            c.span(key.frame, "eapol_key.frame");
+            c.ptr(key.nonce, 32, "eapol_key.nonce");
+            c.ptr(key.mic, 16, "eapol_key.mic");
+            if (key.mic && key.mic != key.frame.data + key.mic_offset) c.failure = "mic_offset";
+        }
+    }
+    *sink += c.sink;
+    return c.failure;
+}
+
+#ifdef DOT11_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 1 || size > 0xFFFF) return 0;
+    uint32_t sink = 0;
+    // 1º byte escolhe o FCS, o resto é o frame
+    if (check_frame(data + 1, (uint16_t)(size - 1), (data[0] & 1) ? 4 : 0, &sink)) abort();
+    return 0;
+}
+
+#else
+
+// -----------------------------------------------------------------------------
+// Corpus
+// -----------------------------------------------------------------------------
+
+static std::vector<uint8_t> bytes;
+static std::vector<std::pair<uint32_t, uint16_t>> frames;   // offset, len
+
+static bool load_pcap(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t gh[24];
+    uint32_t magic = 0, linktype = 0;
+    if (fread(gh, 1, sizeof(gh), f) != sizeof(gh)) {
+        fclose(f);
+        return false;
+    }
+    memcpy(&magic, gh, 4);
+    memcpy(&linktype, gh + 20, 4);
+    if (magic != 0xa1b2c3d4 || linktype != 105) {
+        fprintf(stderr, "[DOT11] %s: só pcap clássico little-endian, LINKTYPE 105\n", path);
+        fclose(f);
+        return false;
+    }
+    uint8_t rh[16];
+    while (fread(rh, 1, sizeof(rh), f) == sizeof(rh)) {
+        uint32_t caplen;
+        memcpy(&caplen, rh + 8, 4);
+        uint32_t off = (uint32_t)bytes.size();
+        bytes.resize(off + caplen);
+        if (fread(&bytes[off], 1, caplen, f) != caplen) {
+            bytes.resize(off);
+            break;
+        }
+        if (caplen <= 0xFFFF) frames.push_back(std::make_pair(off, (uint16_t)caplen));
+    }
+    fclose(f);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Fuzz
+// -----------------------------------------------------------------------------
+
+static void mutate(std::vector<uint8_t>* buf, std::mt19937* rng) {
+    std::vector<uint8_t>& b = *buf;
+    auto rnd = [rng](uint32_t n) { return n ? (uint32_t)((*rng)() % n) : 0u; };
+    switch (rnd(8)) {
+        case 0:   // bit trocado
+            if (!b.empty()) b[rnd(b.size())] ^= (uint8_t)(1u << rnd(8));
+            break;
+        case 1:   // byte qualquer
+            if (!b.empty()) b[rnd(b.size())] = (uint8_t)rnd(256);
+            break;
+        case 2:   // byte extremo (tamanhos de IE, contadores de listas do RSN)
+            if (!b.empty()) b[rnd(b.size())] = rnd(2) ? 0xFF : 0x00;
+            break;
+        case 3:   // corte
+            b.resize(rnd(b.size() + 1));
+            break;
+        case 4:   // lixo no fim
+            for (uint32_t n = rnd(64); n > 0; --n) b.push_back((uint8_t)rnd(256));
+            break;
+        case 5:   // Frame Control qualquer (tipo/subtipo/flags)
+            if (b.size() >= 2) {
+                b[0] = (uint8_t)rnd(256);
+                b[1] = (uint8_t)rnd(256);
+            }
+            break;
+        case 6:   // tamanho do EAPOL (logo depois do LLC) ou de um IE
+            if (b.size() > 36) b[24 + 8 + 2 + rnd(2)] = (uint8_t)rnd(256);
+            break;
+        default: {  // emenda com outro frame do corpus
+            const std::pair<uint32_t, uint16_t>& o = frames[rnd(frames.size())];
+            uint32_t cut = rnd(b.size() + 1);
+            uint32_t from = rnd(o.second + 1u);
+            b.resize(cut);
+            b.insert(b.end(), bytes.begin() + o.first + from, bytes.begin() + o.first + o.second);
+            break;
+        }
+    }
+    if (b.size() > 0xFFFF) b.resize(0xFFFF);
+}
+
+static int run_fuzz(uint64_t iterations, uint32_t seed, bool json) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> input;
+    uint32_t sink = 0;
+    Clock::time_point t0 = Clock::now();
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const std::pair<uint32_t, uint16_t>& f = frames[rng() % frames.size()];
+        input.assign(bytes.begin() + f.first, bytes.begin() + f.first + f.second);
+        for (uint32_t m = 1 + rng() % 4; m > 0; --m) mutate(&input, &rng);
+
+        // Buffer do tamanho exato: um byte além já é erro do ASan
+        const uint16_t len = (uint16_t)input.size();
+        uint8_t* exact = static_cast<uint8_t*>(malloc(len ? len : 1));
+        if (len) memcpy(exact, input.data(), len);
+        const uint16_t fcs = (rng() & 1) ? 4 : 0;
+        const char* bad = check_frame(exact, len, fcs, &sink);
+        if (bad) {
+            printf("[DOT11] FALHOU na entrada %llu: %s fora do buffer (len %u, fcs %u)\n",
+                   (unsigned long long)i, bad, len, fcs);
+            for (uint16_t k = 0; k < len; ++k) printf("%02x", exact[k]);
+            printf("\n");
+            free(exact);
+            return 1;
+        }
+        free(exact);
+    }
+
+    double s = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (json) {
+        printf("{\"fuzz_inputs\":%llu,\"seed\":%u,\"seconds\":%.1f,\"inputs_s\":%.0f,"
+               "\"violations\":0,\"checksum\":%u}\n",
+               (unsigned long long)iterations, seed, s, iterations / s, sink);
+    } else {
+        printf("[DOT11] fuzz: %llu entradas (semente %u) em %.1f s, %.0f/s, nenhuma "
+               "leitura fora do buffer\n",
+               (unsigned long long)iterations, seed, s, iterations / s);
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Microbench
+// -----------------------------------------------------------------------------
+
+static int run_bench(int passes, bool json) {
+    double best_ns = 1e30;
+    uint32_t ssids = 0, rsns = 0, pmkids = 0, eapols = 0;
+    uint32_t checksum = 0;
+    for (int p = 0; p < passes; ++p) {
+        ssids = rsns = pmkids = eapols = 0;
+        Clock::time_point t0 = Clock::now();
+        for (const std::pair<uint32_t, uint16_t>& f : frames) {
+            dot11::Dot11View v;
+            if (!v.parse(&bytes[f.first], f.second, 4)) continue;
+            if (v.is_mgmt()) {
+                ssids += v.has_ssid;
+                if (!v.rsn.empty()) {
+                    rsns++;
+                    pmkids += dot11::rsn_pmkid(v.rsn) != nullptr;
+                }
+            } else if (v.has_eapol()) {
+                dot11::EapolKey key;
+                eapols += dot11::parse_eapol_key(v.eapol, &key) && key.message != 0;
+            }
+            checksum += v.channel + v.ssid.len;
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() /
+                    frames.size();
+        best_ns = std::min(best_ns, ns);
+    }
+
+    const double fps = 1e9 / best_ns;
+    const double mb_s = bytes.size() / (best_ns * frames.size() / 1e9) / 1048576.0;
+    if (json) {
+        printf("{\"frames\":%zu,\"passes\":%d,\"ns_per_frame\":%.1f,\"fps\":%.0f,\"mb_s\":%.0f,"
+               "\"ssids\":%u,\"rsn\":%u,\"pmkids\":%u,\"eapol_keys\":%u,\"checksum\":%u}\n",
+               frames.size(), passes, best_ns, fps, mb_s, ssids, rsns, pmkids, eapols,
+               checksum);
+    } else {
+        printf("[DOT11] %zu frames, melhor de %d passadas: %.1f ns/frame, %.0f frames/s, "
+               "%.0f MB/s\n",
+               frames.size(), passes, best_ns, fps, mb_s);
+        printf("[DOT11] %u SSIDs, %u RSN (%u com PMKID), %u EAPOL-Key\n", ssids, rsns, pmkids,
+               eapols);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int passes = 10;
+    uint64_t fuzz = 0;
+    uint32_t seed = 1;
+    bool json = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--passes" && has) passes = std::max(1, atoi(argv[++i]));
+        else if (a == "--fuzz" && has) fuzz = strtoull(argv[++i], nullptr, 10);
+        else if (a == "--seed" && has) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--json") json = true;
+        else if (a[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "uso: %s [--passes N] [--fuzz N [--seed S]] [--json] captura.pcap\n",
+                argv[0]);
+        return 2;
+    }
+    if (!load_pcap(path) || frames.empty()) {
+        fprintf(stderr, "[DOT11] sem frames em %s\n", path);
+        return 1;
+    }
+
+    int rc = fuzz ? run_fuzz(fuzz, seed, json) : run_bench(passes, json);
+    fflush(stdout);
+    return rc;
+}
+
+#endif  // DOT11_LIBFUZZER
@@ -0,0 +1,356 @@
+/*
+  mac_table_bench.cpp - MacTable x std::set<String> / std::map<String,String>
+
+  Compara, com 10k e 100k entradas (ou os tamanhos de --sizes), as tabelas
+  de dedup da captura (src/capture/mac_table.h) com os contêineres que elas
+  substituíram no capture.cpp:
+
+    handshakes   MacTable<12, uint8_t> (AP+STA crus) x std::set<String>
+                 com a chave "AABBCCDDEEFF_112233445566"
+    ssids        MacTable<6, SsidEntry> (BSSID cru -> char[33]) x
+                 std::map<String, String> com o BSSID em hex
+
+  Para cada um: ns por inserção, por busca que acha e por busca que não
+  acha (melhor de --passes), alocações por inserção (operator new do
+  shim) e bytes de heap por entrada (mallinfo2, inclui o overhead do
+  malloc do host; ponteiros de 8 bytes, no S3 são 4). A MacTable usa a
+  menor potência de 2 com ocupação até 50% (acima de ~60% a sondagem de
+  32 slots já despeja algumas entradas).
+
+  Confere que toda chave inserida é achada, nenhuma ausente é achada e
+  que a MacTable não despejou nada; se falhar, sai com 1.
+
+  Uso:
+    pio run -e native_mac_table
+    .pio/build/native_mac_table/program [--sizes 10000,100000] [--passes N] [--json]
+*/
+
+#include <Arduino.h>
+
+#include "capture/mac_table.h"
+
+#include "host_shim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct SsidEntry {
+    char ssid[33];
+};
+
+struct OpResult {
+    double insert_ns = 1e30;
+    double hit_ns = 1e30;
+    double miss_ns = 1e30;
+    double allocs_per_insert = 0;
+    double bytes_per_entry = 0;
+    bool ok = true;
+};
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t n) {
+    if (!ok) {
+        printf("  FALHOU: %s (%zu entradas)\n", what, n);
+        failures++;
+    }
+}
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+static uint64_t next_rand() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void random_mac(uint8_t* mac) {
+    uint64_t r = next_rand();
+    memcpy(mac, &r, 6);
+    mac[0] &= 0xFE;   // unicast
+}
+
+// As mesmas chaves do capture.cpp antigo (mac_to_string_nosep)
+static String mac_hex(const uint8_t* mac) {
+    char buf[13];
+    snprintf(buf, sizeof(buf), "%02X%02X%02X%02X%02X%02X", mac[0], mac[1], mac[2], mac[3],
+             mac[4], mac[5]);
+    return String(buf);
+}
+
+static String pair_key(const uint8_t* key) {
+    return mac_hex(key) + String("_") + mac_hex(key + 6);
+}
+
+// Heap em uso, inclusive blocos grandes que o malloc serve com mmap
+static size_t heap_in_use() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+static uint64_t allocs_now() {
+    HostShimStats s;
+    host_shim_get_stats(&s);
+    return s.allocs;
+}
+
+static double ns_per(Clock::time_point t0, size_t n) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+static uint32_t table_capacity(size_t n) {
+    uint32_t cap = 1;
+    while (cap < n * 2) cap <<= 1;
+    return cap;
+}
+
+// Chaves presentes e ausentes, KeyLen bytes cada
+static void make_keys(size_t n, size_t key_len, std::vector<uint8_t>* hit,
+                      std::vector<uint8_t>* miss) {
+    hit->resize(n * key_len);
+    miss->resize(n * key_len);
+    for (size_t i = 0; i < n * key_len; i += 6) random_mac(&(*hit)[i]);
+    for (size_t i = 0; i < n * key_len; i += 6) random_mac(&(*miss)[i]);
+}
+
+static void random_ssid(char* out, size_t i) {
+    int len = 6 + (int)(i % 15);
+    for (int k = 0; k < len; ++k) out[k] = 'a' + (char)((i * 7 + k * 13) % 26);
+    out[len] = '\0';
+}
+
+static OpResult bench_handshakes_table(size_t n, int passes, const std::vector<uint8_t>& hit,
+                                       const std::vector<uint8_t>& miss, uint32_t* evictions) {
+    typedef MacTable<12, uint8_t> Table;
+    OpResult r;
+    const uint32_t cap = table_capacity(n);
+    for (int p = 0; p < passes; ++p) {
+        size_t h0 = heap_in_use();
+        uint64_t a0 = allocs_now();
+        void* storage = malloc(Table::storage_bytes(cap));
+        Table t;
+        t.begin(storage, cap);
+
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) t.insert(&hit[i * 12]);
+        r.insert_ns = std::min(r.insert_ns, ns_per(t0, n));
+        r.allocs_per_insert = (double)(allocs_now() - a0) / n;
+        r.bytes_per_entry = (double)(heap_in_use() - h0) / n;
+
+        size_t found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) found += t.contains(&hit[i * 12]);
+        r.hit_ns = std::min(r.hit_ns, ns_per(t0, n));
+        r.ok = r.ok && found == n;
+
+        found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) found += t.contains(&miss[i * 12]);
+        r.miss_ns = std::min(r.miss_ns, ns_per(t0, n));
+        r.ok = r.ok && found == 0;
+
+        *evictions = t.total_evictions();
+        free(storage);
+    }
+    return r;
+}
+
+static OpResult bench_handshakes_set(size_t n, int passes, const std::vector<uint8_t>& hit,
+                                     const std::vector<uint8_t>& miss) {
+    OpResult r;
+    for (int p = 0; p < passes; ++p) {
+        size_t h0 = heap_in_use();
+        uint64_t a0 = allocs_now();
+        std::set<String>* s = new std::set<String>();
+
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) s->insert(pair_key(&hit[i * 12]));
+        r.insert_ns = std::min(r.insert_ns, ns_per(t0, n));
+        r.allocs_per_insert = (double)(allocs_now() - a0) / n;
+        r.bytes_per_entry = (double)(heap_in_use() - h0) / n;
+
+        size_t found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) found += s->find(pair_key(&hit[i * 12])) != s->end();
+        r.hit_ns = std::min(r.hit_ns, ns_per(t0, n));
+        r.ok = r.ok && found == n;
+
+        found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) found += s->find(pair_key(&miss[i * 12])) != s->end();
+        r.miss_ns = std::min(r.miss_ns, ns_per(t0, n));
+        r.ok = r.ok && found == 0;
+
+        delete s;
+    }
+    return r;
+}
+
+static OpResult bench_ssids_table(size_t n, int passes, const std::vector<uint8_t>& hit,
+                                  const std::vector<uint8_t>& miss, uint32_t* evictions) {
+    typedef MacTable<6, SsidEntry> Table;
+    OpResult r;
+    const uint32_t cap = table_capacity(n);
+    char ssid[33];
+    for (int p = 0; p < passes; ++p) {
+        size_t h0 = heap_in_use();
+        uint64_t a0 = allocs_now();
+        void* storage = malloc(Table::storage_bytes(cap));
+        Table t;
+        t.begin(storage, cap);
+
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            SsidEntry* e = t.insert(&hit[i * 6]);
+            random_ssid(ssid, i);
+            size_t len = strlen(ssid);
+            memcpy(e->ssid, ssid, len);
+            e->ssid[len] = '\0';
+        }
+        r.insert_ns = std::min(r.insert_ns, ns_per(t0, n));
+        r.allocs_per_insert = (double)(allocs_now() - a0) / n;
+        r.bytes_per_entry = (double)(heap_in_use() - h0) / n;
+
+        size_t found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            const SsidEntry* e = t.find(&hit[i * 6]);
+            found += e && e->ssid[0];
+        }
+        r.hit_ns = std::min(r.hit_ns, ns_per(t0, n));
+        r.ok = r.ok && found == n;
+
+        found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) found += t.find(&miss[i * 6]) != nullptr;
+        r.miss_ns = std::min(r.miss_ns, ns_per(t0, n));
+        r.ok = r.ok && found == 0;
+
+        *evictions = t.total_evictions();
+        free(storage);
+    }
+    return r;
+}
+
+static OpResult bench_ssids_map(size_t n, int passes, const std::vector<uint8_t>& hit,
+                                const std::vector<uint8_t>& miss) {
+    OpResult r;
+    char ssid[33];
+    for (int p = 0; p < passes; ++p) {
+        size_t h0 = heap_in_use();
+        uint64_t a0 = allocs_now();
+        std::map<String, String>* m = new std::map<String, String>();
+
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            random_ssid(ssid, i);
+            (*m)[mac_hex(&hit[i * 6])] = String(ssid);
+        }
+        r.insert_ns = std::min(r.insert_ns, ns_per(t0, n));
+        r.allocs_per_insert = (double)(allocs_now() - a0) / n;
+        r.bytes_per_entry = (double)(heap_in_use() - h0) / n;
+
+        size_t found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            auto it = m->find(mac_hex(&hit[i * 6]));
+            found += it != m->end() && it->second.length() > 0;
+        }
+        r.hit_ns = std::min(r.hit_ns, ns_per(t0, n));
+        r.ok = r.ok && found == n;
+
+        found = 0;
+        t0 = Clock::now();
+        for (size_t i = 0; i < n; ++i) found += m->find(mac_hex(&miss[i * 6])) != m->end();
+        r.miss_ns = std::min(r.miss_ns, ns_per(t0, n));
+        r.ok = r.ok && found == 0;
+
+        delete m;
+    }
+    return r;
+}
+
+static void print_row(const char* name, const OpResult& r, bool json, bool last) {
+    if (json) {
+        printf("\"%s\":{\"insert_ns\":%.1f,\"hit_ns\":%.1f,\"miss_ns\":%.1f,"
+               "\"allocs_per_insert\":%.2f,\"bytes_per_entry\":%.1f}%s",
+               name, r.insert_ns, r.hit_ns, r.miss_ns, r.allocs_per_insert, r.bytes_per_entry,
+               last ? "" : ",");
+    } else {
+        printf("  %-22s %8.1f %8.1f %8.1f %8.2f %10.1f\n", name, r.insert_ns, r.hit_ns,
+               r.miss_ns, r.allocs_per_insert, r.bytes_per_entry);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes = {10000, 100000};
+    int passes = 3;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--sizes" && has) {
+            sizes.clear();
+            for (char* p = argv[++i]; *p;) {
+                sizes.push_back(strtoul(p, &p, 10));
+                if (*p == ',') ++p;
+            }
+        } else if (a == "--passes" && has) {
+            passes = std::max(1, atoi(argv[++i]));
+        } else if (a == "--json") {
+            json = true;
+        } else {
+            fprintf(stderr, "uso: %s [--sizes 10000,100000] [--passes N] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (size_t si = 0; si < sizes.size(); ++si) {
+        const size_t n = sizes[si];
+        if (n == 0) continue;
+        std::vector<uint8_t> hit12, miss12, hit6, miss6;
+        make_keys(n, 12, &hit12, &miss12);
+        make_keys(n, 6, &hit6, &miss6);
+
+        uint32_t ev_hs = 0, ev_ssid = 0;
+        OpResult hs_table = bench_handshakes_table(n, passes, hit12, miss12, &ev_hs);
+        OpResult hs_set = bench_handshakes_set(n, passes, hit12, miss12);
+        OpResult ssid_table = bench_ssids_table(n, passes, hit6, miss6, &ev_ssid);
+        OpResult ssid_map = bench_ssids_map(n, passes, hit6, miss6);
+        const uint32_t cap = table_capacity(n);
+
+        if (json) {
+            printf("{\"entries\":%zu,\"capacity\":%u,", n, cap);
+            print_row("handshakes_mac_table", hs_table, true, false);
+            print_row("handshakes_std_set", hs_set, true, false);
+            print_row("ssids_mac_table", ssid_table, true, false);
+            print_row("ssids_std_map", ssid_map, true, true);
+            printf("}\n");
+        } else {
+            printf("[MACTABLE] %zu entradas (MacTable com %u slots, %.0f%% ocupada)\n", n, cap,
+                   100.0 * n / cap);
+            printf("  %-22s %8s %8s %8s %8s %10s\n", "", "ins ns", "hit ns", "miss ns",
+                   "allocs", "bytes/ent");
+            print_row("handshakes MacTable", hs_table, false, false);
+            print_row("handshakes std::set", hs_set, false, false);
+            print_row("ssids MacTable", ssid_table, false, false);
+            print_row("ssids std::map", ssid_map, false, false);
+        }
+
+        check(hs_table.ok && ssid_table.ok, "MacTable: busca errada", n);
+        check(hs_set.ok && ssid_map.ok, "std::set/map: busca errada", n);
+        check(ev_hs == 0 && ev_ssid == 0, "MacTable despejou entradas abaixo de 50%", n);
+    }
+    fflush(stdout);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+"""
+sanitize_link.py - Repete no link os -fsanitize=... do build_flags
+
+extra_script (post:) do env native_dot11_fuzz: o PlatformIO só passa o
+build_flags para o compilador, e sem o -fsanitize no link faltam as
+bibliotecas do ASan/UBSan.
+"""
+
+Import("env")  # noqa: F821
+
+env.Append(LINKFLAGS=[f for f in env.get("CCFLAGS", [])  # noqa: F821
+                      if str(f).startswith("-fsanitize")])
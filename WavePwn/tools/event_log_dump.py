@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+event_log_dump.py - Lê o anel de eventos do WavePwn
+
+Decodifica /sd/lab_logs/events.ring (ver src/utils/event_log.h) e imprime
+os eventos em ordem de seq, do mais antigo ainda no anel ao último gravado,
+no mesmo formato "tempo;origem;texto" dos antigos arquivos .log do lab.
+Segmentos sem cabeçalho válido são ignorados; um registro com CRC errado ou
+fora de sequência (resto de uma volta anterior ou write cortado) encerra o
+segmento.
+
+Uso:
+    $ python3 tools/event_log_dump.py /media/sd/lab_logs/events.ring
+    $ python3 tools/event_log_dump.py events.ring --since 1200 --jsonl
+"""
+
+import argparse
+import json
+import pathlib
+import struct
+import sys
+import zlib
+
+
+SEGMENT_HEADER = struct.Struct("<4sHHII")
+RECORD_HEADER = struct.Struct("<IIBBH")
+
+MAGIC = b"WPEL"
+VERSION = 1
+SEGMENT_SIZE = 64 * 1024
+
+FLAG_EPOCH = 0x01
+SOURCES = {0: "system", 1: "lab", 2: "web"}
+
+
+def read_segment(data: bytes, base: int):
+    """Primeiro seq e registros (seq, tempo, origem, flags, texto) do segmento."""
+    magic, version, header_len, first_seq, crc = SEGMENT_HEADER.unpack_from(data, base)
+    if magic != MAGIC or version != VERSION or crc != zlib.crc32(data[base:base + 12]):
+        return None, []
+
+    records = []
+    seq = first_seq
+    off = header_len
+    while off + RECORD_HEADER.size + 4 <= SEGMENT_SIZE:
+        rseq, t, source, flags, length = RECORD_HEADER.unpack_from(data, base + off)
+        total = RECORD_HEADER.size + ((length + 3) & ~3) + 4
+        if rseq != seq or off + total > SEGMENT_SIZE:
+            break
+        head = data[base + off:base + off + RECORD_HEADER.size]
+        text = data[base + off + RECORD_HEADER.size:base + off + RECORD_HEADER.size + length]
+        (crc,) = struct.unpack_from("<I", data, base + off + total - 4)
+        if crc != zlib.crc32(head + text):
+            break
+        records.append((rseq, t, source, flags, text.decode("utf-8", "replace")))
+        seq += 1
+        off += total
+    return first_seq, records
+
+
+def read_ring(path: pathlib.Path):
+    data = path.read_bytes()
+    segments = []
+    for base in range(0, len(data) - SEGMENT_SIZE + 1, SEGMENT_SIZE):
+        first, records = read_segment(data, base)
+        if first is not None:
+            segments.append((first, records))
+
+    # Segmentos começam onde o anterior terminou: ordenar pelo primeiro seq
+    # dá a ordem do anel, a partir do mais antigo
+    segments.sort(key=lambda s: s[0])
+    events = []
+    for first, records in segments:
+        if events and first != events[-1][0] + 1:
+            print(f"[dump] buraco de seq {events[-1][0] + 1}..{first - 1}", file=sys.stderr)
+        events.extend(records)
+    return events
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("ring", type=pathlib.Path)
+    ap.add_argument("--since", type=int, default=0, help="só eventos com seq >= N")
+    ap.add_argument("--jsonl", action="store_true", help="um objeto JSON por linha")
+    args = ap.parse_args()
+
+    events = read_ring(args.ring)
+    for seq, t, source, flags, text in events:
+        if seq < args.since:
+            continue
+        name = SOURCES.get(source, "?")
+        if args.jsonl:
+            print(json.dumps({"seq": seq, "t": t, "epoch": bool(flags & FLAG_EPOCH),
+                              "src": name, "text": text}, ensure_ascii=False))
+        else:
+            print(f"{seq} {t}{'' if flags & FLAG_EPOCH else 's'};{name};{text}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
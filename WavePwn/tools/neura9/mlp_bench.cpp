@@ -0,0 +1,131 @@
+/*
+  mlp_bench.cpp - MLP de ponto fixo da NEURA9 (src/neura9/mlp.h) no host
+
+  Roda o FixedMlp do neura9/mlp_model.h (ou do header em
+  -DNEURA9_MLP_MODEL_HEADER) sobre as linhas de um CSV do dataset
+  (f0..f71,label, com cabeçalho) e:
+
+    padrão   mede us por inferência (melhor e média de --passes passadas
+             pelo CSV inteiro) e imprime os bytes do modelo em flash
+    --dump   imprime, por linha, a classe e os logits int16 — o que o
+             tools/neura9/mlp_check.py compara com o numpy do trainer e
+             com o modelo TFLite
+
+  Uso:
+    pio run -e native_mlp
+    .pio/build/native_mlp/program [--passes N] [--json] [--dump] dataset.csv
+*/
+
+#ifndef NEURA9_MLP_MODEL_HEADER
+#define NEURA9_MLP_MODEL_HEADER "neura9/mlp_model.h"
+#endif
+#include NEURA9_MLP_MODEL_HEADER
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef neura9_mlp::Model Model;
+typedef std::chrono::steady_clock Clock;
+
+static const Model mlp(neura9_mlp::INPUT_CENTER, neura9_mlp::INPUT_INV_SCALE, neura9_mlp::LAYERS,
+                       neura9_mlp::OUTPUT_SCALE);
+
+// Linhas f0..f(kInputs-1); o label (última coluna) é ignorado. Os valores
+// passam por double como no np.loadtxt do trainer.
+static bool load_csv(const char* path, std::vector<float>* rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[8192];
+    bool header = true;
+    while (fgets(line, sizeof(line), f)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        const char* p = line;
+        int n = 0;
+        for (; n < Model::kInputs && *p && *p != '\n'; ++n) {
+            char* end;
+            rows->push_back(static_cast<float>(strtod(p, &end)));
+            p = *end == ',' ? end + 1 : end;
+        }
+        if (n != Model::kInputs) {
+            rows->resize(rows->size() - n);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int passes = 20;
+    bool json = false;
+    bool dump = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--passes" && has) passes = std::max(1, atoi(argv[++i]));
+        else if (a == "--json") json = true;
+        else if (a == "--dump") dump = true;
+        else if (a[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "uso: %s [--passes N] [--json] [--dump] dataset.csv\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<float> rows;
+    if (!load_csv(path, &rows) || rows.empty()) {
+        fprintf(stderr, "[MLP] sem linhas de %d features em %s\n", Model::kInputs, path);
+        return 1;
+    }
+    const size_t n = rows.size() / Model::kInputs;
+
+    if (dump) {
+        int16_t logits[Model::kOutputs];
+        float conf;
+        for (size_t r = 0; r < n; ++r) {
+            int cls = mlp.run(&rows[r * Model::kInputs], &conf, logits);
+            printf("%d", cls);
+            for (int k = 0; k < Model::kOutputs; ++k) printf(" %d", logits[k]);
+            printf("\n");
+        }
+        return 0;
+    }
+
+    double best_us = 1e30, total_us = 0;
+    unsigned checksum = 0;
+    for (int p = 0; p < passes; ++p) {
+        float conf;
+        Clock::time_point t0 = Clock::now();
+        for (size_t r = 0; r < n; ++r) {
+            checksum += mlp.run(&rows[r * Model::kInputs], &conf);
+        }
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / n;
+        best_us = std::min(best_us, us);
+        total_us += us;
+    }
+
+    if (json) {
+        printf("{\"rows\":%zu,\"passes\":%d,\"layers\":%d,\"model_bytes\":%zu,"
+               "\"us_best\":%.3f,\"us_mean\":%.3f,\"placeholder\":%s,\"checksum\":%u}\n",
+               n, passes, Model::kLayers, Model::kModelBytes, best_us, total_us / passes,
+               NEURA9_MLP_PLACEHOLDER ? "true" : "false", checksum);
+    } else {
+        printf("[MLP] %zu linhas x %d passadas, %d camadas, %zu bytes de modelo%s\n", n, passes,
+               Model::kLayers, Model::kModelBytes,
+               NEURA9_MLP_PLACEHOLDER ? " (placeholder)" : "");
+        printf("[MLP] %.3f us/inferencia (melhor), %.3f us (media)\n", best_us, total_us / passes);
+    }
+    return 0;
+}
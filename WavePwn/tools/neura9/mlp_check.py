@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+mlp_check.py - Confere o MLP de ponto fixo da NEURA9 contra o modelo treinado
+
+Roda o mlp_bench (env native_mlp, compilado com o neura9/mlp_model.h
+gerado pelo trainer) sobre o dataset e confere:
+
+    bit a bit   classe e logits int16 de cada linha iguais aos do
+                mlp_fixed_predict() do ai/neura9_trainer.py (mesmo
+                ai/neura9_mlp.npz que gerou o header)
+    argmax      a classe de cada linha igual à do modelo de referência:
+                o .tflite em --tflite (interpretador do TensorFlow, entrada
+                quantizada como no firmware) ou, sem ele, o forward float
+                dos pesos Keras guardados no .npz
+
+Imprime também us por inferência e bytes do modelo (mlp_bench --json) e,
+com --tflite, o tamanho do .tflite para comparar. Sai com 1 se algo
+falhar; as linhas divergentes saem com a margem top-1/top-2 da referência.
+
+Uso:
+    $ python3 ai/neura9_trainer.py --mlp-header src/neura9/mlp_model.h
+    $ pio run -e native_mlp
+    $ python3 tools/neura9/mlp_check.py ai/dataset/neura9_dataset.csv
+    $ python3 tools/neura9/mlp_check.py dataset.csv --tflite modelo_float32.tflite
+"""
+
+import argparse
+import importlib.util
+import json
+import os
+import pathlib
+import subprocess
+import sys
+
+import numpy as np
+
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.join(HERE, "..", "..")
+
+
+def load_trainer():
+    path = os.path.join(ROOT, "ai", "neura9_trainer.py")
+    spec = importlib.util.spec_from_file_location("neura9_trainer", path)
+    mod = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(mod)
+    return mod
+
+
+def run_dump(bench: str, dataset: pathlib.Path):
+    out = subprocess.run([bench, "--dump", str(dataset)], check=True,
+                         capture_output=True, text=True).stdout
+    rows = np.array([[int(v) for v in line.split()] for line in out.splitlines()])
+    return rows[:, 0], rows[:, 1:]
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("dataset", type=pathlib.Path, nargs="?",
+                    default=pathlib.Path(ROOT) / "ai" / "dataset" / "neura9_dataset.csv")
+    ap.add_argument("--bench", default=os.path.join(ROOT, ".pio", "build", "native_mlp", "program"))
+    ap.add_argument("--npz", type=pathlib.Path,
+                    default=pathlib.Path(ROOT) / "ai" / "neura9_mlp.npz")
+    ap.add_argument("--tflite", type=pathlib.Path, help="modelo de referência (precisa de TensorFlow)")
+    ap.add_argument("--passes", type=int, default=20)
+    args = ap.parse_args()
+
+    trainer = load_trainer()
+    x, _ = trainer.load_dataset(args.dataset)
+    layers, q = trainer.load_mlp_npz(args.npz)
+    failures = 0
+
+    cls, logits = run_dump(args.bench, args.dataset)
+    if len(cls) != len(x):
+        print(f"[MLP] mlp_bench leu {len(cls)} linhas, dataset tem {len(x)}")
+        return 1
+
+    np_cls, np_logits = trainer.mlp_fixed_predict(q, x)
+    exact = int((np_logits == logits).all(axis=1).sum())
+    print(f"[MLP] C++ x numpy (mlp_fixed_predict): {exact}/{len(x)} linhas com logits iguais")
+    if exact != len(x) or (np_cls != cls).any():
+        failures += 1
+
+    if args.tflite:
+        ref = trainer.tflite_predict(args.tflite.read_bytes(), x)
+        ref_name = args.tflite.name
+    else:
+        ref = trainer.mlp_float_forward(layers, x)[-1]
+        ref_name = "float64 (pesos do .npz)"
+    ref_cls = ref.argmax(axis=1)
+    diff = np.nonzero(ref_cls != cls)[0]
+    print(f"[MLP] argmax igual ao {ref_name}: {len(x) - len(diff)}/{len(x)}")
+    for i in diff[:20]:
+        top = np.sort(ref[i])[::-1]
+        print(f"    linha {i}: ref={ref_cls[i]} mlp={cls[i]} margem ref={top[0] - top[1]:.6f}")
+    if len(diff):
+        failures += 1
+
+    out = subprocess.run([args.bench, "--json", "--passes", str(args.passes), str(args.dataset)],
+                         check=True, capture_output=True, text=True).stdout
+    bench = json.loads(out)
+    sizes = "x".join(str(s) for s in q["sizes"])
+    line = (f"[MLP] {sizes}: {bench['us_best']:.3f} us/inferencia no host "
+            f"(media {bench['us_mean']:.3f}), {bench['model_bytes']} bytes de modelo em flash")
+    if args.tflite:
+        line += f" (.tflite: {args.tflite.stat().st_size} bytes)"
+    print(line)
+
+    print("[MLP] verificacao", "FALHOU" if failures else "ok")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
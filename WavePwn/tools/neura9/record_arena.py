@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+record_arena.py - Grava a arena medida da NEURA9 em src/neura9/model_arena.h
+
+Com um modelo novo (CRC diferente do gravado), o Neura9::begin() monta o
+interpretador numa arena de sonda, lê arena_used_bytes() e loga:
+
+    [NEURA9] arena medida: used=5312 crc=1a2b3c4d len=21480 (...)
+
+Este script lê essa linha (log do monitor serial, arquivo ou stdin) e gera
+o cabeçalho; no próximo build o begin() aloca direto o tamanho exato, sem
+a sonda de 160 KB. Com --model, confere se o log é mesmo do .tflite que
+vai para o firmware (mesmo CRC-32 e tamanho).
+
+Uso:
+    $ pio device monitor | tee boot.txt       # reinicia o dispositivo
+    $ python3 tools/neura9/record_arena.py boot.txt \\
+          --model ai/neura9_defense_model.tflite
+"""
+
+import argparse
+import pathlib
+import re
+import sys
+import zlib
+
+LINE = re.compile(r"\[NEURA9\] arena medida: used=(\d+) crc=([0-9a-fA-F]{8}) len=(\d+)")
+HEADER = pathlib.Path(__file__).resolve().parents[2] / "src" / "neura9" / "model_arena.h"
+
+TEMPLATE = """#pragma once
+
+// Arena medida para o modelo em ai/neura9_defense_model_data.cpp.
+// Gerado por tools/neura9/record_arena.py a partir da linha
+// "[NEURA9] arena medida: ..." do boot; não editar à mão.
+//
+// Com CRC diferente do modelo embutido (modelo novo), o begin() mede de
+// novo com uma arena de sonda e loga o valor a gravar aqui.
+#define NEURA9_ARENA_MODEL_CRC 0x{crc:08x}u
+#define NEURA9_ARENA_MODEL_LEN {length}
+#define NEURA9_ARENA_BYTES     {used}
+"""
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("log", nargs="?", type=pathlib.Path, help="log do boot (padrão: stdin)")
+    ap.add_argument("--model", type=pathlib.Path, help=".tflite embutido no firmware")
+    ap.add_argument("--output", type=pathlib.Path, default=HEADER)
+    args = ap.parse_args()
+
+    text = args.log.read_text(errors="replace") if args.log else sys.stdin.read()
+    found = LINE.findall(text)
+    if not found:
+        print("[arena] nenhuma linha \"[NEURA9] arena medida\" no log", file=sys.stderr)
+        return 1
+    used, crc, length = int(found[-1][0]), int(found[-1][1], 16), int(found[-1][2])
+
+    if args.model:
+        data = args.model.read_bytes()
+        if zlib.crc32(data) != crc or len(data) != length:
+            print(f"[arena] o log é de outro modelo (crc {crc:08x}, {length} bytes; "
+                  f"{args.model}: {zlib.crc32(data):08x}, {len(data)} bytes)", file=sys.stderr)
+            return 1
+
+    args.output.write_text(TEMPLATE.format(crc=crc, length=length, used=used))
+    print(f"[arena] {args.output}: {used} bytes para o modelo {crc:08x} ({length} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
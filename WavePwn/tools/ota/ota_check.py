@@ -0,0 +1,299 @@
+#!/usr/bin/env python3
+"""
+ota_check.py - Confere e mede o OTA retomável no host
+
+Sobe o ota_server (env native_ota: src/web/ota_http + src/utils/ota_secure
++ task ota_flash sobre uma flash simulada com tempos de datasheet) com uma
+imagem de teste de 3 MB assinada por tools/ota/test_key.pem e confere:
+
+    antigo      POST /legacy/firmware: Update.write() no handler (referência)
+    novo        /ota/begin + /ota/chunk: imagem em ota_1 igual byte a byte,
+                boot trocado, nenhuma gravação sobre byte não apagado
+    retomada    conexões derrubadas no meio dos pedaços e um cliente novo
+                no meio do envio: termina com a imagem certa
+    delta       ota_0 com a build antiga, patch de tools/ota/ota_delta.py:
+                ota_1 igual byte a byte à build nova (também com conexões
+                derrubadas); patch contra outra base -> failed (base)
+    assinatura  manifesto adulterado ou sem assinatura -> 403
+    hash        manifesto de outra imagem -> failed (sha256), boot não muda
+
+O cliente limita a vazão (--rate, padrão 600 KB/s, ordem de grandeza de um
+upload HTTP pelo SoftAP do ESP32-S3). Para cada caminho imprime o tempo
+total, a vazão, o maior tempo dentro de um handler HTTP (a task do AsyncTCP
+parada) e a maior operação de flash (o outro core parado com o cache
+desligado). Sai com 1 se algo falhar.
+
+As duas "builds" do delta são sintéticas (código deslocado por uma função
+nova, endereços relocados, trecho removido); --old/--new usam duas builds
+de verdade (o primeiro byte vira 0xE9 se precisar).
+
+Uso:
+    $ pio run -e native_ota
+    $ python3 tools/ota/ota_check.py [--server caminho/ota_server] [--json]
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import random
+import re
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+
+import ota_delta   # noqa: E402
+import ota_sign    # noqa: E402
+import ota_upload  # noqa: E402
+
+TEST_KEY = os.path.join(HERE, "test_key.pem")
+
+
+def make_image(size, seed):
+    rng = random.Random(seed)
+    image = bytearray(rng.randbytes(size))
+    image[0] = 0xE9   # magic do cabeçalho de imagem do ESP32
+    return bytes(image)
+
+
+def make_build_pair(size, seed):
+    """(antiga, nova) parecidas como duas builds seguidas do firmware."""
+    rng = random.Random(seed)
+    old = bytearray(make_image(size, seed))
+    new = bytearray(old)
+    # Função nova no meio: tudo depois desloca 2 KB
+    at = size * 3 // 10
+    new[at:at] = rng.randbytes(2048)
+    # Trecho removido mais adiante
+    cut = size * 6 // 10
+    del new[cut:cut + 1024]
+    # Endereços relocados: uma palavra a cada ~256 bytes depois da inserção
+    for pos in range(at + 2048, len(new) - 4, 256):
+        word = int.from_bytes(new[pos:pos + 4], "little")
+        new[pos:pos + 4] = ((word + 2048) & 0xFFFFFFFF).to_bytes(4, "little")
+    # Versão e data da build no começo
+    new[32:96] = rng.randbytes(64)
+    return bytes(old), bytes(new[:size]) if len(new) > size else bytes(new)
+
+
+def read_build(path):
+    with open(path, "rb") as f:
+        image = bytearray(f.read())
+    image[0] = 0xE9
+    return bytes(image)
+
+
+class Server:
+    def __init__(self, path, flash):
+        self.proc = subprocess.Popen([path, "--port", "0", "--flash", flash],
+                                     stdout=subprocess.PIPE, text=True)
+        banner = self.proc.stdout.readline()
+        self.port = int(re.search(r":(\d+)/", banner).group(1))
+
+    def client(self, rate):
+        return ota_upload.Client("127.0.0.1", self.port, "admin", "wavepwn", rate_kbps=rate)
+
+    def close(self):
+        self.proc.kill()
+        self.proc.wait()
+
+
+def host_get(client, path):
+    return client.request("GET", path)[1]
+
+
+def measure(name, fn, client, image):
+    client.request("POST", "/host/reset")
+    client.bytes_sent = 0
+    t0 = time.monotonic()
+    result = fn()
+    dt = time.monotonic() - t0
+    stats = host_get(client, "/host/stats")
+    img = host_get(client, "/host/image?size=%d" % len(image))
+    return {
+        "path": name,
+        "result": result,
+        "seconds": round(dt, 2),
+        "kb_per_s": round(len(image) / 1024 / dt),
+        "http_handler_max_ms": round(stats["http"]["handler_us_max"] / 1000, 1),
+        "http_handler_total_ms": round(stats["http"]["handler_us_total"] / 1000),
+        "flash_busy_ms": round(stats["flash"]["busy_us"] / 1000),
+        "flash_max_op_ms": round(stats["flash"]["max_op_us"] / 1000, 1),
+        "sector_erases": stats["flash"]["sector_erases"],
+        "block_erases": stats["flash"]["block_erases"],
+        "dirty_writes": stats["flash"]["dirty_writes"],
+        "image_ok": img["sha256"] == hashlib.sha256(image).hexdigest(),
+        "boot": img["boot"],
+        "bytes_sent": client.bytes_sent,
+        "image_size": len(image),
+    }
+
+
+def run_legacy(args, image):
+    srv = Server(args.server, args.flash)
+    try:
+        c = srv.client(args.rate)
+        c.timeout = 600
+        r = measure("antigo", lambda: c.request("POST", "/legacy/firmware", image)[0], c, image)
+        r["ok"] = r["result"] == 200 and r["image_ok"] and r["boot"] == "ota_1"
+        return r
+    finally:
+        srv.close()
+
+
+def run_new(args, image, manifest, name="novo", drop_every=0, restart_at=None):
+    srv = Server(args.server, args.flash)
+    try:
+        c = srv.client(args.rate)
+
+        def go():
+            if restart_at:
+                # Cliente "morre" no meio; outro retoma com o mesmo manifesto
+                ota_upload.upload(c, image, manifest, drop_every=drop_every, stop_at=restart_at)
+            st = ota_upload.upload(c, image, manifest, drop_every=drop_every)
+            return st["state"], st["error"]
+
+        r = measure(name, go, c, image)
+        r["ok"] = (r["result"] == ("ready", None) and r["image_ok"] and r["boot"] == "ota_1"
+                   and r["dirty_writes"] == 0)
+        return r
+    finally:
+        srv.close()
+
+
+def run_delta(args, old, new, manifest, patch, name="delta", drop_every=0):
+    srv = Server(args.server, args.flash)
+    try:
+        c = srv.client(args.rate)
+        c.timeout = 120
+        c.request("POST", "/host/base", old)
+
+        def go():
+            st = ota_upload.upload(c, patch, manifest, drop_every=drop_every)
+            return st["state"], st["error"]
+
+        r = measure(name, go, c, new)
+        r["ok"] = (r["result"] == ("ready", None) and r["image_ok"] and r["boot"] == "ota_1"
+                   and r["dirty_writes"] == 0)
+        return r
+    finally:
+        srv.close()
+
+
+def check_delta(args, old, new, manifest, patch, errors):
+    if ota_delta.apply(old, patch) != new:
+        errors.append("delta: ota_delta.apply não reconstrói a build nova")
+    r = run_delta(argparse.Namespace(server=args.server, flash="instant", rate=0),
+                  old, new, manifest, patch, "delta+quedas", drop_every=3)
+    if not r["ok"]:
+        errors.append("delta com quedas: %s" % json.dumps(r))
+
+    # Patch de outra base: falha antes de gravar, boot não muda
+    srv = Server(args.server, "instant")
+    try:
+        c = srv.client(0)
+        c.request("POST", "/host/base", make_image(len(old), 9))
+        st = ota_upload.upload(c, patch, manifest)
+        img = host_get(c, "/host/image?size=%d" % len(new))
+        if st["state"] != "failed" or st["error"] != "base":
+            errors.append("delta: base errada terminou em %s/%s" % (st["state"], st["error"]))
+        if img["boot"] != "ota_0" or st["written"] != 0:
+            errors.append("delta: base errada gravou %d bytes / boot %s" % (st["written"], img["boot"]))
+    finally:
+        srv.close()
+
+
+def check_rejections(args, image, manifest, other, errors):
+    srv = Server(args.server, "instant")
+    try:
+        c = srv.client(0)
+
+        def begin(m):
+            q = "size=%d&sha256=%s&version=%s&sig=%s" % (m["size"], m["sha256"], m["version"], m["sig"])
+            return c.request("POST", "/ota/begin?" + q)[0]
+
+        forged = dict(manifest, version="9.9.9")
+        if begin(forged) != 403:
+            errors.append("assinatura: manifesto com versão trocada foi aceito")
+        if begin(dict(manifest, sig="")) != 403:
+            errors.append("assinatura: manifesto sem assinatura foi aceito")
+        if begin(dict(manifest, sha256="zz")) != 400:
+            errors.append("manifesto inválido não deu 400")
+        if begin(dict(manifest, size=64 << 20)) not in (403, 413):
+            errors.append("imagem maior que a partição não foi recusada")
+
+        # Manifesto (assinado) de `other`, bytes de `image`
+        st = ota_upload.upload(c, image, ota_sign.make_manifest(other, "2.0.1", TEST_KEY))
+        img = host_get(c, "/host/image?size=%d" % len(image))
+        if st["state"] != "failed" or st["error"] != "sha256":
+            errors.append("hash: imagem trocada terminou em %s/%s" % (st["state"], st["error"]))
+        if img["boot"] != "ota_0":
+            errors.append("hash: boot trocado mesmo com a imagem errada")
+
+        # Chunk fora de ordem: 409 com o offset certo
+        st = ota_upload.upload(c, image, manifest, stop_at=1)
+        code, resp = c.request("POST", "/ota/chunk?offset=0", image[:4096])
+        if code != 409 or resp.get("offset") != st["offset"]:
+            errors.append("offset: esperado 409 com offset %d, veio %d %s" % (st["offset"], code, resp))
+    finally:
+        srv.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--server", default=".pio/build/native_ota/program")
+    parser.add_argument("--size-mb", type=float, default=3)
+    parser.add_argument("--rate", type=int, default=600, help="KB/s do cliente (0 = sem limite)")
+    parser.add_argument("--flash", default="datasheet", choices=["datasheet", "instant"])
+    parser.add_argument("--old", help="build antiga (.bin) para o delta")
+    parser.add_argument("--new", help="build nova (.bin) para o delta")
+    parser.add_argument("--json", action="store_true")
+    args = parser.parse_args()
+
+    size = int(args.size_mb * (1 << 20))
+    image = make_image(size, 1)
+    other = make_image(size, 2)
+    manifest = ota_sign.make_manifest(image, "2.0.0", TEST_KEY)
+
+    if args.old and args.new:
+        old, new = read_build(args.old), read_build(args.new)
+    else:
+        old, new = make_build_pair(size, 3)
+    delta_manifest, patch = ota_sign.make_delta(old, new, "2.0.1", TEST_KEY)
+
+    errors = []
+    check_rejections(args, image, manifest, other, errors)
+    check_delta(args, old, new, delta_manifest, patch, errors)
+
+    runs = [
+        run_legacy(args, image),
+        run_new(args, image, manifest),
+        run_new(args, image, manifest, "retomada", drop_every=7, restart_at=size // 2),
+        run_new(args, new, ota_sign.make_manifest(new, "2.0.1", TEST_KEY), "inteiro"),
+        run_delta(args, old, new, delta_manifest, patch),
+    ]
+    for r in runs:
+        if not r["ok"]:
+            errors.append("%s: %s" % (r["path"], json.dumps(r)))
+
+    if args.json:
+        print(json.dumps(runs, indent=2))
+    else:
+        print("%-9s %8s %8s %14s %12s %12s %10s" % ("caminho", "tempo", "KB/s", "handler máx",
+                                                   "flash total", "flash máx", "enviado"))
+        for r in runs:
+            print("%-9s %7.1fs %8d %12.1fms %10dms %10.1fms %9.3fx" % (
+                r["path"], r["seconds"], r["kb_per_s"], r["http_handler_max_ms"],
+                r["flash_busy_ms"], r["flash_max_op_ms"], r["bytes_sent"] / r["image_size"]))
+
+    for e in errors:
+        print("FALHA: " + e, file=sys.stderr)
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
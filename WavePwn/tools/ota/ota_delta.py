@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+ota_delta.py - Patch do OTA delta (formato em src/utils/ota_delta.h)
+
+Gera o patch que transforma a imagem em execução (base) na nova, no
+estilo do bsdiff: acha trechos da nova que existem na base (índice de
+16 bytes a cada 8 posições da base), estende cada trecho para frente
+aceitando diferenças esparsas (endereços que mudaram com a relinkagem) e
+grava a diferença byte a byte; o que não casa vai como extra. O fluxo
+inteiro sai comprimido com deflate cru (zlib nível 9, janela de 32 KB).
+
+O firmware confere o SHA-256 da base antes de gravar qualquer byte, então
+o patch só serve para o dispositivo que roda exatamente `base`.
+
+Uso:
+    $ python3 tools/ota/ota_delta.py diff antigo.bin novo.bin -o novo.delta
+    $ python3 tools/ota/ota_delta.py apply antigo.bin novo.delta -o conferido.bin
+
+Para o manifesto e o envio, ver `ota_sign.py sign --base` e ota_upload.py.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b"WPD1"
+KEY = 16        # bytes da chave do índice
+STRIDE = 8      # posições da base indexadas
+SLACK = 64      # queda de pontuação que encerra um trecho aproximado
+
+
+def _index(base):
+    idx = {}
+    for i in range(0, len(base) - KEY + 1, STRIDE):
+        idx.setdefault(base[i:i + KEY], i)
+    return idx
+
+
+def _extend(new, base, i, p):
+    """Fim (exclusivo, em `new`) do trecho alinhado em new[i] ~ base[p]:
+    +1 por byte igual, -1 por diferente, corta no melhor ponto."""
+    n = min(len(new) - i, len(base) - p)
+    k = score = best = best_k = 0
+    while k < n:
+        if new[i + k:i + k + 64] == base[p + k:p + k + 64] and k + 64 <= n:
+            k += 64
+            score += 64
+        else:
+            score += 1 if new[i + k] == base[p + k] else -1
+            k += 1
+        if score > best:
+            best, best_k = score, k
+        elif score < best - SLACK:
+            break
+    return i + best_k
+
+
+def _matches(new, base):
+    """Trechos (início em new, início na base, fim em new), em ordem."""
+    idx = _index(base)
+    out = []
+    i = 0
+    prev = 0          # fim do trecho anterior em new
+    offset = None     # base - new do trecho anterior
+    while i <= len(new) - KEY:
+        key = new[i:i + KEY]
+        p = None
+        # Primeiro tenta o mesmo alinhamento do trecho anterior
+        if offset is not None and 0 <= i + offset <= len(base) - KEY and \
+                base[i + offset:i + offset + KEY] == key:
+            p = i + offset
+        else:
+            p = idx.get(key)
+        if p is None:
+            i += 1
+            continue
+        # Volta enquanto os bytes anteriores também casam
+        while i > prev and p > 0 and new[i - 1] == base[p - 1]:
+            i -= 1
+            p -= 1
+        end = _extend(new, base, i, p)
+        if end <= i:
+            i += 1
+            continue
+        out.append((i, p, end))
+        offset = p - i
+        prev = i = end
+    return out
+
+
+def diff(base, new, level=9):
+    """Patch (bytes) de `base` para `new`."""
+    raw = bytearray()
+    raw += MAGIC + struct.pack("<I", len(base)) + hashlib.sha256(base).digest()
+    raw += struct.pack("<I", len(new))
+
+    # Registro k: diff do trecho k-1, extra até o trecho k, seek até ele.
+    # O primeiro só tem extra; o último, sem trecho seguinte, seek 0 (e
+    # nem sai se não tiver nada: a imagem completa encerra o patch).
+    prev = (0, 0, 0)
+    for start, p, end in _matches(new, base) + [(len(new), None, len(new))]:
+        ps, pp, pe = prev
+        if p is None and pe - ps == 0 and start == pe:
+            break
+        after = pp + (pe - ps)
+        seek = p - after if p is not None else 0
+        raw += struct.pack("<IIi", pe - ps, start - pe, seek)
+        raw += bytes((new[ps + k] - base[pp + k]) & 0xFF for k in range(pe - ps))
+        raw += new[pe:start]
+        prev = (start, p, end)
+
+    c = zlib.compressobj(level, zlib.DEFLATED, -15, 9)
+    return c.compress(bytes(raw)) + c.flush()
+
+
+def apply(base, patch):
+    """Referência em Python do que o firmware faz; levanta ValueError."""
+    raw = zlib.decompress(patch, -15)
+    if raw[:4] != MAGIC:
+        raise ValueError("não é um patch WPD1")
+    base_size, = struct.unpack_from("<I", raw, 4)
+    base = base[:base_size]
+    if len(base) != base_size or hashlib.sha256(base).digest() != raw[8:40]:
+        raise ValueError("patch feito para outra base")
+    image_size, = struct.unpack_from("<I", raw, 40)
+    out = bytearray()
+    at = 44
+    pos = 0
+    while len(out) < image_size:
+        dlen, elen, seek = struct.unpack_from("<IIi", raw, at)
+        at += 12
+        out += bytes((raw[at + k] + base[pos + k]) & 0xFF for k in range(dlen))
+        at += dlen
+        pos += dlen
+        out += raw[at:at + elen]
+        at += elen
+        pos += seek
+    if len(out) != image_size or at != len(raw):
+        raise ValueError("patch inconsistente")
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("diff", help="gera o patch de base para nova")
+    p.add_argument("base")
+    p.add_argument("new")
+    p.add_argument("-o", "--output", required=True)
+    p = sub.add_parser("apply", help="aplica o patch (conferência no host)")
+    p.add_argument("base")
+    p.add_argument("patch")
+    p.add_argument("-o", "--output", required=True)
+    args = parser.parse_args()
+
+    with open(args.base, "rb") as f:
+        base = f.read()
+    if args.cmd == "diff":
+        with open(args.new, "rb") as f:
+            new = f.read()
+        patch = diff(base, new)
+        if apply(base, patch) != new:
+            sys.exit("patch não reconstrói a imagem (bug no ota_delta.py)")
+        with open(args.output, "wb") as f:
+            f.write(patch)
+        print("%s: %d bytes (%.1f%% de %d)" % (args.output, len(patch),
+                                              100.0 * len(patch) / len(new), len(new)))
+    else:
+        with open(args.patch, "rb") as f:
+            patch = f.read()
+        with open(args.output, "wb") as f:
+            f.write(apply(base, patch))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,180 @@
+// ota_server - rotas de OTA (src/web/ota_http + src/utils/ota_secure) no host
+//
+// Mesmas rotas de webserver_start() para /ota/*, com a task ota_flash real
+// (FreeRTOS do shim do replay) gravando numa flash simulada com tempos de
+// datasheet (tools/ota/shim/host_flash.h). Usado por tools/ota/ota_check.py.
+//
+// Rotas extras, só do host:
+//   POST /legacy/firmware   caminho antigo: Update.write() no handler HTTP
+//                           (apaga o setor e grava a cada 4 KB ali mesmo)
+//   GET  /host/stats        contadores da flash e tempo nos handlers
+//   GET  /host/image?size=N SHA-256 dos N primeiros bytes de ota_1 + boot
+//   POST /host/reset        zera os contadores
+//   POST /host/base         corpo vira a imagem em execução (ota_0), base
+//                           do OTA delta; sem tempo de flash
+//
+//   ota_server [--port N] [--flash datasheet|instant]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ESPAsyncWebServer.h>
+#include "esp_ota_ops.h"
+#include "host_flash.h"
+#include "utils/sha256.h"
+#include "web/ota_http.h"
+
+static const char* USER = "admin";
+static const char* PASS = "wavepwn";
+static const uint32_t PARTITION_SIZE = 8u * 1024 * 1024;
+
+// -----------------------------------------------------------------------------
+// Caminho antigo (ota_secure.cpp antes do anel): UpdateClass do Arduino
+// -----------------------------------------------------------------------------
+
+static struct {
+    uint8_t buf[4096];
+    size_t len;
+    size_t progress;
+    bool error;
+} legacy;
+
+// UpdateClass::_writeBuffer: apaga o setor e grava, no chamador
+static void legacy_flush() {
+    const esp_partition_t* part = esp_ota_get_next_update_partition(nullptr);
+    if (esp_partition_erase_range(part, legacy.progress, 4096) != ESP_OK ||
+        esp_partition_write(part, legacy.progress, legacy.buf, legacy.len) != ESP_OK) {
+        legacy.error = true;
+    }
+    legacy.progress += legacy.len;
+    legacy.len = 0;
+}
+
+static void legacy_body(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t) {
+    if (!request->authenticate(USER, PASS)) return;
+    if (index == 0) {
+        legacy.len = 0;
+        legacy.progress = 0;
+        legacy.error = false;
+    }
+    while (len > 0 && !legacy.error) {
+        size_t n = sizeof(legacy.buf) - legacy.len;
+        if (n > len) n = len;
+        memcpy(legacy.buf + legacy.len, data, n);
+        legacy.len += n;
+        data += n;
+        len -= n;
+        if (legacy.len == sizeof(legacy.buf)) legacy_flush();
+    }
+}
+
+// Update.end(true): resto do buffer e troca do boot
+static void legacy_done(AsyncWebServerRequest* request) {
+    if (!request->authenticate(USER, PASS)) {
+        request->requestAuthentication();
+        return;
+    }
+    if (legacy.len > 0) legacy_flush();
+    bool ok = !legacy.error &&
+              esp_ota_set_boot_partition(esp_ota_get_next_update_partition(nullptr)) == ESP_OK;
+    request->send(ok ? 200 : 500, "text/plain", ok ? "OTA OK, rebooting..." : "OTA FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// Rotas do host
+// -----------------------------------------------------------------------------
+
+static void handle_stats(AsyncWebServerRequest* request) {
+    HostFlashStats fs;
+    host_flash_get_stats(&fs);
+    HostAsyncStats hs;
+    host_async_get_stats(&hs);
+
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "{\"flash\":{\"sector_erases\":%u,\"block_erases\":%u,\"page_programs\":%u,"
+             "\"busy_us\":%llu,\"max_op_us\":%llu,\"dirty_writes\":%u},"
+             "\"http\":{\"handler_calls\":%llu,\"handler_us_total\":%llu,\"handler_us_max\":%llu}}",
+             fs.sector_erases, fs.block_erases, fs.page_programs,
+             (unsigned long long)fs.busy_us, (unsigned long long)fs.max_op_us, fs.dirty_writes,
+             (unsigned long long)hs.handler_calls, (unsigned long long)hs.handler_us_total,
+             (unsigned long long)hs.handler_us_max);
+    request->send(200, "application/json", buf);
+}
+
+static void handle_image(AsyncWebServerRequest* request) {
+    const AsyncWebParameter* p = request->getParam("size");
+    long size = p ? p->value().toInt() : 0;
+    if (size <= 0 || (uint32_t)size > PARTITION_SIZE) {
+        request->send(400, "application/json", "{\"error\":\"size\"}");
+        return;
+    }
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256(host_flash_data("ota_1"), (size_t)size, digest);
+    char hex[SHA256_DIGEST_LEN * 2 + 1];
+    for (int i = 0; i < SHA256_DIGEST_LEN; ++i) snprintf(hex + i * 2, 3, "%02x", digest[i]);
+
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"sha256\":\"%s\",\"boot\":\"%s\"}", hex, esp_ota_get_boot_partition()->label);
+    request->send(200, "application/json", buf);
+}
+
+static void base_body(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t) {
+    if (!host_flash_load("ota_0", index, data, len)) {
+        request->_tempObject = calloc(1, 1);   // marca de erro; liberado pelo request
+    }
+}
+
+static void handle_base(AsyncWebServerRequest* request) {
+    bool ok = request->_tempObject == nullptr;
+    request->send(ok ? 200 : 413, "application/json", ok ? "{}" : "{\"error\":\"size\"}");
+}
+
+static void handle_reset(AsyncWebServerRequest* request) {
+    host_flash_reset_stats();
+    host_async_reset_stats();
+    request->send(200, "application/json", "{}");
+}
+
+int main(int argc, char** argv) {
+    int port = 8080;
+    bool instant = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--flash") == 0 && i + 1 < argc) {
+            instant = strcmp(argv[++i], "instant") == 0;
+        } else {
+            fprintf(stderr, "uso: %s [--port N] [--flash datasheet|instant]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    host_flash_init(PARTITION_SIZE);
+    if (instant) {
+        HostFlashModel none = {0, 0, 0};
+        host_flash_set_model(none);
+    }
+
+    AsyncWebServer server((uint16_t)port);
+    ota_http_register(server, USER, PASS);
+    server.on("/legacy/firmware", HTTP_POST, legacy_done, nullptr, legacy_body);
+    server.on("/host/stats", HTTP_GET, handle_stats);
+    server.on("/host/image", HTTP_GET, handle_image);
+    server.on("/host/reset", HTTP_POST, handle_reset);
+    server.on("/host/base", HTTP_POST, handle_base, nullptr, base_body);
+    server.onNotFound([](AsyncWebServerRequest* request) {
+        request->send(404, "text/plain", "Not found");
+    });
+    server.begin();
+
+    printf("[OTA] rotas de OTA em http://127.0.0.1:%d/ (flash %s)\n", server.port(),
+           instant ? "instantânea" : "datasheet");
+    fflush(stdout);
+
+    for (;;) {
+        pause();
+    }
+}
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+ota_sign.py - Chaves e manifestos do OTA (src/utils/ota_secure)
+
+O firmware só aceita uma imagem cujo manifesto esteja assinado (ECDSA P-256
+sobre SHA-256) pela chave privada correspondente a src/utils/ota_pubkey.h.
+A mensagem assinada é
+
+    wavepwn-ota-v1 <tamanho> <sha256 da imagem em hex> <versão>
+
+Usa o `openssl` da linha de comando.
+
+Uso:
+    # uma vez: gera o par e reescreve src/utils/ota_pubkey.h
+    $ python3 tools/ota/ota_sign.py keygen --key ~/.wavepwn/ota_key.pem
+
+    # a cada build: manifesto ao lado do .bin
+    $ python3 tools/ota/ota_sign.py sign .pio/build/wavepwn_final/firmware.bin \\
+          --key ~/.wavepwn/ota_key.pem --version 2.1.0
+      -> firmware.bin.manifest.json
+
+    # delta contra a imagem que o dispositivo roda hoje (ota_delta.py)
+    $ python3 tools/ota/ota_sign.py sign novo/firmware.bin --base atual/firmware.bin \\
+          --key ~/.wavepwn/ota_key.pem --version 2.1.1
+      -> firmware.bin.delta + firmware.bin.manifest.json (com "patch")
+
+Sem --key, o manifesto sai sem assinatura (só aceito por firmware com
+ota_pubkey.h vazio compilado com -DOTA_ALLOW_UNSIGNED).
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+
+import ota_delta  # noqa: E402
+
+PUBKEY_HEADER = os.path.join(HERE, "..", "..", "src", "utils", "ota_pubkey.h")
+
+VERSION_RE = re.compile(r"^[A-Za-z0-9._+-]{1,31}$")
+
+
+def manifest_message(size, sha256_hex, version):
+    return ("wavepwn-ota-v1 %d %s %s" % (size, sha256_hex, version)).encode()
+
+
+def sign_message(message, key_path):
+    with tempfile.NamedTemporaryFile(delete=False) as f:
+        f.write(message)
+        msg_path = f.name
+    try:
+        return subprocess.run(["openssl", "dgst", "-sha256", "-sign", key_path, msg_path],
+                              check=True, capture_output=True).stdout
+    finally:
+        os.unlink(msg_path)
+
+
+def make_manifest(image, version, key_path=None):
+    """Manifesto (dict) de `image` (bytes)."""
+    if not VERSION_RE.match(version):
+        raise ValueError("versão inválida: use [A-Za-z0-9._+-], até 31 caracteres")
+    digest = hashlib.sha256(image).hexdigest()
+    sig = b""
+    if key_path:
+        sig = sign_message(manifest_message(len(image), digest, version), key_path)
+    return {"version": version, "size": len(image), "sha256": digest, "sig": sig.hex()}
+
+
+def make_delta(base, image, version, key_path=None):
+    """(manifesto, patch): a assinatura continua sendo da imagem final."""
+    patch = ota_delta.diff(base, image)
+    manifest = make_manifest(image, version, key_path)
+    manifest["patch"] = len(patch)
+    manifest["base_sha256"] = hashlib.sha256(base).hexdigest()
+    return manifest, patch
+
+
+def write_pubkey_header(pem, path=PUBKEY_HEADER):
+    lines = pem.strip().splitlines()
+    body = "\n".join('    "%s\\n"' % line for line in lines)
+    with open(path, "w") as f:
+        f.write("#pragma once\n\n"
+                "// Chave pública ECDSA P-256 (PEM) que assina os manifestos de OTA.\n"
+                "// `python3 tools/ota/ota_sign.py keygen` gera o par e reescreve este\n"
+                "// arquivo; a chave privada fica fora do repositório.\n"
+                "//\n"
+                "// Vazia: toda OTA é recusada (403), a não ser num build com\n"
+                "// -DOTA_ALLOW_UNSIGNED, que aceita manifestos sem assinatura.\n"
+                "static const char OTA_PUBKEY_PEM[] =\n%s;\n" % body)
+
+
+def cmd_keygen(args):
+    if os.path.exists(args.key):
+        sys.exit("%s já existe; apague antes para trocar a chave" % args.key)
+    os.makedirs(os.path.dirname(os.path.abspath(args.key)), exist_ok=True)
+    subprocess.run(["openssl", "ecparam", "-name", "prime256v1", "-genkey", "-noout",
+                    "-out", args.key], check=True)
+    os.chmod(args.key, 0o600)
+    pem = subprocess.run(["openssl", "ec", "-in", args.key, "-pubout"],
+                         check=True, capture_output=True, text=True).stdout
+    write_pubkey_header(pem, args.header)
+    print("chave privada: %s (guarde fora do repositório)" % args.key)
+    print("chave pública: %s" % os.path.relpath(args.header))
+
+
+def cmd_sign(args):
+    with open(args.image, "rb") as f:
+        image = f.read()
+    if args.base:
+        with open(args.base, "rb") as f:
+            manifest, patch = make_delta(f.read(), image, args.version, args.key)
+        with open(args.image + ".delta", "wb") as f:
+            f.write(patch)
+        print("%s.delta: %d bytes (%.1f%% da imagem)" % (args.image, len(patch),
+                                                         100.0 * len(patch) / len(image)))
+    else:
+        manifest = make_manifest(image, args.version, args.key)
+    out = args.output or args.image + ".manifest.json"
+    with open(out, "w") as f:
+        json.dump(manifest, f, indent=2)
+        f.write("\n")
+    print("%s: %d bytes, sha256 %s, %s" % (out, manifest["size"], manifest["sha256"][:16],
+                                          "assinado" if manifest["sig"] else "SEM assinatura"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("keygen", help="gera o par de chaves e reescreve ota_pubkey.h")
+    p.add_argument("--key", required=True, help="onde gravar a chave privada (PEM)")
+    p.add_argument("--header", default=PUBKEY_HEADER)
+    p.set_defaults(fn=cmd_keygen)
+
+    p = sub.add_parser("sign", help="gera o manifesto de uma imagem")
+    p.add_argument("image")
+    p.add_argument("--version", required=True)
+    p.add_argument("--key", help="chave privada (PEM); sem ela, manifesto sem assinatura")
+    p.add_argument("--base", help="imagem em execução no dispositivo: gera também o .delta")
+    p.add_argument("-o", "--output")
+    p.set_defaults(fn=cmd_sign)
+
+    args = parser.parse_args()
+    args.fn(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,10 @@
+#pragma once
+
+// Chave de TESTE do host (par de tools/ota/test_key.pem, público de
+// propósito). Só entra no build do ota_server via -DOTA_PUBKEY_HEADER;
+// o firmware usa src/utils/ota_pubkey.h.
+static const char OTA_PUBKEY_PEM[] =
+    "-----BEGIN PUBLIC KEY-----\n"
+    "MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEHDOlzvCD6gGeMb/QeJhQhtE8HH51\n"
+    "rz+2JRP6BNseL2uuRJa7nhOB2W4CcJSpVNExjlLpmZmqYb0pOKwvr0lkeg==\n"
+    "-----END PUBLIC KEY-----\n";
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+ota_upload.py - Envia um firmware pelo OTA retomável (/ota/begin, /ota/chunk)
+
+Manda o manifesto, depois a imagem (ou o patch delta, se o manifesto tiver
+"patch") em pedaços de 16 KB. Mantém no máximo
+uma janela (64 KB, o anel do firmware) ainda não gravada na flash, para
+não receber 503. Conexão caída, 409 ou 503: consulta /ota/status e
+continua do offset que o dispositivo já aceitou. Rodar de novo com o mesmo
+manifesto retoma de onde parou (enquanto o dispositivo não reiniciar).
+
+Uso:
+    $ python3 tools/ota/ota_sign.py sign firmware.bin --key K --version 2.1.0
+    $ python3 tools/ota/ota_upload.py firmware.bin firmware.bin.manifest.json \\
+          --host 192.168.4.1 --reboot
+
+    # delta: o .delta no lugar do .bin
+    $ python3 tools/ota/ota_sign.py sign novo.bin --base atual.bin --key K --version 2.1.1
+    $ python3 tools/ota/ota_upload.py novo.bin.delta novo.bin.manifest.json
+"""
+
+import argparse
+import base64
+import json
+import socket
+import sys
+import time
+
+
+CHUNK = 16 * 1024
+WINDOW = 64 * 1024
+
+
+class Dropped(Exception):
+    pass
+
+
+class Client:
+    def __init__(self, host, port, user, password, rate_kbps=0, timeout=30):
+        self.host = host
+        self.port = port
+        self.auth = base64.b64encode(("%s:%s" % (user, password)).encode()).decode()
+        self.rate = rate_kbps * 1024
+        self.timeout = timeout
+        self.bytes_sent = 0
+
+    def request(self, method, path, body=b"", drop_after=None):
+        """(código, json). drop_after: fecha o socket depois de N bytes do corpo."""
+        s = socket.create_connection((self.host, self.port), timeout=self.timeout)
+        try:
+            head = ("%s %s HTTP/1.1\r\nHost: %s\r\nAuthorization: Basic %s\r\n"
+                    "Content-Type: application/octet-stream\r\nContent-Length: %d\r\n"
+                    "Connection: close\r\n\r\n" % (method, path, self.host, self.auth, len(body)))
+            s.sendall(head.encode())
+            self._send_body(s, body, drop_after)
+            data = b""
+            while True:
+                part = s.recv(65536)
+                if not part:
+                    break
+                data += part
+        finally:
+            s.close()
+        head, _, payload = data.partition(b"\r\n\r\n")
+        if not head:
+            raise Dropped("sem resposta")
+        code = int(head.split(b" ", 2)[1])
+        try:
+            return code, json.loads(payload or b"{}")
+        except ValueError:
+            return code, {"raw": payload.decode(errors="replace")}
+
+    # Vazão limitada a `rate` (emula o SoftAP no teste do host)
+    def _send_body(self, s, body, drop_after):
+        t0 = time.monotonic()
+        sent = 0
+        while sent < len(body):
+            n = min(1460, len(body) - sent)
+            if drop_after is not None and sent + n > drop_after:
+                s.sendall(body[sent:drop_after])
+                self.bytes_sent += drop_after - sent
+                raise Dropped("conexão derrubada em %d bytes" % drop_after)
+            s.sendall(body[sent:sent + n])
+            sent += n
+            self.bytes_sent += n
+            if self.rate:
+                ahead = sent / self.rate - (time.monotonic() - t0)
+                if ahead > 0:
+                    time.sleep(ahead)
+
+    def status(self):
+        return self.request("GET", "/ota/status")[1]
+
+
+def upload(client, image, manifest, chunk=CHUNK, window=WINDOW, drop_every=0, stop_at=None, log=None):
+    """Envia `image` (o patch, num manifesto delta) e espera o estado final.
+    Devolve o status final (dict).
+
+    drop_every: derruba a conexão no meio de um a cada N pedaços (teste).
+    stop_at: para depois desse offset sem esperar o fim (teste de retomada).
+    """
+    q = "size=%d&sha256=%s&version=%s&sig=%s" % (manifest["size"], manifest["sha256"],
+                                                 manifest["version"], manifest["sig"])
+    if manifest.get("patch"):
+        q += "&patch=%d" % manifest["patch"]
+    code, resp = client.request("POST", "/ota/begin?" + q)
+    if code != 200:
+        raise RuntimeError("begin: HTTP %d %s" % (code, resp))
+    offset = resp["offset"]
+    if offset and log:
+        log("retomando em %d/%d" % (offset, len(image)))
+
+    buffered = 0
+    chunks = 0
+    while offset < len(image):
+        if stop_at is not None and offset >= stop_at:
+            return client.status()
+
+        # Janela: não mandar mais do que o anel do firmware ainda comporta
+        while buffered + chunk > window:
+            time.sleep(0.02)
+            st = client.status()
+            buffered = st["buffered"]
+            if st["state"] != "receiving":
+                return st
+
+        piece = image[offset:offset + chunk]
+        chunks += 1
+        drop = len(piece) // 2 if drop_every and chunks % drop_every == 0 else None
+        try:
+            code, resp = client.request("POST", "/ota/chunk?offset=%d" % offset, piece, drop)
+        except (Dropped, OSError) as e:
+            if log:
+                log("%s; consultando o status" % e)
+            time.sleep(0.05)
+            st = client.status()
+            offset, buffered = st["offset"], st["buffered"]
+            continue
+
+        offset = resp.get("offset", offset)
+        buffered = resp.get("buffered", buffered)
+        if code == 503:
+            time.sleep(0.05)
+        elif code == 409 and resp.get("error") != "offset":
+            return client.status()   # sessão falhou ou foi descartada
+        elif code not in (200, 409, 503):
+            raise RuntimeError("chunk: HTTP %d %s" % (code, resp))
+        if log and chunks % 32 == 0:
+            log("%d/%d bytes" % (offset, len(image)))
+
+    while True:
+        st = client.status()
+        if st["state"] not in ("receiving", "verifying"):
+            return st
+        time.sleep(0.05)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image", help=".bin, ou .delta com manifesto delta")
+    parser.add_argument("manifest")
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--user", default="admin")
+    parser.add_argument("--password", default="wavepwn")
+    parser.add_argument("--chunk", type=int, default=CHUNK)
+    parser.add_argument("--reboot", action="store_true", help="reinicia ao terminar")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    with open(args.manifest) as f:
+        manifest = json.load(f)
+    expected = manifest.get("patch") or manifest["size"]
+    if expected != len(image):
+        sys.exit("manifesto é de outro arquivo (%d != %d bytes)" % (expected, len(image)))
+
+    client = Client(args.host, args.port, args.user, args.password)
+    t0 = time.monotonic()
+    st = upload(client, image, manifest, chunk=args.chunk, log=lambda m: print("[OTA] " + m))
+    dt = time.monotonic() - t0
+    print("[OTA] %s em %.1f s (%.0f KB/s)%s" % (st["state"], dt, len(image) / 1024 / dt,
+                                              ", erro: %s" % st["error"] if st.get("error") else ""))
+    if st["state"] != "ready":
+        sys.exit(1)
+    if args.reboot:
+        try:
+            client.request("GET", "/reboot")
+        except (Dropped, OSError):
+            pass
+
+
+if __name__ == "__main__":
+    main()
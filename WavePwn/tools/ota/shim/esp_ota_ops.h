@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_partition.h"
+
+const esp_partition_t* esp_ota_get_running_partition();
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start);
+
+// Confere o magic 0xE9 do cabeçalho de imagem e marca a partição
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* part);
+const esp_partition_t* esp_ota_get_boot_partition();
@@ -0,0 +1,25 @@
+#pragma once
+
+// Shim das partições de app do ESP-IDF sobre uma flash NOR simulada em RAM
+// (tools/ota/shim/flash_sim.cpp): ota_0 (em execução) e ota_1.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_OTA_VALIDATE_FAILED 0x1503
+
+struct esp_partition_t {
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+};
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t offset, const void* src, size_t size);
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* dst, size_t size);
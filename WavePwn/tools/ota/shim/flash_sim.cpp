@@ -0,0 +1,202 @@
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "host_flash.h"
+#include "mbedtls/pk.h"
+
+#include <string.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+// -----------------------------------------------------------------------------
+// Flash NOR: apagar = 0xFF, gravar só leva bits de 1 para 0
+// -----------------------------------------------------------------------------
+
+static const uint32_t SECTOR = 4096;
+static const uint32_t BLOCK = 64 * 1024;
+static const uint32_t PAGE = 256;
+
+static esp_partition_t parts[2] = {
+    {0x10000, 0, "ota_0"},
+    {0x810000, 0, "ota_1"},
+};
+static std::vector<uint8_t> data[2];
+static const esp_partition_t* boot = &parts[0];
+
+static std::mutex flash_mutex;   // "cache desligado"
+static HostFlashModel model = {45000, 150000, 400};
+static HostFlashStats stats;
+
+static int index_of(const esp_partition_t* part) {
+    if (part == &parts[0]) return 0;
+    if (part == &parts[1]) return 1;
+    return -1;
+}
+
+static void flash_busy(uint64_t us) {
+    if (us) std::this_thread::sleep_for(std::chrono::microseconds(us));
+    stats.busy_us += us;
+    if (us > stats.max_op_us) stats.max_op_us = us;
+}
+
+void host_flash_init(uint32_t partition_size) {
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    for (int i = 0; i < 2; ++i) {
+        parts[i].size = partition_size;
+        data[i].assign(partition_size, 0xFF);
+    }
+    parts[1].address = parts[0].address + partition_size;
+    boot = &parts[0];
+}
+
+void host_flash_set_model(const HostFlashModel& m) {
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    model = m;
+}
+
+void host_flash_get_stats(HostFlashStats* out) {
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    *out = stats;
+}
+
+void host_flash_reset_stats() {
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    memset(&stats, 0, sizeof(stats));
+}
+
+const uint8_t* host_flash_data(const char* label) {
+    for (int i = 0; i < 2; ++i) {
+        if (strcmp(parts[i].label, label) == 0) return data[i].data();
+    }
+    return nullptr;
+}
+
+bool host_flash_load(const char* label, size_t offset, const void* src, size_t len) {
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    for (int i = 0; i < 2; ++i) {
+        if (strcmp(parts[i].label, label) != 0) continue;
+        if (offset + len > data[i].size()) return false;
+        memcpy(&data[i][offset], src, len);
+        return true;
+    }
+    return false;
+}
+
+// Como o esp_flash: blocos de 64 KB onde o intervalo permite, setores no resto
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t size) {
+    int i = index_of(part);
+    if (i < 0 || offset % SECTOR || size % SECTOR || offset + size > part->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t pos = offset;
+    while (pos < offset + size) {
+        std::lock_guard<std::mutex> lock(flash_mutex);
+        size_t step = (pos % BLOCK == 0 && offset + size - pos >= BLOCK) ? BLOCK : SECTOR;
+        memset(&data[i][pos], 0xFF, step);
+        if (step == BLOCK) {
+            stats.block_erases++;
+            flash_busy(model.block_erase_us);
+        } else {
+            stats.sector_erases++;
+            flash_busy(model.sector_erase_us);
+        }
+        pos += step;
+    }
+    return ESP_OK;
+}
+
+// Uma operação por página de 256 B (o esp_flash também divide assim)
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t offset, const void* src, size_t size) {
+    int i = index_of(part);
+    if (i < 0 || offset + size > part->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(src);
+    size_t pos = 0;
+    while (pos < size) {
+        size_t n = PAGE - ((offset + pos) % PAGE);
+        if (n > size - pos) n = size - pos;
+
+        std::lock_guard<std::mutex> lock(flash_mutex);
+        for (size_t k = 0; k < n; ++k) {
+            uint8_t& cell = data[i][offset + pos + k];
+            if ((cell & p[pos + k]) != p[pos + k]) stats.dirty_writes++;
+            cell &= p[pos + k];
+        }
+        stats.page_programs++;
+        flash_busy(model.page_program_us);
+        pos += n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* dst, size_t size) {
+    int i = index_of(part);
+    if (i < 0 || offset + size > part->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    memcpy(dst, &data[i][offset], size);
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &parts[0];
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t*) {
+    return parts[1].size ? &parts[1] : nullptr;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* part) {
+    int i = index_of(part);
+    if (i < 0) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(flash_mutex);
+    if (data[i][0] != 0xE9) return ESP_ERR_OTA_VALIDATE_FAILED;
+    boot = part;
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+    return boot;
+}
+
+// -----------------------------------------------------------------------------
+// mbedtls_pk -> OpenSSL
+// -----------------------------------------------------------------------------
+
+void mbedtls_pk_init(mbedtls_pk_context* ctx) {
+    ctx->pkey = nullptr;
+}
+
+void mbedtls_pk_free(mbedtls_pk_context* ctx) {
+    EVP_PKEY_free(static_cast<EVP_PKEY*>(ctx->pkey));
+    ctx->pkey = nullptr;
+}
+
+int mbedtls_pk_parse_public_key(mbedtls_pk_context* ctx, const unsigned char* key, size_t keylen) {
+    BIO* bio = BIO_new_mem_buf(key, (int)keylen);
+    ctx->pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    return ctx->pkey ? 0 : -1;
+}
+
+int mbedtls_pk_verify(mbedtls_pk_context* ctx,
+                      mbedtls_md_type_t md_alg,
+                      const unsigned char* hash,
+                      size_t hash_len,
+                      const unsigned char* sig,
+                      size_t sig_len) {
+    if (!ctx->pkey || md_alg != MBEDTLS_MD_SHA256) return -1;
+    EVP_PKEY_CTX* v = EVP_PKEY_CTX_new(static_cast<EVP_PKEY*>(ctx->pkey), nullptr);
+    int ok = v && EVP_PKEY_verify_init(v) == 1 &&
+             EVP_PKEY_CTX_set_signature_md(v, EVP_sha256()) == 1 &&
+             EVP_PKEY_verify(v, sig, sig_len, hash, hash_len) == 1;
+    EVP_PKEY_CTX_free(v);
+    return ok ? 0 : -1;
+}
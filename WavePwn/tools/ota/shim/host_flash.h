@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Controle e contadores da flash simulada (só host).
+//
+// Modelo de tempo (W25Q128 / GD25Q128, típicos do datasheet): apagar setor
+// de 4 KB 45 ms, bloco de 64 KB 150 ms, programar página de 256 B 0,4 ms.
+// Cada operação dorme esse tempo segurando um mutex global, como o cache
+// desligado na placa: é o tempo em que o outro core (loop da UI) para.
+
+struct HostFlashModel {
+    uint32_t sector_erase_us;
+    uint32_t block_erase_us;
+    uint32_t page_program_us;
+};
+
+struct HostFlashStats {
+    uint32_t sector_erases;
+    uint32_t block_erases;
+    uint32_t page_programs;
+    uint64_t busy_us;        // soma das operações
+    uint64_t max_op_us;      // maior operação (pausa do outro core)
+    uint32_t dirty_writes;   // gravação em byte não apagado (bug)
+};
+
+// Tamanho de cada partição (padrão 8 MB)
+void host_flash_init(uint32_t partition_size);
+void host_flash_set_model(const HostFlashModel& model);
+void host_flash_get_stats(HostFlashStats* out);
+void host_flash_reset_stats();
+
+// Conteúdo de uma partição (para conferir a imagem gravada)
+const uint8_t* host_flash_data(const char* label);
+
+// Grava direto, sem tempo nem contadores (a imagem "gravada pela USB")
+bool host_flash_load(const char* label, size_t offset, const void* src, size_t len);
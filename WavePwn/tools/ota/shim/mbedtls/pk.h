@@ -0,0 +1,22 @@
+#pragma once
+
+// Só o que utils/ota_secure usa do mbedtls, implementado com a libcrypto
+// do OpenSSL (tools/ota/shim/flash_sim.cpp).
+
+#include <stddef.h>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+
+typedef struct {
+    void* pkey;
+} mbedtls_pk_context;
+
+void mbedtls_pk_init(mbedtls_pk_context* ctx);
+void mbedtls_pk_free(mbedtls_pk_context* ctx);
+int mbedtls_pk_parse_public_key(mbedtls_pk_context* ctx, const unsigned char* key, size_t keylen);
+int mbedtls_pk_verify(mbedtls_pk_context* ctx,
+                      mbedtls_md_type_t md_alg,
+                      const unsigned char* hash,
+                      size_t hash_len,
+                      const unsigned char* sig,
+                      size_t sig_len);
@@ -0,0 +1,32 @@
+#!/bin/sh
+# bench.sh - Linha de base de desempenho do motor de captura no host
+#
+# Gera (uma vez) os corpora sintéticos de gen_pcap.py e roda o replay em
+# cada perfil com um "SD" novo, imprimindo uma linha JSON por perfil.
+#
+#   tools/replay/bench.sh                  # usa o build do env native_replay
+#   REPLAY=/caminho/replay tools/replay/bench.sh
+#   DURATION=120 PROFILES="mixed data" tools/replay/bench.sh
+
+set -e
+cd "$(dirname "$0")/../.."
+
+REPLAY=${REPLAY:-.pio/build/native_replay/program}
+OUT=${OUT:-.pio/replay_bench}
+DURATION=${DURATION:-30}
+PROFILES=${PROFILES:-"mixed beacons data handshakes"}
+
+if [ ! -x "$REPLAY" ]; then
+    pio run -e native_replay
+fi
+
+mkdir -p "$OUT"
+for p in $PROFILES; do
+    corpus="$OUT/${p}_${DURATION}s.pcap"
+    if [ ! -f "$corpus" ]; then
+        python3 tools/replay/gen_pcap.py -p "$p" --seconds "$DURATION" -o "$corpus" >&2
+    fi
+    rm -rf "$OUT/sd_$p"
+    printf '%-11s ' "$p"
+    "$REPLAY" --sd "$OUT/sd_$p" --json "$corpus"
+done
@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""
+gen_pcap.py - Gera capturas 802.11 sintéticas para o replay no host
+
+Simula um ambiente com APs (open/WPA2/WPA3, alguns com PMKID no RSN IE e
+alguns ocultos), clientes trocando data frames e handshakes 4-way completos
+(M1..M4). Os frames saem com FCS, como o callback promíscuo do ESP32 entrega.
+Determinístico para a mesma --seed.
+
+Perfis:
+    mixed       ambiente urbano típico (padrão)
+    beacons     só beacons de muitos APs (custo do parsing de IEs / tabela)
+    data        poucos APs, tráfego de dados pesado (caminho rápido de data)
+    handshakes  muitos clientes reassociando (tracker + log de sessão)
+    attack      mixed + rajadas de deauth broadcast, clones abertos de redes
+                WPA2 (evil twin) e probe requests (features da NEURA9)
+
+Uso:
+    $ python3 tools/replay/gen_pcap.py -p mixed -o mixed.pcap
+    $ python3 tools/replay/gen_pcap.py -p beacons --seconds 10 --radiotap -o b.pcap
+"""
+
+import argparse
+import heapq
+import random
+import struct
+import sys
+import zlib
+
+
+PROFILES = {
+    #              aps  clients  data/s  handshakes  hidden  wpa3  open  pmkid
+    "mixed":      (80,  200,     5,      20,         0.10,   0.15, 0.10, 0.20),
+    "beacons":    (500, 0,       0,      0,          0.10,   0.15, 0.10, 0.20),
+    "data":       (8,   60,      200,    2,          0.0,    0.0,  0.0,  0.0),
+    "handshakes": (40,  400,     1,      400,        0.0,    0.10, 0.0,  0.10),
+    "attack":     (80,  200,     5,      20,         0.10,   0.15, 0.10, 0.20),
+}
+
+# Tráfego hostil por perfil (os demais não têm)
+#              deauth/s  rajada(s)  evil twins  probes/s
+ATTACKS = {
+    "attack": (50,       3.0,       3,          20),
+}
+
+BEACON_INTERVAL_US = 102400
+CHANNELS = (1, 6, 11, 2, 3, 4, 5, 7, 8, 9, 10, 12, 13)
+
+LINKTYPE_IEEE802_11 = 105
+LINKTYPE_IEEE802_11_RADIOTAP = 127
+
+OUI_IEEE = b"\x00\x0f\xac"
+KI_PAIRWISE = 0x0008
+KI_INSTALL = 0x0040
+KI_ACK = 0x0080
+KI_MIC = 0x0100
+KI_SECURE = 0x0200
+KI_ENC_DATA = 0x1000
+KI_VERSION = 0x0002     # HMAC-SHA1 / AES
+
+
+def mac(rng, local=True):
+    b = bytearray(rng.getrandbits(8) for _ in range(6))
+    b[0] = (b[0] & 0xFC) | (0x02 if local else 0x00)
+    return bytes(b)
+
+
+def ie(eid, data):
+    return struct.pack("BB", eid, len(data)) + data
+
+
+def rsn_ie(akm, pmkid=None):
+    body = struct.pack("<H", 1) + OUI_IEEE + b"\x04"          # versão, group CCMP
+    body += struct.pack("<H", 1) + OUI_IEEE + b"\x04"         # pairwise CCMP
+    body += struct.pack("<H", 1) + OUI_IEEE + bytes([akm])    # AKM
+    body += struct.pack("<H", 0x000C)                          # capabilities
+    if pmkid is not None:
+        body += struct.pack("<H", 1) + pmkid
+    return ie(48, body)
+
+
+class Ap:
+    def __init__(self, rng, index, profile):
+        _, _, _, _, hidden, wpa3, open_, pmkid = profile
+        self.bssid = mac(rng)
+        self.ssid = ("" if rng.random() < hidden else "net-%03d" % index).encode()
+        self.channel = CHANNELS[index % 3] if rng.random() < 0.7 else rng.choice(CHANNELS)
+        self.open = rng.random() < open_
+        self.akm = 8 if rng.random() < wpa3 else 2
+        self.pmkid = None if self.open or rng.random() >= pmkid else rng.randbytes(16)
+        self.rssi = rng.randint(-90, -35)
+        self.seq = 0
+
+    def next_seq(self):
+        self.seq = (self.seq + 1) & 0x0FFF
+        return struct.pack("<H", self.seq << 4)
+
+    def beacon(self, ts_us):
+        cap = 0x0401 if self.open else 0x0411
+        body = struct.pack("<QHH", ts_us, 100, cap)
+        body += ie(0, self.ssid)
+        body += ie(1, b"\x82\x84\x8b\x96\x0c\x12\x18\x24")
+        body += ie(3, bytes([self.channel]))
+        if not self.open:
+            body += rsn_ie(self.akm, self.pmkid)
+        hdr = b"\x80\x00\x00\x00" + b"\xff" * 6 + self.bssid + self.bssid + self.next_seq()
+        return hdr + body
+
+
+def deauth_frame(ap, dst=b"\xff" * 6, reason=7):
+    return b"\xc0\x00\x00\x00" + dst + ap.bssid + ap.bssid + ap.next_seq() + \
+        struct.pack("<H", reason)
+
+
+def probe_request(sta, ssid):
+    body = ie(0, ssid) + ie(1, b"\x82\x84\x8b\x96")
+    return b"\x40\x00\x00\x00" + b"\xff" * 6 + sta + b"\xff" * 6 + b"\x00\x00" + body
+
+
+def data_frame(ap, sta, from_ds, payload):
+    if from_ds:
+        fc, a1, a2 = b"\x08\x42", sta, ap.bssid       # FromDS + Protected
+    else:
+        fc, a1, a2 = b"\x08\x41", ap.bssid, sta       # ToDS + Protected
+    return fc + b"\x00\x00" + a1 + a2 + ap.bssid + ap.next_seq() + payload
+
+
+def eapol_frame(ap, sta, from_ds, key_info, replay, nonce, mic, key_data):
+    key = struct.pack(">BHHQ", 2, key_info | KI_PAIRWISE | KI_VERSION, 16, replay)
+    key += nonce + b"\x00" * 16 + b"\x00" * 8 + b"\x00" * 8 + mic
+    key += struct.pack(">H", len(key_data)) + key_data
+    eapol = struct.pack(">BBH", 2, 3, len(key)) + key
+    llc = b"\xaa\xaa\x03\x00\x00\x00\x88\x8e"
+    fc = b"\x08\x02" if from_ds else b"\x08\x01"
+    a1, a2 = (sta, ap.bssid) if from_ds else (ap.bssid, sta)
+    return fc + b"\x00\x00" + a1 + a2 + ap.bssid + ap.next_seq() + llc + eapol
+
+
+def handshake(rng, ap, sta, t0):
+    anonce, snonce = rng.randbytes(32), rng.randbytes(32)
+    r = rng.randint(1, 1000)
+    zero_mic, zero_nonce = b"\x00" * 16, b"\x00" * 32
+    rsn = rsn_ie(ap.akm)
+    return [
+        (t0, eapol_frame(ap, sta, True, KI_ACK, r, anonce, zero_mic, b"")),
+        (t0 + 2000, eapol_frame(ap, sta, False, KI_MIC, r, snonce, rng.randbytes(16), rsn)),
+        (t0 + 4000, eapol_frame(ap, sta, True, KI_MIC | KI_ACK | KI_INSTALL | KI_SECURE
+                                | KI_ENC_DATA, r + 1, anonce, rng.randbytes(16),
+                                rng.randbytes(56))),
+        (t0 + 6000, eapol_frame(ap, sta, False, KI_MIC | KI_SECURE, r + 1, zero_nonce,
+                                rng.randbytes(16), b"")),
+    ]
+
+
+def radiotap(channel, rssi):
+    # Flags (FCS), Rate, Channel, dBm signal, dBm noise: o mesmo do pcapng
+    # gravado pelo firmware
+    present = (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5) | (1 << 6)
+    freq = 2484 if channel == 14 else 2407 + 5 * channel
+    return struct.pack("<BBHIBBHHbb", 0, 0, 16, present, 0x10, 12, freq, 0x0080,
+                       rssi, -95)
+
+
+def generate(args):
+    rng = random.Random(args.seed)
+    profile = list(PROFILES[args.profile])
+    for i, name in enumerate(("aps", "clients", "data_rate", "handshakes")):
+        value = getattr(args, name)
+        if value is not None:
+            profile[i] = value
+    n_aps, n_clients, data_rate, n_handshakes = profile[:4]
+
+    aps = [Ap(rng, i, profile) for i in range(n_aps)]
+    clients = []
+    for _ in range(n_clients):
+        candidates = [a for a in aps if not a.open] or aps
+        clients.append((mac(rng), rng.choice(candidates)))
+
+    duration_us = int(args.seconds * 1e6)
+    events = []
+
+    # Beacons de cada AP, com fase aleatória
+    for ap in aps:
+        t = rng.randrange(BEACON_INTERVAL_US)
+        while t < duration_us:
+            events.append((t, ap, None))
+            t += BEACON_INTERVAL_US
+
+    # Tráfego de dados: chegada de Poisson por cliente
+    if data_rate > 0:
+        for sta, ap in clients:
+            t = rng.expovariate(data_rate) * 1e6
+            while t < duration_us:
+                from_ds = rng.random() < 0.6
+                size = rng.choice((64, 128, 512, 1200, 1400))
+                events.append((int(t), ap, data_frame(ap, sta, from_ds, rng.randbytes(size))))
+                t += rng.expovariate(data_rate) * 1e6
+
+    # Handshakes: clientes (re)associando em instantes aleatórios
+    for _ in range(n_handshakes):
+        if not clients:
+            break
+        sta, ap = rng.choice(clients)
+        if ap.open:
+            continue
+        t0 = rng.randrange(max(1, duration_us - 10000))
+        for t, frame in handshake(rng, ap, sta, t0):
+            events.append((t, ap, frame))
+
+    deauth_rate, burst_s, n_twins, probe_rate = ATTACKS.get(args.profile, (0, 0, 0, 0))
+
+    # Evil twin: BSSID novo, mesmo SSID de uma rede WPA2, sem criptografia
+    for target in [a for a in aps if not a.open and a.ssid][:n_twins]:
+        twin = Ap(rng, 0, profile)
+        twin.ssid, twin.channel, twin.open, twin.pmkid = target.ssid, target.channel, True, None
+        t = duration_us // 3 + rng.randrange(BEACON_INTERVAL_US)
+        while t < duration_us:
+            events.append((t, twin, None))
+            t += BEACON_INTERVAL_US
+
+    # Deauth broadcast em rajadas de burst_s a cada ~10 s, forjado como o AP
+    if deauth_rate > 0:
+        t_burst = 5_000_000
+        while t_burst < duration_us:
+            ap = rng.choice(aps)
+            t = t_burst
+            while t < min(duration_us, t_burst + burst_s * 1e6):
+                events.append((int(t), ap, deauth_frame(ap)))
+                t += rng.expovariate(deauth_rate) * 1e6
+            t_burst += 10_000_000
+
+    # Probe requests de estações procurando redes conhecidas
+    if probe_rate > 0:
+        t = rng.expovariate(probe_rate) * 1e6
+        while t < duration_us:
+            sta, ap = rng.choice(clients) if clients else (mac(rng), rng.choice(aps))
+            events.append((int(t), ap, probe_request(sta, ap.ssid)))
+            t += rng.expovariate(probe_rate) * 1e6
+
+    events.sort(key=lambda e: e[0])
+
+    linktype = LINKTYPE_IEEE802_11_RADIOTAP if args.radiotap else LINKTYPE_IEEE802_11
+    start = 1700000000 * 1000000
+    frames = 0
+    with open(args.output, "wb") as out:
+        out.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535, linktype))
+        for t, ap, frame in events:
+            if frame is None:
+                frame = ap.beacon(t)
+            frame += struct.pack("<I", zlib.crc32(frame) & 0xFFFFFFFF)
+            if args.radiotap:
+                rssi = max(-100, min(-20, ap.rssi + rng.randint(-4, 4)))
+                frame = radiotap(ap.channel, rssi) + frame
+            ts = start + t
+            out.write(struct.pack("<IIII", ts // 1000000, ts % 1000000, len(frame), len(frame)))
+            out.write(frame)
+            frames += 1
+
+    print("%s: %d frames, %d APs, %d clientes, %d handshakes, %.0f s"
+          % (args.output, frames, n_aps, n_clients, n_handshakes, args.seconds))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-p", "--profile", choices=sorted(PROFILES), default="mixed")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--seconds", type=float, default=30.0)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--aps", type=int)
+    parser.add_argument("--clients", type=int)
+    parser.add_argument("--data-rate", type=float, dest="data_rate",
+                        help="data frames/s por cliente")
+    parser.add_argument("--handshakes", type=int)
+    parser.add_argument("--radiotap", action="store_true",
+                        help="LINKTYPE 127 (radiotap) em vez de 105")
+    args = parser.parse_args()
+
+    if sys.version_info < (3, 9):
+        sys.exit("Python 3.9+ necessario (random.randbytes)")
+    generate(args)
+
+
+if __name__ == "__main__":
+    main()
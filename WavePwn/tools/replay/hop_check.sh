@@ -0,0 +1,62 @@
+#!/bin/sh
+# hop_check.sh - Channel hopping adaptativo x round-robin fixo, em handshakes/h
+#
+# Gera um corpus multicanal com radiotap (gen_pcap.py --radiotap: 70% dos
+# APs em 1/6/11, o resto espalhado), roda o replay com --hop rr e com
+# --hop adaptive em cada semente de SEEDS (relógio virtual, dwell do
+# config.h) e compara os handshakes por hora de captura. Sai com 1 se a
+# média do adaptativo ficar abaixo de MIN_GAIN x o round-robin.
+#
+#   tools/replay/hop_check.sh                     # 30 min de captura
+#   SEEDS="1 2 3 4 5" MIN_GAIN=1.5 tools/replay/hop_check.sh
+#   CORPUS=gravado.pcapng tools/replay/hop_check.sh   # captura real, com canal
+
+set -e
+cd "$(dirname "$0")/../.."
+
+REPLAY=${REPLAY:-.pio/build/native_replay/program}
+OUT=${OUT:-.pio/replay_bench}
+DURATION=${DURATION:-1800}
+SEEDS=${SEEDS:-"1 2 3"}
+MIN_GAIN=${MIN_GAIN:-1.0}
+CORPUS=${CORPUS:-$OUT/hop_${DURATION}s.pcap}
+
+if [ ! -x "$REPLAY" ]; then
+    pio run -e native_replay
+fi
+
+mkdir -p "$OUT"
+if [ ! -f "$CORPUS" ]; then
+    # Muitos clientes e pouco tráfego de dados: cada handshake é de um par
+    # AP/STA novo (a captura deduplica por par) e o corpus fica em ~130 MB
+    python3 tools/replay/gen_pcap.py -p mixed --radiotap --seconds "$DURATION" --aps 40 \
+        --clients 2000 --data-rate 0.05 --handshakes $((DURATION * 5 / 3)) -o "$CORPUS" >&2
+fi
+
+per_hour() {
+    rm -rf "$OUT/sd_hop"
+    "$REPLAY" --sd "$OUT/sd_hop" --json "$@" "$CORPUS" | python3 -c \
+        'import json, sys; print(json.load(sys.stdin)["handshakes_per_hour"])'
+}
+
+rr=$(per_hour --hop rr)
+printf 'round-robin        %8s handshakes/h\n' "$rr"
+sum=0
+n=0
+for s in $SEEDS; do
+    h=$(per_hour --hop adaptive --hop-seed "$s")
+    printf 'adaptativo seed %-2s %8s handshakes/h\n' "$s" "$h"
+    sum=$(python3 -c "print($sum + $h)")
+    n=$((n + 1))
+done
+
+python3 - "$rr" "$sum" "$n" "$MIN_GAIN" <<'PY'
+import sys
+rr, total, n, min_gain = float(sys.argv[1]), float(sys.argv[2]), int(sys.argv[3]), float(sys.argv[4])
+mean = total / n
+gain = mean / rr if rr else float("inf")
+ok = gain >= min_gain
+print("[HOP] adaptativo %.1f handshakes/h x round-robin %.1f: %.2fx (minimo %.2fx) %s"
+      % (mean, rr, gain, min_gain, "ok" if ok else "FALHOU"), file=sys.stderr)
+sys.exit(0 if ok else 1)
+PY
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+pair_check.py - Seleção de par do HandshakeTracker sobre um corpus pcap
+
+Gera um pcap com um cenário de 4-way handshake por AP/STA (subconjuntos de
+M1..M4, replay counters trocados, mensagens fora da janela de 5 s, M4 com
+SNonce zerado, EAPOL maior que o buffer do tracker), roda o replay
+(env native_replay) sobre ele e exporta o log de sessão com o
+tools/session_export.py. Confere, para cada cenário:
+
+    par         o MESSAGEPAIR da linha 22000 (ou nenhuma linha)
+    conteúdo    MIC, ANonce e EAPOL (com o MIC zerado) vindos das
+                mensagens certas, e o ESSID do beacon
+
+e que o replay contou em "eapol_oversize" as M2 grandes demais.
+
+Sai com 1 se algum cenário divergir. --pcap guarda o corpus gerado.
+
+Uso:
+    $ pio run -e native_replay
+    $ python3 tools/replay/pair_check.py
+    $ python3 tools/replay/pair_check.py --replay /caminho/replay --pcap pares.pcap
+"""
+
+import argparse
+import json
+import os
+import pathlib
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.join(HERE, "..", "..")
+sys.path.insert(0, HERE)
+sys.path.insert(0, os.path.join(ROOT, "tools"))
+
+import gen_pcap  # noqa: E402
+import session_export  # noqa: E402
+from gen_pcap import KI_ACK, KI_ENC_DATA, KI_INSTALL, KI_MIC, KI_SECURE  # noqa: E402
+
+# Offsets dentro do EAPOL (cabeçalho de 4 bytes + EAPOL-Key)
+EAPOL_MIC_OFFSET = 4 + 77
+EAPOL_FIXED_LEN = 4 + 95          # sem o Key Data
+TRACKER_EAPOL_MAX = 256           # HandshakeTracker::StaMessage::eapol
+
+# nome, mensagens [(msg, atraso em ms, opções)], par esperado (None = nenhum)
+SCENARIOS = [
+    ("M1..M4", [(1, 0, {}), (2, 2, {}), (3, 4, {}), (4, 6, {})], 0x02),
+    ("M1+M2", [(1, 0, {}), (2, 2, {})], 0x00),
+    ("M2+M3", [(2, 0, {}), (3, 2, {})], 0x02),
+    ("M3+M4 com SNonce", [(3, 0, {}), (4, 2, {"snonce": True})], 0x05),
+    ("M1+M4 com SNonce", [(1, 0, {}), (4, 2, {"snonce": True})], 0x01),
+    ("M1+M2, M3 depois", [(1, 0, {}), (2, 2, {}), (3, 1000, {})], 0x02),
+    ("M3+M4 SNonce zerado", [(3, 0, {}), (4, 2, {})], None),
+    ("M1+M2 replay diferente", [(1, 0, {}), (2, 2, {"replay": 5})], None),
+    ("M1+M2 fora da janela", [(1, 0, {}), (2, 6000, {})], None),
+    ("M1+M2 EAPOL > 256", [(1, 0, {}), (2, 2, {"key_data": 300})], None),
+    ("so M1", [(1, 0, {})], None),
+    ("so M2", [(2, 0, {})], None),
+]
+
+
+class Scenario:
+    def __init__(self, rng, index, name, messages, expected):
+        profile = (0, 0, 0, 0, 0.0, 0.0, 0.0, 0.0)
+        self.ap = gen_pcap.Ap(rng, index, profile)
+        self.ap.ssid = b"pair-%02d" % index
+        self.sta = gen_pcap.mac(rng)
+        self.name = name
+        self.messages = messages
+        self.expected = expected
+        self.anonce = rng.randbytes(32)
+        self.snonce = rng.randbytes(32)
+        self.replay = rng.randint(1, 1000)
+        self.frames = {}      # msg -> (mic, eapol com MIC zerado)
+        self.rng = rng
+
+    def frame(self, msg, opts):
+        ap, sta, r = self.ap, self.sta, self.replay
+        mic = self.rng.randbytes(16)
+        key_data = self.rng.randbytes(opts.get("key_data", 0))
+        if msg == 1:
+            mic = b"\x00" * 16
+            f = gen_pcap.eapol_frame(ap, sta, True, KI_ACK, r, self.anonce, mic, b"")
+        elif msg == 2:
+            f = gen_pcap.eapol_frame(ap, sta, False, KI_MIC, r + opts.get("replay", 0),
+                                     self.snonce, mic,
+                                     key_data or gen_pcap.rsn_ie(ap.akm))
+        elif msg == 3:
+            f = gen_pcap.eapol_frame(ap, sta, True, KI_MIC | KI_ACK | KI_INSTALL | KI_SECURE
+                                     | KI_ENC_DATA, r + 1, self.anonce, mic,
+                                     self.rng.randbytes(56))
+        else:
+            nonce = self.snonce if opts.get("snonce") else b"\x00" * 32
+            f = gen_pcap.eapol_frame(ap, sta, False, KI_MIC | KI_SECURE, r + 1, nonce, mic, b"")
+        eapol = bytearray(f[24 + 8:])
+        eapol[EAPOL_MIC_OFFSET:EAPOL_MIC_OFFSET + 16] = b"\x00" * 16
+        self.frames[msg] = (mic, bytes(eapol))
+        return f
+
+    def events(self, t0):
+        """(t_us, frame): beacon antes (SSID) e depois (grava pares pendentes)."""
+        out = [(t0, self.ap.beacon(t0))]
+        for msg, delay_ms, opts in self.messages:
+            out.append((t0 + 1000 + delay_ms * 1000, self.frame(msg, opts)))
+        end = out[-1][0] + 10000
+        out.append((end, self.ap.beacon(end)))
+        return out
+
+    def expected_line(self):
+        # ANonce é o mesmo em M1 e M3; MIC e EAPOL vêm de M2 (pares E2) ou M4
+        p = self.expected
+        mic, eapol = self.frames[2 if p in (0x00, 0x02) else 4]
+        return "WPA*02*{}*{}*{}*{}*{}*{}*{:02x}".format(
+            mic.hex(), self.ap.bssid.hex(), self.sta.hex(), self.ap.ssid.hex(),
+            self.anonce.hex(), eapol.hex(), p)
+
+
+def write_pcap(path, events):
+    start = 1700000000 * 1000000
+    with open(path, "wb") as out:
+        out.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535,
+                              gen_pcap.LINKTYPE_IEEE802_11))
+        for t, frame in sorted(events, key=lambda e: e[0]):
+            frame += struct.pack("<I", zlib.crc32(frame) & 0xFFFFFFFF)
+            ts = start + t
+            out.write(struct.pack("<IIII", ts // 1000000, ts % 1000000, len(frame), len(frame)))
+            out.write(frame)
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--replay", default=os.path.join(ROOT, ".pio", "build", "native_replay",
+                                                     "program"))
+    ap.add_argument("--pcap", type=pathlib.Path, help="onde guardar o corpus gerado")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    rng = random.Random(args.seed)
+    scenarios = [Scenario(rng, i, *s) for i, s in enumerate(SCENARIOS)]
+    events = []
+    t = 0
+    for s in scenarios:
+        events += s.events(t)
+        t = events[-1][0] + 10_000_000     # cenários a 10 s um do outro
+
+    with tempfile.TemporaryDirectory() as tmp:
+        tmp = pathlib.Path(tmp)
+        pcap = args.pcap or tmp / "pairs.pcap"
+        write_pcap(pcap, events)
+        stats = json.loads(subprocess.run([args.replay, "--sd", str(tmp / "sd"), "--json",
+                                           str(pcap)], check=True, capture_output=True,
+                                          text=True).stdout)
+        session_export.export(tmp / "sd" / "sd" / "wavepwn" / "session", tmp / "export")
+        lines = (tmp / "export" / "handshakes.22000").read_text().split()
+
+    got = {}
+    for line in lines:
+        f = line.split("*")
+        got[(f[3], f[4])] = line
+
+    failures = 0
+    for s in scenarios:
+        line = got.pop((s.ap.bssid.hex(), s.sta.hex()), None)
+        if s.expected is None:
+            ok = line is None
+            want = "nenhum"
+        else:
+            ok = line == s.expected_line()
+            want = "%02x" % s.expected
+        have = "nenhum" if line is None else line.split("*")[-1]
+        print(f"  {s.name:26} esperado {want:6} obtido {have:6} {'ok' if ok else 'FALHOU'}")
+        if not ok and line is not None and s.expected is not None:
+            print(f"    esperado: {s.expected_line()}\n    obtido:   {line}")
+        failures += not ok
+    for line in got.values():
+        print(f"  linha inesperada: {line}")
+        failures += 1
+
+    oversize = sum(1 for s in scenarios for _, _, o in s.messages
+                   if EAPOL_FIXED_LEN + o.get("key_data", 0) > TRACKER_EAPOL_MAX)
+    if stats["eapol_oversize"] != oversize:
+        print(f"  eapol_oversize {stats['eapol_oversize']}, esperado {oversize}")
+        failures += 1
+
+    print("[PAIRS] verificacao", "FALHOU" if failures else "ok",
+          f"({len(scenarios)} cenarios)")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
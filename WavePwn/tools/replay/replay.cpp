@@ -0,0 +1,789 @@
+/*
+  replay.cpp - Replay de arquivos pcap/pcapng pelo motor de captura no host
+
+  Compila src/capture.cpp e src/capture/ contra o shim de tools/replay/shim
+  (SD -> arquivos POSIX, millis -> relógio virtual, FreeRTOS -> std::thread)
+  e entrega cada frame a capture_packet_handler() como o callback promíscuo
+  faria. A thread principal faz o papel da task de captura (capture_poll());
+  a task sd (storage.cpp), que grava os buffers do PCAP, roda de verdade
+  numa thread.
+
+  Com --rate o ring é exercitado como no device: a thread principal
+  entrega os frames no ritmo pedido (relógio de parede) e uma segunda
+  thread drena o ring como a task de captura; frames descartados por ring
+  cheio saem em "dropped" e --max-drops transforma isso em falha.
+
+  Com --hop o hopper do wifi_sniffer.cpp roda no relógio virtual: um
+  ChannelScheduler (adaptativo ou round-robin) decide o canal a cada
+  dwell, e só os frames desse canal chegam à captura, como no rádio. O
+  corpus precisa do canal de cada frame (radiotap ou pcapng do firmware);
+  o resultado é comparado em handshakes por hora de captura.
+
+  Uso:
+    pio run -e native_replay
+    .pio/build/native_replay/program [opções] captura.pcap [...]
+
+  Opções:
+    --sd DIR            raiz do "SD" (padrão ./replay_sd)
+    --format pcap|pcapng  formato do PCAP gravado (padrão: o do firmware)
+    --batch N           frames entre drenagens do ring (padrão 32)
+    --loops N           repete o corpus N vezes (dedup em regime)
+    --json              resumo em uma linha JSON no stdout
+    --features CSV      grava o vetor da NEURA9 (neura9/features.h) a cada
+                        --features-ms de tempo de captura, no formato
+                        f0,...,f71,label do ai/neura9_trainer.py
+    --features-ms N     intervalo entre linhas do CSV (padrão 1000)
+    --label N           classe (0-9, ai/neura9_labels.txt) das linhas
+    --rate FPS          entrega a FPS frames/s com a task de captura numa
+                        thread própria (sem --features)
+    --max-drops N       sai com 1 se o ring descartar mais de N frames
+    --hop rr|adaptive   simula o channel hopping (sem --rate)
+    --hop-dwell B,MIN,MAX  dwell base/mín/máx em ms (padrão: config.h)
+    --hop-seed N        semente da exploração do modo adaptativo
+    -v                  Serial do firmware na stderr
+*/
+
+#include <Arduino.h>
+#include <esp_wifi_types.h>
+
+#include "capture.h"
+#include "capture/ap_table.h"
+#include "capture/channel_scheduler.h"
+#include "capture/frame_ring.h"
+#include "neura9/features.h"
+#include "pwnagotchi.h"
+#include "storage.h"
+#include "ui.h"
+#include "utils/crc32.h"
+#include "wifi_sniffer.h"
+
+#include "config.h"
+#include "shim/host_shim.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// Dublês do resto do firmware
+// -----------------------------------------------------------------------------
+
+Pwnagotchi pwn;
+
+static uint32_t ui_moods = 0;
+static uint32_t ui_handshake_celebrations = 0;
+static uint32_t ui_pmkid_celebrations = 0;
+
+extern "C" void ui_set_mood(Mood mood) {
+    (void)mood;
+    ui_moods++;
+}
+
+extern "C" void ui_celebrate_handshake(void) { ui_handshake_celebrations++; }
+extern "C" void ui_celebrate_pmkid(void) { ui_pmkid_celebrations++; }
+
+static uint32_t sniff_events[SNIFF_EAPOL_M1 + 1] = {};
+static uint8_t replay_channel = 0;
+
+// --hop: estado da hopper_task do wifi_sniffer.cpp, com o relógio virtual
+// no lugar de millis()
+static ChannelScheduler hopper;
+static bool hopping = false;
+static ChannelActivity hop_activity = {};
+static uint8_t hop_pending_m1 = 0;
+static uint64_t hop_dwell_start_us = 0;
+
+void wifi_sniffer_count(uint8_t channel, SniffEvent ev) {
+    if (ev <= SNIFF_EAPOL_M1) sniff_events[ev]++;
+    if (!hopping) return;
+
+    // Mesmas regras do wifi_sniffer.cpp: M1 só pede o bump, e o resto
+    // conta só no canal atual
+    if (ev == SNIFF_EAPOL_M1) {
+        hop_pending_m1 = channel;
+        return;
+    }
+    if (channel != hopper.channel()) return;
+    switch (ev) {
+        case SNIFF_BEACON: hop_activity.beacons++; break;
+        case SNIFF_DATA: hop_activity.data_frames++; break;
+        case SNIFF_EAPOL: hop_activity.eapol++; break;
+        case SNIFF_NEW_BSSID: hop_activity.new_bssids++; break;
+        default: break;
+    }
+}
+
+uint8_t wifi_sniffer_channel() { return replay_channel; }
+
+static ChannelActivity hop_take_activity() {
+    ChannelActivity a = hop_activity;
+    hop_activity = ChannelActivity();
+    return a;
+}
+
+// Fecha os dwells que terminaram até `now_us`
+static void hop_until(uint64_t now_us) {
+    while (now_us >= hop_dwell_start_us + hopper.dwell_ms() * 1000ULL) {
+        uint32_t dwell = hopper.dwell_ms();
+        hop_dwell_start_us += dwell * 1000ULL;
+        replay_channel = hopper.advance(hop_take_activity(), dwell);
+    }
+}
+
+// EAPOL M1 processado em `now_us`: o hopper acordaria na hora
+static void hop_on_m1(uint64_t now_us) {
+    if (!hopper.can_bump(hop_pending_m1)) {
+        hop_pending_m1 = 0;
+        return;
+    }
+    // Como o hopper_task: no canal atual só estende o dwell em andamento
+    uint32_t elapsed = (uint32_t)((now_us - hop_dwell_start_us) / 1000ULL);
+    if (hop_pending_m1 == hopper.channel()) {
+        hopper.hold(elapsed);
+    } else {
+        hopper.bump(hop_pending_m1, hop_take_activity(), elapsed);
+        replay_channel = hopper.channel();
+        hop_dwell_start_us = now_us;
+    }
+    hop_pending_m1 = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Leitura de pcap / pcapng
+// -----------------------------------------------------------------------------
+
+static const uint32_t LINKTYPE_IEEE802_11 = 105;
+static const uint32_t LINKTYPE_IEEE802_11_RADIOTAP = 127;
+
+struct ReplayFrame {
+    uint64_t ts_us;
+    size_t offset;        // em Corpus::bytes (frame 802.11 já com FCS)
+    uint16_t len;
+    uint8_t channel;
+    int8_t rssi;
+    int8_t noise_floor;
+    uint8_t rate;
+};
+
+struct Corpus {
+    std::vector<uint8_t> bytes;
+    std::vector<ReplayFrame> frames;
+    uint32_t skipped = 0;       // linktype desconhecido / registro inválido
+    uint32_t fcs_added = 0;     // frames sem FCS que ganharam um calculado
+};
+
+struct RadioInfo {
+    uint8_t channel = 0;
+    int8_t rssi = -50;
+    int8_t noise_floor = -95;
+    uint8_t rate = 0;
+    bool has_fcs = false;
+};
+
+static uint16_t rd16(const uint8_t* p, bool swap) {
+    uint16_t v = (uint16_t)(p[0] | (p[1] << 8));
+    return swap ? (uint16_t)((v >> 8) | (v << 8)) : v;
+}
+
+static uint32_t rd32(const uint8_t* p, bool swap) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                 ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+static uint8_t freq_to_channel(uint16_t mhz) {
+    if (mhz == 2484) return 14;
+    if (mhz >= 2412 && mhz <= 2472) return (uint8_t)((mhz - 2407) / 5);
+    if (mhz >= 5000 && mhz < 6000) return (uint8_t)((mhz - 5000) / 5);
+    return 0;
+}
+
+// Radiotap rate (500 kbps) -> índice wifi_phy_rate_t, inverso do pcap_writer
+static uint8_t rate_to_phy(uint8_t r500k) {
+    switch (r500k) {
+        case 2: return 0x0;
+        case 4: return 0x1;
+        case 11: return 0x2;
+        case 22: return 0x3;
+        case 96: return 0x8;
+        case 48: return 0x9;
+        case 24: return 0xA;
+        case 12: return 0xB;
+        case 108: return 0xC;
+        case 72: return 0xD;
+        case 36: return 0xE;
+        case 18: return 0xF;
+        default: return 0;
+    }
+}
+
+// Campos 0..14 do namespace padrão: {tamanho, alinhamento}
+static const uint8_t RADIOTAP_FIELDS[15][2] = {
+    {8, 8}, {1, 1}, {1, 1}, {4, 2}, {2, 1}, {1, 1}, {1, 1}, {2, 2},
+    {2, 2}, {2, 2}, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {2, 2},
+};
+
+static bool parse_radiotap(const uint8_t* p, uint32_t len, RadioInfo* ri, uint32_t* hdr_len) {
+    if (len < 8 || p[0] != 0) return false;
+    uint32_t it_len = rd16(p + 2, false);
+    if (it_len < 8 || it_len > len) return false;
+
+    uint32_t present = rd32(p + 4, false);
+    uint32_t off = 8;
+    for (uint32_t word = present; word & 0x80000000u; off += 4) {
+        if (off + 4 > it_len) return false;
+        word = rd32(p + off, false);
+    }
+
+    for (int bit = 0; bit < 15; ++bit) {
+        if (!(present & (1u << bit))) continue;
+        uint32_t size = RADIOTAP_FIELDS[bit][0];
+        uint32_t align = RADIOTAP_FIELDS[bit][1];
+        off = (off + align - 1) & ~(align - 1);
+        if (off + size > it_len) break;
+
+        const uint8_t* f = p + off;
+        switch (bit) {
+            case 1: ri->has_fcs = (f[0] & 0x10) != 0; break;
+            case 2: ri->rate = rate_to_phy(f[0]); break;
+            case 3: ri->channel = freq_to_channel(rd16(f, false)); break;
+            case 5: ri->rssi = (int8_t)f[0]; break;
+            case 6: ri->noise_floor = (int8_t)f[0]; break;
+            default: break;
+        }
+        off += size;
+    }
+
+    *hdr_len = it_len;
+    return true;
+}
+
+// Guarda um frame no corpus. O callback do ESP32 entrega sig_len com FCS;
+// quando a captura de origem não tem, acrescentamos um calculado.
+static void add_frame(Corpus* c, uint32_t linktype, uint64_t ts_us,
+                      const uint8_t* data, uint32_t caplen) {
+    RadioInfo ri;
+    if (linktype == LINKTYPE_IEEE802_11_RADIOTAP) {
+        uint32_t hdr = 0;
+        if (!parse_radiotap(data, caplen, &ri, &hdr)) {
+            c->skipped++;
+            return;
+        }
+        data += hdr;
+        caplen -= hdr;
+    } else if (linktype == LINKTYPE_IEEE802_11) {
+        if (caplen > 4) {
+            uint32_t fcs = crc32_update(0, data, caplen - 4);
+            ri.has_fcs = fcs == rd32(data + caplen - 4, false);
+        }
+    } else {
+        c->skipped++;
+        return;
+    }
+
+    if (caplen < 10 || caplen + 4 > 0xFFFF) {
+        c->skipped++;
+        return;
+    }
+
+    ReplayFrame fr;
+    fr.ts_us = ts_us;
+    fr.offset = c->bytes.size();
+    fr.channel = ri.channel;
+    fr.rssi = ri.rssi;
+    fr.noise_floor = ri.noise_floor;
+    fr.rate = ri.rate;
+
+    c->bytes.insert(c->bytes.end(), data, data + caplen);
+    if (!ri.has_fcs) {
+        uint32_t fcs = crc32_update(0, data, caplen);
+        for (int i = 0; i < 4; ++i) c->bytes.push_back((uint8_t)(fcs >> (8 * i)));
+        caplen += 4;
+        c->fcs_added++;
+    }
+    fr.len = (uint16_t)caplen;
+    c->frames.push_back(fr);
+}
+
+static bool read_file(const char* path, std::vector<uint8_t>* out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        out->insert(out->end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool load_pcap(const std::vector<uint8_t>& b, Corpus* c) {
+    uint32_t magic = rd32(b.data(), false);
+    bool swap = magic == 0xd4c3b2a1u || magic == 0x4d3cb2a1u;
+    bool nanos = magic == 0xa1b23c4du || magic == 0x4d3cb2a1u;
+    uint32_t linktype = rd32(b.data() + 20, swap) & 0x0FFFFFFFu;
+
+    size_t off = 24;
+    while (off + 16 <= b.size()) {
+        const uint8_t* h = b.data() + off;
+        uint64_t sec = rd32(h, swap);
+        uint64_t frac = rd32(h + 4, swap);
+        uint32_t caplen = rd32(h + 8, swap);
+        off += 16;
+        if (caplen > b.size() - off) break;   // cauda truncada
+
+        uint64_t ts = sec * 1000000ULL + (nanos ? frac / 1000 : frac);
+        add_frame(c, linktype, ts, b.data() + off, caplen);
+        off += caplen;
+    }
+    return true;
+}
+
+static bool load_pcapng(const std::vector<uint8_t>& b, Corpus* c) {
+    struct Iface {
+        uint32_t linktype;
+        uint64_t ts_div;    // unidades por µs (ou 0 = multiplicar)
+        uint64_t ts_mul;
+    };
+    std::vector<Iface> ifaces;
+    bool swap = false;
+
+    size_t off = 0;
+    while (off + 12 <= b.size()) {
+        const uint8_t* blk = b.data() + off;
+        uint32_t type = rd32(blk, swap);
+        if (type == 0x0A0D0D0Au) {
+            // Section Header Block: define a ordem dos bytes da seção
+            swap = rd32(blk + 8, false) != 0x1A2B3C4Du;
+            ifaces.clear();
+        }
+        uint32_t total = rd32(blk + 4, swap);
+        if (total < 12 || total > b.size() - off) break;
+
+        if (type == 0x00000001u && total >= 20) {
+            // Interface Description Block
+            Iface ifc = {rd16(blk + 8, swap), 0, 1};
+            uint8_t tsresol = 6;
+            for (size_t o = 16; o + 4 <= total - 4;) {
+                uint16_t code = rd16(blk + o, swap);
+                uint16_t olen = rd16(blk + o + 2, swap);
+                if (code == 0) break;
+                if (code == 9 && olen >= 1) tsresol = blk[o + 4];
+                o += 4 + ((olen + 3u) & ~3u);
+            }
+            if (tsresol & 0x80) {
+                ifc.ts_div = 0;   // potência de 2: aproximação por ponto flutuante
+                ifc.ts_mul = (uint64_t)(tsresol & 0x7F);
+            } else if (tsresol >= 6) {
+                uint64_t d = 1;
+                for (int i = 6; i < tsresol; ++i) d *= 10;
+                ifc.ts_div = d;
+            } else {
+                uint64_t m = 1;
+                for (int i = tsresol; i < 6; ++i) m *= 10;
+                ifc.ts_div = 1;
+                ifc.ts_mul = m;
+            }
+            ifaces.push_back(ifc);
+        } else if (type == 0x00000006u && total >= 32) {
+            // Enhanced Packet Block
+            uint32_t iface = rd32(blk + 8, swap);
+            uint64_t ts = ((uint64_t)rd32(blk + 12, swap) << 32) | rd32(blk + 16, swap);
+            uint32_t caplen = rd32(blk + 20, swap);
+            if (iface >= ifaces.size() || caplen > total - 32) {
+                c->skipped++;
+            } else {
+                const Iface& ifc = ifaces[iface];
+                uint64_t us;
+                if (ifc.ts_div == 0) {
+                    us = (uint64_t)((double)ts * 1e6 / (double)(1ULL << ifc.ts_mul));
+                } else {
+                    us = ts / ifc.ts_div * ifc.ts_mul;
+                }
+                add_frame(c, ifc.linktype, us, blk + 28, caplen);
+            }
+        }
+        off += total;
+    }
+    return true;
+}
+
+static bool load_capture(const char* path, Corpus* c) {
+    std::vector<uint8_t> b;
+    if (!read_file(path, &b) || b.size() < 24) {
+        fprintf(stderr, "[REPLAY] Nao foi possivel ler '%s'\n", path);
+        return false;
+    }
+    uint32_t magic = rd32(b.data(), false);
+    if (magic == 0x0A0D0D0Au) return load_pcapng(b, c);
+    if (magic == 0xa1b2c3d4u || magic == 0xd4c3b2a1u ||
+        magic == 0xa1b23c4du || magic == 0x4d3cb2a1u) {
+        return load_pcap(b, c);
+    }
+    fprintf(stderr, "[REPLAY] '%s' nao e pcap/pcapng\n", path);
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Replay
+// -----------------------------------------------------------------------------
+
+static bool mkdirs(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); ++i) {
+        if (i == path.size() || path[i] == '/') {
+            std::string part = path.substr(0, i);
+            if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        }
+    }
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "uso: replay [--sd DIR] [--format pcap|pcapng] [--batch N] [--loops N]\n"
+            "            [--json] [-v] [--features CSV [--features-ms N] [--label N]]\n"
+            "            [--rate FPS] [--max-drops N]\n"
+            "            [--hop rr|adaptive [--hop-dwell B,MIN,MAX] [--hop-seed N]]\n"
+            "            captura.pcap[ng] [...]\n");
+}
+
+int main(int argc, char** argv) {
+    std::string sd_root = "replay_sd";
+    std::vector<const char*> inputs;
+    int format = -1;
+    uint32_t batch = 32;
+    uint32_t loops = 1;
+    bool json = false;
+    bool verbose = false;
+    const char* features_path = nullptr;
+    uint32_t features_ms = 1000;
+    int label = 0;
+    uint32_t rate = 0;
+    long max_drops = -1;
+    const char* hop = nullptr;
+    uint32_t hop_dwell[3] = {CHANNEL_HOP_DELAY, CHANNEL_HOP_MIN_DWELL, CHANNEL_HOP_MAX_DWELL};
+    uint32_t hop_seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--sd" && i + 1 < argc) {
+            sd_root = argv[++i];
+        } else if (a == "--format" && i + 1 < argc) {
+            std::string f = argv[++i];
+            format = f == "pcapng" ? CAPTURE_FORMAT_PCAPNG : CAPTURE_FORMAT_PCAP;
+        } else if (a == "--batch" && i + 1 < argc) {
+            batch = (uint32_t)atoi(argv[++i]);
+        } else if (a == "--loops" && i + 1 < argc) {
+            loops = (uint32_t)atoi(argv[++i]);
+        } else if (a == "--json") {
+            json = true;
+        } else if (a == "--features" && i + 1 < argc) {
+            features_path = argv[++i];
+        } else if (a == "--features-ms" && i + 1 < argc) {
+            features_ms = (uint32_t)atoi(argv[++i]);
+        } else if (a == "--label" && i + 1 < argc) {
+            label = atoi(argv[++i]);
+        } else if (a == "--rate" && i + 1 < argc) {
+            rate = (uint32_t)atoi(argv[++i]);
+        } else if (a == "--max-drops" && i + 1 < argc) {
+            max_drops = atol(argv[++i]);
+        } else if (a == "--hop" && i + 1 < argc) {
+            hop = argv[++i];
+        } else if (a == "--hop-dwell" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u,%u,%u", &hop_dwell[0], &hop_dwell[1], &hop_dwell[2]) != 3) {
+                usage();
+                return 2;
+            }
+        } else if (a == "--hop-seed" && i + 1 < argc) {
+            hop_seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (a == "-v") {
+            verbose = true;
+        } else if (a.size() > 1 && a[0] == '-') {
+            usage();
+            return 2;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        usage();
+        return 2;
+    }
+    if (batch == 0) batch = 1;
+    if (loops == 0) loops = 1;
+    if (features_ms == 0) features_ms = 1;
+    if (rate && features_path) {
+        fprintf(stderr, "[REPLAY] --features precisa do modo sem --rate\n");
+        return 2;
+    }
+    if (hop && ((strcmp(hop, "rr") != 0 && strcmp(hop, "adaptive") != 0) || rate ||
+                hop_dwell[0] == 0 || hop_dwell[1] == 0)) {
+        fprintf(stderr, "[REPLAY] --hop rr|adaptive, dwell > 0 e sem --rate\n");
+        return 2;
+    }
+
+    FILE* features_csv = nullptr;
+    if (features_path) {
+        features_csv = fopen(features_path, "w");
+        if (!features_csv) {
+            fprintf(stderr, "[REPLAY] Nao foi possivel criar '%s'\n", features_path);
+            return 1;
+        }
+        for (int k = 0; k < NEURA9_FEATURE_COUNT; ++k) fprintf(features_csv, "f%d,", k);
+        fprintf(features_csv, "label\n");
+    }
+
+    Corpus corpus;
+    for (const char* path : inputs) {
+        if (!load_capture(path, &corpus)) return 1;
+    }
+    if (corpus.frames.empty()) {
+        fprintf(stderr, "[REPLAY] Nenhum frame 802.11 nas entradas\n");
+        return 1;
+    }
+    if (hop) {
+        for (const ReplayFrame& fr : corpus.frames) {
+            if (!fr.channel) {
+                fprintf(stderr, "[REPLAY] --hop precisa do canal de cada frame "
+                                "(radiotap ou pcapng)\n");
+                return 1;
+            }
+        }
+    }
+
+    // Layout do SD que Pwnagotchi::initSD() cria no device
+    if (!mkdirs(sd_root + "/sd/wavepwn/handshakes") ||
+        !mkdirs(sd_root + "/sd/wavepwn/session")) {
+        fprintf(stderr, "[REPLAY] Nao foi possivel criar '%s'\n", sd_root.c_str());
+        return 1;
+    }
+
+    host_shim_set_sd_root(sd_root.c_str());
+    host_shim_set_verbose(verbose);
+    host_shim_skip_task("capture");   // a thread principal drena o ring
+    host_shim_set_time_us(1000000);   // 1 s depois do boot
+    storage_start();                  // task sd, como no initSD
+
+    if (format >= 0) capture_set_format((CaptureFormat)format);
+    capture_init();
+
+    CaptureStats cs;
+    capture_get_stats(&cs);
+    if (cs.ring_capacity == 0) {
+        fprintf(stderr, "[REPLAY] capture_init falhou\n");
+        return 1;
+    }
+    if (batch > cs.ring_capacity) batch = cs.ring_capacity;
+
+    static uint8_t pkt_buf[sizeof(wifi_promiscuous_pkt_t) + 65536];
+    wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)pkt_buf;
+
+    // Tempo virtual: relativo ao primeiro frame, monotônico entre arquivos
+    // e voltas
+    const uint64_t first_ts = corpus.frames.front().ts_us;
+    uint64_t clock_base = 1000000;
+    uint64_t last_us = clock_base;
+
+    HostShimStats before;
+    host_shim_get_stats(&before);
+    uint64_t bytes_in = 0;
+    uint64_t frames_in = 0;
+    uint64_t next_features_us = clock_base + features_ms * 1000ULL;
+    uint32_t feature_rows = 0;
+    float vec[NEURA9_FEATURE_COUNT];
+
+    uint64_t hop_missed = 0;
+    if (hop) {
+        hopping = hopper.begin(WIFI_CHANNELS, CHANNEL_COUNT, hop_dwell[0], hop_dwell[1],
+                               hop_dwell[2], strcmp(hop, "adaptive") == 0, hop_seed);
+        hop_dwell_start_us = clock_base;
+        replay_channel = hopper.channel();
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    // --rate: a task de captura numa thread. No device ela acorda com o
+    // xTaskNotifyGive de cada frame; aqui fica em polling com yield
+    std::atomic<bool> producing{true};
+    std::thread capture_thread;
+    if (rate) {
+        capture_thread = std::thread([&producing] {
+            while (producing.load(std::memory_order_acquire)) {
+                capture_poll();
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    for (uint32_t loop = 0; loop < loops; ++loop) {
+        for (const ReplayFrame& fr : corpus.frames) {
+            uint64_t now = clock_base + (fr.ts_us >= first_ts ? fr.ts_us - first_ts : 0);
+            if (now < last_us) now = last_us;
+            last_us = now;
+
+            // Uma linha por intervalo, com o ring drenado até o instante
+            // da amostra (como o snapshot do device veria)
+            while (features_csv && now >= next_features_us) {
+                host_shim_set_time_us(next_features_us);
+                capture_poll();
+                neura9_features.snapshot(vec, millis());
+                for (int k = 0; k < NEURA9_FEATURE_COUNT; ++k) {
+                    fprintf(features_csv, "%.6g,", vec[k]);
+                }
+                fprintf(features_csv, "%d\n", label);
+                feature_rows++;
+                next_features_us += features_ms * 1000ULL;
+            }
+            host_shim_set_time_us(now);
+            if (hopping) {
+                // Fora do canal do hopper o rádio não ouve o frame
+                hop_until(now);
+                if (fr.channel != hopper.channel()) {
+                    hop_missed++;
+                    continue;
+                }
+            } else if (fr.channel) {
+                replay_channel = fr.channel;
+            }
+
+            pkt->rx_ctrl.rssi = fr.rssi;
+            pkt->rx_ctrl.rate = fr.rate;
+            pkt->rx_ctrl.noise_floor = fr.noise_floor;
+            pkt->rx_ctrl.channel = fr.channel;
+            pkt->rx_ctrl.timestamp = (uint32_t)now;
+            pkt->rx_ctrl.sig_len = fr.len;
+            memcpy(pkt->payload, &corpus.bytes[fr.offset], fr.len);
+
+            // Ritmo fixo no relógio de parede. yield em vez de sleep: sleep
+            // não tem resolução para dezenas de milhares de frames/s, e o
+            // yield deixa a thread de captura rodar mesmo com um core só
+            if (rate) {
+                auto due = t0 + std::chrono::nanoseconds(frames_in * 1000000000ULL / rate);
+                while (std::chrono::steady_clock::now() < due) {
+                    std::this_thread::yield();
+                }
+            }
+
+            capture_packet_handler(pkt_buf, fr.len, fr.channel);
+            bytes_in += fr.len;
+            frames_in++;
+
+            if (hopping) {
+                // Processa já: o bump de um M1 vale a partir deste frame
+                capture_poll();
+                if (hop_pending_m1) hop_on_m1(now);
+            }
+            if (frames_in % batch == 0) {
+                if (!rate) capture_poll();
+                capture_dispatch_ui_events();
+            }
+        }
+        clock_base = last_us + 1000000;
+    }
+
+    if (rate) {
+        producing.store(false, std::memory_order_release);
+        capture_thread.join();
+    }
+    capture_poll();
+    capture_dispatch_ui_events();
+    capture_flush();
+    if (features_csv) fclose(features_csv);
+
+    auto t1 = std::chrono::steady_clock::now();
+    double wall_s = std::chrono::duration<double>(t1 - t0).count();
+
+    HostShimStats after;
+    host_shim_get_stats(&after);
+    capture_get_stats(&cs);
+
+    ApTableSummary aps;
+    ap_table.get_summary(&aps, millis());
+
+    uint64_t allocs = after.allocs - before.allocs;
+    uint64_t alloc_bytes = after.alloc_bytes - before.alloc_bytes;
+    uint64_t sd_bytes = after.sd_bytes_written - before.sd_bytes_written;
+    uint32_t sd_writes = after.sd_writes - before.sd_writes;
+    uint32_t sd_syncs = after.sd_syncs - before.sd_syncs;
+    double fps = wall_s > 0 ? frames_in / wall_s : 0;
+    double per_frame_ns = frames_in ? wall_s * 1e9 / frames_in : 0;
+    double allocs_per_frame = frames_in ? (double)allocs / frames_in : 0;
+    double capture_s = (last_us - 1000000ULL) / 1e6;
+    double handshakes_per_hour = capture_s > 0 ? pwn.handshakes * 3600.0 / capture_s : 0;
+
+    if (json) {
+        printf("{\"frames\":%llu,\"bytes_in\":%llu,\"wall_ms\":%.1f,\"fps\":%.0f,"
+               "\"ns_per_frame\":%.0f,\"allocs\":%llu,\"allocs_per_frame\":%.4f,"
+               "\"alloc_bytes\":%llu,\"sd_writes\":%u,\"sd_bytes\":%llu,\"sd_syncs\":%u,"
+               "\"pcap_bytes\":%llu,\"dropped\":%u,\"ring_max_depth\":%u,"
+               "\"pmkids\":%u,\"handshakes\":%u,\"eapol_oversize\":%u,\"aps\":%u,\"clients\":%u,"
+               "\"aps_with_handshake\":%u,\"serial_lines\":%u,\"feature_rows\":%u,"
+               "\"rate\":%u,\"hop\":\"%s\",\"hop_missed\":%llu,\"hops\":%u,\"bumps\":%u,"
+               "\"capture_s\":%.1f,\"handshakes_per_hour\":%.1f}\n",
+               (unsigned long long)frames_in, (unsigned long long)bytes_in,
+               wall_s * 1000.0, fps, per_frame_ns,
+               (unsigned long long)allocs, allocs_per_frame,
+               (unsigned long long)alloc_bytes, sd_writes, (unsigned long long)sd_bytes,
+               sd_syncs, (unsigned long long)cs.pcap_bytes, cs.frames_dropped,
+               cs.ring_max_depth, pwn.pmkids, pwn.handshakes, cs.eapol_oversize, aps.aps_total,
+               aps.clients, aps.with_handshake,
+               after.serial_lines - before.serial_lines, feature_rows, rate,
+               hop ? hop : "off", (unsigned long long)hop_missed, hopper.hops(),
+               hopper.bumps(), capture_s, handshakes_per_hour);
+    } else {
+        printf("[REPLAY] Entrada: %llu frames (%.1f MB) de %u arquivo(s), %u ignorados, "
+               "%u com FCS calculado\n",
+               (unsigned long long)frames_in, bytes_in / 1048576.0,
+               (unsigned)inputs.size(), corpus.skipped, corpus.fcs_added);
+        printf("[REPLAY] Tempo: %.1f ms -> %.0f frames/s, %.0f ns/frame, %.1f MB/s\n",
+               wall_s * 1000.0, fps, per_frame_ns,
+               wall_s > 0 ? bytes_in / 1048576.0 / wall_s : 0.0);
+        printf("[REPLAY] Alocacoes: %llu (%.4f/frame, %llu bytes)\n",
+               (unsigned long long)allocs, allocs_per_frame,
+               (unsigned long long)alloc_bytes);
+        printf("[REPLAY] SD: %llu bytes em %u writes, %u fsyncs (PCAP %llu bytes)\n",
+               (unsigned long long)sd_bytes, sd_writes, sd_syncs,
+               (unsigned long long)cs.pcap_bytes);
+        printf("[REPLAY] Ring: %u descartados, ocupacao maxima %u/%u\n",
+               cs.frames_dropped, cs.ring_max_depth, cs.ring_capacity);
+        printf("[REPLAY] Capturas: %u PMKIDs, %u handshakes, %u APs (%u com handshake), "
+               "%u clientes, %u EAPOL grandes demais\n",
+               pwn.pmkids, pwn.handshakes, aps.aps_total, aps.with_handshake, aps.clients,
+               cs.eapol_oversize);
+        printf("[REPLAY] Eventos: %u beacons, %u data, %u EAPOL (%u M1), %u BSSIDs novos; "
+               "UI %u handshakes / %u PMKIDs\n",
+               sniff_events[SNIFF_BEACON], sniff_events[SNIFF_DATA],
+               sniff_events[SNIFF_EAPOL], sniff_events[SNIFF_EAPOL_M1],
+               sniff_events[SNIFF_NEW_BSSID], ui_handshake_celebrations,
+               ui_pmkid_celebrations);
+        if (hopping) {
+            printf("[REPLAY] Hopping %s: %llu frames fora do canal, %u trocas, %u bumps; "
+                   "%.1f handshakes/h em %.0f s de captura\n",
+                   hop, (unsigned long long)hop_missed, hopper.hops(), hopper.bumps(),
+                   handshakes_per_hour, capture_s);
+        }
+        if (features_csv) {
+            printf("[REPLAY] Features: %u linhas em %s (label %d)\n", feature_rows,
+                   features_path, label);
+        }
+        printf("[REPLAY] Saida em %s/sd/wavepwn\n", sd_root.c_str());
+    }
+    fflush(stdout);
+
+    if (max_drops >= 0 && (long)cs.frames_dropped > max_drops) {
+        fprintf(stderr, "[REPLAY] FALHOU: %u frames descartados pelo ring (max %ld)\n",
+                cs.frames_dropped, max_drops);
+        fflush(stderr);
+        _exit(1);
+    }
+
+    // A task sd continua bloqueada na fila: sai sem rodar
+    // destrutores estáticos por baixo dela.
+    _exit(0);
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# ring_check.sh - Replay em ritmo de linha: o ring não pode descartar frames
+#
+# Roda o replay com --rate (callback e task de captura em threads
+# separadas) em cada taxa de RATES sobre os corpora de bench.sh, com
+# --max-drops 0: sai com 1 na primeira taxa em que o ring descartar algo.
+#
+#   tools/replay/ring_check.sh                    # até 20k frames/s
+#   RATES="5000 50000" tools/replay/ring_check.sh
+#   REPLAY=/caminho/replay PROFILES=data tools/replay/ring_check.sh
+
+set -e
+cd "$(dirname "$0")/../.."
+
+REPLAY=${REPLAY:-.pio/build/native_replay/program}
+OUT=${OUT:-.pio/replay_bench}
+DURATION=${DURATION:-30}
+PROFILES=${PROFILES:-"mixed data"}
+RATES=${RATES:-"2000 5000 20000"}
+
+if [ ! -x "$REPLAY" ]; then
+    pio run -e native_replay
+fi
+
+mkdir -p "$OUT"
+for p in $PROFILES; do
+    corpus="$OUT/${p}_${DURATION}s.pcap"
+    if [ ! -f "$corpus" ]; then
+        python3 tools/replay/gen_pcap.py -p "$p" --seconds "$DURATION" -o "$corpus" >&2
+    fi
+    for r in $RATES; do
+        rm -rf "$OUT/sd_ring"
+        printf '%-7s %7s/s ' "$p" "$r"
+        "$REPLAY" --sd "$OUT/sd_ring" --json --rate "$r" --max-drops 0 "$corpus"
+    done
+done
+echo "[RING] sem descartes em: $RATES frames/s" >&2
@@ -0,0 +1,132 @@
+#pragma once
+
+// Shim mínimo do core Arduino para compilar o motor de captura no Linux
+// (env native_replay). Só o que src/capture* usa: String, Print/Serial,
+// millis/micros com relógio virtual e IRAM_ATTR.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+
+#define IRAM_ATTR
+#define F(x) x
+
+class String {
+public:
+    String() {}
+    String(const char* s) : str(s ? s : "") {}
+    String(const std::string& s) : str(s) {}
+    explicit String(char c) : str(1, c) {}
+    explicit String(int v) : str(std::to_string(v)) {}
+    explicit String(unsigned v) : str(std::to_string(v)) {}
+    explicit String(long v) : str(std::to_string(v)) {}
+    explicit String(unsigned long v) : str(std::to_string(v)) {}
+    explicit String(long long v) : str(std::to_string(v)) {}
+    explicit String(unsigned long long v) : str(std::to_string(v)) {}
+    String(double v, unsigned int decimals) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        str = buf;
+    }
+
+    const char* c_str() const { return str.c_str(); }
+    unsigned int length() const { return (unsigned int)str.size(); }
+    bool isEmpty() const { return str.empty(); }
+    bool reserve(unsigned int n) {
+        str.reserve(n);
+        return true;
+    }
+
+    String& operator+=(const String& o) {
+        str += o.str;
+        return *this;
+    }
+    String& operator+=(const char* o) {
+        str += o ? o : "";
+        return *this;
+    }
+    String& operator+=(char c) {
+        str += c;
+        return *this;
+    }
+
+    char operator[](unsigned int i) const { return i < str.size() ? str[i] : '\0'; }
+    bool operator==(const String& o) const { return str == o.str; }
+    bool operator==(const char* o) const { return str == (o ? o : ""); }
+    bool operator!=(const String& o) const { return str != o.str; }
+    bool operator<(const String& o) const { return str < o.str; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t p = str.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    bool startsWith(const char* p) const { return str.compare(0, strlen(p), p) == 0; }
+    bool endsWith(const char* p) const {
+        size_t n = strlen(p);
+        return str.size() >= n && str.compare(str.size() - n, n, p) == 0;
+    }
+    String substring(unsigned int from, unsigned int to = 0xFFFFFFFFu) const {
+        if (from >= str.size()) return String();
+        return String(str.substr(from, to == 0xFFFFFFFFu ? std::string::npos : to - from));
+    }
+    long toInt() const { return atol(str.c_str()); }
+    void replace(const char* find, const char* with) {
+        size_t n = strlen(find), m = strlen(with);
+        if (n == 0) return;
+        for (size_t p = str.find(find); p != std::string::npos; p = str.find(find, p + m)) {
+            str.replace(p, n, with);
+        }
+    }
+
+private:
+    std::string str;
+};
+
+inline String operator+(const String& a, const String& b) {
+    String r(a);
+    r += b;
+    return r;
+}
+inline String operator+(const String& a, const char* b) {
+    String r(a);
+    r += b;
+    return r;
+}
+inline String operator+(const char* a, const String& b) {
+    String r(a);
+    r += b;
+    return r;
+}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t* data, size_t len) = 0;
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t println(const char* s = "") { return print(s) + print("\n"); }
+    size_t println(const String& s) { return println(s.c_str()); }
+};
+
+// Serial vai para stderr só com `replay -v`; sempre conta as linhas.
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// Relógio virtual (avançado pelo replay conforme os timestamps do pcap)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
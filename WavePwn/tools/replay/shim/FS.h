@@ -0,0 +1,73 @@
+#pragma once
+
+// fs::FS / File sobre arquivos POSIX. Os caminhos do firmware ("/sd/...")
+// são resolvidos dentro da raiz definida por host_shim_set_sd_root().
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2,
+};
+
+namespace fs {
+
+struct FileImpl;
+
+class File : public Print {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+    int read();
+    size_t read(uint8_t* buf, size_t len);
+    int available();
+    void flush();
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    bool setBufferSize(size_t) { return true; }   // stdio do host decide
+    size_t position() const;
+    size_t size() const;
+    void close();
+
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+
+    explicit operator bool() const;
+
+private:
+    std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) {
+        return rename(from.c_str(), to.c_str());
+    }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+};
+
+}  // namespace fs
+
+using fs::File;
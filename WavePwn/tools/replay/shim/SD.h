@@ -0,0 +1,11 @@
+#pragma once
+
+#include "FS.h"
+
+class SDFS : public fs::FS {
+public:
+    bool begin() { return true; }
+    void end() {}
+};
+
+extern SDFS SD;
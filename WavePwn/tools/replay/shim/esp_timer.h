@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Microssegundos do relógio virtual
+int64_t esp_timer_get_time(void);
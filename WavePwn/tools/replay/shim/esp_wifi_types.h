@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// Só os campos de rx_ctrl que o callback promíscuo lê. O layout não precisa
+// bater com o do IDF: o replay monta o pacote com esta mesma definição.
+typedef struct {
+    int8_t   rssi;
+    uint8_t  rate;
+    int8_t   noise_floor;
+    uint8_t  channel;
+    uint32_t timestamp;
+    uint16_t sig_len;       // inclui o FCS, como no ESP32
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+    wifi_pkt_rx_ctrl_t rx_ctrl;
+    uint8_t payload[0];
+} wifi_promiscuous_pkt_t;
+
+typedef enum {
+    WIFI_PKT_MGMT,
+    WIFI_PKT_CTRL,
+    WIFI_PKT_DATA,
+    WIFI_PKT_MISC,
+} wifi_promiscuous_pkt_type_t;
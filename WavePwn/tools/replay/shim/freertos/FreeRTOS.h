@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// FreeRTOS sobre std::thread. Ticks = ms de relógio real (não o virtual):
+// os timeouts só servem para as tasks não ficarem presas.
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  0
+#define pdPASS  1
+
+#define portMAX_DELAY      0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+#define tskNO_AFFINITY     0x7FFFFFFF
+
+// Seções críticas: um mutex recursivo global
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+void host_shim_enter_critical();
+void host_shim_exit_critical();
+#define portENTER_CRITICAL(mux) ((void)(mux), host_shim_enter_critical())
+#define portEXIT_CRITICAL(mux)  ((void)(mux), host_shim_exit_critical())
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn,
+                                   const char* name,
+                                   uint32_t stack_depth,
+                                   void* arg,
+                                   UBaseType_t priority,
+                                   TaskHandle_t* handle,
+                                   BaseType_t core);
+
+// Notificação simples (contador). Fora de uma task criada pelo shim,
+// ulTaskNotifyTake retorna 0 na hora.
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+// nullptr fora de uma task criada pelo shim
+TaskHandle_t xTaskGetCurrentTaskHandle();
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Controle e contadores do shim, usados só pelo replay.
+
+struct HostShimStats {
+    // Heap: operator new/delete e heap_caps_*
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t alloc_bytes;
+    uint64_t heap_caps_allocs;
+
+    // "SD" (arquivos POSIX)
+    uint64_t sd_bytes_written;
+    uint64_t sd_bytes_read;
+    uint32_t sd_writes;
+    uint32_t sd_reads;
+    uint32_t sd_syncs;
+    uint32_t sd_opens;
+
+    uint32_t serial_lines;
+};
+
+// Raiz no host onde "/sd/..." é resolvido. Padrão: diretório atual.
+void host_shim_set_sd_root(const char* dir);
+
+// Relógio virtual em µs (millis/micros/esp_timer_get_time).
+void host_shim_set_time_us(uint64_t us);
+uint64_t host_shim_time_us();
+
+// Serial para stderr (padrão: só conta as linhas).
+void host_shim_set_verbose(bool verbose);
+
+// Tasks com esse nome não são criadas (xTaskCreatePinnedToCore falha),
+// para o replay fazer o papel delas na thread principal.
+void host_shim_skip_task(const char* name);
+
+void host_shim_get_stats(HostShimStats* out);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+// Só os tipos que aparecem em ui.h / pwnagotchi.h; nenhuma função do LVGL é
+// chamada pelo motor de captura.
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_event_t lv_event_t;
+typedef struct {
+    int16_t x;
+    int16_t y;
+} lv_point_t;
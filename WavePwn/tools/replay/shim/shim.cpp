@@ -0,0 +1,488 @@
+// Implementação do shim de host: Arduino/SD/heap_caps/FreeRTOS sobre POSIX
+// e std::thread, com contadores para o relatório do replay.
+
+#include "host_shim.h"
+
+#include <Arduino.h>
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// Contadores
+// -----------------------------------------------------------------------------
+
+static std::atomic<uint64_t> c_allocs{0};
+static std::atomic<uint64_t> c_frees{0};
+static std::atomic<uint64_t> c_alloc_bytes{0};
+static std::atomic<uint64_t> c_heap_caps_allocs{0};
+static std::atomic<uint64_t> c_sd_bytes_written{0};
+static std::atomic<uint64_t> c_sd_bytes_read{0};
+static std::atomic<uint32_t> c_sd_writes{0};
+static std::atomic<uint32_t> c_sd_reads{0};
+static std::atomic<uint32_t> c_sd_syncs{0};
+static std::atomic<uint32_t> c_sd_opens{0};
+static std::atomic<uint32_t> c_serial_lines{0};
+
+void host_shim_get_stats(HostShimStats* out) {
+    out->allocs = c_allocs.load();
+    out->frees = c_frees.load();
+    out->alloc_bytes = c_alloc_bytes.load();
+    out->heap_caps_allocs = c_heap_caps_allocs.load();
+    out->sd_bytes_written = c_sd_bytes_written.load();
+    out->sd_bytes_read = c_sd_bytes_read.load();
+    out->sd_writes = c_sd_writes.load();
+    out->sd_reads = c_sd_reads.load();
+    out->sd_syncs = c_sd_syncs.load();
+    out->sd_opens = c_sd_opens.load();
+    out->serial_lines = c_serial_lines.load();
+}
+
+// operator new/delete sobre malloc/free de propósito
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static inline void* counted_malloc(size_t n) {
+    c_allocs.fetch_add(1, std::memory_order_relaxed);
+    c_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    return malloc(n ? n : 1);
+}
+
+static inline void counted_free(void* p) {
+    if (!p) return;
+    c_frees.fetch_add(1, std::memory_order_relaxed);
+    free(p);
+}
+
+void* operator new(size_t n) {
+    void* p = counted_malloc(n);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) {
+    void* p = counted_malloc(n);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return counted_malloc(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return counted_malloc(n); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+
+// -----------------------------------------------------------------------------
+// Relógio virtual e Serial
+// -----------------------------------------------------------------------------
+
+static std::atomic<uint64_t> virtual_us{0};
+static bool serial_verbose = false;
+
+void host_shim_set_time_us(uint64_t us) { virtual_us.store(us, std::memory_order_relaxed); }
+uint64_t host_shim_time_us() { return virtual_us.load(std::memory_order_relaxed); }
+void host_shim_set_verbose(bool verbose) { serial_verbose = verbose; }
+
+unsigned long millis() { return (unsigned long)(host_shim_time_us() / 1000ULL); }
+unsigned long micros() { return (unsigned long)host_shim_time_us(); }
+int64_t esp_timer_get_time(void) { return (int64_t)host_shim_time_us(); }
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '\n') c_serial_lines.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (serial_verbose) fwrite(data, 1, len, stderr);
+    return len;
+}
+
+size_t Print::printf(const char* fmt, ...) {
+    char small[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(small, sizeof(small), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, (size_t)n);
+
+    std::vector<char> big((size_t)n + 1);
+    va_start(ap, fmt);
+    vsnprintf(big.data(), big.size(), fmt, ap);
+    va_end(ap);
+    return write((const uint8_t*)big.data(), (size_t)n);
+}
+
+// -----------------------------------------------------------------------------
+// heap_caps
+// -----------------------------------------------------------------------------
+
+void* heap_caps_malloc(size_t size, uint32_t) {
+    c_heap_caps_allocs.fetch_add(1, std::memory_order_relaxed);
+    return counted_malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* p = heap_caps_malloc(n * size, caps);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t) {
+    c_heap_caps_allocs.fetch_add(1, std::memory_order_relaxed);
+    c_allocs.fetch_add(1, std::memory_order_relaxed);
+    c_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void heap_caps_free(void* ptr) { counted_free(ptr); }
+
+size_t heap_caps_get_free_size(uint32_t) { return 8u * 1024 * 1024; }
+
+// -----------------------------------------------------------------------------
+// SD -> POSIX
+// -----------------------------------------------------------------------------
+
+SDFS SD;
+fs::FS& SDCARD = SD;   // storage.h: no firmware, o cartão SDMMC
+
+static std::string sd_root = ".";
+
+void host_shim_set_sd_root(const char* dir) { sd_root = dir ? dir : "."; }
+
+static std::string host_path(const char* path) {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    return sd_root + p;
+}
+
+namespace fs {
+
+struct FileImpl {
+    FILE* fp = nullptr;
+    DIR* dir = nullptr;
+    std::string path;       // caminho do firmware ("/sd/...")
+    std::string name;       // basename, como no arduino-esp32 2.x
+
+    ~FileImpl() {
+        if (fp) fclose(fp);
+        if (dir) closedir(dir);
+    }
+};
+
+static std::shared_ptr<FileImpl> open_impl(const std::string& path, const char* mode) {
+    std::string host = host_path(path.c_str());
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path;
+    size_t slash = path.find_last_of('/');
+    impl->name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    struct stat st;
+    if (mode[0] == 'r' && stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(host.c_str());
+        if (!impl->dir) return nullptr;
+    } else {
+        std::string m = mode;
+        m += 'b';
+        impl->fp = fopen(host.c_str(), m.c_str());
+        if (!impl->fp) return nullptr;
+    }
+    c_sd_opens.fetch_add(1, std::memory_order_relaxed);
+    return impl;
+}
+
+size_t File::write(const uint8_t* data, size_t len) {
+    if (!impl || !impl->fp) return 0;
+    size_t w = fwrite(data, 1, len, impl->fp);
+    c_sd_writes.fetch_add(1, std::memory_order_relaxed);
+    c_sd_bytes_written.fetch_add(w, std::memory_order_relaxed);
+    return w;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+    if (!impl || !impl->fp) return 0;
+    size_t r = fread(buf, 1, len, impl->fp);
+    c_sd_reads.fetch_add(1, std::memory_order_relaxed);
+    c_sd_bytes_read.fetch_add(r, std::memory_order_relaxed);
+    return r;
+}
+
+int File::available() {
+    if (!impl || !impl->fp) return 0;
+    return (int)(size() - position());
+}
+
+// fflush sem fsync: o custo de sincronizar o disco do host não diz nada
+// sobre o SD, só a quantidade de syncs interessa.
+void File::flush() {
+    if (!impl || !impl->fp) return;
+    fflush(impl->fp);
+    c_sd_syncs.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl || !impl->fp) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(impl->fp, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!impl || !impl->fp) return 0;
+    long p = ftell(impl->fp);
+    return p < 0 ? 0 : (size_t)p;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->fp) return 0;
+    fflush(impl->fp);
+    struct stat st;
+    if (fstat(fileno(impl->fp), &st) != 0) return 0;
+    return (size_t)st.st_size;
+}
+
+void File::close() { impl.reset(); }
+
+const char* File::name() const { return impl ? impl->name.c_str() : ""; }
+const char* File::path() const { return impl ? impl->path.c_str() : ""; }
+bool File::isDirectory() const { return impl && impl->dir; }
+
+File File::openNextFile(const char* mode) {
+    if (!impl || !impl->dir) return File();
+    for (;;) {
+        struct dirent* e = readdir(impl->dir);
+        if (!e) return File();
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        auto child = open_impl(impl->path + "/" + e->d_name, mode);
+        if (child) return File(child);
+    }
+}
+
+File::operator bool() const { return impl && (impl->fp || impl->dir); }
+
+File FS::open(const char* path, const char* mode, bool) {
+    auto impl = open_impl(path ? path : "", mode ? mode : FILE_READ);
+    return impl ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(host_path(path).c_str(), &st) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir(host_path(path).c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool FS::remove(const char* path) { return ::unlink(host_path(path).c_str()) == 0; }
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(host_path(from).c_str(), host_path(to).c_str()) == 0;
+}
+
+bool FS::rmdir(const char* path) { return ::rmdir(host_path(path).c_str()) == 0; }
+
+}  // namespace fs
+
+// -----------------------------------------------------------------------------
+// FreeRTOS
+// -----------------------------------------------------------------------------
+
+static std::recursive_mutex critical_mutex;
+
+void host_shim_enter_critical() { critical_mutex.lock(); }
+void host_shim_exit_critical() { critical_mutex.unlock(); }
+
+template <typename Pred>
+static bool wait_ticks(std::condition_variable& cv,
+                       std::unique_lock<std::mutex>& lock,
+                       TickType_t ticks,
+                       Pred pred) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, pred);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+struct HostTask {
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t notify = 0;
+};
+
+static thread_local HostTask* current_task = nullptr;
+static std::vector<std::string> skipped_tasks;
+
+void host_shim_skip_task(const char* name) { skipped_tasks.push_back(name); }
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn,
+                                   const char* name,
+                                   uint32_t,
+                                   void* arg,
+                                   UBaseType_t,
+                                   TaskHandle_t* handle,
+                                   BaseType_t) {
+    for (const std::string& s : skipped_tasks) {
+        if (s == name) return pdFAIL;
+    }
+
+    HostTask* task = new HostTask();   // vive até o fim do processo
+    if (handle) *handle = task;
+    std::thread([fn, arg, task]() {
+        current_task = task;
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    HostTask* task = current_task;
+    if (!task) return 0;
+
+    std::unique_lock<std::mutex> lock(task->m);
+    wait_ticks(task->cv, lock, ticks, [task] { return task->notify > 0; });
+    uint32_t value = task->notify;
+    if (value) task->notify = clear_on_exit ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+    HostTask* task = static_cast<HostTask*>(handle);
+    if (!task) return pdFAIL;
+    {
+        std::lock_guard<std::mutex> lock(task->m);
+        task->notify++;
+    }
+    task->cv.notify_one();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return current_task; }
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+// Fila com buffer circular pré-alocado (sem alocação por item, para não
+// poluir a contagem de alocações do replay)
+struct HostQueue {
+    std::mutex m;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::vector<uint8_t> storage;
+    UBaseType_t length = 0;
+    UBaseType_t item_size = 0;
+    UBaseType_t head = 0;
+    UBaseType_t count = 0;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    HostQueue* q = new HostQueue();
+    q->storage.resize((size_t)length * item_size);
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t ticks) {
+    HostQueue* q = static_cast<HostQueue*>(handle);
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!wait_ticks(q->not_full, lock, ticks, [q] { return q->count < q->length; })) {
+        return pdFALSE;
+    }
+    UBaseType_t slot = (q->head + q->count) % q->length;
+    memcpy(&q->storage[(size_t)slot * q->item_size], item, q->item_size);
+    q->count++;
+    lock.unlock();
+    q->not_empty.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t ticks) {
+    HostQueue* q = static_cast<HostQueue*>(handle);
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!wait_ticks(q->not_empty, lock, ticks, [q] { return q->count > 0; })) {
+        return pdFALSE;
+    }
+    memcpy(item, &q->storage[(size_t)q->head * q->item_size], q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    lock.unlock();
+    q->not_full.notify_one();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle) {
+    HostQueue* q = static_cast<HostQueue*>(handle);
+    std::lock_guard<std::mutex> lock(q->m);
+    return q->count;
+}
+
+struct HostSemaphore {
+    std::mutex m;
+    std::condition_variable cv;
+    UBaseType_t count = 0;
+    UBaseType_t max_count = 1;
+};
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial) {
+    HostSemaphore* s = new HostSemaphore();
+    s->max_count = max_count;
+    s->count = initial;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return xSemaphoreCreateCounting(1, 0); }
+SemaphoreHandle_t xSemaphoreCreateMutex() { return xSemaphoreCreateCounting(1, 1); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks) {
+    HostSemaphore* s = static_cast<HostSemaphore*>(handle);
+    std::unique_lock<std::mutex> lock(s->m);
+    if (!wait_ticks(s->cv, lock, ticks, [s] { return s->count > 0; })) {
+        return pdFALSE;
+    }
+    s->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle) {
+    HostSemaphore* s = static_cast<HostSemaphore*>(handle);
+    {
+        std::lock_guard<std::mutex> lock(s->m);
+        if (s->count >= s->max_count) return pdFALSE;
+        s->count++;
+    }
+    s->cv.notify_one();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle) {
+    delete static_cast<HostSemaphore*>(handle);
+}
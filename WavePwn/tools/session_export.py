@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+session_export.py - Exporta os logs de sessão binários do WavePwn
+
+Lê os arquivos /sd/wavepwn/session/session_NNNNN.bin (ver
+src/capture/session_log.h) e gera, sob demanda, os arquivos que antes eram
+escritos evento a evento no cartão:
+
+    handshakes.22000   linhas WPA*02* (hashcat -m 22000), melhor par por AP/STA
+    pmkid.16800        linhas WPA*01* (hashcat -m 16800 / 22000)
+    handshakes.jsonl   metadados de cada handshake
+    pmkid.jsonl        metadados de cada PMKID
+    aps.jsonl          BSSID -> SSID aprendidos
+
+Registros truncados/corrompidos (queda de energia) encerram a leitura do
+arquivo; tudo antes deles é exportado.
+
+Uso:
+    $ python3 tools/session_export.py /media/sd/wavepwn/session -o export/
+"""
+
+import argparse
+import json
+import pathlib
+import struct
+import sys
+import zlib
+
+
+FILE_HEADER = struct.Struct("<4sHHII")
+RECORD_HEADER = struct.Struct("<HBB")
+AP_RECORD = struct.Struct("<6sBB32sQ")
+PMKID_RECORD = struct.Struct("<16s6s6sB32sQ")
+HANDSHAKE_RECORD = struct.Struct("<6s6s32s16sBBBB32sQH")
+
+MAGIC = b"WPSL"
+VERSION = 1
+
+REC_AP = 1
+REC_PMKID = 2
+REC_HANDSHAKE = 3
+
+# Mesma ordem de preferência do HandshakeTracker (maior = melhor)
+PAIR_RANK = {0x02: 4, 0x00: 3, 0x05: 2, 0x01: 1}
+
+
+def mac(b: bytes) -> str:
+    return b.hex()
+
+
+def read_records(path: pathlib.Path):
+    """Gera (session_id, tipo, payload) de um arquivo de sessão."""
+    data = path.read_bytes()
+    if len(data) < FILE_HEADER.size:
+        return
+    magic, version, header_len, session_id, _epoch = FILE_HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        print(f"[export] ignorando {path.name}: cabeçalho inválido", file=sys.stderr)
+        return
+
+    off = header_len
+    while off < len(data):
+        if off + RECORD_HEADER.size > len(data):
+            print(f"[export] {path.name}: cauda truncada em {off}", file=sys.stderr)
+            return
+        length, rtype, _flags = RECORD_HEADER.unpack_from(data, off)
+        end = off + RECORD_HEADER.size + length
+        if end + 4 > len(data):
+            print(f"[export] {path.name}: cauda truncada em {off}", file=sys.stderr)
+            return
+        (crc,) = struct.unpack_from("<I", data, end)
+        if zlib.crc32(data[off:end]) != crc:
+            print(f"[export] {path.name}: CRC inválido em {off}", file=sys.stderr)
+            return
+        yield session_id, rtype, data[off + RECORD_HEADER.size:end]
+        off = end + 4
+
+
+def export(session_dir: pathlib.Path, out_dir: pathlib.Path) -> None:
+    out_dir.mkdir(parents=True, exist_ok=True)
+
+    best = {}          # (ap, sta) -> (rank, linha 22000)
+    pmkid_lines = {}   # linha -> None (ordem de chegada, sem repetição)
+    hs_meta, pmkid_meta, aps = [], [], []
+
+    for path in sorted(session_dir.glob("session_*.bin")):
+        for session_id, rtype, payload in read_records(path):
+            if rtype == REC_HANDSHAKE and len(payload) >= HANDSHAKE_RECORD.size:
+                (ap, sta, anonce, mic, keyver, pair, authorized, ssid_len, ssid,
+                 ts, eapol_len) = HANDSHAKE_RECORD.unpack_from(payload)
+                eapol = payload[HANDSHAKE_RECORD.size:HANDSHAKE_RECORD.size + eapol_len]
+                essid = ssid[:ssid_len]
+                line = "WPA*02*{}*{}*{}*{}*{}*{}*{:02x}".format(
+                    mic.hex(), mac(ap), mac(sta), essid.hex(),
+                    anonce.hex(), eapol.hex(), pair)
+                rank = PAIR_RANK.get(pair, 0)
+                key = (ap, sta)
+                if key not in best or rank >= best[key][0]:
+                    best[key] = (rank, line)
+                hs_meta.append({
+                    "type": "handshake", "session": session_id,
+                    "ap": mac(ap), "sta": mac(sta),
+                    "ssid": essid.decode("utf-8", "replace"),
+                    "keyver": keyver, "pair": pair,
+                    "authorized": bool(authorized), "timestamp": ts,
+                })
+            elif rtype == REC_PMKID and len(payload) >= PMKID_RECORD.size:
+                pmkid, ap, sta, ssid_len, ssid, ts = PMKID_RECORD.unpack_from(payload)
+                essid = ssid[:ssid_len]
+                line = "WPA*01*{}*{}*{}*{}".format(
+                    pmkid.hex(), mac(ap), mac(sta), essid.hex())
+                pmkid_lines[line] = None
+                pmkid_meta.append({
+                    "type": "pmkid", "session": session_id,
+                    "ap": mac(ap), "sta": mac(sta),
+                    "ssid": essid.decode("utf-8", "replace"), "timestamp": ts,
+                })
+            elif rtype == REC_AP and len(payload) >= AP_RECORD.size:
+                bssid, channel, ssid_len, ssid, ts = AP_RECORD.unpack_from(payload)
+                aps.append({
+                    "type": "ap", "session": session_id, "bssid": mac(bssid),
+                    "ssid": ssid[:ssid_len].decode("utf-8", "replace"),
+                    "channel": channel, "timestamp": ts,
+                })
+
+    def write_lines(name, lines):
+        with open(out_dir / name, "w", encoding="utf-8") as f:
+            for line in lines:
+                f.write(line + "\n")
+
+    write_lines("handshakes.22000", (line for _, line in best.values()))
+    write_lines("pmkid.16800", pmkid_lines.keys())
+    write_lines("handshakes.jsonl", (json.dumps(m) for m in hs_meta))
+    write_lines("pmkid.jsonl", (json.dumps(m) for m in pmkid_meta))
+    write_lines("aps.jsonl", (json.dumps(m) for m in aps))
+
+    print(f"[export] {len(best)} handshakes, {len(pmkid_lines)} PMKIDs, "
+          f"{len(aps)} APs -> {out_dir}")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Exporta logs de sessão do WavePwn")
+    parser.add_argument("session_dir", type=pathlib.Path,
+                        help="diretório com session_*.bin (cópia de /sd/wavepwn/session)")
+    parser.add_argument("-o", "--out", type=pathlib.Path, default=pathlib.Path("export"),
+                        help="diretório de saída (padrão: ./export)")
+    args = parser.parse_args()
+    export(args.session_dir, args.out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,393 @@
+/*
+  event_log_bench.cpp - Anel de eventos (src/utils/event_log.cpp) no host
+
+  Sobe a task sd real (storage.cpp, FreeRTOS do shim do replay) e compara,
+  para a mesma carga de eventos vindos de várias tasks:
+
+    legacy   o lab_log_event antigo: um job por evento que abre
+             /sd/lab_logs/<tag>.log, anexa a linha e fecha (no FATFS o
+             close grava a entrada de diretório e a FAT)
+    ring     event_log_append() + event_log_poll(), como no firmware
+
+  Depois confere o anel: todo evento aceito aparece uma vez, em ordem, com
+  seq consecutivos; leitura a partir de seq no meio e de seq já
+  sobrescrito (a carga padrão dá mais de uma volta no arquivo); e a
+  recuperação em um novo begin(), inclusive com o último registro cortado
+  no meio (queda de energia durante o write).
+
+  Uso:
+    pio run -e native_event_log
+    .pio/build/native_event_log/program [--events N] [--threads T]
+        [--interval-us U] [--json] [DIR]
+*/
+
+#include <Arduino.h>
+
+#include "storage.h"
+#include "utils/event_log.h"
+
+#include "host_shim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static int events = 24000;
+static int threads = 4;
+static int interval_us = 200;
+static bool json = false;
+static std::string dir = "event_log_sd";
+
+static std::atomic<bool> running{true};
+static const Clock::time_point t0 = Clock::now();
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+static void clock_thread() {
+    while (running.load()) {
+        host_shim_set_time_us((uint64_t)now_us());
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+struct PhaseResult {
+    uint32_t accepted = 0;
+    uint32_t dropped = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+    uint32_t opens = 0;
+    uint32_t writes = 0;
+    uint32_t syncs = 0;
+    uint64_t bytes = 0;
+    double elapsed_ms = 0;
+};
+
+// Texto parecido com os do lab: "tag;detalhes" com tamanho variável
+static void make_text(char* out, size_t cap, int thread, int i) {
+    snprintf(out, cap, "deauth_burst_sim;t%d;n%d;bssid=AA:BB:CC:%02X:%02X:%02X;frames=%d",
+             thread, i, (i >> 8) & 0xFF, i & 0xFF, thread, (i * 37) % 500);
+}
+
+typedef bool (*AppendFn)(int thread, int i);
+
+static PhaseResult run_phase(AppendFn fn, bool poll) {
+    HostShimStats before;
+    host_shim_get_stats(&before);
+
+    std::vector<std::vector<double>> lat(threads);
+    std::vector<uint32_t> accepted(threads, 0);
+    std::atomic<bool> producing{true};
+    double start = now_us();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            int per_thread = events / threads;
+            lat[t].reserve(per_thread);
+            for (int i = 0; i < per_thread; ++i) {
+                double a = now_us();
+                bool ok = fn(t, i);
+                lat[t].push_back(now_us() - a);
+                if (ok) accepted[t]++;
+                std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+            }
+        });
+    }
+    // Loop da UI: event_log_poll a cada volta (~5 ms)
+    std::thread ui([&]() {
+        while (producing.load()) {
+            if (poll) event_log_poll(millis());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+    for (auto& w : workers) w.join();
+    producing = false;
+    ui.join();
+
+    // Espera a task sd terminar o que ficou na fila
+    if (poll) {
+        EventRecord rec;
+        uint32_t next;
+        event_log_read(0xFFFFFFFF, &rec, 1, &next);
+    } else {
+        storage_call(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, [](void*) {}, nullptr);
+    }
+
+    PhaseResult r;
+    r.elapsed_ms = (now_us() - start) / 1000.0;
+    std::vector<double> all;
+    for (int t = 0; t < threads; ++t) {
+        all.insert(all.end(), lat[t].begin(), lat[t].end());
+        r.accepted += accepted[t];
+    }
+    r.dropped = (uint32_t)all.size() - r.accepted;
+    std::sort(all.begin(), all.end());
+    if (!all.empty()) {
+        r.p50_us = all[all.size() / 2];
+        r.p99_us = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+        r.max_us = all.back();
+    }
+
+    HostShimStats after;
+    host_shim_get_stats(&after);
+    r.opens = after.sd_opens - before.sd_opens;
+    r.writes = after.sd_writes - before.sd_writes;
+    r.syncs = after.sd_syncs - before.sd_syncs;
+    r.bytes = after.sd_bytes_written - before.sd_bytes_written;
+    return r;
+}
+
+// --- legacy: um job por evento (o lab_log_event antes do anel) ---
+
+struct LegacyJob {
+    char path[64];
+    char line[192];
+};
+
+static void legacy_write(void* arg) {
+    LegacyJob* job = (LegacyJob*)arg;
+    File f = SDCARD.open(job->path, FILE_APPEND);
+    if (!f) return;
+    size_t n = f.print(job->line);
+    f.close();
+    storage_account(0, n);
+}
+
+static void legacy_free(void* arg) {
+    delete (LegacyJob*)arg;
+}
+
+static bool legacy_append(int thread, int i) {
+    LegacyJob* job = new LegacyJob;
+    snprintf(job->path, sizeof(job->path), "/sd/lab_logs/legacy_t%d.log", thread);
+    char text[EVENT_LOG_TEXT_MAX];
+    make_text(text, sizeof(text), thread, i);
+    snprintf(job->line, sizeof(job->line), "%lu;%s\n", (unsigned long)(millis() / 1000), text);
+    if (!storage_submit(STORAGE_PRIO_LOG, STORAGE_CLIENT_LOG, legacy_write, job, legacy_free)) {
+        delete job;
+        return false;
+    }
+    return true;
+}
+
+static bool ring_append(int thread, int i) {
+    char text[EVENT_LOG_TEXT_MAX];
+    make_text(text, sizeof(text), thread, i);
+    return event_log_append(EVENT_SRC_LAB, text);
+}
+
+// --- verificação ---
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "[EVLOG] FALHOU: %s\n", what);
+        failures++;
+    }
+}
+
+// Lê tudo a partir de `from` em páginas de 32
+static std::vector<EventRecord> read_all(uint32_t from, uint32_t* next_out) {
+    std::vector<EventRecord> out;
+    std::vector<EventRecord> page(32);
+    uint32_t next = from;
+    for (;;) {
+        size_t n = event_log_read(next, page.data(), page.size(), &next);
+        out.insert(out.end(), page.begin(), page.begin() + n);
+        if (n < page.size()) break;
+    }
+    if (next_out) *next_out = next;
+    return out;
+}
+
+// Cada thread aparece com os índices em ordem; seq sem buracos
+static void verify_ring(const std::vector<EventRecord>& recs, uint32_t first, uint32_t next,
+                        uint32_t accepted_total) {
+    check(!recs.empty(), "anel vazio");
+    if (recs.empty()) return;
+    check(recs.front().seq == first, "primeiro seq lido != first_seq");
+    check(recs.back().seq + 1 == next, "ultimo seq lido + 1 != next_seq");
+    std::vector<int> last(threads, -1);
+    uint32_t lab = 0;
+    for (size_t i = 0; i < recs.size(); ++i) {
+        if (i > 0 && recs[i].seq != recs[i - 1].seq + 1) {
+            check(false, "seq fora de ordem");
+            return;
+        }
+        if (recs[i].source != EVENT_SRC_LAB) continue;
+        int t, n;
+        if (sscanf(recs[i].text, "deauth_burst_sim;t%d;n%d;", &t, &n) != 2 || t < 0 || t >= threads) {
+            check(false, "texto corrompido");
+            return;
+        }
+        char expect[EVENT_LOG_TEXT_MAX];
+        make_text(expect, sizeof(expect), t, n);
+        check(strcmp(expect, recs[i].text) == 0, "texto diferente do enviado");
+        check(n > last[t], "eventos de uma thread fora de ordem");
+        last[t] = n;
+        lab++;
+    }
+    // Sem volta no anel, todo evento aceito tem que estar lá
+    if (first == 1) {
+        check(lab == accepted_total, "eventos aceitos faltando no anel");
+    }
+}
+
+static std::string ring_path() {
+    return dir + EVENT_LOG_PATH;
+}
+
+static void print_phase(const char* name, const PhaseResult& r, int total) {
+    if (json) {
+        printf("\"%s\":{\"accepted\":%u,\"dropped\":%u,\"append_p50_us\":%.2f,"
+               "\"append_p99_us\":%.2f,\"append_max_us\":%.1f,\"opens\":%u,\"writes\":%u,"
+               "\"syncs\":%u,\"bytes\":%llu,\"writes_per_event\":%.3f,\"ms\":%.0f}",
+               name, r.accepted, r.dropped, r.p50_us, r.p99_us, r.max_us, r.opens, r.writes,
+               r.syncs, (unsigned long long)r.bytes, r.accepted ? (double)r.writes / r.accepted : 0,
+               r.elapsed_ms);
+        return;
+    }
+    printf("  %-7s %6u/%d aceitos  append p50 %6.2f us p99 %7.2f us max %8.1f us\n"
+           "          opens %6u  writes %6u  syncs %6u  (%.3f writes/evento, %llu bytes)\n",
+           name, r.accepted, total, r.p50_us, r.p99_us, r.max_us, r.opens, r.writes, r.syncs,
+           r.accepted ? (double)r.writes / r.accepted : 0, (unsigned long long)r.bytes);
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--events" && has) events = atoi(argv[++i]);
+        else if (a == "--threads" && has) threads = std::max(1, atoi(argv[++i]));
+        else if (a == "--interval-us" && has) interval_us = atoi(argv[++i]);
+        else if (a == "--json") json = true;
+        else if (a[0] != '-') dir = a;
+        else {
+            fprintf(stderr, "uso: %s [--events N] [--threads T] [--interval-us U] [--json] [DIR]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    ::mkdir(dir.c_str(), 0755);
+    host_shim_set_sd_root(dir.c_str());
+    SDCARD.mkdir("/sd");
+    SDCARD.mkdir("/sd/lab_logs");
+    remove(ring_path().c_str());
+
+    std::thread clock(clock_thread);
+    storage_start();
+
+    PhaseResult legacy = run_phase(legacy_append, false);
+
+    check(event_log_begin(), "event_log_begin");
+    PhaseResult ring = run_phase(ring_append, true);
+
+    EventLogStats stats;
+    event_log_get_stats(&stats);
+    uint32_t next = 0;
+    std::vector<EventRecord> recs = read_all(0, &next);
+    check(next == stats.next_seq, "next da leitura != next_seq");
+    verify_ring(recs, stats.first_seq, stats.next_seq, ring.accepted);
+    bool wrapped = stats.first_seq > 1;
+
+    // Leitura no meio: começa exatamente no seq pedido
+    if (!recs.empty()) {
+        uint32_t mid = recs[recs.size() / 2].seq;
+        EventRecord rec;
+        uint32_t n = 0;
+        check(event_log_read(mid, &rec, 1, &n) == 1 && rec.seq == mid && n == mid + 1,
+              "leitura a partir de um seq no meio");
+    }
+    // Seq já sobrescrito: volta para o mais antigo
+    if (wrapped) {
+        EventRecord rec;
+        uint32_t n = 0;
+        check(event_log_read(1, &rec, 1, &n) == 1 && rec.seq == stats.first_seq,
+              "leitura de seq sobrescrito");
+    }
+    // Seq à frente do fim: nada, e next_seq para o cliente se realinhar
+    {
+        EventRecord rec;
+        uint32_t n = 0;
+        check(event_log_read(stats.next_seq + 100, &rec, 1, &n) == 0 && n == stats.next_seq,
+              "leitura depois do fim");
+    }
+
+    // Recuperação: novo begin acha o mesmo fim e grava o "boot" em seguida
+    uint32_t before_next = stats.next_seq;
+    check(event_log_begin(), "event_log_begin (reabertura)");
+    std::vector<EventRecord> tail = read_all(before_next - 1, &next);
+    check(tail.size() == 2 && tail[0].seq == before_next - 1 && tail[1].seq == before_next &&
+          strcmp(tail[1].text, "boot") == 0, "recuperacao depois de reabrir");
+
+    // Queda de energia no meio do último write: o registro cortado some e
+    // o próximo ocupa o lugar dele
+    EventRecord last = tail.back();
+    uint32_t rec_size = 12 + ((last.len + 3) & ~3u) + 4;
+    FILE* f = fopen(ring_path().c_str(), "r+b");
+    bool torn = false;
+    if (f) {
+        // Acha o registro pelo seq e zera o CRC dele
+        std::vector<uint8_t> buf(EVENT_LOG_SEGMENT_SIZE);
+        for (uint32_t s = 0; s < EVENT_LOG_SEGMENTS && !torn; ++s) {
+            fseek(f, (long)s * EVENT_LOG_SEGMENT_SIZE, SEEK_SET);
+            if (fread(buf.data(), 1, buf.size(), f) != buf.size()) break;
+            for (uint32_t off = 16; off + rec_size <= buf.size(); off += 4) {
+                uint32_t seq;
+                memcpy(&seq, &buf[off], 4);
+                uint16_t len;
+                memcpy(&len, &buf[off + 10], 2);
+                if (seq == last.seq && len == last.len &&
+                    memcmp(&buf[off + 12], last.text, last.len) == 0) {
+                    static const uint8_t zero[4] = {0, 0, 0, 0};
+                    fseek(f, (long)s * EVENT_LOG_SEGMENT_SIZE + off + rec_size - 4, SEEK_SET);
+                    fwrite(zero, 1, 4, f);
+                    torn = true;
+                    break;
+                }
+            }
+        }
+        fclose(f);
+    }
+    check(torn, "registro para cortar nao encontrado");
+    check(event_log_begin(), "event_log_begin (depois do corte)");
+    tail = read_all(last.seq - 1, &next);
+    check(tail.size() == 2 && tail[1].seq == last.seq && strcmp(tail[1].text, "boot") == 0,
+          "recuperacao depois de registro cortado");
+    event_log_get_stats(&stats);
+
+    running = false;
+    clock.join();
+
+    if (json) {
+        printf("{\"events\":%d,\"threads\":%d,\"interval_us\":%d,", events, threads, interval_us);
+        print_phase("legacy", legacy, events);
+        printf(",");
+        print_phase("ring", ring, events);
+        printf(",\"ring_first\":%u,\"ring_next\":%u,\"wrapped\":%s,\"batches\":%u,\"ok\":%s}\n",
+               stats.first_seq, stats.next_seq, wrapped ? "true" : "false", stats.batches,
+               failures ? "false" : "true");
+    } else {
+        printf("[EVLOG] %d eventos de %d threads, um a cada %d us por thread\n", events, threads,
+               interval_us);
+        print_phase("legacy", legacy, events);
+        print_phase("ring", ring, events);
+        printf("[EVLOG] anel: seq %u..%u (%s), %u lotes; verificacao %s\n", stats.first_seq,
+               stats.next_seq - 1, wrapped ? "deu a volta" : "sem volta", stats.batches,
+               failures ? "FALHOU" : "ok");
+    }
+    return failures ? 1 : 0;
+}
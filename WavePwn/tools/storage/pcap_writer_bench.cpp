@@ -0,0 +1,271 @@
+/*
+  pcap_writer_bench.cpp - PcapWriter x um write() por frame, no host
+
+  Grava os frames de um pcap clássico (LINKTYPE 105, como os corpora de
+  tools/replay/bench.sh) de dois jeitos num diretório local:
+
+    direto   o caminho antigo: um writev() (cabeçalho + frame) por registro
+    writer   src/capture/pcap_writer.cpp com a task sd do storage.cpp: os
+             registros vão para os buffers de 16 KB e o SD recebe blocos
+
+  e imprime registros/s e as syscalls de escrita de cada um (syscw de
+  /proc/self/io, que soma todas as threads). Os dois arquivos têm que sair
+  idênticos byte a byte; se não, sai com 1.
+
+  No host o write() cai no page cache: o ganho medido é só o de syscalls e
+  cópias. No cartão cada write pequeno ainda custa um ciclo de FATFS/SDMMC.
+
+  Uso:
+    pio run -e native_pcap_writer
+    .pio/build/native_pcap_writer/program [--passes N] [--json] [--dir DIR] captura.pcap
+*/
+
+#include <Arduino.h>
+
+#include "capture/pcap_writer.h"
+#include "storage.h"
+
+#include "host_shim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Frame {
+    uint64_t ts_us;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t orig_len;
+};
+
+static std::vector<uint8_t> bytes;
+static std::vector<Frame> frames;
+
+static bool load_pcap(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t gh[24];
+    uint32_t magic = 0, linktype = 0;
+    if (fread(gh, 1, sizeof(gh), f) != sizeof(gh)) {
+        fclose(f);
+        return false;
+    }
+    memcpy(&magic, gh, 4);
+    memcpy(&linktype, gh + 20, 4);
+    if (magic != 0xa1b2c3d4 || linktype != 105) {
+        fprintf(stderr, "[BENCH] %s: só pcap clássico little-endian, LINKTYPE 105\n", path);
+        fclose(f);
+        return false;
+    }
+    uint8_t rh[16];
+    while (fread(rh, 1, sizeof(rh), f) == sizeof(rh)) {
+        uint32_t sec, usec, caplen, orig;
+        memcpy(&sec, rh, 4);
+        memcpy(&usec, rh + 4, 4);
+        memcpy(&caplen, rh + 8, 4);
+        memcpy(&orig, rh + 12, 4);
+        Frame fr = {(uint64_t)sec * 1000000ULL + usec, (uint32_t)bytes.size(), caplen, orig};
+        bytes.resize(bytes.size() + caplen);
+        if (fread(&bytes[fr.offset], 1, caplen, f) != caplen) {
+            bytes.resize(fr.offset);
+            break;
+        }
+        frames.push_back(fr);
+    }
+    fclose(f);
+    return true;
+}
+
+// Escritas (syscalls write/writev/pwrite) feitas pelo processo até agora
+static uint64_t write_syscalls() {
+    FILE* f = fopen("/proc/self/io", "r");
+    if (!f) return 0;
+    char line[128];
+    unsigned long long v = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "syscw: %llu", &v) == 1) break;
+    }
+    fclose(f);
+    return v;
+}
+
+struct PhaseResult {
+    double ms = 1e30;
+    uint64_t syscalls = 0;
+    uint64_t bytes = 0;
+};
+
+static void put_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+
+static bool run_direct(const std::string& path, PhaseResult* r) {
+    static const uint8_t header[24] = {
+        0xd4, 0xc3, 0xb2, 0xa1, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x69, 0x00, 0x00, 0x00,
+    };
+    uint64_t sc0 = write_syscalls();
+    Clock::time_point t0 = Clock::now();
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    uint64_t total = sizeof(header);
+    bool ok = ::write(fd, header, sizeof(header)) == (ssize_t)sizeof(header);
+    for (size_t i = 0; ok && i < frames.size(); ++i) {
+        const Frame& fr = frames[i];
+        uint8_t rh[16];
+        put_u32(rh + 0, (uint32_t)(fr.ts_us / 1000000ULL));
+        put_u32(rh + 4, (uint32_t)(fr.ts_us % 1000000ULL));
+        put_u32(rh + 8, fr.len);
+        put_u32(rh + 12, fr.orig_len);
+        struct iovec iov[2] = {{rh, sizeof(rh)}, {&bytes[fr.offset], fr.len}};
+        ok = ::writev(fd, iov, 2) == (ssize_t)(sizeof(rh) + fr.len);
+        total += sizeof(rh) + fr.len;
+    }
+    ::close(fd);
+
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    r->ms = std::min(r->ms, ms);
+    r->syscalls = write_syscalls() - sc0;
+    r->bytes = total;
+    return ok;
+}
+
+static bool run_writer(PcapWriter* w, const char* sd_path, PhaseResult* r,
+                       PcapWriterStats* ws) {
+    PcapWriterStats before;
+    w->get_stats(&before);
+    uint64_t sc0 = write_syscalls();
+    Clock::time_point t0 = Clock::now();
+
+    if (!w->open(sd_path, PCAP_FORMAT_LEGACY)) return false;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const Frame& fr = frames[i];
+        // Relógio virtual do pcap: a política de fsync por tempo vê a
+        // mesma cadência da captura original
+        host_shim_set_time_us(fr.ts_us - frames.front().ts_us + 1000000);
+        PcapPacketInfo info = {};
+        info.timestamp_us = fr.ts_us;
+        info.orig_len = fr.orig_len;
+        w->write_packet(info, &bytes[fr.offset], fr.len);
+        // Como a task de captura: poll() a cada drenagem do ring
+        if ((i & 31) == 31) w->poll();
+    }
+    w->close();
+
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    r->ms = std::min(r->ms, ms);
+    r->syscalls = write_syscalls() - sc0;
+
+    PcapWriterStats after;
+    w->get_stats(&after);
+    r->bytes = after.bytes_written - before.bytes_written;
+    ws->sd_writes = after.sd_writes - before.sd_writes;
+    ws->syncs = after.syncs - before.syncs;
+    ws->stalls = after.stalls - before.stalls;
+    ws->max_stall_us = after.max_stall_us;
+    return true;
+}
+
+static bool same_file(const std::string& a, const std::string& b) {
+    FILE* fa = fopen(a.c_str(), "rb");
+    FILE* fb = fopen(b.c_str(), "rb");
+    bool same = fa && fb;
+    static char ba[65536], bb[65536];
+    while (same) {
+        size_t na = fread(ba, 1, sizeof(ba), fa);
+        size_t nb = fread(bb, 1, sizeof(bb), fb);
+        same = na == nb && memcmp(ba, bb, na) == 0;
+        if (na == 0) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+int main(int argc, char** argv) {
+    int passes = 3;
+    bool json = false;
+    std::string dir = ".";
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--passes" && has) passes = std::max(1, atoi(argv[++i]));
+        else if (a == "--json") json = true;
+        else if (a == "--dir" && has) dir = argv[++i];
+        else if (a[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "uso: %s [--passes N] [--json] [--dir DIR] captura.pcap\n", argv[0]);
+        return 2;
+    }
+    if (!load_pcap(path) || frames.empty()) {
+        fprintf(stderr, "[BENCH] sem frames em %s\n", path);
+        return 1;
+    }
+
+    host_shim_set_sd_root(dir.c_str());
+    host_shim_set_time_us(1000000);
+    storage_start();
+
+    PcapWriter writer;
+    if (!writer.begin()) {
+        fprintf(stderr, "[BENCH] PcapWriter::begin falhou\n");
+        return 1;
+    }
+
+    const std::string direct_path = dir + "/bench_direct.pcap";
+    const std::string writer_path = dir + "/bench_writer.pcap";
+    PhaseResult direct, batched;
+    PcapWriterStats ws = {};
+    for (int p = 0; p < passes; ++p) {
+        if (!run_direct(direct_path, &direct) ||
+            !run_writer(&writer, "/bench_writer.pcap", &batched, &ws)) {
+            fprintf(stderr, "[BENCH] falha ao gravar em %s\n", dir.c_str());
+            return 1;
+        }
+    }
+    const bool same = same_file(direct_path, writer_path);
+
+    const double n = (double)frames.size();
+    const double direct_rps = n / (direct.ms / 1000.0);
+    const double writer_rps = n / (batched.ms / 1000.0);
+    if (json) {
+        printf("{\"records\":%zu,\"bytes\":%llu,\"passes\":%d,"
+               "\"direct\":{\"ms\":%.1f,\"records_s\":%.0f,\"syscalls\":%llu},"
+               "\"writer\":{\"ms\":%.1f,\"records_s\":%.0f,\"syscalls\":%llu,"
+               "\"sd_writes\":%u,\"syncs\":%u,\"stalls\":%u},\"identical\":%s}\n",
+               frames.size(), (unsigned long long)direct.bytes, passes, direct.ms, direct_rps,
+               (unsigned long long)direct.syscalls, batched.ms, writer_rps,
+               (unsigned long long)batched.syscalls, ws.sd_writes, ws.syncs, ws.stalls,
+               same ? "true" : "false");
+    } else {
+        printf("[BENCH] %zu registros, %.1f MB, melhor de %d passadas\n", frames.size(),
+               direct.bytes / 1048576.0, passes);
+        printf("  direto  %8.1f ms %10.0f registros/s %8llu syscalls de escrita\n", direct.ms,
+               direct_rps, (unsigned long long)direct.syscalls);
+        printf("  writer  %8.1f ms %10.0f registros/s %8llu syscalls de escrita "
+               "(%u writes, %u fsyncs, %u esperas)\n",
+               batched.ms, writer_rps, (unsigned long long)batched.syscalls, ws.sd_writes,
+               ws.syncs, ws.stalls);
+        printf("[BENCH] arquivos %s\n", same ? "identicos" : "DIFERENTES");
+    }
+    fflush(stdout);
+
+    // A task sd continua bloqueada na fila: sai sem rodar destrutores
+    // estáticos por baixo dela
+    _exit(same ? 0 : 1);
+}
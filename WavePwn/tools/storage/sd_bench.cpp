@@ -0,0 +1,83 @@
+/*
+  sd_bench.cpp - src/utils/sd_bench.cpp no host
+
+  Roda o mesmo benchmark do POST /api/storage/bench num diretório local.
+  No host os números são do disco e do page cache, não de um microSD: serve
+  para conferir o código (offsets, contas de MB/s e IOPS, JSON) e comparar
+  tamanhos de bloco. Os números do cartão vêm do endpoint no dispositivo.
+
+  Uso:
+    pio run -e native_sd_bench
+    .pio/build/native_sd_bench/program [--file-kb N] [--seq-block B]
+        [--rand-block B] [--rand-ops N] [--json] [DIR]
+*/
+
+#include <Arduino.h>
+
+#include "utils/sd_bench.h"
+
+#include "host_shim.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<bool> running{true};
+
+// esp_timer_get_time() do shim segue o relógio real
+static void clock_thread() {
+    Clock::time_point t0 = Clock::now();
+    while (running.load()) {
+        host_shim_set_time_us(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count());
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+static void print_result(const char* name, const SdBenchResult& r) {
+    printf("  %-10s %8.2f MB/s %8.0f IOPS  (%lu ops, %.1f ms)\n",
+           name, r.mb_s, r.iops, (unsigned long)r.ops, r.us / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    SdBenchConfig config;
+    std::string dir = ".";
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--file-kb" && has) config.file_kb = atoi(argv[++i]);
+        else if (a == "--seq-block" && has) config.seq_block = atoi(argv[++i]);
+        else if (a == "--rand-block" && has) config.rand_block = atoi(argv[++i]);
+        else if (a == "--rand-ops" && has) config.rand_ops = atoi(argv[++i]);
+        else if (a == "--json") json = true;
+        else if (a[0] != '-') dir = a;
+        else {
+            fprintf(stderr, "uso: %s [--file-kb N] [--seq-block B] [--rand-block B] "
+                            "[--rand-ops N] [--json] [DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::thread clock(clock_thread);
+    SdBenchReport report;
+    bool ok = sd_bench_run(dir.c_str(), config, &report);
+    running = false;
+    clock.join();
+
+    if (json) {
+        printf("%s\n", sd_bench_json(report).c_str());
+    } else {
+        printf("[BENCH] %s: arquivo de %lu KB, blocos de %lu / %lu bytes\n", dir.c_str(),
+               (unsigned long)config.file_kb, (unsigned long)config.seq_block,
+               (unsigned long)config.rand_block);
+        print_result("seq_write", report.seq_write);
+        print_result("seq_read", report.seq_read);
+        print_result("rand_write", report.rand_write);
+        print_result("rand_read", report.rand_read);
+    }
+    return ok ? 0 : 1;
+}
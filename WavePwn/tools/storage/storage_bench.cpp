@@ -0,0 +1,285 @@
+/*
+  storage_bench.cpp - Captura x downloads na task sd (host)
+
+  Sobe a task sd real (storage.cpp, FreeRTOS do shim do replay) e gera a
+  carga de uma sessão com o dashboard aberto, com o custo de cada acesso ao
+  cartão injetado por um modelo de tempo (o host não tem SD lento):
+
+    captura    um buffer do PCAP (--pcap-kb, padrão PCAP_WRITER_BUFFER_SIZE)
+               a cada --pcap-kb / --capture-kbps, gravado a --write-kbps
+               mais --write-cost-us por comando de escrita; o PcapWriter tem
+               dois buffers, então um buffer que demora mais que o
+               enchimento do outro vira stall. Com --bounce o buffer está na
+               PSRAM: o driver copia e grava setor a setor (um comando por
+               512 bytes em vez de um por buffer)
+    logs       um evento do lab a cada --log-ms (abre, anexa, fecha: --log-ms-cost)
+    downloads  --downloads streams lendo blocos de 4 KB a --read-kbps, cada
+               um com um bloco sempre pedido (como o web_io_stream)
+    listagem   uma varredura de diretório de --list-cost ms a cada segundo
+
+  Dois modos, um por execução:
+
+    fifo   todos os jobs na mesma fila (ordem de chegada), como acessos ao
+           SD sem coordenação
+    prio   filas do storage.h: captura, logs, downloads
+
+  Uso:
+    pio run -e native_storage
+    .pio/build/native_storage/program --mode fifo --json
+    .pio/build/native_storage/program --mode prio --json
+*/
+
+#include <Arduino.h>
+
+#include "capture/pcap_writer.h"
+#include "storage.h"
+
+#include "host_shim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static bool mode_prio = true;
+static int seconds = 10;
+static int capture_kbps = 400;
+static int write_kbps = 1200;
+static int read_kbps = 1500;
+static int downloads = 2;
+static int log_ms = 50;
+static int log_cost_ms = 8;
+static int list_cost_ms = 40;
+static size_t pcap_buffer = PCAP_WRITER_BUFFER_SIZE;
+static int write_cost_us = 0;
+static bool bounce = false;
+
+static std::atomic<bool> running{true};
+static const Clock::time_point t0 = Clock::now();
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Tempo de cartão: `bytes` a `kbps` KB/s
+static void sd_busy(size_t bytes, int kbps) {
+    std::this_thread::sleep_for(std::chrono::microseconds((long)(bytes * 1000000.0 / (kbps * 1024.0))));
+}
+
+static void sd_busy_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static StoragePrio prio(StoragePrio p) {
+    return mode_prio ? p : STORAGE_PRIO_BULK;
+}
+
+// -----------------------------------------------------------------------------
+// Carga
+// -----------------------------------------------------------------------------
+
+struct Latencies {
+    std::mutex m;
+    std::vector<double> ms;
+
+    void add(double v) {
+        std::lock_guard<std::mutex> lock(m);
+        ms.push_back(v);
+    }
+    double pct(double p) {
+        std::lock_guard<std::mutex> lock(m);
+        if (ms.empty()) return 0;
+        std::vector<double> v = ms;
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+    }
+    double max() {
+        std::lock_guard<std::mutex> lock(m);
+        return ms.empty() ? 0 : *std::max_element(ms.begin(), ms.end());
+    }
+};
+
+static Latencies capture_lat;
+static Latencies log_lat;
+static std::atomic<uint64_t> download_bytes{0};
+static std::atomic<uint32_t> log_dropped{0};
+
+static const size_t STREAM_BLOCK = 4096;
+
+struct TimedJob {
+    double queued_ms;
+    Latencies* lat;
+    std::atomic<bool>* busy;
+};
+
+static void capture_write(void*) {
+    size_t commands = bounce ? pcap_buffer / STORAGE_SECTOR_SIZE : 1;
+    std::this_thread::sleep_for(std::chrono::microseconds((long)(commands * write_cost_us)));
+    sd_busy(pcap_buffer, write_kbps);
+    storage_account(0, pcap_buffer);
+}
+
+static void timed_done(void* arg) {
+    TimedJob* job = (TimedJob*)arg;
+    job->lat->add(now_ms() - job->queued_ms);
+    if (job->busy) job->busy->store(false);
+    else delete job;
+}
+
+static void log_write(void*) {
+    sd_busy_ms(log_cost_ms);
+    storage_account(0, 96);
+}
+
+static void download_block(void* arg) {
+    sd_busy(STREAM_BLOCK, read_kbps);
+    storage_account(STREAM_BLOCK, 0);
+    download_bytes += STREAM_BLOCK;
+    if (running.load() && !storage_submit(prio(STORAGE_PRIO_BULK), STORAGE_CLIENT_WEB,
+                                          download_block, arg)) {
+        fprintf(stderr, "[BENCH] fila cheia no download\n");
+    }
+}
+
+static void list_scan(void*) {
+    sd_busy_ms(list_cost_ms);
+}
+
+// Produtor de captura: como o PcapWriter, dois buffers; o próximo só pode
+// ser entregue se o outro já foi gravado (senão, stall)
+static void capture_thread(uint32_t* stalls, double* stall_ms) {
+    TimedJob jobs[2];
+    std::atomic<bool> busy[2];
+    busy[0] = busy[1] = false;
+    double fill_ms = pcap_buffer * 1000.0 / (capture_kbps * 1024.0);
+    int active = 0;
+    double next = now_ms() + fill_ms;
+    while (running.load()) {
+        double wait = next - now_ms();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds((long)(wait * 1000)));
+
+        // O buffer que acabou de encher vai para a fila; o outro precisa
+        // estar livre para a captura continuar
+        double t = now_ms();
+        while (busy[active ^ 1].load()) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        double stalled = now_ms() - t;
+        if (stalled > 0.5) {
+            (*stalls)++;
+            *stall_ms = std::max(*stall_ms, stalled);
+        }
+
+        jobs[active] = {now_ms(), &capture_lat, &busy[active]};
+        busy[active] = true;
+        if (!storage_submit(prio(STORAGE_PRIO_CAPTURE), STORAGE_CLIENT_CAPTURE,
+                            capture_write, &jobs[active], timed_done)) {
+            busy[active] = false;
+            fprintf(stderr, "[BENCH] fila cheia na captura\n");
+        }
+        active ^= 1;
+        next += fill_ms;
+    }
+    while (busy[0].load() || busy[1].load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static void log_thread() {
+    while (running.load()) {
+        TimedJob* job = new TimedJob{now_ms(), &log_lat, nullptr};
+        if (!storage_submit(prio(STORAGE_PRIO_LOG), STORAGE_CLIENT_LOG, log_write, job, timed_done)) {
+            delete job;
+            log_dropped++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(log_ms));
+    }
+}
+
+static void list_thread() {
+    while (running.load()) {
+        storage_call(prio(STORAGE_PRIO_BULK), STORAGE_CLIENT_WEB, list_scan, nullptr);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+}
+
+// millis()/micros() do shim seguem o relógio real (estatísticas da task sd)
+static void clock_thread() {
+    while (running.load()) {
+        host_shim_set_time_us((uint64_t)(now_ms() * 1000.0));
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--mode" && has) mode_prio = std::string(argv[++i]) != "fifo";
+        else if (a == "--seconds" && has) seconds = atoi(argv[++i]);
+        else if (a == "--capture-kbps" && has) capture_kbps = atoi(argv[++i]);
+        else if (a == "--write-kbps" && has) write_kbps = atoi(argv[++i]);
+        else if (a == "--read-kbps" && has) read_kbps = atoi(argv[++i]);
+        else if (a == "--downloads" && has) downloads = atoi(argv[++i]);
+        else if (a == "--log-ms" && has) log_ms = atoi(argv[++i]);
+        else if (a == "--log-ms-cost" && has) log_cost_ms = atoi(argv[++i]);
+        else if (a == "--list-cost" && has) list_cost_ms = atoi(argv[++i]);
+        else if (a == "--pcap-kb" && has) pcap_buffer = (size_t)std::max(1, atoi(argv[++i])) * 1024;
+        else if (a == "--write-cost-us" && has) write_cost_us = atoi(argv[++i]);
+        else if (a == "--bounce") bounce = true;
+        else if (a == "--json") json = true;
+        else {
+            fprintf(stderr, "uso: %s [--mode fifo|prio] [--seconds S] [--capture-kbps K] "
+                            "[--write-kbps K] [--read-kbps K] [--downloads N] [--log-ms T] "
+                            "[--log-ms-cost T] [--list-cost T] [--pcap-kb N] "
+                            "[--write-cost-us T] [--bounce] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::thread clock(clock_thread);
+    storage_start();
+
+    for (int i = 0; i < downloads; ++i) {
+        storage_submit(prio(STORAGE_PRIO_BULK), STORAGE_CLIENT_WEB, download_block, nullptr);
+    }
+    uint32_t stalls = 0;
+    double stall_ms = 0;
+    std::thread capture(capture_thread, &stalls, &stall_ms);
+    std::thread logs(log_thread);
+    std::thread lists(list_thread);
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    running = false;
+    capture.join();
+    logs.join();
+    lists.join();
+    // Os downloads param sozinhos; espera a fila esvaziar
+    storage_call(STORAGE_PRIO_BULK, STORAGE_CLIENT_WEB, [](void*) {}, nullptr);
+    clock.join();
+
+    double dl_kbps = download_bytes.load() / 1024.0 / seconds;
+    if (json) {
+        printf("{\"mode\":\"%s\",\"pcap_kb\":%u,\"bounce\":%s,\"capture_p50_ms\":%.1f,\"capture_p99_ms\":%.1f,"
+               "\"capture_max_ms\":%.1f,\"capture_stalls\":%u,\"capture_stall_max_ms\":%.1f,"
+               "\"log_p50_ms\":%.1f,\"log_max_ms\":%.1f,\"log_dropped\":%u,"
+               "\"download_kbps\":%.0f,\"storage\":%s}\n",
+               mode_prio ? "prio" : "fifo", (unsigned)(pcap_buffer / 1024),
+               bounce ? "true" : "false", capture_lat.pct(0.5), capture_lat.pct(0.99),
+               capture_lat.max(), stalls, stall_ms, log_lat.pct(0.5), log_lat.max(),
+               log_dropped.load(), dl_kbps, storage_stats_json().c_str());
+    } else {
+        printf("[BENCH] modo %s, %d s, buffers de %u KB%s\n", mode_prio ? "prio" : "fifo",
+               seconds, (unsigned)(pcap_buffer / 1024), bounce ? " na PSRAM (setor a setor)" : "");
+        printf("  captura: buffer pronto em p50 %.1f / p99 %.1f / max %.1f ms, "
+               "%u stalls (max %.1f ms)\n",
+               capture_lat.pct(0.5), capture_lat.pct(0.99), capture_lat.max(), stalls, stall_ms);
+        printf("  logs: p50 %.1f / max %.1f ms, %u descartados\n",
+               log_lat.pct(0.5), log_lat.max(), log_dropped.load());
+        printf("  downloads: %.0f KB/s somados\n", dl_kbps);
+        printf("  /api/storage: %s\n", storage_stats_json().c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+// asset_server - Serve o manifesto gzip/ETag de src/web no host
+//
+// Mesmas rotas de webserver_start() para os assets (sem a autenticação do
+// OTA), sobre o shim POSIX do ESPAsyncWebServer. Usado por
+// tools/web/http_bench.py para medir bytes por carregamento do dashboard
+// sem a placa.
+//
+//   asset_server [--port N]      (N=0: porta livre, impressa no stdout)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ESPAsyncWebServer.h>
+#include "web/web_assets.h"
+
+int main(int argc, char** argv) {
+    int port = 8080;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "uso: %s [--port N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    AsyncWebServer server((uint16_t)port);
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
+        web_assets_serve(request, *web_asset_find("/index.html"));
+    });
+    web_assets_register(server, nullptr);
+    server.onNotFound([](AsyncWebServerRequest* request) {
+        request->send(404, "text/plain", "Not found");
+    });
+    server.begin();
+
+    printf("[WEB] %u assets em http://127.0.0.1:%d/\n", (unsigned)WEB_ASSETS_COUNT, server.port());
+    fflush(stdout);
+
+    for (;;) {
+        pause();
+    }
+}
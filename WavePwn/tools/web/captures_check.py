@@ -0,0 +1,418 @@
+#!/usr/bin/env python3
+"""
+captures_check.py - Confere a API de capturas (/api/captures*) no host
+
+Monta um "SD" temporário com um PCAP grande (150 MB por padrão), centenas
+de PCAPs pequenos e logs de sessão com PMKIDs repetidos, sobe o
+captures_server (env native_web_captures: src/web/captures + web_io +
+shims) e confere:
+
+    listagem   páginas por cursor cobrem o diretório inteiro, em ordem,
+               sem repetição
+    download   arquivo inteiro e intervalos (Range) batem byte a byte;
+               416 fora do arquivo; vários intervalos -> 200 completo
+    hashes     16800 igual ao pmkid.16800 do tools/session_export.py;
+               22000 contém todas as linhas do export
+    memória    RSS do servidor durante o download do arquivo grande
+    limites    nomes/diretórios inválidos -> 400, downloads demais -> 503
+
+Imprime a vazão do download e o pico de RSS. Sai com 1 se algo falhar.
+
+Uso:
+    $ pio run -e native_web_captures
+    $ python3 tools/web/captures_check.py
+    $ python3 tools/web/captures_check.py --server caminho/captures_server --size-mb 150
+"""
+
+import argparse
+import contextlib
+import hashlib
+import importlib.util
+import io
+import json
+import os
+import pathlib
+import random
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import zlib
+
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def load_session_export():
+    path = os.path.join(HERE, "..", "session_export.py")
+    spec = importlib.util.spec_from_file_location("session_export", path)
+    mod = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(mod)
+    return mod
+
+
+# -----------------------------------------------------------------------------
+# "SD" de teste
+# -----------------------------------------------------------------------------
+
+def write_big_file(path, size):
+    # Conteúdo pseudoaleatório, mas barato de gerar
+    block = random.Random(1).randbytes(1 << 20)
+    h = hashlib.sha256()
+    with open(path, "wb") as f:
+        left = size
+        i = 0
+        while left > 0:
+            chunk = block[i % 251:] + block[:i % 251]
+            chunk = chunk[:left]
+            f.write(chunk)
+            h.update(chunk)
+            left -= len(chunk)
+            i += 1
+    return h.hexdigest()
+
+
+def record(se, rtype, payload):
+    hdr = se.RECORD_HEADER.pack(len(payload), rtype, 0)
+    return hdr + payload + struct.pack("<I", zlib.crc32(hdr + payload))
+
+
+def write_sessions(se, session_dir, rng):
+    pmkids = []
+    for i in range(40):
+        ssid = ("rede-%02d" % i).encode()
+        pmkids.append(se.PMKID_RECORD.pack(rng.randbytes(16), rng.randbytes(6), b"\xff" * 6,
+                                           len(ssid), ssid, 1000 + i))
+    for sid in (1, 2, 3):
+        data = se.FILE_HEADER.pack(se.MAGIC, se.VERSION, se.FILE_HEADER.size, sid, 0)
+        for n in range(60):
+            # PMKID regravado a cada beacon: o mesmo registro várias vezes
+            data += record(se, se.REC_PMKID, pmkids[(sid * 7 + n) % len(pmkids)])
+            if n % 4 == 0:
+                ap, sta = rng.randbytes(6), rng.randbytes(6)
+                eapol = rng.randbytes(rng.randint(95, 250))
+                ssid = b"casa-%d" % (n % 5)
+                for pair in (0x00, 0x02):
+                    hs = se.HANDSHAKE_RECORD.pack(ap, sta, rng.randbytes(32), rng.randbytes(16),
+                                                  2, pair, int(pair == 0x02), len(ssid), ssid,
+                                                  5000 + n, len(eapol))
+                    data += record(se, se.REC_HANDSHAKE, hs + eapol)
+            if n % 10 == 0:
+                ssid = b"ap"
+                data += record(se, se.REC_AP, se.AP_RECORD.pack(rng.randbytes(6), 6, len(ssid),
+                                                                ssid, n))
+        if sid == 3:
+            data += b"\x10\x00"   # cauda truncada (queda de energia)
+        with open(os.path.join(session_dir, "session_%05d.bin" % sid), "wb") as f:
+            f.write(data)
+
+
+# -----------------------------------------------------------------------------
+# HTTP
+# -----------------------------------------------------------------------------
+
+def open_request(port, path, headers=None):
+    s = socket.create_connection(("127.0.0.1", port))
+    req = "GET %s HTTP/1.1\r\nHost: 192.168.4.1\r\n" % path
+    for k, v in (headers or {}).items():
+        req += "%s: %s\r\n" % (k, v)
+    s.sendall((req + "\r\n").encode())
+
+    head = b""
+    while b"\r\n\r\n" not in head:
+        chunk = s.recv(4096)
+        if not chunk:
+            break
+        head += chunk
+    head, _, rest = head.partition(b"\r\n\r\n")
+    lines = head.decode("latin-1").split("\r\n")
+    status = int(lines[0].split()[1])
+    hdrs = {}
+    for line in lines[1:]:
+        k, _, v = line.partition(":")
+        hdrs[k.strip().lower()] = v.strip()
+    return s, status, hdrs, rest
+
+
+def dechunk(data):
+    out = b""
+    while data:
+        line, _, data = data.partition(b"\r\n")
+        n = int(line, 16)
+        if n == 0:
+            break
+        out += data[:n]
+        data = data[n + 2:]
+    return out
+
+
+def request(port, path, headers=None, sink=None):
+    """(status, headers, corpo). Com `sink`, o corpo vai para sink(bytes).
+
+    503 com Retry-After (tamanho ainda fora do cache) é repetido, como um
+    navegador faria com o link de novo."""
+    for _ in range(20):
+        s, status, hdrs, rest = open_request(port, path, headers)
+        if status != 503 or "retry-after" not in hdrs:
+            break
+        s.close()
+        time.sleep(0.05)
+    body = bytearray()
+    chunked = hdrs.get("transfer-encoding") == "chunked"
+    with s:
+        data = rest
+        while True:
+            if data:
+                if sink and not chunked:
+                    sink(data)
+                else:
+                    body += data
+            data = s.recv(1 << 16)
+            if not data:
+                break
+    body = bytes(body)
+    if chunked:
+        body = dechunk(body)
+        if sink:
+            sink(body)
+            body = b""
+    return status, hdrs, body
+
+
+def rss_kb(pid, field="VmRSS"):
+    with open("/proc/%d/status" % pid) as f:
+        for line in f:
+            if line.startswith(field + ":"):
+                return int(line.split()[1])
+    return 0
+
+
+# -----------------------------------------------------------------------------
+# Conferências
+# -----------------------------------------------------------------------------
+
+def check_listing(port, names, errors):
+    seen = []
+    cursor = ""
+    pages = 0
+    while True:
+        path = "/api/captures?dir=handshakes&limit=37"
+        if cursor:
+            path += "&cursor=" + cursor
+        status, _, body = request(port, path)
+        if status != 200:
+            errors.append("listagem: status %d" % status)
+            return
+        page = json.loads(body)
+        pages += 1
+        seen += [(i["name"], i["size"]) for i in page["items"]]
+        if not page["next"]:
+            break
+        cursor = page["next"]
+    if seen != sorted(names.items()):
+        errors.append("listagem: %d itens em %d páginas, esperado %d em ordem"
+                      % (len(seen), pages, len(names)))
+    print("listagem: %d arquivos em %d páginas de 37" % (len(seen), pages))
+
+    status, _, body = request(port, "/api/captures?dir=session")
+    got = [i["name"] for i in json.loads(body)["items"]] if status == 200 else None
+    if got != ["session_00001.bin", "session_00002.bin", "session_00003.bin"]:
+        errors.append("listagem de session: %r" % got)
+
+
+def check_download(port, pid, name, size, digest, errors):
+    h = hashlib.sha256()
+    received = [0]
+    peak = [0]
+    base = rss_kb(pid)
+    done = threading.Event()
+
+    def sample():
+        while not done.is_set():
+            peak[0] = max(peak[0], rss_kb(pid))
+            time.sleep(0.02)
+
+    def sink(data):
+        h.update(data)
+        received[0] += len(data)
+
+    t = threading.Thread(target=sample)
+    t.start()
+    start = time.monotonic()
+    status, hdrs, _ = request(port, "/api/captures/file?dir=handshakes&name=" + name, sink=sink)
+    elapsed = time.monotonic() - start
+    done.set()
+    t.join()
+
+    if status != 200 or int(hdrs.get("content-length", -1)) != size:
+        errors.append("download: status %d, headers %r" % (status, hdrs))
+    if received[0] != size or h.hexdigest() != digest:
+        errors.append("download: %d bytes, sha256 %s (esperado %s)"
+                      % (received[0], h.hexdigest(), digest))
+    if hdrs.get("accept-ranges") != "bytes":
+        errors.append("download: sem Accept-Ranges")
+    print("download: %d MB em %.2f s (%.1f MB/s no loopback)"
+          % (size >> 20, elapsed, size / elapsed / 1e6))
+    print("memória do servidor: RSS %d KB antes, pico %d KB durante (+%d KB)"
+          % (base, peak[0], peak[0] - base))
+    return peak[0] - base
+
+
+def check_ranges(port, path_on_disk, name, size, errors):
+    with open(path_on_disk, "rb") as f:
+        def part(a, b):
+            f.seek(a)
+            return f.read(b - a + 1)
+
+        url = "/api/captures/file?dir=handshakes&name=" + name
+        cases = [
+            ("bytes=0-0", 0, 0),
+            ("bytes=100-4195", 100, 4195),
+            ("bytes=%d-" % (size - 70000), size - 70000, size - 1),
+            ("bytes=-5000", size - 5000, size - 1),
+            ("bytes=%d-%d" % (size - 10, size + 1000), size - 10, size - 1),
+            ("bytes=%d-%d" % (size // 2, size // 2 + (1 << 20)), size // 2, size // 2 + (1 << 20)),
+        ]
+        for rng, a, b in cases:
+            status, hdrs, body = request(port, url, {"Range": rng})
+            want_cr = "bytes %d-%d/%d" % (a, b, size)
+            if status != 206 or hdrs.get("content-range") != want_cr or body != part(a, b):
+                errors.append("Range %s: status %d, %r, %d bytes"
+                              % (rng, status, hdrs.get("content-range"), len(body)))
+
+        for rng in ("bytes=%d-" % size, "bytes=-0"):
+            status, hdrs, _ = request(port, url, {"Range": rng})
+            if status != 416 or hdrs.get("content-range") != "bytes */%d" % size:
+                errors.append("Range %s: esperado 416, veio %d %r"
+                              % (rng, status, hdrs.get("content-range")))
+
+        # Vários intervalos ou sintaxe desconhecida: arquivo inteiro (só o começo é lido)
+        for rng in ("bytes=0-1,5-6", "items=0-1", "bytes=9-3"):
+            s, status, hdrs, _ = open_request(port, url, {"Range": rng})
+            s.close()
+            if status != 200 or int(hdrs.get("content-length", -1)) != size:
+                errors.append("Range %s: esperado 200 completo, veio %d" % (rng, status))
+    print("range: %d intervalos + 416 + fallback 200 conferidos" % len(cases))
+
+
+def check_hashes(port, se, session_dir, errors):
+    out_dir = tempfile.mkdtemp(prefix="captures_export_")
+    with contextlib.redirect_stdout(io.StringIO()), contextlib.redirect_stderr(io.StringIO()):
+        se.export(session_dir, pathlib.Path(out_dir))
+
+    with open(os.path.join(out_dir, "pmkid.16800")) as f:
+        want_16800 = f.read()
+    with open(os.path.join(out_dir, "handshakes.22000")) as f:
+        want_22000 = set(f.read().split())
+
+    status, hdrs, body = request(port, "/api/captures/hashes?type=16800")
+    if status != 200 or body.decode() != want_16800:
+        errors.append("16800: status %d, %d linhas (esperado %d)"
+                      % (status, body.count(b"\n"), want_16800.count("\n")))
+    n16800 = body.count(b"\n")
+
+    status, hdrs, body = request(port, "/api/captures/hashes?type=22000")
+    lines = body.decode().split()
+    if status != 200 or not want_22000.issubset(lines) or len(lines) != len(set(lines)):
+        errors.append("22000: status %d, %d linhas, %d do export"
+                      % (status, len(lines), len(want_22000)))
+    print("hashes: %d linhas 16800, %d linhas 22000 (%d melhores pares no export)"
+          % (n16800, len(lines), len(want_22000)))
+
+
+def check_limits(port, errors):
+    for path, want in (("/api/captures?dir=../etc", 400),
+                       ("/api/captures?dir=handshakes&cursor=../x", 400),
+                       ("/api/captures/file?dir=handshakes&name=../../etc/passwd", 400),
+                       ("/api/captures/file?dir=handshakes&name=.hidden", 400),
+                       ("/api/captures/file?dir=handshakes&name=nao_existe.pcap", 404),
+                       ("/api/captures/hashes?type=2500", 400)):
+        status = request(port, path)[0]
+        if status != want:
+            errors.append("%s: esperado %d, veio %d" % (path, want, status))
+
+
+def check_concurrency(port, name, errors):
+    # Dois downloads parados (cliente não lê) ocupam as vagas; o terceiro é 503
+    url = "/api/captures/file?dir=handshakes&name=" + name
+    request(port, url, {"Range": "bytes=0-0"})   # tamanho no cache
+    held = [open_request(port, url)[0] for _ in range(2)]
+    third = request(port, "/api/captures/hashes?type=16800")[0]
+    for s in held:
+        s.close()
+    if third != 503:
+        errors.append("terceiro download simultâneo: esperado 503, veio %d" % third)
+
+    # Vagas liberadas quando os clientes desconectam
+    for _ in range(50):
+        time.sleep(0.05)
+        if request(port, "/api/captures/hashes?type=16800")[0] == 200:
+            break
+    else:
+        errors.append("vagas de download não foram liberadas após desconectar")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--server", default=".pio/build/native_web_captures/program")
+    parser.add_argument("--size-mb", type=int, default=150)
+    parser.add_argument("--max-rss-kb", type=int, default=2048,
+                        help="crescimento máximo do RSS do servidor no download grande")
+    args = parser.parse_args()
+
+    se = load_session_export()
+    rng = random.Random(7)
+    errors = []
+
+    with tempfile.TemporaryDirectory(prefix="captures_sd_") as root:
+        hs_dir = os.path.join(root, "sd", "wavepwn", "handshakes")
+        session_dir = os.path.join(root, "sd", "wavepwn", "session")
+        os.makedirs(hs_dir)
+        os.makedirs(session_dir)
+        os.makedirs(os.path.join(root, "sd", "lab_logs"))
+
+        names = {}
+        for i in range(250):
+            name = "%010d.pcap" % rng.randrange(10 ** 9)
+            data = rng.randbytes(rng.randint(24, 600))
+            with open(os.path.join(hs_dir, name), "wb") as f:
+                f.write(data)
+            names[name] = len(data)
+        big = "20250101_120000.pcap"
+        size = args.size_mb << 20
+        digest = write_big_file(os.path.join(hs_dir, big), size)
+        names[big] = size
+        with open(os.path.join(hs_dir, ".oculto"), "wb") as f:
+            f.write(b"x")
+        write_sessions(se, session_dir, rng)
+
+        server = subprocess.Popen([args.server, "--sd", root, "--port", "0"],
+                                  stdout=subprocess.PIPE, text=True)
+        try:
+            banner = server.stdout.readline()
+            port = int(banner.rsplit(":", 1)[1].strip("/\n"))
+
+            check_listing(port, names, errors)
+            growth = check_download(port, server.pid, big, size, digest, errors)
+            if growth > args.max_rss_kb:
+                errors.append("RSS do servidor cresceu %d KB no download (limite %d KB)"
+                              % (growth, args.max_rss_kb))
+            check_ranges(port, os.path.join(hs_dir, big), big, size, errors)
+            check_hashes(port, se, pathlib.Path(session_dir), errors)
+            check_limits(port, errors)
+            check_concurrency(port, big, errors)
+        finally:
+            server.kill()
+            server.wait()
+
+    for e in errors:
+        print("FALHA: " + e, file=sys.stderr)
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
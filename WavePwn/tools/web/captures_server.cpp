@@ -0,0 +1,59 @@
+// captures_server - API de capturas de src/web/captures sobre um "SD" no host
+//
+// Mesmas rotas de webserver_start() para /api/captures* e /api/storage, com
+// as tasks sd e web_io reais (FreeRTOS do shim do replay) e o SD do shim
+// apontando para um diretório. Usado por tools/web/captures_check.py.
+//
+//   captures_server --sd DIR [--port N]      (N=0: porta livre, impressa no stdout)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ESPAsyncWebServer.h>
+#include "web/captures.h"
+#include "web/web_io.h"
+#include "storage.h"
+
+#include "host_shim.h"
+
+int main(int argc, char** argv) {
+    int port = 8080;
+    const char* sd_root = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sd") == 0 && i + 1 < argc) {
+            sd_root = argv[++i];
+        } else {
+            sd_root = nullptr;
+            break;
+        }
+    }
+    if (!sd_root) {
+        fprintf(stderr, "uso: %s --sd DIR [--port N]\n", argv[0]);
+        return 2;
+    }
+
+    host_shim_set_sd_root(sd_root);
+    storage_start();
+    web_io_start();
+
+    AsyncWebServer server((uint16_t)port);
+    captures_register(server);
+    server.on("/api/storage", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", storage_stats_json());
+    });
+    server.onNotFound([](AsyncWebServerRequest* request) {
+        request->send(404, "text/plain", "Not found");
+    });
+    server.begin();
+
+    printf("[WEB] capturas de %s em http://127.0.0.1:%d/\n", sd_root, server.port());
+    fflush(stdout);
+
+    for (;;) {
+        pause();
+    }
+}
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+embed_assets.py - Comprime os assets do dashboard e gera o manifesto em C++
+
+Roda como extra_script (pre:) do PlatformIO antes de compilar e também pode
+ser chamado à mão. Para cada arquivo listado em `custom_web_assets`:
+
+    - comprime com gzip nível 9 (mtime=0, saída determinística); se o gzip
+      não ficar menor (favicon de poucos bytes), guarda o original;
+    - calcula um ETag forte (SHA-256 do conteúdo original, 16 hex);
+    - escreve o blob e uma entrada do manifesto WEB_ASSETS em
+      src/web/web_assets_data.cpp (ver src/web/web_assets.h).
+
+O arquivo gerado só é reescrito quando o conteúdo muda, para não forçar
+recompilação a cada build. gzip e não brotli: navegadores só anunciam
+"br" em HTTPS, e o dashboard é servido em HTTP puro pelo SoftAP.
+
+Caminho HTTP: relativo a data/web/ ("/index.html"); fora dele, relativo à
+raiz do projeto ("/ota/update.html").
+
+Uso:
+    $ python3 tools/web/embed_assets.py data/web/index.html ota/update.html
+    $ python3 tools/web/embed_assets.py --list    # tamanhos, sem gerar nada
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import sys
+
+
+OUTPUT = os.path.join("src", "web", "web_assets_data.cpp")
+WEB_ROOT = os.path.join("data", "web")
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+}
+
+
+def url_path(rel):
+    rel = rel.replace("\\", "/")
+    root = WEB_ROOT.replace("\\", "/") + "/"
+    if rel.startswith(root):
+        rel = rel[len(root):]
+    return "/" + rel
+
+
+def load_asset(project_dir, rel):
+    with open(os.path.join(project_dir, rel), "rb") as f:
+        raw = f.read()
+    ext = os.path.splitext(rel)[1].lower()
+    if ext not in MIME_TYPES:
+        sys.exit("embed_assets: tipo desconhecido para %s" % rel)
+    gz = gzip.compress(raw, compresslevel=9, mtime=0)
+    return {
+        "source": rel,
+        "path": url_path(rel),
+        "mime": MIME_TYPES[ext],
+        "raw_len": len(raw),
+        "gzip": len(gz) < len(raw),
+        "data": gz if len(gz) < len(raw) else raw,
+        "etag": hashlib.sha256(raw).hexdigest()[:16],
+    }
+
+
+def c_bytes(data, indent="    ", per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        chunk = data[i:i + per_line]
+        lines.append(indent + ",".join("0x%02x" % b for b in chunk) + ",")
+    return "\n".join(lines)
+
+
+def render(assets):
+    out = [
+        "// Gerado por tools/web/embed_assets.py - NAO EDITAR",
+        "",
+        '#include "web/web_assets.h"',
+        "",
+    ]
+    for i, a in enumerate(assets):
+        out.append("// %s: %d -> %d bytes%s" % (a["source"], a["raw_len"], len(a["data"]),
+                                                 "" if a["gzip"] else " (sem gzip)"))
+        out.append("alignas(4) static const uint8_t k_asset_%d[] = {" % i)
+        out.append(c_bytes(a["data"]))
+        out.append("};")
+        out.append("")
+
+    out.append("constexpr WebAsset WEB_ASSETS[] = {")
+    for i, a in enumerate(assets):
+        out.append('    {"%s", "%s", k_asset_%d, sizeof(k_asset_%d), %d, "\\"%s\\"", %s},'
+                   % (a["path"], a["mime"], i, i, a["raw_len"], a["etag"],
+                      "true" if a["gzip"] else "false"))
+    out.append("};")
+    out.append("")
+    out.append("constexpr size_t WEB_ASSETS_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    out.append("")
+    return "\n".join(out)
+
+
+def generate(project_dir, sources, output=OUTPUT):
+    assets = [load_asset(project_dir, rel) for rel in sources]
+    text = render(assets)
+
+    path = os.path.join(project_dir, output)
+    old = None
+    if os.path.exists(path):
+        with open(path, "r") as f:
+            old = f.read()
+    if old != text:
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, "w") as f:
+            f.write(text)
+
+    raw = sum(a["raw_len"] for a in assets)
+    gz = sum(len(a["data"]) for a in assets)
+    print("[WEB] %d assets: %d -> %d bytes gzip (%.0f%%)%s"
+          % (len(assets), raw, gz, 100.0 * gz / max(1, raw),
+             "" if old != text else ", sem mudancas"))
+    return assets
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("assets", nargs="+", help="caminhos relativos ao projeto")
+    parser.add_argument("--project-dir", default=".")
+    parser.add_argument("-o", "--output", default=OUTPUT)
+    parser.add_argument("--list", action="store_true",
+                        help="só mostra tamanhos e ETags")
+    args = parser.parse_args()
+
+    if args.list:
+        for rel in args.assets:
+            a = load_asset(args.project_dir, rel)
+            print("%-24s %-24s %7d -> %6d  \"%s\"%s"
+                  % (a["path"], a["mime"], a["raw_len"], len(a["data"]), a["etag"],
+                     "" if a["gzip"] else "  (sem gzip)"))
+        return
+    generate(args.project_dir, args.assets, args.output)
+
+
+try:
+    Import("env")  # noqa: F821 - injetado pelo SCons do PlatformIO
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    generate(env.subst("$PROJECT_DIR"),  # noqa: F821
+             env.GetProjectOption("custom_web_assets").split())
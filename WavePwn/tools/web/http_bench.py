@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+http_bench.py - Mede os bytes por carregamento do dashboard no host
+
+Sobe o asset_server (env native_web: src/web + shim do ESPAsyncWebServer),
+carrega cada página com seus assets como um navegador faria e compara três
+cenários, contando os bytes de resposta que passariam pelo SoftAP
+(cabeçalhos + corpo):
+
+    antes   serve_embedded(): 200 descomprimido, sem ETag (calculado a
+            partir dos arquivos, com os mesmos cabeçalhos do servidor)
+    frio    primeira visita: 200 + Content-Encoding: gzip (se compensar)
+    quente  revisita com If-None-Match: 304 sem corpo
+
+Também confere cada resposta: gzip descomprime para o arquivo original,
+ETag presente e estável, 304 na revisita. Sai com 1 se algo falhar.
+
+Uso:
+    $ pio run -e native_web
+    $ python3 tools/web/http_bench.py
+    $ python3 tools/web/http_bench.py --server caminho/asset_server
+"""
+
+import argparse
+import configparser
+import gzip
+import os
+import socket
+import subprocess
+import sys
+
+
+PAGES = {
+    "dashboard": ["/", "/style.css", "/chart.min.js", "/favicon.ico"],
+    "config": ["/config.html", "/style.css", "/bootstrap.min.css", "/bootstrap.min.js",
+               "/config.js", "/favicon.ico"],
+    "ota": ["/ota/update.html"],
+}
+
+
+def load_sources(project_dir):
+    # Mesmo mapeamento de tools/web/embed_assets.py
+    cfg = configparser.ConfigParser(interpolation=None)
+    cfg.read(os.path.join(project_dir, "platformio.ini"))
+    sources = {}
+    for rel in cfg.get("web", "assets").split():
+        path = rel[len("data/web"):] if rel.startswith("data/web/") else "/" + rel
+        with open(os.path.join(project_dir, rel), "rb") as f:
+            sources[path] = f.read()
+    sources["/"] = sources["/index.html"]
+    return sources
+
+
+def request(port, path, etag=None):
+    req = "GET %s HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept-Encoding: gzip, deflate\r\n" % path
+    if etag:
+        req += "If-None-Match: %s\r\n" % etag
+    req += "\r\n"
+
+    with socket.create_connection(("127.0.0.1", port)) as s:
+        s.sendall(req.encode())
+        data = b""
+        while True:
+            chunk = s.recv(65536)
+            if not chunk:
+                break
+            data += chunk
+
+    head, _, body = data.partition(b"\r\n\r\n")
+    lines = head.decode("latin-1").split("\r\n")
+    status = int(lines[0].split()[1])
+    headers = {}
+    for line in lines[1:]:
+        k, _, v = line.partition(":")
+        headers[k.strip().lower()] = v.strip()
+    return status, headers, body, len(data)
+
+
+def baseline_bytes(path, raw):
+    mime = {".css": "text/css", ".js": "application/javascript", ".ico": "image/x-icon"}
+    ext = os.path.splitext(path)[1]
+    head = ("HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %d\r\n"
+            "Connection: close\r\n\r\n" % (mime.get(ext, "text/html"), len(raw)))
+    return len(head) + len(raw)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--server", default=".pio/build/native_web/program")
+    parser.add_argument("--project-dir",
+                        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+    args = parser.parse_args()
+
+    sources = load_sources(args.project_dir)
+    server = subprocess.Popen([args.server, "--port", "0"], stdout=subprocess.PIPE, text=True)
+    errors = []
+    try:
+        banner = server.stdout.readline()
+        port = int(banner.rsplit(":", 1)[1].strip("/\n"))
+
+        totals = [0, 0, 0]
+        print("%-10s %9s %9s %9s %8s" % ("pagina", "antes", "frio", "quente", "reducao"))
+        for page, paths in PAGES.items():
+            before = cold = warm = 0
+            for path in paths:
+                raw = sources[path]
+                before += baseline_bytes(path, raw)
+
+                status, headers, body, n = request(port, path)
+                cold += n
+                etag = headers.get("etag")
+                if status != 200 or not etag:
+                    errors.append("%s: resposta fria inesperada (%d, %s)" % (path, status, headers))
+                    continue
+                if headers.get("content-encoding") == "gzip":
+                    body = gzip.decompress(body)
+                if body != raw:
+                    errors.append("%s: corpo nao bate com o arquivo" % path)
+
+                status, headers, body, n = request(port, path, etag)
+                warm += n
+                if status != 304 or body or headers.get("etag") != etag:
+                    errors.append("%s: revalidacao sem 304 (%d)" % (path, status))
+
+            totals[0] += before
+            totals[1] += cold
+            totals[2] += warm
+            print("%-10s %9d %9d %9d %7.1f%%"
+                  % (page, before, cold, warm, 100.0 * (1 - cold / before)))
+
+        print("%-10s %9d %9d %9d %7.1f%%"
+              % ("total", totals[0], totals[1], totals[2], 100.0 * (1 - totals[1] / totals[0])))
+        print("revisita: %d bytes (%.2f%% do original)" % (totals[2], 100.0 * totals[2] / totals[0]))
+
+        # Conferências extras: ETag com lista / W/ / *, caminho inexistente
+        _, headers, _, _ = request(port, "/style.css")
+        tag = headers["etag"]
+        for inm in ('"x", %s' % tag, "W/" + tag, "*"):
+            if request(port, "/style.css", inm)[0] != 304:
+                errors.append("If-None-Match %r nao gerou 304" % inm)
+        if request(port, "/style.css", '"outro"')[0] != 200:
+            errors.append("ETag diferente deveria gerar 200")
+        if request(port, "/nao-existe.js")[0] != 404:
+            errors.append("caminho inexistente deveria gerar 404")
+    finally:
+        server.kill()
+        server.wait()
+
+    for e in errors:
+        print("FALHA: " + e, file=sys.stderr)
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,444 @@
+/*
+  load_test.cpp - Tempo de frame da UI com o dashboard sob carga (host)
+
+  Sobe o servidor web sobre o shim do ESPAsyncWebServer com os assets reais
+  (src/web/web_assets) e a task web_io real (src/web/web_io, FreeRTOS do
+  shim do replay), dispara N clientes HTTP e M clientes WebSocket em threads
+  e mede, na thread principal, o período do "loop da UI" (Pwnagotchi::update:
+  trabalho do LVGL + webserver_send_stats + vTaskDelay(5)).
+
+  Dois modos, um por execução:
+
+    sync   modelo antigo: o loop da UI chama handleClient() (uma requisição
+           por frame, handler inline: SD e HTTPS bloqueiam a UI) e faz
+           broadcast de stats a cada frame
+    async  modelo novo: handlers na thread do servidor, SD/HTTPS na task
+           web_io (config em RAM, Gemini com resposta adiada), stats a cada
+           500 ms
+
+  Latências de SD e do Gemini são injetadas (--sd-ms, --net-ms), já que o
+  host não tem cartão nem TLS lento.
+
+  Uso:
+    pio run -e native_web_load
+    .pio/build/native_web_load/program --mode sync --json
+    .pio/build/native_web_load/program --mode async --json
+
+  Opções:
+    --mode sync|async   (padrão async)
+    --seconds S         duração (padrão 10)
+    --clients N         clientes HTTP simultâneos (padrão 16)
+    --ws M              clientes WebSocket (padrão 4)
+    --frame-ms F        trabalho do LVGL por frame (padrão 4)
+    --sd-ms D           custo de um acesso ao SD (padrão 10)
+    --net-ms D          custo de uma pergunta ao Gemini (padrão 800)
+    --think-ms T        pausa de cada cliente entre requisições (padrão 50)
+    --sd DIR            raiz do "SD" (padrão ./load_sd)
+    --json              resumo em uma linha JSON
+*/
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "web/web_assets.h"
+#include "web/web_io.h"
+#include "storage.h"
+
+#include "host_shim.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static bool mode_async = true;
+static int sd_ms = 10;
+static int net_ms = 800;
+static int think_ms = 50;
+
+static std::mutex config_mutex;
+static String device_config = "{\"device_name\":\"WavePwn\",\"theme\":\"dark\"}";
+
+static void sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static double ms_since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// -----------------------------------------------------------------------------
+// Rotas (mesma forma de webserver.cpp, com os custos de SD/rede injetados)
+// -----------------------------------------------------------------------------
+
+static void collect_body(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                         size_t index, size_t total) {
+    if (index == 0) request->_tempObject = calloc(1, total + 1);
+    if (request->_tempObject) memcpy((char*)request->_tempObject + index, data, len);
+}
+
+static void persist_config(const String& json) {
+    sleep_ms(sd_ms);
+    File f = SDCARD.open("/config/device_config.json", FILE_WRITE);
+    if (f) {
+        f.print(json.c_str());
+        f.close();
+    }
+}
+
+static String gemini_answer(const String& prompt) {
+    sleep_ms(net_ms);
+    return String("{\"response\":\"eco: ") + prompt + "\"}";
+}
+
+static void register_routes(AsyncWebServer& server) {
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
+        web_assets_serve(request, *web_asset_find("/index.html"));
+    });
+    web_assets_register(server, "/ota/");
+
+    server.on("/api/config/device", HTTP_GET, [](AsyncWebServerRequest* request) {
+        if (!mode_async) sleep_ms(sd_ms);   // antes: SD.open + deserializeJson
+        String out;
+        {
+            std::lock_guard<std::mutex> lock(config_mutex);
+            out = device_config;
+        }
+        request->send(200, "application/json", out);
+    });
+
+    server.on("/api/config/device", HTTP_POST, [](AsyncWebServerRequest* request) {
+        String body(request->_tempObject ? (const char*)request->_tempObject : "");
+        if (mode_async) {
+            if (!web_io_post(persist_config, body)) {
+                request->send(503, "application/json", "{\"error\":\"busy\"}");
+                return;
+            }
+        } else {
+            persist_config(body);
+        }
+        {
+            std::lock_guard<std::mutex> lock(config_mutex);
+            device_config = body;
+        }
+        request->send(200, "application/json", "{\"ok\":true}");
+    }, nullptr, collect_body);
+
+    server.on("/api/gemini/ask", HTTP_POST, [](AsyncWebServerRequest* request) {
+        String prompt("ping");
+        if (mode_async) {
+            if (!web_io_defer(request, "application/json", gemini_answer, prompt)) {
+                request->send(503, "application/json", "{\"error\":\"busy\"}");
+            }
+        } else {
+            request->send(200, "application/json", gemini_answer(prompt));
+        }
+    }, nullptr, collect_body);
+
+    // /api/aps: só CPU (tabela em RAM), igual nos dois modos
+    server.on("/api/aps", HTTP_GET, [](AsyncWebServerRequest* request) {
+        String out("{\"aps\":[");
+        for (int i = 0; i < 20; ++i) {
+            if (i) out += ",";
+            out += "{\"bssid\":\"02:00:00:00:00:00\",\"ssid\":\"net-";
+            out += String(i);
+            out += "\",\"ch\":6,\"rssi\":-60,\"enc\":\"WPA2\",\"clients\":3}";
+        }
+        out += "]}";
+        request->send(200, "application/json", out);
+    });
+}
+
+// -----------------------------------------------------------------------------
+// Clientes
+// -----------------------------------------------------------------------------
+
+static int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool http_request(int port, const std::string& req) {
+    int fd = connect_to(port);
+    if (fd < 0) return false;
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+    char buf[16384];
+    bool ok = false;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        ok = true;
+    }
+    close(fd);
+    return ok;
+}
+
+struct ClientStats {
+    std::vector<double> latencies_ms;
+    uint32_t failures = 0;
+};
+
+static void http_client(int port, int id, std::atomic<bool>* stop, ClientStats* out) {
+    static const char* ASSETS[] = {"/", "/style.css", "/chart.min.js", "/favicon.ico",
+                                   "/config.html", "/config.js", "/bootstrap.min.css"};
+    std::mt19937 rng(1000 + id);
+    std::uniform_int_distribution<int> pct(0, 99);
+
+    while (!stop->load()) {
+        int r = pct(rng);
+        std::string req;
+        if (r < 55) {
+            // Metade das vezes o navegador revalida (If-None-Match)
+            const char* path = ASSETS[rng() % (sizeof(ASSETS) / sizeof(ASSETS[0]))];
+            const WebAsset* a = web_asset_find(strcmp(path, "/") == 0 ? "/index.html" : path);
+            req = std::string("GET ") + path + " HTTP/1.1\r\nHost: 192.168.4.1\r\n";
+            if (a && (rng() & 1)) req += std::string("If-None-Match: ") + a->etag + "\r\n";
+            req += "\r\n";
+        } else if (r < 75) {
+            req = "GET /api/config/device HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n";
+        } else if (r < 90) {
+            req = "GET /api/aps?n=20 HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n";
+        } else if (r < 99) {
+            std::string body = "{\"device_name\":\"client-" + std::to_string(id) + "\"}";
+            req = "POST /api/config/device HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+                  "Content-Type: application/json\r\nContent-Length: " +
+                  std::to_string(body.size()) + "\r\n\r\n" + body;
+        } else {
+            std::string body = "{\"prompt\":\"ping\"}";
+            req = "POST /api/gemini/ask HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+                  "Content-Type: application/json\r\nContent-Length: " +
+                  std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+
+        Clock::time_point t0 = Clock::now();
+        if (http_request(port, req)) {
+            out->latencies_ms.push_back(ms_since(t0));
+        } else {
+            out->failures++;
+        }
+        sleep_ms(think_ms);
+    }
+}
+
+static void ws_client(int port, std::atomic<bool>* stop, std::atomic<uint64_t>* messages) {
+    int fd = connect_to(port);
+    if (fd < 0) return;
+    std::string req = "GET /ws HTTP/1.1\r\nHost: 192.168.4.1\r\nUpgrade: websocket\r\n"
+                      "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                      "Sec-WebSocket-Version: 13\r\n\r\n";
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+
+    struct timeval tv = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    std::string in;
+    bool upgraded = false;
+    char buf[4096];
+    while (!stop->load()) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0) break;
+        if (n < 0) continue;
+        in.append(buf, (size_t)n);
+        if (!upgraded) {
+            size_t end = in.find("\r\n\r\n");
+            if (end == std::string::npos) continue;
+            in.erase(0, end + 4);
+            upgraded = true;
+        }
+        // Frames de texto sem máscara (servidor -> cliente)
+        for (;;) {
+            if (in.size() < 2) break;
+            size_t len = (uint8_t)in[1] & 0x7F;
+            size_t hdr = 2;
+            if (len == 126) {
+                if (in.size() < 4) break;
+                len = ((uint8_t)in[2] << 8) | (uint8_t)in[3];
+                hdr = 4;
+            } else if (len == 127) {
+                break;   // stats nunca passam de 64 KB
+            }
+            if (in.size() < hdr + len) break;
+            in.erase(0, hdr + len);
+            (*messages)++;
+        }
+    }
+    close(fd);
+}
+
+// -----------------------------------------------------------------------------
+// Loop da UI
+// -----------------------------------------------------------------------------
+
+static void spin_ms(double ms) {
+    Clock::time_point t0 = Clock::now();
+    volatile uint32_t x = 0;
+    while (ms_since(t0) < ms) x++;
+}
+
+static String stats_json(uint32_t frame) {
+    String json("{\"uptime\":");
+    json += String(frame / 100);
+    json += ",\"battery\":100,\"aps\":80,\"aps_active\":42,\"clients\":120,\"open\":8,"
+            "\"wpa3\":12,\"aps_hs\":5,\"rssi_max\":-38,\"ch\":6,\"hs\":5,\"pmkid\":3,"
+            "\"frames\":123456,\"drops\":0,\"ai\":\"SAFE\",\"log\":\"[WS] ok\"}";
+    return json;
+}
+
+static double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+    return v[std::min(i, v.size() - 1)];
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "uso: %s [--mode sync|async] [--seconds S] [--clients N] [--ws M]\n"
+            "          [--frame-ms F] [--sd-ms D] [--net-ms D] [--think-ms T]\n"
+            "          [--sd DIR] [--json]\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    double seconds = 10.0;
+    int clients = 16;
+    int ws_clients = 4;
+    double frame_ms = 4.0;
+    std::string sd_root = "load_sd";
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (a == "--mode" && has_value) {
+            mode_async = std::string(argv[++i]) != "sync";
+        } else if (a == "--seconds" && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (a == "--clients" && has_value) {
+            clients = atoi(argv[++i]);
+        } else if (a == "--ws" && has_value) {
+            ws_clients = atoi(argv[++i]);
+        } else if (a == "--frame-ms" && has_value) {
+            frame_ms = atof(argv[++i]);
+        } else if (a == "--sd-ms" && has_value) {
+            sd_ms = atoi(argv[++i]);
+        } else if (a == "--net-ms" && has_value) {
+            net_ms = atoi(argv[++i]);
+        } else if (a == "--think-ms" && has_value) {
+            think_ms = atoi(argv[++i]);
+        } else if (a == "--sd" && has_value) {
+            sd_root = argv[++i];
+        } else if (a == "--json") {
+            json = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    mkdir(sd_root.c_str(), 0755);
+    mkdir((sd_root + "/config").c_str(), 0755);
+    host_shim_set_sd_root(sd_root.c_str());
+
+    host_async_set_inline(!mode_async);
+    AsyncWebServer server(0);
+    AsyncWebSocket ws("/ws");
+    register_routes(server);
+    server.addHandler(&ws);
+    server.begin();
+    if (mode_async) web_io_start();
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> ws_messages{0};
+    std::vector<ClientStats> stats(clients);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < ws_clients; ++i) {
+        threads.emplace_back(ws_client, server.port(), &stop, &ws_messages);
+    }
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back(http_client, server.port(), i, &stop, &stats[i]);
+    }
+
+    // Pwnagotchi::update(): LVGL + webserver_send_stats() + vTaskDelay(5)
+    std::vector<double> frames;
+    Clock::time_point start = Clock::now();
+    Clock::time_point last_stats = start;
+    uint32_t frame = 0;
+    while (ms_since(start) < seconds * 1000.0) {
+        Clock::time_point t0 = Clock::now();
+        spin_ms(frame_ms);
+
+        if (mode_async) {
+            if (ms_since(last_stats) >= 500.0) {
+                last_stats = Clock::now();
+                if (ws.count() > 0) ws.textAll(stats_json(frame));
+            }
+        } else {
+            host_async_pump(0, 1);   // http_server.handleClient()
+            if (ws.count() > 0) ws.textAll(stats_json(frame));
+        }
+
+        sleep_ms(5);
+        frames.push_back(ms_since(t0));
+        frame++;
+    }
+
+    stop.store(true);
+    // No modo sync ninguém mais roda o laço: drena até os clientes saírem
+    Clock::time_point drain = Clock::now();
+    while (!mode_async && ms_since(drain) < 3000.0) host_async_pump(1, 0);
+    for (auto& t : threads) t.join();
+
+    std::vector<double> lat;
+    uint32_t failures = 0;
+    for (auto& s : stats) {
+        lat.insert(lat.end(), s.latencies_ms.begin(), s.latencies_ms.end());
+        failures += s.failures;
+    }
+    double wall_s = ms_since(start) / 1000.0;
+    HostAsyncStats hs;
+    host_async_get_stats(&hs);
+
+    double f50 = percentile(frames, 50), f99 = percentile(frames, 99);
+    double fmax = frames.empty() ? 0.0 : frames.back();
+    double r50 = percentile(lat, 50), r99 = percentile(lat, 99);
+
+    if (json) {
+        printf("{\"mode\":\"%s\",\"frames\":%zu,\"frame_p50_ms\":%.2f,\"frame_p99_ms\":%.2f,"
+               "\"frame_max_ms\":%.2f,\"requests\":%zu,\"req_per_s\":%.0f,\"req_p50_ms\":%.2f,"
+               "\"req_p99_ms\":%.2f,\"failures\":%u,\"ws_messages\":%llu,\"bytes_out\":%llu}\n",
+               mode_async ? "async" : "sync", frames.size(), f50, f99, fmax, lat.size(),
+               lat.size() / wall_s, r50, r99, failures,
+               (unsigned long long)ws_messages.load(), (unsigned long long)hs.bytes_out);
+    } else {
+        printf("[LOAD] Modo %s, %d clientes HTTP + %d WebSocket, %.0f s\n",
+               mode_async ? "async" : "sync", clients, ws_clients, seconds);
+        printf("[LOAD] Frame da UI: p50 %.2f ms, p99 %.2f ms, max %.2f ms (%zu frames)\n",
+               f50, f99, fmax, frames.size());
+        printf("[LOAD] Requisições: %zu (%.0f/s), p50 %.2f ms, p99 %.2f ms, %u falhas\n",
+               lat.size(), lat.size() / wall_s, r50, r99, failures);
+        printf("[LOAD] WebSocket: %llu mensagens recebidas\n",
+               (unsigned long long)ws_messages.load());
+    }
+    fflush(stdout);
+    _exit(0);
+}
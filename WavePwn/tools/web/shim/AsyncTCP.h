@@ -0,0 +1,3 @@
+#pragma once
+
+// Shim: o transporte fica todo em ESPAsyncWebServer.h / async_shim.cpp
@@ -0,0 +1,236 @@
+#pragma once
+
+// Shim do ESPAsyncWebServer sobre sockets POSIX, só com o que src/web usa.
+// Um laço de eventos com poll() faz o papel da task do AsyncTCP:
+//
+//   - modo normal: begin() sobe uma thread própria para o laço;
+//   - modo inline (host_async_set_inline): ninguém roda o laço sozinho e o
+//     chamador usa host_async_pump(). É o modelo antigo, com handleClient()
+//     no loop da UI, usado como referência no load_test.
+//
+// Respostas chunked com RESPONSE_TRY_AGAIN são tentadas de novo a cada volta
+// do laço, como o _onPoll do AsyncTCP. Corpos de rotas com onBody são
+// entregues aos pedaços, conforme chegam do socket (como no AsyncTCP): uma
+// conexão que cai no meio do corpo já entregou o que chegou. Fillers só são chamados enquanto a
+// saída pendente da conexão está abaixo de uma janela (o espaço livre do
+// TCP no AsyncTCP). Sempre "Connection: close".
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+enum WebRequestMethod : uint8_t {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_ANY = 0b11111111,
+};
+
+class IPAddress {
+public:
+    explicit IPAddress(uint32_t addr = 0) : addr_(addr) {}
+    String toString() const;
+
+private:
+    uint32_t addr_;   // ordem de rede
+};
+
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : name_(name), value_(value) {}
+    const String& name() const { return name_; }
+    const String& value() const { return value_; }
+
+private:
+    String name_;
+    String value_;
+};
+
+typedef AsyncWebHeader AsyncWebParameter;
+
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+
+struct HostConn;
+
+class AsyncWebServerResponse {
+public:
+    void addHeader(const char* name, const char* value);
+    void setCode(int code) { code_ = code; }
+
+private:
+    friend class AsyncWebServerRequest;
+    friend struct HostConn;
+
+    int code_ = 200;
+    std::string content_type_;
+    std::string headers_;
+    std::string body_;
+    AwsResponseFiller filler_;
+    bool chunked_ = false;
+    size_t length_ = 0;   // corpo via filler com Content-Length
+};
+
+class AsyncWebServerRequest {
+public:
+    ~AsyncWebServerRequest();
+
+    void* _tempObject = nullptr;   // liberado com free() no destrutor
+
+    const String& url() const { return url_; }
+    WebRequestMethod method() const { return method_; }
+
+    bool hasParam(const char* name) const { return getParam(name) != nullptr; }
+    const AsyncWebParameter* getParam(const char* name) const;
+    bool hasHeader(const char* name) const { return getHeader(name) != nullptr; }
+    const AsyncWebHeader* getHeader(const char* name) const;
+
+    bool authenticate(const char* user, const char* pass);
+    void requestAuthentication();
+    void onDisconnect(std::function<void()> fn) { on_disconnect_ = fn; }
+
+    AsyncWebServerResponse* beginResponse(int code,
+                                          const char* content_type = nullptr,
+                                          const String& content = String());
+    AsyncWebServerResponse* beginResponse_P(int code,
+                                            const char* content_type,
+                                            const uint8_t* content,
+                                            size_t len);
+    AsyncWebServerResponse* beginResponse(const char* content_type,
+                                          size_t len,
+                                          AwsResponseFiller filler);
+    AsyncWebServerResponse* beginChunkedResponse(const char* content_type,
+                                                 AwsResponseFiller filler);
+
+    void send(AsyncWebServerResponse* response);
+    void send(int code, const char* content_type = nullptr, const String& content = String());
+
+private:
+    friend struct HostConn;
+
+    String url_;
+    WebRequestMethod method_ = HTTP_GET;
+    std::vector<AsyncWebHeader> headers_;
+    std::vector<AsyncWebParameter> params_;
+    AsyncWebServerResponse* response_ = nullptr;
+    std::function<void()> on_disconnect_;
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, const String&, size_t, uint8_t*, size_t, bool)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t)>
+    ArBodyHandlerFunction;
+
+enum AwsEventType { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA };
+
+enum AwsFrameType { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG };
+
+// `arg` do WS_EVT_DATA. O shim entrega sempre a mensagem inteira num evento.
+struct AwsFrameInfo {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+};
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+public:
+    IPAddress remoteIP() const { return ip_; }
+    uint32_t id() const { return id_; }
+
+private:
+    friend struct HostConn;
+    IPAddress ip_;
+    uint32_t id_ = 0;
+};
+
+typedef std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*, uint8_t*, size_t)>
+    AwsEventHandler;
+
+class AsyncWebSocket {
+public:
+    explicit AsyncWebSocket(const char* url) : url_(url) {}
+
+    void onEvent(AwsEventHandler handler) { handler_ = handler; }
+    size_t count() const;
+    void cleanupClients() {}
+    void textAll(const String& message);
+    void binary(uint32_t id, const uint8_t* message, size_t len);
+
+private:
+    friend struct HostConn;
+
+    std::string url_;
+    AwsEventHandler handler_;
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : port_(port) {}
+
+    void on(const char* uri,
+            WebRequestMethod method,
+            ArRequestHandlerFunction on_request,
+            ArUploadHandlerFunction on_upload = nullptr,
+            ArBodyHandlerFunction on_body = nullptr);
+    void onNotFound(ArRequestHandlerFunction fn) { not_found_ = fn; }
+    void addHandler(AsyncWebSocket* ws) { ws_ = ws; }
+    void begin();
+
+    // Só no host: porta efetiva (begin() com porta 0 deixa o kernel escolher)
+    uint16_t port() const { return port_; }
+
+private:
+    friend struct HostConn;
+    friend void host_async_pump(int, int);
+
+    struct Route {
+        std::string uri;
+        WebRequestMethod method;
+        ArRequestHandlerFunction on_request;
+        ArBodyHandlerFunction on_body;
+    };
+
+    uint16_t port_;
+    int listen_fd_ = -1;
+    std::vector<Route> routes_;
+    ArRequestHandlerFunction not_found_;
+    AsyncWebSocket* ws_ = nullptr;
+};
+
+// --- Controle do shim (só host) ---------------------------------------------
+
+// true: begin() não cria a thread do laço; o chamador usa host_async_pump()
+void host_async_set_inline(bool inline_mode);
+
+// Uma volta do laço no chamador: espera até timeout_ms por eventos e
+// despacha no máximo max_requests requisições (o WebServer síncrono atendia
+// uma por handleClient()). max_requests <= 0: sem limite.
+void host_async_pump(int timeout_ms, int max_requests);
+
+struct HostAsyncStats {
+    uint64_t requests;
+    uint64_t bytes_out;
+    uint64_t ws_messages;
+    uint64_t try_again;
+
+    // Tempo dentro dos handlers HTTP (onRequest, onBody, notFound): o que
+    // na placa seria a task do AsyncTCP parada
+    uint64_t handler_calls;
+    uint64_t handler_us_total;
+    uint64_t handler_us_max;
+};
+
+void host_async_get_stats(HostAsyncStats* out);
+void host_async_reset_stats();
@@ -0,0 +1,749 @@
+#include "ESPAsyncWebServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+// Utilitários: base64 e SHA-1 (handshake do WebSocket, Basic Auth)
+// -----------------------------------------------------------------------------
+
+static std::string base64(const uint8_t* data, size_t len) {
+    static const char* T = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        out += T[(v >> 18) & 63];
+        out += T[(v >> 12) & 63];
+        out += i + 1 < len ? T[(v >> 6) & 63] : '=';
+        out += i + 2 < len ? T[v & 63] : '=';
+    }
+    return out;
+}
+
+static void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string msg((const char*)data, len);
+    msg += (char)0x80;
+    while (msg.size() % 64 != 56) msg += (char)0;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 7; i >= 0; --i) msg += (char)(bits >> (i * 8));
+
+    for (size_t off = 0; off < msg.size(); off += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* p = (const uint8_t*)msg.data() + off + i * 4;
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; ++i) {
+            uint32_t x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = (x << 1) | (x >> 31);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = (b << 30) | (b >> 2);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; ++i) {
+        out[i * 4] = h[i] >> 24;
+        out[i * 4 + 1] = h[i] >> 16;
+        out[i * 4 + 2] = h[i] >> 8;
+        out[i * 4 + 3] = h[i];
+    }
+}
+
+static const char* status_text(int code) {
+    switch (code) {
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 416: return "Range Not Satisfiable";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Estado global do laço
+// -----------------------------------------------------------------------------
+
+struct HostConn {
+    enum State { READING, BODY, RESPONDING, WEBSOCKET, DONE };
+
+    int fd = -1;
+    State state = READING;
+    std::string in;
+    std::string out;                        // protegido por g_mutex
+    AsyncWebServerRequest* request = nullptr;
+    size_t chunk_index = 0;                 // bytes já pedidos ao filler
+    bool try_again = false;                 // último filler: RESPONSE_TRY_AGAIN
+    AsyncWebSocketClient ws_client;
+
+    // Corpo entregue aos pedaços (estado BODY)
+    ArBodyHandlerFunction body_fn;
+    ArRequestHandlerFunction body_done;
+    size_t body_index = 0;
+    size_t body_total = 0;
+
+    void materialize(AsyncWebServerResponse* r);
+    bool fill_chunks();                     // false = TRY_AGAIN ou janela cheia
+
+    // O laço inteiro fica aqui por ser friend das classes públicas
+    static bool handle_input(AsyncWebServer* server, HostConn* c, sockaddr_in* peer);
+    static bool handle_body(HostConn* c);
+    static void handle_ws_input(AsyncWebServer* server, HostConn* c);
+    static void close_conn(AsyncWebServer* server, HostConn* c);
+    static void loop_once(AsyncWebServer* server, int timeout_ms, int max_requests);
+};
+
+// Saída pendente acima da qual os fillers esperam o socket drenar
+static const size_t HOST_SEND_WINDOW = 16 * 1024;
+
+static std::mutex g_mutex;
+static std::vector<HostConn*> g_conns;
+static AsyncWebServer* g_server = nullptr;
+static bool g_inline = false;
+
+static std::atomic<uint64_t> g_requests{0};
+static std::atomic<uint64_t> g_bytes_out{0};
+static std::atomic<uint64_t> g_ws_messages{0};
+static std::atomic<uint64_t> g_try_again{0};
+static std::atomic<uint32_t> g_ws_next_id{1};
+static std::atomic<uint64_t> g_handler_calls{0};
+static std::atomic<uint64_t> g_handler_us_total{0};
+static std::atomic<uint64_t> g_handler_us_max{0};
+
+template <typename Fn>
+static void timed_handler(Fn fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count();
+    g_handler_calls++;
+    g_handler_us_total += us;
+    uint64_t prev = g_handler_us_max.load();
+    while (us > prev && !g_handler_us_max.compare_exchange_weak(prev, us)) {
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Tipos públicos
+// -----------------------------------------------------------------------------
+
+String IPAddress::toString() const {
+    char buf[INET_ADDRSTRLEN];
+    struct in_addr a;
+    a.s_addr = addr_;
+    inet_ntop(AF_INET, &a, buf, sizeof(buf));
+    return String(buf);
+}
+
+void AsyncWebServerResponse::addHeader(const char* name, const char* value) {
+    headers_ += std::string(name) + ": " + value + "\r\n";
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    free(_tempObject);
+    delete response_;
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(const char* name) const {
+    for (const auto& p : params_) {
+        if (strcmp(p.name().c_str(), name) == 0) return &p;
+    }
+    return nullptr;
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(const char* name) const {
+    for (const auto& h : headers_) {
+        if (strcasecmp(h.name().c_str(), name) == 0) return &h;
+    }
+    return nullptr;
+}
+
+bool AsyncWebServerRequest::authenticate(const char* user, const char* pass) {
+    const AsyncWebHeader* h = getHeader("Authorization");
+    if (!h) return false;
+    std::string cred = std::string(user) + ":" + pass;
+    std::string expected = "Basic " + base64((const uint8_t*)cred.data(), cred.size());
+    return expected == h->value().c_str();
+}
+
+void AsyncWebServerRequest::requestAuthentication() {
+    AsyncWebServerResponse* r = beginResponse(401);
+    r->addHeader("WWW-Authenticate", "Basic realm=\"Login Required\"");
+    send(r);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code,
+                                                             const char* content_type,
+                                                             const String& content) {
+    AsyncWebServerResponse* r = new AsyncWebServerResponse();
+    r->code_ = code;
+    if (content_type) r->content_type_ = content_type;
+    r->body_.assign(content.c_str(), content.length());
+    return r;
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code,
+                                                               const char* content_type,
+                                                               const uint8_t* content,
+                                                               size_t len) {
+    AsyncWebServerResponse* r = beginResponse(code, content_type);
+    r->body_.assign((const char*)content, len);
+    return r;
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const char* content_type,
+                                                             size_t len,
+                                                             AwsResponseFiller filler) {
+    AsyncWebServerResponse* r = beginResponse(200, content_type);
+    r->length_ = len;
+    r->filler_ = len > 0 ? filler : nullptr;
+    return r;
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const char* content_type,
+                                                                    AwsResponseFiller filler) {
+    AsyncWebServerResponse* r = beginResponse(200, content_type);
+    r->chunked_ = true;
+    r->filler_ = filler;
+    return r;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    if (response_) {
+        delete response;   // já respondido: o ESPAsyncWebServer também ignora
+        return;
+    }
+    response_ = response;
+}
+
+void AsyncWebServerRequest::send(int code, const char* content_type, const String& content) {
+    send(beginResponse(code, content_type, content));
+}
+
+size_t AsyncWebSocket::count() const {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    size_t n = 0;
+    for (HostConn* c : g_conns) {
+        if (c->state == HostConn::WEBSOCKET) ++n;
+    }
+    return n;
+}
+
+static std::string ws_frame(uint8_t opcode, const char* data, size_t len) {
+    std::string frame;
+    frame += (char)(0x80 | opcode);   // FIN
+    if (len < 126) {
+        frame += (char)len;
+    } else if (len < 65536) {
+        frame += (char)126;
+        frame += (char)(len >> 8);
+        frame += (char)len;
+    } else {
+        frame += (char)127;
+        for (int i = 7; i >= 0; --i) frame += (char)((uint64_t)len >> (i * 8));
+    }
+    frame.append(data, len);
+    return frame;
+}
+
+void AsyncWebSocket::textAll(const String& message) {
+    std::string frame = ws_frame(WS_TEXT, message.c_str(), message.length());
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (HostConn* c : g_conns) {
+        if (c->state == HostConn::WEBSOCKET) {
+            c->out += frame;
+            g_ws_messages++;
+        }
+    }
+}
+
+void AsyncWebSocket::binary(uint32_t id, const uint8_t* message, size_t len) {
+    std::string frame = ws_frame(WS_BINARY, (const char*)message, len);
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (HostConn* c : g_conns) {
+        if (c->state == HostConn::WEBSOCKET && c->ws_client.id() == id) {
+            c->out += frame;
+            g_ws_messages++;
+        }
+    }
+}
+
+void AsyncWebServer::on(const char* uri,
+                        WebRequestMethod method,
+                        ArRequestHandlerFunction on_request,
+                        ArUploadHandlerFunction on_upload,
+                        ArBodyHandlerFunction on_body) {
+    (void)on_upload;   // uploads multipart não são usados no host
+    routes_.push_back(Route{uri, method, on_request, on_body});
+}
+
+// -----------------------------------------------------------------------------
+// Conexões
+// -----------------------------------------------------------------------------
+
+void HostConn::materialize(AsyncWebServerResponse* r) {
+    std::string head = "HTTP/1.1 " + std::to_string(r->code_) + " " + status_text(r->code_) + "\r\n";
+    if (r->chunked_) {
+        head += "Transfer-Encoding: chunked\r\n";
+    } else if (r->length_ > 0) {
+        head += "Content-Length: " + std::to_string(r->length_) + "\r\n";
+    } else {
+        head += "Content-Length: " + std::to_string(r->body_.size()) + "\r\n";
+    }
+    if (!r->content_type_.empty()) head += "Content-Type: " + r->content_type_ + "\r\n";
+    head += r->headers_;
+    head += "Connection: close\r\n\r\n";
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    out += head;
+    if (!r->chunked_) out += r->body_;
+}
+
+bool HostConn::fill_chunks() {
+    AsyncWebServerResponse* r = request->response_;
+    uint8_t buf[1460];
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            if (out.size() >= HOST_SEND_WINDOW) return false;
+        }
+        size_t max_len = sizeof(buf);
+        if (!r->chunked_ && r->length_ - chunk_index < max_len) max_len = r->length_ - chunk_index;
+
+        size_t n = r->filler_(buf, max_len, chunk_index);
+        try_again = (n == RESPONSE_TRY_AGAIN);
+        if (try_again) {
+            g_try_again++;
+            return false;
+        }
+        if (!r->chunked_) {
+            // Content-Length: corpo cru; 0 antes do fim = fonte acabou cedo
+            std::lock_guard<std::mutex> lock(g_mutex);
+            out.append((const char*)buf, n);
+            chunk_index += n;
+            if (n == 0 || chunk_index >= r->length_) {
+                r->filler_ = nullptr;
+                return true;
+            }
+            continue;
+        }
+        char size_line[16];
+        snprintf(size_line, sizeof(size_line), "%zx\r\n", n);
+
+        std::lock_guard<std::mutex> lock(g_mutex);
+        out += size_line;
+        out.append((const char*)buf, n);
+        out += "\r\n";
+        if (n == 0) {
+            r->filler_ = nullptr;
+            return true;
+        }
+        chunk_index += n;
+    }
+}
+
+static void parse_query(std::vector<AsyncWebParameter>& params, const std::string& query) {
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        std::string kv = query.substr(pos, amp - pos);
+        size_t eq = kv.find('=');
+        params.emplace_back(String(kv.substr(0, eq)),
+                            String(eq == std::string::npos ? "" : kv.substr(eq + 1)));
+        pos = amp + 1;
+    }
+}
+
+// Devolve true se uma requisição completa foi tratada
+bool HostConn::handle_input(AsyncWebServer* server, HostConn* c, sockaddr_in* peer) {
+    size_t head_end = c->in.find("\r\n\r\n");
+    if (head_end == std::string::npos) return false;
+
+    AsyncWebServerRequest* req = new AsyncWebServerRequest();
+    std::string line = c->in.substr(0, c->in.find("\r\n"));
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.find(' ', sp1 + 1);
+    std::string method = line.substr(0, sp1);
+    std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t q = target.find('?');
+    std::string path = target.substr(0, q);
+    if (q != std::string::npos) parse_query(req->params_, target.substr(q + 1));
+
+    size_t content_length = 0;
+    size_t pos = c->in.find("\r\n") + 2;
+    while (pos < head_end) {
+        size_t eol = c->in.find("\r\n", pos);
+        std::string h = c->in.substr(pos, eol - pos);
+        size_t colon = h.find(':');
+        if (colon != std::string::npos) {
+            std::string k = h.substr(0, colon);
+            size_t v = h.find_first_not_of(' ', colon + 1);
+            std::string val = v == std::string::npos ? "" : h.substr(v);
+            req->headers_.emplace_back(String(k), String(val));
+            if (strcasecmp(k.c_str(), "Content-Length") == 0) content_length = strtoul(val.c_str(), nullptr, 10);
+        }
+        pos = eol + 2;
+    }
+    WebRequestMethod req_method = method == "POST" ? HTTP_POST : HTTP_GET;
+    const AsyncWebServer::Route* route = nullptr;
+    for (const auto& r : server->routes_) {
+        if (r.uri == path && (r.method & req_method)) {
+            route = &r;
+            break;
+        }
+    }
+    bool streamed = route && route->on_body && content_length > 0;
+
+    if (!streamed && c->in.size() < head_end + 4 + content_length) {
+        delete req;
+        return false;   // corpo ainda chegando
+    }
+    std::string body = streamed ? std::string() : c->in.substr(head_end + 4, content_length);
+    c->in.erase(0, streamed ? head_end + 4 : std::string::npos);
+
+    req->url_ = String(path);
+    req->method_ = req_method;
+    c->request = req;
+    g_requests++;
+
+    if (streamed) {
+        c->body_fn = route->on_body;
+        c->body_done = route->on_request;
+        c->body_index = 0;
+        c->body_total = content_length;
+        c->state = HostConn::BODY;
+        return handle_body(c);
+    }
+
+    // Upgrade para WebSocket
+    const AsyncWebHeader* key = req->getHeader("Sec-WebSocket-Key");
+    if (server->ws_ && key && path == server->ws_->url_) {
+        std::string accept = std::string(key->value().c_str()) + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        uint8_t digest[20];
+        sha1((const uint8_t*)accept.data(), accept.size(), digest);
+        std::string resp = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                           "Connection: Upgrade\r\nSec-WebSocket-Accept: " +
+                           base64(digest, 20) + "\r\n\r\n";
+        c->ws_client.ip_ = IPAddress(peer->sin_addr.s_addr);
+        c->ws_client.id_ = g_ws_next_id++;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            c->out += resp;
+            c->state = HostConn::WEBSOCKET;
+        }
+        if (server->ws_->handler_) {
+            server->ws_->handler_(server->ws_, &c->ws_client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+        }
+        return true;
+    }
+
+    if (route) {
+        timed_handler([&] { route->on_request(req); });
+    } else if (server->not_found_) {
+        timed_handler([&] { server->not_found_(req); });
+    } else {
+        req->send(404, "text/plain", "Not found");
+    }
+    c->state = HostConn::RESPONDING;
+    return true;
+}
+
+// Entrega ao onBody o que já chegou do corpo; true quando o corpo acabou e
+// o onRequest foi chamado
+bool HostConn::handle_body(HostConn* c) {
+    size_t n = c->body_total - c->body_index;
+    if (n > c->in.size()) n = c->in.size();
+    if (n > 0) {
+        timed_handler([&] {
+            c->body_fn(c->request, (uint8_t*)&c->in[0], n, c->body_index, c->body_total);
+        });
+        c->body_index += n;
+        c->in.erase(0, n);
+    }
+    if (c->body_index < c->body_total) return false;
+
+    timed_handler([&] { c->body_done(c->request); });
+    c->state = HostConn::RESPONDING;
+    return true;
+}
+
+// Frames do cliente (sempre mascarados). Só mensagens de um frame; close
+// encerra a conexão, ping/pong são ignorados.
+void HostConn::handle_ws_input(AsyncWebServer* server, HostConn* c) {
+    for (;;) {
+        const uint8_t* p = (const uint8_t*)c->in.data();
+        size_t avail = c->in.size();
+        if (avail < 2) return;
+
+        uint8_t opcode = p[0] & 0x0F;
+        uint64_t len = p[1] & 0x7F;
+        size_t hdr = 2;
+        if (len == 126) {
+            if (avail < 4) return;
+            len = ((uint64_t)p[2] << 8) | p[3];
+            hdr = 4;
+        } else if (len == 127) {
+            if (avail < 10) return;
+            len = 0;
+            for (int i = 0; i < 8; ++i) len = (len << 8) | p[2 + i];
+            hdr = 10;
+        }
+        bool masked = (p[1] & 0x80) != 0;
+        size_t mask_at = hdr;
+        if (masked) hdr += 4;
+        if (avail < hdr + len) return;
+
+        std::string payload(c->in, hdr, (size_t)len);
+        if (masked) {
+            for (size_t i = 0; i < payload.size(); ++i) payload[i] ^= p[mask_at + (i & 3)];
+        }
+        c->in.erase(0, hdr + (size_t)len);
+
+        if (opcode == WS_DISCONNECT) {
+            c->state = HostConn::DONE;
+            return;
+        }
+        if ((opcode == WS_TEXT || opcode == WS_BINARY) && server->ws_->handler_) {
+            AwsFrameInfo info = {};
+            info.message_opcode = opcode;
+            info.opcode = opcode;
+            info.final = 1;
+            info.masked = masked;
+            info.len = payload.size();
+            server->ws_->handler_(server->ws_, &c->ws_client, WS_EVT_DATA, &info,
+                                  (uint8_t*)&payload[0], payload.size());
+        }
+    }
+}
+
+void HostConn::close_conn(AsyncWebServer* server, HostConn* c) {
+    if (c->state == HostConn::WEBSOCKET && server->ws_ && server->ws_->handler_) {
+        server->ws_->handler_(server->ws_, &c->ws_client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+    }
+    if (c->request && c->request->on_disconnect_) c->request->on_disconnect_();
+    delete c->request;
+    close(c->fd);
+    delete c;
+}
+
+void HostConn::loop_once(AsyncWebServer* server, int timeout_ms, int max_requests) {
+    std::vector<pollfd> fds;
+    std::vector<HostConn*> conns;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        conns = g_conns;
+        fds.push_back(pollfd{server->listen_fd_, POLLIN, 0});
+        for (HostConn* c : conns) {
+            short ev = 0;
+            if (c->state == HostConn::READING || c->state == HostConn::BODY ||
+                c->state == HostConn::WEBSOCKET) {
+                ev |= POLLIN;
+            }
+            // Filler com dado pronto: POLLOUT para voltar assim que o socket
+            // aceitar mais, em vez de esperar o timeout
+            bool filling = c->state == HostConn::RESPONDING && c->request &&
+                           c->request->response_ && c->request->response_->filler_ &&
+                           !c->try_again;
+            if (!c->out.empty() || filling) ev |= POLLOUT;
+            fds.push_back(pollfd{c->fd, ev, 0});
+        }
+    }
+    // Mensagens do WebSocket enfileiradas por outras threads e fillers em
+    // TRY_AGAIN só são vistos na próxima volta: volta curta
+    if (timeout_ms > 5) timeout_ms = 5;
+    poll(fds.data(), fds.size(), timeout_ms);
+
+    if (fds[0].revents & POLLIN) {
+        int fd = accept(server->listen_fd_, nullptr, nullptr);
+        if (fd >= 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            HostConn* c = new HostConn();
+            c->fd = fd;
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_conns.push_back(c);
+        }
+    }
+
+    int dispatched = 0;
+    for (size_t i = 0; i < conns.size(); ++i) {
+        HostConn* c = conns[i];
+        short rev = fds[i + 1].revents;
+
+        if (rev & (POLLIN | POLLHUP | POLLERR)) {
+            char buf[4096];
+            ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                if (c->state == HostConn::READING || c->state == HostConn::BODY ||
+                    c->state == HostConn::WEBSOCKET) {
+                    c->in.append(buf, (size_t)n);
+                }
+            } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                c->state = HostConn::DONE;
+            }
+        }
+
+        bool reading = c->state == HostConn::READING && (max_requests <= 0 || dispatched < max_requests);
+        if (reading || c->state == HostConn::BODY) {
+            sockaddr_in peer = {};
+            socklen_t plen = sizeof(peer);
+            getpeername(c->fd, (sockaddr*)&peer, &plen);
+            if (reading ? handle_input(server, c, &peer) : handle_body(c)) {
+                ++dispatched;
+                if (c->state == HostConn::RESPONDING) {
+                    if (c->request->response_) {
+                        c->materialize(c->request->response_);
+                    } else {
+                        c->request->send(500, "text/plain", "no response");
+                        c->materialize(c->request->response_);
+                    }
+                }
+            }
+        }
+
+        if (c->state == HostConn::WEBSOCKET) {
+            handle_ws_input(server, c);
+        }
+
+        if (c->state == HostConn::RESPONDING && c->request->response_->filler_) {
+            c->fill_chunks();
+        }
+
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (!c->out.empty()) {
+            ssize_t n = send(c->fd, c->out.data(), c->out.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                g_bytes_out += (uint64_t)n;
+                c->out.erase(0, (size_t)n);
+            } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                c->state = HostConn::DONE;
+            }
+        }
+        if (c->state == HostConn::RESPONDING && c->out.empty() && !c->request->response_->filler_) {
+            c->state = HostConn::DONE;
+        }
+    }
+
+    std::vector<HostConn*> done;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        for (size_t i = 0; i < g_conns.size();) {
+            if (g_conns[i]->state == HostConn::DONE) {
+                done.push_back(g_conns[i]);
+                g_conns.erase(g_conns.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+    for (HostConn* c : done) close_conn(server, c);
+}
+
+void AsyncWebServer::begin() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port_);
+    if (bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd_, 128) != 0) {
+        perror("[WEB] bind/listen");
+        exit(1);
+    }
+    socklen_t alen = sizeof(addr);
+    getsockname(listen_fd_, (sockaddr*)&addr, &alen);
+    port_ = ntohs(addr.sin_port);
+
+    g_server = this;
+    if (!g_inline) {
+        std::thread([this]() {
+            for (;;) HostConn::loop_once(this, 10, 0);
+        }).detach();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Controle
+// -----------------------------------------------------------------------------
+
+void host_async_set_inline(bool inline_mode) {
+    g_inline = inline_mode;
+}
+
+void host_async_pump(int timeout_ms, int max_requests) {
+    if (g_server) HostConn::loop_once(g_server, timeout_ms, max_requests);
+}
+
+void host_async_get_stats(HostAsyncStats* out) {
+    out->requests = g_requests.load();
+    out->bytes_out = g_bytes_out.load();
+    out->ws_messages = g_ws_messages.load();
+    out->try_again = g_try_again.load();
+    out->handler_calls = g_handler_calls.load();
+    out->handler_us_total = g_handler_us_total.load();
+    out->handler_us_max = g_handler_us_max.load();
+}
+
+void host_async_reset_stats() {
+    g_requests = 0;
+    g_bytes_out = 0;
+    g_ws_messages = 0;
+    g_try_again = 0;
+    g_handler_calls = 0;
+    g_handler_us_total = 0;
+    g_handler_us_max = 0;
+}
@@ -0,0 +1,433 @@
+/*
+  telemetry_bench.cpp - Custo da telemetria do dashboard (host)
+
+  Sobe o AsyncWebSocket do shim em /ws, conecta N clientes WebSocket reais
+  (sockets em loopback) e roda o "loop da UI" com um ambiente sintético
+  (tabela de APs com RSSI oscilando, hopper trocando de canal, contadores de
+  frames, uma linha de log a cada 2 s, NEURA9 mudando de classe às vezes).
+
+  Modos:
+
+    json-loop   JSON montado com String e textAll a cada frame da UI (o
+                webserver_send_stats original, sem o neura9.predict())
+    json        o mesmo JSON a cada 500 ms
+    binary      src/web/telemetry: canais com período, só o que mudou,
+                frames binários; clientes assinam --channels
+
+  Mede a CPU da thread da UI dentro da publicação (CLOCK_THREAD_CPUTIME_ID)
+  e os bytes que chegam aos clientes (frames WebSocket inteiros).
+
+  Uso:
+    pio run -e native_web_telemetry
+    .pio/build/native_web_telemetry/program --mode binary --ws 4 --json
+
+  Opções:
+    --mode json-loop|json|binary  (padrão binary)
+    --seconds S                   duração (padrão 10)
+    --ws N                        clientes WebSocket (padrão 4)
+    --channels M                  máscara assinada no modo binary (padrão 15)
+    --json                        resumo em uma linha JSON
+*/
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "web/telemetry.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// -----------------------------------------------------------------------------
+// Ambiente sintético
+// -----------------------------------------------------------------------------
+
+static const size_t SIM_APS = 60;
+static const char* THREAT_LABELS[10] = {"SAFE", "CROWDED", "OPEN_NETWORK", "EVIL_TWIN_RISK",
+                                        "DEAUTH_DETECTED", "ROGUE_AP", "HIGH_RISK",
+                                        "BATTERY_CRITICAL", "GESTURE_COMMAND", "LEARNING_MODE"};
+
+struct Sim {
+    std::mt19937 rng{42};
+    ApInfo aps[SIM_APS];
+    uint32_t uptime = 0;
+    float battery = 100.0f;
+    uint32_t aps_total = 0;
+    uint8_t channel = 1;
+    uint32_t handshakes = 0;
+    uint32_t pmkids = 0;
+    uint32_t frames = 0;
+    uint32_t drops = 0;
+    uint8_t threat = 0;
+    String last_log;
+    uint32_t next_log_ms = 0;
+    uint32_t next_hop_ms = 0;
+    uint32_t next_rssi_ms = 0;
+    uint32_t next_threat_ms = 15000;
+
+    void begin() {
+        for (size_t i = 0; i < SIM_APS; ++i) {
+            ApInfo& ap = aps[i];
+            memset(&ap, 0, sizeof(ap));
+            ap.bssid[0] = 0x02;
+            ap.bssid[5] = (uint8_t)i;
+            snprintf(ap.ssid, sizeof(ap.ssid), "rede-%02u", (unsigned)i);
+            ap.channel = (uint8_t)(1 + i % 13);
+            ap.rssi_ewma_x16 = (int16_t)(-(40 + (int)(rng() % 50)) * 16);
+            ap.encryption = (uint8_t)(1 + rng() % 5);
+            ap.clients = (uint16_t)(rng() % 6);
+        }
+        aps_total = SIM_APS;
+    }
+
+    void step(uint32_t now_ms, void (*log)(const String&)) {
+        uptime = now_ms / 1000;
+        frames = now_ms * 4 / 5;   // ~800 frames/s
+        battery = 100.0f - now_ms / 60000.0f;
+
+        if (now_ms >= next_hop_ms) {   // hopper: 250 ms por canal
+            next_hop_ms = now_ms + 250;
+            channel = (uint8_t)(channel % 13 + 1);
+        }
+        if (now_ms >= next_rssi_ms) {  // EWMA do RSSI anda a cada 100 ms
+            next_rssi_ms = now_ms + 100;
+            for (size_t i = 0; i < SIM_APS; ++i) {
+                int step = (int)(rng() % 33) - 16;   // ±1 dB em 1/16
+                int v = aps[i].rssi_ewma_x16 + step;
+                aps[i].rssi_ewma_x16 = (int16_t)std::max(-95 * 16, std::min(-30 * 16, v));
+                if (rng() % 200 == 0) aps[i].clients++;
+                if (rng() % 2000 == 0) {
+                    aps[i].capture_flags |= AP_CAPTURE_HANDSHAKE;
+                    handshakes++;
+                }
+                aps[i].last_seen_ms = now_ms;
+            }
+            if (rng() % 50 == 0) drops++;
+        }
+        if (now_ms >= next_log_ms) {
+            next_log_ms = now_ms + 2000;
+            char line[96];
+            snprintf(line, sizeof(line), "[HOP] canal %u, %u frames, \"%s\"", channel,
+                     (unsigned)frames, aps[rng() % SIM_APS].ssid);
+            last_log = line;
+            log(last_log);
+        }
+        if (now_ms >= next_threat_ms) {
+            next_threat_ms = now_ms + 15000;
+            threat = (uint8_t)(rng() % 4);
+        }
+    }
+};
+
+static Sim sim;
+
+static void sim_stats(int32_t* v, uint32_t) {
+    v[TELEM_STAT_UPTIME] = (int32_t)sim.uptime;
+    v[TELEM_STAT_BATTERY] = (int32_t)(sim.battery + 0.5f);
+    v[TELEM_STAT_APS] = (int32_t)sim.aps_total;
+    v[TELEM_STAT_APS_ACTIVE] = (int32_t)SIM_APS;
+    v[TELEM_STAT_CLIENTS] = 120;
+    v[TELEM_STAT_OPEN] = 8;
+    v[TELEM_STAT_WPA3] = 12;
+    v[TELEM_STAT_APS_HS] = (int32_t)sim.handshakes;
+    v[TELEM_STAT_RSSI_MAX] = -38;
+    v[TELEM_STAT_CHANNEL] = sim.channel;
+    v[TELEM_STAT_HANDSHAKES] = (int32_t)sim.handshakes;
+    v[TELEM_STAT_PMKIDS] = (int32_t)sim.pmkids;
+    v[TELEM_STAT_FRAMES] = (int32_t)sim.frames;
+    v[TELEM_STAT_DROPS] = (int32_t)sim.drops;
+}
+
+static uint8_t sim_threat() {
+    return sim.threat;
+}
+
+static size_t sim_aps(ApInfo* out, size_t n, uint32_t) {
+    static ApInfo sorted[SIM_APS];
+    memcpy(sorted, sim.aps, sizeof(sorted));
+    std::sort(sorted, sorted + SIM_APS,
+              [](const ApInfo& a, const ApInfo& b) { return a.rssi_ewma_x16 > b.rssi_ewma_x16; });
+    n = std::min(n, SIM_APS);
+    memcpy(out, sorted, n * sizeof(ApInfo));
+    return n;
+}
+
+static void sim_log(const String& line) {
+    telemetry_log(line.c_str());
+}
+
+// JSON do webserver_send_stats anterior (mesmos campos e mesma montagem)
+static String stats_json() {
+    String json;
+    json.reserve(384);
+
+    json += "{";
+    json += "\"uptime\":";
+    json += String(sim.uptime);
+    json += ",\"battery\":";
+    json += String(sim.battery, 0);
+    json += ",\"aps\":";
+    json += String(sim.aps_total);
+    json += ",\"aps_active\":";
+    json += String((unsigned)SIM_APS);
+    json += ",\"clients\":";
+    json += String(120);
+    json += ",\"open\":";
+    json += String(8);
+    json += ",\"wpa3\":";
+    json += String(12);
+    json += ",\"aps_hs\":";
+    json += String(sim.handshakes);
+    json += ",\"rssi_max\":";
+    json += String(-38);
+    json += ",\"ch\":";
+    json += String((unsigned)sim.channel);
+    json += ",\"hs\":";
+    json += String(sim.handshakes);
+    json += ",\"pmkid\":";
+    json += String(sim.pmkids);
+    json += ",\"frames\":";
+    json += String(sim.frames);
+    json += ",\"drops\":";
+    json += String(sim.drops);
+    json += ",\"ai\":\"";
+    json += THREAT_LABELS[sim.threat];
+    json += "\"";
+
+    if (sim.last_log.length() > 0) {
+        json += ",\"log\":\"";
+        String log = sim.last_log;
+        log.replace("\\", "\\\\");
+        log.replace("\"", "\\\"");
+        log.replace("\n", "\\n");
+        json += log;
+        json += "\"";
+    } else {
+        json += ",\"log\":\"\"";
+    }
+
+    json += "}";
+    return json;
+}
+
+// -----------------------------------------------------------------------------
+// Clientes WebSocket
+// -----------------------------------------------------------------------------
+
+struct WsStats {
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> messages{0};
+};
+
+static void ws_client(int port, int channels, std::atomic<bool>* stop, WsStats* out) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return;
+    }
+    std::string req = "GET /ws HTTP/1.1\r\nHost: 192.168.4.1\r\nUpgrade: websocket\r\n"
+                      "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                      "Sec-WebSocket-Version: 13\r\n\r\n";
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+
+    struct timeval tv = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    std::string in;
+    bool upgraded = false;
+    char buf[8192];
+    while (!stop->load()) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0) break;
+        if (n < 0) continue;
+        in.append(buf, (size_t)n);
+        if (!upgraded) {
+            size_t end = in.find("\r\n\r\n");
+            if (end == std::string::npos) continue;
+            in.erase(0, end + 4);
+            upgraded = true;
+
+            // Assinatura como o dashboard faz no onopen (frame mascarado)
+            if (channels >= 0) {
+                uint8_t sub[8] = {0x82, 0x82, 1, 2, 3, 4, TELEM_OP_SUBSCRIBE, (uint8_t)channels};
+                sub[6] ^= 1;
+                sub[7] ^= 2;
+                send(fd, sub, sizeof(sub), MSG_NOSIGNAL);
+            }
+        }
+        for (;;) {
+            if (in.size() < 2) break;
+            size_t len = (uint8_t)in[1] & 0x7F;
+            size_t hdr = 2;
+            if (len == 126) {
+                if (in.size() < 4) break;
+                len = ((uint8_t)in[2] << 8) | (uint8_t)in[3];
+                hdr = 4;
+            }
+            if (in.size() < hdr + len) break;
+            out->bytes += hdr + len;
+            out->messages++;
+            in.erase(0, hdr + len);
+        }
+    }
+    close(fd);
+}
+
+// -----------------------------------------------------------------------------
+
+static double thread_cpu_us() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double ms_since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "uso: %s [--mode json-loop|json|binary] [--seconds S] [--ws N]\n"
+            "          [--channels M] [--json]\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    std::string mode = "binary";
+    double seconds = 10.0;
+    int ws_clients = 4;
+    int channels = TELEM_MASK_ALL;
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (a == "--mode" && has_value) {
+            mode = argv[++i];
+        } else if (a == "--seconds" && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (a == "--ws" && has_value) {
+            ws_clients = atoi(argv[++i]);
+        } else if (a == "--channels" && has_value) {
+            channels = atoi(argv[++i]);
+        } else if (a == "--json") {
+            json = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    bool binary = mode == "binary";
+    if (!binary && mode != "json" && mode != "json-loop") {
+        usage(argv[0]);
+        return 2;
+    }
+
+    AsyncWebServer server(0);
+    AsyncWebSocket ws("/ws");
+    ws.onEvent([](AsyncWebSocket*, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                  uint8_t* data, size_t len) {
+        if (type == WS_EVT_CONNECT) {
+            telemetry_client_connected(client->id());
+        } else if (type == WS_EVT_DISCONNECT) {
+            telemetry_client_disconnected(client->id());
+        } else if (type == WS_EVT_DATA) {
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            if (info->final && info->index == 0 && info->len == len && info->opcode == WS_BINARY) {
+                telemetry_client_message(client->id(), data, len);
+            }
+        }
+    });
+    server.addHandler(&ws);
+    server.begin();
+
+    TelemetrySources sources = {sim_stats, sim_threat, sim_aps};
+    telemetry_begin(&ws, sources);
+    sim.begin();
+
+    std::atomic<bool> stop{false};
+    std::vector<WsStats> stats(ws_clients);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < ws_clients; ++i) {
+        threads.emplace_back(ws_client, server.port(), binary ? channels : -1, &stop, &stats[i]);
+    }
+    while (ws_clients > 0 && ws.count() < (size_t)ws_clients) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Loop da UI: simulação + publicação + vTaskDelay(5)
+    Clock::time_point start = Clock::now();
+    uint32_t last_json = 0;
+    double cpu_us = 0.0;
+    uint64_t frames = 0;
+    uint64_t published = 0;
+    for (;;) {
+        double elapsed = ms_since(start);
+        if (elapsed >= seconds * 1000.0) break;
+        uint32_t now = (uint32_t)elapsed;
+        sim.step(now, sim_log);
+
+        double t0 = thread_cpu_us();
+        if (binary) {
+            telemetry_tick(now);
+        } else if (mode == "json-loop" || now - last_json >= 500) {
+            last_json = now;
+            if (ws.count() > 0) {
+                ws.textAll(stats_json());
+                published++;
+            }
+        }
+        cpu_us += thread_cpu_us() - t0;
+        frames++;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    double wall_s = ms_since(start) / 1000.0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));   // drena o que ficou na fila
+    stop.store(true);
+    for (auto& t : threads) t.join();
+
+    uint64_t bytes = 0, messages = 0;
+    for (auto& s : stats) {
+        bytes += s.bytes.load();
+        messages += s.messages.load();
+    }
+    double cpu_per_s = cpu_us / wall_s;
+    double bytes_per_s = bytes / wall_s;
+    double bytes_per_client = ws_clients ? bytes_per_s / ws_clients : 0.0;
+    (void)published;
+
+    if (json) {
+        printf("{\"mode\":\"%s\",\"ws\":%d,\"channels\":%d,\"frames\":%llu,\"cpu_us_per_s\":%.0f,"
+               "\"cpu_us_per_frame\":%.2f,\"messages\":%llu,\"bytes_per_s\":%.0f,"
+               "\"bytes_per_s_per_client\":%.0f}\n",
+               mode.c_str(), ws_clients, binary ? channels : 0, (unsigned long long)frames,
+               cpu_per_s, frames ? cpu_us / frames : 0.0, (unsigned long long)messages,
+               bytes_per_s, bytes_per_client);
+    } else {
+        printf("[TELEM] Modo %s, %d clientes, %.0f s, %llu frames da UI\n", mode.c_str(),
+               ws_clients, seconds, (unsigned long long)frames);
+        printf("[TELEM] CPU na publicação: %.0f us/s (%.2f us/frame)\n", cpu_per_s,
+               frames ? cpu_us / frames : 0.0);
+        printf("[TELEM] Recebido: %llu mensagens, %.0f B/s (%.0f B/s por cliente)\n",
+               (unsigned long long)messages, bytes_per_s, bytes_per_client);
+    }
+    fflush(stdout);
+    _exit(0);
+}
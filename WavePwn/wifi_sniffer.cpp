@@ -4,4 +4,164 @@
 
 #include "wifi_sniffer.h"
 
-// Implementações futuras de captura de pacotes e handshakes.
\ No newline at end of file
+#include <Arduino.h>
+#include <esp_wifi.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
+
+static const BaseType_t HOPPER_TASK_CORE = 0;
+static const UBaseType_t HOPPER_TASK_PRIO = 2;
+static const uint32_t HOPPER_TASK_STACK = 3072;
+
+static ChannelScheduler scheduler;
+static portMUX_TYPE scheduler_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t hopper_task_handle = nullptr;
+
+// Canal atual e atividade do dwell em andamento (escritos pela task de
+// captura, zerados pelo hopper a cada troca)
+static std::atomic<uint8_t> current_channel{0};
+static std::atomic<uint32_t> act_beacons{0};
+static std::atomic<uint32_t> act_data{0};
+static std::atomic<uint32_t> act_eapol{0};
+static std::atomic<uint32_t> act_new_bssids{0};
+static std::atomic<uint8_t> pending_m1_channel{0};
+
+static ChannelActivity take_activity() {
+    ChannelActivity a;
+    a.beacons = act_beacons.exchange(0, std::memory_order_relaxed);
+    a.data_frames = act_data.exchange(0, std::memory_order_relaxed);
+    a.eapol = act_eapol.exchange(0, std::memory_order_relaxed);
+    a.new_bssids = act_new_bssids.exchange(0, std::memory_order_relaxed);
+    return a;
+}
+
+static void set_channel(uint8_t ch) {
+    if (ch == current_channel.load(std::memory_order_relaxed)) return;
+    esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
+    current_channel.store(ch, std::memory_order_relaxed);
+}
+
+static void hopper_task(void* arg) {
+    (void)arg;
+
+    uint32_t dwell_start = millis();
+    for (;;) {
+        uint32_t elapsed = millis() - dwell_start;
+        uint32_t dwell = scheduler.dwell_ms();
+        uint32_t wait = elapsed < dwell ? dwell - elapsed : 0;
+
+        // Acorda no fim do dwell ou antes, num EAPOL M1
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+
+        elapsed = millis() - dwell_start;
+        uint8_t m1_channel = pending_m1_channel.exchange(0, std::memory_order_relaxed);
+        uint8_t next = 0;
+
+        // No round-robin (ou canal fora da lista) o M1 não mexe no dwell
+        if (m1_channel && scheduler.can_bump(m1_channel)) {
+            if (m1_channel == scheduler.channel()) {
+                // Mesmo canal: só estende o dwell; a atividade continua
+                // acumulando e é creditada uma vez, quando ele terminar
+                portENTER_CRITICAL(&scheduler_mux);
+                scheduler.hold(elapsed);
+                portEXIT_CRITICAL(&scheduler_mux);
+            } else {
+                ChannelActivity a = take_activity();
+                portENTER_CRITICAL(&scheduler_mux);
+                scheduler.bump(m1_channel, a, elapsed);
+                portEXIT_CRITICAL(&scheduler_mux);
+                next = m1_channel;
+                dwell_start = millis();
+            }
+        } else if (elapsed >= dwell) {
+            ChannelActivity a = take_activity();
+            portENTER_CRITICAL(&scheduler_mux);
+            next = scheduler.advance(a, elapsed);
+            portEXIT_CRITICAL(&scheduler_mux);
+            dwell_start = millis();
+        }
+
+        if (next) {
+            set_channel(next);
+        }
+    }
+}
+
+void wifi_sniffer_begin(const uint8_t* channels,
+                        uint8_t count,
+                        uint32_t base_dwell_ms,
+                        uint32_t min_dwell_ms,
+                        uint32_t max_dwell_ms,
+                        bool adaptive) {
+    if (!scheduler.begin(channels, count, base_dwell_ms, min_dwell_ms,
+                         max_dwell_ms, adaptive, esp_random())) {
+        Serial.println("[SNIFFER] Lista de canais vazia, hopping desativado");
+        return;
+    }
+
+    set_channel(scheduler.channel());
+
+    xTaskCreatePinnedToCore(hopper_task,
+                            "ch_hopper",
+                            HOPPER_TASK_STACK,
+                            nullptr,
+                            HOPPER_TASK_PRIO,
+                            &hopper_task_handle,
+                            HOPPER_TASK_CORE);
+
+    Serial.printf("[SNIFFER] Hopping %s em %u canais (dwell base %lu ms)\n",
+                  adaptive ? "adaptativo" : "round-robin",
+                  (unsigned)scheduler.channel_count(),
+                  (unsigned long)base_dwell_ms);
+}
+
+void wifi_sniffer_count(uint8_t channel, SniffEvent ev) {
+    // Um M1 recebido logo depois de uma troca ainda é do canal anterior:
+    // o bump leva o rádio de volta para ele. Não conta de novo: o frame já
+    // chegou como SNIFF_EAPOL.
+    if (ev == SNIFF_EAPOL_M1) {
+        pending_m1_channel.store(channel, std::memory_order_relaxed);
+        if (hopper_task_handle) {
+            xTaskNotifyGive(hopper_task_handle);
+        }
+        return;
+    }
+
+    // Frames de canais vizinhos (sobreposição em 2.4 GHz) ou do canal
+    // anterior logo após a troca não contam para o dwell atual.
+    if (channel != current_channel.load(std::memory_order_relaxed)) return;
+
+    switch (ev) {
+        case SNIFF_BEACON:
+            act_beacons.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case SNIFF_DATA:
+            act_data.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case SNIFF_EAPOL:
+            act_eapol.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case SNIFF_NEW_BSSID:
+            act_new_bssids.fetch_add(1, std::memory_order_relaxed);
+            break;
+        default:
+            break;
+    }
+}
+
+uint8_t wifi_sniffer_channel() {
+    return current_channel.load(std::memory_order_relaxed);
+}
+
+uint8_t wifi_sniffer_channel_count() {
+    return scheduler.channel_count();
+}
+
+bool wifi_sniffer_get_channel_stats(uint8_t index, ChannelStats* out) {
+    if (!out || index >= scheduler.channel_count()) return false;
+    portENTER_CRITICAL(&scheduler_mux);
+    *out = scheduler.channel_stats(index);
+    portEXIT_CRITICAL(&scheduler_mux);
+    return true;
+}
@@ -4,4 +4,42 @@
 
 #pragma once
 
-// Futuras declarações do sniffer Wi-Fi.
\ No newline at end of file
+#include <stdint.h>
+
+#include "capture/channel_scheduler.h"
+
+// Channel hopping adaptativo.
+//
+// Uma task dedicada troca de canal conforme o ChannelScheduler: o tempo em
+// cada canal é proporcional à atividade útil observada nele (EAPOL, BSSIDs
+// novos, data frames, beacons), com exploração. A task de captura alimenta
+// os contadores via wifi_sniffer_count(); um EAPOL M1 faz o hopper ir (ou
+// ficar) no canal na hora, para pegar o resto do handshake.
+
+enum SniffEvent : uint8_t {
+    SNIFF_BEACON,
+    SNIFF_DATA,
+    SNIFF_EAPOL,
+    SNIFF_NEW_BSSID,
+    SNIFF_EAPOL_M1,     // só segura o canal; o frame já veio como SNIFF_EAPOL
+};
+
+// Inicia o hopper. `base_dwell_ms` é o dwell médio; com adaptive = false o
+// comportamento é o round-robin fixo de `channels`.
+void wifi_sniffer_begin(const uint8_t* channels,
+                        uint8_t count,
+                        uint32_t base_dwell_ms,
+                        uint32_t min_dwell_ms,
+                        uint32_t max_dwell_ms,
+                        bool adaptive);
+
+// Registra um evento visto em `channel` (canal do rx_ctrl). Só contabiliza
+// se for o canal atual do hopper. Seguro para chamar da task de captura.
+void wifi_sniffer_count(uint8_t channel, SniffEvent ev);
+
+// Canal em que o rádio está agora (0 antes de begin()).
+uint8_t wifi_sniffer_channel();
+
+// Snapshot das estatísticas de um canal (índice 0..count-1).
+bool wifi_sniffer_get_channel_stats(uint8_t index, ChannelStats* out);
+uint8_t wifi_sniffer_channel_count();